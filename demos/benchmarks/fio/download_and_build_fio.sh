@@ -2,6 +2,20 @@
 set -e
 
 SRC=fio_src
+LIBAIO_SRC=libaio_src
+INSTALL_DIR=/usr/local/occlum/x86_64-linux-musl
+
+# Download and install libaio, which is linked statically into FIO for ioengine=libaio
+if [ ! -d $LIBAIO_SRC ];then
+    rm -rf $LIBAIO_SRC && mkdir $LIBAIO_SRC
+    cd $LIBAIO_SRC
+    git clone https://pagure.io/libaio.git .
+    git checkout tags/libaio-0.3.113
+    make -C src CC=occlum-gcc libaio.a
+    install -D -m 644 src/libaio.h $INSTALL_DIR/include/libaio.h
+    install -D -m 644 src/libaio.a $INSTALL_DIR/lib/libaio.a
+    cd ..
+fi
 
 # Download FIO
 if [ ! -d $SRC ];then
@@ -1,6 +0,0 @@
-mod access;
-mod drop;
-mod message;
-mod multiple;
-mod read_write;
-mod single;
@@ -60,6 +60,14 @@ impl dyn File {
     }
 }
 
+/// The data file of a new INode
+pub enum DataFile {
+    /// Create the data file with the name
+    Create(SefsUuid),
+    /// Use the existing data file with the name, which has data of the size
+    Reuse(SefsUuid, usize),
+}
+
 /// inode for SEFS
 pub struct INodeImpl {
     /// inode number
@@ -202,6 +210,73 @@ impl INodeImpl {
         }
     }
 
+    /// Create an INode in this dir, with the data file given by `data` if it is some
+    fn create_inode(
+        &self,
+        name: &str,
+        type_: FileType,
+        mode: u16,
+        data: Option<DataFile>,
+    ) -> vfs::Result<Arc<dyn vfs::INode>> {
+        let info = self.metadata()?;
+
+        if info.type_ != vfs::FileType::Dir {
+            return Err(FsError::NotDir);
+        }
+        if info.nlinks == 0 {
+            return Err(FsError::DirRemoved);
+        }
+        if name.len() > MAX_FNAME_LEN {
+            return Err(FsError::NameTooLong);
+        }
+
+        // Ensure the name is not exist
+        if self.get_file_inode_id(name).is_ok() {
+            return Err(FsError::EntryExist);
+        }
+
+        // Create a new INode
+        let inode = self.fs.new_inode_with_data(type_, mode, data)?;
+        if type_ == FileType::Dir {
+            inode.dirent_init(self.id)?;
+        }
+        // Insert it into dir entry
+        let entry = DiskEntry {
+            id: inode.id as u32,
+            name: Str256::from(name),
+            type_,
+        };
+        self.dirent_append(&entry)?;
+        // Append success, increase nlinks
+        inode.nlinks_inc();
+        if type_ == FileType::Dir {
+            inode.nlinks_inc(); //for .
+            self.nlinks_inc(); //for ..
+        }
+        // Update metadata file to make the INode valid
+        self.fs.sync_metadata()?;
+        inode.sync_all()?;
+        // Sync the dirINode's info into file
+        // MUST sync the INode's info first, or the entry maybe invalid
+        self.sync_all()?;
+
+        Ok(inode)
+    }
+
+    /// Create a file INode in this dir with the given data file.
+    ///
+    /// It is used to create images incrementally, e.g., the data file can be named by
+    /// the hash of its content, and be reused if it exists in a previous image.
+    #[cfg(feature = "create_image")]
+    pub fn create_file(
+        &self,
+        name: &str,
+        mode: u16,
+        data: DataFile,
+    ) -> vfs::Result<Arc<dyn vfs::INode>> {
+        self.create_inode(name, FileType::File, mode, Some(data))
+    }
+
     /// Write the INode's info into metadata file
     fn sync_metadata(&self) -> vfs::Result<()> {
         let mut disk_inode = self.disk_inode.write();
@@ -504,48 +579,7 @@ impl vfs::INode for INodeImpl {
             vfs::FileType::Socket => FileType::Socket,
             _ => return Err(FsError::InvalidParam),
         };
-        let info = self.metadata()?;
-        if info.type_ != vfs::FileType::Dir {
-            return Err(FsError::NotDir);
-        }
-        if info.nlinks == 0 {
-            return Err(FsError::DirRemoved);
-        }
-        if name.len() > MAX_FNAME_LEN {
-            return Err(FsError::NameTooLong);
-        }
-
-        // Ensure the name is not exist
-        if self.get_file_inode_id(name).is_ok() {
-            return Err(FsError::EntryExist);
-        }
-
-        // Create a new INode
-        let inode = self.fs.new_inode(type_, mode)?;
-        if type_ == FileType::Dir {
-            inode.dirent_init(self.id)?;
-        }
-        // Insert it into dir entry
-        let entry = DiskEntry {
-            id: inode.id as u32,
-            name: Str256::from(name),
-            type_,
-        };
-        self.dirent_append(&entry)?;
-        // Append success, increase nlinks
-        inode.nlinks_inc();
-        if type_ == FileType::Dir {
-            inode.nlinks_inc(); //for .
-            self.nlinks_inc(); //for ..
-        }
-        // Update metadata file to make the INode valid
-        self.fs.sync_metadata()?;
-        inode.sync_all()?;
-        // Sync the dirINode's info into file
-        // MUST sync the INode's info first, or the entry maybe invalid
-        self.sync_all()?;
-
-        Ok(inode)
+        self.create_inode(name, type_, mode, None)
     }
 
     fn unlink(&self, name: &str) -> vfs::Result<()> {
@@ -1070,6 +1104,16 @@ impl SEFS {
 
     /// Create a new INode file
     fn new_inode(&self, type_: FileType, mode: u16) -> vfs::Result<Arc<INodeImpl>> {
+        self.new_inode_with_data(type_, mode, None)
+    }
+
+    /// Create a new INode file, with the data file given by `data` if it is some
+    fn new_inode_with_data(
+        &self,
+        type_: FileType,
+        mode: u16,
+        data: Option<DataFile>,
+    ) -> vfs::Result<Arc<INodeImpl>> {
         let id = self.alloc_block().ok_or(FsError::NoDeviceSpace)?;
         let (time, uuid) = if cfg!(feature = "create_image") && self.device.protect_integrity() {
             (Default::default(), SefsUuid::from(id))
@@ -1079,8 +1123,13 @@ impl SEFS {
                 self.uuid_provider.generate_uuid(),
             )
         };
+        let (uuid, size, create) = match data {
+            None => (uuid, 0, true),
+            Some(DataFile::Create(uuid)) => (uuid, 0, true),
+            Some(DataFile::Reuse(uuid, size)) => (uuid, size, false),
+        };
         let disk_inode = Dirty::new_dirty(DiskINode {
-            size: 0,
+            size: size as u64,
             type_,
             mode,
             nlinks: 0,
@@ -1094,7 +1143,7 @@ impl SEFS {
             disk_filename: uuid,
             inode_mac: Default::default(),
         });
-        self._new_inode(id, disk_inode, true)
+        self._new_inode(id, disk_inode, create)
     }
 
     fn flush_weak_inodes(&self) {
@@ -0,0 +1,267 @@
+//! Lazy copy-up of the files in image
+//!
+//! A file in image is not copied to container as a whole when it is going to be
+//! modified. Instead, a container file of the same size is created, and only the
+//! extents that are written are copied up from image. The copied extents are
+//! recorded in a bitmap, which is persisted in an extent map file beside the
+//! container file.
+//!
+//! Reading the extents that are not copied falls through to the image file. The
+//! image data is visible up to `image_len`, which is cut when the file is truncated.
+//!
+//! The layout of the extent map file:
+//!
+//! | image_len: u64 | bitmap of the copied extents |
+
+use alloc::{string::String, sync::Arc, vec, vec::Vec};
+use core::ops::Range;
+use rcore_fs::dev::{DevError, EIO};
+use rcore_fs::vfs::*;
+
+/// The granularity of copy-up
+pub const EXTENT_SIZE: usize = 0x1000;
+
+/// The size of the header of extent map file
+const HEADER_SIZE: usize = core::mem::size_of::<u64>();
+
+/// The max size of data copied by one write
+const COPY_BUF_SIZE: usize = 0x10000;
+
+/// The copied extents of a partially copied-up file
+pub struct ExtentMap {
+    /// The container dir which has the extent map file
+    dir: Arc<dyn INode>,
+    /// The name of the extent map file
+    name: String,
+    /// The extent map file
+    file: Arc<dyn INode>,
+    /// The length of the image data which is visible
+    image_len: usize,
+    /// One bit per extent, set if the extent is copied
+    bitmap: Vec<u8>,
+}
+
+impl ExtentMap {
+    /// Create an extent map file in `dir`, with no extents copied
+    pub fn create(dir: &Arc<dyn INode>, name: &str, image_len: usize) -> Result<Self> {
+        let file = dir.create(name, FileType::File, 0o777)?;
+        let map = Self {
+            dir: dir.clone(),
+            name: String::from(name),
+            file,
+            image_len,
+            bitmap: Vec::new(),
+        };
+        if let Err(e) = map.write_header() {
+            dir.unlink(name)?;
+            return Err(e);
+        }
+        Ok(map)
+    }
+
+    /// Load the extent map from the file in `dir`
+    pub fn load(dir: &Arc<dyn INode>, name: &str) -> Result<Self> {
+        let file = dir.find(name)?;
+        let content = file.read_as_vec()?;
+        if content.len() < HEADER_SIZE {
+            return Err(FsError::from(DevError(EIO)));
+        }
+        let mut header = [0u8; HEADER_SIZE];
+        header.copy_from_slice(&content[..HEADER_SIZE]);
+        Ok(Self {
+            dir: dir.clone(),
+            name: String::from(name),
+            file,
+            image_len: u64::from_le_bytes(header) as usize,
+            bitmap: content[HEADER_SIZE..].to_vec(),
+        })
+    }
+
+    /// Remove the extent map file
+    pub fn remove(&self) -> Result<()> {
+        match self.dir.unlink(&self.name) {
+            // the file may be unlinked already
+            Ok(_) | Err(FsError::EntryNotFound) => Ok(()),
+            Err(e) => Err(e),
+        }
+    }
+
+    pub fn sync(&self) -> Result<()> {
+        self.file.sync_all()
+    }
+
+    /// Read the merged data of image and container
+    pub fn read_at(
+        &self,
+        image: &Arc<dyn INode>,
+        container: &Arc<dyn INode>,
+        offset: usize,
+        buf: &mut [u8],
+    ) -> Result<usize> {
+        let size = container.metadata()?.size;
+        if offset >= size {
+            return Ok(0);
+        }
+        let len = buf.len().min(size - offset);
+        let end = offset + len;
+        let mut pos = offset;
+        while pos < end {
+            // read the consecutive extents in the same layer at a time
+            let from_image = self.is_in_image(pos / EXTENT_SIZE);
+            let mut run_end = (pos / EXTENT_SIZE + 1) * EXTENT_SIZE;
+            while run_end < end && self.is_in_image(run_end / EXTENT_SIZE) == from_image {
+                run_end += EXTENT_SIZE;
+            }
+            let run_end = run_end.min(end);
+            let run_buf = &mut buf[pos - offset..run_end - offset];
+            if from_image {
+                // the data beyond the visible image data are zeros
+                let image_end = run_end.min(self.image_len).max(pos);
+                let (image_buf, zero_buf) = run_buf.split_at_mut(image_end - pos);
+                read_full(image, pos, image_buf)?;
+                zero_buf.fill(0);
+            } else {
+                read_full(container, pos, run_buf)?;
+            }
+            pos = run_end;
+        }
+        Ok(len)
+    }
+
+    /// Write to container, copying up the extents partially covered by the write
+    pub fn write_at(
+        &mut self,
+        image: &Arc<dyn INode>,
+        container: &Arc<dyn INode>,
+        offset: usize,
+        buf: &[u8],
+    ) -> Result<usize> {
+        if buf.is_empty() {
+            return container.write_at(offset, buf);
+        }
+        let end = offset + buf.len();
+        let first = offset / EXTENT_SIZE;
+        let last = (end - 1) / EXTENT_SIZE;
+        if offset % EXTENT_SIZE != 0 || (first == last && end % EXTENT_SIZE != 0) {
+            self.copy_up(image, container, first..first + 1)?;
+        }
+        if last != first && end % EXTENT_SIZE != 0 {
+            self.copy_up(image, container, last..last + 1)?;
+        }
+        let len = container.write_at(offset, buf)?;
+        self.set_copied(offset..offset + len)?;
+        Ok(len)
+    }
+
+    /// Cut the visible image data when the file is truncated
+    pub fn truncate(&mut self, len: usize) -> Result<()> {
+        if len < self.image_len {
+            self.image_len = len;
+            self.write_header()?;
+        }
+        Ok(())
+    }
+
+    /// Copy up all the extents which are not copied yet
+    pub fn copy_up_all(
+        &mut self,
+        image: &Arc<dyn INode>,
+        container: &Arc<dyn INode>,
+    ) -> Result<()> {
+        let num_extents = (self.image_len + EXTENT_SIZE - 1) / EXTENT_SIZE;
+        self.copy_up(image, container, 0..num_extents)?;
+        self.set_copied(0..self.image_len)
+    }
+
+    /// Whether the data of the extent is in image
+    fn is_in_image(&self, idx: usize) -> bool {
+        let is_copied = self
+            .bitmap
+            .get(idx / 8)
+            .map_or(false, |byte| byte & (1 << (idx % 8)) != 0);
+        !is_copied && idx * EXTENT_SIZE < self.image_len
+    }
+
+    /// Copy the image data of the extents to container chunk by chunk
+    fn copy_up(
+        &self,
+        image: &Arc<dyn INode>,
+        container: &Arc<dyn INode>,
+        extents: Range<usize>,
+    ) -> Result<()> {
+        let mut buf = vec![0u8; COPY_BUF_SIZE.min(extents.len() * EXTENT_SIZE)];
+        let mut idx = extents.start;
+        while idx < extents.end {
+            if !self.is_in_image(idx) {
+                idx += 1;
+                continue;
+            }
+            let mut end_idx = idx + 1;
+            while end_idx < extents.end
+                && (end_idx - idx) * EXTENT_SIZE < buf.len()
+                && self.is_in_image(end_idx)
+            {
+                end_idx += 1;
+            }
+            let start = idx * EXTENT_SIZE;
+            let end = (end_idx * EXTENT_SIZE).min(self.image_len);
+            let chunk = &mut buf[..end - start];
+            read_full(image, start, chunk)?;
+            write_full(container, start, chunk)?;
+            idx = end_idx;
+        }
+        Ok(())
+    }
+
+    /// Mark the extents in the range copied and persist the changed bits
+    fn set_copied(&mut self, range: Range<usize>) -> Result<()> {
+        // the extents beyond the image data are never read from image
+        let end = range.end.min(self.image_len);
+        if range.start >= end {
+            return Ok(());
+        }
+        let first = range.start / EXTENT_SIZE;
+        let last = (end - 1) / EXTENT_SIZE;
+        if self.bitmap.len() <= last / 8 {
+            self.bitmap.resize(last / 8 + 1, 0);
+        }
+        let mut is_changed = false;
+        for idx in first..=last {
+            let byte = &mut self.bitmap[idx / 8];
+            if *byte & (1 << (idx % 8)) == 0 {
+                *byte |= 1 << (idx % 8);
+                is_changed = true;
+            }
+        }
+        if !is_changed {
+            return Ok(());
+        }
+        let bytes = first / 8..last / 8 + 1;
+        write_full(&self.file, HEADER_SIZE + bytes.start, &self.bitmap[bytes])
+    }
+
+    fn write_header(&self) -> Result<()> {
+        write_full(&self.file, 0, &(self.image_len as u64).to_le_bytes())
+    }
+}
+
+/// Read to fill the `buf`, the data beyond the end of file are zeros
+fn read_full(inode: &Arc<dyn INode>, offset: usize, buf: &mut [u8]) -> Result<()> {
+    let mut done = 0;
+    while done < buf.len() {
+        let len = inode.read_at(offset + done, &mut buf[done..])?;
+        if len == 0 {
+            buf[done..].fill(0);
+            break;
+        }
+        done += len;
+    }
+    Ok(())
+}
+
+fn write_full(inode: &Arc<dyn INode>, offset: usize, buf: &[u8]) -> Result<()> {
+    if inode.write_at(offset, buf)? != buf.len() {
+        return Err(FsError::from(DevError(EIO)));
+    }
+    Ok(())
+}
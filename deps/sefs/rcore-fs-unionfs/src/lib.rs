@@ -1,14 +1,12 @@
 #![cfg_attr(not(any(test, feature = "std")), no_std)]
 #![deny(warnings)]
 #![feature(get_mut_unchecked)]
-#![feature(new_uninit)]
 
 extern crate alloc;
 //#[macro_use]
 extern crate log;
 
 use alloc::{
-    boxed::Box,
     collections::BTreeMap,
     string::{String, ToString},
     sync::{Arc, Weak},
@@ -16,10 +14,12 @@ use alloc::{
 };
 use core::any::Any;
 use core::sync::atomic::{AtomicUsize, Ordering};
+use extent::ExtentMap;
 use rcore_fs::dev::{DevError, EIO};
 use rcore_fs::vfs::*;
 use spin::{RwLock, RwLockWriteGuard};
 
+mod extent;
 #[cfg(test)]
 mod tests;
 
@@ -70,6 +70,8 @@ struct UnionINodeInner {
     opaque: bool,
     /// Merged directory entries.
     cached_children: EntriesMap,
+    /// The copied extents if the file is partially copied up from image
+    extents: Option<ExtentMap>,
 }
 
 /// Directory entries
@@ -140,6 +142,8 @@ const MAC_FILE: &str = ".ufs.mac";
 const WH_PREFIX: &str = ".ufs.wh.";
 /// the prefix of opaque file
 const OPAQUE_PREFIX: &str = ".ufs.opq.";
+/// the prefix of extent map file
+const EXT_PREFIX: &str = ".ufs.ext.";
 
 impl UnionFS {
     /// Create a `UnionFS` wrapper for file system `fs`
@@ -230,6 +234,7 @@ impl UnionFS {
             inner: RwLock::new(UnionINodeInner {
                 inners,
                 cached_children: EntriesMap::new(),
+                extents: None,
                 this: Weak::default(),
                 parent: Weak::default(),
                 path_with_mode: PathWithMode::new(),
@@ -257,6 +262,7 @@ impl UnionFS {
             inner: RwLock::new(UnionINodeInner {
                 inners: inodes,
                 cached_children: EntriesMap::new(),
+                extents: None,
                 this: Weak::default(),
                 parent: Weak::default(),
                 path_with_mode,
@@ -270,6 +276,33 @@ impl UnionFS {
     fn alloc_inode_id(&self) -> usize {
         self.next_inode_id.fetch_add(1, Ordering::SeqCst)
     }
+
+    /// Copy up the rest extents of all the partially copied-up files, so that none
+    /// of the files depends on the image layer any more
+    pub fn materialize_all(&self) -> Result<()> {
+        Self::materialize_dir(&self.root_inode())
+    }
+
+    fn materialize_dir(dir: &UnionINode) -> Result<()> {
+        // only the dirs in container may have partially copied-up files
+        let container_dir = match dir.inner.read().maybe_container_inode() {
+            Some(inode) => inode.clone(),
+            None => return Ok(()),
+        };
+        for name in container_dir.list()? {
+            if name.is_self() || name.is_parent() || name.is_reserved() {
+                continue;
+            }
+            let inode = dir.find(&name)?;
+            let inode = inode.downcast_ref::<UnionINode>().unwrap();
+            match inode.metadata()?.type_ {
+                FileType::Dir => Self::materialize_dir(inode)?,
+                FileType::File => inode.materialize()?,
+                _ => {}
+            }
+        }
+        Ok(())
+    }
 }
 
 impl VirtualINode {
@@ -339,6 +372,7 @@ impl UnionINodeInner {
             for name in inode.list()? {
                 // skip the special entries
                 if name.starts_with(OPAQUE_PREFIX)
+                    || name.starts_with(EXT_PREFIX)
                     || name == MAC_FILE
                     || name.is_self()
                     || name.is_parent()
@@ -377,10 +411,15 @@ impl UnionINodeInner {
             .unwrap()
     }
 
+    /// Determine the upper INode in images
+    pub fn image_inode(&self) -> Option<&Arc<dyn INode>> {
+        self.inners[1..].iter().find_map(|v| v.as_real())
+    }
+
     /// Ensure container INode exists in this `UnionINode` and return it.
     ///
     /// If the INode is not exist, first `mkdir -p` the base path.
-    /// Then if it is a file, create a copy of the image file;
+    /// Then if it is a file, create a lazy copy of the image file (see `ExtentMap`);
     /// If it is a directory, create an empty dir.
     /// If it is a symlink, create a copy of the image symlink.
     pub fn container_inode(&mut self) -> Result<Arc<dyn INode>> {
@@ -421,34 +460,29 @@ impl UnionINodeInner {
                         last_inode = last_inode.create(last_inode_name, FileType::Dir, *mode)?;
                     }
                     FileType::File => {
+                        // copy it from image to container on write extent by extent
+                        let image_len = self.inode().metadata()?.size;
+                        let map_name = last_inode_name.extents();
+                        // remove the map left by an interrupted copy-up
+                        match last_inode.unlink(&map_name) {
+                            Ok(_) | Err(FsError::EntryNotFound) => {}
+                            Err(e) => return Err(e),
+                        }
+                        let extents = ExtentMap::create(&last_inode, &map_name, image_len)?;
                         let last_file_inode =
-                            last_inode.create(last_inode_name, FileType::File, *mode)?;
-                        // copy it from image to container chunk by chunk
-                        const BUF_SIZE: usize = 0x10000;
-                        let mut buf = unsafe { Box::<[u8; BUF_SIZE]>::new_uninit().assume_init() };
-                        let mut offset = 0usize;
-                        let mut len = BUF_SIZE;
-                        while len == BUF_SIZE {
-                            len = match self.inode().read_at(offset, buf.as_mut()) {
-                                Ok(len) => len,
+                            match last_inode.create(last_inode_name, FileType::File, *mode) {
+                                Ok(inode) => inode,
                                 Err(e) => {
-                                    last_inode.unlink(last_inode_name)?;
+                                    extents.remove()?;
                                     return Err(e);
                                 }
                             };
-                            match last_file_inode.write_at(offset, &buf[..len]) {
-                                Ok(len_written) if len_written != len => {
-                                    last_inode.unlink(last_inode_name)?;
-                                    return Err(FsError::from(DevError(EIO)));
-                                }
-                                Err(e) => {
-                                    last_inode.unlink(last_inode_name)?;
-                                    return Err(e);
-                                }
-                                Ok(_) => {}
-                            }
-                            offset += len;
+                        if let Err(e) = last_file_inode.resize(image_len) {
+                            last_inode.unlink(last_inode_name)?;
+                            extents.remove()?;
+                            return Err(e);
                         }
+                        self.extents = Some(extents);
                         last_inode = last_file_inode;
                     }
                     FileType::SymLink | FileType::Socket => {
@@ -485,6 +519,38 @@ impl UnionINodeInner {
         Ok(last_inode)
     }
 
+    /// Ensure container INode exists and holds the whole copy of the image file.
+    pub fn full_container_inode(&mut self) -> Result<Arc<dyn INode>> {
+        let inode = self.container_inode()?;
+        self.materialize()?;
+        Ok(inode)
+    }
+
+    /// Copy up the rest extents of a partially copied-up file
+    pub fn materialize(&mut self) -> Result<()> {
+        let mut extents = match self.extents.take() {
+            Some(extents) => extents,
+            None => return Ok(()),
+        };
+        let container = self.maybe_container_inode().unwrap().clone();
+        let image = self.image_inode().unwrap().clone();
+        let ret = extents
+            .copy_up_all(&image, &container)
+            .and_then(|_| container.sync_data())
+            .and_then(|_| extents.remove());
+        if ret.is_err() {
+            self.extents = Some(extents);
+        }
+        ret
+    }
+
+    /// Return the image INode and the copied extents if the file is partially copied up
+    fn partial_copy(&mut self) -> Option<(&Arc<dyn INode>, &mut ExtentMap)> {
+        let extents = self.extents.as_mut()?;
+        let image = self.inners[1..].iter().find_map(|v| v.as_real())?;
+        Some((image, extents))
+    }
+
     /// Return container INode if it has
     pub fn maybe_container_inode(&self) -> Option<&Arc<dyn INode>> {
         self.inners[0].as_real()
@@ -537,7 +603,7 @@ impl UnionINode {
         name: &str,
         id: Option<usize>,
         ext: Option<Extension>,
-    ) -> Arc<UnionINode> {
+    ) -> Result<Arc<UnionINode>> {
         let new_inode = {
             let inodes: Vec<_> = parent_guard.inners.iter().map(|x| x.find(name)).collect();
             let mode = inodes
@@ -560,23 +626,57 @@ impl UnionINode {
             let fs = fs.upgrade().unwrap();
             fs.create_inode(inodes, path_with_mode, opaque, id, ext)
         };
-        if new_inode.metadata().unwrap().type_ == FileType::Dir {
-            new_inode.inner.write().this = Arc::downgrade(&new_inode);
-            new_inode.inner.write().parent = Arc::downgrade(&parent_guard.this.upgrade().unwrap());
+        match new_inode.metadata().unwrap().type_ {
+            FileType::Dir => {
+                new_inode.inner.write().this = Arc::downgrade(&new_inode);
+                new_inode.inner.write().parent =
+                    Arc::downgrade(&parent_guard.this.upgrade().unwrap());
+            }
+            FileType::File => {
+                // load the copied extents if the file is partially copied up
+                let mut inner = new_inode.inner.write();
+                if let (true, Some(dir)) = (
+                    inner.inners[0].is_real(),
+                    parent_guard.maybe_container_inode(),
+                ) {
+                    match ExtentMap::load(dir, &name.extents()) {
+                        Ok(extents) => inner.extents = Some(extents),
+                        Err(FsError::EntryNotFound) => {}
+                        Err(e) => return Err(e),
+                    }
+                }
+            }
+            _ => {}
         }
-        new_inode
+        Ok(new_inode)
+    }
+
+    /// Copy up the rest extents if the file is partially copied up from image.
+    ///
+    /// Files are copied up from image lazily, the extents that are not written
+    /// are still read from image. This makes the container copy self-contained.
+    pub fn materialize(&self) -> Result<()> {
+        self.inner.write().materialize()
     }
 }
 
 impl INode for UnionINode {
     fn read_at(&self, offset: usize, buf: &mut [u8]) -> Result<usize> {
         let inner = self.inner.read();
-        inner.inode().read_at(offset, buf)
+        match (inner.extents.as_ref(), inner.image_inode()) {
+            // merge the copied extents in container with the image file
+            (Some(extents), Some(image)) => extents.read_at(image, inner.inode(), offset, buf),
+            _ => inner.inode().read_at(offset, buf),
+        }
     }
 
     fn write_at(&self, offset: usize, buf: &[u8]) -> Result<usize> {
         let mut inner = self.inner.write();
-        inner.container_inode()?.write_at(offset, buf)
+        let container_inode = inner.container_inode()?;
+        match inner.partial_copy() {
+            Some((image, extents)) => extents.write_at(image, &container_inode, offset, buf),
+            None => container_inode.write_at(offset, buf),
+        }
     }
 
     fn poll(&self) -> Result<PollStatus> {
@@ -599,29 +699,45 @@ impl INode for UnionINode {
     fn sync_all(&self) -> Result<()> {
         let inner = self.inner.read();
         if let Some(inode) = inner.maybe_container_inode() {
-            inode.sync_all()
-        } else {
-            Ok(())
+            inode.sync_all()?;
+        }
+        // sync the extent map after the data it records
+        if let Some(extents) = inner.extents.as_ref() {
+            extents.sync()?;
         }
+        Ok(())
     }
 
     fn sync_data(&self) -> Result<()> {
         let inner = self.inner.read();
         if let Some(inode) = inner.maybe_container_inode() {
-            inode.sync_data()
-        } else {
-            Ok(())
+            inode.sync_data()?;
         }
+        if let Some(extents) = inner.extents.as_ref() {
+            extents.sync()?;
+        }
+        Ok(())
     }
 
     fn fallocate(&self, mode: &FallocateMode, offset: usize, len: usize) -> Result<()> {
         let mut inner = self.inner.write();
-        inner.container_inode()?.fallocate(mode, offset, len)
+        let container_inode = match mode {
+            // allocating keeps the data as is
+            FallocateMode::Allocate(_) => inner.container_inode()?,
+            _ => inner.full_container_inode()?,
+        };
+        container_inode.fallocate(mode, offset, len)
     }
 
     fn resize(&self, len: usize) -> Result<()> {
         let mut inner = self.inner.write();
-        inner.container_inode()?.resize(len)
+        let container_inode = inner.container_inode()?;
+        container_inode.resize(len)?;
+        // the image data beyond the new end must not be seen again
+        if let Some((_, extents)) = inner.partial_copy() {
+            extents.truncate(len)?;
+        }
+        Ok(())
     }
 
     fn create(&self, name: &str, type_: FileType, mode: u16) -> Result<Arc<dyn INode>> {
@@ -662,7 +778,7 @@ impl INode for UnionINode {
                 }
             }
         }
-        let new_inode = Self::new_inode(&self.fs, &inner, name, None, None);
+        let new_inode = Self::new_inode(&self.fs, &inner, name, None, None)?;
         inner
             .entries()
             .insert(String::from(name), Some(Entry::new(&new_inode)));
@@ -690,7 +806,7 @@ impl INode for UnionINode {
         }
         // ensure 'child' exists in container
         // copy from image on necessary
-        let child_inode = child.inner.write().container_inode()?;
+        let child_inode = child.inner.write().full_container_inode()?;
         let mut inner = self.inner.write();
         // when we got the lock, the name may have been created by another thread
         if inner.entries().contains_key(name) {
@@ -745,7 +861,14 @@ impl INode for UnionINode {
                     dir_inode.unlink(&name.opaque())?;
                 }
             }
-            Ok(_) => dir_inode.unlink(name)?,
+            Ok(_) => {
+                dir_inode.unlink(name)?;
+                // remove the extent map if the file is partially copied up
+                match dir_inode.unlink(&name.extents()) {
+                    Ok(_) | Err(FsError::EntryNotFound) => {}
+                    Err(e) => return Err(e),
+                }
+            }
             Err(_) => {}
         }
         if inode
@@ -824,7 +947,7 @@ impl INode for UnionINode {
 
         // ensure 'old_name' exists in container
         // copy the file from image on necessary
-        old.inner.write().container_inode()?;
+        old.inner.write().full_container_inode()?;
         // self and target are the same INode
         if self.metadata()?.inode == target.metadata()?.inode {
             let mut self_inner = self.inner.write();
@@ -880,7 +1003,7 @@ impl INode for UnionINode {
                 new_name,
                 Some(old.id),
                 Some(old.ext.clone()),
-            );
+            )?;
             self_inner.entries().remove(old_name);
             self_inner
                 .entries()
@@ -949,7 +1072,7 @@ impl INode for UnionINode {
                 new_name,
                 Some(old.id),
                 Some(old.ext.clone()),
-            );
+            )?;
             self_inner.entries().remove(old_name);
             target_inner
                 .entries()
@@ -983,7 +1106,7 @@ impl INode for UnionINode {
         } else {
             None
         };
-        let new_inode = Self::new_inode(&self.fs, &inner, name, reused_id, None);
+        let new_inode = Self::new_inode(&self.fs, &inner, name, reused_id, None)?;
         inner
             .entries()
             .insert(String::from(name), Some(Entry::new(&new_inode)));
@@ -1042,7 +1165,7 @@ impl INode for UnionINode {
                 match inode_op {
                     Some(inode) => inode,
                     None => {
-                        let new_inode = Self::new_inode(&self.fs, &inner, name, reused_id, None);
+                        let new_inode = Self::new_inode(&self.fs, &inner, name, reused_id, None)?;
                         inner
                             .entries()
                             .insert(String::from(name), Some(Entry::new(&new_inode)));
@@ -1108,6 +1231,7 @@ impl PathWithMode {
 trait NameExt {
     fn whiteout(&self) -> String;
     fn opaque(&self) -> String;
+    fn extents(&self) -> String;
     fn is_reserved(&self) -> bool;
     fn is_self(&self) -> bool;
     fn is_parent(&self) -> bool;
@@ -1122,8 +1246,15 @@ impl NameExt for str {
         String::from(OPAQUE_PREFIX) + self
     }
 
+    fn extents(&self) -> String {
+        String::from(EXT_PREFIX) + self
+    }
+
     fn is_reserved(&self) -> bool {
-        self.starts_with(WH_PREFIX) || self.starts_with(OPAQUE_PREFIX) || self == MAC_FILE
+        self.starts_with(WH_PREFIX)
+            || self.starts_with(OPAQUE_PREFIX)
+            || self.starts_with(EXT_PREFIX)
+            || self == MAC_FILE
     }
 
     fn is_self(&self) -> bool {
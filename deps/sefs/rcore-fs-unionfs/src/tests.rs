@@ -1,6 +1,7 @@
 extern crate std;
 
-use crate::UnionFS;
+use crate::extent::EXTENT_SIZE;
+use crate::{UnionFS, UnionINode};
 use alloc::sync::Arc;
 use rcore_fs::vfs::*;
 use rcore_fs_ramfs::RamFS;
@@ -272,6 +273,87 @@ fn move_image() -> Result<()> {
     Ok(())
 }
 
+#[test]
+fn write_file_partially() -> Result<()> {
+    let (fs, croot, iroot) = create_sample()?;
+    let root = fs.root_inode();
+    let image_data: Vec<u8> = (0..EXTENT_SIZE * 4).map(|i| i as u8).collect();
+    iroot.lookup("file3")?.write_at(0, &image_data)?;
+
+    // write across the 2nd and 3rd extents
+    let file3 = root.lookup("file3")?;
+    const WRITE_DATA: &[u8] = b"I'm writing to container";
+    let offset = EXTENT_SIZE * 2 - 10;
+    file3.write_at(offset, WRITE_DATA)?;
+    let mut expected = image_data.clone();
+    expected[offset..offset + WRITE_DATA.len()].copy_from_slice(WRITE_DATA);
+    assert_eq!(file3.read_as_vec()?, expected);
+    assert_eq!(root.lookup("file3")?.read_as_vec()?, expected);
+
+    // only the written extents are copied up
+    let cfile3 = croot.lookup("file3")?.read_as_vec()?;
+    assert_eq!(cfile3.len(), image_data.len());
+    assert_eq!(
+        &cfile3[EXTENT_SIZE..EXTENT_SIZE * 3],
+        &expected[EXTENT_SIZE..EXTENT_SIZE * 3]
+    );
+    assert!(cfile3[..EXTENT_SIZE].iter().all(|&b| b == 0));
+    assert!(cfile3[EXTENT_SIZE * 3..].iter().all(|&b| b == 0));
+    assert!(croot.lookup(".ufs.ext.file3").is_ok());
+    assert_eq!(iroot.lookup("file3")?.read_as_vec()?, image_data);
+
+    // the copied extents are kept after the INode is dropped
+    drop(file3);
+    drop(root);
+    let root = fs.root_inode();
+    assert_eq!(root.lookup("file3")?.read_as_vec()?, expected);
+    let entries: BTreeSet<String> = root.list()?.into_iter().collect();
+    assert!(!entries.contains(".ufs.ext.file3"));
+    Ok(())
+}
+
+#[test]
+fn truncate_then_extend() -> Result<()> {
+    let (fs, _, iroot) = create_sample()?;
+    let root = fs.root_inode();
+    let image_data: Vec<u8> = (0..EXTENT_SIZE * 2).map(|i| i as u8).collect();
+    iroot.lookup("file3")?.write_at(0, &image_data)?;
+
+    let file3 = root.lookup("file3")?;
+    let len = EXTENT_SIZE + 10;
+    file3.resize(len)?;
+    assert_eq!(file3.read_as_vec()?, &image_data[..len]);
+    // the truncated image data is not seen again
+    file3.resize(EXTENT_SIZE * 2)?;
+    let mut expected = image_data[..len].to_vec();
+    expected.resize(EXTENT_SIZE * 2, 0);
+    assert_eq!(file3.read_as_vec()?, expected);
+    file3.write_at(EXTENT_SIZE + 20, b"container")?;
+    expected[EXTENT_SIZE + 20..EXTENT_SIZE + 29].copy_from_slice(b"container");
+    assert_eq!(file3.read_as_vec()?, expected);
+    Ok(())
+}
+
+#[test]
+fn materialize() -> Result<()> {
+    let (fs, croot, iroot) = create_sample()?;
+    let root = fs.root_inode();
+    let image_data: Vec<u8> = (0..EXTENT_SIZE * 3).map(|i| i as u8).collect();
+    iroot.lookup("dir/file4")?.write_at(0, &image_data)?;
+
+    let file4 = root.lookup("dir/file4")?;
+    file4.write_at(EXTENT_SIZE, b"container")?;
+    let mut expected = image_data.clone();
+    expected[EXTENT_SIZE..EXTENT_SIZE + 9].copy_from_slice(b"container");
+
+    file4.downcast_ref::<UnionINode>().unwrap().materialize()?;
+    assert_eq!(croot.lookup("dir/file4")?.read_as_vec()?, expected);
+    assert!(croot.lookup("dir/.ufs.ext.file4").is_not_found());
+    assert_eq!(file4.read_as_vec()?, expected);
+    assert_eq!(root.lookup("dir/file4")?.read_as_vec()?, expected);
+    Ok(())
+}
+
 const MODE: u16 = 0o777;
 
 trait IsNotFound {
@@ -0,0 +1,358 @@
+//! A parallel and incremental builder of SEFS images.
+//!
+//! An image is built in stages:
+//!
+//! 1. Scan: walk the source dir in the order of names;
+//! 2. Hash: hash the regular files in parallel. The data file of a regular file is
+//!    named by the hash of its key, path, mode and content, so an unchanged file has
+//!    the same data file as the one in the previous image;
+//! 3. Build: create the INodes in the scanned order. The data files found in the
+//!    previous image are reused, and the others are encrypted by worker threads;
+//! 4. Sync: sync the FS.
+
+use std::error::Error;
+use std::fs;
+use std::io::Read;
+use std::os::unix::ffi::OsStrExt;
+use std::os::unix::fs::PermissionsExt;
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc::{sync_channel, Receiver};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::Instant;
+
+use rcore_fs::vfs::{FileSystem, FileType, INode};
+use rcore_fs_sefs::dev::SefsUuid;
+use rcore_fs_sefs::{DataFile, INodeImpl, SEFS};
+use sha2::{Digest, Sha256};
+
+const BUF_SIZE: usize = 0x10000;
+const S_IMASK: u32 = 0o777;
+
+/// The max number of worker threads, which must not exceed the TCSNum of the enclave
+pub const MAX_JOBS: usize = 16;
+
+type WorkerResult = Result<(), String>;
+
+/// The options to build an image
+pub struct BuildOptions<'a> {
+    /// The previous image whose data files can be reused
+    pub reuse: Option<&'a Path>,
+    /// The key for encryption, which is a part of the hash
+    pub key: &'a Option<String>,
+    /// The number of worker threads
+    pub jobs: usize,
+}
+
+/// The default number of worker threads
+pub fn default_jobs() -> usize {
+    let ncores = unsafe { libc::sysconf(libc::_SC_NPROCESSORS_ONLN) };
+    (ncores.max(1) as usize).min(MAX_JOBS)
+}
+
+/// Build the SEFS image in `image` for the source `dir`
+pub fn build_image(
+    dir: &Path,
+    sefs_fs: &Arc<SEFS>,
+    image: &Path,
+    options: &BuildOptions,
+) -> Result<(), Box<dyn Error>> {
+    let jobs = options.jobs.max(1).min(MAX_JOBS);
+
+    let start = Instant::now();
+    let mut nodes = Vec::new();
+    scan_dir(dir, None, &mut nodes)?;
+    println!(
+        "[+] Scanned {} entries in {:.2?}",
+        nodes.len(),
+        start.elapsed()
+    );
+
+    let start = Instant::now();
+    let nodes = Arc::new(nodes);
+    let hashes = hash_files(dir, &nodes, options.key, jobs)?;
+    let total_size: usize = nodes.iter().filter_map(|node| node.file_size()).sum();
+    println!(
+        "[+] Hashed {} files ({} bytes) in {:.2?}",
+        hashes.iter().filter(|hash| hash.is_some()).count(),
+        total_size,
+        start.elapsed()
+    );
+
+    let start = Instant::now();
+    let (num_reused, num_encrypted) = build_nodes(
+        &nodes,
+        &hashes,
+        sefs_fs.root_inode(),
+        image,
+        options.reuse,
+        jobs,
+    )?;
+    println!(
+        "[+] Built {} INodes ({} files reused, {} files encrypted) in {:.2?}",
+        nodes.len(),
+        num_reused,
+        num_encrypted,
+        start.elapsed()
+    );
+
+    let start = Instant::now();
+    sefs_fs.sync()?;
+    println!("[+] Synced the image in {:.2?}", start.elapsed());
+    Ok(())
+}
+
+/// An entry in the source dir
+struct Node {
+    /// The path on host
+    path: PathBuf,
+    /// The index of the parent dir, or none if the parent is the root
+    parent: Option<usize>,
+    name: String,
+    mode: u16,
+    kind: NodeKind,
+}
+
+enum NodeKind {
+    Dir,
+    File(usize),
+    SymLink(Vec<u8>),
+}
+
+impl Node {
+    fn file_size(&self) -> Option<usize> {
+        match self.kind {
+            NodeKind::File(size) => Some(size),
+            _ => None,
+        }
+    }
+}
+
+fn scan_dir(
+    path: &Path,
+    parent: Option<usize>,
+    nodes: &mut Vec<Node>,
+) -> Result<(), Box<dyn Error>> {
+    let mut entries: Vec<fs::DirEntry> = fs::read_dir(path)?.map(|dir| dir.unwrap()).collect();
+    entries.sort_by_key(|entry| entry.file_name());
+    for entry in entries {
+        let name = entry.file_name().to_str().unwrap().to_string();
+        let metadata = fs::symlink_metadata(entry.path())?;
+        let type_ = metadata.file_type();
+        let mode = (metadata.permissions().mode() & S_IMASK) as u16;
+        let kind = if type_.is_file() {
+            NodeKind::File(metadata.len() as usize)
+        } else if type_.is_dir() {
+            NodeKind::Dir
+        } else if type_.is_symlink() {
+            let target = fs::read_link(entry.path())?;
+            NodeKind::SymLink(target.as_os_str().as_bytes().to_vec())
+        } else {
+            continue;
+        };
+        let is_dir = matches!(kind, NodeKind::Dir);
+        nodes.push(Node {
+            path: entry.path(),
+            parent,
+            name,
+            mode,
+            kind,
+        });
+        if is_dir {
+            let idx = nodes.len() - 1;
+            scan_dir(entry.path().as_path(), Some(idx), nodes)?;
+        }
+    }
+    Ok(())
+}
+
+/// Hash the regular files in parallel, return the hashes indexed by nodes
+fn hash_files(
+    dir: &Path,
+    nodes: &Arc<Vec<Node>>,
+    key: &Option<String>,
+    jobs: usize,
+) -> Result<Vec<Option<[u8; 16]>>, Box<dyn Error>> {
+    // The hash of a file depends on the key, as a data file encrypted by another key
+    // can not be reused
+    let key_tag = match key {
+        Some(key) => format!("key:{}", key),
+        None => String::from("integrity-only"),
+    };
+    let hashes = Arc::new(Mutex::new(vec![None; nodes.len()]));
+    let next_idx = Arc::new(AtomicUsize::new(0));
+    let workers: Vec<_> = (0..jobs)
+        .map(|_| {
+            let (nodes, hashes, next_idx) = (nodes.clone(), hashes.clone(), next_idx.clone());
+            let (dir, key_tag) = (dir.to_path_buf(), key_tag.clone());
+            thread::spawn(move || -> WorkerResult {
+                loop {
+                    let idx = next_idx.fetch_add(1, Ordering::Relaxed);
+                    let node = match nodes.get(idx) {
+                        Some(node) => node,
+                        None => return Ok(()),
+                    };
+                    if node.file_size().is_none() {
+                        continue;
+                    }
+                    let hash = hash_file(&dir, node, &key_tag)
+                        .map_err(|e| format!("failed to hash {:?}: {}", node.path, e))?;
+                    hashes.lock().unwrap()[idx] = Some(hash);
+                }
+            })
+        })
+        .collect();
+    join_workers(workers)?;
+    let hashes = Arc::try_unwrap(hashes).unwrap().into_inner().unwrap();
+    Ok(hashes)
+}
+
+fn hash_file(dir: &Path, node: &Node, key_tag: &str) -> std::io::Result<[u8; 16]> {
+    let mut hasher = Sha256::new();
+    hasher.update(key_tag.as_bytes());
+    hasher.update(&[0]);
+    hasher.update(node.path.strip_prefix(dir).unwrap().as_os_str().as_bytes());
+    hasher.update(&[0]);
+    hasher.update(&node.mode.to_le_bytes());
+    let mut file = fs::File::open(&node.path)?;
+    let mut buf = vec![0u8; BUF_SIZE];
+    loop {
+        let len = file.read(&mut buf)?;
+        if len == 0 {
+            break;
+        }
+        hasher.update(&buf[..len]);
+    }
+    let mut hash = [0u8; 16];
+    hash.copy_from_slice(&hasher.finalize()[..16]);
+    Ok(hash)
+}
+
+/// A file whose data is to be encrypted
+struct EncryptJob {
+    path: PathBuf,
+    size: usize,
+    inode: Arc<dyn INode>,
+}
+
+/// Create the INodes in order, and encrypt the new files by worker threads.
+/// Return the numbers of reused files and encrypted files.
+fn build_nodes(
+    nodes: &[Node],
+    hashes: &[Option<[u8; 16]>],
+    root_inode: Arc<dyn INode>,
+    image: &Path,
+    reuse: Option<&Path>,
+    jobs: usize,
+) -> Result<(usize, usize), Box<dyn Error>> {
+    // The channel is bounded, so the opened INodes of files are bounded too
+    let (sender, receiver) = sync_channel::<EncryptJob>(jobs * 4);
+    let receiver = Arc::new(Mutex::new(receiver));
+    let workers: Vec<_> = (0..jobs)
+        .map(|_| {
+            let receiver = receiver.clone();
+            thread::spawn(move || encrypt_files(&receiver))
+        })
+        .collect();
+
+    let mut dir_inodes: Vec<Option<Arc<dyn INode>>> = vec![None; nodes.len()];
+    let (mut num_reused, mut num_encrypted) = (0, 0);
+    let ret = (|| -> Result<(), Box<dyn Error>> {
+        for (idx, node) in nodes.iter().enumerate() {
+            let parent = match node.parent {
+                Some(parent) => dir_inodes[parent].as_ref().unwrap(),
+                None => &root_inode,
+            };
+            match &node.kind {
+                NodeKind::Dir => {
+                    let inode = parent.create(&node.name, FileType::Dir, node.mode)?;
+                    dir_inodes[idx] = Some(inode);
+                }
+                NodeKind::SymLink(target) => {
+                    let inode = parent.create(&node.name, FileType::SymLink, node.mode)?;
+                    inode.resize(target.len())?;
+                    inode.write_at(0, target)?;
+                }
+                NodeKind::File(size) => {
+                    let parent = parent.downcast_ref::<INodeImpl>().unwrap();
+                    let uuid = SefsUuid(hashes[idx].unwrap());
+                    let filename = uuid.to_string();
+                    let is_reused = match reuse {
+                        Some(reuse) => {
+                            reuse_data_file(&reuse.join(&filename), &image.join(&filename))
+                        }
+                        None => false,
+                    };
+                    if is_reused {
+                        parent.create_file(&node.name, node.mode, DataFile::Reuse(uuid, *size))?;
+                        num_reused += 1;
+                    } else {
+                        let inode =
+                            parent.create_file(&node.name, node.mode, DataFile::Create(uuid))?;
+                        let job = EncryptJob {
+                            path: node.path.clone(),
+                            size: *size,
+                            inode,
+                        };
+                        // The workers have quit on errors if the channel is closed
+                        if sender.send(job).is_err() {
+                            break;
+                        }
+                        num_encrypted += 1;
+                    }
+                }
+            }
+        }
+        Ok(())
+    })();
+    drop(sender);
+    join_workers(workers)?;
+    ret?;
+    Ok((num_reused, num_encrypted))
+}
+
+/// Link or copy the data file of the previous image into the new image
+fn reuse_data_file(prev: &Path, new: &Path) -> bool {
+    if !prev.is_file() {
+        return false;
+    }
+    fs::hard_link(prev, new).is_ok() || fs::copy(prev, new).is_ok()
+}
+
+fn encrypt_files(receiver: &Mutex<Receiver<EncryptJob>>) -> WorkerResult {
+    let mut buf = vec![0u8; BUF_SIZE];
+    loop {
+        let job = match receiver.lock().unwrap().recv() {
+            Ok(job) => job,
+            Err(_) => return Ok(()),
+        };
+        encrypt_file(&job, &mut buf)
+            .map_err(|e| format!("failed to encrypt {:?}: {}", job.path, e))?;
+    }
+}
+
+fn encrypt_file(job: &EncryptJob, buf: &mut [u8]) -> Result<(), Box<dyn Error>> {
+    let mut file = fs::File::open(&job.path)?;
+    job.inode.resize(job.size)?;
+    let mut offset = 0usize;
+    loop {
+        let len = file.read(buf)?;
+        if len == 0 {
+            break;
+        }
+        job.inode.write_at(offset, &buf[..len])?;
+        offset += len;
+    }
+    Ok(())
+}
+
+fn join_workers(workers: Vec<thread::JoinHandle<WorkerResult>>) -> Result<(), Box<dyn Error>> {
+    let mut ret = Ok(());
+    for worker in workers {
+        if let Err(e) = worker.join().expect("worker thread panicked") {
+            ret = Err(e.into());
+        }
+    }
+    ret
+}
@@ -13,11 +13,12 @@ use structopt::StructOpt;
 use rcore_fs::dev::std_impl::StdTimeProvider;
 use rcore_fs::vfs::FileSystem;
 use rcore_fs_cli::fuse::VfsFuse;
-use rcore_fs_cli::zip::{unzip_dir, zip_dir};
+use rcore_fs_cli::zip::unzip_dir;
 use rcore_fs_sefs as sefs;
 use rcore_fs_sefs::dev::std_impl::StdUuidProvider;
 use rcore_fs_unionfs as unionfs;
 
+mod builder;
 mod enclave;
 mod sgx_dev;
 
@@ -48,6 +49,12 @@ enum Cmd {
         /// Key for encryption
         #[structopt(short, long, parse(from_os_str))]
         key: Option<PathBuf>,
+        /// Previous SEFS image directory, whose unchanged files are reused
+        #[structopt(short, long, parse(from_os_str))]
+        reuse: Option<PathBuf>,
+        /// Number of threads to encrypt files (default: number of CPUs)
+        #[structopt(short, long)]
+        jobs: Option<usize>,
     },
     /// Unzip data from given <image> to <dir>
     #[structopt(name = "unzip")]
@@ -150,16 +157,22 @@ fn main() -> Result<(), Box<dyn Error>> {
             image,
             mac,
             key,
+            reuse,
+            jobs,
         } => {
+            std::fs::create_dir(&image)?;
+            let key = parse_key(&key)?;
             let sefs_fs = {
-                std::fs::create_dir(&image)?;
-                let key = parse_key(&key)?;
                 let mode = sgx_dev::EncryptMode::from_parameters(true, &key)?;
                 let device = sgx_dev::SgxStorage::new(enclave.geteid(), &image, mode);
                 sefs::SEFS::create(Box::new(device), &StdTimeProvider, &StdUuidProvider)?
             };
-            zip_dir(&dir, sefs_fs.root_inode())?;
-            sefs_fs.sync()?;
+            let options = builder::BuildOptions {
+                reuse: reuse.as_deref().filter(|reuse| reuse.is_dir()),
+                key: &key,
+                jobs: jobs.unwrap_or_else(builder::default_jobs),
+            };
+            builder::build_image(&dir, &sefs_fs, &image, &options)?;
             let root_mac_str = {
                 let mut s = String::from("");
                 for (i, byte) in sefs_fs.root_mac().iter().enumerate() {
@@ -13,9 +13,9 @@ use futures::executor;
 use grpc::prelude::*;
 use grpc::ClientConf;
 use occlum_exec::occlum_exec::{
-    ExecCommRequest, ExecCommResponse_ExecutionStatus, GetResultRequest,
-    GetResultResponse_ExecutionStatus, HealthCheckRequest, HealthCheckResponse_ServingStatus,
-    KillProcessRequest, StopRequest,
+    Command as BatchCommand, ExecCommRequest, ExecCommResponse_ExecutionStatus, ExecCommsRequest,
+    GetResultRequest, GetResultResponse_ExecutionStatus, HealthCheckRequest,
+    HealthCheckResponse_ServingStatus, KillProcessRequest, StopRequest,
 };
 use occlum_exec::occlum_exec_grpc::OcclumExecClient;
 use occlum_exec::{DEFAULT_SERVER_FILE, DEFAULT_SERVER_TIMER, DEFAULT_SOCK_FILE};
@@ -113,6 +113,111 @@ fn exec_command(
     }
 }
 
+// The max number of fds sent in one message, which is below SCM_MAX_FD of Linux
+const MAX_FDS_PER_MESSAGE: usize = 3 * 64;
+
+/// Execute a batch of commands on server, and wait for all of them to stop
+///
+/// Returns the first non-zero return value of the commands, or 0 if all of them
+/// return 0.
+fn exec_commands(
+    client: &OcclumExecClient,
+    commands: &[Vec<&str>],
+    envs: &[&str],
+) -> Result<i32, String> {
+    debug!("exec_commands {:?} {:?}", commands, envs);
+
+    let mut command_list = RepeatedField::default();
+    for args in commands {
+        // Change args[0] from path name to program name
+        let program_name = Path::new(args[0]).file_name().unwrap().to_str().unwrap();
+        let parameters = std::iter::once(program_name)
+            .chain(args[1..].iter().cloned())
+            .map(|p| p.to_string())
+            .collect();
+        command_list.push(BatchCommand {
+            command: args[0].to_string(),
+            parameters: RepeatedField::from_vec(parameters),
+            enviroments: RepeatedField::from_vec(envs.iter().map(|e| e.to_string()).collect()),
+            ..Default::default()
+        });
+    }
+
+    let tmp_dir = TempDir::new("occlum_tmp").expect("create temp dir");
+    let sockpath = tmp_dir.path().join("occlum.sock");
+
+    let listener = UnixListener::bind(&sockpath).unwrap();
+
+    //the thread would send the stdio of all the commands to server
+    let stdio_fds: Vec<i32> = commands.iter().flat_map(|_| vec![0, 1, 2]).collect();
+    let sendfd_thread = thread::spawn(move || {
+        for stream in listener.incoming() {
+            match stream {
+                Ok(stream) => {
+                    debug!("server connected");
+                    if stdio_fds
+                        .chunks(MAX_FDS_PER_MESSAGE)
+                        .all(|fds| stream.send_with_fd(&[0], fds).is_ok())
+                    {
+                        break;
+                    }
+                }
+                Err(e) => {
+                    debug!("connection failed: {}", e);
+                }
+            }
+        }
+    });
+
+    let responses = client
+        .exec_commands(
+            grpc::RequestOptions::new(),
+            ExecCommsRequest {
+                sockpath: String::from(sockpath.as_path().to_str().unwrap()),
+                commands: command_list,
+                ..Default::default()
+            },
+        )
+        .drop_metadata(); // Drop response metadata
+    let mut responses = executor::block_on_stream(responses);
+
+    // The first response has the process ids of the commands
+    let launched = match responses.next() {
+        Some(Ok(resp)) => resp.responses.into_vec(),
+        _ => return Err(String::from("failed to send request.")),
+    };
+    let num_running = launched
+        .iter()
+        .filter(|resp| resp.status == ExecCommResponse_ExecutionStatus::RUNNING)
+        .count();
+    if num_running > 0 {
+        sendfd_thread.join().unwrap();
+    }
+
+    // The later ones have the return values, until all the commands stop
+    let mut return_value = 0;
+    for resp in responses {
+        match resp {
+            Ok(resp) => {
+                let result = resp.get_result();
+                debug!("process:{} returns {}", result.process_id, result.result);
+                if return_value == 0 {
+                    return_value = result.result;
+                }
+            }
+            Err(_) => return Err(String::from("failed to get the return values.")),
+        }
+    }
+
+    if num_running < launched.len() {
+        return Err(format!(
+            "failed to launch {} of the processes.",
+            launched.len() - num_running
+        ));
+    }
+    Ok(return_value)
+}
+
 /// Starts the server if the server is not running
 fn start_server(client: &OcclumExecClient, server_name: &str) -> Result<u32, String> {
     let mut server_launched = false;
@@ -276,6 +381,11 @@ fn main() -> Result<(), i32> {
                 .about("Execute the command on server.")
                 .arg(Arg::with_name("args").multiple(true).min_values(1).last(true).help("The arguments for the command")),
         )
+        .subcommand(
+            App::new("exec_batch")
+                .about("Execute a batch of commands on server.")
+                .arg(Arg::with_name("commands").multiple(true).min_values(1).last(true).help("The commands, each of which is the arguments separated by spaces")),
+        )
         .get_matches();
 
     let env: Vec<String> = env::vars()
@@ -368,6 +478,26 @@ fn main() -> Result<(), i32> {
                 return Err(-1);
             }
         };
+    } else if let Some(ref matches) = matches.subcommand_matches("exec_batch") {
+        let commands: Vec<Vec<&str>> = matches
+            .values_of("commands")
+            .unwrap()
+            .map(|command| command.split_whitespace().collect::<Vec<_>>())
+            .collect();
+        if commands.iter().any(|args| args.is_empty()) {
+            println!("empty command");
+            return Err(-1);
+        }
+        let env: Vec<&str> = env.iter().map(|string| string.as_str()).collect();
+
+        match exec_commands(&client, &commands, &env) {
+            Ok(0) => {}
+            Ok(result) => return Err(result),
+            Err(s) => {
+                debug!("execute commands failed {}", s);
+                return Err(-1);
+            }
+        }
     } else {
         unreachable!();
     }
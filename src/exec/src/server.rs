@@ -2,19 +2,25 @@ extern crate chrono;
 extern crate nix;
 extern crate timer;
 use crate::occlum_exec::{
-    ExecCommRequest, ExecCommResponse, ExecCommResponse_ExecutionStatus, GetResultRequest,
-    GetResultResponse, GetResultResponse_ExecutionStatus, HealthCheckRequest, HealthCheckResponse,
-    HealthCheckResponse_ServingStatus, KillProcessRequest, KillProcessResponse, StopRequest,
-    StopResponse,
+    Command, ExecCommRequest, ExecCommResponse, ExecCommResponse_ExecutionStatus, ExecCommsRequest,
+    ExecCommsResponse, GetResultRequest, GetResultResponse, GetResultResponse_ExecutionStatus,
+    HealthCheckRequest, HealthCheckResponse, HealthCheckResponse_ServingStatus, KillProcessRequest,
+    KillProcessResponse, ProcessResult, StopRequest, StopResponse,
 };
 use crate::occlum_exec_grpc::OcclumExec;
-use grpc::{ServerHandlerContext, ServerRequestSingle, ServerResponseUnarySink};
+use futures::channel::mpsc;
+use futures::StreamExt;
+use grpc::{
+    ServerHandlerContext, ServerRequestSingle, ServerResponseSink, ServerResponseUnarySink,
+};
 use nix::sys::signal::{self, Signal};
 use nix::unistd::Pid;
+use protobuf::{RepeatedField, SingularPtrField};
 use sendfd::RecvWithFd;
 use std::cmp;
 use std::collections::HashMap;
 use std::ffi::CString;
+use std::io;
 use std::os::unix::io::RawFd;
 use std::os::unix::net::UnixStream;
 use std::panic;
@@ -281,6 +287,158 @@ impl OcclumExec for OcclumExecImpl {
             })
         }
     }
+
+    fn exec_commands(
+        &self,
+        o: ServerHandlerContext,
+        mut req: ServerRequestSingle<ExecCommsRequest>,
+        resp: ServerResponseSink<ExecCommsResponse>,
+    ) -> grpc::Result<()> {
+        // Clear the timer for we need the server continue service
+        *self.stop_timer.lock().unwrap() = None;
+
+        let req = req.take_message();
+        let commands = req.commands.into_vec();
+
+        // The responses of this batch only, which end when all the senders are dropped
+        let (sender, receiver) = mpsc::unbounded();
+        o.pump(receiver.map(Ok), resp);
+
+        let launch_failed = || ExecCommResponse {
+            status: ExecCommResponse_ExecutionStatus::LAUNCH_FAILED,
+            process_id: 0,
+            ..Default::default()
+        };
+        let failed_responses = || ExecCommsResponse {
+            responses: RepeatedField::from_vec(commands.iter().map(|_| launch_failed()).collect()),
+            ..Default::default()
+        };
+
+        //Get the client stdio of all the commands
+        let stdio_fds = match recv_stdio_fds(&req.sockpath, commands.len()) {
+            Ok(stdio_fds) => stdio_fds,
+            Err(e) => {
+                info!("Failed to receive stdio fds: {}", e);
+                sender
+                    .unbounded_send(failed_responses())
+                    .unwrap_or_default();
+                return Ok(());
+            }
+        };
+
+        let process_ids = match rust_occlum_pal_create_processes(&commands, &stdio_fds) {
+            Ok(process_ids) => process_ids,
+            Err(_) => {
+                close_stdio_fds(&stdio_fds);
+                sender
+                    .unbounded_send(failed_responses())
+                    .unwrap_or_default();
+                return Ok(());
+            }
+        };
+
+        let mut launched_commands = self.commands.lock().unwrap();
+        let responses = process_ids
+            .iter()
+            .zip(stdio_fds.iter())
+            .map(|(&process_id, stdio)| {
+                if process_id <= 0 {
+                    close_stdio_fds(std::slice::from_ref(stdio));
+                    return launch_failed();
+                }
+                launched_commands.entry(process_id).or_insert((None, true));
+                ExecCommResponse {
+                    status: ExecCommResponse_ExecutionStatus::RUNNING,
+                    process_id,
+                    ..Default::default()
+                }
+            })
+            .collect();
+        drop(launched_commands);
+        sender
+            .unbounded_send(ExecCommsResponse {
+                responses: RepeatedField::from_vec(responses),
+                ..Default::default()
+            })
+            .unwrap_or_default();
+
+        for process_id in process_ids.into_iter().filter(|&pid| pid > 0) {
+            //Run the command in a thread, and send the result to the client when it stops
+            let commands = self.commands.clone();
+            let sender = sender.clone();
+            thread::spawn(move || {
+                let mut exit_status = Box::new(0);
+
+                let result = match rust_occlum_pal_exec(process_id, &mut exit_status) {
+                    Ok(()) => *exit_status,
+                    // Return -1 if the process crashed or get any unexpected error
+                    Err(_) => -1,
+                };
+                debug!("process:{} finished, send the result", process_id);
+
+                // The result is reported once. It is kept for GetResult only if the
+                // client has stopped receiving the responses.
+                let mut commands = commands.lock().unwrap();
+                let response = ExecCommsResponse {
+                    result: SingularPtrField::some(ProcessResult {
+                        process_id,
+                        result,
+                        ..Default::default()
+                    }),
+                    ..Default::default()
+                };
+                if sender.unbounded_send(response).is_ok() {
+                    commands.remove(&process_id);
+                } else {
+                    *commands.get_mut(&process_id).expect("get process") = (Some(result), false);
+                }
+            });
+        }
+
+        Ok(())
+    }
+}
+
+/// Receive the stdio fds of `num` commands, three for each, which may be sent in
+/// multiple messages
+fn recv_stdio_fds(sockpath: &str, num: usize) -> io::Result<Vec<occlum_stdio_fds>> {
+    let stream = UnixStream::connect(sockpath)?;
+    let mut data = [0; 10];
+    let mut fdlist: Vec<RawFd> = vec![0; num * 3];
+    let mut num_received = 0;
+    while num_received < fdlist.len() {
+        let num_fds = match stream.recv_with_fd(&mut data, &mut fdlist[num_received..]) {
+            Ok((_, num_fds)) if num_fds > 0 => num_fds,
+            res => {
+                // The fds received so far are not used by any process
+                for &fd in &fdlist[..num_received] {
+                    let _ = nix::unistd::close(fd);
+                }
+                return Err(res.err().unwrap_or_else(|| {
+                    io::Error::new(io::ErrorKind::UnexpectedEof, "not enough stdio fds")
+                }));
+            }
+        };
+        num_received += num_fds;
+    }
+
+    Ok(fdlist
+        .chunks(3)
+        .map(|fds| occlum_stdio_fds {
+            stdin_fd: fds[0],
+            stdout_fd: fds[1],
+            stderr_fd: fds[2],
+        })
+        .collect())
+}
+
+/// Close the stdio fds of the commands whose processes are not created
+fn close_stdio_fds(stdio_fds: &[occlum_stdio_fds]) {
+    for fds in stdio_fds {
+        for &fd in &[fds.stdin_fd, fds.stdout_fd, fds.stderr_fd] {
+            let _ = nix::unistd::close(fd);
+        }
+    }
 }
 
 /*
@@ -324,6 +482,19 @@ extern "C" {
      */
     fn occlum_pal_create_process(args: *const occlum_pal_create_process_args) -> i32;
 
+    /*
+     * @brief Create a batch of new processes inside the Occlum enclave
+     *
+     * @param args  Mandatory input. An array of arguments, one for each process.
+     *              The pid of each process is updated, or set to -errno if the
+     *              process fails to be created.
+     * @param num   The number of processes, which must be positive.
+     *
+     * @retval If 0, then success, even if some processes fail to be created;
+     *         otherwise, check errno for the exact error type.
+     */
+    fn occlum_pal_create_processes(args: *mut occlum_pal_create_process_args, num: i32) -> i32;
+
     /*
      * @brief Execute the process inside the Occlum enclave
      *
@@ -393,6 +564,42 @@ fn rust_occlum_pal_create_process(
     }
 }
 
+/// Creates the processes of the commands inside Occlum enclave in one batch. Returns
+/// the pid of each process, or -errno if the process fails to be created.
+fn rust_occlum_pal_create_processes(
+    commands: &[Command],
+    stdio: &[occlum_stdio_fds],
+) -> Result<Vec<i32>, i32> {
+    let mut libos_tids = vec![0; commands.len()];
+    // The strings pointed by the args, which must outlive the args
+    let mut contents = Vec::with_capacity(commands.len());
+    let mut args = Vec::with_capacity(commands.len());
+    for ((command, stdio), libos_tid) in
+        commands.iter().zip(stdio.iter()).zip(libos_tids.iter_mut())
+    {
+        let cmd_path = CString::new(command.command.as_str()).expect("cmd_path: new failed");
+        let (cmd_args_array, cmd_args) = vec_strings_to_cchars(&command.parameters.to_vec())?;
+        let (cmd_envs_array, cmd_envs) = vec_strings_to_cchars(&command.enviroments.to_vec())?;
+
+        args.push(occlum_pal_create_process_args {
+            path: cmd_path.as_ptr() as *const libc::c_char,
+            argv: cmd_args_array.as_ptr() as *const *const libc::c_char,
+            env: cmd_envs_array.as_ptr() as *const *const libc::c_char,
+            stdio: stdio as *const occlum_stdio_fds,
+            pid: libos_tid as *mut i32,
+        });
+        contents.push((cmd_path, cmd_args_array, cmd_args, cmd_envs_array, cmd_envs));
+    }
+
+    let ret = unsafe { occlum_pal_create_processes(args.as_mut_ptr(), args.len() as i32) };
+    drop(args);
+
+    match ret {
+        0 => Ok(libos_tids),
+        _ => Err(ret),
+    }
+}
+
 fn rust_occlum_pal_exec(occlum_process_id: i32, exit_status: &mut i32) -> Result<(), i32> {
     let args = occlum_pal_exec_args {
         pid: occlum_process_id,
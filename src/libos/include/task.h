@@ -25,12 +25,23 @@ struct Task {
     jmp_buf*            saved_state;
 };
 
+// See Struct Context in coroutine.rs
+struct Context {
+    uint64_t            rsp;
+    uint64_t            stack_base;
+    uint64_t            stack_limit;
+    uint64_t            task;
+};
+
 void __set_current_task(struct Task* task);
 struct Task* __get_current_task(void);
 
 int do_run_task(struct Task* task);
 void do_exit_task(void);
 
+void do_init_context(struct Context* context, void (*entry)(void*), void* arg);
+void do_switch_context(struct Context* from, struct Context* to);
+
 #ifdef __cplusplus
 }
 #endif
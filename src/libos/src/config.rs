@@ -102,6 +102,7 @@ pub fn parse_key(key_str: &str) -> Result<sgx_key_128bit_t> {
 pub struct Config {
     pub resource_limits: ConfigResourceLimits,
     pub process: ConfigProcess,
+    pub scheduler: ConfigScheduler,
     pub env: ConfigEnv,
     pub app: Vec<ConfigApp>,
 }
@@ -116,6 +117,22 @@ pub struct ConfigProcess {
     pub default_stack_size: usize,
     pub default_heap_size: usize,
     pub default_mmap_size: usize,
+    pub templates: Vec<PathBuf>,
+}
+
+#[derive(Debug)]
+pub struct ConfigScheduler {
+    pub mode: ConfigSchedMode,
+    pub num_of_vcpus: usize,
+    pub task_stack_size: usize,
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum ConfigSchedMode {
+    /// Each LibOS thread runs on a host thread of its own
+    OneToOne,
+    /// LibOS threads are multiplexed on a fixed pool of host threads (vCPUs)
+    ManyToMany,
 }
 
 #[derive(Debug)]
@@ -175,12 +192,15 @@ pub struct ConfigMountOptions {
     pub layers: Option<Vec<ConfigMount>>,
     pub temporary: bool,
     pub index: u32,
+    // Copy up all the partially copied-up files of a UnionFS when it is mounted
+    pub materialize: bool,
 }
 
 impl Config {
     fn from_input(input: &InputConfig) -> Result<Config> {
         let resource_limits = ConfigResourceLimits::from_input(&input.resource_limits)?;
         let process = ConfigProcess::from_input(&input.process)?;
+        let scheduler = ConfigScheduler::from_input(&input.scheduler)?;
         let env = ConfigEnv::from_input(&input.env)?;
 
         let app = {
@@ -194,6 +214,7 @@ impl Config {
         Ok(Config {
             resource_limits,
             process,
+            scheduler,
             env,
             app,
         })
@@ -222,10 +243,45 @@ impl ConfigProcess {
         let default_stack_size = parse_memory_size(&input.default_stack_size)?;
         let default_heap_size = parse_memory_size(&input.default_heap_size)?;
         let default_mmap_size = parse_memory_size(&input.default_mmap_size)?;
+        let templates = {
+            let mut templates = Vec::new();
+            for template in &input.templates {
+                let template_path = Path::new(template).to_path_buf();
+                if !template_path.is_absolute() {
+                    return_errno!(EINVAL, "process template must be an absolute path")
+                }
+                templates.push(template_path);
+            }
+            templates
+        };
         Ok(ConfigProcess {
             default_stack_size,
             default_heap_size,
             default_mmap_size,
+            templates,
+        })
+    }
+}
+
+impl ConfigScheduler {
+    const MAX_NUM_OF_VCPUS: usize = 256;
+
+    fn from_input(input: &InputConfigScheduler) -> Result<ConfigScheduler> {
+        let mode = match input.mode.as_str() {
+            "1:1" => ConfigSchedMode::OneToOne,
+            "M:N" => ConfigSchedMode::ManyToMany,
+            _ => return_errno!(EINVAL, "Unsupported scheduler mode"),
+        };
+        let num_of_vcpus = match input.num_of_vcpus {
+            0 => (*crate::sched::NCORES).min(Self::MAX_NUM_OF_VCPUS),
+            n if n > Self::MAX_NUM_OF_VCPUS => return_errno!(EINVAL, "Too many vCPUs"),
+            n => n,
+        };
+        let task_stack_size = parse_memory_size(&input.task_stack_size)?;
+        Ok(ConfigScheduler {
+            mode,
+            num_of_vcpus,
+            task_stack_size,
         })
     }
 }
@@ -317,6 +373,7 @@ impl ConfigMountOptions {
             layers,
             temporary: input.temporary,
             index: input.index,
+            materialize: input.materialize,
         })
     }
 }
@@ -354,6 +411,8 @@ struct InputConfig {
     #[serde(default)]
     pub process: InputConfigProcess,
     #[serde(default)]
+    pub scheduler: InputConfigScheduler,
+    #[serde(default)]
     pub env: InputConfigEnv,
     #[serde(default)]
     pub app: Vec<InputConfigApp>,
@@ -388,6 +447,8 @@ struct InputConfigProcess {
     pub default_heap_size: String,
     #[serde(default = "InputConfigProcess::get_default_mmap_size")]
     pub default_mmap_size: String,
+    #[serde(default)]
+    pub templates: Vec<String>,
 }
 
 impl InputConfigProcess {
@@ -410,6 +471,38 @@ impl Default for InputConfigProcess {
             default_stack_size: InputConfigProcess::get_default_stack_size(),
             default_heap_size: InputConfigProcess::get_default_heap_size(),
             default_mmap_size: InputConfigProcess::get_default_mmap_size(),
+            templates: Vec::new(),
+        }
+    }
+}
+
+#[derive(Deserialize, Debug)]
+#[serde(deny_unknown_fields)]
+struct InputConfigScheduler {
+    #[serde(default = "InputConfigScheduler::get_mode")]
+    pub mode: String,
+    #[serde(default)]
+    pub num_of_vcpus: usize,
+    #[serde(default = "InputConfigScheduler::get_task_stack_size")]
+    pub task_stack_size: String,
+}
+
+impl InputConfigScheduler {
+    fn get_mode() -> String {
+        "1:1".to_string()
+    }
+
+    fn get_task_stack_size() -> String {
+        "256KB".to_string()
+    }
+}
+
+impl Default for InputConfigScheduler {
+    fn default() -> InputConfigScheduler {
+        InputConfigScheduler {
+            mode: InputConfigScheduler::get_mode(),
+            num_of_vcpus: 0,
+            task_stack_size: InputConfigScheduler::get_task_stack_size(),
         }
     }
 }
@@ -453,6 +546,8 @@ struct InputConfigMountOptions {
     pub temporary: bool,
     #[serde(default)]
     pub index: u32,
+    #[serde(default)]
+    pub materialize: bool,
 }
 
 #[derive(Deserialize, Debug)]
@@ -5,7 +5,7 @@ use std::sync::Once;
 
 use super::*;
 use crate::exception::*;
-use crate::fs::{HostStdioFds, do_mount_rootfs};
+use crate::fs::{do_mount_rootfs, HostStdioFds};
 use crate::interrupt;
 use crate::process::idle_reap_zombie_children;
 use crate::process::{ProcessFilter, SpawnAttr};
@@ -165,6 +165,59 @@ pub extern "C" fn occlum_ecall_new_process(
     .unwrap_or(ecall_errno!(EFAULT))
 }
 
+/// The arguments of a process in occlum_ecall_new_processes, which is the same as
+/// `struct occlum_pal_create_process_args` in PAL
+#[repr(C)]
+pub struct NewProcessArgs {
+    path: *const c_char,
+    argv: *const *const c_char,
+    env: *const *const c_char,
+    host_stdio_fds: *const HostStdioFds,
+    pid: *mut i32,
+}
+
+#[no_mangle]
+pub extern "C" fn occlum_ecall_new_processes(
+    args: *const NewProcessArgs,
+    pids: *mut i32,
+    num: usize,
+) -> i32 {
+    if HAS_INIT.load(Ordering::SeqCst) == false {
+        return ecall_errno!(EAGAIN);
+    }
+    if args.is_null() || pids.is_null() {
+        return ecall_errno!(EINVAL);
+    }
+
+    // Both arrays have been guaranteed to be inside enclave by ECall
+    let args = unsafe { std::slice::from_raw_parts(args, num) };
+    let pids = unsafe { std::slice::from_raw_parts_mut(pids, num) };
+    for (process_args, pid) in args.iter().zip(pids.iter_mut()) {
+        let (path, args, env, host_stdio_fds) = match parse_untrusted_arguments(process_args) {
+            Ok(all_parsed_args) => all_parsed_args,
+            Err(e) => {
+                eprintln!("invalid arguments for LibOS: {}", e.backtrace());
+                *pid = ecall_errno!(e.errno());
+                continue;
+            }
+        };
+
+        *pid = panic::catch_unwind(|| {
+            backtrace::__rust_begin_short_backtrace(|| {
+                match do_new_process(&path, &args, env, &host_stdio_fds) {
+                    Ok(pid_t) => pid_t as i32,
+                    Err(e) => {
+                        eprintln!("failed to boot up LibOS: {}", e.backtrace());
+                        ecall_errno!(e.errno())
+                    }
+                }
+            })
+        })
+        .unwrap_or(ecall_errno!(EFAULT));
+    }
+    0
+}
+
 #[no_mangle]
 pub extern "C" fn occlum_ecall_exec_thread(libos_pid: i32, host_tid: i32) -> i32 {
     if HAS_INIT.load(Ordering::SeqCst) == false {
@@ -185,6 +238,26 @@ pub extern "C" fn occlum_ecall_exec_thread(libos_pid: i32, host_tid: i32) -> i32
     .unwrap_or(ecall_errno!(EFAULT))
 }
 
+#[no_mangle]
+pub extern "C" fn occlum_ecall_exec_vcpu(vcpu_id: i32, host_tid: i32) -> i32 {
+    if HAS_INIT.load(Ordering::SeqCst) == false {
+        return ecall_errno!(EAGAIN);
+    }
+
+    panic::catch_unwind(|| {
+        backtrace::__rust_begin_short_backtrace(|| {
+            match process::task::exec_vcpu(vcpu_id as usize, host_tid as pid_t) {
+                Ok(()) => 0,
+                Err(e) => {
+                    eprintln!("failed to run a vCPU: {}", e.backtrace());
+                    ecall_errno!(e.errno())
+                }
+            }
+        })
+    })
+    .unwrap_or(ecall_errno!(EFAULT))
+}
+
 #[no_mangle]
 pub extern "C" fn occlum_ecall_kill(pid: i32, sig: i32) -> i32 {
     if HAS_INIT.load(Ordering::SeqCst) == false {
@@ -221,6 +294,26 @@ pub extern "C" fn occlum_ecall_broadcast_interrupts() -> i32 {
     .unwrap_or(ecall_errno!(EFAULT))
 }
 
+#[no_mangle]
+pub extern "C" fn occlum_ecall_run_timers(wakeup_fd: i32) -> i32 {
+    if HAS_INIT.load(Ordering::SeqCst) == false {
+        return ecall_errno!(EAGAIN);
+    }
+
+    panic::catch_unwind(|| {
+        backtrace::__rust_begin_short_backtrace(|| {
+            match time::timer_wheel::run_timers(wakeup_fd as FileDesc) {
+                Ok(()) => 0,
+                Err(e) => {
+                    eprintln!("failed to run timers: {}", e.backtrace());
+                    ecall_errno!(e.errno())
+                }
+            }
+        })
+    })
+    .unwrap_or(ecall_errno!(EFAULT))
+}
+
 fn parse_log_level(level_chars: *const c_char) -> Result<LevelFilter> {
     const DEFAULT_LEVEL: LevelFilter = LevelFilter::Off;
 
@@ -281,6 +374,23 @@ fn parse_arguments(
     Ok((path_buf, args, env_merged, host_stdio_fds))
 }
 
+// Parse the arguments of a process, whose pointers are all outside enclave
+fn parse_untrusted_arguments(
+    args: &NewProcessArgs,
+) -> Result<(PathBuf, Vec<CString>, Vec<CString>, HostStdioFds)> {
+    let path = clone_cstring_safely(args.path)?;
+    let host_stdio_fds = if args.host_stdio_fds.is_null() {
+        None
+    } else {
+        check_ptr(args.host_stdio_fds)?;
+        Some(unsafe { args.host_stdio_fds.read() })
+    };
+    let host_stdio_fds_ptr = host_stdio_fds
+        .as_ref()
+        .map_or(std::ptr::null(), |fds| fds as *const HostStdioFds);
+    parse_arguments(path.as_ptr(), args.argv, args.env, host_stdio_fds_ptr)
+}
+
 fn do_new_process(
     program_path: &PathBuf,
     argv: &Vec<CString>,
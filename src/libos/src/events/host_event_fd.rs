@@ -83,6 +83,19 @@ impl HostEventFd {
         ocall_eventfd_write_batch(host_fds, val);
     }
 
+    /// Poll a host eventfd and then clear its counter, as `poll` does.
+    ///
+    /// Precondition. The caller must ensure that the host fd is valid.
+    pub unsafe fn poll_raw(host_fd: FileDesc, timeout: Option<&Duration>) -> Result<()> {
+        match timeout {
+            None => ocall_eventfd_poll(host_fd, std::ptr::null_mut()),
+            Some(timeout) => {
+                let mut timeout_c = timespec_t::from(*timeout);
+                ocall_eventfd_poll(host_fd, &mut timeout_c)
+            }
+        }
+    }
+
     pub fn host_fd(&self) -> FileDesc {
         self.host_fd
     }
@@ -95,6 +108,44 @@ impl Drop for HostEventFd {
     }
 }
 
+/// Poll the host fds in one OCall, as poll does.
+///
+/// If `eventfd_idx` is given, the host fd at the index must be a host eventfd, whose
+/// counter is cleared once it is readable. The timeout is updated to reflect the
+/// remaining time. Return the number of the host fds that have events.
+pub fn poll_host_fds(
+    pollfds: &mut [libc::pollfd],
+    mut timeout: Option<&mut Duration>,
+    eventfd_idx: Option<usize>,
+) -> Result<usize> {
+    let num_events = try_libc!({
+        let mut remain_c = timeout.as_ref().map(|timeout| timespec_t::from(**timeout));
+        let remain_c_ptr = remain_c
+            .as_mut()
+            .map_or(std::ptr::null_mut(), |mut_ref| mut_ref);
+
+        let mut ret = 0;
+        let status = occlum_ocall_poll_with_eventfd(
+            &mut ret,
+            pollfds.as_mut_ptr(),
+            pollfds.len() as u32,
+            remain_c_ptr,
+            eventfd_idx.map_or(-1, |idx| idx as i32),
+        );
+        assert!(status == sgx_status_t::SGX_SUCCESS);
+
+        if let Some(timeout) = timeout.as_mut() {
+            let remain = remain_c.unwrap().as_duration();
+            assert!(remain <= **timeout + TIMERSLACK.to_duration());
+            **timeout = remain;
+        }
+
+        ret
+    }) as usize;
+    assert!(num_events <= pollfds.len());
+    Ok(num_events)
+}
+
 fn ocall_eventfd_poll(host_fd: FileDesc, timeout: *mut timespec_t) -> Result<()> {
     try_libc!({
         let mut ret = 0;
@@ -123,4 +174,11 @@ extern "C" {
         num_fds: usize,
         val: u64,
     ) -> sgx_status_t;
+    fn occlum_ocall_poll_with_eventfd(
+        ret: *mut i32,
+        fds: *mut libc::pollfd,
+        nfds: u32,
+        timeout: *mut timespec_t,
+        eventfd_idx: i32,
+    ) -> sgx_status_t;
 }
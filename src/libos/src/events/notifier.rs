@@ -1,6 +1,7 @@
 use std::any::Any;
 use std::fmt;
 use std::marker::PhantomData;
+use std::sync::atomic::{AtomicUsize, Ordering};
 use std::sync::Weak;
 
 use super::{Event, EventFilter, Observer};
@@ -9,6 +10,9 @@ use crate::prelude::*;
 /// An event notifier broadcasts interesting events to registered observers.
 pub struct Notifier<E: Event, F: EventFilter<E> = DummyEventFilter<E>> {
     subscribers: SgxMutex<VecDeque<Subscriber<E, F>>>,
+    // The number of subscribers, which allows broadcasting to no subscribers
+    // without taking the lock
+    nr_subscribers: AtomicUsize,
 }
 
 struct Subscriber<E: Event, F: EventFilter<E>> {
@@ -21,7 +25,11 @@ impl<E: Event, F: EventFilter<E>> Notifier<E, F> {
     /// Create an event notifier.
     pub fn new() -> Self {
         let subscribers = SgxMutex::new(VecDeque::new());
-        Self { subscribers }
+        let nr_subscribers = AtomicUsize::new(0);
+        Self {
+            subscribers,
+            nr_subscribers,
+        }
     }
 
     /// Register an observer with its interesting events and metadata.
@@ -37,16 +45,23 @@ impl<E: Event, F: EventFilter<E>> Notifier<E, F> {
             filter,
             metadata,
         });
+        self.nr_subscribers.store(subscribers.len(), Ordering::SeqCst);
     }
 
     /// Unregister an observer.
     pub fn unregister(&self, observer: &Weak<dyn Observer<E>>) {
         let mut subscribers = self.subscribers.lock().unwrap();
         subscribers.retain(|subscriber| !Weak::ptr_eq(&subscriber.observer, observer));
+        self.nr_subscribers.store(subscribers.len(), Ordering::SeqCst);
     }
 
     /// Broadcast an event to all registered observers.
     pub fn broadcast(&self, event: &E) {
+        // The quick path for a common case
+        if self.nr_subscribers.load(Ordering::SeqCst) == 0 {
+            return;
+        }
+
         let subscribers = self.subscribers.lock().unwrap();
         for subscriber in subscribers.iter() {
             if let Some(filter) = subscriber.filter.as_ref() {
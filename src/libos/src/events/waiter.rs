@@ -2,8 +2,9 @@ use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::Weak;
 use std::time::Duration;
 
-use super::host_event_fd::HostEventFd;
+use super::host_event_fd::{poll_host_fds, HostEventFd};
 use crate::prelude::*;
+use crate::process::task::{current_coroutine, CoroutineRef};
 
 /// A waiter enables a thread to sleep.
 pub struct Waiter {
@@ -71,11 +72,22 @@ impl Waiter {
         }
     }
 
-    /// Expose the internal host eventfd.
+    /// Put the current thread to sleep until being waken up by a waker or any of the
+    /// host fds has the events of interest, whose `revents` are set accordingly.
     ///
-    /// This host eventfd should be used by an external user carefully.
-    pub fn host_eventfd(&self) -> &HostEventFd {
-        self.inner.host_eventfd()
+    /// The method returns the number of the host fds that have events, which is zero
+    /// if the waiter has been waken up or the time is up (i.e., the `timeout` argument
+    /// becomes zero). Like the `wait_mut` method, the `timeout` argument is updated to
+    /// reflect the remaining timeout, and `Err(e)` is returned if interrupted.
+    ///
+    /// In the M:N mode, the host fds are polled by the vCPU of the current thread on
+    /// its behalf, so that the vCPU can run the other threads in the meantime.
+    pub fn wait_host_fds(
+        &self,
+        pollfds: &mut [libc::pollfd],
+        timeout: Option<&mut Duration>,
+    ) -> Result<usize> {
+        self.inner.wait_host_fds(pollfds, timeout)
     }
 }
 
@@ -99,20 +111,30 @@ impl Waker {
     pub fn batch_wake<'a, I: Iterator<Item = &'a Waker>>(iter: I) {
         Inner::batch_wake(iter);
     }
+
+    /// Return whether this waker is created by the waiter.
+    pub fn belongs_to(&self, waiter: &Waiter) -> bool {
+        Weak::as_ptr(&self.inner) == Arc::as_ptr(&waiter.inner)
+    }
 }
 
 struct Inner {
     is_woken: AtomicBool,
     host_eventfd: Arc<HostEventFd>,
+    // The coroutine of the waiting thread in the M:N mode, which sleeps without the
+    // host eventfd
+    coroutine: Option<CoroutineRef>,
 }
 
 impl Inner {
     pub fn new() -> Self {
         let is_woken = AtomicBool::new(false);
         let host_eventfd = current!().host_eventfd().clone();
+        let coroutine = current_coroutine();
         Self {
             is_woken,
             host_eventfd,
+            coroutine,
         }
     }
 
@@ -125,6 +147,10 @@ impl Inner {
     }
 
     pub fn wait(&self, timeout: Option<&Duration>) -> Result<()> {
+        if self.coroutine.is_some() {
+            let mut timeout = timeout.cloned();
+            return self.wait_mut(timeout.as_mut());
+        }
         while !self.is_woken() {
             self.host_eventfd.poll(timeout)?;
         }
@@ -146,7 +172,10 @@ impl Inner {
 
     fn do_wait_mut(&self, remain: &mut Option<Duration>) -> Result<()> {
         while !self.is_woken() {
-            self.host_eventfd.poll_mut(remain.as_mut())?;
+            match self.coroutine.as_ref() {
+                Some(coroutine) => coroutine.park(remain.as_mut())?,
+                None => self.host_eventfd.poll_mut(remain.as_mut())?,
+            }
         }
         Ok(())
     }
@@ -157,7 +186,12 @@ impl Inner {
             .compare_exchange(false, true, Ordering::SeqCst, Ordering::SeqCst)
             .is_ok()
         {
-            self.host_eventfd.write_u64(1);
+            if let Some(coroutine) = self.coroutine.as_ref() {
+                coroutine.unpark();
+            }
+            if self.coroutine.is_none() {
+                self.host_eventfd.write_u64(1);
+            }
         }
     }
 
@@ -170,6 +204,13 @@ impl Inner {
                     .compare_exchange(false, true, Ordering::SeqCst, Ordering::SeqCst)
                     .is_ok()
             })
+            .filter(|inner| match inner.coroutine.as_ref() {
+                Some(coroutine) => {
+                    coroutine.unpark();
+                    false
+                }
+                None => true,
+            })
             .map(|inner| inner.host_eventfd.host_fd())
             .collect::<Vec<FileDesc>>();
         unsafe {
@@ -177,7 +218,56 @@ impl Inner {
         }
     }
 
-    pub fn host_eventfd(&self) -> &HostEventFd {
-        &self.host_eventfd
+    pub fn wait_host_fds(
+        &self,
+        pollfds: &mut [libc::pollfd],
+        timeout: Option<&mut Duration>,
+    ) -> Result<usize> {
+        const ZERO: Duration = Duration::from_secs(0);
+        // Once woken, the host fds are polled without waiting
+        let mut zero_timeout = ZERO;
+        let mut timeout = if self.is_woken() {
+            Some(&mut zero_timeout)
+        } else {
+            timeout
+        };
+
+        loop {
+            let num_events = match self.coroutine.as_ref() {
+                Some(coroutine) => coroutine.poll_host_fds(pollfds, timeout.as_deref_mut())?,
+                None => self.poll_host_fds_and_eventfd(pollfds, timeout.as_deref_mut())?,
+            };
+            // The thread may be resumed spuriously, e.g., by a stale write to the host
+            // eventfd, which is shared by all the waiters of the thread
+            let is_timeout = timeout.as_ref().map_or(false, |timeout| **timeout == ZERO);
+            if num_events > 0 || is_timeout || self.is_woken() {
+                return Ok(num_events);
+            }
+        }
+    }
+
+    fn poll_host_fds_and_eventfd(
+        &self,
+        pollfds: &mut [libc::pollfd],
+        timeout: Option<&mut Duration>,
+    ) -> Result<usize> {
+        let mut all_pollfds = Vec::with_capacity(pollfds.len() + 1);
+        all_pollfds.extend_from_slice(pollfds);
+        all_pollfds.push(libc::pollfd {
+            fd: self.host_eventfd.host_fd() as i32,
+            events: libc::POLLIN,
+            revents: 0,
+        });
+        let num_events = poll_host_fds(&mut all_pollfds, timeout, Some(pollfds.len()))?;
+
+        let host_eventfd_pollfd = all_pollfds.pop().unwrap();
+        for (pollfd, polled) in pollfds.iter_mut().zip(all_pollfds.iter()) {
+            pollfd.revents = polled.revents;
+        }
+        if host_eventfd_pollfd.revents != 0 {
+            Ok(num_events - 1)
+        } else {
+            Ok(num_events)
+        }
     }
 }
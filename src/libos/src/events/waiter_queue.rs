@@ -43,6 +43,18 @@ impl WaiterQueue {
         wakers.push_back(waiter.waker());
     }
 
+    /// Dequeue a waiter without waking it up.
+    ///
+    /// This is useful when a waiter stops waiting on the queue for reasons
+    /// other than being waken up by the queue, e.g., a host event.
+    pub fn dequeue(&self, waiter: &Waiter) {
+        let mut wakers = self.wakers.lock().unwrap();
+        let old_len = wakers.len();
+        wakers.retain(|waker| !waker.belongs_to(waiter));
+        self.count
+            .fetch_sub(old_len - wakers.len(), Ordering::SeqCst);
+    }
+
     /// Dequeue a waiter and wake up its thread.
     pub fn dequeue_and_wake_one(&self) -> usize {
         self.dequeue_and_wake_nr(1)
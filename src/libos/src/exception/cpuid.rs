@@ -240,6 +240,12 @@ pub fn setup_cpuid_info() {
     let max_basic_leaf = CPUID.get_max_basic_leaf();
 }
 
+/// Whether the CPU supports RDPID, which reads the CPU ID set by the host kernel.
+pub fn is_rdpid_supported() -> bool {
+    const CPUID_7_ECX_RDPID: u32 = 1 << 22;
+    CPUID.get_max_basic_leaf() >= 7 && CPUID.get_cpuid_info(7, 0).ecx & CPUID_7_ECX_RDPID != 0
+}
+
 pub fn handle_cpuid_exception(user_context: &mut CpuContext) -> Result<isize> {
     debug!("handle CPUID exception");
     let leaf = user_context.rax as u32;
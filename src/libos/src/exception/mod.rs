@@ -7,6 +7,8 @@ use super::*;
 use crate::signal::{FaultSignal, SigSet};
 use crate::syscall::exception_interrupt_syscall_c_abi;
 use crate::syscall::{CpuContext, FpRegs, SyscallNum};
+
+pub use self::cpuid::is_rdpid_supported;
 use aligned::{Aligned, A16};
 use core::arch::x86_64::_fxsave;
 use sgx_types::*;
@@ -0,0 +1,241 @@
+use super::*;
+use crate::events::{Waiter, WaiterQueue};
+use crate::vm::{MMapFlags, VMPerms, PAGE_SIZE};
+use std::mem::size_of;
+use std::sync::atomic::{fence, AtomicBool, Ordering};
+
+const AIO_RING_MAGIC: u32 = 0xa10a10a1;
+const AIO_RING_COMPAT_FEATURES: u32 = 1;
+const AIO_RING_INCOMPAT_FEATURES: u32 = 0;
+
+/// The header of a completion ring, i.e., `struct aio_ring` of Linux, which is
+/// followed by the events
+#[repr(C)]
+struct AioRingHeader {
+    id: u32,
+    nr: u32,
+    // Written by the user when it fetches the events from the ring by itself
+    head: u32,
+    tail: u32,
+    magic: u32,
+    compat_features: u32,
+    incompat_features: u32,
+    header_length: u32,
+}
+
+/// A completion event, i.e., `struct io_event` of Linux
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+#[allow(non_camel_case_types)]
+pub struct io_event_t {
+    pub data: u64,
+    pub obj: u64,
+    pub res: i64,
+    pub res2: i64,
+}
+
+/// An AIO context, whose ID is the address of its completion ring
+pub struct AioContext {
+    ring_addr: usize,
+    ring_size: usize,
+    // The number of the events that the ring can hold, one of which is always empty
+    nr: u32,
+    // The number of events requested by io_setup
+    nr_events: u32,
+    state: SgxMutex<RingState>,
+    getters: WaiterQueue,
+    is_destroyed: AtomicBool,
+}
+
+struct RingState {
+    tail: u32,
+    // The number of the places reserved for the requests being submitted
+    reserved: u32,
+}
+
+impl AioContext {
+    pub fn new(nr_events: u32) -> Result<Self> {
+        let header_len = size_of::<AioRingHeader>();
+        let event_len = size_of::<io_event_t>();
+        let ring_size = align_up(header_len + (nr_events as usize + 1) * event_len, PAGE_SIZE);
+        let nr = ((ring_size - header_len) / event_len) as u32;
+        let ring_addr = crate::vm::do_mmap(
+            0,
+            ring_size,
+            VMPerms::READ | VMPerms::WRITE,
+            MMapFlags::MAP_PRIVATE | MMapFlags::MAP_ANONYMOUS,
+            0,
+            0,
+        )?;
+
+        let context = Self {
+            ring_addr,
+            ring_size,
+            nr,
+            nr_events,
+            state: SgxMutex::new(RingState {
+                tail: 0,
+                reserved: 0,
+            }),
+            getters: WaiterQueue::new(),
+            is_destroyed: AtomicBool::new(false),
+        };
+        *context.header()? = AioRingHeader {
+            id: 0,
+            nr,
+            head: 0,
+            tail: 0,
+            magic: AIO_RING_MAGIC,
+            compat_features: AIO_RING_COMPAT_FEATURES,
+            incompat_features: AIO_RING_INCOMPAT_FEATURES,
+            header_length: header_len as u32,
+        };
+        Ok(context)
+    }
+
+    pub fn id(&self) -> aio_context_t {
+        self.ring_addr as aio_context_t
+    }
+
+    pub fn nr_events(&self) -> u32 {
+        self.nr_events
+    }
+
+    pub fn destroy(&self) -> Result<()> {
+        self.is_destroyed.store(true, Ordering::Release);
+        self.getters.dequeue_and_wake_all();
+        crate::vm::do_munmap(self.ring_addr, self.ring_size)
+    }
+
+    /// Reserve the places in the ring for the completions of at most `nr_reqs`
+    /// requests, returning the number of the places reserved.
+    pub fn reserve(&self, nr_reqs: usize) -> Result<usize> {
+        let mut state = self.state.lock().unwrap();
+        let nr_used = self.nr_completions(self.head()?, state.tail) + state.reserved;
+        let nr_free = (self.nr - 1).saturating_sub(nr_used);
+        if nr_free == 0 {
+            return_errno!(EAGAIN, "the completion ring is full");
+        }
+        let nr_reserved = min(nr_reqs, nr_free as usize);
+        state.reserved += nr_reserved as u32;
+        Ok(nr_reserved)
+    }
+
+    pub fn unreserve(&self, nr_places: usize) {
+        let mut state = self.state.lock().unwrap();
+        state.reserved -= nr_places as u32;
+    }
+
+    /// Do the requests, each of which has reserved a place in the ring
+    pub fn submit(&self, reqs: Vec<AioRequest>) {
+        let results = do_batch(&reqs);
+        for (req, res) in reqs.iter().zip(results.into_iter()) {
+            self.complete(req, res);
+        }
+    }
+
+    fn complete(&self, req: &AioRequest, res: Result<usize>) {
+        let event = req.to_event(res);
+        {
+            let mut state = self.state.lock().unwrap();
+            state.reserved -= 1;
+            // The ring may be unmapped by the user
+            if let Err(e) = self.push_event(&mut state, &event) {
+                warn!("failed to put AIO completion into the ring: {:?}", e);
+            }
+        }
+        req.notify_resfd();
+        self.getters.dequeue_and_wake_all();
+    }
+
+    fn push_event(&self, state: &mut RingState, event: &io_event_t) -> Result<()> {
+        let tail = state.tail;
+        self.events()?[tail as usize] = *event;
+        state.tail = (tail + 1) % self.nr;
+        // The event must be visible before the tail for the user fetching events by itself
+        fence(Ordering::Release);
+        self.header()?.tail = state.tail;
+        Ok(())
+    }
+
+    /// Fetch at least `min_nr` events unless the timeout expires
+    pub fn get_events(
+        &self,
+        min_nr: usize,
+        events: &mut [io_event_t],
+        mut timeout: Option<&mut Duration>,
+    ) -> Result<usize> {
+        let waiter = Waiter::new();
+        let mut nr_fetched = 0;
+        loop {
+            nr_fetched += self.pop_events(&mut events[nr_fetched..])?;
+            if nr_fetched >= min_nr || nr_fetched == events.len() {
+                return Ok(nr_fetched);
+            }
+            if self.is_destroyed.load(Ordering::Acquire) {
+                return_errno!(EINVAL, "the AIO context is destroyed");
+            }
+            if let Some(timeout) = &timeout {
+                if **timeout == Duration::from_secs(0) {
+                    return Ok(nr_fetched);
+                }
+            }
+
+            self.getters.reset_and_enqueue(&waiter);
+            // Check again in case that the events come before the waiter is enqueued
+            let res = if self.has_events()? {
+                Ok(())
+            } else {
+                waiter.wait_mut(timeout.as_mut().map(|timeout| &mut **timeout))
+            };
+            self.getters.dequeue(&waiter);
+            match res {
+                Ok(()) => {}
+                Err(e) if e.errno() == Errno::ETIMEDOUT => return Ok(nr_fetched),
+                Err(e) if e.errno() == Errno::EINTR && nr_fetched > 0 => return Ok(nr_fetched),
+                Err(e) => return Err(e),
+            }
+        }
+    }
+
+    fn has_events(&self) -> Result<bool> {
+        let state = self.state.lock().unwrap();
+        Ok(self.nr_completions(self.head()?, state.tail) > 0)
+    }
+
+    fn pop_events(&self, events: &mut [io_event_t]) -> Result<usize> {
+        let state = self.state.lock().unwrap();
+        let header = self.header()?;
+        let ring = self.events()?;
+        let tail = state.tail;
+        let mut head = header.head % self.nr;
+        let mut nr_popped = 0;
+        while head != tail && nr_popped < events.len() {
+            events[nr_popped] = ring[head as usize];
+            head = (head + 1) % self.nr;
+            nr_popped += 1;
+        }
+        header.head = head;
+        Ok(nr_popped)
+    }
+
+    // The head is checked as it may be changed by the user
+    fn head(&self) -> Result<u32> {
+        Ok(self.header()?.head % self.nr)
+    }
+
+    fn nr_completions(&self, head: u32, tail: u32) -> u32 {
+        (tail + self.nr - head) % self.nr
+    }
+
+    fn header(&self) -> Result<&mut AioRingHeader> {
+        from_user::check_mut_array(self.ring_addr as *mut u8, self.ring_size)?;
+        Ok(unsafe { &mut *(self.ring_addr as *mut AioRingHeader) })
+    }
+
+    fn events(&self) -> Result<&mut [io_event_t]> {
+        from_user::check_mut_array(self.ring_addr as *mut u8, self.ring_size)?;
+        let events_ptr = (self.ring_addr + size_of::<AioRingHeader>()) as *mut io_event_t;
+        Ok(unsafe { std::slice::from_raw_parts_mut(events_ptr, self.nr as usize) })
+    }
+}
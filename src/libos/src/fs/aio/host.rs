@@ -0,0 +1,152 @@
+//! Batched AIO requests on the files of HostFS.
+//!
+//! The requests of a batch are marshaled into one untrusted arena, which holds an
+//! array of `occlum_aio_req`s and then the data, so that the host does them all in
+//! a single OCall. The results are checked before the data are copied back.
+
+use super::request::AioOp;
+use super::*;
+use crate::untrusted::UntrustedSliceAlloc;
+use std::mem::{size_of, size_of_val};
+use std::slice;
+
+const HOST_AIO_NONE: i32 = -1;
+const HOST_AIO_READ: i32 = 0;
+const HOST_AIO_WRITE: i32 = 1;
+const HOST_AIO_FSYNC: i32 = 2;
+const HOST_AIO_FDSYNC: i32 = 3;
+
+/// A request to the host, i.e., `struct occlum_aio_req` of the PAL
+#[repr(C)]
+#[derive(Clone, Copy)]
+#[allow(non_camel_case_types)]
+struct occlum_aio_req {
+    fd: i32,
+    opcode: i32,
+    // The sync done after writing
+    sync_op: i32,
+    buf: *mut u8,
+    len: usize,
+    offset: i64,
+    res: isize,
+}
+
+extern "C" {
+    fn occlum_ocall_aio_batch(reqs: *mut occlum_aio_req, nr_reqs: usize) -> sgx_status_t;
+}
+
+/// Do the requests, which must have host file descriptors, returning their results.
+pub fn do_batch(reqs: &[&AioRequest]) -> Vec<Result<usize>> {
+    let nr_bytes = reqs
+        .iter()
+        .filter(|req| matches!(req.op(), AioOp::Read | AioOp::Write))
+        .map(|req| req.total_len())
+        .sum();
+    let allocs = UntrustedSliceAlloc::new(reqs.len() * size_of::<occlum_aio_req>())
+        .and_then(|meta_alloc| Ok((meta_alloc, UntrustedSliceAlloc::new(nr_bytes)?)));
+    match allocs {
+        Ok((meta_alloc, bytes_alloc)) => do_batch_in(reqs, &meta_alloc, &bytes_alloc),
+        Err(e) => {
+            // The batch may be too large for the untrusted memory
+            warn!("failed to allocate the untrusted arena of AIO: {:?}", e);
+            reqs.iter().map(|req| req.execute()).collect()
+        }
+    }
+}
+
+fn do_batch_in(
+    reqs: &[&AioRequest],
+    meta_alloc: &UntrustedSliceAlloc,
+    bytes_alloc: &UntrustedSliceAlloc,
+) -> Vec<Result<usize>> {
+    // Marshal the requests
+    let mut host_reqs = Vec::with_capacity(reqs.len());
+    for req in reqs {
+        let (opcode, data_len) = match req.op() {
+            AioOp::Read => (HOST_AIO_READ, req.total_len()),
+            AioOp::Write => (HOST_AIO_WRITE, req.total_len()),
+            AioOp::Fsync => (HOST_AIO_FSYNC, 0),
+            AioOp::Fdsync => (HOST_AIO_FDSYNC, 0),
+        };
+        let buf = if data_len > 0 {
+            let mut u_data = bytes_alloc.new_slice_mut(data_len).unwrap();
+            if req.op() == AioOp::Write {
+                let mut pos = 0;
+                for &(addr, len) in req.iovs() {
+                    let buf = unsafe { slice::from_raw_parts(addr as *const u8, len) };
+                    u_data[pos..pos + len].copy_from_slice(buf);
+                    pos += len;
+                }
+            }
+            u_data.as_mut_ptr()
+        } else {
+            std::ptr::null_mut()
+        };
+        let sync_op = match req.sync_after_write() {
+            Some(AioOp::Fsync) => HOST_AIO_FSYNC,
+            Some(AioOp::Fdsync) => HOST_AIO_FDSYNC,
+            _ => HOST_AIO_NONE,
+        };
+        host_reqs.push(occlum_aio_req {
+            fd: req.host_fd().unwrap(),
+            opcode,
+            sync_op,
+            buf,
+            len: data_len,
+            offset: req.offset().unwrap_or(0) as i64,
+            res: 0,
+        });
+    }
+    let mut u_reqs = meta_alloc
+        .new_slice_mut(reqs.len() * size_of::<occlum_aio_req>())
+        .unwrap();
+    u_reqs.read_from_slice(as_bytes(&host_reqs)).unwrap();
+
+    // Do OCall
+    unsafe {
+        let status = occlum_ocall_aio_batch(u_reqs.as_mut_ptr() as *mut occlum_aio_req, reqs.len());
+        assert!(status == sgx_status_t::SGX_SUCCESS);
+    }
+
+    // Copy the results back after checking the values returned from outside the enclave
+    let bufs: Vec<(*mut u8, usize)> = host_reqs.iter().map(|r| (r.buf, r.len)).collect();
+    u_reqs.write_to_slice(as_bytes_mut(&mut host_reqs)).unwrap();
+    reqs.iter()
+        .zip(host_reqs.iter())
+        .zip(bufs.into_iter())
+        .map(|((req, host_req), (data_ptr, data_len))| {
+            let res = host_req.res;
+            if res < 0 {
+                let errno = res
+                    .checked_neg()
+                    .filter(|&errno| errno <= Errno::EHWPOISON as isize)
+                    .map_or(Errno::EIO, |errno| Errno::from(errno as u32));
+                return Err(errno!(errno, "host AIO failed"));
+            }
+            let len = res as usize;
+            assert!(len <= data_len);
+            if req.op() == AioOp::Read && len > 0 {
+                let data = unsafe { slice::from_raw_parts(data_ptr as *const u8, len) };
+                let mut pos = 0;
+                for &(addr, buf_len) in req.iovs() {
+                    if pos == len {
+                        break;
+                    }
+                    let copy_len = min(buf_len, len - pos);
+                    let buf = unsafe { slice::from_raw_parts_mut(addr as *mut u8, copy_len) };
+                    buf.copy_from_slice(&data[pos..pos + copy_len]);
+                    pos += copy_len;
+                }
+            }
+            Ok(len)
+        })
+        .collect()
+}
+
+fn as_bytes<T: Copy>(items: &[T]) -> &[u8] {
+    unsafe { slice::from_raw_parts(items.as_ptr() as *const u8, size_of_val(items)) }
+}
+
+fn as_bytes_mut<T: Copy>(items: &mut [T]) -> &mut [u8] {
+    unsafe { slice::from_raw_parts_mut(items.as_mut_ptr() as *mut u8, size_of_val(items)) }
+}
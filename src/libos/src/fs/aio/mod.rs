@@ -0,0 +1,188 @@
+//! Linux native asynchronous I/O, i.e., io_setup, io_submit, io_getevents, io_cancel
+//! and io_destroy.
+//!
+//! An AIO context has a completion ring in the user space, whose layout is the same
+//! as that of Linux, so that libaio can check for completions without syscalls.
+//!
+//! The LibOS has no kernel threads to serve the requests in the background. So the
+//! requests of a batch are done as they are submitted, just like Linux does for the
+//! buffered I/O. The reads and writes of the files on HostFS are gathered into one
+//! OCall; the other requests, e.g., those of SEFS files or sockets, are done by the
+//! files in the enclave. Then the completion events are put into the ring.
+
+use super::*;
+use crate::util::mem_util::from_user;
+use std::time::Duration;
+
+pub use self::context::io_event_t;
+pub use self::request::{iocb_t, AioOp, AioRequest};
+
+use self::context::AioContext;
+
+mod context;
+mod host;
+mod request;
+
+#[allow(non_camel_case_types)]
+pub type aio_context_t = u64;
+
+// The max number of the events of all the AIO contexts of a process, i.e.,
+// /proc/sys/fs/aio-max-nr of Linux
+const AIO_MAX_NR: u32 = 65536;
+
+/// The AIO contexts of a process
+pub struct AioContexts {
+    contexts: HashMap<aio_context_t, Arc<AioContext>>,
+    nr_events: u32,
+}
+
+impl AioContexts {
+    pub fn new() -> Self {
+        Self {
+            contexts: HashMap::new(),
+            nr_events: 0,
+        }
+    }
+
+    /// Delete all the AIO contexts, as the process exits. The rings are not unmapped,
+    /// as they are freed with the memory of the process.
+    pub fn clear(&mut self) {
+        self.contexts.clear();
+        self.nr_events = 0;
+    }
+}
+
+fn find_context(id: aio_context_t) -> Result<Arc<AioContext>> {
+    let current = current!();
+    let contexts = current.process().aio_contexts().lock().unwrap();
+    contexts
+        .contexts
+        .get(&id)
+        .cloned()
+        .ok_or_else(|| errno!(EINVAL, "the AIO context does not exist"))
+}
+
+pub fn do_io_setup(nr_events: u32) -> Result<aio_context_t> {
+    debug!("io_setup: nr_events: {}", nr_events);
+    if nr_events == 0 {
+        return_errno!(EINVAL, "nr_events must be positive");
+    }
+
+    let current = current!();
+    let mut contexts = current.process().aio_contexts().lock().unwrap();
+    let total = contexts
+        .nr_events
+        .checked_add(nr_events)
+        .filter(|&total| total <= AIO_MAX_NR)
+        .ok_or_else(|| errno!(EAGAIN, "too many AIO events"))?;
+    let context = AioContext::new(nr_events)?;
+    let id = context.id();
+    contexts.contexts.insert(id, Arc::new(context));
+    contexts.nr_events = total;
+    Ok(id)
+}
+
+pub fn do_io_destroy(id: aio_context_t) -> Result<()> {
+    debug!("io_destroy: ctx: {:#x}", id);
+    let context = {
+        let current = current!();
+        let mut contexts = current.process().aio_contexts().lock().unwrap();
+        let context = contexts
+            .contexts
+            .remove(&id)
+            .ok_or_else(|| errno!(EINVAL, "the AIO context does not exist"))?;
+        contexts.nr_events -= context.nr_events();
+        context
+    };
+    context.destroy()
+}
+
+/// Submit the I/O control blocks, returning the number of them submitted. Once a
+/// block is invalid, the blocks before it are submitted, and the error is returned
+/// only if no block is submitted.
+pub fn do_io_submit(id: aio_context_t, iocbs: &[*const iocb_t]) -> Result<usize> {
+    debug!("io_submit: ctx: {:#x}, nr: {}", id, iocbs.len());
+    let context = find_context(id)?;
+    if iocbs.is_empty() {
+        return Ok(0);
+    }
+
+    // Every request must have a place in the ring for its completion
+    let nr_reserved = context.reserve(iocbs.len())?;
+    let mut reqs = Vec::with_capacity(nr_reserved);
+    let mut error = None;
+    for &iocb_ptr in &iocbs[..nr_reserved] {
+        match AioRequest::from_user(iocb_ptr) {
+            Ok(req) => reqs.push(req),
+            Err(e) => {
+                error = Some(e);
+                break;
+            }
+        }
+    }
+    context.unreserve(nr_reserved - reqs.len());
+
+    let nr_submitted = reqs.len();
+    context.submit(reqs);
+    match error {
+        Some(e) if nr_submitted == 0 => Err(e),
+        _ => Ok(nr_submitted),
+    }
+}
+
+pub fn do_io_getevents(
+    id: aio_context_t,
+    min_nr: usize,
+    events: &mut [io_event_t],
+    timeout: Option<&mut Duration>,
+) -> Result<usize> {
+    debug!(
+        "io_getevents: ctx: {:#x}, min_nr: {}, nr: {}, timeout: {:?}",
+        id,
+        min_nr,
+        events.len(),
+        timeout
+    );
+    if min_nr > events.len() {
+        return_errno!(EINVAL, "min_nr is greater than nr");
+    }
+    let context = find_context(id)?;
+    context.get_events(min_nr, events, timeout)
+}
+
+/// Do a batch of requests, returning their results in order. The requests on the
+/// files of HostFS are done by the host in one OCall.
+pub fn do_batch(reqs: &[AioRequest]) -> Vec<Result<usize>> {
+    let is_host_req: Vec<bool> = reqs.iter().map(|req| req.host_fd().is_some()).collect();
+    let host_reqs: Vec<&AioRequest> = reqs
+        .iter()
+        .zip(is_host_req.iter())
+        .filter(|&(_, &is_host_req)| is_host_req)
+        .map(|(req, _)| req)
+        .collect();
+    let mut host_results = if host_reqs.is_empty() {
+        Vec::new()
+    } else {
+        host::do_batch(&host_reqs)
+    }
+    .into_iter();
+    reqs.iter()
+        .zip(is_host_req.into_iter())
+        .map(|(req, is_host_req)| {
+            if is_host_req {
+                host_results.next().unwrap()
+            } else {
+                req.execute()
+            }
+        })
+        .collect()
+}
+
+/// As the requests are done when they are submitted, there is never an in-flight
+/// request to cancel.
+pub fn do_io_cancel(id: aio_context_t, iocb: &iocb_t) -> Result<()> {
+    debug!("io_cancel: ctx: {:#x}, iocb: {:?}", id, iocb);
+    let _context = find_context(id)?;
+    iocb.validate_key()?;
+    return_errno!(EINVAL, "the request is not in flight")
+}
@@ -0,0 +1,303 @@
+use super::*;
+use crate::fs::hostfs::HNode;
+
+const IOCB_CMD_PREAD: u16 = 0;
+const IOCB_CMD_PWRITE: u16 = 1;
+const IOCB_CMD_FSYNC: u16 = 2;
+const IOCB_CMD_FDSYNC: u16 = 3;
+const IOCB_CMD_POLL: u16 = 5;
+const IOCB_CMD_PREADV: u16 = 7;
+const IOCB_CMD_PWRITEV: u16 = 8;
+
+const IOCB_FLAG_RESFD: u32 = 1 << 0;
+const IOCB_FLAG_IOPRIO: u32 = 1 << 1;
+
+const RWF_HIPRI: i32 = 0x1;
+const RWF_DSYNC: i32 = 0x2;
+const RWF_SYNC: i32 = 0x4;
+
+/// An I/O control block, i.e., `struct iocb` of Linux
+#[repr(C)]
+#[derive(Clone, Copy, Debug)]
+#[allow(non_camel_case_types)]
+pub struct iocb_t {
+    aio_data: u64,
+    aio_key: u32,
+    aio_rw_flags: i32,
+    aio_lio_opcode: u16,
+    aio_reqprio: i16,
+    aio_fildes: u32,
+    aio_buf: u64,
+    aio_nbytes: u64,
+    aio_offset: i64,
+    aio_reserved2: u64,
+    aio_flags: u32,
+    aio_resfd: u32,
+}
+
+impl iocb_t {
+    pub fn validate_key(&self) -> Result<()> {
+        if self.aio_key != 0 {
+            return_errno!(EINVAL, "aio_key must be zero");
+        }
+        Ok(())
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum AioOp {
+    Read,
+    Write,
+    Fsync,
+    Fdsync,
+}
+
+/// A request parsed from an I/O control block, whose buffers are checked
+pub struct AioRequest {
+    iocb_addr: u64,
+    user_data: u64,
+    op: AioOp,
+    file: FileRef,
+    // The (address, length) pairs of the user buffers
+    iovs: Vec<(usize, usize)>,
+    // The offset is ignored for the files that cannot seek, e.g., sockets. If there
+    // is no offset, the current position of the file is used.
+    offset: Option<usize>,
+    // Whether to sync the data, or all the metadata too, after writing
+    sync_after_write: Option<AioOp>,
+    resfd: Option<FileRef>,
+}
+
+impl AioRequest {
+    pub fn from_user(iocb_ptr: *const iocb_t) -> Result<Self> {
+        from_user::check_ptr(iocb_ptr)?;
+        let iocb = unsafe { *iocb_ptr };
+        iocb.validate_key()?;
+        if iocb.aio_reserved2 != 0 {
+            return_errno!(EINVAL, "the reserved field must be zero");
+        }
+        if iocb.aio_flags & !(IOCB_FLAG_RESFD | IOCB_FLAG_IOPRIO) != 0 {
+            return_errno!(EINVAL, "invalid flags");
+        }
+        if iocb.aio_nbytes > isize::MAX as u64 || iocb.aio_offset < 0 {
+            return_errno!(EINVAL, "invalid size or offset");
+        }
+
+        let current = current!();
+        let file = current.file(iocb.aio_fildes as FileDesc)?;
+        let resfd = if iocb.aio_flags & IOCB_FLAG_RESFD != 0 {
+            let resfd = current.file(iocb.aio_resfd as FileDesc)?;
+            resfd
+                .as_event()
+                .map_err(|_| errno!(EINVAL, "resfd is not an eventfd"))?;
+            Some(resfd)
+        } else {
+            None
+        };
+
+        let op = match iocb.aio_lio_opcode {
+            IOCB_CMD_PREAD | IOCB_CMD_PREADV => AioOp::Read,
+            IOCB_CMD_PWRITE | IOCB_CMD_PWRITEV => AioOp::Write,
+            IOCB_CMD_FSYNC => AioOp::Fsync,
+            IOCB_CMD_FDSYNC => AioOp::Fdsync,
+            IOCB_CMD_POLL => return_errno!(EINVAL, "IOCB_CMD_POLL is not supported"),
+            _ => return_errno!(EINVAL, "invalid opcode"),
+        };
+        // The files without access modes are checked when the requests are done
+        if let Ok(access_mode) = file.access_mode() {
+            match op {
+                AioOp::Read if !access_mode.readable() => {
+                    return_errno!(EBADF, "the file is not readable")
+                }
+                AioOp::Write if !access_mode.writable() => {
+                    return_errno!(EBADF, "the file is not writable")
+                }
+                _ => {}
+            }
+        }
+
+        let iovs = match iocb.aio_lio_opcode {
+            IOCB_CMD_PREAD | IOCB_CMD_PWRITE => {
+                vec![(iocb.aio_buf as usize, iocb.aio_nbytes as usize)]
+            }
+            IOCB_CMD_PREADV | IOCB_CMD_PWRITEV => {
+                let iovs_ptr = iocb.aio_buf as *const libc::iovec;
+                let count = iocb.aio_nbytes as usize;
+                from_user::check_array(iovs_ptr, count)?;
+                let iovs = unsafe { std::slice::from_raw_parts(iovs_ptr, count) };
+                iovs.iter()
+                    .map(|iov| (iov.iov_base as usize, iov.iov_len))
+                    .collect()
+            }
+            _ => Vec::new(),
+        };
+        let mut total_len: usize = 0;
+        for &(addr, len) in &iovs {
+            match op {
+                AioOp::Read => from_user::check_mut_array(addr as *mut u8, len)?,
+                _ => from_user::check_array(addr as *const u8, len)?,
+            }
+            total_len = total_len
+                .checked_add(len)
+                .filter(|&total_len| total_len <= isize::MAX as usize)
+                .ok_or_else(|| errno!(EINVAL, "the buffers are too large"))?;
+        }
+
+        let rw_flags = iocb.aio_rw_flags;
+        if rw_flags & !(RWF_HIPRI | RWF_DSYNC | RWF_SYNC) != 0 {
+            return_errno!(EOPNOTSUPP, "the flags are not supported");
+        }
+        let sync_after_write = if op != AioOp::Write {
+            None
+        } else if rw_flags & RWF_SYNC != 0 {
+            Some(AioOp::Fsync)
+        } else if rw_flags & RWF_DSYNC != 0 {
+            Some(AioOp::Fdsync)
+        } else {
+            None
+        };
+
+        Ok(Self {
+            iocb_addr: iocb_ptr as u64,
+            user_data: iocb.aio_data,
+            op,
+            file,
+            iovs,
+            offset: Some(iocb.aio_offset as usize),
+            sync_after_write,
+            resfd,
+        })
+    }
+
+    /// Create a request whose buffers are checked, e.g., that of io_uring
+    pub fn new(
+        op: AioOp,
+        file: FileRef,
+        iovs: Vec<(usize, usize)>,
+        offset: Option<usize>,
+        user_data: u64,
+    ) -> Self {
+        Self {
+            iocb_addr: 0,
+            user_data,
+            op,
+            file,
+            iovs,
+            offset,
+            sync_after_write: None,
+            resfd: None,
+        }
+    }
+
+    pub fn user_data(&self) -> u64 {
+        self.user_data
+    }
+
+    pub fn op(&self) -> AioOp {
+        self.op
+    }
+
+    pub fn iovs(&self) -> &[(usize, usize)] {
+        &self.iovs
+    }
+
+    pub fn offset(&self) -> Option<usize> {
+        self.offset
+    }
+
+    pub fn sync_after_write(&self) -> Option<AioOp> {
+        self.sync_after_write
+    }
+
+    pub fn total_len(&self) -> usize {
+        self.iovs.iter().map(|&(_, len)| len).sum()
+    }
+
+    /// Get the host file descriptor if the request can be done by the host directly,
+    /// i.e., the request is on a file of HostFS that is not opened for appending, and
+    /// it does not read or write at the current position of the file.
+    pub fn host_fd(&self) -> Option<i32> {
+        if self.offset.is_none() && matches!(self.op, AioOp::Read | AioOp::Write) {
+            return None;
+        }
+        let inode_file = self.file.as_inode_file().ok()?;
+        if inode_file.status_flags().ok()?.always_append() {
+            return None;
+        }
+        inode_file
+            .inode()
+            .as_any_ref()
+            .downcast_ref::<HNode>()?
+            .host_fd()
+    }
+
+    /// Do the request in the enclave
+    pub fn execute(&self) -> Result<usize> {
+        let offset = self.offset.filter(|_| self.file.as_inode_file().is_ok());
+        let len = match self.op {
+            AioOp::Read => {
+                let mut bufs: Vec<&mut [u8]> = self
+                    .iovs
+                    .iter()
+                    .map(|&(addr, len)| unsafe {
+                        std::slice::from_raw_parts_mut(addr as *mut u8, len)
+                    })
+                    .collect();
+                match offset {
+                    Some(offset) => self.file.preadv(&mut bufs, offset)?,
+                    None => self.file.readv(&mut bufs)?,
+                }
+            }
+            AioOp::Write => {
+                let bufs: Vec<&[u8]> = self
+                    .iovs
+                    .iter()
+                    .map(|&(addr, len)| unsafe {
+                        std::slice::from_raw_parts(addr as *const u8, len)
+                    })
+                    .collect();
+                let len = match offset {
+                    Some(offset) => self.file.pwritev(&bufs, offset)?,
+                    None => self.file.writev(&bufs)?,
+                };
+                match self.sync_after_write {
+                    Some(AioOp::Fsync) => self.file.sync_all()?,
+                    Some(AioOp::Fdsync) => self.file.sync_data()?,
+                    _ => {}
+                }
+                len
+            }
+            AioOp::Fsync => {
+                self.file.sync_all()?;
+                0
+            }
+            AioOp::Fdsync => {
+                self.file.sync_data()?;
+                0
+            }
+        };
+        Ok(len)
+    }
+
+    pub fn to_event(&self, res: Result<usize>) -> io_event_t {
+        let res = match res {
+            Ok(len) => len as i64,
+            Err(e) => -(e.errno() as i64),
+        };
+        io_event_t {
+            data: self.user_data,
+            obj: self.iocb_addr,
+            res,
+            res2: 0,
+        }
+    }
+
+    /// Notify the completion by the eventfd, if any
+    pub fn notify_resfd(&self) {
+        if let Some(resfd) = &self.resfd {
+            if let Err(e) = resfd.write(&1u64.to_ne_bytes()) {
+                warn!("failed to notify AIO completion by eventfd: {:?}", e);
+            }
+        }
+    }
+}
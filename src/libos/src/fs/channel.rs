@@ -1,14 +1,20 @@
-use std::sync::atomic::{AtomicBool, Ordering};
-use std::sync::Weak;
-
-use ringbuf::{Consumer as RbConsumer, Producer as RbProducer, RingBuffer};
+use std::sync::atomic::{self, AtomicBool, Ordering};
 
 use super::{IoEvents, IoNotifier};
-use crate::events::{Event, EventFilter, Notifier, Observer, Waiter, WaiterQueueObserver};
+use crate::events::{Event, EventFilter, Notifier, Observer, Waiter, WaiterQueue};
 use crate::prelude::*;
+use crate::util::ring_buf::RingBuf;
 
 /// A unidirectional communication channel, intended to implement IPC, e.g., pipe,
 /// unix domain sockets, etc.
+///
+/// The channel is backed by a lock-free MPMC ring buffer, so the endpoints can
+/// be shared by multiple threads (e.g., a pipe inherited by many writers)
+/// without any external serialization.
+///
+/// An endpoint only wakes up its peer when the peer is actually waiting,
+/// i.e., when there are waiters blocked on the peer or observers registered
+/// to the notifier of the peer.
 pub struct Channel<I> {
     producer: Producer<I>,
     consumer: Consumer<I>,
@@ -18,31 +24,9 @@ impl<I> Channel<I> {
     /// Create a new channel.
     pub fn new(capacity: usize) -> Result<Self> {
         let state = Arc::new(State::new());
-
-        let rb = RingBuffer::new(capacity);
-        let (rb_producer, rb_consumer) = rb.split();
-        let mut producer = Producer::new(rb_producer, state.clone());
-        let mut consumer = Consumer::new(rb_consumer, state.clone());
-
-        // The events on an endpoint is not triggered by itself, but its peer.
-        // For example, a producer becomes writable (IoEvents::OUT) only if
-        // its peer consumer gets read. So an endpoint needs to hold a
-        // reference to the notifier of its peer.
-        producer.peer_notifier = Arc::downgrade(&consumer.notifier);
-        consumer.peer_notifier = Arc::downgrade(&producer.notifier);
-        // An endpoint registers itself as an observer to its own notifier so
-        // that it can be waken up by its peer.
-        producer.notifier.register(
-            Arc::downgrade(&producer.observer) as Weak<dyn Observer<_>>,
-            None,
-            None,
-        );
-        consumer.notifier.register(
-            Arc::downgrade(&consumer.observer) as Weak<dyn Observer<_>>,
-            None,
-            None,
-        );
-
+        let rb = Arc::new(RingBuf::new(capacity));
+        let producer = Producer::new(rb.clone(), state.clone());
+        let consumer = Consumer::new(rb, state);
         Ok(Self { producer, consumer })
     }
 
@@ -120,31 +104,22 @@ impl<I: Copy> Channel<I> {
 // and Consumer<I>.
 macro_rules! impl_end_point_type {
     ($(#[$attr:meta])* $vis:vis struct $end_point:ident<$i:ident> {
-        inner: $inner:ident<$_:ident>,
+        events: $events:ident,
+        peer_events: $peer_events:ident,
     }) => (
         /// An endpoint is either the producer or consumer of a channel.
         $(#[$attr])* $vis struct $end_point<$i> {
-            inner: SgxMutex<$inner<$i>>,
+            rb: Arc<RingBuf<$i>>,
             state: Arc<State>,
-            observer: Arc<WaiterQueueObserver<IoEvents>>,
-            notifier: Arc<IoNotifier>,
-            peer_notifier: Weak<IoNotifier>,
             is_nonblocking: AtomicBool,
         }
 
         impl<$i> $end_point<$i> {
-            fn new(inner: $inner<$i>, state: Arc<State>) -> Self {
-                let inner = SgxMutex::new(inner);
-                let observer = WaiterQueueObserver::new();
-                let notifier = Arc::new(IoNotifier::new());
-                let peer_notifier = Default::default();
+            fn new(rb: Arc<RingBuf<$i>>, state: Arc<State>) -> Self {
                 let is_nonblocking = AtomicBool::new(false);
                 Self {
-                    inner,
+                    rb,
                     state,
-                    observer,
-                    notifier,
-                    peer_notifier,
                     is_nonblocking,
                 }
             }
@@ -154,7 +129,7 @@ macro_rules! impl_end_point_type {
             /// An interesting observer can receive I/O events of the endpoint by
             /// registering itself to this notifier.
             pub fn notifier(&self) -> &IoNotifier {
-                &self.notifier
+                &self.state.$events.notifier
             }
 
             /// Returns whether the endpoint is non-blocking.
@@ -170,14 +145,25 @@ macro_rules! impl_end_point_type {
 
                 if nonblocking {
                     // Wake all threads that are blocked on pushing/popping this endpoint
-                    self.observer.waiter_queue().dequeue_and_wake_all();
+                    self.waiter_queue().dequeue_and_wake_all();
                 }
             }
 
+            fn waiter_queue(&self) -> &WaiterQueue {
+                &self.state.$events.waiter_queue
+            }
+
             fn trigger_peer_events(&self, events: &IoEvents) {
-                if let Some(peer_notifier) = self.peer_notifier.upgrade() {
-                    peer_notifier.broadcast(events);
-                }
+                // The update to the ring buffer must be visible before we check
+                // whether the peer is waiting. This pairs with the full barrier
+                // in WaiterQueue::reset_and_enqueue, which is issued by the peer
+                // before it checks the ring buffer for the last time.
+                atomic::fence(Ordering::SeqCst);
+
+                let peer_events = &self.state.$peer_events;
+                // Both are no-ops if nobody is waiting for the peer
+                peer_events.waiter_queue.dequeue_and_wake_all();
+                peer_events.notifier.broadcast(events);
             }
         }
     )
@@ -212,7 +198,8 @@ macro_rules! waiter_loop {
 impl_end_point_type! {
     /// Producer is the writable endpoint of a channel.
     pub struct Producer<I> {
-        inner: RbProducer<I>,
+        events: producer_events,
+        peer_events: consumer_events,
     }
 }
 
@@ -220,14 +207,12 @@ impl<I> Producer<I> {
     pub fn push(&self, mut item: I) -> Result<()> {
         waiter_loop!(
             {
-                let mut rb_producer = self.inner.lock().unwrap();
                 if self.is_self_shutdown() || self.is_peer_shutdown() {
                     return_errno!(EPIPE, "one or both endpoints have been shutdown");
                 }
 
-                item = match rb_producer.push(item) {
+                item = match self.rb.push(item) {
                     Ok(()) => {
-                        drop(rb_producer);
                         self.trigger_peer_events(&IoEvents::IN);
                         return Ok(());
                     }
@@ -238,17 +223,14 @@ impl<I> Producer<I> {
                     return_errno!(EAGAIN, "try again later");
                 }
             },
-            self.observer.waiter_queue()
+            self.waiter_queue()
         );
     }
 
     pub fn poll(&self) -> IoEvents {
         let mut events = IoEvents::empty();
 
-        let writable = {
-            let mut rb_producer = self.inner.lock().unwrap();
-            !rb_producer.is_full() || self.is_self_shutdown()
-        };
+        let writable = !self.rb.is_full() || self.is_self_shutdown();
         if writable {
             events |= IoEvents::OUT;
         }
@@ -261,19 +243,14 @@ impl<I> Producer<I> {
     }
 
     pub fn shutdown(&self) {
-        {
-            // It is important to hold this lock while updating the state
-            let inner = self.inner.lock().unwrap();
-            if self.state.is_producer_shutdown() {
-                return;
-            }
-            self.state.set_producer_shutdown();
+        if !self.state.set_producer_shutdown() {
+            return;
         }
 
         // The shutdown of the producer triggers hangup events on the consumer
         self.trigger_peer_events(&IoEvents::HUP);
         // Wake all threads that are blocked on pushing to this producer
-        self.observer.waiter_queue().dequeue_and_wake_all();
+        self.waiter_queue().dequeue_and_wake_all();
     }
 
     pub fn is_self_shutdown(&self) -> bool {
@@ -291,40 +268,39 @@ impl<I: Copy> Producer<I> {
     }
 
     pub fn push_slices(&self, item_slices: &[&[I]]) -> Result<usize> {
+        self.do_push_slices(item_slices, false)
+    }
+
+    /// Push without blocking, even if the endpoint is blocking
+    pub fn try_push_slices(&self, item_slices: &[&[I]]) -> Result<usize> {
+        self.do_push_slices(item_slices, true)
+    }
+
+    fn do_push_slices(&self, item_slices: &[&[I]], is_nonblocking: bool) -> Result<usize> {
         let len: usize = item_slices.iter().map(|slice| slice.len()).sum();
         if len == 0 {
             return Ok(0);
         }
+        // A small push is done as a whole or not at all, while a large one can be partial
+        let min_len = if len <= ATOMIC_PUSH_LEN { len } else { 1 };
 
         waiter_loop!(
             {
-                let mut rb_producer = self.inner.lock().unwrap();
                 if self.is_self_shutdown() || self.is_peer_shutdown() {
                     return_errno!(EPIPE, "one or both endpoints have been shutdown");
                 }
 
-                let mut total_count = 0;
-                for items in item_slices {
-                    let count = rb_producer.push_slice(items);
-                    total_count += count;
-                    if count < items.len() {
-                        break;
-                    } else {
-                        continue;
-                    }
-                }
-
+                let total_count = self.rb.push_slices(item_slices, min_len);
                 if total_count > 0 {
-                    drop(rb_producer);
                     self.trigger_peer_events(&IoEvents::IN);
                     return Ok(total_count);
                 }
 
-                if self.is_nonblocking() {
+                if is_nonblocking || self.is_nonblocking() {
                     return_errno!(EAGAIN, "try again later");
                 }
             },
-            self.observer.waiter_queue()
+            self.waiter_queue()
         );
     }
 }
@@ -338,7 +314,8 @@ impl<I> Drop for Producer<I> {
 impl_end_point_type! {
     /// Consumer is the readable endpoint of a channel.
     pub struct Consumer<I> {
-        inner: RbConsumer<I>,
+        events: consumer_events,
+        peer_events: producer_events,
     }
 }
 
@@ -346,13 +323,11 @@ impl<I> Consumer<I> {
     pub fn pop(&self) -> Result<Option<I>> {
         waiter_loop!(
             {
-                let mut rb_consumer = self.inner.lock().unwrap();
                 if self.is_self_shutdown() {
                     return_errno!(EPIPE, "this endpoint has been shutdown");
                 }
 
-                if let Some(item) = rb_consumer.pop() {
-                    drop(rb_consumer);
+                if let Some(item) = self.rb.pop() {
                     self.trigger_peer_events(&IoEvents::OUT);
                     return Ok(Some(item));
                 }
@@ -364,17 +339,14 @@ impl<I> Consumer<I> {
                     return_errno!(EAGAIN, "try again later");
                 }
             },
-            self.observer.waiter_queue()
+            self.waiter_queue()
         );
     }
 
     pub fn poll(&self) -> IoEvents {
         let mut events = IoEvents::empty();
 
-        let readable = {
-            let mut rb_consumer = self.inner.lock().unwrap();
-            !rb_consumer.is_empty() || self.is_self_shutdown()
-        };
+        let readable = !self.rb.is_empty() || self.is_self_shutdown();
         if readable {
             events |= IoEvents::IN;
         }
@@ -387,19 +359,14 @@ impl<I> Consumer<I> {
     }
 
     pub fn shutdown(&self) {
-        {
-            // It is important to hold this lock while updating the state
-            let inner = self.inner.lock().unwrap();
-            if self.state.is_consumer_shutdown() {
-                return;
-            }
-            self.state.set_consumer_shutdown();
+        if !self.state.set_consumer_shutdown() {
+            return;
         }
 
         // The consumer being shutdown triggers error on the producer
         self.trigger_peer_events(&IoEvents::ERR);
         // Wake all threads that are blocked on popping from this consumer
-        self.observer.waiter_queue().dequeue_and_wake_all();
+        self.waiter_queue().dequeue_and_wake_all();
     }
 
     pub fn is_self_shutdown(&self) -> bool {
@@ -414,19 +381,17 @@ impl<I> Consumer<I> {
         if self.is_self_shutdown() {
             0
         } else {
-            self.inner.lock().unwrap().len()
+            self.rb.len()
         }
     }
 
     pub fn capacity(&self) -> usize {
-        let rb_consumer = self.inner.lock().unwrap();
-        rb_consumer.capacity()
+        self.rb.capacity()
     }
 
     // Get the length of data stored in the buffer
     pub fn ready_len(&self) -> usize {
-        let rb_consumer = self.inner.lock().unwrap();
-        rb_consumer.len()
+        self.rb.len()
     }
 }
 
@@ -436,6 +401,31 @@ impl<I: Copy> Consumer<I> {
     }
 
     pub fn pop_slices(&self, item_slices: &mut [&mut [I]]) -> Result<usize> {
+        self.do_pop_slices(item_slices, false)
+    }
+
+    /// Pop without blocking, even if the endpoint is blocking
+    pub fn try_pop_slices(&self, item_slices: &mut [&mut [I]]) -> Result<usize> {
+        self.do_pop_slices(item_slices, true)
+    }
+
+    /// Copy the items ready to be popped without popping them or blocking
+    ///
+    /// Safety. The caller must make sure that no item is popped concurrently, e.g., by
+    /// a lock that is held by all the consumers of the channel.
+    pub unsafe fn peek_slices(&self, item_slices: &mut [&mut [I]]) -> Result<usize> {
+        if self.is_self_shutdown() {
+            return_errno!(EPIPE, "this endpoint has been shutdown");
+        }
+
+        let total_count = self.rb.peek_slices(item_slices);
+        if total_count > 0 || self.is_peer_shutdown() {
+            return Ok(total_count);
+        }
+        return_errno!(EAGAIN, "try again later");
+    }
+
+    fn do_pop_slices(&self, item_slices: &mut [&mut [I]], is_nonblocking: bool) -> Result<usize> {
         let len: usize = item_slices.iter().map(|slice| slice.len()).sum();
         if len == 0 {
             return Ok(0);
@@ -443,24 +433,12 @@ impl<I: Copy> Consumer<I> {
 
         waiter_loop!(
             {
-                let mut rb_consumer = self.inner.lock().unwrap();
                 if self.is_self_shutdown() {
                     return_errno!(EPIPE, "this endpoint has been shutdown");
                 }
 
-                let mut total_count = 0;
-                for items in item_slices.iter_mut() {
-                    let count = rb_consumer.pop_slice(items);
-                    total_count += count;
-                    if count < items.len() {
-                        break;
-                    } else {
-                        continue;
-                    }
-                }
-
+                let total_count = self.rb.pop_slices(item_slices);
                 if total_count > 0 {
-                    drop(rb_consumer);
                     self.trigger_peer_events(&IoEvents::OUT);
                     return Ok(total_count);
                 };
@@ -468,11 +446,11 @@ impl<I: Copy> Consumer<I> {
                 if self.is_peer_shutdown() {
                     return Ok(0);
                 }
-                if self.is_nonblocking() {
+                if is_nonblocking || self.is_nonblocking() {
                     return_errno!(EAGAIN, "try again later");
                 }
             },
-            self.observer.waiter_queue()
+            self.waiter_queue()
         );
     }
 }
@@ -483,10 +461,23 @@ impl<I> Drop for Consumer<I> {
     }
 }
 
+/// Pushes of no more than this number of items are atomic, i.e., they are never
+/// interleaved with the items pushed by other threads. This is consistent with
+/// the guarantee of `PIPE_BUF` on Linux.
+const ATOMIC_PUSH_LEN: usize = 4096;
+
 /// The state of a channel shared by the two endpoints of a channel.
 struct State {
     is_producer_shutdown: AtomicBool,
     is_consumer_shutdown: AtomicBool,
+    producer_events: EndPointEvents,
+    consumer_events: EndPointEvents,
+}
+
+/// The waiters and observers interested in the events of an endpoint.
+struct EndPointEvents {
+    waiter_queue: WaiterQueue,
+    notifier: IoNotifier,
 }
 
 impl State {
@@ -494,6 +485,8 @@ impl State {
         Self {
             is_producer_shutdown: AtomicBool::new(false),
             is_consumer_shutdown: AtomicBool::new(false),
+            producer_events: EndPointEvents::new(),
+            consumer_events: EndPointEvents::new(),
         }
     }
 
@@ -505,11 +498,22 @@ impl State {
         self.is_consumer_shutdown.load(Ordering::Acquire)
     }
 
-    pub fn set_producer_shutdown(&self) {
-        self.is_producer_shutdown.store(true, Ordering::Release)
+    /// Returns false if the producer has already been shutdown.
+    pub fn set_producer_shutdown(&self) -> bool {
+        !self.is_producer_shutdown.swap(true, Ordering::AcqRel)
     }
 
-    pub fn set_consumer_shutdown(&self) {
-        self.is_consumer_shutdown.store(true, Ordering::Release)
+    /// Returns false if the consumer has already been shutdown.
+    pub fn set_consumer_shutdown(&self) -> bool {
+        !self.is_consumer_shutdown.swap(true, Ordering::AcqRel)
+    }
+}
+
+impl EndPointEvents {
+    pub fn new() -> Self {
+        Self {
+            waiter_queue: WaiterQueue::new(),
+            notifier: IoNotifier::new(),
+        }
     }
 }
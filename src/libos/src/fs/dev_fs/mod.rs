@@ -1,10 +1,10 @@
 use super::rootfs::mount_fs_at;
+use super::tmpfs::TmpFS;
 use super::*;
 
 use rcore_fs::vfs;
 use rcore_fs_devfs::DevFS;
 use rcore_fs_mountfs::MountFS;
-use rcore_fs_ramfs::RamFS;
 
 use self::dev_fd::DevFd;
 use self::dev_null::DevNull;
@@ -38,10 +38,10 @@ pub fn init_devfs() -> Result<Arc<MountFS>> {
     let dev_fd = Arc::new(DevFd) as _;
     devfs.add("fd", dev_fd);
     let mountable_devfs = MountFS::new(devfs);
-    // Mount the ramfs at '/shm'
-    let ramfs = RamFS::new();
+    // Mount the tmpfs at '/shm'
+    let tmpfs = TmpFS::new();
     mount_fs_at(
-        ramfs,
+        tmpfs,
         &mountable_devfs.root_inode(),
         &Path::new("/shm"),
         true,
@@ -39,6 +39,22 @@ pub trait File: Debug + Sync + Send + Any {
         return_op_unsupported_error!("writev")
     }
 
+    /// Read without blocking, even if the file is blocking. EAGAIN is returned if
+    /// nothing can be read now.
+    ///
+    /// A file whose readv may block must override this method.
+    fn readv_nonblocking(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        self.readv(bufs)
+    }
+
+    /// Write without blocking, even if the file is blocking. EAGAIN is returned if
+    /// nothing can be written now.
+    ///
+    /// A file whose writev may block must override this method.
+    fn writev_nonblocking(&self, bufs: &[&[u8]]) -> Result<usize> {
+        self.writev(bufs)
+    }
+
     fn seek(&self, pos: SeekFrom) -> Result<off_t> {
         return_op_unsupported_error!("seek")
     }
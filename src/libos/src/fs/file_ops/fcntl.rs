@@ -24,6 +24,10 @@ pub enum FcntlCmd<'a> {
     SetLk(&'a c_flock),
     /// The blocking version of SetLK
     SetLkWait(&'a c_flock),
+    /// Add the seals of a file of tmpfs, e.g., memfd
+    AddSeals(u32),
+    /// Get the seals of a file of tmpfs
+    GetSeals(),
 }
 
 impl<'a> FcntlCmd<'a> {
@@ -54,6 +58,8 @@ impl<'a> FcntlCmd<'a> {
                 let lock_c = unsafe { &*lock_ptr };
                 FcntlCmd::SetLkWait(lock_c)
             }
+            libc::F_ADD_SEALS => FcntlCmd::AddSeals(arg as u32),
+            libc::F_GET_SEALS => FcntlCmd::GetSeals(),
             _ => return_errno!(EINVAL, "unsupported command"),
         })
     }
@@ -135,6 +141,22 @@ pub fn do_fcntl(fd: FileDesc, cmd: &mut FcntlCmd) -> Result<isize> {
             file.set_advisory_lock(&lock, is_nonblocking)?;
             0
         }
+        FcntlCmd::AddSeals(seals) => {
+            let file = file_table.get(fd)?;
+            let tmp_file = file.as_tmp_file()?;
+            let seals =
+                FileSeals::from_bits(*seals).ok_or_else(|| errno!(EINVAL, "invalid seals"))?;
+            if !file.access_mode()?.writable() {
+                return_errno!(EPERM, "the file is not opened for writing");
+            }
+            tmp_file.add_seals(seals)?;
+            0
+        }
+        FcntlCmd::GetSeals() => {
+            let file = file_table.get(fd)?;
+            let tmp_file = file.as_tmp_file()?;
+            tmp_file.seals().bits() as isize
+        }
     };
     Ok(ret)
 }
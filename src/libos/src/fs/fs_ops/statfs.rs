@@ -91,11 +91,10 @@ impl TryFrom<FsInfo> for Statfs {
         } else {
             Self {
                 f_type: match info.magic {
-                    // The "/dev" and "/dev/shm" are tmpfs on Linux, so we transform the
-                    // magic number to TMPFS_MAGIC.
+                    // The "/dev" is tmpfs on Linux, so we transform the magic number to
+                    // TMPFS_MAGIC.
                     rcore_fs_ramfs::RAMFS_MAGIC | rcore_fs_devfs::DEVFS_MAGIC => {
-                        const TMPFS_MAGIC: usize = 0x0102_1994;
-                        TMPFS_MAGIC
+                        crate::fs::tmpfs::TMPFS_MAGIC
                     }
                     val => val,
                 },
@@ -5,6 +5,7 @@ use core::any::Any;
 use rcore_fs::vfs::*;
 use std::io::{Read, Seek, SeekFrom, Write};
 use std::os::unix::fs::{DirEntryExt, FileExt, FileTypeExt, PermissionsExt};
+use std::os::unix::io::AsRawFd;
 use std::path::{Path, PathBuf};
 use std::sync::{SgxMutex as Mutex, SgxMutexGuard as MutexGuard};
 use std::untrusted::fs;
@@ -293,6 +294,16 @@ impl INode for HNode {
 }
 
 impl HNode {
+    /// Get the host file descriptor of the regular file, with which the host can do
+    /// I/O on behalf of the LibOS. The descriptor is valid as long as the `HNode` is.
+    pub fn host_fd(&self) -> Option<i32> {
+        if !self.is_file() {
+            return None;
+        }
+        let guard = self.open_file().ok()?;
+        guard.as_ref().map(|file| file.as_raw_fd())
+    }
+
     /// Ensure to open the file and store a `File` into `self.file`,
     /// return the `MutexGuard`.
     fn open_file(&self) -> Result<MutexGuard<Option<fs::File>>> {
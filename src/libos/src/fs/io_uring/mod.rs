@@ -0,0 +1,125 @@
+//! io_uring, i.e., io_uring_setup and io_uring_enter.
+//!
+//! The submission and completion rings are in the user space with the same layouts
+//! as those of Linux, so that liburing works without changes. As the LibOS has no
+//! kernel threads to serve the requests in the background, the requests are
+//! consumed in batches and progressed when io_uring_enter is called:
+//!
+//! * The reads, writes and syncs of the files that are always ready, e.g., regular
+//!   files, are done as they are submitted. Those on the files of HostFS are gathered
+//!   into one OCall by AIO (see `aio::do_batch`).
+//! * The other requests, e.g., those on sockets or pipes, and polls wait for their
+//!   files to be ready. The files of all the waiting requests are polled at once,
+//!   and then only the ready requests are done.
+//! * The timeouts are checked whenever the requests are progressed.
+//!
+//! SQPOLL is accepted. But as there is no thread to poll the submission ring, the
+//! ring always has IORING_SQ_NEED_WAKEUP set, so that the user enters the LibOS to
+//! submit, as liburing does once the polling thread is idle.
+
+use super::*;
+use crate::util::mem_util::from_user;
+
+pub use self::ring::{AsIoUring, IoUring};
+
+mod request;
+mod ring;
+
+// The flags of io_uring_setup
+const IORING_SETUP_IOPOLL: u32 = 1 << 0;
+const IORING_SETUP_SQPOLL: u32 = 1 << 1;
+const IORING_SETUP_SQ_AFF: u32 = 1 << 2;
+const IORING_SETUP_CQSIZE: u32 = 1 << 3;
+const IORING_SETUP_CLAMP: u32 = 1 << 4;
+
+// The flags of io_uring_enter
+const IORING_ENTER_GETEVENTS: u32 = 1 << 0;
+const IORING_ENTER_SQ_WAKEUP: u32 = 1 << 1;
+const IORING_ENTER_SQ_WAIT: u32 = 1 << 2;
+
+// The flags of the submission ring
+const IORING_SQ_NEED_WAKEUP: u32 = 1 << 0;
+const IORING_SQ_CQ_OVERFLOW: u32 = 1 << 1;
+
+const IORING_FEAT_SINGLE_MMAP: u32 = 1 << 0;
+const IORING_FEAT_NODROP: u32 = 1 << 1;
+const IORING_FEAT_SUBMIT_STABLE: u32 = 1 << 2;
+const IORING_FEAT_RW_CUR_POS: u32 = 1 << 3;
+
+// The offsets to mmap the rings and the SQEs
+const IORING_OFF_SQ_RING: usize = 0;
+const IORING_OFF_CQ_RING: usize = 0x8000000;
+const IORING_OFF_SQES: usize = 0x10000000;
+
+const IORING_MAX_ENTRIES: u32 = 32768;
+const IORING_MAX_CQ_ENTRIES: u32 = 2 * IORING_MAX_ENTRIES;
+
+/// The offsets of the fields of the submission ring, i.e., `struct io_sqring_offsets`
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+#[allow(non_camel_case_types)]
+pub struct io_sqring_offsets {
+    head: u32,
+    tail: u32,
+    ring_mask: u32,
+    ring_entries: u32,
+    flags: u32,
+    dropped: u32,
+    array: u32,
+    resv1: u32,
+    resv2: u64,
+}
+
+/// The offsets of the fields of the completion ring, i.e., `struct io_cqring_offsets`
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+#[allow(non_camel_case_types)]
+pub struct io_cqring_offsets {
+    head: u32,
+    tail: u32,
+    ring_mask: u32,
+    ring_entries: u32,
+    overflow: u32,
+    cqes: u32,
+    flags: u32,
+    resv1: u32,
+    resv2: u64,
+}
+
+/// The parameters of io_uring_setup, i.e., `struct io_uring_params`
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+#[allow(non_camel_case_types)]
+pub struct io_uring_params {
+    sq_entries: u32,
+    cq_entries: u32,
+    flags: u32,
+    sq_thread_cpu: u32,
+    sq_thread_idle: u32,
+    features: u32,
+    wq_fd: u32,
+    resv: [u32; 3],
+    sq_off: io_sqring_offsets,
+    cq_off: io_cqring_offsets,
+}
+
+pub fn do_io_uring_setup(entries: u32, params: &mut io_uring_params) -> Result<FileRef> {
+    debug!("io_uring_setup: entries: {}, params: {:?}", entries, params);
+    let ring = IoUring::new(entries, params)?;
+    Ok(Arc::new(ring))
+}
+
+pub fn do_io_uring_enter(
+    fd: FileDesc,
+    to_submit: u32,
+    min_complete: u32,
+    flags: u32,
+) -> Result<usize> {
+    debug!(
+        "io_uring_enter: fd: {}, to_submit: {}, min_complete: {}, flags: {:#x}",
+        fd, to_submit, min_complete, flags
+    );
+    let file = current!().file(fd)?;
+    let ring = file.as_io_uring()?;
+    ring.enter(&file, to_submit, min_complete, flags)
+}
@@ -0,0 +1,439 @@
+use super::*;
+use crate::fs::aio::{AioOp, AioRequest};
+use crate::net::{AsUnixDatagram, AsUnixSocket, HostSocketType};
+use crate::time::timer_wheel::monotonic_now;
+use crate::time::timespec_t;
+use std::time::Duration;
+
+const IORING_OP_NOP: u8 = 0;
+const IORING_OP_READV: u8 = 1;
+const IORING_OP_WRITEV: u8 = 2;
+const IORING_OP_FSYNC: u8 = 3;
+const IORING_OP_POLL_ADD: u8 = 6;
+const IORING_OP_POLL_REMOVE: u8 = 7;
+const IORING_OP_TIMEOUT: u8 = 11;
+const IORING_OP_TIMEOUT_REMOVE: u8 = 12;
+const IORING_OP_ACCEPT: u8 = 13;
+const IORING_OP_ASYNC_CANCEL: u8 = 14;
+const IORING_OP_READ: u8 = 22;
+const IORING_OP_WRITE: u8 = 23;
+const IORING_OP_SEND: u8 = 26;
+const IORING_OP_RECV: u8 = 27;
+
+// The requests are always done asynchronously, so IOSQE_ASYNC is a no-op. The other
+// flags, e.g., IOSQE_FIXED_FILE or IOSQE_IO_LINK, are not supported.
+const IOSQE_ASYNC: u8 = 1 << 4;
+
+const IORING_FSYNC_DATASYNC: u32 = 1 << 0;
+const IORING_TIMEOUT_ABS: u32 = 1 << 0;
+
+const MSG_DONTWAIT: i32 = 0x40;
+
+/// A submission queue entry, i.e., `struct io_uring_sqe` of Linux
+#[repr(C)]
+#[derive(Clone, Copy, Debug)]
+#[allow(non_camel_case_types)]
+pub struct io_uring_sqe {
+    opcode: u8,
+    flags: u8,
+    ioprio: u16,
+    fd: i32,
+    // The offset, or the second address
+    off: u64,
+    addr: u64,
+    len: u32,
+    // The flags of the operation, e.g., rw_flags, poll_events or msg_flags
+    op_flags: u32,
+    user_data: u64,
+    pad: [u64; 3],
+}
+
+impl io_uring_sqe {
+    pub fn user_data(&self) -> u64 {
+        self.user_data
+    }
+}
+
+/// A completion queue entry, i.e., `struct io_uring_cqe` of Linux
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+#[allow(non_camel_case_types)]
+pub struct io_uring_cqe {
+    user_data: u64,
+    res: i32,
+    flags: u32,
+}
+
+impl io_uring_cqe {
+    pub fn new(user_data: u64, res: Result<usize>) -> Self {
+        let res = match res {
+            Ok(len) => min(len, i32::MAX as usize) as i32,
+            Err(e) => -(e.errno() as i32),
+        };
+        Self {
+            user_data,
+            res,
+            flags: 0,
+        }
+    }
+}
+
+/// A request parsed from an SQE, whose buffers are checked
+pub enum Request {
+    Nop,
+    /// A request done as it is submitted
+    Io(AioRequest),
+    /// A request done once its file is ready
+    Waiting(WaitingRequest),
+    Timeout(TimeoutRequest),
+    /// A request to cancel the request of the user data
+    Cancel(u64, CancelKind),
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum CancelKind {
+    Poll,
+    Timeout,
+    Any,
+}
+
+impl Request {
+    pub fn from_sqe(sqe: &io_uring_sqe) -> Result<Self> {
+        if sqe.flags & !IOSQE_ASYNC != 0 {
+            return_errno!(EINVAL, "the flags of the SQE are not supported");
+        }
+
+        let user_data = sqe.user_data;
+        let req = match sqe.opcode {
+            IORING_OP_NOP => Self::Nop,
+            IORING_OP_READV | IORING_OP_READ | IORING_OP_WRITEV | IORING_OP_WRITE => {
+                Self::from_rw_sqe(sqe)?
+            }
+            IORING_OP_FSYNC => {
+                if sqe.op_flags & !IORING_FSYNC_DATASYNC != 0 {
+                    return_errno!(EINVAL, "invalid fsync flags");
+                }
+                let op = if sqe.op_flags & IORING_FSYNC_DATASYNC != 0 {
+                    AioOp::Fdsync
+                } else {
+                    AioOp::Fsync
+                };
+                let file = current!().file(sqe.fd as FileDesc)?;
+                Self::Io(AioRequest::new(op, file, Vec::new(), None, user_data))
+            }
+            IORING_OP_POLL_ADD => {
+                let file = current!().file(sqe.fd as FileDesc)?;
+                let events = IoEvents::from_raw(sqe.op_flags & 0xffff);
+                Self::Waiting(WaitingRequest::new(sqe, file, events, Action::Poll))
+            }
+            IORING_OP_SEND | IORING_OP_RECV => {
+                let (addr, len) = (sqe.addr as usize, sqe.len as usize);
+                let (events, action) = if sqe.opcode == IORING_OP_SEND {
+                    from_user::check_array(addr as *const u8, len)?;
+                    let flags = sqe.op_flags as i32;
+                    (IoEvents::OUT, Action::Send { addr, len, flags })
+                } else {
+                    from_user::check_mut_array(addr as *mut u8, len)?;
+                    let flags = sqe.op_flags as i32;
+                    (IoEvents::IN, Action::Recv { addr, len, flags })
+                };
+                let file = current!().file(sqe.fd as FileDesc)?;
+                if !is_pollable(&file) {
+                    return_errno!(ENOTSOCK, "the file is not a socket");
+                }
+                Self::Waiting(WaitingRequest::new(sqe, file, events, action))
+            }
+            IORING_OP_ACCEPT => {
+                let addr = sqe.addr as usize;
+                let addr_len = sqe.off as usize;
+                if addr != 0 {
+                    from_user::check_mut_ptr(addr_len as *mut libc::socklen_t)?;
+                }
+                let file = current!().file(sqe.fd as FileDesc)?;
+                if !is_pollable(&file) {
+                    return_errno!(ENOTSOCK, "the file is not a socket");
+                }
+                let flags = sqe.op_flags as i32;
+                let action = Action::Accept {
+                    addr,
+                    addr_len,
+                    flags,
+                };
+                Self::Waiting(WaitingRequest::new(sqe, file, IoEvents::IN, action))
+            }
+            IORING_OP_TIMEOUT => {
+                if sqe.len != 1 || sqe.op_flags & !IORING_TIMEOUT_ABS != 0 {
+                    return_errno!(EINVAL, "invalid timeout");
+                }
+                let ts_ptr = sqe.addr as *const timespec_t;
+                from_user::check_ptr(ts_ptr)?;
+                let ts = timespec_t::from_raw_ptr(ts_ptr)?.as_duration();
+                let deadline = if sqe.op_flags & IORING_TIMEOUT_ABS != 0 {
+                    ts
+                } else {
+                    monotonic_now() + ts
+                };
+                Self::Timeout(TimeoutRequest {
+                    user_data,
+                    deadline,
+                    count: sqe.off,
+                    start: 0,
+                })
+            }
+            IORING_OP_POLL_REMOVE => Self::Cancel(sqe.addr, CancelKind::Poll),
+            IORING_OP_TIMEOUT_REMOVE => Self::Cancel(sqe.addr, CancelKind::Timeout),
+            IORING_OP_ASYNC_CANCEL => Self::Cancel(sqe.addr, CancelKind::Any),
+            _ => return_errno!(EINVAL, "the opcode is not supported"),
+        };
+        Ok(req)
+    }
+
+    fn from_rw_sqe(sqe: &io_uring_sqe) -> Result<Self> {
+        let op = match sqe.opcode {
+            IORING_OP_READV | IORING_OP_READ => AioOp::Read,
+            _ => AioOp::Write,
+        };
+        if sqe.op_flags != 0 {
+            return_errno!(EOPNOTSUPP, "the flags are not supported");
+        }
+        let file = current!().file(sqe.fd as FileDesc)?;
+        if let Ok(access_mode) = file.access_mode() {
+            if op == AioOp::Read && !access_mode.readable() {
+                return_errno!(EBADF, "the file is not readable");
+            }
+            if op == AioOp::Write && !access_mode.writable() {
+                return_errno!(EBADF, "the file is not writable");
+            }
+        }
+
+        // The iovecs are copied as they are submitted, i.e., IORING_FEAT_SUBMIT_STABLE
+        let iovs = match sqe.opcode {
+            IORING_OP_READ | IORING_OP_WRITE => vec![(sqe.addr as usize, sqe.len as usize)],
+            _ => {
+                let iovs_ptr = sqe.addr as *const libc::iovec;
+                let count = sqe.len as usize;
+                from_user::check_array(iovs_ptr, count)?;
+                let iovs = unsafe { std::slice::from_raw_parts(iovs_ptr, count) };
+                iovs.iter()
+                    .map(|iov| (iov.iov_base as usize, iov.iov_len))
+                    .collect()
+            }
+        };
+        for &(addr, len) in &iovs {
+            match op {
+                AioOp::Read => from_user::check_mut_array(addr as *mut u8, len)?,
+                _ => from_user::check_array(addr as *const u8, len)?,
+            }
+        }
+
+        if is_pollable(&file) {
+            let (events, action) = match op {
+                AioOp::Read => (IoEvents::IN, Action::Read { iovs }),
+                _ => (IoEvents::OUT, Action::Write { iovs }),
+            };
+            return Ok(Self::Waiting(WaitingRequest::new(
+                sqe, file, events, action,
+            )));
+        }
+        // An offset of -1 means the current position, i.e., IORING_FEAT_RW_CUR_POS
+        let offset = match sqe.off as i64 {
+            -1 => None,
+            offset if offset >= 0 => Some(offset as usize),
+            _ => return_errno!(EINVAL, "invalid offset"),
+        };
+        Ok(Self::Io(AioRequest::new(
+            op,
+            file,
+            iovs,
+            offset,
+            sqe.user_data,
+        )))
+    }
+}
+
+/// Whether the requests on the file should wait for the file to be ready. The
+/// regular files, and the files that cannot be polled, are always ready.
+fn is_pollable(file: &FileRef) -> bool {
+    if file.as_inode_file().is_ok() {
+        return false;
+    }
+    file.notifier().is_some() || file.host_fd().is_some()
+}
+
+#[derive(Debug)]
+enum Action {
+    Read {
+        iovs: Vec<(usize, usize)>,
+    },
+    Write {
+        iovs: Vec<(usize, usize)>,
+    },
+    Send {
+        addr: usize,
+        len: usize,
+        flags: i32,
+    },
+    Recv {
+        addr: usize,
+        len: usize,
+        flags: i32,
+    },
+    Accept {
+        addr: usize,
+        addr_len: usize,
+        flags: i32,
+    },
+    Poll,
+}
+
+/// A request waiting for its file to be ready
+#[derive(Debug)]
+pub struct WaitingRequest {
+    user_data: u64,
+    // The socket requests are done by the fd, as the syscalls do
+    fd: FileDesc,
+    file: FileRef,
+    events: IoEvents,
+    action: Action,
+}
+
+impl WaitingRequest {
+    fn new(sqe: &io_uring_sqe, file: FileRef, events: IoEvents, action: Action) -> Self {
+        Self {
+            user_data: sqe.user_data,
+            fd: sqe.fd as FileDesc,
+            file,
+            events: events | IoEvents::ERR | IoEvents::HUP,
+            action,
+        }
+    }
+
+    pub fn user_data(&self) -> u64 {
+        self.user_data
+    }
+
+    pub fn file(&self) -> &FileRef {
+        &self.file
+    }
+
+    pub fn events(&self) -> IoEvents {
+        self.events
+    }
+
+    pub fn is_poll(&self) -> bool {
+        matches!(self.action, Action::Poll)
+    }
+
+    /// The interesting events that are ready
+    pub fn poll(&self) -> IoEvents {
+        self.file.poll_new() & self.events
+    }
+
+    /// Do the request once the file is ready. EAGAIN is returned if the request
+    /// should wait again, e.g., the data are taken by others.
+    ///
+    /// The request must never block the ring, even if the file is blocking. The
+    /// sockets are done with MSG_DONTWAIT, and the other files are read or written
+    /// by their non-blocking methods.
+    pub fn execute(&self, revents: IoEvents) -> Result<usize> {
+        let len = match &self.action {
+            Action::Read { iovs } => {
+                let mut bufs: Vec<&mut [u8]> = iovs
+                    .iter()
+                    .map(|&(addr, len)| unsafe {
+                        std::slice::from_raw_parts_mut(addr as *mut u8, len)
+                    })
+                    .collect();
+                if is_socket(&self.file) {
+                    crate::net::do_recvv_nowait(self.fd as c_int, &mut bufs)?
+                } else {
+                    self.file.readv_nonblocking(&mut bufs)?
+                }
+            }
+            Action::Write { iovs } => {
+                let bufs: Vec<&[u8]> = iovs
+                    .iter()
+                    .map(|&(addr, len)| unsafe {
+                        std::slice::from_raw_parts(addr as *const u8, len)
+                    })
+                    .collect();
+                if is_socket(&self.file) {
+                    crate::net::do_sendv_nowait(self.fd as c_int, &bufs)?
+                } else {
+                    self.file.writev_nonblocking(&bufs)?
+                }
+            }
+            &Action::Send { addr, len, flags } => crate::net::do_sendto(
+                self.fd as c_int,
+                addr as *const c_void,
+                len,
+                flags | MSG_DONTWAIT,
+                std::ptr::null(),
+                0,
+            )? as usize,
+            &Action::Recv { addr, len, flags } => crate::net::do_recvfrom(
+                self.fd as c_int,
+                addr as *mut c_void,
+                len,
+                flags | MSG_DONTWAIT,
+                std::ptr::null_mut(),
+                std::ptr::null_mut(),
+            )? as usize,
+            &Action::Accept {
+                addr,
+                addr_len,
+                flags,
+            } => crate::net::do_accept4_nowait(
+                self.fd as c_int,
+                addr as *mut libc::sockaddr,
+                addr_len as *mut libc::socklen_t,
+                flags,
+            )? as usize,
+            Action::Poll => revents.to_raw() as usize,
+        };
+        Ok(len)
+    }
+}
+
+fn is_socket(file: &FileRef) -> bool {
+    file.as_host_socket().is_ok()
+        || file.as_unix_socket().is_ok()
+        || file.as_unix_datagram().is_ok()
+}
+
+/// A timeout, which expires at the deadline, or when `count` requests are completed
+#[derive(Debug)]
+pub struct TimeoutRequest {
+    user_data: u64,
+    // On the monotonic clock
+    deadline: Duration,
+    count: u64,
+    // The number of the completions when the timeout is submitted
+    start: u64,
+}
+
+impl TimeoutRequest {
+    pub fn start(mut self, nr_completions: u64) -> Self {
+        self.start = nr_completions;
+        self
+    }
+
+    pub fn user_data(&self) -> u64 {
+        self.user_data
+    }
+
+    pub fn deadline(&self) -> Duration {
+        self.deadline
+    }
+
+    /// Get the result if the timeout is completed
+    pub fn check(&self, now: Duration, nr_completions: u64) -> Option<Result<usize>> {
+        if self.count > 0 && nr_completions - self.start >= self.count {
+            Some(Ok(0))
+        } else if now >= self.deadline {
+            Some(Err(errno!(ETIME, "the timeout expires")))
+        } else {
+            None
+        }
+    }
+}
@@ -0,0 +1,609 @@
+use super::request::{
+    io_uring_cqe, io_uring_sqe, CancelKind, Request, TimeoutRequest, WaitingRequest,
+};
+use super::*;
+use crate::fs::aio;
+use crate::net::{EventMonitor, EventMonitorBuilder};
+use crate::time::timer_wheel::monotonic_now;
+use crate::vm::{MMapFlags, ProcessVM, VMPerms, PAGE_SIZE};
+use std::mem::size_of;
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::sync::Weak;
+use std::time::Duration;
+
+// The offsets of the fields in the region of the rings, where the submission ring
+// is followed by the completion ring. The SQE indexes of the submission ring are
+// after the CQEs.
+const SQ_HEAD: usize = 0;
+const SQ_TAIL: usize = 4;
+const SQ_RING_MASK: usize = 8;
+const SQ_RING_ENTRIES: usize = 12;
+const SQ_FLAGS: usize = 16;
+const SQ_DROPPED: usize = 20;
+const CQ_HEAD: usize = 24;
+const CQ_TAIL: usize = 28;
+const CQ_RING_MASK: usize = 32;
+const CQ_RING_ENTRIES: usize = 36;
+const CQ_OVERFLOW: usize = 40;
+const CQ_FLAGS: usize = 44;
+const CQES: usize = 64;
+
+/// An io_uring instance, whose rings are mapped in the user space when it is set up
+/// and returned by mmap on its file
+#[derive(Debug)]
+pub struct IoUring {
+    sq_entries: u32,
+    cq_entries: u32,
+    is_sqpoll: bool,
+    rings_addr: usize,
+    rings_size: usize,
+    sqes_addr: usize,
+    sqes_size: usize,
+    // The VM of the process where the rings are mapped
+    vm: Weak<ProcessVM>,
+    state: SgxMutex<RingState>,
+    notifier: IoNotifier,
+}
+
+#[derive(Debug)]
+struct RingState {
+    // The trusted copies of the head of the submission ring and the tail of the
+    // completion ring, as the values in the rings may be changed by the user
+    sq_head: u32,
+    cq_tail: u32,
+    // The completions that the completion ring has no room for, i.e.,
+    // IORING_FEAT_NODROP
+    overflow: VecDeque<io_uring_cqe>,
+    waiting: Vec<WaitingRequest>,
+    // Increased when new requests start to wait, so that the waiting threads
+    // monitor their files
+    waiting_generation: u64,
+    timeouts: Vec<TimeoutRequest>,
+    // The number of the completions of the requests other than timeouts
+    nr_completions: u64,
+}
+
+impl IoUring {
+    pub fn new(entries: u32, params: &mut io_uring_params) -> Result<Self> {
+        let flags = params.flags;
+        let supported_flags =
+            IORING_SETUP_SQPOLL | IORING_SETUP_SQ_AFF | IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+        if flags & !supported_flags != 0 {
+            return_errno!(EINVAL, "the flags are not supported");
+        }
+        if flags & IORING_SETUP_SQ_AFF != 0 && flags & IORING_SETUP_SQPOLL == 0 {
+            return_errno!(EINVAL, "IORING_SETUP_SQ_AFF requires IORING_SETUP_SQPOLL");
+        }
+        if params.resv != [0; 3] {
+            return_errno!(EINVAL, "the reserved fields must be zero");
+        }
+
+        let is_clamped = flags & IORING_SETUP_CLAMP != 0;
+        let sq_entries = round_entries(entries, IORING_MAX_ENTRIES, is_clamped)?;
+        let cq_entries = if flags & IORING_SETUP_CQSIZE != 0 {
+            let cq_entries = round_entries(params.cq_entries, IORING_MAX_CQ_ENTRIES, is_clamped)?;
+            if cq_entries < sq_entries {
+                return_errno!(
+                    EINVAL,
+                    "the completion ring is smaller than the submission ring"
+                );
+            }
+            cq_entries
+        } else {
+            2 * sq_entries
+        };
+
+        let sq_array = CQES + cq_entries as usize * size_of::<io_uring_cqe>();
+        let rings_size = align_up(sq_array + sq_entries as usize * 4, PAGE_SIZE);
+        let sqes_size = align_up(sq_entries as usize * size_of::<io_uring_sqe>(), PAGE_SIZE);
+        let rings_addr = mmap_anonymous(rings_size)?;
+        let sqes_addr = mmap_anonymous(sqes_size).map_err(|e| {
+            let _ = crate::vm::do_munmap(rings_addr, rings_size);
+            e
+        })?;
+
+        let ring = Self {
+            sq_entries,
+            cq_entries,
+            is_sqpoll: flags & IORING_SETUP_SQPOLL != 0,
+            rings_addr,
+            rings_size,
+            sqes_addr,
+            sqes_size,
+            vm: Arc::downgrade(current!().vm()),
+            state: SgxMutex::new(RingState {
+                sq_head: 0,
+                cq_tail: 0,
+                overflow: VecDeque::new(),
+                waiting: Vec::new(),
+                waiting_generation: 0,
+                timeouts: Vec::new(),
+                nr_completions: 0,
+            }),
+            notifier: IoNotifier::new(),
+        };
+        // The memory is zeroed by mmap
+        ring.field(SQ_RING_MASK)?
+            .store(sq_entries - 1, Ordering::Relaxed);
+        ring.field(SQ_RING_ENTRIES)?
+            .store(sq_entries, Ordering::Relaxed);
+        ring.field(CQ_RING_MASK)?
+            .store(cq_entries - 1, Ordering::Relaxed);
+        ring.field(CQ_RING_ENTRIES)?
+            .store(cq_entries, Ordering::Relaxed);
+        ring.update_sq_flags(&ring.state.lock().unwrap())?;
+
+        params.sq_entries = sq_entries;
+        params.cq_entries = cq_entries;
+        params.features = IORING_FEAT_SINGLE_MMAP
+            | IORING_FEAT_NODROP
+            | IORING_FEAT_SUBMIT_STABLE
+            | IORING_FEAT_RW_CUR_POS;
+        params.sq_off = io_sqring_offsets {
+            head: SQ_HEAD as u32,
+            tail: SQ_TAIL as u32,
+            ring_mask: SQ_RING_MASK as u32,
+            ring_entries: SQ_RING_ENTRIES as u32,
+            flags: SQ_FLAGS as u32,
+            dropped: SQ_DROPPED as u32,
+            array: sq_array as u32,
+            ..Default::default()
+        };
+        params.cq_off = io_cqring_offsets {
+            head: CQ_HEAD as u32,
+            tail: CQ_TAIL as u32,
+            ring_mask: CQ_RING_MASK as u32,
+            ring_entries: CQ_RING_ENTRIES as u32,
+            overflow: CQ_OVERFLOW as u32,
+            cqes: CQES as u32,
+            flags: CQ_FLAGS as u32,
+            ..Default::default()
+        };
+        Ok(ring)
+    }
+
+    /// Get the address of the rings or the SQEs. As both rings are in one region,
+    /// i.e., IORING_FEAT_SINGLE_MMAP, mapping either ring gets the same region.
+    pub fn mmap(&self, addr: usize, size: usize, flags: MMapFlags, offset: usize) -> Result<usize> {
+        let (region_addr, region_size) = match offset {
+            IORING_OFF_SQ_RING | IORING_OFF_CQ_RING => (self.rings_addr, self.rings_size),
+            IORING_OFF_SQES => (self.sqes_addr, self.sqes_size),
+            _ => return_errno!(EINVAL, "invalid offset"),
+        };
+        if size == 0 || size > region_size {
+            return_errno!(EINVAL, "invalid size");
+        }
+        if flags.contains(MMapFlags::MAP_FIXED) && addr != region_addr {
+            return_errno!(EINVAL, "the rings cannot be mapped at a fixed address");
+        }
+        Ok(region_addr)
+    }
+
+    pub fn enter(
+        &self,
+        this: &FileRef,
+        to_submit: u32,
+        min_complete: u32,
+        flags: u32,
+    ) -> Result<usize> {
+        let supported_flags =
+            IORING_ENTER_GETEVENTS | IORING_ENTER_SQ_WAKEUP | IORING_ENTER_SQ_WAIT;
+        if flags & !supported_flags != 0 {
+            return_errno!(EINVAL, "the flags are not supported");
+        }
+
+        // In SQPOLL mode, entering the LibOS plays the role of waking up the polling
+        // thread, which submits all the SQEs.
+        let nr_submitted = if self.is_sqpoll {
+            self.submit(self.sq_entries)?;
+            to_submit as usize
+        } else if to_submit > 0 {
+            self.submit(to_submit)?
+        } else {
+            0
+        };
+
+        let min_complete = if flags & IORING_ENTER_GETEVENTS != 0 {
+            min(min_complete, self.cq_entries) as usize
+        } else {
+            0
+        };
+        match self.progress(this, min_complete) {
+            Ok(()) => Ok(nr_submitted),
+            Err(_) if nr_submitted > 0 => Ok(nr_submitted),
+            Err(e) => Err(e),
+        }
+    }
+
+    /// Consume at most `to_submit` SQEs, returning the number of them
+    fn submit(&self, to_submit: u32) -> Result<usize> {
+        let sqes = {
+            let mut state = self.state.lock().unwrap();
+            self.pop_sqes(&mut state, to_submit)?
+        };
+        if sqes.is_empty() {
+            return Ok(0);
+        }
+
+        let mut io_reqs = Vec::new();
+        let mut cqes = Vec::new();
+        {
+            let mut state = self.state.lock().unwrap();
+            for sqe in &sqes {
+                match Request::from_sqe(sqe) {
+                    Ok(Request::Nop) => cqes.push(io_uring_cqe::new(sqe.user_data(), Ok(0))),
+                    Ok(Request::Io(req)) => io_reqs.push(req),
+                    Ok(Request::Waiting(req)) => {
+                        state.waiting.push(req);
+                        state.waiting_generation += 1;
+                    }
+                    Ok(Request::Timeout(req)) => {
+                        let req = req.start(state.nr_completions);
+                        state.timeouts.push(req);
+                    }
+                    Ok(Request::Cancel(target, kind)) => {
+                        let res = self.cancel(&mut state, target, kind);
+                        cqes.push(io_uring_cqe::new(sqe.user_data(), res));
+                    }
+                    Err(e) => cqes.push(io_uring_cqe::new(sqe.user_data(), Err(e))),
+                }
+            }
+            for cqe in cqes {
+                self.post(&mut state, cqe, false);
+            }
+        }
+
+        if !io_reqs.is_empty() {
+            let results = aio::do_batch(&io_reqs);
+            let mut state = self.state.lock().unwrap();
+            for (req, res) in io_reqs.iter().zip(results.into_iter()) {
+                self.post(&mut state, io_uring_cqe::new(req.user_data(), res), false);
+            }
+        }
+        self.notifier.broadcast(&IoEvents::IN);
+        Ok(sqes.len())
+    }
+
+    fn pop_sqes(&self, state: &mut RingState, to_submit: u32) -> Result<Vec<io_uring_sqe>> {
+        let tail = self.field(SQ_TAIL)?.load(Ordering::Acquire);
+        let nr_sqes = min(
+            min(tail.wrapping_sub(state.sq_head), self.sq_entries),
+            to_submit,
+        );
+        let array = self.sq_array()?;
+        let sqes = self.sqes()?;
+        let mut popped = Vec::with_capacity(nr_sqes as usize);
+        let mut nr_dropped = 0;
+        for _ in 0..nr_sqes {
+            let idx =
+                array[(state.sq_head & (self.sq_entries - 1)) as usize].load(Ordering::Relaxed);
+            state.sq_head = state.sq_head.wrapping_add(1);
+            match sqes.get(idx as usize) {
+                Some(sqe) => popped.push(*sqe),
+                None => nr_dropped += 1,
+            }
+        }
+        if nr_dropped > 0 {
+            self.field(SQ_DROPPED)?
+                .fetch_add(nr_dropped, Ordering::Relaxed);
+        }
+        // The SQEs are copied before the user reuses them
+        self.field(SQ_HEAD)?.store(state.sq_head, Ordering::Release);
+        Ok(popped)
+    }
+
+    fn cancel(&self, state: &mut RingState, target: u64, kind: CancelKind) -> Result<usize> {
+        if kind != CancelKind::Timeout {
+            let pos = state.waiting.iter().position(|req| {
+                req.user_data() == target && (kind == CancelKind::Any || req.is_poll())
+            });
+            if let Some(pos) = pos {
+                state.waiting.remove(pos);
+                let res = Err(errno!(ECANCELED, "the request is canceled"));
+                self.post(state, io_uring_cqe::new(target, res), false);
+                return Ok(0);
+            }
+        }
+        if kind != CancelKind::Poll {
+            let pos = state
+                .timeouts
+                .iter()
+                .position(|req| req.user_data() == target);
+            if let Some(pos) = pos {
+                state.timeouts.remove(pos);
+                let res = Err(errno!(ECANCELED, "the timeout is canceled"));
+                self.post(state, io_uring_cqe::new(target, res), true);
+                return Ok(0);
+            }
+        }
+        return_errno!(ENOENT, "the request is not found");
+    }
+
+    /// Progress the waiting requests and the timeouts until there are at least
+    /// `min_complete` completions
+    fn progress(&self, this: &FileRef, min_complete: usize) -> Result<()> {
+        let mut monitor: Option<(EventMonitor, u64)> = None;
+        loop {
+            if let Some((monitor, _)) = monitor.as_mut() {
+                monitor.reset_events();
+            }
+            self.do_ready_requests();
+            let (nr_ready, deadline, generation, has_waiting) = {
+                let mut state = self.state.lock().unwrap();
+                self.check_timeouts(&mut state);
+                self.flush_overflow(&mut state)?;
+                let deadline = state.timeouts.iter().map(|req| req.deadline()).min();
+                let has_waiting = !state.waiting.is_empty();
+                let nr_ready = self.nr_ready(&state)?;
+                (nr_ready, deadline, state.waiting_generation, has_waiting)
+            };
+            // The states of the host files are refreshed as the monitor is built, so
+            // the waiting requests are checked again after that
+            let is_monitored = matches!(
+                &monitor,
+                Some((_, monitor_generation)) if *monitor_generation == generation
+            );
+            if nr_ready >= min_complete && (is_monitored || !has_waiting) {
+                return Ok(());
+            }
+            if !is_monitored {
+                monitor = Some((self.new_monitor(this), generation));
+                continue;
+            }
+            let mut timeout = deadline.map(|deadline| {
+                deadline
+                    .checked_sub(monotonic_now())
+                    .unwrap_or(Duration::from_secs(0))
+            });
+            match monitor.as_mut().unwrap().0.wait_events(timeout.as_mut()) {
+                Ok(_) => {}
+                Err(e) if e.errno() == ETIMEDOUT => {}
+                Err(e) => return Err(e),
+            }
+        }
+    }
+
+    /// Monitor the files of the waiting requests, and the ring itself for the
+    /// completions by others. The host files that are not tracked are polled in
+    /// one OCall as the monitor is built.
+    fn new_monitor(&self, this: &FileRef) -> EventMonitor {
+        let files_and_events: Vec<(FileRef, IoEvents)> = {
+            let state = self.state.lock().unwrap();
+            state
+                .waiting
+                .iter()
+                .map(|req| (req.file().clone(), req.events()))
+                .collect()
+        };
+        let mut builder = EventMonitorBuilder::new(files_and_events.len() + 1);
+        builder.add_file(this.clone(), IoEvents::IN);
+        for (file, events) in files_and_events {
+            builder.add_file(file, events);
+        }
+        builder.build()
+    }
+
+    fn do_ready_requests(&self) {
+        let ready_reqs = {
+            let mut state = self.state.lock().unwrap();
+            let mut ready_reqs = Vec::new();
+            let mut idx = 0;
+            while idx < state.waiting.len() {
+                let revents = state.waiting[idx].poll();
+                if revents.is_empty() {
+                    idx += 1;
+                } else {
+                    ready_reqs.push((state.waiting.swap_remove(idx), revents));
+                }
+            }
+            ready_reqs
+        };
+        if ready_reqs.is_empty() {
+            return;
+        }
+
+        let results: Vec<_> = ready_reqs
+            .into_iter()
+            .map(|(req, revents)| {
+                let res = req.execute(revents);
+                (req, res)
+            })
+            .collect();
+        {
+            let mut state = self.state.lock().unwrap();
+            for (req, res) in results {
+                match res {
+                    Err(e) if e.errno() == EAGAIN => state.waiting.push(req),
+                    res => self.post(&mut state, io_uring_cqe::new(req.user_data(), res), false),
+                }
+            }
+        }
+        self.notifier.broadcast(&IoEvents::IN);
+    }
+
+    fn check_timeouts(&self, state: &mut RingState) {
+        let now = monotonic_now();
+        let mut idx = 0;
+        while idx < state.timeouts.len() {
+            match state.timeouts[idx].check(now, state.nr_completions) {
+                Some(res) => {
+                    let req = state.timeouts.swap_remove(idx);
+                    self.post(state, io_uring_cqe::new(req.user_data(), res), true);
+                }
+                None => idx += 1,
+            }
+        }
+    }
+
+    fn post(&self, state: &mut RingState, cqe: io_uring_cqe, is_timeout: bool) {
+        if !is_timeout {
+            state.nr_completions += 1;
+        }
+        // Keep the order of the completions
+        if state.overflow.is_empty() {
+            match self.push_cqe(state, &cqe) {
+                Ok(true) => return,
+                Ok(false) => {}
+                Err(e) => {
+                    // The rings may be unmapped by the user
+                    warn!("failed to put io_uring completion into the ring: {:?}", e);
+                    return;
+                }
+            }
+        }
+        state.overflow.push_back(cqe);
+        if let Err(e) = self.update_sq_flags(state) {
+            warn!("failed to update the flags of io_uring: {:?}", e);
+        }
+    }
+
+    fn push_cqe(&self, state: &mut RingState, cqe: &io_uring_cqe) -> Result<bool> {
+        let head = self.field(CQ_HEAD)?.load(Ordering::Acquire);
+        if state.cq_tail.wrapping_sub(head) >= self.cq_entries {
+            return Ok(false);
+        }
+        let idx = state.cq_tail & (self.cq_entries - 1);
+        self.cqes()?[idx as usize] = *cqe;
+        state.cq_tail = state.cq_tail.wrapping_add(1);
+        // The CQE must be visible before the tail
+        self.field(CQ_TAIL)?.store(state.cq_tail, Ordering::Release);
+        Ok(true)
+    }
+
+    fn flush_overflow(&self, state: &mut RingState) -> Result<()> {
+        if state.overflow.is_empty() {
+            return Ok(());
+        }
+        while let Some(cqe) = state.overflow.front().cloned() {
+            if !self.push_cqe(state, &cqe)? {
+                break;
+            }
+            state.overflow.pop_front();
+        }
+        self.update_sq_flags(state)
+    }
+
+    fn update_sq_flags(&self, state: &RingState) -> Result<()> {
+        let mut flags = 0;
+        if self.is_sqpoll {
+            flags |= IORING_SQ_NEED_WAKEUP;
+        }
+        if !state.overflow.is_empty() {
+            flags |= IORING_SQ_CQ_OVERFLOW;
+        }
+        self.field(SQ_FLAGS)?.store(flags, Ordering::Release);
+        Ok(())
+    }
+
+    /// The number of the completions that the user has not fetched
+    fn nr_ready(&self, state: &RingState) -> Result<usize> {
+        let head = self.field(CQ_HEAD)?.load(Ordering::Acquire);
+        let nr_in_ring = min(state.cq_tail.wrapping_sub(head), self.cq_entries);
+        Ok(nr_in_ring as usize + state.overflow.len())
+    }
+
+    fn field(&self, offset: usize) -> Result<&AtomicU32> {
+        from_user::check_mut_array(self.rings_addr as *mut u8, self.rings_size)?;
+        Ok(unsafe { &*((self.rings_addr + offset) as *const AtomicU32) })
+    }
+
+    fn cqes(&self) -> Result<&mut [io_uring_cqe]> {
+        from_user::check_mut_array(self.rings_addr as *mut u8, self.rings_size)?;
+        let cqes_ptr = (self.rings_addr + CQES) as *mut io_uring_cqe;
+        Ok(unsafe { std::slice::from_raw_parts_mut(cqes_ptr, self.cq_entries as usize) })
+    }
+
+    fn sq_array(&self) -> Result<&[AtomicU32]> {
+        from_user::check_mut_array(self.rings_addr as *mut u8, self.rings_size)?;
+        let array_addr =
+            self.rings_addr + CQES + self.cq_entries as usize * size_of::<io_uring_cqe>();
+        let array_ptr = array_addr as *const AtomicU32;
+        Ok(unsafe { std::slice::from_raw_parts(array_ptr, self.sq_entries as usize) })
+    }
+
+    fn sqes(&self) -> Result<&[io_uring_sqe]> {
+        from_user::check_array(self.sqes_addr as *const u8, self.sqes_size)?;
+        let sqes_ptr = self.sqes_addr as *const io_uring_sqe;
+        Ok(unsafe { std::slice::from_raw_parts(sqes_ptr, self.sq_entries as usize) })
+    }
+}
+
+impl Drop for IoUring {
+    fn drop(&mut self) {
+        // The rings are unmapped with the VM if the process has exited. They cannot
+        // be unmapped by another process, which closes the file last.
+        let vm = match self.vm.upgrade() {
+            Some(vm) => vm,
+            None => return,
+        };
+        if !Arc::ptr_eq(&vm, current!().vm()) {
+            return;
+        }
+        for &(addr, size) in &[
+            (self.rings_addr, self.rings_size),
+            (self.sqes_addr, self.sqes_size),
+        ] {
+            if let Err(e) = vm.munmap(addr, size) {
+                warn!("failed to unmap the io_uring region: {:?}", e);
+            }
+        }
+    }
+}
+
+impl File for IoUring {
+    fn poll_new(&self) -> IoEvents {
+        let state = self.state.lock().unwrap();
+        let mut events = IoEvents::empty();
+        if self.nr_ready(&state).unwrap_or(0) > 0 {
+            events |= IoEvents::IN;
+        }
+        if let Ok(sq_tail) = self.field(SQ_TAIL) {
+            let sq_tail = sq_tail.load(Ordering::Acquire);
+            if sq_tail.wrapping_sub(state.sq_head) < self.sq_entries {
+                events |= IoEvents::OUT;
+            }
+        }
+        events
+    }
+
+    fn notifier(&self) -> Option<&IoNotifier> {
+        Some(&self.notifier)
+    }
+
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+}
+
+pub trait AsIoUring {
+    fn as_io_uring(&self) -> Result<&IoUring>;
+}
+
+impl AsIoUring for FileRef {
+    fn as_io_uring(&self) -> Result<&IoUring> {
+        self.as_any()
+            .downcast_ref::<IoUring>()
+            .ok_or_else(|| errno!(EOPNOTSUPP, "not an io_uring file"))
+    }
+}
+
+fn round_entries(entries: u32, max_entries: u32, is_clamped: bool) -> Result<u32> {
+    if entries == 0 {
+        return_errno!(EINVAL, "the number of entries must be positive");
+    }
+    if entries > max_entries && !is_clamped {
+        return_errno!(EINVAL, "too many entries");
+    }
+    Ok(min(entries, max_entries).next_power_of_two())
+}
+
+fn mmap_anonymous(size: usize) -> Result<usize> {
+    crate::vm::do_mmap(
+        0,
+        size,
+        VMPerms::READ | VMPerms::WRITE,
+        MMapFlags::MAP_PRIVATE | MMapFlags::MAP_ANONYMOUS,
+        0,
+        0,
+    )
+}
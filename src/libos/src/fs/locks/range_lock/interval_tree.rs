@@ -0,0 +1,229 @@
+/// An interval tree of file ranges.
+///
+/// It is an AVL tree whose nodes are ordered by the start of range and then by the
+/// key, and each node is augmented with the max end of the ranges in its subtree.
+/// The ranges with the same key must not share the same start.
+use super::*;
+use std::cmp::Ordering;
+
+pub struct IntervalTree<K, V> {
+    root: Link<K, V>,
+    len: usize,
+}
+
+type Link<K, V> = Option<Box<Node<K, V>>>;
+
+struct Node<K, V> {
+    range: FileRange,
+    key: K,
+    value: V,
+    max_end: usize,
+    height: u8,
+    left: Link<K, V>,
+    right: Link<K, V>,
+}
+
+impl<K: Ord + Copy, V> IntervalTree<K, V> {
+    pub fn new() -> Self {
+        Self { root: None, len: 0 }
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Insert a range with the key and value, or update the existing one.
+    pub fn insert(&mut self, range: FileRange, key: K, value: V) {
+        let node = Box::new(Node {
+            range,
+            key,
+            value,
+            max_end: range.end(),
+            height: 1,
+            left: None,
+            right: None,
+        });
+        let mut is_new = true;
+        self.root = Some(Node::insert(self.root.take(), node, &mut is_new));
+        if is_new {
+            self.len += 1;
+        }
+    }
+
+    /// Remove the range which starts at `start` with the key.
+    pub fn remove(&mut self, start: usize, key: K) -> Option<(FileRange, V)> {
+        let (root, removed) = Node::remove(self.root.take(), start, key);
+        self.root = root;
+        removed.map(|node| {
+            self.len -= 1;
+            (node.range, node.value)
+        })
+    }
+
+    /// Find the first range overlapping with `range` that satisfies the predicate, in
+    /// the order of start.
+    pub fn find<F>(&self, range: &FileRange, mut predicate: F) -> Option<(&FileRange, &K, &V)>
+    where
+        F: FnMut(&FileRange, &K, &V) -> bool,
+    {
+        Node::find(&self.root, range, &mut predicate)
+            .map(|node| (&node.range, &node.key, &node.value))
+    }
+}
+
+impl<K: Ord + Copy, V> Default for IntervalTree<K, V> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<K: Ord + Copy, V> Node<K, V> {
+    fn height(link: &Link<K, V>) -> u8 {
+        link.as_ref().map_or(0, |node| node.height)
+    }
+
+    fn max_end(link: &Link<K, V>) -> usize {
+        link.as_ref().map_or(0, |node| node.max_end)
+    }
+
+    fn cmp_with(&self, start: usize, key: K) -> Ordering {
+        (start, key).cmp(&(self.range.start(), self.key))
+    }
+
+    fn balance_factor(&self) -> i32 {
+        Self::height(&self.left) as i32 - Self::height(&self.right) as i32
+    }
+
+    fn update(&mut self) {
+        self.height = 1 + max(Self::height(&self.left), Self::height(&self.right));
+        self.max_end = max(
+            self.range.end(),
+            max(Self::max_end(&self.left), Self::max_end(&self.right)),
+        );
+    }
+
+    fn rotate_right(mut node: Box<Self>) -> Box<Self> {
+        let mut left = node.left.take().unwrap();
+        node.left = left.right.take();
+        node.update();
+        left.right = Some(node);
+        left.update();
+        left
+    }
+
+    fn rotate_left(mut node: Box<Self>) -> Box<Self> {
+        let mut right = node.right.take().unwrap();
+        node.right = right.left.take();
+        node.update();
+        right.left = Some(node);
+        right.update();
+        right
+    }
+
+    fn rebalance(mut node: Box<Self>) -> Box<Self> {
+        node.update();
+        let balance_factor = node.balance_factor();
+        if balance_factor > 1 {
+            if node.left.as_ref().unwrap().balance_factor() < 0 {
+                node.left = Some(Self::rotate_left(node.left.take().unwrap()));
+            }
+            Self::rotate_right(node)
+        } else if balance_factor < -1 {
+            if node.right.as_ref().unwrap().balance_factor() > 0 {
+                node.right = Some(Self::rotate_right(node.right.take().unwrap()));
+            }
+            Self::rotate_left(node)
+        } else {
+            node
+        }
+    }
+
+    fn insert(link: Link<K, V>, new_node: Box<Self>, is_new: &mut bool) -> Box<Self> {
+        let mut node = match link {
+            Some(node) => node,
+            None => return new_node,
+        };
+        match node.cmp_with(new_node.range.start(), new_node.key) {
+            Ordering::Less => node.left = Some(Self::insert(node.left.take(), new_node, is_new)),
+            Ordering::Greater => {
+                node.right = Some(Self::insert(node.right.take(), new_node, is_new))
+            }
+            Ordering::Equal => {
+                node.range = new_node.range;
+                node.value = new_node.value;
+                *is_new = false;
+            }
+        }
+        Self::rebalance(node)
+    }
+
+    fn remove(link: Link<K, V>, start: usize, key: K) -> (Link<K, V>, Option<Box<Self>>) {
+        let mut node = match link {
+            Some(node) => node,
+            None => return (None, None),
+        };
+        let removed = match node.cmp_with(start, key) {
+            Ordering::Less => {
+                let (left, removed) = Self::remove(node.left.take(), start, key);
+                node.left = left;
+                removed
+            }
+            Ordering::Greater => {
+                let (right, removed) = Self::remove(node.right.take(), start, key);
+                node.right = right;
+                removed
+            }
+            Ordering::Equal => {
+                let rest = match (node.left.take(), node.right.take()) {
+                    (None, rest) | (rest, None) => rest,
+                    (Some(left), Some(right)) => {
+                        // Replace the node with the min node of the right subtree
+                        let (right, mut min) = Self::remove_min(right);
+                        min.left = Some(left);
+                        min.right = right;
+                        Some(Self::rebalance(min))
+                    }
+                };
+                return (rest, Some(node));
+            }
+        };
+        (Some(Self::rebalance(node)), removed)
+    }
+
+    fn remove_min(mut node: Box<Self>) -> (Link<K, V>, Box<Self>) {
+        match node.left.take() {
+            None => (node.right.take(), node),
+            Some(left) => {
+                let (left, min) = Self::remove_min(left);
+                node.left = left;
+                (Some(Self::rebalance(node)), min)
+            }
+        }
+    }
+
+    fn find<'a, F>(link: &'a Link<K, V>, range: &FileRange, predicate: &mut F) -> Option<&'a Self>
+    where
+        F: FnMut(&FileRange, &K, &V) -> bool,
+    {
+        let node = link.as_ref()?;
+        // No ranges in the subtree reach the start
+        if node.max_end <= range.start() {
+            return None;
+        }
+        if let Some(found) = Self::find(&node.left, range, predicate) {
+            return Some(found);
+        }
+        // The node and the ranges in the right subtree start after the end
+        if node.range.start() >= range.end() {
+            return None;
+        }
+        if node.range.end() > range.start() && predicate(&node.range, &node.key, &node.value) {
+            return Some(node);
+        }
+        Self::find(&node.right, range, predicate)
+    }
+}
@@ -1,16 +1,20 @@
 /// File POSIX advisory range locks
 use super::*;
 use crate::events::{Waiter, WaiterQueue};
-use crate::util::sync::rw_lock::RwLockWriteGuard;
 use process::pid_t;
 use rcore_fs::vfs::AnyExt;
+use std::collections::BTreeMap;
 
 pub use self::builder::RangeLockBuilder;
+use self::interval_tree::IntervalTree;
 pub use self::range::{FileRange, OverlapWith, OFFSET_MAX};
 use self::range::{FileRangeChange, RangeLockWhence};
+use self::wait_for::WaitFor;
 
 mod builder;
+mod interval_tree;
 mod range;
+mod wait_for;
 
 /// C struct for a file range lock in Libc
 #[repr(C)]
@@ -115,6 +119,34 @@ impl RangeLock {
         }
     }
 
+    /// Cut the overlapping range off the lock, return the remaining parts to the
+    /// left and right of the range.
+    pub fn cut(mut self, range: &FileRange) -> (Option<Self>, Option<Self>) {
+        let has_left = self.start() < range.start();
+        let has_right = self.end() > range.end();
+        match (has_left, has_right) {
+            (true, true) => {
+                let right_lk = {
+                    let mut r_lk = self.clone();
+                    r_lk.set_start(range.end());
+                    r_lk
+                };
+                self.set_end(range.start());
+                (Some(self), Some(right_lk))
+            }
+            (true, false) => {
+                self.set_end(range.start());
+                (Some(self), None)
+            }
+            (false, true) => {
+                self.set_start(range.end());
+                (None, Some(self))
+            }
+            // The lock is dropped, and the waiters are woken up
+            (false, false) => (None, None),
+        }
+    }
+
     pub fn enqueue_waiter(&mut self, waiter: &Waiter) {
         if self.waiters.is_none() {
             self.waiters = Some(WaiterQueue::new());
@@ -159,8 +191,9 @@ impl Clone for RangeLock {
 
 /// List of File POSIX advisory range locks.
 ///
-/// Rule of ordering:
-/// Locks are sorted by owner process, then by the starting offset.
+/// Rule of indexing:
+/// All locks are indexed by range in an interval tree to find the conflicts, and the
+/// locks of each owner are indexed by the starting offset to update them.
 ///
 /// Rule of mergeing:
 /// Adjacent and overlapping locks with same owner and type will be merged.
@@ -169,28 +202,40 @@ impl Clone for RangeLock {
 /// New locks with different type will replace or split the overlapping locks
 /// if they have same owner.
 ///
+/// Rule of waiting:
+/// A blocked request waits on the conflicting lock, and it is woken up when the lock
+/// is shrinked or released. A request that would cause a deadlock fails with EDEADLK.
+///
 pub struct RangeLockList {
-    inner: RwLock<VecDeque<RangeLock>>,
+    inner: RwLock<RangeLockListInner>,
+}
+
+struct RangeLockListInner {
+    /// The owners and types of all locks
+    tree: IntervalTree<pid_t, RangeLockType>,
+    /// The locks of each owner, which do not overlap with each other
+    owners: HashMap<pid_t, BTreeMap<usize, RangeLock>>,
 }
 
 impl RangeLockList {
     pub fn new() -> Self {
         Self {
-            inner: RwLock::new(VecDeque::new()),
+            inner: RwLock::new(RangeLockListInner {
+                tree: IntervalTree::new(),
+                owners: HashMap::new(),
+            }),
         }
     }
 
     pub fn test_lock(&self, lock: &mut RangeLock) {
         debug!("test_lock with RangeLock: {:?}", lock);
-        let list = self.inner.read().unwrap();
-        for existing_lock in list.iter() {
-            if lock.conflict_with(existing_lock) {
-                // Return the information about the conflict lock
-                lock.owner = existing_lock.owner;
-                lock.type_ = existing_lock.type_;
-                lock.range = existing_lock.range;
-                return;
-            }
+        let inner = self.inner.read().unwrap();
+        if let Some(conflict_lock) = inner.find_conflict(lock) {
+            // Return the information about the conflict lock
+            lock.owner = conflict_lock.owner;
+            lock.type_ = conflict_lock.type_;
+            lock.range = conflict_lock.range;
+            return;
         }
         // The lock could be placed at this time
         lock.type_ = RangeLockType::F_UNLCK;
@@ -202,160 +247,120 @@ impl RangeLockList {
             lock, is_nonblocking
         );
         loop {
-            let mut list = self.inner.write().unwrap();
-            if let Some(mut conflict_lock) = list.iter_mut().find(|l| l.conflict_with(lock)) {
+            let mut inner = self.inner.write().unwrap();
+            if let Some(conflict_lock) = inner.find_conflict_mut(lock) {
                 if is_nonblocking {
                     return_errno!(EAGAIN, "lock conflict, try again later");
                 }
-                // Start to wait
+                // Start to wait, the edge is kept in the wait-for graph until waking up
+                let _wait_for = WaitFor::new(lock.owner, conflict_lock.owner)?;
                 let waiter = Waiter::new();
-                // TODO: Add deadlock detection, and returns EDEADLK
-                warn!("Do not support deadlock detection, maybe wait infinitely");
                 conflict_lock.enqueue_waiter(&waiter);
                 // Ensure that we drop any locks before wait
-                drop(list);
+                drop(inner);
                 waiter.wait(None)?;
                 // Wake up, let's try to set lock again
                 continue;
             }
             // No conflict here, let's insert the lock
-            return Ok(Self::insert_lock_into_list(&mut list, lock));
+            inner.insert(lock);
+            return Ok(());
         }
     }
 
-    fn insert_lock_into_list(list: &mut RwLockWriteGuard<VecDeque<RangeLock>>, lock: &RangeLock) {
-        let first_same_owner_idx = match list.iter().position(|lk| lk.owner() == lock.owner()) {
-            Some(idx) => idx,
-            None => {
-                // Can't find existing locks with same owner.
-                list.push_front(lock.clone());
-                return;
-            }
-        };
-        // Insert the lock at the start position with same owner, may breaking
-        // the rules of RangeLockList.
-        // We will handle the inserted lock with next one to adjust the list to
-        // obey the rules.
-        list.insert(first_same_owner_idx, lock.clone());
-        let mut pre_idx = first_same_owner_idx;
-        let mut next_idx = pre_idx + 1;
-        loop {
-            if next_idx >= list.len() {
-                break;
-            }
-            let pre_lock = list[pre_idx].clone();
-            let next_lock = list[next_idx].clone();
+    pub fn unlock(&self, lock: &RangeLock) {
+        debug!("unlock with RangeLock: {:?}", lock);
+        let mut inner = self.inner.write().unwrap();
+        inner.remove_range(lock.owner, &lock.range);
+    }
+}
 
-            if next_lock.owner() != pre_lock.owner() {
-                break;
-            }
-            if next_lock.type_() == pre_lock.type_() {
-                // Same type
-                if pre_lock.end() < next_lock.start() {
-                    break;
-                } else if next_lock.end() < pre_lock.start() {
-                    list.swap(pre_idx, next_idx);
-                    pre_idx += 1;
-                    next_idx += 1;
-                } else {
-                    // Merge adjacent or overlapping locks
-                    list[next_idx].merge_with(&pre_lock);
-                    list.remove(pre_idx);
-                }
+impl RangeLockListInner {
+    fn find_conflict_key(&self, lock: &RangeLock) -> Option<(pid_t, usize)> {
+        self.tree
+            .find(&lock.range, |_, &owner, &type_| {
+                // locks owned by the same process do not conflict, and write lock is
+                // exclusive
+                owner != lock.owner
+                    && (type_ == RangeLockType::F_WRLCK || lock.type_ == RangeLockType::F_WRLCK)
+            })
+            .map(|(range, &owner, _)| (owner, range.start()))
+    }
+
+    fn find_conflict(&self, lock: &RangeLock) -> Option<&RangeLock> {
+        let (owner, start) = self.find_conflict_key(lock)?;
+        self.owners.get(&owner)?.get(&start)
+    }
+
+    fn find_conflict_mut(&mut self, lock: &RangeLock) -> Option<&mut RangeLock> {
+        let (owner, start) = self.find_conflict_key(lock)?;
+        self.owners.get_mut(&owner)?.get_mut(&start)
+    }
+
+    fn insert(&mut self, lock: &RangeLock) {
+        let owner = lock.owner;
+        let locks = self.owners.entry(owner).or_default();
+        // The locks of the owner that are overlapping or adjacent with the new lock
+        let affected_starts: Vec<usize> = locks
+            .range(..=lock.end())
+            .rev()
+            .take_while(|(_, lk)| lk.end() >= lock.start())
+            .map(|(&start, _)| start)
+            .collect();
+
+        let mut new_lock = lock.clone();
+        for start in affected_starts {
+            let mut existing_lock = locks.remove(&start).unwrap();
+            self.tree.remove(start, owner);
+            if existing_lock.type_ == lock.type_ {
+                // Merge adjacent or overlapping locks, keeping the waiters of the
+                // existing one
+                existing_lock.merge_with(&new_lock);
+                new_lock = existing_lock;
+            } else if existing_lock.overlap_with(lock).is_none() {
+                Self::put(&mut self.tree, locks, existing_lock);
             } else {
-                // Different type
-                if pre_lock.end() <= next_lock.start() {
-                    break;
-                } else if next_lock.end() <= pre_lock.start() {
-                    list.swap(pre_idx, next_idx);
-                    pre_idx += 1;
-                    next_idx += 1;
-                } else {
-                    // Split overlapping locks
-                    let overlap_with = pre_lock.overlap_with(&next_lock).unwrap();
-                    match overlap_with {
-                        OverlapWith::ToLeft => {
-                            list[next_idx].set_start(pre_lock.end());
-                            break;
-                        }
-                        OverlapWith::InMiddle => {
-                            let right_lk = {
-                                let mut r_lk = next_lock.clone();
-                                r_lk.set_start(pre_lock.end());
-                                r_lk
-                            };
-                            list[next_idx].set_end(pre_lock.start());
-                            list.swap(pre_idx, next_idx);
-                            list.insert(next_idx + 1, right_lk);
-                            break;
-                        }
-                        OverlapWith::ToRight => {
-                            list[next_idx].set_end(pre_lock.start());
-                            list.swap(pre_idx, next_idx);
-                            pre_idx += 1;
-                            next_idx += 1;
-                        }
-                        OverlapWith::Includes => {
-                            // New lock can replace the old one
-                            list.remove(next_idx);
-                        }
-                    }
+                // Replace or split overlapping locks
+                let (left_lk, right_lk) = existing_lock.cut(&lock.range);
+                for lk in left_lk.into_iter().chain(right_lk) {
+                    Self::put(&mut self.tree, locks, lk);
                 }
             }
         }
+        Self::put(&mut self.tree, locks, new_lock);
     }
 
-    pub fn unlock(&self, lock: &RangeLock) {
-        debug!("unlock with RangeLock: {:?}", lock);
-        let mut list = self.inner.write().unwrap();
-        let mut skipped = 0;
-        loop {
-            let idx = match list
-                .iter()
-                .skip(skipped)
-                .position(|lk| lk.owner() == lock.owner())
-            {
-                // (idx + skipped) is the original position in list
-                Some(idx) => idx + skipped,
-                None => break,
-            };
-
-            let existing_lock = &mut list[idx];
-            let overlap_with = match lock.overlap_with(existing_lock) {
-                Some(overlap_with) => overlap_with,
-                None => {
-                    skipped = idx + 1;
-                    continue;
-                }
-            };
-
-            match overlap_with {
-                OverlapWith::ToLeft => {
-                    existing_lock.set_start(lock.end());
-                    break;
-                }
-                OverlapWith::InMiddle => {
-                    // Split the lock
-                    let right_lk = {
-                        let mut r_lk = existing_lock.clone();
-                        r_lk.set_start(lock.end());
-                        r_lk
-                    };
-                    existing_lock.set_end(lock.start());
-                    list.insert(idx + 1, right_lk);
-                    break;
-                }
-                OverlapWith::ToRight => {
-                    existing_lock.set_end(lock.start());
-                    skipped = idx + 1;
-                }
-                OverlapWith::Includes => {
-                    // The lock can be deleted from the list
-                    list.remove(idx);
-                    skipped = idx;
-                }
+    fn remove_range(&mut self, owner: pid_t, range: &FileRange) {
+        let locks = match self.owners.get_mut(&owner) {
+            Some(locks) => locks,
+            None => return,
+        };
+        let overlapping_starts: Vec<usize> = locks
+            .range(..range.end())
+            .rev()
+            .take_while(|(_, lk)| lk.end() > range.start())
+            .map(|(&start, _)| start)
+            .collect();
+        for start in overlapping_starts {
+            let existing_lock = locks.remove(&start).unwrap();
+            self.tree.remove(start, owner);
+            let (left_lk, right_lk) = existing_lock.cut(range);
+            for lk in left_lk.into_iter().chain(right_lk) {
+                Self::put(&mut self.tree, locks, lk);
             }
         }
+        if locks.is_empty() {
+            self.owners.remove(&owner);
+        }
+    }
+
+    fn put(
+        tree: &mut IntervalTree<pid_t, RangeLockType>,
+        locks: &mut BTreeMap<usize, RangeLock>,
+        lock: RangeLock,
+    ) {
+        tree.insert(lock.range, lock.owner, lock.type_);
+        locks.insert(lock.start(), lock);
     }
 }
 
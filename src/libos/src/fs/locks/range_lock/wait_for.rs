@@ -0,0 +1,82 @@
+/// Deadlock detection of range locks.
+///
+/// The owners blocked by range locks, of any file, form a wait-for graph, where an
+/// edge from owner A to owner B means A is waiting for a lock held by B. A lock
+/// request that would close a cycle in the graph is a deadlock.
+use super::*;
+use std::collections::HashSet;
+
+lazy_static! {
+    static ref WAIT_FOR_GRAPH: SgxMutex<WaitForGraph> = SgxMutex::new(WaitForGraph::new());
+}
+
+/// An edge in the wait-for graph, which is removed when dropped
+pub struct WaitFor {
+    waiter: pid_t,
+    blocker: pid_t,
+}
+
+impl WaitFor {
+    /// Add the edge, or return EDEADLK if the waiter is waited by the blocker directly
+    /// or indirectly.
+    pub fn new(waiter: pid_t, blocker: pid_t) -> Result<Self> {
+        let mut graph = WAIT_FOR_GRAPH.lock().unwrap();
+        if graph.is_reachable(blocker, waiter) {
+            return_errno!(EDEADLK, "waiting for the lock would cause a deadlock");
+        }
+        graph.add_edge(waiter, blocker);
+        Ok(Self { waiter, blocker })
+    }
+}
+
+impl Drop for WaitFor {
+    fn drop(&mut self) {
+        WAIT_FOR_GRAPH
+            .lock()
+            .unwrap()
+            .remove_edge(self.waiter, self.blocker);
+    }
+}
+
+struct WaitForGraph {
+    // An owner may wait for the same owner more than once, e.g., in multiple threads
+    edges: HashMap<pid_t, Vec<pid_t>>,
+}
+
+impl WaitForGraph {
+    fn new() -> Self {
+        Self {
+            edges: HashMap::new(),
+        }
+    }
+
+    fn add_edge(&mut self, waiter: pid_t, blocker: pid_t) {
+        self.edges.entry(waiter).or_default().push(blocker);
+    }
+
+    fn remove_edge(&mut self, waiter: pid_t, blocker: pid_t) {
+        let blockers = self.edges.get_mut(&waiter).unwrap();
+        let idx = blockers.iter().position(|&pid| pid == blocker).unwrap();
+        blockers.swap_remove(idx);
+        if blockers.is_empty() {
+            self.edges.remove(&waiter);
+        }
+    }
+
+    fn is_reachable(&self, from: pid_t, to: pid_t) -> bool {
+        let mut visited = HashSet::new();
+        let mut stack = vec![from];
+        while let Some(pid) = stack.pop() {
+            if pid == to {
+                return true;
+            }
+            if !visited.insert(pid) {
+                continue;
+            }
+            if let Some(blockers) = self.edges.get(&pid) {
+                stack.extend(blockers.iter().filter(|pid| !visited.contains(pid)));
+            }
+        }
+        false
+    }
+}
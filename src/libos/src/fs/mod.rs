@@ -15,6 +15,7 @@ use untrusted::{SliceAsMutPtrAndLen, SliceAsPtrAndLen};
 
 use crate::config::ConfigMount;
 
+pub use self::aio::{aio_context_t, io_event_t, iocb_t, AioContexts};
 pub use self::event_file::{AsEvent, EventCreationFlags, EventFile};
 pub use self::events::{AtomicIoEvents, IoEvents, IoNotifier};
 pub use self::file::{File, FileRef};
@@ -28,16 +29,20 @@ pub use self::fs_ops::Statfs;
 pub use self::fs_view::FsView;
 pub use self::host_fd::HostFd;
 pub use self::inode_file::{AsINodeFile, INodeExt, INodeFile};
+pub use self::io_uring::{io_uring_params, AsIoUring, IoUring};
 pub use self::locks::flock::{Flock, FlockList, FlockOps, FlockType};
 pub use self::locks::range_lock::{
     FileRange, RangeLock, RangeLockBuilder, RangeLockList, RangeLockType, OFFSET_MAX,
 };
 pub use self::pipe::PipeType;
 pub use self::rootfs::ROOT_FS;
+pub use self::signal_file::{AsSignalFile, SignalCreationFlags, SignalFile};
 pub use self::stdio::{HostStdioFds, StdinFile, StdoutFile};
 pub use self::syscalls::*;
 pub use self::timer_file::{AsTimer, TimerCreationFlags, TimerFile};
+pub use self::tmpfs::{AsTmpFile, FileSeals, TmpFS};
 
+mod aio;
 pub mod channel;
 mod dev_fs;
 mod event_file;
@@ -50,14 +55,17 @@ mod fs_view;
 mod host_fd;
 mod hostfs;
 mod inode_file;
+mod io_uring;
 mod locks;
 mod pipe;
 mod procfs;
 mod rootfs;
 mod sefs;
+mod signal_file;
 mod stdio;
 mod syscalls;
 mod timer_file;
+mod tmpfs;
 
 /// Split a `path` to (`dir_path`, `file_name`).
 ///
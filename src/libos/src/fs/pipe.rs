@@ -44,6 +44,10 @@ impl File for PipeReader {
         self.consumer.pop_slices(bufs)
     }
 
+    fn readv_nonblocking(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        self.consumer.try_pop_slices(bufs)
+    }
+
     fn metadata(&self) -> Result<Metadata> {
         Ok(Metadata {
             dev: 0,
@@ -142,6 +146,10 @@ impl File for PipeWriter {
         self.producer.push_slices(bufs)
     }
 
+    fn writev_nonblocking(&self, bufs: &[&[u8]]) -> Result<usize> {
+        self.producer.try_push_slices(bufs)
+    }
+
     fn seek(&self, pos: SeekFrom) -> Result<off_t> {
         return_errno!(ESPIPE, "Pipe does not support seek")
     }
@@ -1,5 +1,7 @@
 use super::*;
-use crate::vm::USER_SPACE_VM_MANAGER;
+use crate::process::table::get_all_processes;
+use crate::vm::{SHMEM_SIZE, USER_SPACE_VM_MANAGER};
+use std::sync::atomic::Ordering;
 
 pub struct MemInfoINode;
 
@@ -15,13 +17,29 @@ impl ProcINode for MemInfoINode {
     fn generate_data_in_bytes(&self) -> vfs::Result<Vec<u8>> {
         let total_ram = USER_SPACE_VM_MANAGER.get_total_size();
         let free_ram = current!().vm().get_free_size();
+        // The memory of tmpfs, i.e., /dev/shm and memfd
+        let shmem = SHMEM_SIZE.load(Ordering::Relaxed);
+        // The memory reclaimed by madvise and not used again, which are not in Linux
+        let (discarded, lazy_freed) = get_all_processes()
+            .iter()
+            .filter_map(|process| process.main_thread())
+            .map(|thread| thread.vm().reclaim_stat().sizes())
+            .fold((0, 0), |(discarded, lazy_freed), (d, l)| {
+                (discarded + d, lazy_freed + l)
+            });
         Ok(format!(
             "MemTotal:       {} kB\n\
              MemFree:        {} kB\n\
-             MemAvailable:   {} kB\n",
+             MemAvailable:   {} kB\n\
+             Shmem:          {} kB\n\
+             Discarded:      {} kB\n\
+             LazyFree:       {} kB\n",
             total_ram / KB,
             free_ram / KB,
             free_ram / KB,
+            shmem / KB,
+            discarded / KB,
+            lazy_freed / KB,
         )
         .into_bytes())
     }
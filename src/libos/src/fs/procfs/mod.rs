@@ -7,17 +7,21 @@ use crate::process::table::get_all_processes;
 
 use self::cpuinfo::CpuInfoINode;
 use self::meminfo::MemInfoINode;
+use self::numa_meminfo::NumaMemInfoINode;
 use self::pid::LockedPidDirINode;
 use self::proc_inode::{Dir, DirProcINode, File, ProcINode, SymLink};
 use self::self_::SelfSymINode;
 use self::stat::StatINode;
+use self::sysvipc::LockedSysvIpcDirINode;
 
 mod cpuinfo;
 mod meminfo;
+mod numa_meminfo;
 mod pid;
 mod proc_inode;
 mod self_;
 mod stat;
+mod sysvipc;
 
 // Same with the procfs on Linux
 const PROC_SUPER_MAGIC: usize = 0x9fa0;
@@ -107,12 +111,18 @@ impl LockedProcRootINode {
         let meminfo_inode = MemInfoINode::new();
         file.non_volatile_entries
             .insert(String::from("meminfo"), meminfo_inode);
+        let numa_meminfo_inode = NumaMemInfoINode::new();
+        file.non_volatile_entries
+            .insert(String::from("numa_meminfo"), numa_meminfo_inode);
         let self_inode = SelfSymINode::new();
         file.non_volatile_entries
             .insert(String::from("self"), self_inode);
         let stat_inode = StatINode::new();
         file.non_volatile_entries
             .insert(String::from("stat"), stat_inode);
+        let sysvipc_inode = LockedSysvIpcDirINode::new(file.this.clone());
+        file.non_volatile_entries
+            .insert(String::from("sysvipc"), sysvipc_inode);
     }
 }
 
@@ -0,0 +1,36 @@
+use super::*;
+use crate::vm::USER_SPACE_VM_MANAGER;
+
+/// The memory usage of each NUMA pool of the user space, in the format of
+/// `/sys/devices/system/node/node<N>/meminfo` on Linux.
+pub struct NumaMemInfoINode;
+
+const KB: usize = 1024;
+
+impl NumaMemInfoINode {
+    pub fn new() -> Arc<dyn INode> {
+        Arc::new(File::new(Self))
+    }
+}
+
+impl ProcINode for NumaMemInfoINode {
+    fn generate_data_in_bytes(&self) -> vfs::Result<Vec<u8>> {
+        let num_nodes = USER_SPACE_VM_MANAGER.numa_pools().num_nodes();
+        let mut data = String::new();
+        for node in 0..num_nodes as u32 {
+            let (total, free) = USER_SPACE_VM_MANAGER.numa_node_usage(node);
+            data += &format!(
+                "Node {} MemTotal:       {} kB\n\
+                 Node {} MemFree:        {} kB\n\
+                 Node {} MemUsed:        {} kB\n",
+                node,
+                total / KB,
+                node,
+                free / KB,
+                node,
+                (total - free) / KB,
+            );
+        }
+        Ok(data.into_bytes())
+    }
+}
@@ -10,6 +10,7 @@ use self::fd::LockedProcFdDirINode;
 use self::maps::ProcMapsINode;
 use self::root::ProcRootSymINode;
 use self::stat::ProcStatINode;
+use self::status::ProcStatusINode;
 
 mod cmdline;
 mod comm;
@@ -19,6 +20,7 @@ mod fd;
 mod maps;
 mod root;
 mod stat;
+mod status;
 
 pub struct LockedPidDirINode(RwLock<PidDirINode>);
 
@@ -62,6 +64,9 @@ impl LockedPidDirINode {
         // stat
         let stat_inode = ProcStatINode::new(&file.process_ref);
         file.entries.insert(String::from("stat"), stat_inode);
+        // status
+        let status_inode = ProcStatusINode::new(&file.process_ref);
+        file.entries.insert(String::from("status"), status_inode);
         // maps
         let maps_inode = ProcMapsINode::new(&file.process_ref);
         file.entries.insert(String::from("maps"), maps_inode);
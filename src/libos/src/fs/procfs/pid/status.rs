@@ -0,0 +1,53 @@
+use super::*;
+
+pub struct ProcStatusINode(ProcessRef);
+
+const KB: usize = 1024;
+
+impl ProcStatusINode {
+    pub fn new(process_ref: &ProcessRef) -> Arc<dyn INode> {
+        Arc::new(File::new(Self(Arc::clone(process_ref))))
+    }
+}
+
+impl ProcINode for ProcStatusINode {
+    fn generate_data_in_bytes(&self) -> vfs::Result<Vec<u8>> {
+        let main_thread = self.0.main_thread().ok_or(FsError::EntryNotFound)?;
+        let name = String::from_utf8(main_thread.name().as_c_str().to_bytes().to_vec()).unwrap();
+        let state = match self.0.status() {
+            ProcessStatus::Running => "R (running)",
+            ProcessStatus::Stopped => "T (stopped)",
+            ProcessStatus::Zombie => "Z (zombie)",
+        };
+        let pid = self.0.pid();
+        let ppid = self.0.parent().pid();
+        let num_threads = self.0.threads().len();
+        let vm = main_thread.vm();
+        let vm_size = vm.get_process_range().size();
+        // The memory reclaimed by madvise and not used again, which are not in Linux
+        let (vm_discarded, vm_lazy_free) = vm.reclaim_stat().sizes();
+
+        let result = format!(
+            "Name:\t{}\n\
+             State:\t{}\n\
+             Tgid:\t{}\n\
+             Pid:\t{}\n\
+             PPid:\t{}\n\
+             Threads:\t{}\n\
+             VmSize:\t{:>8} kB\n\
+             VmDiscarded:\t{:>8} kB\n\
+             VmLazyFree:\t{:>8} kB\n",
+            name,
+            state,
+            pid,
+            pid,
+            ppid,
+            num_threads,
+            vm_size / KB,
+            vm_discarded / KB,
+            vm_lazy_free / KB,
+        )
+        .into_bytes();
+        Ok(result)
+    }
+}
@@ -0,0 +1,107 @@
+use super::*;
+use crate::ipc::{MSG_MANAGER, SEM_MANAGER, SHM_MANAGER};
+
+/// The directory of the System V IPC objects, i.e., /proc/sysvipc, read by `ipcs`
+pub struct LockedSysvIpcDirINode(RwLock<SysvIpcDirINode>);
+
+struct SysvIpcDirINode {
+    this: Weak<Dir<LockedSysvIpcDirINode>>,
+    // The parent is the root, which holds this directory
+    parent: Weak<dyn INode>,
+    entries: HashMap<String, Arc<dyn INode>>,
+}
+
+impl LockedSysvIpcDirINode {
+    pub fn new(parent: Weak<dyn INode>) -> Arc<dyn INode> {
+        let mut entries: HashMap<String, Arc<dyn INode>> = HashMap::new();
+        entries.insert(String::from("msg"), SysvIpcINode::new(SysvIpcKind::Msg));
+        entries.insert(String::from("sem"), SysvIpcINode::new(SysvIpcKind::Sem));
+        entries.insert(String::from("shm"), SysvIpcINode::new(SysvIpcKind::Shm));
+        let inode = Arc::new(Dir::new(Self(RwLock::new(SysvIpcDirINode {
+            this: Weak::default(),
+            parent,
+            entries,
+        }))));
+        inode.inner().0.write().unwrap().this = Arc::downgrade(&inode);
+        inode
+    }
+}
+
+impl DirProcINode for LockedSysvIpcDirINode {
+    fn find(&self, name: &str) -> vfs::Result<Arc<dyn INode>> {
+        let file = self.0.read().unwrap();
+        if name == "." {
+            return Ok(file.this.upgrade().unwrap());
+        }
+        if name == ".." {
+            return Ok(file.parent.upgrade().unwrap());
+        }
+        if let Some(inode) = file.entries.get(name) {
+            Ok(Arc::clone(inode))
+        } else {
+            Err(FsError::EntryNotFound)
+        }
+    }
+
+    fn get_entry(&self, id: usize) -> vfs::Result<String> {
+        match id {
+            0 => Ok(String::from(".")),
+            1 => Ok(String::from("..")),
+            i => {
+                let file = self.0.read().unwrap();
+                if let Some(name) = file.entries.keys().nth(i - 2) {
+                    Ok(name.to_owned())
+                } else {
+                    Err(FsError::EntryNotFound)
+                }
+            }
+        }
+    }
+
+    fn iterate_entries(&self, mut ctx: &mut DirentWriterContext) -> vfs::Result<usize> {
+        let file = self.0.read().unwrap();
+        let idx = ctx.pos();
+
+        // Write first two special entries
+        if idx == 0 {
+            let this_inode = file.this.upgrade().unwrap();
+            write_inode_entry!(&mut ctx, ".", &this_inode);
+        }
+        if idx <= 1 {
+            let parent_inode = file.parent.upgrade().unwrap();
+            write_inode_entry!(&mut ctx, "..", &parent_inode);
+        }
+
+        // Write the normal entries
+        let skipped = if idx < 2 { 0 } else { idx - 2 };
+        for (name, inode) in file.entries.iter().skip(skipped) {
+            write_inode_entry!(&mut ctx, name, inode);
+        }
+        Ok(ctx.written_len())
+    }
+}
+
+enum SysvIpcKind {
+    Msg,
+    Sem,
+    Shm,
+}
+
+struct SysvIpcINode(SysvIpcKind);
+
+impl SysvIpcINode {
+    fn new(kind: SysvIpcKind) -> Arc<dyn INode> {
+        Arc::new(File::new(Self(kind)))
+    }
+}
+
+impl ProcINode for SysvIpcINode {
+    fn generate_data_in_bytes(&self) -> vfs::Result<Vec<u8>> {
+        let info = match self.0 {
+            SysvIpcKind::Msg => MSG_MANAGER.proc_info(),
+            SysvIpcKind::Sem => SEM_MANAGER.proc_info(),
+            SysvIpcKind::Shm => SHM_MANAGER.proc_info(),
+        };
+        Ok(info.into_bytes())
+    }
+}
@@ -71,6 +71,9 @@ pub fn open_root_fs_according_to(
         open_or_create_sefs_according_to(&root_container_sefs_mount_config, user_key)?;
     // create UnionFS
     let root_unionfs = UnionFS::new(vec![root_container_sefs, root_image_sefs])?;
+    if root_mount_config.options.materialize {
+        root_unionfs.materialize_all()?;
+    }
     let root_mountable_unionfs = MountFS::new(root_unionfs);
     Ok(root_mountable_unionfs)
 }
@@ -170,6 +173,9 @@ pub fn mount_nonroot_fs_according_to(
                         return_errno!(EINVAL, "Unsupported fs type inside unionfs");
                     }
                 };
+                if mc.options.materialize {
+                    unionfs.materialize_all()?;
+                }
                 mount_fs_at(unionfs, root, &mc.target, follow_symlink)?;
             }
         }
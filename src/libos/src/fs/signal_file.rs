@@ -0,0 +1,288 @@
+use super::*;
+
+use crate::events::{Observer, Waiter, WaiterQueue};
+use crate::net::PollEventFlags;
+use crate::process::{Process, Thread};
+use crate::signal::{signalfd_siginfo_t, SigNum, SigSet, Signal, SIGKILL, SIGSTOP};
+use atomic::{Atomic, Ordering};
+use std::fmt;
+use std::sync::Weak;
+
+/// Signalfd, which dequeues the pending signals of the reader in batches
+///
+/// The signals read from a signalfd are never handled by deliver_signal, so no signal
+/// frame is built for them. As in Linux, a signalfd reads the signals of the thread
+/// that reads or polls it. The signal queues of each such thread and its process are
+/// observed once it does, so that a signal sent to it wakes it up.
+pub struct SignalFile {
+    inner: Arc<Inner>,
+    observed: SgxMutex<Observed>,
+    status_flags: Atomic<StatusFlags>,
+}
+
+// The part observing the signal queues
+struct Inner {
+    mask: Atomic<SigSet>,
+    notifier: IoNotifier,
+    readers: WaiterQueue,
+}
+
+// The threads and the processes whose signal queues are observed
+#[derive(Default)]
+struct Observed {
+    threads: Vec<Weak<Thread>>,
+    processes: Vec<Weak<Process>>,
+}
+
+impl SignalFile {
+    pub fn new(mask: SigSet, flags: SignalCreationFlags) -> Result<Self> {
+        let inner = Arc::new(Inner {
+            mask: Atomic::new(Self::valid_mask(mask)),
+            notifier: IoNotifier::new(),
+            readers: WaiterQueue::new(),
+        });
+        let status_flags = if flags.contains(SignalCreationFlags::SFD_NONBLOCK) {
+            StatusFlags::O_NONBLOCK
+        } else {
+            StatusFlags::empty()
+        };
+        let file = Self {
+            inner,
+            observed: SgxMutex::new(Observed::default()),
+            status_flags: Atomic::new(status_flags),
+        };
+        file.observe_current();
+        Ok(file)
+    }
+
+    pub fn set_mask(&self, mask: SigSet) {
+        self.inner
+            .mask
+            .store(Self::valid_mask(mask), Ordering::Release);
+        // The signals already pending may become readable
+        if !self.pending_signals().empty() {
+            self.inner.notifier.broadcast(&IoEvents::IN);
+            self.inner.readers.dequeue_and_wake_all();
+        }
+    }
+
+    fn valid_mask(mut mask: SigSet) -> SigSet {
+        // SIGKILL and SIGSTOP cannot be read from a signalfd, which are ignored silently
+        mask -= SIGKILL;
+        mask -= SIGSTOP;
+        mask
+    }
+
+    // Observe the signal queues of the current thread and its process, if they are
+    // not observed yet
+    fn observe_current(&self) {
+        let thread = current!();
+        let process = thread.process();
+        let weak_observer = Arc::downgrade(&self.inner) as Weak<dyn Observer<_>>;
+        let mut observed = self.observed.lock().unwrap();
+        if !observed
+            .threads
+            .iter()
+            .any(|weak| weak.as_ptr() == Arc::as_ptr(&thread))
+        {
+            observed.threads.retain(|weak| weak.strong_count() > 0);
+            thread.sig_queues().read().unwrap().notifier().register(
+                weak_observer.clone(),
+                None,
+                None,
+            );
+            observed.threads.push(Arc::downgrade(&thread));
+        }
+        if !observed
+            .processes
+            .iter()
+            .any(|weak| weak.as_ptr() == Arc::as_ptr(process))
+        {
+            observed.processes.retain(|weak| weak.strong_count() > 0);
+            process
+                .sig_queues()
+                .read()
+                .unwrap()
+                .notifier()
+                .register(weak_observer, None, None);
+            observed.processes.push(Arc::downgrade(process));
+        }
+    }
+
+    // The pending signals of the reader that are in the mask
+    fn pending_signals(&self) -> SigSet {
+        self.observe_current();
+        let thread = current!();
+        let pending = thread.process().sig_queues().read().unwrap().pending()
+            | thread.sig_queues().read().unwrap().pending();
+        pending & self.inner.mask.load(Ordering::Acquire)
+    }
+
+    fn dequeue_signals(&self, max_count: usize) -> Vec<Box<dyn Signal>> {
+        let blocked = !self.inner.mask.load(Ordering::Acquire);
+        let thread = current!();
+        // The signals of the process go first, as in sigtimedwait
+        let mut signals = thread
+            .process()
+            .sig_queues()
+            .write()
+            .unwrap()
+            .dequeue_batch(&blocked, max_count);
+        if signals.len() < max_count {
+            let thread_signals = thread
+                .sig_queues()
+                .write()
+                .unwrap()
+                .dequeue_batch(&blocked, max_count - signals.len());
+            signals.extend(thread_signals);
+        }
+        signals
+    }
+}
+
+impl Observer<SigNum> for Inner {
+    fn on_event(&self, signum: &SigNum, _metadata: &Option<Weak<dyn Any + Send + Sync>>) {
+        // Called with the lock of the signal queue held, so the queue is not checked here
+        if self.mask.load(Ordering::Acquire).contains(*signum) {
+            self.notifier.broadcast(&IoEvents::IN);
+            self.readers.dequeue_and_wake_all();
+        }
+    }
+}
+
+impl Drop for SignalFile {
+    fn drop(&mut self) {
+        let weak_observer = Arc::downgrade(&self.inner) as Weak<dyn Observer<_>>;
+        let observed = self.observed.lock().unwrap();
+        for thread in observed.threads.iter().filter_map(|weak| weak.upgrade()) {
+            thread
+                .sig_queues()
+                .read()
+                .unwrap()
+                .notifier()
+                .unregister(&weak_observer);
+        }
+        for process in observed.processes.iter().filter_map(|weak| weak.upgrade()) {
+            process
+                .sig_queues()
+                .read()
+                .unwrap()
+                .notifier()
+                .unregister(&weak_observer);
+        }
+    }
+}
+
+bitflags! {
+    pub struct SignalCreationFlags: i32 {
+        /// Non-blocking
+        const SFD_NONBLOCK  = 1 << 11;
+        /// Close on exec
+        const SFD_CLOEXEC   = 1 << 19;
+    }
+}
+
+impl File for SignalFile {
+    fn read(&self, buf: &mut [u8]) -> Result<usize> {
+        const SIGINFO_SIZE: usize = std::mem::size_of::<signalfd_siginfo_t>();
+        let max_count = buf.len() / SIGINFO_SIZE;
+        if max_count == 0 {
+            return_errno!(EINVAL, "the buffer is too small");
+        }
+
+        let waiter = Waiter::new();
+        loop {
+            // As many signals as the buffer can hold are read at once
+            let signals = self.dequeue_signals(max_count);
+            if !signals.is_empty() {
+                for (signal, bytes) in signals.iter().zip(buf.chunks_exact_mut(SIGINFO_SIZE)) {
+                    let siginfo = signalfd_siginfo_t::from_info(&signal.to_info());
+                    let siginfo_bytes = unsafe {
+                        std::slice::from_raw_parts(
+                            &siginfo as *const signalfd_siginfo_t as *const u8,
+                            SIGINFO_SIZE,
+                        )
+                    };
+                    bytes.copy_from_slice(siginfo_bytes);
+                }
+                return Ok(signals.len() * SIGINFO_SIZE);
+            }
+            if self
+                .status_flags
+                .load(Ordering::Acquire)
+                .contains(StatusFlags::O_NONBLOCK)
+            {
+                return_errno!(EAGAIN, "no pending signal in the mask");
+            }
+
+            self.inner.readers.reset_and_enqueue(&waiter);
+            // Check again in case that a signal arrives before the waiter is enqueued
+            let res = if self.pending_signals().empty() {
+                waiter.wait(None)
+            } else {
+                Ok(())
+            };
+            self.inner.readers.dequeue(&waiter);
+            res?;
+        }
+    }
+
+    fn access_mode(&self) -> Result<AccessMode> {
+        Ok(AccessMode::O_RDWR)
+    }
+
+    fn status_flags(&self) -> Result<StatusFlags> {
+        Ok(self.status_flags.load(Ordering::Acquire))
+    }
+
+    fn set_status_flags(&self, new_status_flags: StatusFlags) -> Result<()> {
+        self.status_flags
+            .store(new_status_flags & STATUS_FLAGS_MASK, Ordering::Release);
+        Ok(())
+    }
+
+    fn poll(&self) -> Result<PollEventFlags> {
+        let events = if self.pending_signals().empty() {
+            PollEventFlags::empty()
+        } else {
+            PollEventFlags::POLLIN
+        };
+        Ok(events)
+    }
+
+    fn poll_new(&self) -> IoEvents {
+        if self.pending_signals().empty() {
+            IoEvents::empty()
+        } else {
+            IoEvents::IN
+        }
+    }
+
+    fn notifier(&self) -> Option<&IoNotifier> {
+        Some(&self.inner.notifier)
+    }
+
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+}
+
+impl fmt::Debug for SignalFile {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("SignalFile")
+            .field("mask", &self.inner.mask.load(Ordering::Relaxed))
+            .finish()
+    }
+}
+
+pub trait AsSignalFile {
+    fn as_signal_file(&self) -> Result<&SignalFile>;
+}
+
+impl AsSignalFile for FileRef {
+    fn as_signal_file(&self) -> Result<&SignalFile> {
+        self.as_any()
+            .downcast_ref::<SignalFile>()
+            .ok_or_else(|| errno!(EINVAL, "not a signal file"))
+    }
+}
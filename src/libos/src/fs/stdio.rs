@@ -1,4 +1,6 @@
 use super::*;
+use crate::events::Waiter;
+use crate::process::task::is_vcpu_enabled;
 use core::cell::RefCell;
 use core::cmp;
 use std::io::{BufReader, LineWriter};
@@ -302,10 +304,32 @@ impl StdinFile {
     fn host_fd(&self) -> FileDesc {
         self.host_fd
     }
+
+    // In the M:N mode, wait until the host stdin is readable if nothing is buffered, so
+    // that a blocking read does not block the vCPU in the host. The lock is not held
+    // while waiting, as the other threads on the vCPU may need it.
+    fn wait_readable(&self) -> Result<()> {
+        if !is_vcpu_enabled() || !self.inner.lock().unwrap().buffer().is_empty() {
+            return Ok(());
+        }
+        if self.status_flags()?.contains(StatusFlags::O_NONBLOCK) {
+            return Ok(());
+        }
+
+        let mut pollfds = [libc::pollfd {
+            fd: self.host_fd as i32,
+            events: libc::POLLIN,
+            revents: 0,
+        }];
+        // Nobody wakes up the waiter
+        Waiter::new().wait_host_fds(&mut pollfds, None)?;
+        Ok(())
+    }
 }
 
 impl File for StdinFile {
     fn read(&self, buf: &mut [u8]) -> Result<usize> {
+        self.wait_readable()?;
         let read_len = {
             self.inner
                 .lock()
@@ -317,6 +341,7 @@ impl File for StdinFile {
     }
 
     fn readv(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        self.wait_readable()?;
         let mut guard = self.inner.lock().unwrap();
         let mut total_bytes = 0;
         for buf in bufs {
@@ -1,3 +1,4 @@
+use super::aio::{self, aio_context_t, io_event_t, iocb_t};
 use super::event_file::EventCreationFlags;
 use super::file_ops;
 use super::file_ops::{
@@ -6,10 +7,13 @@ use super::file_ops::{
 };
 use super::fs_ops;
 use super::fs_ops::{MountFlags, MountOptions, UmountFlags};
+use super::io_uring::{self, io_uring_params};
+use super::signal_file::SignalCreationFlags;
 use super::time::{clockid_t, itimerspec_t, timespec_t, timeval_t, ClockID};
 use super::timer_file::{TimerCreationFlags, TimerSetFlags};
 use super::*;
 use crate::config::{user_rootfs_config, ConfigApp, ConfigMountFsType};
+use crate::signal::{sigset_t, SigSet};
 use util::mem_util::from_user;
 
 #[allow(non_camel_case_types)]
@@ -44,7 +48,7 @@ pub fn do_timerfd_create(clockid: clockid_t, flags: i32) -> Result<isize> {
 
     let clockid = ClockID::from_raw(clockid)?;
     match clockid {
-        ClockID::CLOCK_REALTIME | ClockID::CLOCK_MONOTONIC => {}
+        ClockID::CLOCK_REALTIME | ClockID::CLOCK_MONOTONIC | ClockID::CLOCK_BOOTTIME => {}
         _ => {
             return_errno!(EINVAL, "invalid clockid");
         }
@@ -99,6 +103,153 @@ pub fn do_timerfd_gettime(fd: FileDesc, curr_value_ptr: *mut itimerspec_t) -> Re
     Ok(0)
 }
 
+pub fn do_signalfd(fd: c_int, mask_ptr: *const sigset_t, sizemask: usize) -> Result<isize> {
+    do_signalfd4(fd, mask_ptr, sizemask, 0)
+}
+
+pub fn do_signalfd4(
+    fd: c_int,
+    mask_ptr: *const sigset_t,
+    sizemask: usize,
+    flags: i32,
+) -> Result<isize> {
+    debug!("signalfd: fd: {}, flags: {:#x}", fd, flags);
+    if sizemask != std::mem::size_of::<sigset_t>() {
+        return_errno!(EINVAL, "unexpected sigset size");
+    }
+    from_user::check_ptr(mask_ptr)?;
+    let mask = SigSet::from_c(unsafe { mask_ptr.read() });
+    let signal_flags =
+        SignalCreationFlags::from_bits(flags).ok_or_else(|| errno!(EINVAL, "invalid flags"))?;
+
+    // An existing signalfd only gets the new mask
+    if fd != -1 {
+        let file = current!().file(fd as FileDesc)?;
+        file.as_signal_file()?.set_mask(mask);
+        return Ok(fd as isize);
+    }
+
+    let file_ref: Arc<dyn File> = Arc::new(SignalFile::new(mask, signal_flags)?);
+    let fd = current!().add_file(
+        file_ref,
+        signal_flags.contains(SignalCreationFlags::SFD_CLOEXEC),
+    );
+    Ok(fd as isize)
+}
+
+pub fn do_memfd_create(name: *const i8, flags: u32) -> Result<isize> {
+    // The name is shown as the target of /proc/self/fd, prefixed by "memfd:"
+    const MFD_NAME_MAX_LEN: usize = 249;
+    const MFD_CLOEXEC: u32 = 0x1;
+    const MFD_ALLOW_SEALING: u32 = 0x2;
+    // The huge pages are not supported by SGX, so the flags of them are ignored
+    const MFD_HUGETLB: u32 = 0x4;
+    const MFD_HUGE_MASK: u32 = 0x3f << 26;
+
+    let name = from_user::clone_cstring_safely(name)?
+        .to_string_lossy()
+        .into_owned();
+    debug!("memfd_create: name: {:?}, flags: {:#x}", name, flags);
+    if name.len() > MFD_NAME_MAX_LEN {
+        return_errno!(EINVAL, "the name is too long");
+    }
+    if flags & !(MFD_CLOEXEC | MFD_ALLOW_SEALING | MFD_HUGETLB | MFD_HUGE_MASK) != 0 {
+        return_errno!(EINVAL, "invalid flags");
+    }
+
+    let inode = tmpfs::new_memfd_inode(flags & MFD_ALLOW_SEALING != 0);
+    let abs_path = format!("/memfd:{} (deleted)", name);
+    let file_ref: Arc<dyn File> = Arc::new(INodeFile::open(inode, &abs_path, libc::O_RDWR as u32)?);
+    let fd = current!().add_file(file_ref, flags & MFD_CLOEXEC != 0);
+    Ok(fd as isize)
+}
+
+pub fn do_io_setup(nr_events: u32, ctx_ptr: *mut aio_context_t) -> Result<isize> {
+    from_user::check_mut_ptr(ctx_ptr)?;
+    if unsafe { ctx_ptr.read() } != 0 {
+        return_errno!(EINVAL, "the context must be initialized to zero");
+    }
+    let ctx = aio::do_io_setup(nr_events)?;
+    unsafe {
+        ctx_ptr.write(ctx);
+    }
+    Ok(0)
+}
+
+pub fn do_io_destroy(ctx: aio_context_t) -> Result<isize> {
+    aio::do_io_destroy(ctx)?;
+    Ok(0)
+}
+
+pub fn do_io_submit(ctx: aio_context_t, nr: i64, iocbs_ptr: *const *const iocb_t) -> Result<isize> {
+    if nr < 0 {
+        return_errno!(EINVAL, "nr must not be negative");
+    }
+    from_user::check_array(iocbs_ptr, nr as usize)?;
+    let iocbs = unsafe { std::slice::from_raw_parts(iocbs_ptr, nr as usize) };
+    let nr_submitted = aio::do_io_submit(ctx, iocbs)?;
+    Ok(nr_submitted as isize)
+}
+
+pub fn do_io_getevents(
+    ctx: aio_context_t,
+    min_nr: i64,
+    nr: i64,
+    events_ptr: *mut io_event_t,
+    timeout_ptr: *const timespec_t,
+) -> Result<isize> {
+    if min_nr < 0 || nr < 0 {
+        return_errno!(EINVAL, "min_nr and nr must not be negative");
+    }
+    from_user::check_mut_array(events_ptr, nr as usize)?;
+    let events = unsafe { std::slice::from_raw_parts_mut(events_ptr, nr as usize) };
+    let mut timeout = if timeout_ptr.is_null() {
+        None
+    } else {
+        from_user::check_ptr(timeout_ptr)?;
+        Some(timespec_t::from_raw_ptr(timeout_ptr)?.as_duration())
+    };
+    let nr_events = aio::do_io_getevents(ctx, min_nr as usize, events, timeout.as_mut())?;
+    Ok(nr_events as isize)
+}
+
+pub fn do_io_cancel(
+    ctx: aio_context_t,
+    iocb_ptr: *const iocb_t,
+    result_ptr: *mut io_event_t,
+) -> Result<isize> {
+    from_user::check_ptr(iocb_ptr)?;
+    from_user::check_mut_ptr(result_ptr)?;
+    aio::do_io_cancel(ctx, unsafe { &*iocb_ptr })?;
+    Ok(0)
+}
+
+pub fn do_io_uring_setup(entries: u32, params_ptr: *mut io_uring_params) -> Result<isize> {
+    from_user::check_mut_ptr(params_ptr)?;
+    let mut params = unsafe { params_ptr.read() };
+    let file_ref = io_uring::do_io_uring_setup(entries, &mut params)?;
+    unsafe {
+        params_ptr.write(params);
+    }
+    let fd = current!().add_file(file_ref, true);
+    Ok(fd as isize)
+}
+
+pub fn do_io_uring_enter(
+    fd: FileDesc,
+    to_submit: u32,
+    min_complete: u32,
+    flags: u32,
+    sigmask: *const c_void,
+    sigmask_size: size_t,
+) -> Result<isize> {
+    if !sigmask.is_null() {
+        warn!("io_uring_enter sigmask is not supported!");
+    }
+    let nr_submitted = io_uring::do_io_uring_enter(fd, to_submit, min_complete, flags)?;
+    Ok(nr_submitted as isize)
+}
+
 pub fn do_creat(path: *const i8, mode: u16) -> Result<isize> {
     let flags =
         AccessMode::O_WRONLY as u32 | (CreationFlags::O_CREAT | CreationFlags::O_TRUNC).bits();
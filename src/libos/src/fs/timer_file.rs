@@ -1,65 +1,76 @@
 use super::*;
 
-use crate::time::{clockid_t, itimerspec_t, timespec_t, ClockID};
+use crate::events::{Waiter, WaiterQueue};
+use crate::net::PollEventFlags;
+use crate::time::{itimerspec_t, ClockID, Timer};
 use atomic::{Atomic, Ordering};
-use std::time::Duration;
+use std::fmt;
+use std::sync::atomic::AtomicU64;
 
-/// Native Linux timerfd
-#[derive(Debug)]
+/// Timerfd, whose timer is on the timer wheel of the LibOS
 pub struct TimerFile {
-    host_fd: HostFd,
-    host_events: Atomic<IoEvents>,
+    clockid: ClockID,
+    timer: Timer,
+    inner: Arc<Inner>,
+    status_flags: Atomic<StatusFlags>,
+}
+
+// The part shared with the callback of the timer
+struct Inner {
+    // The number of expirations since the last read
+    expirations: AtomicU64,
     notifier: IoNotifier,
+    readers: WaiterQueue,
 }
 
 impl TimerFile {
     pub fn new(clockid: ClockID, flags: TimerCreationFlags) -> Result<Self> {
-        let raw_host_fd = try_libc!({
-            let mut ret: i32 = 0;
-            let status = occlum_ocall_timerfd_create(&mut ret, clockid as clockid_t, flags.bits());
-            assert!(status == sgx_status_t::SGX_SUCCESS);
-            ret
-        }) as FileDesc;
-        let host_fd = HostFd::new(raw_host_fd);
-        let host_events = Atomic::new(IoEvents::empty());
-        let notifier = IoNotifier::new();
+        let inner = Arc::new(Inner {
+            expirations: AtomicU64::new(0),
+            notifier: IoNotifier::new(),
+            readers: WaiterQueue::new(),
+        });
+        let timer = {
+            let inner = inner.clone();
+            Timer::new(move |expirations| inner.expire(expirations))
+        };
+        let status_flags = if flags.contains(TimerCreationFlags::TFD_NONBLOCK) {
+            StatusFlags::O_NONBLOCK
+        } else {
+            StatusFlags::empty()
+        };
         Ok(Self {
-            host_fd,
-            host_events,
-            notifier,
+            clockid,
+            timer,
+            inner,
+            status_flags: Atomic::new(status_flags),
         })
     }
 
-    pub fn host_fd(&self) -> c_int {
-        self.host_fd.to_raw() as c_int
-    }
-
     pub fn set_time(&self, flags: TimerSetFlags, new_value: &itimerspec_t) -> Result<itimerspec_t> {
-        let mut ret = 0;
-        let mut old_value: itimerspec_t = Default::default();
-        let fd = self.host_fd() as FileDesc;
-        let sgx_status = unsafe {
-            occlum_ocall_timerfd_settime(&mut ret, fd, flags.bits(), new_value, &mut old_value)
-        };
-        assert!(sgx_status == sgx_status_t::SGX_SUCCESS);
-        assert!(ret == 0 || libc::errno() == Errno::EINTR as i32);
-        if ret != 0 {
-            return_errno!(EINTR, "settime interrupted");
-        }
-        Ok(old_value)
+        // The expirations of the previous setting are discarded. As the real-time clock
+        // is not changed by the LibOS, TFD_TIMER_CANCEL_ON_SET takes no effect.
+        self.inner.expirations.store(0, Ordering::SeqCst);
+        let (value, interval) = self.timer.set(
+            self.clockid,
+            flags.contains(TimerSetFlags::TFD_TIMER_ABSTIME),
+            new_value.it_value().as_duration(),
+            new_value.it_interval().as_duration(),
+        )?;
+        Ok(itimerspec_t::new(interval.into(), value.into()))
     }
 
     pub fn time(&self) -> Result<itimerspec_t> {
-        let mut ret = 0;
-        let mut curr_value: itimerspec_t = Default::default();
-        let fd = self.host_fd() as FileDesc;
-        let sgx_status = unsafe { occlum_ocall_timerfd_gettime(&mut ret, fd, &mut curr_value) };
-        assert!(sgx_status == sgx_status_t::SGX_SUCCESS);
-        assert!(ret == 0 || libc::errno() == Errno::EINTR as i32);
-        if ret != 0 {
-            return_errno!(EINTR, "gettime interrupted");
-        }
-        Ok(curr_value)
+        let (value, interval) = self.timer.get();
+        Ok(itimerspec_t::new(interval.into(), value.into()))
+    }
+}
+
+impl Inner {
+    fn expire(&self, expirations: u64) {
+        self.expirations.fetch_add(expirations, Ordering::SeqCst);
+        self.notifier.broadcast(&IoEvents::IN);
+        self.readers.dequeue_and_wake_all();
     }
 }
 
@@ -80,39 +91,38 @@ bitflags! {
     }
 }
 
-extern "C" {
-    fn occlum_ocall_timerfd_create(ret: *mut i32, clockid: i32, flags: i32) -> sgx_status_t;
-}
-
-extern "C" {
-    fn occlum_ocall_timerfd_settime(
-        ret: *mut i32,
-        fd: u32,
-        flags: i32,
-        new_value: *const itimerspec_t,
-        old_value: *mut itimerspec_t,
-    ) -> sgx_status_t;
-}
-
-extern "C" {
-    fn occlum_ocall_timerfd_gettime(
-        ret: *mut i32,
-        fd: u32,
-        curr_value: *mut itimerspec_t,
-    ) -> sgx_status_t;
-}
-
 impl File for TimerFile {
     fn read(&self, buf: &mut [u8]) -> Result<usize> {
-        let (buf_ptr, buf_len) = buf.as_mut().as_mut_ptr_and_len();
+        const COUNT_SIZE: usize = std::mem::size_of::<u64>();
+        if buf.len() < COUNT_SIZE {
+            return_errno!(EINVAL, "the buffer is too small");
+        }
 
-        let ret = try_libc!(libc::ocall::read(
-            self.host_fd.to_raw() as i32,
-            buf_ptr as *mut c_void,
-            buf_len
-        )) as usize;
-        assert!(ret <= buf.len());
-        Ok(ret)
+        let waiter = Waiter::new();
+        loop {
+            let expirations = self.inner.expirations.swap(0, Ordering::SeqCst);
+            if expirations > 0 {
+                buf[..COUNT_SIZE].copy_from_slice(&expirations.to_ne_bytes());
+                return Ok(COUNT_SIZE);
+            }
+            if self
+                .status_flags
+                .load(Ordering::Acquire)
+                .contains(StatusFlags::O_NONBLOCK)
+            {
+                return_errno!(EAGAIN, "the timer has not expired");
+            }
+
+            self.inner.readers.reset_and_enqueue(&waiter);
+            // Check again in case that the timer expires before the waiter is enqueued
+            let res = if self.inner.expirations.load(Ordering::SeqCst) == 0 {
+                waiter.wait(None)
+            } else {
+                Ok(())
+            };
+            self.inner.readers.dequeue(&waiter);
+            res?;
+        }
     }
 
     // TODO: implement ioctl
@@ -125,38 +135,34 @@ impl File for TimerFile {
     }
 
     fn status_flags(&self) -> Result<StatusFlags> {
-        let ret = try_libc!(libc::ocall::fcntl_arg0(self.host_fd(), libc::F_GETFL));
-        Ok(StatusFlags::from_bits_truncate(ret as u32))
+        Ok(self.status_flags.load(Ordering::Acquire))
     }
 
     fn set_status_flags(&self, new_status_flags: StatusFlags) -> Result<()> {
-        let raw_status_flags = (new_status_flags & STATUS_FLAGS_MASK).bits();
-        try_libc!(libc::ocall::fcntl_arg1(
-            self.host_fd(),
-            libc::F_SETFL,
-            raw_status_flags as c_int
-        ));
+        self.status_flags
+            .store(new_status_flags & STATUS_FLAGS_MASK, Ordering::Release);
         Ok(())
     }
 
-    fn poll_new(&self) -> IoEvents {
-        self.host_events.load(Ordering::Acquire)
-    }
-
-    fn notifier(&self) -> Option<&IoNotifier> {
-        Some(&self.notifier)
+    fn poll(&self) -> Result<PollEventFlags> {
+        let events = if self.inner.expirations.load(Ordering::SeqCst) > 0 {
+            PollEventFlags::POLLIN
+        } else {
+            PollEventFlags::empty()
+        };
+        Ok(events)
     }
 
-    fn host_fd(&self) -> Option<&HostFd> {
-        Some(&self.host_fd)
+    fn poll_new(&self) -> IoEvents {
+        if self.inner.expirations.load(Ordering::SeqCst) > 0 {
+            IoEvents::IN
+        } else {
+            IoEvents::empty()
+        }
     }
 
-    fn update_host_events(&self, ready: &IoEvents, mask: &IoEvents, trigger_notifier: bool) {
-        self.host_events.update(ready, mask, Ordering::Release);
-
-        if trigger_notifier {
-            self.notifier.broadcast(ready);
-        }
+    fn notifier(&self) -> Option<&IoNotifier> {
+        Some(&self.inner.notifier)
     }
 
     fn as_any(&self) -> &dyn Any {
@@ -164,6 +170,16 @@ impl File for TimerFile {
     }
 }
 
+impl fmt::Debug for TimerFile {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("TimerFile")
+            .field("clockid", &self.clockid)
+            .field("timer", &self.timer)
+            .field("expirations", &self.inner.expirations)
+            .finish()
+    }
+}
+
 pub trait AsTimer {
     fn as_timer(&self) -> Result<&TimerFile>;
 }
@@ -0,0 +1,440 @@
+//! A file system in the memory, whose files are backed by shared memory, i.e., /dev/shm
+//! and memfd.
+//!
+//! The pages of a file are mapped by every shared mapping of the file, instead of
+//! copied into the mappings. The file system is flat, as the names of POSIX shared
+//! memory objects are.
+
+use super::*;
+
+use crate::vm::{SharedMapping, SharedMem, VMPerms, USER_SPACE_VM_MANAGER};
+use rcore_fs::vfs::{self, FsInfo};
+use rcore_fs_mountfs::MNode;
+use std::collections::BTreeMap;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Weak;
+
+/// magic number for tmpfs
+pub const TMPFS_MAGIC: usize = 0x0102_1994;
+const MAX_FNAME_LEN: usize = 255;
+const BLKSIZE: usize = 4096;
+
+lazy_static! {
+    /// The hidden file system of memfd, whose files are not in any directory
+    static ref MEMFD_FS: Arc<TmpFS> = TmpFS::new();
+}
+
+pub struct TmpFS {
+    root: Arc<TmpDirINode>,
+    next_inode_id: AtomicUsize,
+}
+
+impl FileSystem for TmpFS {
+    fn sync(&self) -> vfs::Result<()> {
+        Ok(())
+    }
+
+    fn root_inode(&self) -> Arc<dyn INode> {
+        Arc::clone(&self.root) as _
+    }
+
+    fn info(&self) -> FsInfo {
+        // The files share the user space with the processes
+        let blocks = USER_SPACE_VM_MANAGER.get_total_size() / BLKSIZE;
+        let bfree = USER_SPACE_VM_MANAGER.free_size() / BLKSIZE;
+        FsInfo {
+            magic: TMPFS_MAGIC,
+            bsize: BLKSIZE,
+            frsize: BLKSIZE,
+            blocks,
+            bfree,
+            bavail: bfree,
+            files: 0,
+            ffree: 0,
+            namemax: MAX_FNAME_LEN,
+        }
+    }
+}
+
+impl TmpFS {
+    pub fn new() -> Arc<Self> {
+        let root = Arc::new(TmpDirINode(RwLock::new(TmpDir {
+            this: Weak::default(),
+            children: BTreeMap::new(),
+            metadata: new_metadata(0, FileType::Dir, 0o1777),
+            fs: Weak::default(),
+        })));
+        let fs = Arc::new(TmpFS {
+            root,
+            next_inode_id: AtomicUsize::new(1),
+        });
+        let mut root = fs.root.0.write().unwrap();
+        root.this = Arc::downgrade(&fs.root);
+        root.fs = Arc::downgrade(&fs);
+        root.metadata.inode = fs.alloc_inode_id();
+        drop(root);
+        fs
+    }
+
+    /// Allocate an INode ID
+    fn alloc_inode_id(&self) -> usize {
+        self.next_inode_id.fetch_add(1, Ordering::SeqCst)
+    }
+
+    fn new_file(self: &Arc<Self>, mode: u16, seals: FileSeals) -> Arc<TmpFileINode> {
+        Arc::new(TmpFileINode {
+            mem: Arc::new(SharedMem::new()),
+            seals: SgxMutex::new(seals),
+            metadata: RwLock::new(new_metadata(self.alloc_inode_id(), FileType::File, mode)),
+            fs: Arc::downgrade(self),
+        })
+    }
+}
+
+/// Create the file of memfd, which can be sealed if allowed
+pub fn new_memfd_inode(allow_sealing: bool) -> Arc<dyn INode> {
+    let seals = if allow_sealing {
+        FileSeals::empty()
+    } else {
+        FileSeals::F_SEAL_SEAL
+    };
+    MEMFD_FS.new_file(0o777, seals)
+}
+
+fn new_metadata(inode: usize, type_: FileType, mode: u16) -> Metadata {
+    Metadata {
+        dev: 0,
+        inode,
+        size: 0,
+        blk_size: BLKSIZE,
+        blocks: 0,
+        atime: Timespec { sec: 0, nsec: 0 },
+        mtime: Timespec { sec: 0, nsec: 0 },
+        ctime: Timespec { sec: 0, nsec: 0 },
+        type_,
+        mode,
+        nlinks: 1,
+        uid: 0,
+        gid: 0,
+        rdev: 0,
+    }
+}
+
+struct TmpDir {
+    /// Reference to myself, which is also the parent
+    this: Weak<TmpDirINode>,
+    children: BTreeMap<String, Arc<TmpFileINode>>,
+    metadata: Metadata,
+    fs: Weak<TmpFS>,
+}
+
+struct TmpDirINode(RwLock<TmpDir>);
+
+impl INode for TmpDirINode {
+    fn read_at(&self, _offset: usize, _buf: &mut [u8]) -> vfs::Result<usize> {
+        Err(FsError::NotFile)
+    }
+
+    fn write_at(&self, _offset: usize, _buf: &[u8]) -> vfs::Result<usize> {
+        Err(FsError::NotFile)
+    }
+
+    fn metadata(&self) -> vfs::Result<Metadata> {
+        let dir = self.0.read().unwrap();
+        let mut metadata = dir.metadata.clone();
+        metadata.size = dir.children.len();
+        Ok(metadata)
+    }
+
+    fn set_metadata(&self, metadata: &Metadata) -> vfs::Result<()> {
+        let mut dir = self.0.write().unwrap();
+        set_metadata(&mut dir.metadata, metadata);
+        Ok(())
+    }
+
+    fn create2(
+        &self,
+        name: &str,
+        type_: FileType,
+        mode: u16,
+        _data: usize,
+    ) -> vfs::Result<Arc<dyn INode>> {
+        let mut dir = self.0.write().unwrap();
+        if name == "." || name == ".." || name.is_empty() {
+            return Err(FsError::EntryExist);
+        }
+        if dir.children.contains_key(name) {
+            return Err(FsError::EntryExist);
+        }
+        if type_ != FileType::File {
+            return Err(FsError::PermError);
+        }
+        // The files out of memfd cannot be sealed
+        let file = dir
+            .fs
+            .upgrade()
+            .unwrap()
+            .new_file(mode, FileSeals::F_SEAL_SEAL);
+        dir.children.insert(String::from(name), Arc::clone(&file));
+        Ok(file)
+    }
+
+    fn link(&self, name: &str, other: &Arc<dyn INode>) -> vfs::Result<()> {
+        let other = other
+            .downcast_ref::<TmpFileINode>()
+            .ok_or(FsError::NotSameFs)?;
+        let mut dir = self.0.write().unwrap();
+        if name == "." || name == ".." || name.is_empty() {
+            return Err(FsError::EntryExist);
+        }
+        if dir.children.contains_key(name) {
+            return Err(FsError::EntryExist);
+        }
+        let other = dir
+            .children
+            .values()
+            .find(|file| std::ptr::eq(file.as_ref(), other))
+            .cloned()
+            .ok_or(FsError::NotSameFs)?;
+        other.metadata.write().unwrap().nlinks += 1;
+        dir.children.insert(String::from(name), other);
+        Ok(())
+    }
+
+    fn unlink(&self, name: &str) -> vfs::Result<()> {
+        if name == "." || name == ".." || name.is_empty() {
+            return Err(FsError::IsDir);
+        }
+        let mut dir = self.0.write().unwrap();
+        let file = dir.children.remove(name).ok_or(FsError::EntryNotFound)?;
+        file.metadata.write().unwrap().nlinks -= 1;
+        Ok(())
+    }
+
+    fn move_(&self, old_name: &str, target: &Arc<dyn INode>, new_name: &str) -> vfs::Result<()> {
+        if old_name == "." || old_name == ".." || old_name.is_empty() {
+            return Err(FsError::IsDir);
+        }
+        if new_name == "." || new_name == ".." || new_name.is_empty() {
+            return Err(FsError::IsDir);
+        }
+        let target = target
+            .downcast_ref::<TmpDirINode>()
+            .ok_or(FsError::NotSameFs)?;
+        // There is only one directory in the file system
+        if !std::ptr::eq(self, target) {
+            return Err(FsError::NotSameFs);
+        }
+        let mut dir = self.0.write().unwrap();
+        let file = dir
+            .children
+            .remove(old_name)
+            .ok_or(FsError::EntryNotFound)?;
+        if let Some(replaced) = dir.children.insert(String::from(new_name), file) {
+            replaced.metadata.write().unwrap().nlinks -= 1;
+        }
+        Ok(())
+    }
+
+    fn find(&self, name: &str) -> vfs::Result<Arc<dyn INode>> {
+        let dir = self.0.read().unwrap();
+        match name {
+            "." | "" | ".." => Ok(dir.this.upgrade().ok_or(FsError::EntryNotFound)?),
+            name => {
+                let file = dir.children.get(name).ok_or(FsError::EntryNotFound)?;
+                Ok(Arc::clone(file) as Arc<dyn INode>)
+            }
+        }
+    }
+
+    fn get_entry(&self, id: usize) -> vfs::Result<String> {
+        match id {
+            0 => Ok(String::from(".")),
+            1 => Ok(String::from("..")),
+            i => {
+                let dir = self.0.read().unwrap();
+                if let Some(name) = dir.children.keys().nth(i - 2) {
+                    Ok(name.to_owned())
+                } else {
+                    Err(FsError::EntryNotFound)
+                }
+            }
+        }
+    }
+
+    fn iterate_entries(&self, mut ctx: &mut DirentWriterContext) -> vfs::Result<usize> {
+        let dir = self.0.read().unwrap();
+        let idx = ctx.pos();
+        // Write the two special entries
+        if idx <= 1 {
+            let this_inode = dir.this.upgrade().unwrap();
+            if idx == 0 {
+                rcore_fs::write_inode_entry!(&mut ctx, ".", &this_inode);
+            }
+            rcore_fs::write_inode_entry!(&mut ctx, "..", &this_inode);
+        }
+        // Write the normal entries
+        let skipped = if idx < 2 { 0 } else { idx - 2 };
+        for (name, inode) in dir.children.iter().skip(skipped) {
+            rcore_fs::write_inode_entry!(&mut ctx, name, inode);
+        }
+        Ok(ctx.written_len())
+    }
+
+    fn fs(&self) -> Arc<dyn FileSystem> {
+        self.0.read().unwrap().fs.upgrade().unwrap()
+    }
+
+    fn as_any_ref(&self) -> &dyn Any {
+        self
+    }
+}
+
+bitflags! {
+    /// The seals of a file, which restrict the operations on it
+    pub struct FileSeals: u32 {
+        /// The seals cannot be changed
+        const F_SEAL_SEAL = 0x1;
+        /// The file cannot shrink
+        const F_SEAL_SHRINK = 0x2;
+        /// The file cannot grow
+        const F_SEAL_GROW = 0x4;
+        /// The file cannot be written
+        const F_SEAL_WRITE = 0x8;
+        /// The file cannot be written, except by the existing writable mappings
+        const F_SEAL_FUTURE_WRITE = 0x10;
+    }
+}
+
+impl FileSeals {
+    fn can_write(&self) -> bool {
+        !self.intersects(FileSeals::F_SEAL_WRITE | FileSeals::F_SEAL_FUTURE_WRITE)
+    }
+}
+
+pub struct TmpFileINode {
+    mem: Arc<SharedMem>,
+    // The lock is held to check the seals until the operation is done
+    seals: SgxMutex<FileSeals>,
+    // The size is that of the shared memory
+    metadata: RwLock<Metadata>,
+    fs: Weak<TmpFS>,
+}
+
+impl TmpFileINode {
+    pub fn seals(&self) -> FileSeals {
+        *self.seals.lock().unwrap()
+    }
+
+    pub fn add_seals(&self, new_seals: FileSeals) -> Result<()> {
+        let mut seals = self.seals.lock().unwrap();
+        if seals.contains(FileSeals::F_SEAL_SEAL) {
+            return_errno!(EPERM, "the seals are sealed");
+        }
+        if new_seals.contains(FileSeals::F_SEAL_WRITE)
+            && !seals.contains(FileSeals::F_SEAL_WRITE)
+            && self.mem.nr_writable_mappings() > 0
+        {
+            return_errno!(EBUSY, "the file has writable shared mappings");
+        }
+        *seals |= new_seals;
+        Ok(())
+    }
+
+    /// Map the pages of the file shared, which requires the file to be writable if
+    /// the mapping is writable
+    pub fn mmap(&self, offset: usize, size: usize, perms: VMPerms) -> Result<SharedMapping> {
+        let seals = self.seals.lock().unwrap();
+        if perms.can_write() && !seals.can_write() {
+            return_errno!(EPERM, "the file is sealed for writes");
+        }
+        self.mem.map(offset, size, perms)
+    }
+}
+
+impl INode for TmpFileINode {
+    fn read_at(&self, offset: usize, buf: &mut [u8]) -> vfs::Result<usize> {
+        Ok(self.mem.read_at(offset, buf))
+    }
+
+    fn write_at(&self, offset: usize, buf: &[u8]) -> vfs::Result<usize> {
+        let seals = self.seals.lock().unwrap();
+        if !seals.can_write() {
+            return Err(FsError::PermError);
+        }
+        if seals.contains(FileSeals::F_SEAL_GROW)
+            && offset.saturating_add(buf.len()) > self.mem.len()
+        {
+            return Err(FsError::PermError);
+        }
+        self.mem
+            .write_at(offset, buf)
+            .map_err(|_| FsError::NoDeviceSpace)
+    }
+
+    fn metadata(&self) -> vfs::Result<Metadata> {
+        let mut metadata = self.metadata.read().unwrap().clone();
+        metadata.size = self.mem.len();
+        metadata.blocks = align_up(metadata.size, BLKSIZE) / 512;
+        Ok(metadata)
+    }
+
+    fn set_metadata(&self, metadata: &Metadata) -> vfs::Result<()> {
+        set_metadata(&mut self.metadata.write().unwrap(), metadata);
+        Ok(())
+    }
+
+    fn sync_all(&self) -> vfs::Result<()> {
+        Ok(())
+    }
+
+    fn sync_data(&self) -> vfs::Result<()> {
+        Ok(())
+    }
+
+    fn resize(&self, len: usize) -> vfs::Result<()> {
+        let seals = self.seals.lock().unwrap();
+        let old_len = self.mem.len();
+        if (len < old_len && seals.contains(FileSeals::F_SEAL_SHRINK))
+            || (len > old_len && seals.contains(FileSeals::F_SEAL_GROW))
+        {
+            return Err(FsError::PermError);
+        }
+        self.mem.resize(len).map_err(|_| FsError::NoDeviceSpace)
+    }
+
+    fn fs(&self) -> Arc<dyn FileSystem> {
+        self.fs.upgrade().unwrap()
+    }
+
+    fn as_any_ref(&self) -> &dyn Any {
+        self
+    }
+}
+
+fn set_metadata(old: &mut Metadata, new: &Metadata) {
+    old.atime = new.atime;
+    old.mtime = new.mtime;
+    old.ctime = new.ctime;
+    old.mode = new.mode;
+    old.uid = new.uid;
+    old.gid = new.gid;
+}
+
+pub trait AsTmpFile {
+    fn as_tmp_file(&self) -> Result<&TmpFileINode>;
+}
+
+impl AsTmpFile for FileRef {
+    fn as_tmp_file(&self) -> Result<&TmpFileINode> {
+        let inode = self.as_inode_file()?.inode();
+        // The files of /dev/shm are wrapped by the mount point
+        let inode = match inode.downcast_ref::<MNode>() {
+            Some(mnode) => &mnode.inode,
+            None => inode,
+        };
+        inode
+            .downcast_ref::<TmpFileINode>()
+            .ok_or_else(|| errno!(EINVAL, "not a file of tmpfs"))
+    }
+}
@@ -38,6 +38,9 @@ pub fn do_handle_interrupt(
     // interrupt happened
     *context = CpuContext::from_sgx(&info.cpu_context);
     context.fpregs = fpregs;
+    // The thread may be switched out at the interrupt, so its rseq critical section
+    // must restart
+    crate::sched::abort_rseq_critical_section(context);
     Ok(0)
 }
 
@@ -54,32 +57,41 @@ pub fn broadcast_interrupts() -> Result<usize> {
     let num_signaled_threads = crate::process::table::get_all_threads()
         .iter()
         .filter(should_interrupt_thread)
-        .map(|thread| {
-            let host_tid = {
-                let sched = thread.sched().lock().unwrap();
-                match sched.host_tid() {
-                    None => return false,
-                    Some(host_tid) => host_tid,
-                }
-            };
-            let signum = 64; // real-time signal 64 is used to notify interrupts
-            let is_signaled = unsafe {
-                let mut retval = 0;
-                let status = occlum_ocall_tkill(&mut retval, host_tid, signum);
-                assert!(status == sgx_status_t::SGX_SUCCESS);
-                if retval == 0 {
-                    true
-                } else {
-                    false
-                }
-            };
-            is_signaled
-        })
+        .map(interrupt_thread)
         .filter(|&is_signaled| is_signaled)
         .count();
     Ok(num_signaled_threads)
 }
 
+/// Interrupt a thread by sending a POSIX signal. Return whether it is signaled.
+pub fn interrupt_thread(thread: &ThreadRef) -> bool {
+    // In the M:N mode, a parked thread is not running on its vCPU, so it is
+    // interrupted without a host signal
+    if crate::process::task::interrupt_parked_coroutine(thread.raw_ptr()) {
+        return true;
+    }
+
+    let host_tid = {
+        let sched = thread.sched().lock().unwrap();
+        match sched.host_tid() {
+            None => return false,
+            Some(host_tid) => host_tid,
+        }
+    };
+    let signum = 64; // real-time signal 64 is used to notify interrupts
+    let is_signaled = unsafe {
+        let mut retval = 0;
+        let status = occlum_ocall_tkill(&mut retval, host_tid, signum);
+        assert!(status == sgx_status_t::SGX_SUCCESS);
+        if retval == 0 {
+            true
+        } else {
+            false
+        }
+    };
+    is_signaled
+}
+
 extern "C" {
     fn occlum_ocall_tkill(retval: &mut i32, host_tid: pid_t, signum: i32) -> sgx_status_t;
 }
@@ -0,0 +1,81 @@
+use super::*;
+
+use super::shm::IPC_PRIVATE;
+
+/// The IPC objects of one kind, e.g., semaphore sets, indexed by their IDs
+pub struct IpcIds<T> {
+    objects: HashMap<u32, Arc<T>>,
+    // The IDs are allocated from 0 to max_id - 1 in a round robin manner
+    max_id: u32,
+    last_alloc_id: u32,
+}
+
+impl<T> IpcIds<T> {
+    pub fn new(max_id: u32) -> Self {
+        Self {
+            objects: HashMap::new(),
+            max_id,
+            last_alloc_id: max_id - 1,
+        }
+    }
+
+    pub fn get(&self, id: u32) -> Result<Arc<T>> {
+        self.objects
+            .get(&id)
+            .cloned()
+            .ok_or_else(|| errno!(EINVAL, "invalid IPC id"))
+    }
+
+    /// Find the object of the key, which must not be IPC_PRIVATE
+    pub fn find_by_key(&self, key: key_t, get_key: impl Fn(&T) -> key_t) -> Option<Arc<T>> {
+        debug_assert!(key != IPC_PRIVATE);
+        self.objects
+            .values()
+            .find(|object| get_key(object) == key)
+            .cloned()
+    }
+
+    /// Create an object with a new ID
+    pub fn insert(&mut self, new_object: impl FnOnce(u32) -> Result<T>) -> Result<Arc<T>> {
+        if self.objects.len() >= self.max_id as usize {
+            return_errno!(ENOSPC, "all possible IPC IDs have been taken");
+        }
+        let mut id = self.last_alloc_id;
+        loop {
+            id = (id + 1) % self.max_id;
+            if !self.objects.contains_key(&id) {
+                break;
+            }
+        }
+        let object = Arc::new(new_object(id)?);
+        self.objects.insert(id, object.clone());
+        self.last_alloc_id = id;
+        Ok(object)
+    }
+
+    pub fn remove(&mut self, id: u32) -> Result<Arc<T>> {
+        self.objects
+            .remove(&id)
+            .ok_or_else(|| errno!(EINVAL, "invalid IPC id"))
+    }
+
+    pub fn len(&self) -> usize {
+        self.objects.len()
+    }
+
+    /// The highest ID in use, or 0 if there is none
+    pub fn max_used_id(&self) -> u32 {
+        self.objects.keys().copied().max().unwrap_or(0)
+    }
+
+    /// The objects in the ascending order of IDs
+    pub fn sorted(&self) -> Vec<(u32, Arc<T>)> {
+        let mut objects: Vec<(u32, Arc<T>)> = self
+            .objects
+            .iter()
+            .map(|(&id, object)| (id, object.clone()))
+            .collect();
+        objects.sort_by_key(|&(id, _)| id);
+        objects
+    }
+}
@@ -1,7 +1,15 @@
 use super::*;
 
+mod ids;
+mod msg;
+mod sem;
 mod shm;
 mod syscalls;
 
+pub use self::msg::MSG_MANAGER;
+pub use self::sem::{sembuf, SEM_MANAGER};
 pub use self::shm::{key_t, shmids_t, SHM_MANAGER};
-pub use self::syscalls::{do_shmat, do_shmctl, do_shmdt, do_shmget};
+pub use self::syscalls::{
+    do_msgctl, do_msgget, do_msgrcv, do_msgsnd, do_semctl, do_semget, do_semop, do_semtimedop,
+    do_shmat, do_shmctl, do_shmdt, do_shmget,
+};
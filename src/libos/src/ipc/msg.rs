@@ -0,0 +1,477 @@
+//! System V message queues.
+//!
+//! A message queue keeps the messages in the order that they are sent, from which
+//! msgrcv takes the first message of the requested type. The senders sleep when the
+//! queue is full, and the receivers sleep when there is no message of the type.
+
+use super::*;
+
+use super::ids::IpcIds;
+use super::shm::{ipc_perm_t, CmdId, ShmFlags, IPC_INFO, IPC_PRIVATE, IPC_RMID, IPC_SET, IPC_STAT};
+use crate::events::{Waiter, WaiterQueue};
+use crate::fs::FileMode;
+use crate::process::{do_getegid, do_geteuid, gid_t};
+use crate::time::{do_gettimeofday, time_t};
+use crate::util::mem_util::from_user;
+use std::sync::atomic::{AtomicBool, Ordering};
+
+pub type MsgId = u32;
+
+// The limits, which are the same as the defaults of Linux
+// max num of queues system wide
+const MSGMNI: MsgId = 32000;
+// max size of a message (bytes)
+pub const MSGMAX: usize = 8192;
+// default max size of a queue (bytes)
+const MSGMNB: usize = 16384;
+
+// For cmd in msgctl()
+const MSG_STAT: CmdId = 11;
+const MSG_INFO: CmdId = 12;
+const MSG_STAT_ANY: CmdId = 13;
+
+bitflags! {
+    pub struct MsgFlags: i32 {
+        const IPC_NOWAIT = 0o4000;
+        /// truncate the message if it is too long
+        const MSG_NOERROR = 0o10000;
+        /// receive the first message of any other type
+        const MSG_EXCEPT = 0o20000;
+        /// receive a copy of the message at the position
+        const MSG_COPY = 0o40000;
+    }
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug)]
+#[repr(C)]
+struct msqid64_ds {
+    msg_perm: ipc_perm_t,
+    msg_stime: time_t,
+    msg_rtime: time_t,
+    msg_ctime: time_t,
+    msg_cbytes: u64,
+    msg_qnum: u64,
+    msg_qbytes: u64,
+    msg_lspid: pid_t,
+    msg_lrpid: pid_t,
+    unused4: u64,
+    unused5: u64,
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug)]
+#[repr(C)]
+struct msginfo {
+    msgpool: i32,
+    msgmap: i32,
+    msgmax: i32,
+    msgmnb: i32,
+    msgmni: i32,
+    msgssz: i32,
+    msgtql: i32,
+    msgseg: u16,
+}
+
+/// A message with its type
+#[derive(Clone, Debug)]
+pub struct Message {
+    mtype: i64,
+    text: Vec<u8>,
+}
+
+impl Message {
+    pub fn new(mtype: i64, text: Vec<u8>) -> Self {
+        Self { mtype, text }
+    }
+
+    pub fn mtype(&self) -> i64 {
+        self.mtype
+    }
+
+    pub fn text(&self) -> &[u8] {
+        &self.text
+    }
+}
+
+struct MsgQueue {
+    msqid: MsgId,
+    key: key_t,
+    is_removed: AtomicBool,
+    senders: WaiterQueue,
+    receivers: WaiterQueue,
+    inner: SgxMutex<MsgQueueInner>,
+}
+
+struct MsgQueueInner {
+    uid: uid_t,
+    gid: gid_t,
+    cuid: uid_t,
+    cgid: gid_t,
+    mode: FileMode,
+    msg_stime: time_t,
+    msg_rtime: time_t,
+    msg_ctime: time_t,
+    msg_lspid: pid_t,
+    msg_lrpid: pid_t,
+    // The max num of bytes, and messages, of the queue
+    msg_qbytes: usize,
+    msg_cbytes: usize,
+    messages: VecDeque<Message>,
+}
+
+impl MsgQueue {
+    fn new(msqid: MsgId, key: key_t, mode: FileMode) -> Self {
+        let uid = do_geteuid().unwrap() as uid_t;
+        let gid = do_getegid().unwrap() as gid_t;
+        MsgQueue {
+            msqid,
+            key,
+            is_removed: AtomicBool::new(false),
+            senders: WaiterQueue::new(),
+            receivers: WaiterQueue::new(),
+            inner: SgxMutex::new(MsgQueueInner {
+                uid,
+                gid,
+                cuid: uid,
+                cgid: gid,
+                mode,
+                msg_stime: 0,
+                msg_rtime: 0,
+                msg_ctime: MsgManager::current_time(),
+                msg_lspid: 0,
+                msg_lrpid: 0,
+                msg_qbytes: MSGMNB,
+                msg_cbytes: 0,
+                messages: VecDeque::new(),
+            }),
+        }
+    }
+
+    fn check_removed(&self) -> Result<()> {
+        if self.is_removed.load(Ordering::Acquire) {
+            return_errno!(EIDRM, "the message queue is removed");
+        }
+        Ok(())
+    }
+
+    // Wait for the waiter enqueued, and then dequeue it
+    fn wait(waiters: &WaiterQueue, waiter: &Waiter) -> Result<()> {
+        let res = waiter.wait(None);
+        waiters.dequeue(waiter);
+        res
+    }
+
+    fn send(&self, message: Message, flags: MsgFlags) -> Result<()> {
+        let pid = current!().process().pid();
+        let now = MsgManager::current_time();
+        let waiter = Waiter::new();
+        loop {
+            {
+                let mut inner = self.inner.lock().unwrap();
+                self.check_removed()?;
+                let len = message.text.len();
+                if inner.msg_cbytes + len <= inner.msg_qbytes
+                    && inner.messages.len() < inner.msg_qbytes
+                {
+                    inner.msg_cbytes += len;
+                    inner.msg_lspid = pid;
+                    inner.msg_stime = now;
+                    inner.messages.push_back(message);
+                    drop(inner);
+                    self.receivers.dequeue_and_wake_all();
+                    return Ok(());
+                }
+                if flags.contains(MsgFlags::IPC_NOWAIT) {
+                    return_errno!(EAGAIN, "the message queue is full");
+                }
+                self.senders.reset_and_enqueue(&waiter);
+            }
+            Self::wait(&self.senders, &waiter)?;
+        }
+    }
+
+    fn recv(&self, size: usize, msgtyp: i64, flags: MsgFlags) -> Result<Message> {
+        // A copy never waits, as the position to copy is not a type to wait for
+        if flags.contains(MsgFlags::MSG_COPY)
+            && (!flags.contains(MsgFlags::IPC_NOWAIT) || flags.contains(MsgFlags::MSG_EXCEPT))
+        {
+            return_errno!(EINVAL, "MSG_COPY requires IPC_NOWAIT and no MSG_EXCEPT");
+        }
+        if flags.contains(MsgFlags::MSG_COPY) && msgtyp < 0 {
+            return_errno!(ENOMSG, "invalid position to copy");
+        }
+        let pid = current!().process().pid();
+        let now = MsgManager::current_time();
+        let waiter = Waiter::new();
+        loop {
+            {
+                let mut inner = self.inner.lock().unwrap();
+                self.check_removed()?;
+                if let Some(idx) = Self::find(&inner.messages, msgtyp, flags) {
+                    if inner.messages[idx].text.len() > size
+                        && !flags.contains(MsgFlags::MSG_NOERROR)
+                    {
+                        return_errno!(E2BIG, "the message is too long");
+                    }
+                    if flags.contains(MsgFlags::MSG_COPY) {
+                        return Ok(inner.messages[idx].clone());
+                    }
+                    let message = inner.messages.remove(idx).unwrap();
+                    inner.msg_cbytes -= message.text.len();
+                    inner.msg_lrpid = pid;
+                    inner.msg_rtime = now;
+                    drop(inner);
+                    self.senders.dequeue_and_wake_all();
+                    return Ok(message);
+                }
+                if flags.contains(MsgFlags::IPC_NOWAIT) {
+                    return_errno!(ENOMSG, "no message of the type");
+                }
+                self.receivers.reset_and_enqueue(&waiter);
+            }
+            Self::wait(&self.receivers, &waiter)?;
+        }
+    }
+
+    // Find the position of the message to receive
+    fn find(messages: &VecDeque<Message>, msgtyp: i64, flags: MsgFlags) -> Option<usize> {
+        if flags.contains(MsgFlags::MSG_COPY) {
+            // The type is the position of the message to copy
+            return Some(msgtyp as usize).filter(|&idx| idx < messages.len());
+        }
+        let mut iter = messages.iter().enumerate();
+        let found = if msgtyp == 0 {
+            iter.next()
+        } else if msgtyp > 0 && flags.contains(MsgFlags::MSG_EXCEPT) {
+            iter.find(|(_, message)| message.mtype != msgtyp)
+        } else if msgtyp > 0 {
+            iter.find(|(_, message)| message.mtype == msgtyp)
+        } else {
+            // The first message of the lowest type that is not greater than |msgtyp|,
+            // which is clamped to i64::MAX as Linux does
+            let max_type = msgtyp.checked_neg().unwrap_or(i64::MAX);
+            iter.filter(|(_, message)| message.mtype <= max_type)
+                .min_by_key(|&(idx, message)| (message.mtype, idx))
+        };
+        found.map(|(idx, _)| idx)
+    }
+
+    fn stat(&self) -> msqid64_ds {
+        let inner = self.inner.lock().unwrap();
+        msqid64_ds {
+            msg_perm: ipc_perm_t::new(
+                self.key,
+                inner.uid,
+                inner.gid,
+                inner.cuid,
+                inner.cgid,
+                inner.mode.bits(),
+            ),
+            msg_stime: inner.msg_stime,
+            msg_rtime: inner.msg_rtime,
+            msg_ctime: inner.msg_ctime,
+            msg_cbytes: inner.msg_cbytes as u64,
+            msg_qnum: inner.messages.len() as u64,
+            msg_qbytes: inner.msg_qbytes as u64,
+            msg_lspid: inner.msg_lspid,
+            msg_lrpid: inner.msg_lrpid,
+            unused4: 0,
+            unused5: 0,
+        }
+    }
+
+    fn remove(&self) {
+        self.is_removed.store(true, Ordering::Release);
+        self.senders.dequeue_and_wake_all();
+        self.receivers.dequeue_and_wake_all();
+    }
+}
+
+lazy_static! {
+    pub static ref MSG_MANAGER: MsgManager = MsgManager::new();
+}
+
+pub struct MsgManager {
+    msg_queues: RwLock<IpcIds<MsgQueue>>,
+}
+
+impl MsgManager {
+    fn new() -> Self {
+        MsgManager {
+            msg_queues: RwLock::new(IpcIds::new(MSGMNI)),
+        }
+    }
+
+    fn current_time() -> time_t {
+        do_gettimeofday().sec()
+    }
+
+    fn get(&self, msqid: MsgId) -> Result<Arc<MsgQueue>> {
+        self.msg_queues.read().unwrap().get(msqid)
+    }
+
+    pub fn do_msgget(&self, key: key_t, msgflg: ShmFlags) -> Result<MsgId> {
+        debug!("do_msgget: key: {:?}, msgflg: {:?}", key, msgflg);
+        let mut msg_queues = self.msg_queues.write().unwrap();
+        if key != IPC_PRIVATE {
+            if let Some(msg_queue) = msg_queues.find_by_key(key, |msg_queue| msg_queue.key) {
+                if msgflg.contains(ShmFlags::IPC_CREAT) && msgflg.contains(ShmFlags::IPC_EXCL) {
+                    return_errno!(EEXIST, "the message queue already exists for given key");
+                }
+                return Ok(msg_queue.msqid);
+            }
+            if !msgflg.contains(ShmFlags::IPC_CREAT) {
+                return_errno!(ENOENT, "no message queue exists for given key");
+            }
+        }
+        let mode = msgflg.to_file_mode();
+        let msg_queue = msg_queues.insert(|msqid| Ok(MsgQueue::new(msqid, key, mode)))?;
+        Ok(msg_queue.msqid)
+    }
+
+    pub fn do_msgsnd(&self, msqid: MsgId, message: Message, msgflg: MsgFlags) -> Result<()> {
+        debug!(
+            "do_msgsnd: msqid: {:?}, mtype: {:?}, len: {:?}, msgflg: {:?}",
+            msqid,
+            message.mtype,
+            message.text.len(),
+            msgflg
+        );
+        if message.mtype <= 0 {
+            return_errno!(EINVAL, "mtype must be positive");
+        }
+        if message.text.len() > MSGMAX {
+            return_errno!(EINVAL, "the message is too long");
+        }
+        self.get(msqid)?.send(message, msgflg)
+    }
+
+    pub fn do_msgrcv(
+        &self,
+        msqid: MsgId,
+        size: usize,
+        msgtyp: i64,
+        msgflg: MsgFlags,
+    ) -> Result<Message> {
+        debug!(
+            "do_msgrcv: msqid: {:?}, size: {:?}, msgtyp: {:?}, msgflg: {:?}",
+            msqid, size, msgtyp, msgflg
+        );
+        self.get(msqid)?.recv(size, msgtyp, msgflg)
+    }
+
+    pub fn do_msgctl(&self, msqid: MsgId, cmd: CmdId, buf: usize) -> Result<isize> {
+        debug!(
+            "do_msgctl: msqid: {:?}, cmd: {:?}, buf: {:#x}",
+            msqid, cmd, buf
+        );
+        match cmd {
+            IPC_INFO | MSG_INFO => {
+                let buf = buf as *mut msginfo;
+                from_user::check_mut_ptr(buf)?;
+                let msg_queues = self.msg_queues.read().unwrap();
+                let (msgpool, msgmap, msgtql) = if cmd == MSG_INFO {
+                    let queues = msg_queues.sorted();
+                    let (nr_messages, nr_bytes) =
+                        queues
+                            .iter()
+                            .fold((0, 0), |(nr_messages, nr_bytes), (_, queue)| {
+                                let inner = queue.inner.lock().unwrap();
+                                (
+                                    nr_messages + inner.messages.len(),
+                                    nr_bytes + inner.msg_cbytes,
+                                )
+                            });
+                    (queues.len() as i32, nr_messages as i32, nr_bytes as i32)
+                } else {
+                    (
+                        (MSGMNI as usize * MSGMNB / 1024) as i32,
+                        MSGMNB as i32,
+                        MSGMNB as i32,
+                    )
+                };
+                unsafe {
+                    *buf = msginfo {
+                        msgpool,
+                        msgmap,
+                        msgmax: MSGMAX as i32,
+                        msgmnb: MSGMNB as i32,
+                        msgmni: MSGMNI as i32,
+                        msgssz: 16,
+                        msgtql,
+                        msgseg: u16::MAX,
+                    };
+                }
+                return Ok(msg_queues.max_used_id() as isize);
+            }
+            IPC_RMID => {
+                self.msg_queues.write().unwrap().remove(msqid)?.remove();
+                return Ok(0);
+            }
+            _ => {}
+        }
+
+        let msg_queue = self.get(msqid)?;
+        let ret = match cmd {
+            IPC_STAT | MSG_STAT | MSG_STAT_ANY => {
+                let buf = buf as *mut msqid64_ds;
+                from_user::check_mut_ptr(buf)?;
+                unsafe {
+                    *buf = msg_queue.stat();
+                }
+                if cmd == IPC_STAT {
+                    0
+                } else {
+                    msqid as isize
+                }
+            }
+            IPC_SET => {
+                let buf = buf as *const msqid64_ds;
+                from_user::check_ptr(buf)?;
+                let ds = unsafe { &*buf };
+                {
+                    let mut inner = msg_queue.inner.lock().unwrap();
+                    inner.uid = ds.msg_perm.uid;
+                    inner.gid = ds.msg_perm.gid;
+                    inner.mode = FileMode::from_bits_truncate(ds.msg_perm.mode & 0o777);
+                    inner.msg_qbytes = ds.msg_qbytes as usize;
+                    inner.msg_ctime = Self::current_time();
+                }
+                // The queue may have more room now
+                msg_queue.senders.dequeue_and_wake_all();
+                0
+            }
+            _ => return_errno!(EINVAL, "unimplemented cmd"),
+        };
+        Ok(ret)
+    }
+
+    /// The content of /proc/sysvipc/msg
+    pub fn proc_info(&self) -> String {
+        let mut info = String::from(
+            "       key      msqid perms      cbytes       qnum lspid lrpid   uid   gid  cuid  cgid      stime      rtime      ctime\n",
+        );
+        for (msqid, msg_queue) in self.msg_queues.read().unwrap().sorted() {
+            let inner = msg_queue.inner.lock().unwrap();
+            info += &format!(
+                "{:>10} {:>10}  {:>4o}  {:>10} {:>10} {:>5} {:>5} {:>5} {:>5} {:>5} {:>5} {:>10} {:>10} {:>10}\n",
+                msg_queue.key as i32,
+                msqid,
+                inner.mode.bits(),
+                inner.msg_cbytes,
+                inner.messages.len(),
+                inner.msg_lspid,
+                inner.msg_lrpid,
+                inner.uid,
+                inner.gid,
+                inner.cuid,
+                inner.cgid,
+                inner.msg_stime,
+                inner.msg_rtime,
+                inner.msg_ctime,
+            );
+        }
+        info
+    }
+}
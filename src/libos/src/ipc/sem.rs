@@ -0,0 +1,690 @@
+//! System V semaphore sets.
+//!
+//! A semop of one operation without SEM_UNDO, which is what most of the users do to
+//! lock and unlock, changes the semaphore by CAS without any lock, like a futex. The
+//! other semops, i.e., those of multiple operations or with SEM_UNDO, are complex:
+//! a complex semop takes the lock of the set and turns the set into the complex mode,
+//! in which the lock-free semops wait for the lock instead, so that the operations of
+//! a complex semop are done atomically. A semop that cannot proceed always sleeps in
+//! the complex mode, and the semops that change the semaphores wake the sleeping ones.
+
+use super::*;
+
+use super::ids::IpcIds;
+use super::shm::{ipc_perm_t, CmdId, ShmFlags, IPC_INFO, IPC_PRIVATE, IPC_RMID, IPC_SET, IPC_STAT};
+use crate::events::{Waiter, WaiterQueue};
+use crate::fs::FileMode;
+use crate::process::{do_getegid, do_geteuid, gid_t, ThreadRef};
+use crate::time::timer_wheel::coarse_realtime_secs;
+use crate::time::{do_gettimeofday, time_t};
+use crate::util::mem_util::from_user;
+use std::hint;
+use std::ops::{Deref, DerefMut};
+use std::sync::atomic::{AtomicBool, AtomicI32, AtomicI64, AtomicU32, Ordering};
+use std::time::Duration;
+
+pub type SemId = u32;
+
+// The limits, which are the same as the defaults of Linux
+// max num of semaphores per set
+const SEMMSL: usize = 32000;
+// max num of sets system wide
+const SEMMNI: SemId = 32000;
+// max num of semaphores system wide
+const SEMMNS: usize = SEMMNI as usize * SEMMSL;
+// max num of operations per semop
+pub const SEMOPM: usize = 500;
+// max value of semaphores
+const SEMVMX: i32 = 32767;
+// max value of the adjustments for SEM_UNDO
+const SEMAEM: i32 = SEMVMX;
+
+// For cmd in semctl()
+const GETPID: CmdId = 11;
+const GETVAL: CmdId = 12;
+const GETALL: CmdId = 13;
+const GETNCNT: CmdId = 14;
+const GETZCNT: CmdId = 15;
+const SETVAL: CmdId = 16;
+const SETALL: CmdId = 17;
+const SEM_STAT: CmdId = 18;
+const SEM_INFO: CmdId = 19;
+const SEM_STAT_ANY: CmdId = 20;
+
+// For sem_flg in sembuf
+const IPC_NOWAIT: i16 = 0o4000;
+const SEM_UNDO: i16 = 0x1000;
+
+// The bit of fast_state for the complex mode, the other bits of which count the
+// lock-free semops in progress
+const COMPLEX_MODE: u32 = 1 << 31;
+
+/// A semaphore operation, i.e., `struct sembuf`
+#[allow(non_camel_case_types)]
+#[derive(Clone, Copy, Debug)]
+#[repr(C)]
+pub struct sembuf {
+    sem_num: u16,
+    sem_op: i16,
+    sem_flg: i16,
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug)]
+#[repr(C)]
+struct semid64_ds {
+    sem_perm: ipc_perm_t,
+    sem_otime: time_t,
+    unused1: u64,
+    sem_ctime: time_t,
+    unused2: u64,
+    sem_nsems: u64,
+    unused3: u64,
+    unused4: u64,
+}
+
+#[allow(non_camel_case_types)]
+#[derive(Debug)]
+#[repr(C)]
+struct seminfo {
+    semmap: i32,
+    semmni: i32,
+    semmns: i32,
+    semmnu: i32,
+    semmsl: i32,
+    semopm: i32,
+    semume: i32,
+    semusz: i32,
+    semvmx: i32,
+    semaem: i32,
+}
+
+struct Sem {
+    val: AtomicI32,
+    // The pid of the last process that changed the semaphore
+    pid: AtomicI32,
+}
+
+struct SemSet {
+    semid: SemId,
+    key: key_t,
+    sems: Vec<Sem>,
+    fast_state: AtomicU32,
+    // The time of the last semop, which is taken from the coarse clock to keep the
+    // OCall off the fast path
+    sem_otime: AtomicI64,
+    is_removed: AtomicBool,
+    waiters: WaiterQueue,
+    inner: SgxMutex<SemSetInner>,
+}
+
+struct SemSetInner {
+    uid: uid_t,
+    gid: gid_t,
+    cuid: uid_t,
+    cgid: gid_t,
+    mode: FileMode,
+    sem_ctime: time_t,
+    // The numbers of the semops waiting for each semaphore to increase, or to be zero
+    ncnts: Vec<u32>,
+    zcnts: Vec<u32>,
+    // The adjustments of each process to be applied at its exit for SEM_UNDO
+    undos: HashMap<pid_t, Vec<i32>>,
+}
+
+// The lock of a set in the complex mode
+struct SemSetGuard<'a> {
+    inner: SgxMutexGuard<'a, SemSetInner>,
+    fast_state: &'a AtomicU32,
+}
+
+impl Deref for SemSetGuard<'_> {
+    type Target = SemSetInner;
+
+    fn deref(&self) -> &SemSetInner {
+        &self.inner
+    }
+}
+
+impl DerefMut for SemSetGuard<'_> {
+    fn deref_mut(&mut self) -> &mut SemSetInner {
+        &mut self.inner
+    }
+}
+
+impl Drop for SemSetGuard<'_> {
+    fn drop(&mut self) {
+        self.fast_state.fetch_and(!COMPLEX_MODE, Ordering::SeqCst);
+    }
+}
+
+impl SemSet {
+    fn new(semid: SemId, key: key_t, nsems: usize, mode: FileMode) -> Self {
+        let uid = do_geteuid().unwrap() as uid_t;
+        let gid = do_getegid().unwrap() as gid_t;
+        let sems = (0..nsems)
+            .map(|_| Sem {
+                val: AtomicI32::new(0),
+                pid: AtomicI32::new(0),
+            })
+            .collect();
+        SemSet {
+            semid,
+            key,
+            sems,
+            fast_state: AtomicU32::new(0),
+            sem_otime: AtomicI64::new(0),
+            is_removed: AtomicBool::new(false),
+            waiters: WaiterQueue::new(),
+            inner: SgxMutex::new(SemSetInner {
+                uid,
+                gid,
+                cuid: uid,
+                cgid: gid,
+                mode,
+                sem_ctime: SemManager::current_time(),
+                ncnts: vec![0; nsems],
+                zcnts: vec![0; nsems],
+                undos: HashMap::new(),
+            }),
+        }
+    }
+
+    fn nsems(&self) -> usize {
+        self.sems.len()
+    }
+
+    fn sem(&self, semnum: i32) -> Result<&Sem> {
+        if semnum < 0 {
+            return_errno!(EINVAL, "invalid semnum");
+        }
+        self.sems
+            .get(semnum as usize)
+            .ok_or_else(|| errno!(EINVAL, "invalid semnum"))
+    }
+
+    fn check_removed(&self) -> Result<()> {
+        if self.is_removed.load(Ordering::Acquire) {
+            return_errno!(EIDRM, "the semaphore set is removed");
+        }
+        Ok(())
+    }
+
+    // Lock the set and wait for the lock-free semops in progress to finish
+    fn lock(&self) -> SemSetGuard<'_> {
+        let inner = self.inner.lock().unwrap();
+        self.fast_state.fetch_or(COMPLEX_MODE, Ordering::SeqCst);
+        while self.fast_state.load(Ordering::SeqCst) & !COMPLEX_MODE != 0 {
+            hint::spin_loop();
+        }
+        SemSetGuard {
+            inner,
+            fast_state: &self.fast_state,
+        }
+    }
+
+    fn semop(&self, sops: &[sembuf], mut timeout: Option<&mut Duration>) -> Result<()> {
+        let pid = current!().process().pid();
+        if sops.len() == 1 && sops[0].sem_flg & SEM_UNDO == 0 {
+            if let Some(res) = self.try_semop_fast(&sops[0], pid) {
+                return res;
+            }
+        }
+
+        let is_nowait = sops.iter().any(|sop| sop.sem_flg & IPC_NOWAIT != 0);
+        let waiter = Waiter::new();
+        loop {
+            let (semnum, is_for_zero) = {
+                let mut inner = self.lock();
+                self.check_removed()?;
+                let (semnum, is_for_zero) = match self.try_semop(&mut inner, sops, pid)? {
+                    None => {
+                        drop(inner);
+                        self.record_op();
+                        if sops.iter().any(|sop| sop.sem_op != 0) {
+                            self.waiters.dequeue_and_wake_all();
+                        }
+                        return Ok(());
+                    }
+                    Some(blocker) => blocker,
+                };
+                if is_nowait {
+                    return_errno!(EAGAIN, "the semop would block");
+                }
+                if is_for_zero {
+                    inner.zcnts[semnum] += 1;
+                } else {
+                    inner.ncnts[semnum] += 1;
+                }
+                self.waiters.reset_and_enqueue(&waiter);
+                (semnum, is_for_zero)
+            };
+
+            let res = waiter.wait_mut(timeout.as_mut().map(|timeout| &mut **timeout));
+            self.waiters.dequeue(&waiter);
+            {
+                let mut inner = self.inner.lock().unwrap();
+                if is_for_zero {
+                    inner.zcnts[semnum] -= 1;
+                } else {
+                    inner.ncnts[semnum] -= 1;
+                }
+            }
+            match res {
+                Ok(()) => {}
+                Err(e) if e.errno() == Errno::ETIMEDOUT => {
+                    return_errno!(EAGAIN, "the semop timed out")
+                }
+                Err(e) => return Err(e),
+            }
+        }
+    }
+
+    // Do a semop of one operation by CAS. Return None if it has to be done in the
+    // complex mode, e.g., it has to wait.
+    fn try_semop_fast(&self, sop: &sembuf, pid: pid_t) -> Option<Result<()>> {
+        let sem = &self.sems[sop.sem_num as usize];
+        if self.fast_state.fetch_add(1, Ordering::SeqCst) & COMPLEX_MODE != 0 {
+            self.fast_state.fetch_sub(1, Ordering::SeqCst);
+            return None;
+        }
+        let mut val = sem.val.load(Ordering::SeqCst);
+        let res = loop {
+            if let Err(e) = self.check_removed() {
+                break Some(Err(e));
+            }
+            let new_val = val + sop.sem_op as i32;
+            if (sop.sem_op == 0 && val != 0) || new_val < 0 {
+                if sop.sem_flg & IPC_NOWAIT != 0 {
+                    break Some(Err(errno!(EAGAIN, "the semop would block")));
+                }
+                break None;
+            }
+            if new_val > SEMVMX {
+                break Some(Err(errno!(ERANGE, "the semaphore value is too large")));
+            }
+            match sem
+                .val
+                .compare_exchange(val, new_val, Ordering::SeqCst, Ordering::SeqCst)
+            {
+                Ok(_) => break Some(Ok(())),
+                Err(curr_val) => val = curr_val,
+            }
+        };
+        let is_done = matches!(res, Some(Ok(())));
+        if is_done {
+            sem.pid.store(pid, Ordering::Relaxed);
+        }
+        self.fast_state.fetch_sub(1, Ordering::SeqCst);
+
+        if is_done {
+            self.record_op();
+            if sop.sem_op != 0 {
+                self.waiters.dequeue_and_wake_all();
+            }
+        }
+        res
+    }
+
+    // Do all the operations of a semop, or none of them. Return the semaphore to
+    // wait for, and whether to wait for it to be zero, if it has to wait.
+    fn try_semop(
+        &self,
+        inner: &mut SemSetGuard,
+        sops: &[sembuf],
+        pid: pid_t,
+    ) -> Result<Option<(usize, bool)>> {
+        fn lookup(vals: &[(usize, i32)], semnum: usize) -> Option<i32> {
+            vals.iter()
+                .find(|&&(num, _)| num == semnum)
+                .map(|&(_, val)| val)
+        }
+        fn update(vals: &mut Vec<(usize, i32)>, semnum: usize, val: i32) {
+            match vals.iter_mut().find(|(num, _)| *num == semnum) {
+                Some(entry) => entry.1 = val,
+                None => vals.push((semnum, val)),
+            }
+        }
+
+        let mut new_vals: Vec<(usize, i32)> = Vec::with_capacity(sops.len());
+        let mut new_adjs: Vec<(usize, i32)> = Vec::new();
+        for sop in sops {
+            let semnum = sop.sem_num as usize;
+            let val = lookup(&new_vals, semnum)
+                .unwrap_or_else(|| self.sems[semnum].val.load(Ordering::SeqCst));
+            if sop.sem_op == 0 {
+                if val != 0 {
+                    return Ok(Some((semnum, true)));
+                }
+                continue;
+            }
+            let new_val = val + sop.sem_op as i32;
+            if new_val < 0 {
+                return Ok(Some((semnum, false)));
+            }
+            if new_val > SEMVMX {
+                return_errno!(ERANGE, "the semaphore value is too large");
+            }
+            update(&mut new_vals, semnum, new_val);
+
+            if sop.sem_flg & SEM_UNDO != 0 {
+                let adj = lookup(&new_adjs, semnum)
+                    .unwrap_or_else(|| inner.undos.get(&pid).map(|adjs| adjs[semnum]).unwrap_or(0));
+                let new_adj = adj - sop.sem_op as i32;
+                if new_adj < -SEMAEM - 1 || new_adj > SEMAEM {
+                    return_errno!(ERANGE, "the adjustment for SEM_UNDO is too large");
+                }
+                update(&mut new_adjs, semnum, new_adj);
+            }
+        }
+
+        for (semnum, val) in new_vals {
+            let sem = &self.sems[semnum];
+            sem.val.store(val, Ordering::SeqCst);
+            sem.pid.store(pid, Ordering::Relaxed);
+        }
+        if !new_adjs.is_empty() {
+            let nsems = self.nsems();
+            let adjs = inner.undos.entry(pid).or_insert_with(|| vec![0; nsems]);
+            for (semnum, adj) in new_adjs {
+                adjs[semnum] = adj;
+            }
+        }
+        Ok(None)
+    }
+
+    // Apply the adjustments of the process for SEM_UNDO
+    fn undo(&self, pid: pid_t) {
+        let mut inner = self.lock();
+        let adjs = match inner.undos.remove(&pid) {
+            Some(adjs) => adjs,
+            None => return,
+        };
+        for (sem, adj) in self.sems.iter().zip(adjs).filter(|&(_, adj)| adj != 0) {
+            let val = sem.val.load(Ordering::SeqCst) + adj;
+            sem.val.store(val.max(0).min(SEMVMX), Ordering::SeqCst);
+            sem.pid.store(pid, Ordering::Relaxed);
+        }
+        drop(inner);
+        self.record_op();
+        self.waiters.dequeue_and_wake_all();
+    }
+
+    // Set the values, which clears the adjustments of the semaphores for SEM_UNDO
+    fn set_vals(&self, vals: &[(usize, i32)]) -> Result<()> {
+        if vals.iter().any(|&(_, val)| val < 0 || val > SEMVMX) {
+            return_errno!(ERANGE, "invalid semaphore value");
+        }
+        let pid = current!().process().pid();
+        let mut inner = self.lock();
+        for &(semnum, val) in vals {
+            let sem = &self.sems[semnum];
+            sem.val.store(val, Ordering::SeqCst);
+            sem.pid.store(pid, Ordering::Relaxed);
+            for adjs in inner.undos.values_mut() {
+                adjs[semnum] = 0;
+            }
+        }
+        inner.sem_ctime = SemManager::current_time();
+        drop(inner);
+        self.waiters.dequeue_and_wake_all();
+        Ok(())
+    }
+
+    fn record_op(&self) {
+        self.sem_otime
+            .store(coarse_realtime_secs(), Ordering::Relaxed);
+    }
+
+    fn otime(&self) -> time_t {
+        self.sem_otime.load(Ordering::Relaxed)
+    }
+
+    fn stat(&self) -> semid64_ds {
+        let inner = self.inner.lock().unwrap();
+        semid64_ds {
+            sem_perm: ipc_perm_t::new(
+                self.key,
+                inner.uid,
+                inner.gid,
+                inner.cuid,
+                inner.cgid,
+                inner.mode.bits(),
+            ),
+            sem_otime: self.otime(),
+            unused1: 0,
+            sem_ctime: inner.sem_ctime,
+            unused2: 0,
+            sem_nsems: self.nsems() as u64,
+            unused3: 0,
+            unused4: 0,
+        }
+    }
+}
+
+lazy_static! {
+    pub static ref SEM_MANAGER: SemManager = SemManager::new();
+}
+
+pub struct SemManager {
+    sem_sets: RwLock<IpcIds<SemSet>>,
+}
+
+impl SemManager {
+    fn new() -> Self {
+        SemManager {
+            sem_sets: RwLock::new(IpcIds::new(SEMMNI)),
+        }
+    }
+
+    fn current_time() -> time_t {
+        do_gettimeofday().sec()
+    }
+
+    fn get(&self, semid: SemId) -> Result<Arc<SemSet>> {
+        self.sem_sets.read().unwrap().get(semid)
+    }
+
+    pub fn do_semget(&self, key: key_t, nsems: i32, semflg: ShmFlags) -> Result<SemId> {
+        debug!(
+            "do_semget: key: {:?}, nsems: {:?}, semflg: {:?}",
+            key, nsems, semflg
+        );
+        if nsems < 0 || nsems as usize > SEMMSL {
+            return_errno!(EINVAL, "invalid nsems");
+        }
+        let nsems = nsems as usize;
+
+        let mut sem_sets = self.sem_sets.write().unwrap();
+        if key != IPC_PRIVATE {
+            if let Some(sem_set) = sem_sets.find_by_key(key, |sem_set| sem_set.key) {
+                if semflg.contains(ShmFlags::IPC_CREAT) && semflg.contains(ShmFlags::IPC_EXCL) {
+                    return_errno!(EEXIST, "the semaphore set already exists for given key");
+                }
+                if nsems > sem_set.nsems() {
+                    return_errno!(EINVAL, "nsems is larger than that of the set");
+                }
+                return Ok(sem_set.semid);
+            }
+            if !semflg.contains(ShmFlags::IPC_CREAT) {
+                return_errno!(ENOENT, "no semaphore set exists for given key");
+            }
+        }
+        if nsems == 0 {
+            return_errno!(EINVAL, "nsems must be positive to create a semaphore set");
+        }
+        let mode = semflg.to_file_mode();
+        let sem_set = sem_sets.insert(|semid| Ok(SemSet::new(semid, key, nsems, mode)))?;
+        Ok(sem_set.semid)
+    }
+
+    pub fn do_semop(
+        &self,
+        semid: SemId,
+        sops: &[sembuf],
+        timeout: Option<&mut Duration>,
+    ) -> Result<()> {
+        debug!("do_semop: semid: {:?}, sops: {:?}", semid, sops);
+        if sops
+            .iter()
+            .any(|sop| sop.sem_flg & !(IPC_NOWAIT | SEM_UNDO) != 0)
+        {
+            return_errno!(EINVAL, "invalid sem_flg");
+        }
+        let sem_set = self.get(semid)?;
+        if sops
+            .iter()
+            .any(|sop| sop.sem_num as usize >= sem_set.nsems())
+        {
+            return_errno!(EFBIG, "invalid sem_num");
+        }
+        sem_set.semop(sops, timeout)
+    }
+
+    pub fn do_semctl(&self, semid: SemId, semnum: i32, cmd: CmdId, arg: usize) -> Result<isize> {
+        debug!(
+            "do_semctl: semid: {:?}, semnum: {:?}, cmd: {:?}, arg: {:#x}",
+            semid, semnum, cmd, arg
+        );
+        match cmd {
+            IPC_INFO | SEM_INFO => {
+                let buf = arg as *mut seminfo;
+                from_user::check_mut_ptr(buf)?;
+                let sem_sets = self.sem_sets.read().unwrap();
+                let (semusz, semaem) = if cmd == SEM_INFO {
+                    let sets = sem_sets.sorted();
+                    let nr_sems: usize = sets.iter().map(|(_, sem_set)| sem_set.nsems()).sum();
+                    (sets.len() as i32, nr_sems as i32)
+                } else {
+                    (20, SEMAEM)
+                };
+                unsafe {
+                    *buf = seminfo {
+                        semmap: SEMMNS as i32,
+                        semmni: SEMMNI as i32,
+                        semmns: SEMMNS as i32,
+                        semmnu: SEMMNS as i32,
+                        semmsl: SEMMSL as i32,
+                        semopm: SEMOPM as i32,
+                        semume: SEMOPM as i32,
+                        semusz,
+                        semvmx: SEMVMX,
+                        semaem,
+                    };
+                }
+                return Ok(sem_sets.max_used_id() as isize);
+            }
+            IPC_RMID => {
+                let sem_set = self.sem_sets.write().unwrap().remove(semid)?;
+                sem_set.is_removed.store(true, Ordering::Release);
+                sem_set.waiters.dequeue_and_wake_all();
+                return Ok(0);
+            }
+            _ => {}
+        }
+
+        let sem_set = self.get(semid)?;
+        let ret = match cmd {
+            IPC_STAT | SEM_STAT | SEM_STAT_ANY => {
+                let buf = arg as *mut semid64_ds;
+                from_user::check_mut_ptr(buf)?;
+                unsafe {
+                    *buf = sem_set.stat();
+                }
+                if cmd == IPC_STAT {
+                    0
+                } else {
+                    semid as isize
+                }
+            }
+            IPC_SET => {
+                let buf = arg as *const semid64_ds;
+                from_user::check_ptr(buf)?;
+                let perm = unsafe { &(*buf).sem_perm };
+                let mut inner = sem_set.inner.lock().unwrap();
+                inner.uid = perm.uid;
+                inner.gid = perm.gid;
+                inner.mode = FileMode::from_bits_truncate(perm.mode & 0o777);
+                inner.sem_ctime = Self::current_time();
+                0
+            }
+            GETVAL => sem_set.sem(semnum)?.val.load(Ordering::SeqCst) as isize,
+            GETPID => sem_set.sem(semnum)?.pid.load(Ordering::Relaxed) as isize,
+            GETNCNT | GETZCNT => {
+                sem_set.sem(semnum)?;
+                let inner = sem_set.inner.lock().unwrap();
+                let cnts = if cmd == GETNCNT {
+                    &inner.ncnts
+                } else {
+                    &inner.zcnts
+                };
+                cnts[semnum as usize] as isize
+            }
+            GETALL => {
+                let buf = arg as *mut u16;
+                from_user::check_mut_array(buf, sem_set.nsems())?;
+                let vals = unsafe { std::slice::from_raw_parts_mut(buf, sem_set.nsems()) };
+                for (val, sem) in vals.iter_mut().zip(&sem_set.sems) {
+                    *val = sem.val.load(Ordering::SeqCst) as u16;
+                }
+                0
+            }
+            SETVAL => {
+                sem_set.sem(semnum)?;
+                // The value is the int in the union semun
+                let val = arg as u32 as i32;
+                sem_set.set_vals(&[(semnum as usize, val)])?;
+                0
+            }
+            SETALL => {
+                let buf = arg as *const u16;
+                from_user::check_array(buf, sem_set.nsems())?;
+                let vals: Vec<(usize, i32)> =
+                    unsafe { std::slice::from_raw_parts(buf, sem_set.nsems()) }
+                        .iter()
+                        .enumerate()
+                        .map(|(semnum, &val)| (semnum, val as i32))
+                        .collect();
+                sem_set.set_vals(&vals)?;
+                0
+            }
+            _ => return_errno!(EINVAL, "unimplemented cmd"),
+        };
+        Ok(ret)
+    }
+
+    pub fn undo_when_process_exit(&self, thread: &ThreadRef) {
+        let pid = thread.process().pid();
+        let sem_sets = self.sem_sets.read().unwrap().sorted();
+        for (_, sem_set) in sem_sets {
+            let has_undos = sem_set.inner.lock().unwrap().undos.contains_key(&pid);
+            if has_undos {
+                sem_set.undo(pid);
+            }
+        }
+    }
+
+    /// The content of /proc/sysvipc/sem
+    pub fn proc_info(&self) -> String {
+        let mut info = String::from(
+            "       key      semid perms      nsems   uid   gid  cuid  cgid      otime      ctime\n",
+        );
+        for (semid, sem_set) in self.sem_sets.read().unwrap().sorted() {
+            let inner = sem_set.inner.lock().unwrap();
+            info += &format!(
+                "{:>10} {:>10}  {:>4o} {:>10} {:>5} {:>5} {:>5} {:>5} {:>10} {:>10}\n",
+                sem_set.key as i32,
+                semid,
+                inner.mode.bits(),
+                sem_set.nsems(),
+                inner.uid,
+                inner.gid,
+                inner.cuid,
+                inner.cgid,
+                sem_set.otime(),
+                inner.sem_ctime,
+            );
+        }
+        info
+    }
+}
@@ -21,13 +21,13 @@ const SHMMAX: usize = (usize::MAX - (1_usize << 24));
 // also indicates the max shmid - 1 in Occlum
 const SHMMNI: ShmId = 4096;
 
-const IPC_PRIVATE: key_t = 0;
+pub(super) const IPC_PRIVATE: key_t = 0;
 
-// For cmd in shmctl()
-const IPC_RMID: CmdId = 0;
-const IPC_SET: CmdId = 1;
-const IPC_STAT: CmdId = 2;
-const IPC_INFO: CmdId = 3;
+// For cmd in shmctl(), semctl() and msgctl()
+pub(super) const IPC_RMID: CmdId = 0;
+pub(super) const IPC_SET: CmdId = 1;
+pub(super) const IPC_STAT: CmdId = 2;
+pub(super) const IPC_INFO: CmdId = 3;
 const SHM_LOCK: CmdId = 11;
 const SHM_UNLOCK: CmdId = 12;
 const SHM_STAT: CmdId = 13;
@@ -37,13 +37,13 @@ const SHM_STAT_ANY: CmdId = 15;
 #[allow(non_camel_case_types)]
 #[derive(Debug)]
 #[repr(C)]
-struct ipc_perm_t {
-    key: key_t,
-    uid: uid_t,
-    gid: gid_t,
-    cuid: uid_t,
-    cgid: gid_t,
-    mode: u16,
+pub(super) struct ipc_perm_t {
+    pub(super) key: key_t,
+    pub(super) uid: uid_t,
+    pub(super) gid: gid_t,
+    pub(super) cuid: uid_t,
+    pub(super) cgid: gid_t,
+    pub(super) mode: u16,
     pad1: u16,
     seq: u16,
     pad2: u16,
@@ -51,6 +51,31 @@ struct ipc_perm_t {
     unused2: u64,
 }
 
+impl ipc_perm_t {
+    pub(super) fn new(
+        key: key_t,
+        uid: uid_t,
+        gid: gid_t,
+        cuid: uid_t,
+        cgid: gid_t,
+        mode: u16,
+    ) -> Self {
+        Self {
+            key,
+            uid,
+            gid,
+            cuid,
+            cgid,
+            mode,
+            pad1: 0,
+            seq: 0,
+            pad2: 0,
+            unused1: 0,
+            unused2: 0,
+        }
+    }
+}
+
 #[allow(non_camel_case_types)]
 #[derive(Debug)]
 #[repr(C)]
@@ -104,7 +129,7 @@ bitflags! {
 }
 
 impl ShmFlags {
-    fn to_file_mode(&self) -> FileMode {
+    pub(super) fn to_file_mode(&self) -> FileMode {
         let mut shmflgs = *self;
         shmflgs.remove(ShmFlags::IPC_CREAT);
         shmflgs.remove(ShmFlags::IPC_EXCL);
@@ -503,4 +528,37 @@ impl ShmManager {
             self.free_shmid(&shm.shmid);
         }
     }
+
+    /// The content of /proc/sysvipc/shm
+    pub fn proc_info(&self) -> String {
+        let mut info = String::from(
+            "       key      shmid perms                  size  cpid  lpid nattch   uid   gid  cuid  cgid      atime      dtime      ctime                   rss                  swap\n",
+        );
+        let shm_segments = self.shm_segments.read().unwrap();
+        let mut shms: Vec<&ShmSegment> = shm_segments.values().collect();
+        shms.sort_by_key(|shm| shm.shmid);
+        for shm in shms {
+            info += &format!(
+                "{:>10} {:>10}  {:>4o} {:>21} {:>5} {:>5}  {:>5} {:>5} {:>5} {:>5} {:>5} {:>10} {:>10} {:>10} {:>21} {:>21}\n",
+                shm.key as i32,
+                shm.shmid,
+                shm.mode.bits() | shm.status.bits(),
+                shm.shm_size(),
+                shm.shm_cpid,
+                shm.shm_lpid,
+                shm.shm_nattach,
+                shm.uid,
+                shm.gid,
+                shm.cuid,
+                shm.cgid,
+                shm.shm_atime,
+                shm.shm_dtime,
+                shm.shm_ctime,
+                // The segments are always resident
+                shm.shm_size(),
+                0,
+            );
+        }
+        info
+    }
 }
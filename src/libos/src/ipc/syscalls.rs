@@ -2,7 +2,16 @@ use super::*;
 
 use util::mem_util::from_user;
 
+use super::msg::{Message, MsgFlags, MsgId, MSGMAX, MSG_MANAGER};
+use super::sem::{sembuf, SemId, SEMOPM, SEM_MANAGER};
 use super::shm::{shmids_t, CmdId, ShmFlags, ShmId, SHM_MANAGER};
+use crate::time::timespec_t;
+
+// The flag of the new version of the ctl commands, whose structures are the same as
+// the old ones on x86-64
+const IPC_64: CmdId = 0x100;
+
+const MTYPE_SIZE: usize = std::mem::size_of::<i64>();
 
 pub fn do_shmget(key: key_t, size: size_t, shmflg: i32) -> Result<isize> {
     let shmflg =
@@ -34,3 +43,90 @@ pub fn do_shmctl(shmid: i32, cmd: i32, buf_u: *mut shmids_t) -> Result<isize> {
     SHM_MANAGER.do_shmctl(shmid as ShmId, cmd as CmdId, buf)?;
     Ok(0)
 }
+
+pub fn do_semget(key: key_t, nsems: i32, semflg: i32) -> Result<isize> {
+    let semflg =
+        ShmFlags::from_bits(semflg as u32).ok_or_else(|| errno!(EINVAL, "invalid flags"))?;
+    let semid = SEM_MANAGER.do_semget(key, nsems, semflg)?;
+    Ok(semid as isize)
+}
+
+pub fn do_semop(semid: i32, sops: *const sembuf, nsops: size_t) -> Result<isize> {
+    do_semtimedop(semid, sops, nsops, std::ptr::null())
+}
+
+pub fn do_semtimedop(
+    semid: i32,
+    sops: *const sembuf,
+    nsops: size_t,
+    timeout: *const timespec_t,
+) -> Result<isize> {
+    if nsops == 0 {
+        return_errno!(EINVAL, "no operation");
+    }
+    if nsops > SEMOPM {
+        return_errno!(E2BIG, "too many operations");
+    }
+    from_user::check_array(sops, nsops)?;
+    let sops = unsafe { std::slice::from_raw_parts(sops, nsops) }.to_vec();
+    let mut timeout = if timeout.is_null() {
+        None
+    } else {
+        Some(timespec_t::from_raw_ptr(timeout)?.as_duration())
+    };
+    SEM_MANAGER.do_semop(semid as SemId, &sops, timeout.as_mut())?;
+    Ok(0)
+}
+
+pub fn do_semctl(semid: i32, semnum: i32, cmd: i32, arg: usize) -> Result<isize> {
+    SEM_MANAGER.do_semctl(semid as SemId, semnum, cmd as CmdId & !IPC_64, arg)
+}
+
+pub fn do_msgget(key: key_t, msgflg: i32) -> Result<isize> {
+    let msgflg =
+        ShmFlags::from_bits(msgflg as u32).ok_or_else(|| errno!(EINVAL, "invalid flags"))?;
+    let msqid = MSG_MANAGER.do_msgget(key, msgflg)?;
+    Ok(msqid as isize)
+}
+
+pub fn do_msgsnd(msqid: i32, msgp: *const c_void, msgsz: size_t, msgflg: i32) -> Result<isize> {
+    if msgsz > MSGMAX {
+        return_errno!(EINVAL, "the message is too long");
+    }
+    // The message is a long of the type followed by the text
+    from_user::check_array(msgp as *const u8, MTYPE_SIZE + msgsz)?;
+    let mtype = unsafe { std::ptr::read_unaligned(msgp as *const i64) };
+    let text =
+        unsafe { std::slice::from_raw_parts((msgp as *const u8).add(MTYPE_SIZE), msgsz) }.to_vec();
+    let msgflg = MsgFlags::from_bits_truncate(msgflg);
+    MSG_MANAGER.do_msgsnd(msqid as MsgId, Message::new(mtype, text), msgflg)?;
+    Ok(0)
+}
+
+pub fn do_msgrcv(
+    msqid: i32,
+    msgp: *mut c_void,
+    msgsz: size_t,
+    msgtyp: i64,
+    msgflg: i32,
+) -> Result<isize> {
+    if msgsz > isize::MAX as usize {
+        return_errno!(EINVAL, "invalid size");
+    }
+    // A message is never longer than MSGMAX
+    let max_len = msgsz.min(MSGMAX);
+    from_user::check_mut_array(msgp as *mut u8, MTYPE_SIZE + max_len)?;
+    let msgflg = MsgFlags::from_bits_truncate(msgflg);
+    let message = MSG_MANAGER.do_msgrcv(msqid as MsgId, msgsz, msgtyp, msgflg)?;
+    let len = message.text().len().min(max_len);
+    unsafe {
+        std::ptr::write_unaligned(msgp as *mut i64, message.mtype());
+        std::slice::from_raw_parts_mut((msgp as *mut u8).add(MTYPE_SIZE), len)
+            .copy_from_slice(&message.text()[..len]);
+    }
+    Ok(len as isize)
+}
+
+pub fn do_msgctl(msqid: i32, cmd: i32, buf: usize) -> Result<isize> {
+    MSG_MANAGER.do_msgctl(msqid as MsgId, cmd as CmdId & !IPC_64, buf)
+}
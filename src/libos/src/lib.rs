@@ -18,6 +18,7 @@
 #![feature(slice_ptr_get)]
 #![feature(maybe_uninit_extra)]
 #![feature(get_mut_unchecked)]
+#![feature(new_uninit)]
 // for std::hint::black_box
 #![feature(test)]
 #![feature(atomic_from_mut)]
@@ -52,7 +53,6 @@ extern crate rcore_fs_sefs;
 extern crate rcore_fs_unionfs;
 #[macro_use]
 extern crate derive_builder;
-extern crate ringbuf;
 extern crate serde;
 extern crate serde_json;
 #[macro_use]
@@ -266,7 +266,7 @@ impl EpollFile {
             notifier.register(weak_observer, Some(IoEvents::all()), Some(weak_ep_entry));
 
             // Handle host file
-            if ep_entry.file.host_fd().is_some() {
+            if ep_entry.host_fd.is_some() {
                 self.host_file_epoller
                     .add_file(ep_entry.file.clone(), event, flags);
                 return Ok(());
@@ -291,8 +291,8 @@ impl EpollFile {
             let weak_observer = self.weak_self.clone() as Weak<dyn Observer<_>>;
             notifier.unregister(&weak_observer);
 
-            if ep_entry.file.host_fd().is_some() {
-                self.host_file_epoller.del_file(&ep_entry.file);
+            if let Some(host_fd) = ep_entry.host_fd {
+                self.host_file_epoller.del_file(host_fd);
             }
         }
         Ok(())
@@ -315,10 +315,11 @@ impl EpollFile {
             *old_ep_inner = new_ep_inner;
             drop(old_ep_inner);
 
-            if ep_entry.file.host_fd().is_some() {
-                self.host_file_epoller
-                    .mod_file(&ep_entry.file, event, flags);
-                return Ok(());
+            if let Some(host_fd) = ep_entry.host_fd {
+                self.host_file_epoller.mod_file(host_fd, event, flags);
+                if ep_entry.file.host_fd().is_some() {
+                    return Ok(());
+                }
             }
 
             ep_entry
@@ -505,6 +506,10 @@ impl AsEpollFile for FileRef {
 struct EpollEntry {
     fd: FileDesc,
     file: FileRef,
+    // The host fd of the file when it is added, if it is a host file. A host
+    // socket may go in-enclave afterwards (e.g., connected over the loopback
+    // interface), but it stays in the host file epoller until deleted.
+    host_fd: Option<FileDesc>,
     inner: SgxMutex<EpollEntryInner>,
     // Whether the entry is in the ready list
     is_ready: AtomicBool,
@@ -517,9 +522,11 @@ impl EpollEntry {
         let is_ready = Default::default();
         let is_deleted = Default::default();
         let inner = SgxMutex::new(EpollEntryInner { event, flags });
+        let host_fd = file.host_fd().map(|host_fd| host_fd.to_raw());
         Self {
             fd,
             file,
+            host_fd,
             inner,
             is_ready,
             is_deleted,
@@ -57,7 +57,7 @@ impl HostFileEpoller {
         }
 
         self.count.fetch_add(1, Ordering::Relaxed);
-        self.do_epoll_ctl(libc::EPOLL_CTL_ADD, &host_file, Some((event, flags)))
+        self.do_epoll_ctl(libc::EPOLL_CTL_ADD, host_fd, Some((event, flags)))
 
         // Concurrency note:
         // The lock on self.host_files_and_events must be hold while invoking
@@ -67,45 +67,38 @@ impl HostFileEpoller {
 
     pub fn mod_file(
         &self,
-        host_file: &FileRef,
+        host_fd: FileDesc,
         new_event: EpollEvent,
         new_flags: EpollFlags,
     ) -> Result<()> {
         let mut host_files_and_events = self.host_files_and_events.lock().unwrap();
-        let host_fd = host_file.host_fd().unwrap().to_raw();
         let event = match host_files_and_events.get_mut(&host_fd) {
             None => return_errno!(ENOENT, "the host file must be added before modifying"),
             Some((_, event)) => event,
         };
         *event = new_event.mask;
 
-        self.do_epoll_ctl(
-            libc::EPOLL_CTL_MOD,
-            &host_file,
-            Some((new_event, new_flags)),
-        )
+        self.do_epoll_ctl(libc::EPOLL_CTL_MOD, host_fd, Some((new_event, new_flags)))
     }
 
-    pub fn del_file(&self, host_file: &FileRef) -> Result<()> {
+    pub fn del_file(&self, host_fd: FileDesc) -> Result<()> {
         let mut host_files_and_events = self.host_files_and_events.lock().unwrap();
-        let host_fd = host_file.host_fd().unwrap().to_raw();
         let not_added = !host_files_and_events.remove(&host_fd).is_some();
         if not_added {
             return_errno!(ENOENT, "the host file must be added before deleting");
         }
 
         self.count.fetch_sub(1, Ordering::Relaxed);
-        self.do_epoll_ctl(libc::EPOLL_CTL_DEL, &host_file, None)
+        self.do_epoll_ctl(libc::EPOLL_CTL_DEL, host_fd, None)
     }
 
     fn do_epoll_ctl(
         &self,
         raw_cmd: i32,
-        host_file: &FileRef,
+        host_fd: FileDesc,
         event_and_flags: Option<(EpollEvent, EpollFlags)>,
     ) -> Result<()> {
         let host_epoll_fd = self.host_epoll_fd.to_raw();
-        let host_fd = host_file.host_fd().unwrap().to_raw();
 
         let c_event = event_and_flags.map(|(event, flags)| {
             let mut c_event = event.to_c();
@@ -117,7 +110,7 @@ impl HostFileEpoller {
         try_libc!(libc::ocall::epoll_ctl(
             host_epoll_fd as i32,
             raw_cmd,
-            host_file.host_fd().unwrap().to_raw() as i32,
+            host_fd as i32,
             c_event.as_ref().map_or(ptr::null(), |c_event| c_event) as *mut _,
         ));
         Ok(())
@@ -12,7 +12,7 @@ pub use self::io_event::{
     clear_notifier_status, notify_thread, wait_for_notification, IoEvent, THREAD_NOTIFIERS,
 };
 pub use self::poll::{do_poll, PollEvent, PollEventFlags};
-pub use self::poll_new::{do_poll_new, PollFd};
+pub use self::poll_new::{do_poll_new, EventMonitor, EventMonitorBuilder, PollFd};
 pub use self::select::{do_select, FdSetExt};
 
 use fs::{AsEvent, AsINodeFile, AsTimer, CreationFlags, File, FileDesc, FileRef, HostFd, PipeType};
@@ -93,6 +93,7 @@ pub fn do_poll(pollfds: &mut [PollEvent], timeout: *mut timeval_t) -> Result<usi
         if file_ref.as_unix_socket().is_ok()
             || file_ref.as_pipe_reader().is_ok()
             || file_ref.as_pipe_writer().is_ok()
+            || file_ref.as_timer().is_ok()
         {
             let events = file_ref.poll()?;
             debug!("polled events are {:?}", events);
@@ -112,17 +113,17 @@ pub fn do_poll(pollfds: &mut [PollEvent], timeout: *mut timeval_t) -> Result<usi
         }
 
         if let Ok(socket) = file_ref.as_host_socket() {
-            let fd = socket.host_fd().unwrap().to_raw();
+            // An in-enclave loopback connection has no host fd to poll
+            let fd = socket
+                .host_fd()
+                .ok_or_else(|| errno!(EBADF, "not a supported file type"))?
+                .to_raw();
             index_host_pollfds.push(i);
             host_pollfds.push(PollEvent::new(fd, pollfd.events()));
         } else if let Ok(eventfd) = file_ref.as_event() {
             let fd = eventfd.host_fd() as FileDesc;
             index_host_pollfds.push(i);
             host_pollfds.push(PollEvent::new(fd, pollfd.events()));
-        } else if let Ok(timerfd) = file_ref.as_timer() {
-            let fd = timerfd.host_fd() as FileDesc;
-            index_host_pollfds.push(i);
-            host_pollfds.push(PollEvent::new(fd, pollfd.events()));
         } else {
             return_errno!(EBADF, "not a supported file type");
         }
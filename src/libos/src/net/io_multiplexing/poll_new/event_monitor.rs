@@ -1,18 +1,23 @@
 use std::cell::Cell;
-use std::ptr;
 use std::sync::Weak;
 use std::time::Duration;
 
-use crate::events::{Observer, Waiter, WaiterQueueObserver};
+use crate::events::{poll_host_fds, Observer, Waiter, WaiterQueueObserver};
 use crate::fs::{AtomicIoEvents, IoEvents};
+use crate::net::{wait_tracked_host_sockets, HostSocketType};
 use crate::prelude::*;
-use crate::time::{timespec_t, TIMERSLACK};
 
 /// Monitor events that happen on a set of interesting files.
 ///
 /// The event monitor can wait for events on both LibOS files and host files.
 /// Event better, as a result of waiting for the events of host files, the
 /// states of host files (returned by the `poll` method) are also updated.
+///
+/// Host sockets are special host files, whose states are cached and tracked
+/// (see `HostSocket::track_host_events`). If the cached states are enough,
+/// no OCall is needed to poll them. And if all host files are tracked host
+/// sockets, the monitor waits for the events of them without passing the array
+/// of their fds to the host.
 pub struct EventMonitor {
     // The set of interesting files and their events.
     files_and_events: Vec<(FileRef, IoEvents)>,
@@ -21,10 +26,10 @@ pub struct EventMonitor {
     // An array of struct pollfd as the argument for the poll syscall via OCall.
     //
     // The items in `ocall_pollfds` corresponds to the items in
-    // `host_file_idxes` on a one-on-one basis, except the last item in
-    // `ocall_pollfds`. This indicates that `ocall_pollfds.len() ==
-    // host_files_idxes.len() + 1`.
+    // `host_file_idxes` on a one-on-one basis.
     ocall_pollfds: Vec<libc::pollfd>,
+    // Whether all host files are tracked host sockets.
+    host_files_tracked: bool,
     // An observer and also a waiter queue.
     observer: Arc<WaiterQueueObserver<IoEvents>>,
     // A waiter.
@@ -73,83 +78,59 @@ impl EventMonitor {
             }
         }
 
-        // The do_ocall method returns when one of the following conditions is satisfied:
+        if self.host_files_tracked && !self.host_file_idxes.is_empty() {
+            // The states of the host sockets are updated by the tracker
+            wait_tracked_host_sockets(
+                &self.waiter,
+                timeout.as_mut().map(|timeout| &mut **timeout),
+            )?;
+            return Ok(timeout);
+        }
+
+        // The wait_host_fds method returns when one of the following conditions is satisfied:
         // 1. self.waiter is waken, indicating some interesting events happen on the LibOS files;
         // 2. some interesting events happen on the host files;
         // 3. a signal arrives;
         // 4. the time is up.
-        let num_events = self.do_poll_ocall(&mut timeout)?;
+        let num_events = self
+            .waiter
+            .wait_host_fds(&mut self.ocall_pollfds, timeout.as_deref_mut())?;
 
         self.update_host_file_events();
 
         // Poll syscall does not treat timeout as error. So we need
         // to distinguish the case by ourselves.
-        if let Some(timeout) = timeout.as_mut() {
-            if num_events == 0 {
-                **timeout = ZERO;
-                return_errno!(ETIMEDOUT, "no results and the time is up");
-            }
+        if num_events == 0 && !self.waiter.is_woken() {
+            return_errno!(ETIMEDOUT, "no results and the time is up");
         }
-        assert!(num_events > 0);
 
         Ok(timeout)
     }
 
+    /// Whether the cached states of the host files are enough to tell their
+    /// interesting events, which is only possible for host sockets.
+    pub fn is_host_files_cached(&self) -> bool {
+        self.host_files_and_events()
+            .all(|(file, mask)| match file.as_host_socket() {
+                Ok(socket) => socket.is_host_events_cached(mask),
+                Err(_) => false,
+            })
+    }
+
     /// Poll the host files among the set of the interesting files and update
     /// their states accordingly.
     pub fn poll_host_files(&mut self) {
         let mut zero_timeout = Some(Duration::from_secs(0));
-        if let Err(_) = self.do_poll_ocall(&mut zero_timeout.as_mut()) {
+        if let Err(_) = poll_host_fds(&mut self.ocall_pollfds, zero_timeout.as_mut(), None) {
             return;
         }
 
         self.update_host_file_events();
     }
 
-    fn do_poll_ocall(&mut self, timeout: &mut Option<&mut Duration>) -> Result<usize> {
-        extern "C" {
-            fn occlum_ocall_poll_with_eventfd(
-                ret: *mut i32,
-                fds: *mut libc::pollfd,
-                nfds: u32,
-                timeout: *mut timespec_t,
-                eventfd_idx: i32,
-            ) -> sgx_status_t;
-        }
-
-        // Do poll syscall via OCall
-        let num_events = try_libc!({
-            let mut remain_c = timeout.as_ref().map(|timeout| timespec_t::from(**timeout));
-            let remain_c_ptr = remain_c.as_mut().map_or(ptr::null_mut(), |mut_ref| mut_ref);
-
-            let host_eventfd_idx = self.ocall_pollfds.len() - 1;
-
-            let mut ret = 0;
-            let status = unsafe {
-                occlum_ocall_poll_with_eventfd(
-                    &mut ret,
-                    (&mut self.ocall_pollfds[..]).as_mut_ptr(),
-                    self.ocall_pollfds.len() as u32,
-                    remain_c_ptr,
-                    host_eventfd_idx as i32,
-                )
-            };
-            assert!(status == sgx_status_t::SGX_SUCCESS);
-
-            if let Some(timeout) = timeout.as_mut() {
-                let remain = remain_c.unwrap().as_duration();
-                assert!(remain <= **timeout + TIMERSLACK.to_duration());
-                **timeout = remain;
-            }
-
-            ret
-        }) as usize;
-        Ok(num_events)
-    }
-
     fn update_host_file_events(&self) {
         // According to the output pollfds, update the states of the corresponding host files
-        let output_pollfds = self.ocall_pollfds[..self.ocall_pollfds.len() - 1].iter();
+        let output_pollfds = self.ocall_pollfds.iter();
         for (pollfd, (host_file, mask)) in output_pollfds.zip(self.host_files_and_events()) {
             let revents = {
                 assert!((pollfd.revents & libc::POLLNVAL) == 0);
@@ -171,6 +152,7 @@ pub struct EventMonitorBuilder {
     files_and_events: Vec<(FileRef, IoEvents)>,
     host_file_idxes: Vec<usize>,
     ocall_pollfds: Vec<libc::pollfd>,
+    host_files_tracked: bool,
     observer: Arc<WaiterQueueObserver<IoEvents>>,
     waiter: Waiter,
 }
@@ -180,12 +162,14 @@ impl EventMonitorBuilder {
         let files_and_events = Vec::with_capacity(expected_num_files);
         let host_file_idxes = Vec::new();
         let ocall_pollfds = Vec::new();
+        let host_files_tracked = true;
         let observer = WaiterQueueObserver::new();
         let waiter = Waiter::new();
         Self {
             files_and_events,
             host_file_idxes,
             ocall_pollfds,
+            host_files_tracked,
             observer,
             waiter,
         }
@@ -195,6 +179,15 @@ impl EventMonitorBuilder {
         if file.host_fd().is_some() {
             let host_file_idx = self.files_and_events.len();
             self.host_file_idxes.push(host_file_idx);
+
+            // Track a host socket before polling it so that no events are missed
+            let tracked = match file.as_host_socket() {
+                Ok(socket) => socket.track_host_events().is_ok(),
+                Err(_) => false,
+            };
+            if !tracked {
+                self.host_files_tracked = false;
+            }
         }
 
         self.files_and_events.push((file, events));
@@ -216,13 +209,6 @@ impl EventMonitorBuilder {
                 revents: 0,
             });
         }
-
-        // Add one more for waiter's underlying host eventfd
-        ocall_pollfds.push(libc::pollfd {
-            fd: self.waiter.host_eventfd().host_fd() as i32,
-            events: libc::POLLIN,
-            revents: 0,
-        });
     }
 
     fn init_observer(&self) {
@@ -239,6 +225,7 @@ impl EventMonitorBuilder {
                 files_and_events,
                 host_file_idxes,
                 ocall_pollfds,
+                host_files_tracked,
                 observer,
                 waiter,
             } = self;
@@ -246,11 +233,14 @@ impl EventMonitorBuilder {
                 files_and_events,
                 host_file_idxes,
                 ocall_pollfds,
+                host_files_tracked,
                 observer,
                 waiter,
             }
         };
-        new_event_monitor.poll_host_files();
+        if !new_event_monitor.is_host_files_cached() {
+            new_event_monitor.poll_host_files();
+        }
         new_event_monitor
     }
 }
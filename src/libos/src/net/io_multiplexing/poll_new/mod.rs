@@ -5,7 +5,7 @@ use std::time::Duration;
 use crate::fs::IoEvents;
 use crate::prelude::*;
 
-use self::event_monitor::{EventMonitor, EventMonitorBuilder};
+pub use self::event_monitor::{EventMonitor, EventMonitorBuilder};
 
 mod event_monitor;
 
@@ -3,13 +3,14 @@ use std;
 use untrusted::{SliceAsMutPtrAndLen, SliceAsPtrAndLen, UntrustedSlice, UntrustedSliceAlloc};
 
 pub use self::io_multiplexing::{
-    clear_notifier_status, notify_thread, wait_for_notification, EpollEvent, IoEvent, PollEvent,
-    PollEventFlags, PollFd, THREAD_NOTIFIERS,
+    clear_notifier_status, notify_thread, wait_for_notification, EpollEvent, EventMonitor,
+    EventMonitorBuilder, IoEvent, PollEvent, PollEventFlags, PollFd, THREAD_NOTIFIERS,
 };
 pub use self::socket::{
-    mmsghdr, msghdr, msghdr_mut, socketpair, unix_socket, AddressFamily, AsUnixSocket, FileFlags,
-    HostSocket, HostSocketType, HowToShut, Iovs, IovsMut, MsgHdr, MsgHdrFlags, MsgHdrMut,
-    RecvFlags, SendFlags, SliceAsLibcIovec, SockAddr, SocketType, UnixAddr,
+    mmsghdr, mmsghdr_mut, msghdr, msghdr_mut, socketpair, unix_socket, wait_tracked_host_sockets,
+    AddressFamily, AsUnixDatagram, AsUnixSocket, FileFlags, HostSocket, HostSocketType, HowToShut,
+    Iovs, IovsMut, MsgHdr, MsgHdrFlags, MsgHdrMut, RecvFlags, SendFlags, SliceAsLibcIovec,
+    SockAddr, SocketType, UnixAddr,
 };
 pub use self::syscalls::*;
 
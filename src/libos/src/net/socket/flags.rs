@@ -20,6 +20,7 @@ bitflags! {
         const MSG_DONTWAIT     = 0x40;       // Nonblocking io
         const MSG_WAITALL      = 0x0100;     // Wait for a full request
         const MSG_ERRQUEUE     = 0x2000;     // Fetch message from error queue
+        const MSG_WAITFORONE   = 0x10000;    // Nonblocking io after the first message of recvmmsg
         const MSG_CMSG_CLOEXEC = 0x40000000; // Set close_on_exec for file descriptor received through M_RIGHTS
     }
 }
@@ -0,0 +1,129 @@
+//! Blocking I/O on host sockets in the M:N mode.
+//!
+//! A thread must not block in the host in the M:N mode, or it would hold its vCPU until
+//! the OCall returns. So every host socket is non-blocking in the host in the M:N mode,
+//! whatever its status flags are. A blocking I/O operation that would block is retried
+//! once the host socket has the events that it waits for, while the thread parks and
+//! the vCPU polls the host socket on its behalf. The timeouts set by `SO_RCVTIMEO`
+//! and `SO_SNDTIMEO` are honored as the host would do.
+
+use std::sync::atomic::Ordering;
+use std::time::Duration;
+
+use super::*;
+use crate::events::Waiter;
+use crate::process::task::is_vcpu_enabled;
+
+/// The flags to create a host socket with, which make the host socket non-blocking in
+/// the M:N mode.
+pub(super) fn host_socket_flags(file_flags: FileFlags) -> FileFlags {
+    if is_vcpu_enabled() {
+        file_flags | FileFlags::SOCK_NONBLOCK
+    } else {
+        file_flags
+    }
+}
+
+impl HostSocket {
+    /// Whether a blocking I/O operation on the socket waits in the LibOS, i.e., the
+    /// socket is blocking while the host socket is not.
+    pub(super) fn is_blocking_in_libos(&self) -> bool {
+        is_vcpu_enabled() && !self.nonblocking.load(Ordering::Relaxed)
+    }
+
+    /// Do an I/O operation on the host socket. If the operation would block and it is
+    /// a blocking one, wait for the events and retry.
+    pub(super) fn block_on_host<T, F>(
+        &self,
+        events: IoEvents,
+        is_nonblocking: bool,
+        mut op: F,
+    ) -> Result<T>
+    where
+        F: FnMut() -> Result<T>,
+    {
+        // Read from the host socket before the first wait
+        let mut timeout = None;
+        loop {
+            match op() {
+                Err(e) if e.errno() == EAGAIN && !is_nonblocking && is_vcpu_enabled() => {}
+                res => return res,
+            }
+
+            if timeout.is_none() {
+                timeout = Some(self.host_timeout(events)?);
+            }
+            let remain = timeout.as_mut().unwrap().as_mut();
+            self.wait_host_events(events, remain)?;
+        }
+    }
+
+    /// Wait for the connection in progress of a blocking connect to be established.
+    pub(super) fn wait_host_connected(&self) -> Result<()> {
+        let mut timeout = self.host_timeout(IoEvents::OUT)?;
+        if let Err(e) = self.wait_host_events(IoEvents::OUT, timeout.as_mut()) {
+            if e.errno() == EAGAIN {
+                return_errno!(EINPROGRESS, "the timeout of the socket expires");
+            }
+            return Err(e);
+        }
+
+        let mut error: c_int = 0;
+        let mut error_len = std::mem::size_of::<c_int>() as libc::socklen_t;
+        try_libc!(libc::ocall::getsockopt(
+            self.raw_host_fd()? as i32,
+            libc::SOL_SOCKET,
+            libc::SO_ERROR,
+            &mut error as *mut c_int as *mut c_void,
+            &mut error_len
+        ));
+        if error != 0 {
+            return_errno!(Errno::from(error as u32), "failed to connect");
+        }
+        Ok(())
+    }
+
+    // Wait until the host socket has any of the events, or the method call is timeout or
+    // interrupted
+    fn wait_host_events(&self, events: IoEvents, timeout: Option<&mut Duration>) -> Result<()> {
+        let mut pollfds = [libc::pollfd {
+            fd: self.raw_host_fd()? as i32,
+            events: events.to_raw() as i16,
+            revents: 0,
+        }];
+        // Nobody wakes up the waiter
+        let waiter = Waiter::new();
+        if waiter.wait_host_fds(&mut pollfds, timeout)? == 0 {
+            return_errno!(EAGAIN, "the timeout of the socket expires");
+        }
+        Ok(())
+    }
+
+    // The timeout of the blocking I/O operations that wait for the events, which is set
+    // by SO_RCVTIMEO or SO_SNDTIMEO
+    fn host_timeout(&self, events: IoEvents) -> Result<Option<Duration>> {
+        let optname = if events.contains(IoEvents::IN) {
+            libc::SO_RCVTIMEO
+        } else {
+            libc::SO_SNDTIMEO
+        };
+        let mut timeval = libc::timeval {
+            tv_sec: 0,
+            tv_usec: 0,
+        };
+        let mut timeval_len = std::mem::size_of::<libc::timeval>() as libc::socklen_t;
+        try_libc!(libc::ocall::getsockopt(
+            self.raw_host_fd()? as i32,
+            libc::SOL_SOCKET,
+            optname,
+            &mut timeval as *mut libc::timeval as *mut c_void,
+            &mut timeval_len
+        ));
+
+        // A zero timeout (or an invalid one returned by the host) means no timeout
+        let timeout = Duration::from_secs(timeval.tv_sec.max(0) as u64)
+            .checked_add(Duration::from_micros(timeval.tv_usec.max(0) as u64))
+            .filter(|timeout| *timeout != Duration::from_secs(0));
+        Ok(timeout)
+    }
+}
@@ -7,13 +7,34 @@ impl HostSocket {
             return self.ioctl_getifconf(arg_ref);
         }
 
+        if let Some(stream) = self.loopback_stream() {
+            match cmd {
+                IoctlCmd::FIONREAD(arg) => {
+                    **arg = stream.bytes_to_read().min(std::i32::MAX as usize) as i32;
+                    return Ok(0);
+                }
+                IoctlCmd::FIONBIO(nonblocking) => {
+                    self.set_nonblocking(**nonblocking != 0);
+                    return Ok(0);
+                }
+                _ => {}
+            }
+        } else if let IoctlCmd::FIONBIO(nonblocking) = cmd {
+            self.nonblocking
+                .store(**nonblocking != 0, Ordering::Relaxed);
+            // The host socket may be kept non-blocking for the in-enclave peers
+            if self.is_host_always_nonblocking() {
+                return Ok(0);
+            }
+        }
+
         let cmd_num = cmd.cmd_num() as c_int;
         let cmd_arg_ptr = cmd.arg_ptr() as *mut c_void;
         let ret = try_libc!({
             let mut retval: i32 = 0;
             let status = occlum_ocall_ioctl(
                 &mut retval as *mut i32,
-                self.raw_host_fd() as i32,
+                self.raw_host_fd()? as i32,
                 cmd_num,
                 cmd_arg_ptr,
                 cmd.arg_len(),
@@ -36,7 +57,7 @@ impl HostSocket {
             let mut retval: i32 = 0;
             let status = occlum_ocall_ioctl_repack(
                 &mut retval as *mut i32,
-                self.raw_host_fd() as i32,
+                self.raw_host_fd()? as i32,
                 BuiltinIoctlNum::SIOCGIFCONF as i32,
                 arg_ref.ifc_buf,
                 arg_ref.ifc_len,
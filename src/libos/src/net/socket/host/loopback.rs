@@ -0,0 +1,708 @@
+//! An in-enclave fast path for TCP connections over the loopback interface.
+//!
+//! See `loopback_datagram` for the fast path of UDP datagrams.
+//!
+//! When both ends of a TCP connection over 127.0.0.0/8 live in the same LibOS
+//! instance, there is no need to bounce the data through the host kernel. A
+//! listening `HostSocket` bound to a loopback (or wildcard) IPv4 address
+//! registers itself in `LOOPBACK_LISTENERS`. A `HostSocket` connecting to such
+//! an address is then paired with the listener by two endpoints borrowed from
+//! the unix stream socket, so that sending and receiving data involves no OCalls
+//! at all.
+//!
+//! The host sockets are still created and bound. This keeps the control path
+//! (e.g., setsockopt and getsockopt) working and the ports reserved in the host,
+//! so that the host connections and the in-enclave ones never collide. The only
+//! exception is an accepted socket, whose host socket is created once its control
+//! path is used, so that an in-enclave accept needs no OCalls either.
+//!
+//! Peeking, MSG_WAITALL and out-of-band data work as in Linux, except that an urgent
+//! byte is not placed in the stream, i.e., there is no urgent mark.
+
+use std::fmt;
+use std::ptr;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Weak;
+
+use super::loopback_datagram::LoopbackDatagram;
+use super::*;
+use crate::events::{Observer, Waiter, WaiterQueue, WaiterQueueObserver};
+use crate::net::socket::unix::{end_pair, Endpoint, RelayNotifier};
+use crate::process::task::is_vcpu_enabled;
+
+lazy_static! {
+    /// The listeners that accept in-enclave connections, indexed by their IPv4
+    /// addresses and ports (in host byte order).
+    static ref LOOPBACK_LISTENERS: SgxMutex<HashMap<(u32, u16), Arc<LoopbackListener>>> =
+        SgxMutex::new(HashMap::new());
+}
+
+/// The in-enclave status of a host socket.
+pub(super) enum Loopback {
+    /// Not involved in any in-enclave connection.
+    None,
+    /// Listening for both in-enclave connections and host connections.
+    Listening(Arc<LoopbackListener>),
+    /// Connected in-enclave. The data path bypasses the host socket entirely.
+    Connected(Arc<LoopbackStream>),
+    /// Receiving both in-enclave datagrams and host datagrams.
+    Datagram(Arc<LoopbackDatagram>),
+}
+
+impl Debug for Loopback {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        match self {
+            Loopback::None => write!(f, "None"),
+            Loopback::Listening(listener) => {
+                f.debug_tuple("Listening").field(&listener.addr).finish()
+            }
+            Loopback::Connected(stream) => f
+                .debug_struct("Connected")
+                .field("addr", &stream.addr)
+                .field("peer_addr", &stream.peer_addr)
+                .finish(),
+            Loopback::Datagram(datagram) => {
+                f.debug_tuple("Datagram").field(datagram.addr()).finish()
+            }
+        }
+    }
+}
+
+/// One end of an in-enclave TCP connection.
+pub(super) struct LoopbackStream {
+    endpoint: Endpoint,
+    addr: SockAddr,
+    peer_addr: SockAddr,
+    notifier: Arc<IoNotifier>,
+    // Relays the events of the endpoint to the notifier of the socket
+    relay: Arc<RelayNotifier>,
+    // Held by the receivers, so that no data is received while being peeked
+    recv_lock: SgxMutex<()>,
+    // Wakes the receivers blocked on the socket
+    receivers: Arc<WaiterQueueObserver<IoEvents>>,
+    // The urgent byte sent by the peer, and the one sent to the peer
+    urgent: Arc<UrgentByte>,
+    peer_urgent: Arc<UrgentByte>,
+}
+
+impl LoopbackStream {
+    fn new(
+        endpoint: Endpoint,
+        addr: SockAddr,
+        peer_addr: SockAddr,
+        urgent: Arc<UrgentByte>,
+        peer_urgent: Arc<UrgentByte>,
+        notifier: &Arc<IoNotifier>,
+    ) -> Self {
+        let relay = Arc::new(RelayNotifier::with_notifier(notifier.clone()));
+        relay.observe_endpoint(&endpoint);
+        let receivers = WaiterQueueObserver::new();
+        notifier.register(
+            Arc::downgrade(&receivers) as Weak<dyn Observer<_>>,
+            Some(IoEvents::IN | IoEvents::RDHUP | IoEvents::HUP),
+            None,
+        );
+        *urgent.notifier.lock().unwrap() = Arc::downgrade(notifier);
+        Self {
+            endpoint,
+            addr,
+            peer_addr,
+            notifier: notifier.clone(),
+            relay,
+            recv_lock: SgxMutex::new(()),
+            receivers,
+            urgent,
+            peer_urgent,
+        }
+    }
+
+    pub fn addr(&self) -> &SockAddr {
+        &self.addr
+    }
+
+    pub fn peer_addr(&self) -> &SockAddr {
+        &self.peer_addr
+    }
+
+    pub fn sendmsg(&self, bufs: &[&[u8]], flags: SendFlags) -> Result<usize> {
+        if flags.contains(SendFlags::MSG_OOB) {
+            return self.send_urgent(bufs, flags);
+        }
+        self.send_inline(bufs, flags)
+    }
+
+    fn send_inline(&self, bufs: &[&[u8]], flags: SendFlags) -> Result<usize> {
+        let res = if flags.contains(SendFlags::MSG_DONTWAIT) {
+            self.endpoint.writev_nonblocking(bufs)
+        } else {
+            self.endpoint.writev(bufs)
+        };
+        res.map_err(|e| {
+            if e.errno() == EPIPE && !flags.contains(SendFlags::MSG_NOSIGNAL) {
+                crate::signal::do_tkill(current!().tid(), crate::signal::SIGPIPE.as_u8() as i32);
+            }
+            e
+        })
+    }
+
+    // As in Linux, the last byte is the urgent byte, which is received by MSG_OOB only
+    fn send_urgent(&self, bufs: &[&[u8]], flags: SendFlags) -> Result<usize> {
+        let len: usize = bufs.iter().map(|buf| buf.len()).sum();
+        if len == 0 {
+            return Ok(0);
+        }
+
+        let mut inline_bufs: Vec<&[u8]> =
+            bufs.iter().copied().filter(|buf| !buf.is_empty()).collect();
+        let last_buf = inline_bufs.pop().unwrap();
+        let (last_byte, last_inline) = last_buf.split_last().unwrap();
+        inline_bufs.push(last_inline);
+        if len > 1 {
+            let bytes_sent = self.send_inline(&inline_bufs, flags)?;
+            if bytes_sent < len - 1 {
+                return Ok(bytes_sent);
+            }
+        }
+
+        // A new urgent byte replaces the one not received yet
+        *self.peer_urgent.byte.lock().unwrap() = Some(*last_byte);
+        if let Some(notifier) = self.peer_urgent.notifier.lock().unwrap().upgrade() {
+            notifier.broadcast(&IoEvents::PRI);
+        }
+        Ok(len)
+    }
+
+    pub fn recvmsg(&self, bufs: &mut [&mut [u8]], flags: RecvFlags) -> Result<usize> {
+        if flags.contains(RecvFlags::MSG_OOB) {
+            return self.recv_urgent(bufs, flags);
+        }
+        let len: usize = bufs.iter().map(|buf| buf.len()).sum();
+        if len == 0 {
+            return Ok(0);
+        }
+
+        let is_peek = flags.contains(RecvFlags::MSG_PEEK);
+        // A peek returns the data that have arrived, as in Linux
+        let is_wait_all = flags.contains(RecvFlags::MSG_WAITALL) && !is_peek;
+        let is_nonblocking = flags.contains(RecvFlags::MSG_DONTWAIT) || self.endpoint.nonblocking();
+
+        let waiter = Waiter::new();
+        let mut bytes_recvd = 0;
+        let res = loop {
+            self.receivers.waiter_queue().reset_and_enqueue(&waiter);
+            match self.try_recv(bufs, bytes_recvd, is_peek) {
+                // The peer has shut down the connection
+                Ok(0) => break Ok(bytes_recvd),
+                Ok(count) => {
+                    bytes_recvd += count;
+                    if !is_wait_all || bytes_recvd == len {
+                        break Ok(bytes_recvd);
+                    }
+                }
+                Err(e) if e.errno() == EAGAIN && !is_nonblocking => {
+                    if let Err(e) = waiter.wait(None) {
+                        break Err(e);
+                    }
+                }
+                Err(e) => break Err(e),
+            }
+        };
+        self.receivers.waiter_queue().dequeue(&waiter);
+
+        match res {
+            // The data received before an error or a signal are returned
+            Err(_) if bytes_recvd > 0 => Ok(bytes_recvd),
+            res => res,
+        }
+    }
+
+    // Receive or peek without blocking into the buffers, skipping the bytes received
+    fn try_recv(&self, bufs: &mut [&mut [u8]], skip: usize, is_peek: bool) -> Result<usize> {
+        let mut skip = skip;
+        let mut remain_bufs: Vec<&mut [u8]> = bufs
+            .iter_mut()
+            .filter_map(|buf| {
+                if skip >= buf.len() {
+                    skip -= buf.len();
+                    return None;
+                }
+                let remain_buf = &mut buf[skip..];
+                skip = 0;
+                Some(remain_buf)
+            })
+            .collect();
+
+        let _guard = self.recv_lock.lock().unwrap();
+        if is_peek {
+            // Safe as all the receivers hold the lock
+            unsafe { self.endpoint.peekv_nonblocking(&mut remain_bufs) }
+        } else {
+            self.endpoint.readv_nonblocking(&mut remain_bufs)
+        }
+    }
+
+    fn recv_urgent(&self, bufs: &mut [&mut [u8]], flags: RecvFlags) -> Result<usize> {
+        let mut urgent = self.urgent.byte.lock().unwrap();
+        let byte = match *urgent {
+            Some(byte) => byte,
+            None => return_errno!(EINVAL, "no urgent data to receive"),
+        };
+        match bufs.iter_mut().find(|buf| !buf.is_empty()) {
+            Some(buf) => buf[0] = byte,
+            None => return Ok(0),
+        }
+        if !flags.contains(RecvFlags::MSG_PEEK) {
+            *urgent = None;
+        }
+        Ok(1)
+    }
+
+    pub fn bytes_to_read(&self) -> usize {
+        self.endpoint.bytes_to_read()
+    }
+
+    pub fn set_nonblocking(&self, nonblocking: bool) {
+        self.endpoint.set_nonblocking(nonblocking);
+        if nonblocking {
+            self.receivers.waiter_queue().dequeue_and_wake_all();
+        }
+    }
+
+    pub fn shutdown(&self, how: HowToShut) -> Result<()> {
+        self.endpoint.shutdown(how)
+    }
+
+    pub fn poll(&self) -> IoEvents {
+        let mut events = self.endpoint.poll();
+        if self.urgent.byte.lock().unwrap().is_some() {
+            events |= IoEvents::PRI;
+        }
+        events
+    }
+}
+
+impl Drop for LoopbackStream {
+    fn drop(&mut self) {
+        let receivers = Arc::downgrade(&self.receivers) as Weak<dyn Observer<_>>;
+        self.notifier.unregister(&receivers);
+    }
+}
+
+/// The urgent byte sent to one end of an in-enclave TCP connection.
+#[derive(Default)]
+struct UrgentByte {
+    byte: SgxMutex<Option<u8>>,
+    // The notifier of the receiving socket
+    notifier: SgxMutex<Weak<IoNotifier>>,
+}
+
+/// An incoming in-enclave connection that waits to be accepted.
+struct Incoming {
+    endpoint: Endpoint,
+    // The urgent bytes sent to the accepting socket and to the connecting socket
+    urgent: Arc<UrgentByte>,
+    peer_urgent: Arc<UrgentByte>,
+    // The address the connecting socket connects to
+    addr: SockAddr,
+    // The address of the connecting socket
+    peer_addr: SockAddr,
+}
+
+/// The in-enclave part of a listening host socket.
+pub(super) struct LoopbackListener {
+    addr: SockAddr,
+    key: (u32, u16),
+    capacity: AtomicUsize,
+    incoming: SgxMutex<VecDeque<Incoming>>,
+    // The threads that are blocked in accept
+    acceptors: WaiterQueue,
+    // The notifier of the listening socket
+    notifier: Arc<IoNotifier>,
+}
+
+impl LoopbackListener {
+    fn push_incoming(&self, incoming: Incoming) -> core::result::Result<(), Incoming> {
+        {
+            let mut queue = self.incoming.lock().unwrap();
+            if queue.len() >= self.capacity.load(Ordering::Relaxed) {
+                return Err(incoming);
+            }
+            queue.push_back(incoming);
+        }
+
+        self.acceptors.dequeue_and_wake_all();
+        self.notifier.broadcast(&IoEvents::IN);
+        Ok(())
+    }
+
+    fn pop_incoming(&self) -> Option<Incoming> {
+        let (incoming, has_more) = {
+            let mut queue = self.incoming.lock().unwrap();
+            (queue.pop_front(), !queue.is_empty())
+        };
+        if incoming.is_some() && has_more {
+            // Epoll does not reinsert host files into its ready list. Notify again so that the
+            // remaining connections are reported in the level-triggered mode.
+            self.notifier.broadcast(&IoEvents::IN);
+        }
+        incoming
+    }
+
+    fn has_incoming(&self) -> bool {
+        !self.incoming.lock().unwrap().is_empty()
+    }
+
+    fn set_backlog(&self, backlog: i32) {
+        // The same as Linux: a backlog of zero still allows one pending connection
+        const SOMAXCONN: i32 = 4096;
+        let capacity = backlog.max(1).min(SOMAXCONN) as usize;
+        self.capacity.store(capacity, Ordering::Relaxed);
+    }
+
+    fn lookup(ip: u32, port: u16) -> Option<Arc<Self>> {
+        let listeners = LOOPBACK_LISTENERS.lock().unwrap();
+        listeners
+            .get(&(ip, port))
+            .or_else(|| listeners.get(&(INADDR_ANY, port)))
+            .cloned()
+    }
+}
+
+impl HostSocket {
+    /// Listen for in-enclave connections if the socket is bound to a loopback or
+    /// wildcard IPv4 address.
+    pub(super) fn listen_loopback(&self, backlog: i32) -> Result<()> {
+        if !self.is_tcp {
+            return Ok(());
+        }
+
+        let mut loopback = self.loopback.write().unwrap();
+        match &*loopback {
+            Loopback::None => {}
+            Loopback::Listening(listener) => {
+                listener.set_backlog(backlog);
+                return Ok(());
+            }
+            Loopback::Connected(_) => return_errno!(EINVAL, "the socket is already connected"),
+            Loopback::Datagram(_) => return Ok(()),
+        }
+
+        let addr = self.host_sockname()?;
+        let key = match inet_ip_and_port(&addr) {
+            Some((ip, port)) if is_loopback_ip(ip) || ip == INADDR_ANY => (ip, port),
+            _ => return Ok(()),
+        };
+
+        let listener = Arc::new(LoopbackListener {
+            addr,
+            key,
+            capacity: AtomicUsize::new(0),
+            incoming: SgxMutex::new(VecDeque::new()),
+            acceptors: WaiterQueue::new(),
+            notifier: self.notifier.clone(),
+        });
+        listener.set_backlog(backlog);
+
+        let mut listeners = LOOPBACK_LISTENERS.lock().unwrap();
+        if listeners.contains_key(&key) {
+            // E.g., two sockets share the port with SO_REUSEPORT. Leave the
+            // connections to the host.
+            return Ok(());
+        }
+        // A blocking accept waits in the LibOS for both kinds of connections, so the
+        // host accept must never block
+        self.set_host_nonblocking()?;
+        listeners.insert(key, listener.clone());
+        *loopback = Loopback::Listening(listener);
+        Ok(())
+    }
+
+    pub(super) fn set_host_nonblocking(&self) -> Result<()> {
+        let host_flags = try_libc!(libc::ocall::fcntl_arg0(
+            self.raw_host_fd()? as i32,
+            libc::F_GETFL
+        ));
+        try_libc!(libc::ocall::fcntl_arg1(
+            self.raw_host_fd()? as i32,
+            libc::F_SETFL,
+            host_flags | libc::O_NONBLOCK
+        ));
+        Ok(())
+    }
+
+    /// Try to connect to a listener in the same LibOS instance.
+    ///
+    /// Return false if the connection has to be established through the host.
+    pub(super) fn connect_loopback(&self, peer_addr: &SockAddr) -> Result<bool> {
+        if !self.is_tcp {
+            return Ok(false);
+        }
+        let listener = match inet_ip_and_port(peer_addr) {
+            Some((ip, port)) if is_loopback_ip(ip) => match LoopbackListener::lookup(ip, port) {
+                Some(listener) => listener,
+                None => return Ok(false),
+            },
+            _ => return Ok(false),
+        };
+
+        let mut loopback = self.loopback.write().unwrap();
+        match &*loopback {
+            Loopback::None => {}
+            Loopback::Listening(_) => return_errno!(EINVAL, "invalid socket for connect"),
+            Loopback::Connected(_) => return_errno!(EISCONN, "already connected"),
+            Loopback::Datagram(_) => return Ok(false),
+        }
+
+        // Reserve a local port in the host as a real TCP connection would do
+        let addr = self.loopback_local_addr(peer_addr)?;
+        let (end_self, end_incoming) = end_pair(self.nonblocking.load(Ordering::Relaxed))?;
+        let urgent_self = Arc::new(UrgentByte::default());
+        let urgent_incoming = Arc::new(UrgentByte::default());
+        let incoming = Incoming {
+            endpoint: end_incoming,
+            urgent: urgent_incoming.clone(),
+            peer_urgent: urgent_self.clone(),
+            addr: *peer_addr,
+            peer_addr: addr,
+        };
+        if listener.push_incoming(incoming).is_err() {
+            // The backlog is full. Let the host queue the connection.
+            return Ok(false);
+        }
+
+        let stream = LoopbackStream::new(
+            end_self,
+            addr,
+            *peer_addr,
+            urgent_self,
+            urgent_incoming,
+            &self.notifier,
+        );
+        *loopback = Loopback::Connected(Arc::new(stream));
+        drop(loopback);
+
+        // The connection is established immediately
+        self.notifier.broadcast(&IoEvents::OUT);
+        Ok(true)
+    }
+
+    /// Accept either an in-enclave connection or a host connection, whichever
+    /// comes first.
+    pub(super) fn accept_loopback(
+        &self,
+        listener: &LoopbackListener,
+        flags: FileFlags,
+    ) -> Result<(Self, Option<SockAddr>)> {
+        let waiter = Waiter::new();
+        loop {
+            if let Some(incoming) = listener.pop_incoming() {
+                return self.accept_incoming(incoming, flags);
+            }
+            if self.nonblocking.load(Ordering::Relaxed) {
+                return self.accept_host(flags);
+            }
+
+            listener.acceptors.reset_and_enqueue(&waiter);
+            if listener.has_incoming() {
+                listener.acceptors.dequeue(&waiter);
+                continue;
+            }
+
+            let host_ready = self.poll_host_or_waiter(&waiter);
+            if !waiter.is_woken() {
+                listener.acceptors.dequeue(&waiter);
+            }
+            // A concurrent acceptor may take the host connection after the poll
+            if host_ready? {
+                match self.accept_host(flags) {
+                    Err(e) if e.errno() == EAGAIN => continue,
+                    res => return res,
+                }
+            }
+        }
+    }
+
+    pub(super) fn accept_loopback_nowait(
+        &self,
+        listener: &LoopbackListener,
+        flags: FileFlags,
+    ) -> Result<(Self, Option<SockAddr>)> {
+        match listener.pop_incoming() {
+            Some(incoming) => self.accept_incoming(incoming, flags),
+            // The host socket of a loopback listener is always non-blocking
+            None => self.accept_host(flags),
+        }
+    }
+
+    fn accept_incoming(
+        &self,
+        incoming: Incoming,
+        flags: FileFlags,
+    ) -> Result<(Self, Option<SockAddr>)> {
+        // The host socket is only used for the control path, which is created on demand.
+        // It is never connected.
+        let socket = Self::without_host_fd(true, false, flags);
+
+        let Incoming {
+            endpoint,
+            urgent,
+            peer_urgent,
+            addr,
+            peer_addr,
+        } = incoming;
+        endpoint.set_nonblocking(flags.contains(FileFlags::SOCK_NONBLOCK));
+        let stream = LoopbackStream::new(
+            endpoint,
+            addr,
+            peer_addr,
+            urgent,
+            peer_urgent,
+            &socket.notifier,
+        );
+        *socket.loopback.write().unwrap() = Loopback::Connected(Arc::new(stream));
+
+        debug!("accept in-enclave connection from {:?}", peer_addr);
+        Ok((socket, Some(peer_addr)))
+    }
+
+    pub(super) fn loopback_stream(&self) -> Option<Arc<LoopbackStream>> {
+        match &*self.loopback.read().unwrap() {
+            Loopback::Connected(stream) => Some(stream.clone()),
+            _ => None,
+        }
+    }
+
+    pub(super) fn loopback_listener(&self) -> Option<Arc<LoopbackListener>> {
+        match &*self.loopback.read().unwrap() {
+            Loopback::Listening(listener) => Some(listener.clone()),
+            _ => None,
+        }
+    }
+
+    pub(super) fn poll_loopback(&self) -> Option<IoEvents> {
+        match &*self.loopback.read().unwrap() {
+            Loopback::None => None,
+            Loopback::Listening(listener) => {
+                let mut events = self.readiness.events();
+                if listener.has_incoming() {
+                    events |= IoEvents::IN;
+                }
+                Some(events)
+            }
+            Loopback::Connected(stream) => Some(stream.poll()),
+            Loopback::Datagram(datagram) => {
+                let mut events = self.readiness.events();
+                if datagram.has_datagrams() {
+                    events |= IoEvents::IN;
+                }
+                Some(events)
+            }
+        }
+    }
+
+    /// Whether the host socket is kept non-blocking, whatever the status flags are,
+    /// as the LibOS waits for both the host socket and the in-enclave peers, or the
+    /// LibOS threads must not block in the host in the M:N mode.
+    pub(super) fn is_host_always_nonblocking(&self) -> bool {
+        if is_vcpu_enabled() {
+            return true;
+        }
+        match &*self.loopback.read().unwrap() {
+            Loopback::Listening(_) | Loopback::Datagram(_) => true,
+            _ => false,
+        }
+    }
+
+    // Wait until either the host socket is readable or the waiter is woken up.
+    // Return whether the host socket is readable.
+    pub(super) fn poll_host_or_waiter(&self, waiter: &Waiter) -> Result<bool> {
+        let mut pollfds = [libc::pollfd {
+            fd: self.raw_host_fd()? as i32,
+            events: libc::POLLIN,
+            revents: 0,
+        }];
+        waiter.wait_host_fds(&mut pollfds, None)?;
+        Ok(pollfds[0].revents != 0)
+    }
+
+    // The local address of a connecting socket. If the socket is not bound yet,
+    // bind it to an ephemeral port of the destination IP.
+    fn loopback_local_addr(&self, peer_addr: &SockAddr) -> Result<SockAddr> {
+        let (peer_ip, _) = inet_ip_and_port(peer_addr).unwrap();
+        let mut addr = self.host_sockname()?;
+        let (_, port) = inet_ip_and_port(&addr).unwrap();
+        if port == 0 {
+            self.bind(&new_inet_addr(peer_ip, 0))?;
+            addr = self.host_sockname()?;
+        }
+
+        let (ip, port) = inet_ip_and_port(&addr).unwrap();
+        if ip == INADDR_ANY {
+            addr = new_inet_addr(peer_ip, port);
+        }
+        Ok(addr)
+    }
+
+    pub(super) fn host_sockname(&self) -> Result<SockAddr> {
+        let mut addr = SockAddr::default();
+        let mut addr_len = addr.len() as u32;
+        try_libc!(libc::ocall::getsockname(
+            self.raw_host_fd()? as i32,
+            addr.as_mut_ptr(),
+            &mut addr_len
+        ));
+        addr.set_len(addr_len as usize)?;
+        Ok(addr)
+    }
+
+    pub(super) fn unregister_loopback(&self) {
+        match &*self.loopback.read().unwrap() {
+            Loopback::Listening(listener) => {
+                let mut listeners = LOOPBACK_LISTENERS.lock().unwrap();
+                if let Some(registered) = listeners.get(&listener.key) {
+                    if Arc::ptr_eq(registered, listener) {
+                        listeners.remove(&listener.key);
+                    }
+                }
+            }
+            Loopback::Datagram(datagram) => datagram.unregister(),
+            _ => {}
+        }
+    }
+}
+
+// The IPv4 address and port of a socket address in host byte order
+pub(super) fn inet_ip_and_port(addr: &SockAddr) -> Option<(u32, u16)> {
+    if addr.len() < mem::size_of::<libc::sockaddr_in>() {
+        return None;
+    }
+    let sin = unsafe { ptr::read_unaligned(addr.as_ptr() as *const libc::sockaddr_in) };
+    if sin.sin_family != AddressFamily::INET as u16 {
+        return None;
+    }
+    Some((
+        u32::from_be(sin.sin_addr.s_addr),
+        u16::from_be(sin.sin_port),
+    ))
+}
+
+pub(super) fn new_inet_addr(ip: u32, port: u16) -> SockAddr {
+    let mut sin: libc::sockaddr_in = unsafe { mem::zeroed() };
+    sin.sin_family = AddressFamily::INET as u16;
+    sin.sin_addr.s_addr = ip.to_be();
+    sin.sin_port = port.to_be();
+    unsafe {
+        SockAddr::try_from_raw(
+            &sin as *const _ as *const libc::sockaddr,
+            mem::size_of::<libc::sockaddr_in>() as u32,
+        )
+        .unwrap()
+    }
+}
+
+pub(super) const INADDR_ANY: u32 = 0;
+
+pub(super) fn is_loopback_ip(ip: u32) -> bool {
+    // 127.0.0.0/8
+    (ip >> 24) == 127
+}
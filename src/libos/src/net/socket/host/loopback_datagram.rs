@@ -0,0 +1,309 @@
+//! An in-enclave fast path for UDP datagrams over the loopback interface.
+//!
+//! A UDP `HostSocket` bound to a loopback (or wildcard) IPv4 address registers
+//! itself in `LOOPBACK_DATAGRAMS`. A datagram sent to such an address by a socket in
+//! the same LibOS instance is queued to the receiving socket directly, instead of
+//! being bounced through the host kernel. An unbound sender is bound to an ephemeral
+//! port first, as the host would do, so that the receiver can reply in-enclave.
+//!
+//! The host sockets are still bound, so the datagrams from the host keep coming in.
+//! A blocking recv waits for both kinds of datagrams, which is why the host socket of
+//! a registered socket is always non-blocking. As in Linux, a datagram is dropped
+//! silently if the queue of the receiver is full.
+
+use std::sync::atomic::Ordering;
+
+use super::loopback::{inet_ip_and_port, is_loopback_ip, new_inet_addr, Loopback, INADDR_ANY};
+use super::*;
+use crate::events::{Waiter, WaiterQueue};
+
+lazy_static! {
+    /// The sockets that receive in-enclave datagrams, indexed by their IPv4 addresses
+    /// and ports (in host byte order).
+    static ref LOOPBACK_DATAGRAMS: SgxMutex<HashMap<(u32, u16), Arc<LoopbackDatagram>>> =
+        SgxMutex::new(HashMap::new());
+}
+
+/// The in-enclave part of a UDP socket bound to a loopback or wildcard IPv4 address.
+pub(super) struct LoopbackDatagram {
+    addr: SockAddr,
+    key: (u32, u16),
+    // Once the socket is connected, only the datagrams from the peer are received
+    peer_addr: SgxMutex<Option<SockAddr>>,
+    queue: SgxMutex<DatagramQueue>,
+    // The threads that are blocked in recv
+    receivers: WaiterQueue,
+    // The notifier of the socket
+    notifier: Arc<IoNotifier>,
+}
+
+#[derive(Default)]
+struct DatagramQueue {
+    // The datagrams with their source addresses
+    datagrams: VecDeque<(SockAddr, Vec<u8>)>,
+    // The total length of the datagrams
+    len: usize,
+}
+
+impl LoopbackDatagram {
+    // The same as the default rmem_max of Linux
+    const CAPACITY: usize = 208 * 1024;
+    // The maximum payload of a UDP datagram over IPv4
+    const MAX_LEN: usize = 65507;
+
+    pub fn addr(&self) -> &SockAddr {
+        &self.addr
+    }
+
+    fn push(&self, src_addr: SockAddr, bufs: &[&[u8]]) {
+        if let Some(peer_addr) = &*self.peer_addr.lock().unwrap() {
+            if inet_ip_and_port(peer_addr) != inet_ip_and_port(&src_addr) {
+                return;
+            }
+        }
+        {
+            let mut queue = self.queue.lock().unwrap();
+            let len: usize = bufs.iter().map(|buf| buf.len()).sum();
+            if queue.len > 0 && queue.len + len > Self::CAPACITY {
+                return;
+            }
+            queue.datagrams.push_back((src_addr, bufs.concat()));
+            queue.len += len;
+        }
+
+        self.receivers.dequeue_and_wake_all();
+        self.notifier.broadcast(&IoEvents::IN);
+    }
+
+    // Receive the first datagram if there is one, returning the same as do_recvmsg
+    fn pop(
+        &self,
+        bufs: &mut [&mut [u8]],
+        flags: RecvFlags,
+        name: Option<&mut [u8]>,
+    ) -> Option<(usize, usize, usize, MsgHdrFlags)> {
+        let mut queue = self.queue.lock().unwrap();
+        let (src_addr, data) = queue.datagrams.front()?;
+
+        let mut copied = 0;
+        for buf in bufs.iter_mut() {
+            let count = buf.len().min(data.len() - copied);
+            buf[..count].copy_from_slice(&data[copied..copied + count]);
+            copied += count;
+        }
+        let name_len = name.map_or(0, |name| src_addr.copy_to_slice(name));
+        let data_len = data.len();
+
+        let mut msg_flags = MsgHdrFlags::empty();
+        if copied < data_len {
+            msg_flags |= MsgHdrFlags::MSG_TRUNC;
+        }
+        // For MSG_TRUNC recvmsg returns the real length of the datagram
+        let bytes_recvd = if flags.contains(RecvFlags::MSG_TRUNC) {
+            data_len
+        } else {
+            copied
+        };
+
+        if !flags.contains(RecvFlags::MSG_PEEK) {
+            queue.datagrams.pop_front();
+            queue.len -= data_len;
+            if !queue.datagrams.is_empty() {
+                drop(queue);
+                // Epoll does not reinsert host files into its ready list. Notify again so
+                // that the remaining datagrams are reported in the level-triggered mode.
+                self.notifier.broadcast(&IoEvents::IN);
+            }
+        }
+        Some((bytes_recvd, name_len, 0, msg_flags))
+    }
+
+    pub fn has_datagrams(&self) -> bool {
+        !self.queue.lock().unwrap().datagrams.is_empty()
+    }
+
+    fn lookup(ip: u32, port: u16) -> Option<Arc<Self>> {
+        let datagrams = LOOPBACK_DATAGRAMS.lock().unwrap();
+        datagrams
+            .get(&(ip, port))
+            .or_else(|| datagrams.get(&(INADDR_ANY, port)))
+            .cloned()
+    }
+
+    pub fn unregister(&self) {
+        let mut datagrams = LOOPBACK_DATAGRAMS.lock().unwrap();
+        if let Some(registered) = datagrams.get(&self.key) {
+            if std::ptr::eq(Arc::as_ptr(registered), self) {
+                datagrams.remove(&self.key);
+            }
+        }
+    }
+}
+
+impl HostSocket {
+    /// Receive in-enclave datagrams if the socket is a UDP socket bound to a loopback
+    /// or wildcard IPv4 address.
+    pub(super) fn register_loopback_datagram(&self) -> Result<Option<Arc<LoopbackDatagram>>> {
+        if !self.is_udp {
+            return Ok(None);
+        }
+
+        let mut loopback = self.loopback.write().unwrap();
+        if let Loopback::Datagram(datagram) = &*loopback {
+            return Ok(Some(datagram.clone()));
+        }
+
+        let addr = self.host_sockname()?;
+        let key = match inet_ip_and_port(&addr) {
+            Some((ip, port)) if port != 0 && (is_loopback_ip(ip) || ip == INADDR_ANY) => (ip, port),
+            _ => return Ok(None),
+        };
+
+        let datagram = Arc::new(LoopbackDatagram {
+            addr,
+            key,
+            peer_addr: SgxMutex::new(None),
+            queue: SgxMutex::new(DatagramQueue::default()),
+            receivers: WaiterQueue::new(),
+            notifier: self.notifier.clone(),
+        });
+
+        let mut datagrams = LOOPBACK_DATAGRAMS.lock().unwrap();
+        if datagrams.contains_key(&key) {
+            // E.g., two sockets share the port with SO_REUSEPORT. Leave the datagrams
+            // to the host.
+            return Ok(None);
+        }
+        // A blocking recv waits in the LibOS for both kinds of datagrams, so the host
+        // recv must never block
+        self.set_host_nonblocking()?;
+        datagrams.insert(key, datagram.clone());
+        *loopback = Loopback::Datagram(datagram.clone());
+        Ok(Some(datagram))
+    }
+
+    /// Receive only the datagrams from the peer of a connected UDP socket, and send
+    /// the datagrams to the peer in-enclave if possible.
+    pub(super) fn connect_loopback_datagram(&self, peer_addr: &Option<SockAddr>) -> Result<()> {
+        // The socket is bound by the host connect if it is not yet
+        if let Some(datagram) = self.register_loopback_datagram()? {
+            // Connecting to an address of AF_UNSPEC dissolves the association
+            *datagram.peer_addr.lock().unwrap() =
+                peer_addr.filter(|addr| inet_ip_and_port(addr).is_some());
+        }
+        Ok(())
+    }
+
+    /// Send a datagram to a UDP socket in the same LibOS instance.
+    ///
+    /// Return None if the datagram has to be sent through the host.
+    pub(super) fn send_loopback_datagram(
+        &self,
+        bufs: &[&[u8]],
+        flags: SendFlags,
+        name: Option<&[u8]>,
+        control: Option<&[u8]>,
+    ) -> Result<Option<usize>> {
+        // The control messages are left to the host
+        if !self.is_udp || control.map_or(false, |control| !control.is_empty()) {
+            return Ok(None);
+        }
+
+        let peer_addr = match name.filter(|name| !name.is_empty()) {
+            Some(name) => match unsafe {
+                SockAddr::try_from_raw(name.as_ptr() as *const libc::sockaddr, name.len() as u32)
+            } {
+                Ok(addr) => addr,
+                Err(_) => return Ok(None),
+            },
+            None => match self
+                .loopback_datagram()
+                .and_then(|datagram| *datagram.peer_addr.lock().unwrap())
+            {
+                Some(addr) => addr,
+                None => return Ok(None),
+            },
+        };
+        let (peer_ip, receiver) = match inet_ip_and_port(&peer_addr) {
+            Some((ip, port)) if is_loopback_ip(ip) => match LoopbackDatagram::lookup(ip, port) {
+                Some(receiver) => (ip, receiver),
+                None => return Ok(None),
+            },
+            _ => return Ok(None),
+        };
+
+        if flags.contains(SendFlags::MSG_OOB) {
+            return_errno!(EOPNOTSUPP, "out-of-band data is not supported by UDP");
+        }
+        let len: usize = bufs.iter().map(|buf| buf.len()).sum();
+        if len > LoopbackDatagram::MAX_LEN {
+            return_errno!(EMSGSIZE, "the datagram is too long");
+        }
+
+        let datagram = match self.loopback_datagram() {
+            Some(datagram) => datagram,
+            None => {
+                // Bind the socket to an ephemeral port as the host would do
+                let (_, port) = inet_ip_and_port(&self.host_sockname()?).unwrap_or_default();
+                if port == 0 {
+                    self.bind(&new_inet_addr(INADDR_ANY, 0))?;
+                }
+                match self.register_loopback_datagram()? {
+                    Some(datagram) => datagram,
+                    None => return Ok(None),
+                }
+            }
+        };
+
+        let mut src_addr = *datagram.addr();
+        let (src_ip, src_port) = inet_ip_and_port(&src_addr).unwrap();
+        if src_ip == INADDR_ANY {
+            src_addr = new_inet_addr(peer_ip, src_port);
+        }
+        receiver.push(src_addr, bufs);
+        Ok(Some(len))
+    }
+
+    /// Receive either an in-enclave datagram or a host datagram, whichever comes
+    /// first.
+    pub(super) fn recv_loopback_datagram(
+        &self,
+        datagram: &LoopbackDatagram,
+        bufs: &mut [&mut [u8]],
+        flags: RecvFlags,
+        mut name: Option<&mut [u8]>,
+        mut control: Option<&mut [u8]>,
+    ) -> Result<(usize, usize, usize, MsgHdrFlags)> {
+        let is_nonblocking =
+            flags.contains(RecvFlags::MSG_DONTWAIT) || self.nonblocking.load(Ordering::Relaxed);
+
+        let waiter = Waiter::new();
+        loop {
+            datagram.receivers.reset_and_enqueue(&waiter);
+            if let Some(ret) = datagram.pop(bufs, flags, name.as_deref_mut()) {
+                datagram.receivers.dequeue(&waiter);
+                return Ok(ret);
+            }
+
+            // The host socket is always non-blocking
+            match self.do_recvmsg_host(bufs, flags, name.as_deref_mut(), control.as_deref_mut()) {
+                Err(e) if e.errno() == EAGAIN && !is_nonblocking => {}
+                res => {
+                    datagram.receivers.dequeue(&waiter);
+                    return res;
+                }
+            }
+
+            let res = self.poll_host_or_waiter(&waiter);
+            datagram.receivers.dequeue(&waiter);
+            res?;
+        }
+    }
+
+    pub(super) fn loopback_datagram(&self) -> Option<Arc<LoopbackDatagram>> {
+        match &*self.loopback.read().unwrap() {
+            Loopback::Datagram(datagram) => Some(datagram.clone()),
+            _ => None,
+        }
+    }
+}
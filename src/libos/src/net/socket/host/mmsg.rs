@@ -0,0 +1,387 @@
+//! Batched sendmmsg and recvmmsg of host sockets.
+//!
+//! All the messages of a batch are marshaled into one untrusted arena, which holds an
+//! array of `mmsghdr`s, the `iovec`s of all messages, and then the names, the control
+//! messages and the payloads. The arena is passed to the host as is, so that
+//! a batch of messages costs a single OCall. The results are copied back in one pass
+//! after the OCall, without trusting any pointers in the arena.
+
+use super::*;
+use crate::time::timespec_t;
+use crate::untrusted::{
+    SliceAsMutPtrAndLen, SliceAsPtrAndLen, UntrustedSlice, UntrustedSliceAlloc,
+};
+use std::mem::{align_of, size_of, size_of_val};
+use std::slice;
+use std::sync::atomic::Ordering;
+
+impl HostSocket {
+    /// Send a batch of messages, returning the number of bytes sent for each message
+    /// that is sent.
+    pub fn sendmmsg(&self, msgs: &[MsgHdr], flags: SendFlags) -> Result<Vec<usize>> {
+        if msgs.is_empty() {
+            return Ok(Vec::new());
+        }
+        if self.loopback_stream().is_some() {
+            return self.sendmmsg_one_by_one(msgs, flags);
+        }
+
+        let is_nonblocking =
+            flags.contains(SendFlags::MSG_DONTWAIT) || self.nonblocking.load(Ordering::Relaxed);
+        let ret = self.block_on_host(IoEvents::OUT, is_nonblocking, || {
+            self.do_sendmmsg(msgs, flags)
+        });
+        let all_sent = match &ret {
+            Ok(bytes_sent) => {
+                bytes_sent.len() == msgs.len()
+                    && bytes_sent
+                        .iter()
+                        .zip(msgs.iter())
+                        .all(|(&len, msg)| len == msg.get_iovs().total_bytes())
+            }
+            Err(_) => false,
+        };
+        if !all_sent {
+            // The send buffer may be full
+            self.readiness.consume(IoEvents::OUT);
+        }
+        ret
+    }
+
+    fn do_sendmmsg(&self, msgs: &[MsgHdr], flags: SendFlags) -> Result<Vec<usize>> {
+        // Allocate the untrusted arena
+        let nr_iovs = msgs
+            .iter()
+            .map(|msg| msg.get_iovs().as_slices().len())
+            .sum();
+        let nr_bytes = msgs
+            .iter()
+            .map(|msg| {
+                msg.get_iovs().total_bytes()
+                    + msg.get_name().map_or(0, |name| name.len())
+                    + msg.get_control().map_or(0, |control| control.len())
+            })
+            .sum();
+        let (meta_alloc, bytes_alloc) = new_arena::<mmsghdr>(msgs.len(), nr_iovs, nr_bytes)?;
+        let mut u_hdrs = meta_alloc.new_slice_mut(msgs.len() * size_of::<mmsghdr>())?;
+        let mut u_iovs = meta_alloc.new_slice_mut(nr_iovs * size_of::<libc::iovec>())?;
+        let u_iovs_ptr = u_iovs.as_mut_ptr() as *const libc::iovec;
+
+        // Marshal the messages
+        let mut hdrs = Vec::with_capacity(msgs.len());
+        let mut iovs = Vec::with_capacity(nr_iovs);
+        for msg in msgs {
+            let iov_start = iovs.len();
+            for buf in msg.get_iovs().as_slices() {
+                let u_buf = bytes_alloc.new_slice(buf)?;
+                iovs.push(u_buf.as_ref().as_libc_iovec());
+            }
+            let u_name = new_optional_slice(&bytes_alloc, msg.get_name())?;
+            let u_control = new_optional_slice(&bytes_alloc, msg.get_control())?;
+            let (msg_name, msg_namelen) = u_name.as_deref().as_ptr_and_len();
+            let (msg_control, msg_controllen) = u_control.as_deref().as_ptr_and_len();
+
+            hdrs.push(mmsghdr {
+                msg_hdr: msghdr {
+                    msg_name: msg_name as *const c_void,
+                    msg_namelen: msg_namelen as libc::socklen_t,
+                    msg_iov: unsafe { u_iovs_ptr.add(iov_start) },
+                    msg_iovlen: iovs.len() - iov_start,
+                    msg_control: msg_control as *const c_void,
+                    msg_controllen,
+                    msg_flags: 0,
+                },
+                msg_len: 0,
+            });
+        }
+        u_iovs.read_from_slice(as_bytes(&iovs))?;
+        u_hdrs.read_from_slice(as_bytes(&hdrs))?;
+
+        // Do OCall
+        let host_fd = self.raw_host_fd()? as i32;
+        let mut retval: i32 = 0;
+        unsafe {
+            let status = occlum_ocall_sendmmsg(
+                &mut retval as *mut i32,
+                host_fd,
+                u_hdrs.as_mut_ptr() as *mut c_void,
+                msgs.len() as c_uint,
+                flags.bits(),
+            );
+            assert!(status == sgx_status_t::SGX_SUCCESS);
+        }
+        let nr_sent = if flags.contains(SendFlags::MSG_NOSIGNAL) {
+            try_libc!(retval)
+        } else {
+            try_libc_may_epipe!(retval)
+        } as usize;
+        assert!(nr_sent <= msgs.len());
+
+        // Check values returned from outside the enclave
+        u_hdrs.write_to_slice(as_bytes_mut(&mut hdrs[..nr_sent]))?;
+        let bytes_sent = hdrs[..nr_sent]
+            .iter()
+            .zip(msgs.iter())
+            .map(|(hdr, msg)| {
+                let bytes_sent = hdr.msg_len as usize;
+                assert!(bytes_sent <= msg.get_iovs().total_bytes());
+                bytes_sent
+            })
+            .collect();
+        Ok(bytes_sent)
+    }
+
+    /// Receive a batch of messages, returning the number of bytes received for each message
+    /// that is received. The remaining time of the timeout is updated as Linux does.
+    pub fn recvmmsg(
+        &self,
+        msgs: &mut [MsgHdrMut],
+        flags: RecvFlags,
+        mut timeout: Option<&mut timespec_t>,
+    ) -> Result<Vec<usize>> {
+        if msgs.is_empty() {
+            return Ok(Vec::new());
+        }
+        if self.loopback_stream().is_some() || self.loopback_datagram().is_some() {
+            if timeout.is_some() {
+                warn!("the timeout of recvmmsg is ignored for in-enclave sockets");
+            }
+            return self.recvmmsg_one_by_one(msgs, flags);
+        }
+
+        let is_nonblocking =
+            flags.contains(RecvFlags::MSG_DONTWAIT) || self.nonblocking.load(Ordering::Relaxed);
+        let ret = self.block_on_host(IoEvents::IN, is_nonblocking, || {
+            self.do_recvmmsg(msgs, flags, timeout.as_deref_mut())
+        });
+        let is_drained = match &ret {
+            Err(e) => e.errno() == EAGAIN,
+            // Whether there is more to receive is unknown
+            Ok(_) => !flags.contains(RecvFlags::MSG_PEEK),
+        };
+        if is_drained {
+            self.readiness.consume(IoEvents::IN);
+        }
+        ret
+    }
+
+    fn do_recvmmsg(
+        &self,
+        msgs: &mut [MsgHdrMut],
+        flags: RecvFlags,
+        timeout: Option<&mut timespec_t>,
+    ) -> Result<Vec<usize>> {
+        // Allocate the untrusted arena
+        let nr_iovs = msgs
+            .iter()
+            .map(|msg| msg.get_iovs().as_slices().len())
+            .sum();
+        let nr_bytes = msgs
+            .iter()
+            .map(|msg| {
+                msg.get_iovs().total_bytes() + msg.get_name_max_len() + msg.get_control_max_len()
+            })
+            .sum();
+        let (meta_alloc, bytes_alloc) = new_arena::<mmsghdr_mut>(msgs.len(), nr_iovs, nr_bytes)?;
+        let mut u_hdrs = meta_alloc.new_slice_mut(msgs.len() * size_of::<mmsghdr_mut>())?;
+        let mut u_iovs = meta_alloc.new_slice_mut(nr_iovs * size_of::<libc::iovec>())?;
+        let u_iovs_ptr = u_iovs.as_mut_ptr() as *mut libc::iovec;
+
+        // Marshal the buffers
+        let mut hdrs = Vec::with_capacity(msgs.len());
+        let mut iovs = Vec::with_capacity(nr_iovs);
+        let mut u_bufs = Vec::with_capacity(msgs.len());
+        for msg in msgs.iter() {
+            let iov_start = iovs.len();
+            let mut u_data = Vec::new();
+            for buf in msg.get_iovs().as_slices() {
+                let u_buf = bytes_alloc.new_slice_mut(buf.len())?;
+                iovs.push(u_buf.as_ref().as_libc_iovec());
+                u_data.push(u_buf);
+            }
+            let mut u_name = new_optional_slice_mut(&bytes_alloc, msg.get_name_max_len())?;
+            let mut u_control = new_optional_slice_mut(&bytes_alloc, msg.get_control_max_len())?;
+            let (msg_name, msg_namelen) = u_name.as_deref_mut().as_mut_ptr_and_len();
+            let (msg_control, msg_controllen) = u_control.as_deref_mut().as_mut_ptr_and_len();
+
+            hdrs.push(mmsghdr_mut {
+                msg_hdr: msghdr_mut {
+                    msg_name: msg_name as *mut c_void,
+                    msg_namelen: msg_namelen as libc::socklen_t,
+                    msg_iov: unsafe { u_iovs_ptr.add(iov_start) },
+                    msg_iovlen: iovs.len() - iov_start,
+                    msg_control: msg_control as *mut c_void,
+                    msg_controllen,
+                    msg_flags: 0,
+                },
+                msg_len: 0,
+            });
+            u_bufs.push((u_data, u_name, u_control));
+        }
+        u_iovs.read_from_slice(as_bytes(&iovs))?;
+        u_hdrs.read_from_slice(as_bytes(&hdrs))?;
+
+        // Do OCall
+        let host_fd = self.raw_host_fd()? as i32;
+        let timeout_ptr = timeout.map_or(std::ptr::null_mut(), |timeout| {
+            timeout as *mut timespec_t as *mut libc::timespec
+        });
+        let mut retval: i32 = 0;
+        unsafe {
+            let status = occlum_ocall_recvmmsg(
+                &mut retval as *mut i32,
+                host_fd,
+                u_hdrs.as_mut_ptr() as *mut c_void,
+                msgs.len() as c_uint,
+                flags.bits(),
+                timeout_ptr,
+            );
+            assert!(status == sgx_status_t::SGX_SUCCESS);
+        }
+        let nr_recvd = try_libc!(retval) as usize;
+        assert!(nr_recvd <= msgs.len());
+
+        // Copy the results back after checking the values returned from outside the enclave
+        u_hdrs.write_to_slice(as_bytes_mut(&mut hdrs[..nr_recvd]))?;
+        let mut bytes_recvd = Vec::with_capacity(nr_recvd);
+        for ((msg, hdr), (u_data, u_name, u_control)) in msgs
+            .iter_mut()
+            .zip(hdrs[..nr_recvd].iter())
+            .zip(u_bufs.iter())
+        {
+            let data_len = hdr.msg_len as usize;
+            let namelen_recvd = hdr.msg_hdr.msg_namelen as usize;
+            let controllen_recvd = hdr.msg_hdr.msg_controllen;
+            let flags_recvd = MsgHdrFlags::from_bits(hdr.msg_hdr.msg_flags).unwrap();
+
+            // For MSG_TRUNC recvmmsg returns the real length of the datagram,
+            // even when it was longer than the passed buffer.
+            let max_data_len = msg.get_iovs().total_bytes();
+            if flags.contains(RecvFlags::MSG_TRUNC) && data_len > max_data_len {
+                assert!(flags_recvd.contains(MsgHdrFlags::MSG_TRUNC));
+            } else {
+                assert!(data_len <= max_data_len);
+            }
+            assert!(namelen_recvd <= msg.get_name_max_len());
+            assert!(controllen_recvd <= msg.get_control_max_len());
+
+            {
+                let (iovs, name, control) = msg.get_iovs_name_and_control_mut();
+                let mut remain = data_len.min(max_data_len);
+                for (buf, u_buf) in iovs.as_slices_mut().iter_mut().zip(u_data.iter()) {
+                    let len = remain.min(buf.len());
+                    u_buf.write_to_slice(&mut buf[..len])?;
+                    remain -= len;
+                    if remain == 0 {
+                        break;
+                    }
+                }
+                if let (Some(name), Some(u_name)) = (name, u_name) {
+                    u_name.write_to_slice(&mut name[..namelen_recvd])?;
+                }
+                if let (Some(control), Some(u_control)) = (control, u_control) {
+                    u_control.write_to_slice(&mut control[..controllen_recvd])?;
+                }
+            }
+            msg.set_name_len(namelen_recvd)?;
+            msg.set_control_len(controllen_recvd)?;
+            msg.set_flags(flags_recvd);
+            bytes_recvd.push(data_len);
+        }
+        Ok(bytes_recvd)
+    }
+
+    // In-enclave connections have no host messages to batch
+    fn sendmmsg_one_by_one(&self, msgs: &[MsgHdr], flags: SendFlags) -> Result<Vec<usize>> {
+        let mut bytes_sent = Vec::with_capacity(msgs.len());
+        for msg in msgs {
+            match self.sendmsg(msg, flags) {
+                Ok(len) => bytes_sent.push(len),
+                Err(e) if bytes_sent.is_empty() => return Err(e),
+                Err(_) => break,
+            }
+        }
+        Ok(bytes_sent)
+    }
+
+    fn recvmmsg_one_by_one(
+        &self,
+        msgs: &mut [MsgHdrMut],
+        mut flags: RecvFlags,
+    ) -> Result<Vec<usize>> {
+        let mut bytes_recvd = Vec::with_capacity(msgs.len());
+        for msg in msgs.iter_mut() {
+            match self.recvmsg(msg, flags) {
+                Ok(len) => bytes_recvd.push(len),
+                Err(e) if bytes_recvd.is_empty() => return Err(e),
+                Err(_) => break,
+            }
+            if flags.contains(RecvFlags::MSG_WAITFORONE) {
+                flags |= RecvFlags::MSG_DONTWAIT;
+            }
+        }
+        Ok(bytes_recvd)
+    }
+}
+
+/// Allocate the untrusted arena of a batch of messages, which consists of two buffers.
+/// The headers and the iovecs are placed in the first buffer so that they are properly
+/// aligned; the names, the control messages and the payloads are placed in the second.
+fn new_arena<H>(
+    nr_msgs: usize,
+    nr_iovs: usize,
+    nr_bytes: usize,
+) -> Result<(UntrustedSliceAlloc, UntrustedSliceAlloc)> {
+    debug_assert!(size_of::<H>() % align_of::<libc::iovec>() == 0);
+    let meta_size = nr_msgs * size_of::<H>() + nr_iovs * size_of::<libc::iovec>();
+    let meta_alloc = UntrustedSliceAlloc::new(meta_size)?;
+    let bytes_alloc = UntrustedSliceAlloc::new(nr_bytes)?;
+    Ok((meta_alloc, bytes_alloc))
+}
+
+fn new_optional_slice<'a>(
+    alloc: &'a UntrustedSliceAlloc,
+    src: Option<&[u8]>,
+) -> Result<Option<UntrustedSlice<'a>>> {
+    match src {
+        Some(src) if src.len() > 0 => Ok(Some(alloc.new_slice(src)?)),
+        _ => Ok(None),
+    }
+}
+
+fn new_optional_slice_mut(
+    alloc: &UntrustedSliceAlloc,
+    len: usize,
+) -> Result<Option<UntrustedSlice>> {
+    if len == 0 {
+        return Ok(None);
+    }
+    Ok(Some(alloc.new_slice_mut(len)?))
+}
+
+fn as_bytes<T: Copy>(items: &[T]) -> &[u8] {
+    unsafe { slice::from_raw_parts(items.as_ptr() as *const u8, size_of_val(items)) }
+}
+
+fn as_bytes_mut<T: Copy>(items: &mut [T]) -> &mut [u8] {
+    unsafe { slice::from_raw_parts_mut(items.as_mut_ptr() as *mut u8, size_of_val(items)) }
+}
+
+extern "C" {
+    fn occlum_ocall_sendmmsg(
+        ret: *mut c_int,
+        fd: c_int,
+        msgvec: *mut c_void,
+        vlen: c_uint,
+        flags: c_int,
+    ) -> sgx_status_t;
+
+    fn occlum_ocall_recvmmsg(
+        ret: *mut c_int,
+        fd: c_int,
+        msgvec: *mut c_void,
+        vlen: c_uint,
+        flags: c_int,
+        timeout: *mut libc::timespec,
+    ) -> sgx_status_t;
+}
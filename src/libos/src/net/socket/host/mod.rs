@@ -1,26 +1,46 @@
 use std::any::Any;
 use std::io::{Read, Seek, SeekFrom, Write};
+use std::lazy::SyncOnceCell;
 use std::mem;
+use std::sync::atomic::AtomicBool;
 
-use atomic::Atomic;
+use atomic::{Atomic, Ordering};
 
+use self::blocking::host_socket_flags;
+use self::loopback::Loopback;
+use self::readiness::HostReadiness;
 use super::*;
 use crate::fs::{
     occlum_ocall_ioctl, AccessMode, CreationFlags, File, FileRef, HostFd, IoEvents, IoNotifier,
     IoctlCmd, StatusFlags,
 };
 
+mod blocking;
 mod ioctl_impl;
+mod loopback;
+mod loopback_datagram;
+mod mmsg;
+mod readiness;
 mod recv;
 mod send;
 mod socket_file;
 
+pub use self::readiness::wait_tracked_host_sockets;
+
 /// Native linux socket
 #[derive(Debug)]
 pub struct HostSocket {
-    host_fd: HostFd,
-    host_events: Atomic<IoEvents>,
-    notifier: IoNotifier,
+    // Created on demand for a socket accepted in-enclave, which only uses it for the
+    // control path (e.g., setsockopt)
+    host_fd: SyncOnceCell<HostFd>,
+    readiness: Arc<HostReadiness>,
+    notifier: Arc<IoNotifier>,
+    // Whether it is an IPv4 TCP socket, which may be connected in-enclave
+    is_tcp: bool,
+    // Whether it is an IPv4 UDP socket, which may send and receive in-enclave
+    is_udp: bool,
+    nonblocking: AtomicBool,
+    loopback: RwLock<Loopback>,
 }
 
 impl HostSocket {
@@ -32,20 +52,47 @@ impl HostSocket {
     ) -> Result<Self> {
         let raw_host_fd = try_libc!(libc::ocall::socket(
             domain as i32,
-            socket_type as i32 | file_flags.bits(),
+            socket_type as i32 | host_socket_flags(file_flags).bits(),
             protocol
         )) as FileDesc;
         let host_fd = HostFd::new(raw_host_fd);
-        Ok(HostSocket::from_host_fd(host_fd))
+        let is_tcp = domain == AddressFamily::INET
+            && socket_type == SocketType::STREAM
+            && (protocol == 0 || protocol == libc::IPPROTO_TCP);
+        let is_udp = domain == AddressFamily::INET
+            && socket_type == SocketType::DGRAM
+            && (protocol == 0 || protocol == libc::IPPROTO_UDP);
+        Ok(HostSocket::from_host_fd(
+            host_fd, is_tcp, is_udp, file_flags,
+        ))
     }
 
-    fn from_host_fd(host_fd: HostFd) -> HostSocket {
-        let host_events = Atomic::new(IoEvents::empty());
-        let notifier = IoNotifier::new();
+    fn from_host_fd(
+        host_fd: HostFd,
+        is_tcp: bool,
+        is_udp: bool,
+        file_flags: FileFlags,
+    ) -> HostSocket {
+        let socket = Self::without_host_fd(is_tcp, is_udp, file_flags);
+        socket.host_fd.set(host_fd).unwrap();
+        socket
+    }
+
+    // A socket whose host socket is not created until it is used
+    fn without_host_fd(is_tcp: bool, is_udp: bool, file_flags: FileFlags) -> HostSocket {
+        let host_fd = SyncOnceCell::new();
+        let readiness = Arc::new(HostReadiness::new());
+        let notifier = Arc::new(IoNotifier::new());
+        let nonblocking = AtomicBool::new(file_flags.contains(FileFlags::SOCK_NONBLOCK));
+        let loopback = RwLock::new(Loopback::None);
         Self {
             host_fd,
-            host_events,
+            readiness,
             notifier,
+            is_tcp,
+            is_udp,
+            nonblocking,
+            loopback,
         }
     }
 
@@ -53,29 +100,58 @@ impl HostSocket {
         let (addr_ptr, addr_len) = addr.as_ptr_and_len();
 
         let ret = try_libc!(libc::ocall::bind(
-            self.raw_host_fd() as i32,
+            self.raw_host_fd()? as i32,
             addr_ptr as *const libc::sockaddr,
             addr_len as u32
         ));
+        self.register_loopback_datagram()?;
         Ok(())
     }
 
     pub fn listen(&self, backlog: i32) -> Result<()> {
-        let ret = try_libc!(libc::ocall::listen(self.raw_host_fd() as i32, backlog));
-        Ok(())
+        if self.loopback_stream().is_some() {
+            return_errno!(EINVAL, "the socket is already connected");
+        }
+
+        let ret = try_libc!(libc::ocall::listen(self.raw_host_fd()? as i32, backlog));
+        self.listen_loopback(backlog)
     }
 
     pub fn accept(&self, flags: FileFlags) -> Result<(Self, Option<SockAddr>)> {
+        if let Some(listener) = self.loopback_listener() {
+            return self.accept_loopback(&listener, flags);
+        }
+        let is_nonblocking = self.nonblocking.load(Ordering::Relaxed);
+        self.block_on_host(IoEvents::IN, is_nonblocking, || self.accept_host(flags))
+    }
+
+    /// Accept a connection if there is one, whether the socket is blocking or not
+    pub fn accept_nowait(&self, flags: FileFlags) -> Result<(Self, Option<SockAddr>)> {
+        if let Some(listener) = self.loopback_listener() {
+            return self.accept_loopback_nowait(&listener, flags);
+        }
+        if !self.readiness.events().contains(IoEvents::IN) {
+            return_errno!(EAGAIN, "no connection is incoming");
+        }
+        self.accept_host(flags)
+    }
+
+    fn accept_host(&self, flags: FileFlags) -> Result<(Self, Option<SockAddr>)> {
         let mut sockaddr = SockAddr::default();
         let mut addr_len = sockaddr.len();
 
-        let raw_host_fd = try_libc!(libc::ocall::accept4(
-            self.raw_host_fd() as i32,
-            sockaddr.as_mut_ptr() as *mut _,
-            &mut addr_len as *mut _ as *mut _,
-            flags.bits()
-        )) as FileDesc;
-        let host_fd = HostFd::new(raw_host_fd);
+        let ret = (|| -> Result<FileDesc> {
+            let raw_host_fd = try_libc!(libc::ocall::accept4(
+                self.raw_host_fd()? as i32,
+                sockaddr.as_mut_ptr() as *mut _,
+                &mut addr_len as *mut _ as *mut _,
+                host_socket_flags(flags).bits()
+            )) as FileDesc;
+            Ok(raw_host_fd)
+        })();
+        // Whether there are more incoming connections is unknown
+        self.readiness.consume(IoEvents::IN);
+        let host_fd = HostFd::new(ret?);
 
         let addr_option = if addr_len != 0 {
             sockaddr.set_len(addr_len)?;
@@ -83,11 +159,27 @@ impl HostSocket {
         } else {
             None
         };
-        Ok((HostSocket::from_host_fd(host_fd), addr_option))
+        Ok((
+            HostSocket::from_host_fd(host_fd, self.is_tcp, false, flags),
+            addr_option,
+        ))
     }
 
     pub fn connect(&self, addr: &Option<SockAddr>) -> Result<()> {
-        debug!("connect: host_fd: {}, addr {:?}", self.raw_host_fd(), addr);
+        debug!(
+            "connect: host_fd: {:?}, addr {:?}",
+            self.host_fd.get(),
+            addr
+        );
+
+        if self.loopback_stream().is_some() {
+            return_errno!(EISCONN, "already connected");
+        }
+        if let Some(sock_addr) = addr {
+            if self.connect_loopback(sock_addr)? {
+                return Ok(());
+            }
+        }
 
         let (addr_ptr, addr_len) = if let Some(sock_addr) = addr {
             sock_addr.as_ptr_and_len()
@@ -95,12 +187,24 @@ impl HostSocket {
             (std::ptr::null(), 0)
         };
 
-        let ret = try_libc!(libc::ocall::connect(
-            self.raw_host_fd() as i32,
-            addr_ptr,
-            addr_len as u32
-        ));
-        Ok(())
+        let ret = match (|| -> Result<()> {
+            try_libc!(libc::ocall::connect(
+                self.raw_host_fd()? as i32,
+                addr_ptr,
+                addr_len as u32
+            ));
+            Ok(())
+        })() {
+            // The host socket is non-blocking in the M:N mode
+            Err(e) if e.errno() == EINPROGRESS && self.is_blocking_in_libos() => {
+                self.wait_host_connected()
+            }
+            ret => ret,
+        };
+        // The events of a newly connected socket are totally different
+        self.readiness.consume(IoEvents::all());
+        ret?;
+        self.connect_loopback_datagram(addr)
     }
 
     pub fn sendto(
@@ -129,13 +233,50 @@ impl HostSocket {
         Ok((bytes_recv, addr_option))
     }
 
-    pub fn raw_host_fd(&self) -> FileDesc {
-        self.host_fd.to_raw()
+    pub fn raw_host_fd(&self) -> Result<FileDesc> {
+        let host_fd = self.host_fd.get_or_try_init(|| -> Result<HostFd> {
+            // Only TCP sockets are accepted in-enclave
+            let raw_host_fd = try_libc!(libc::ocall::socket(
+                AddressFamily::INET as i32,
+                SocketType::STREAM as i32,
+                0
+            )) as FileDesc;
+            Ok(HostFd::new(raw_host_fd))
+        })?;
+        Ok(host_fd.to_raw())
+    }
+
+    /// The local address of an in-enclave connection.
+    pub fn loopback_addr(&self) -> Option<SockAddr> {
+        self.loopback_stream().map(|stream| *stream.addr())
+    }
+
+    /// The peer address of an in-enclave connection.
+    pub fn loopback_peer_addr(&self) -> Option<SockAddr> {
+        self.loopback_stream().map(|stream| *stream.peer_addr())
     }
 
     pub fn shutdown(&self, how: HowToShut) -> Result<()> {
-        try_libc!(libc::ocall::shutdown(self.raw_host_fd() as i32, how.bits()));
-        Ok(())
+        if let Some(stream) = self.loopback_stream() {
+            return stream.shutdown(how);
+        }
+
+        let ret = (|| -> Result<()> {
+            try_libc!(libc::ocall::shutdown(
+                self.raw_host_fd()? as i32,
+                how.bits()
+            ));
+            Ok(())
+        })();
+        self.readiness.consume(IoEvents::all());
+        ret
+    }
+}
+
+impl Drop for HostSocket {
+    fn drop(&mut self) {
+        self.unregister_loopback();
+        self.untrack_host_events();
     }
 }
 
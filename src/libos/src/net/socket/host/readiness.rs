@@ -0,0 +1,329 @@
+//! The readiness of host sockets, cached inside the enclave.
+//!
+//! Polling host sockets costs an OCall, even if the needed readiness has been known
+//! already. So the events of every host socket are cached in its `HostReadiness`,
+//! which is kept up-to-date in three ways:
+//!
+//! * The results of poll OCalls refresh the events of interest;
+//! * The I/O operations on a host socket clear the events that they may consume
+//!   (e.g., recv clears `IN`), and so does any I/O operation that fails with `EAGAIN`
+//!   (e.g., a peek on a socket that is drained by the host);
+//! * The host sockets that have ever been polled are tracked by a host epoll file
+//!   in edge-triggered mode, which reports the new events of the sockets.
+//!
+//! Thus an event that is present in the cache can be trusted. The absence of an event
+//! is trusted only if it is refreshed by a poll OCall, and for at most one poll. This
+//! way, a poll on the host sockets that are known to be ready returns without OCalls,
+//! while a socket that becomes ready later is never hidden by the cache for long.
+//!
+//! Blocking waits on tracked host sockets wait on the host epoll file instead of
+//! passing the array of host fds to the host again and again. As the host epoll file
+//! is shared by all the waits, only one of them, the fetcher, polls it at a time. The
+//! fetcher dispatches the new events to the notifiers of their sockets, which wake
+//! the waits interested in the sockets only. The other waits sleep on their waiters
+//! until they are woken, one of which takes over when the fetcher leaves.
+
+use std::collections::VecDeque;
+use std::mem::MaybeUninit;
+use std::sync::atomic::{AtomicBool, AtomicU64};
+use std::sync::Weak;
+use std::time::Duration;
+
+use super::*;
+use crate::events::{Waiter, Waker};
+use crate::fs::AtomicIoEvents;
+
+lazy_static! {
+    static ref HOST_SOCKET_TRACKER: HostSocketTracker = HostSocketTracker::new();
+}
+
+/// The cached readiness of a host socket.
+#[derive(Debug)]
+pub struct HostReadiness {
+    // The events that are present
+    events: Atomic<IoEvents>,
+    // The events whose absence is known by a poll OCall
+    known: Atomic<IoEvents>,
+    // The key in the tracker, or zero if the socket is not tracked
+    key: AtomicU64,
+}
+
+impl HostReadiness {
+    pub fn new() -> Self {
+        Self {
+            events: Atomic::new(IoEvents::empty()),
+            known: Atomic::new(IoEvents::empty()),
+            key: AtomicU64::new(0),
+        }
+    }
+
+    pub fn events(&self) -> IoEvents {
+        self.events.load(Ordering::Acquire)
+    }
+
+    /// Update the events of interest with the result of a poll.
+    pub fn update(&self, ready: &IoEvents, mask: &IoEvents) {
+        self.events.update(ready, mask, Ordering::Release);
+        self.known.update(mask, mask, Ordering::Release);
+    }
+
+    /// Add the new events reported by the tracker.
+    fn add(&self, ready: &IoEvents) {
+        self.events.update(ready, ready, Ordering::Release);
+    }
+
+    /// Clear the events that may be consumed by an I/O operation.
+    pub fn consume(&self, events: IoEvents) {
+        self.events
+            .update(&IoEvents::empty(), &events, Ordering::Release);
+        self.known
+            .update(&IoEvents::empty(), &events, Ordering::Release);
+    }
+
+    /// Whether the cache is enough to tell the events of interest.
+    ///
+    /// The absence of `ERR` or `HUP` does not matter, as an error or a hangup is
+    /// reported by the next I/O operation on the socket anyway.
+    pub fn is_cached(&self, mask: &IoEvents) -> bool {
+        let absent = *mask & !self.events() & !(IoEvents::ERR | IoEvents::HUP);
+        if absent.is_empty() {
+            return true;
+        }
+        if !self.known.load(Ordering::Acquire).contains(absent) {
+            return false;
+        }
+        // The absence can only be trusted once
+        self.known
+            .update(&IoEvents::empty(), &absent, Ordering::Release);
+        true
+    }
+}
+
+impl HostSocket {
+    /// Start to track the readiness of the host socket, which is done at most once.
+    pub fn track_host_events(&self) -> Result<()> {
+        HOST_SOCKET_TRACKER.track(self.raw_host_fd()?, &self.readiness, &self.notifier)
+    }
+
+    /// Whether the cached events are enough to tell the events of interest.
+    pub fn is_host_events_cached(&self, mask: &IoEvents) -> bool {
+        self.readiness.is_cached(mask)
+    }
+
+    pub fn is_host_events_tracked(&self) -> bool {
+        self.readiness.key.load(Ordering::Acquire) != 0
+    }
+
+    pub(super) fn untrack_host_events(&self) {
+        HOST_SOCKET_TRACKER.untrack(&self.readiness);
+    }
+}
+
+/// Wait until the waiter is woken or any tracked host socket has new events,
+/// or the method call is timeout or interrupted.
+pub fn wait_tracked_host_sockets(waiter: &Waiter, timeout: Option<&mut Duration>) -> Result<()> {
+    HOST_SOCKET_TRACKER.wait(waiter, timeout)
+}
+
+struct HostSocketTracker {
+    // The tracked host sockets. They are indexed by unique keys instead of host fds,
+    // as a host fd may be reused by a new host socket when an old one is closed.
+    sockets: SgxMutex<HashMap<u64, (Weak<HostReadiness>, Weak<IoNotifier>)>>,
+    next_key: AtomicU64,
+    host_epoll_fd: HostFd,
+    // Whether a wait is polling the host epoll file
+    is_fetching: AtomicBool,
+    // The waits that are ready to take over from the fetcher
+    standby: SgxMutex<VecDeque<Waker>>,
+}
+
+impl HostSocketTracker {
+    // The number of events that are fetched from the host epoll file at a time
+    const BATCH_SIZE: usize = 64;
+
+    pub fn new() -> Self {
+        let host_epoll_fd = {
+            let raw_host_fd = (|| -> Result<u32> {
+                let raw_host_fd = try_libc!(libc::ocall::epoll_create1(libc::EPOLL_CLOEXEC)) as u32;
+                Ok(raw_host_fd)
+            })()
+            .expect("epoll_create should never fail");
+
+            HostFd::new(raw_host_fd)
+        };
+        Self {
+            sockets: Default::default(),
+            next_key: AtomicU64::new(1),
+            host_epoll_fd,
+            is_fetching: AtomicBool::new(false),
+            standby: Default::default(),
+        }
+    }
+
+    pub fn track(
+        &self,
+        host_fd: FileDesc,
+        readiness: &Arc<HostReadiness>,
+        notifier: &Arc<IoNotifier>,
+    ) -> Result<()> {
+        if readiness.key.load(Ordering::Acquire) != 0 {
+            return Ok(());
+        }
+        let key = self.next_key.fetch_add(1, Ordering::Relaxed);
+        if readiness
+            .key
+            .compare_exchange(0, key, Ordering::AcqRel, Ordering::Acquire)
+            .is_err()
+        {
+            // Tracked by another thread
+            return Ok(());
+        }
+
+        self.sockets
+            .lock()
+            .unwrap()
+            .insert(key, (Arc::downgrade(readiness), Arc::downgrade(notifier)));
+
+        let mut c_event = libc::epoll_event {
+            events: (libc::EPOLLIN
+                | libc::EPOLLOUT
+                | libc::EPOLLPRI
+                | libc::EPOLLRDHUP
+                | libc::EPOLLET) as u32,
+            u64: key,
+        };
+        let ret = (|| -> Result<()> {
+            try_libc!(libc::ocall::epoll_ctl(
+                self.host_epoll_fd.to_raw() as i32,
+                libc::EPOLL_CTL_ADD,
+                host_fd as i32,
+                &mut c_event,
+            ));
+            Ok(())
+        })();
+        if let Err(e) = ret {
+            self.untrack(readiness);
+            return Err(e);
+        }
+        Ok(())
+    }
+
+    pub fn untrack(&self, readiness: &HostReadiness) {
+        let key = readiness.key.swap(0, Ordering::AcqRel);
+        if key == 0 {
+            return;
+        }
+        // The host socket is removed from the host epoll file when it is closed, so
+        // there is no need for an OCall
+        self.sockets.lock().unwrap().remove(&key);
+    }
+
+    pub fn wait(&self, waiter: &Waiter, timeout: Option<&mut Duration>) -> Result<()> {
+        const ZERO: Duration = Duration::from_secs(0);
+        if let Some(timeout) = timeout.as_ref() {
+            if **timeout == ZERO {
+                return_errno!(ETIMEDOUT, "should return immediately");
+            }
+        }
+
+        loop {
+            if self
+                .is_fetching
+                .compare_exchange(false, true, Ordering::SeqCst, Ordering::SeqCst)
+                .is_ok()
+            {
+                let ret = self.fetch_until_woken(waiter, timeout);
+                self.is_fetching.store(false, Ordering::SeqCst);
+                // Hand over to a wait on standby, which may return spuriously
+                if let Some(waker) = self.standby.lock().unwrap().pop_front() {
+                    waker.wake();
+                }
+                return ret;
+            }
+
+            self.standby.lock().unwrap().push_back(waiter.waker());
+            // Check again in case that the fetcher leaves before the waker is pushed
+            if !self.is_fetching.load(Ordering::SeqCst) {
+                self.remove_standby(waiter);
+                continue;
+            }
+            let ret = waiter.wait_mut(timeout);
+            self.remove_standby(waiter);
+            return ret;
+        }
+    }
+
+    fn remove_standby(&self, waiter: &Waiter) {
+        self.standby
+            .lock()
+            .unwrap()
+            .retain(|waker| !waker.belongs_to(waiter));
+    }
+
+    // Wait for the waiter and the host epoll file, and fetch the new events of the host
+    // epoll file, until the waiter is woken
+    fn fetch_until_woken(&self, waiter: &Waiter, mut timeout: Option<&mut Duration>) -> Result<()> {
+        while !waiter.is_woken() {
+            let mut pollfds = [libc::pollfd {
+                fd: self.host_epoll_fd.to_raw() as i32,
+                events: libc::POLLIN,
+                revents: 0,
+            }];
+            let num_events = waiter.wait_host_fds(&mut pollfds, timeout.as_deref_mut())?;
+            if num_events > 0 {
+                self.fetch_events();
+            } else if !waiter.is_woken() {
+                return_errno!(ETIMEDOUT, "no results and the time is up");
+            }
+        }
+        Ok(())
+    }
+
+    // Fetch the new events from the host epoll file, then update the readiness of the
+    // host sockets and notify the observers
+    fn fetch_events(&self) {
+        let mut raw_events = [MaybeUninit::<libc::epoll_event>::uninit(); Self::BATCH_SIZE];
+        loop {
+            let ocall_res = || -> Result<usize> {
+                let count = try_libc!(libc::ocall::epoll_wait(
+                    self.host_epoll_fd.to_raw() as i32,
+                    raw_events.as_mut_ptr() as *mut _,
+                    raw_events.len() as c_int,
+                    0,
+                )) as usize;
+                assert!(count <= raw_events.len());
+                Ok(count)
+            }();
+            let count = match ocall_res {
+                Ok(count) => count,
+                Err(e) => {
+                    warn!("Unexpected error from ocall::epoll_wait(): {:?}", e);
+                    return;
+                }
+            };
+
+            for raw_event in &raw_events[..count] {
+                let raw_event = unsafe { raw_event.assume_init() };
+                let io_events = IoEvents::from_raw(raw_event.events as u32);
+                let key = raw_event.u64;
+
+                let (readiness, notifier) = {
+                    let sockets = self.sockets.lock().unwrap();
+                    match sockets.get(&key) {
+                        // The host socket may be closed
+                        None => continue,
+                        Some((readiness, notifier)) => (readiness.upgrade(), notifier.upgrade()),
+                    }
+                };
+                if let (Some(readiness), Some(notifier)) = (readiness, notifier) {
+                    readiness.add(&io_events);
+                    notifier.broadcast(&io_events);
+                }
+            }
+
+            if count < raw_events.len() {
+                return;
+            }
+        }
+    }
+}
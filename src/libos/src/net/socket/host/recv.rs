@@ -1,3 +1,5 @@
+use std::sync::atomic::Ordering;
+
 use super::*;
 use crate::untrusted::{SliceAsMutPtrAndLen, SliceAsPtrAndLen, UntrustedSliceAlloc};
 
@@ -30,6 +32,28 @@ impl HostSocket {
         flags: RecvFlags,
         mut name: Option<&mut [u8]>,
         mut control: Option<&mut [u8]>,
+    ) -> Result<(usize, usize, usize, MsgHdrFlags)> {
+        if let Some(stream) = self.loopback_stream() {
+            let bytes_recvd = stream.recvmsg(data, flags)?;
+            return Ok((bytes_recvd, 0, 0, MsgHdrFlags::empty()));
+        }
+        if let Some(datagram) = self.loopback_datagram() {
+            return self.recv_loopback_datagram(&datagram, data, flags, name, control);
+        }
+
+        let is_nonblocking =
+            flags.contains(RecvFlags::MSG_DONTWAIT) || self.nonblocking.load(Ordering::Relaxed);
+        self.block_on_host(IoEvents::IN, is_nonblocking, || {
+            self.do_recvmsg_host(data, flags, name.as_deref_mut(), control.as_deref_mut())
+        })
+    }
+
+    pub(super) fn do_recvmsg_host(
+        &self,
+        data: &mut [&mut [u8]],
+        flags: RecvFlags,
+        name: Option<&mut [u8]>,
+        control: Option<&mut [u8]>,
     ) -> Result<(usize, usize, usize, MsgHdrFlags)> {
         let data_length = data.iter().map(|s| s.len()).sum();
         let u_allocator = UntrustedSliceAlloc::new(data_length)?;
@@ -40,7 +64,16 @@ impl HostSocket {
             }
             bufs
         };
-        let retval = self.do_recvmsg_untrusted_data(&mut u_data, flags, name, control)?;
+        let retval = self.do_recvmsg_untrusted_data(&mut u_data, flags, name, control);
+        let is_drained = match &retval {
+            Err(e) => e.errno() == EAGAIN,
+            // Whether there is more to receive is unknown
+            Ok(_) => !flags.contains(RecvFlags::MSG_PEEK),
+        };
+        if is_drained {
+            self.readiness.consume(IoEvents::IN);
+        }
+        let retval = retval?;
 
         let mut remain = retval.0;
         for (i, buf) in data.iter_mut().enumerate() {
@@ -64,7 +97,7 @@ impl HostSocket {
     ) -> Result<(usize, usize, usize, MsgHdrFlags)> {
         // Prepare the arguments for OCall
         // Host socket fd
-        let host_fd = self.raw_host_fd() as i32;
+        let host_fd = self.raw_host_fd()? as i32;
         // Name
         let (msg_name, msg_namelen) = name.as_mut_ptr_and_len();
         let msg_name = msg_name as *mut c_void;
@@ -1,3 +1,5 @@
+use std::sync::atomic::Ordering;
+
 use super::*;
 
 impl HostSocket {
@@ -22,6 +24,51 @@ impl HostSocket {
         flags: SendFlags,
         name: Option<&[u8]>,
         control: Option<&[u8]>,
+    ) -> Result<usize> {
+        if let Some(stream) = self.loopback_stream() {
+            return stream.sendmsg(data, flags);
+        }
+        if let Some(bytes_sent) = self.send_loopback_datagram(data, flags, name, control)? {
+            return Ok(bytes_sent);
+        }
+
+        let is_nonblocking =
+            flags.contains(SendFlags::MSG_DONTWAIT) || self.nonblocking.load(Ordering::Relaxed);
+        let data_length: usize = data.iter().map(|buf| buf.len()).sum();
+        let mut bytes_sent = 0;
+        loop {
+            let remain;
+            let bufs = if bytes_sent == 0 {
+                data
+            } else {
+                remain = remaining_bufs(data, bytes_sent);
+                &remain[..]
+            };
+            let ret = self.block_on_host(IoEvents::OUT, is_nonblocking, || {
+                self.do_sendmsg_host(bufs, flags, name, control)
+            });
+            match ret {
+                Ok(len) if len > 0 => bytes_sent += len,
+                Ok(_) => break,
+                Err(e) if bytes_sent == 0 => return Err(e),
+                // E.g., interrupted by a signal after some data is sent
+                Err(_) => break,
+            }
+            // A blocking send returns after all data is sent, as the host would do if the
+            // host socket were blocking
+            if bytes_sent == data_length || is_nonblocking || !self.is_blocking_in_libos() {
+                break;
+            }
+        }
+        Ok(bytes_sent)
+    }
+
+    fn do_sendmsg_host(
+        &self,
+        data: &[&[u8]],
+        flags: SendFlags,
+        name: Option<&[u8]>,
+        control: Option<&[u8]>,
     ) -> Result<usize> {
         let data_length = data.iter().map(|s| s.len()).sum();
         let u_allocator = UntrustedSliceAlloc::new(data_length)?;
@@ -33,7 +80,13 @@ impl HostSocket {
             bufs
         };
 
-        self.do_sendmsg_untrusted_data(&u_data, flags, name, control)
+        let ret = self.do_sendmsg_untrusted_data(&u_data, flags, name, control);
+        match &ret {
+            Ok(bytes_sent) if *bytes_sent == data_length => {}
+            // The send buffer may be full
+            _ => self.readiness.consume(IoEvents::OUT),
+        }
+        ret
     }
 
     fn do_sendmsg_untrusted_data(
@@ -46,7 +99,7 @@ impl HostSocket {
         // Prepare the arguments for OCall
         let mut retval: isize = 0;
         // Host socket fd
-        let host_fd = self.raw_host_fd() as i32;
+        let host_fd = self.raw_host_fd()? as i32;
         // Name
         let (msg_name, msg_namelen) = name.as_ptr_and_len();
         let msg_name = msg_name as *const c_void;
@@ -88,6 +141,20 @@ impl HostSocket {
     }
 }
 
+// The buffers that remain to be sent after the given number of bytes
+fn remaining_bufs<'a>(bufs: &[&'a [u8]], mut skip: usize) -> Vec<&'a [u8]> {
+    let mut remain = Vec::with_capacity(bufs.len());
+    for buf in bufs {
+        if skip >= buf.len() {
+            skip -= buf.len();
+            continue;
+        }
+        remain.push(&buf[skip..]);
+        skip = 0;
+    }
+    remain
+}
+
 extern "C" {
     fn occlum_ocall_sendmsg(
         ret: *mut ssize_t,
@@ -5,8 +5,8 @@ use atomic::{Atomic, Ordering};
 
 use super::*;
 use crate::fs::{
-    occlum_ocall_ioctl, AccessMode, AtomicIoEvents, CreationFlags, File, FileRef, HostFd, IoEvents,
-    IoctlCmd, StatusFlags, STATUS_FLAGS_MASK,
+    occlum_ocall_ioctl, AccessMode, CreationFlags, File, FileRef, HostFd, IoEvents, IoctlCmd,
+    StatusFlags, STATUS_FLAGS_MASK,
 };
 
 //TODO: refactor write syscall to allow zero length with non-zero buffer
@@ -55,29 +55,63 @@ impl File for HostSocket {
     }
 
     fn status_flags(&self) -> Result<StatusFlags> {
+        if self.loopback_stream().is_some() {
+            return Ok(if self.nonblocking.load(Ordering::Relaxed) {
+                StatusFlags::O_NONBLOCK
+            } else {
+                StatusFlags::empty()
+            });
+        }
+
         let ret = try_libc!(libc::ocall::fcntl_arg0(
-            self.raw_host_fd() as i32,
+            self.raw_host_fd()? as i32,
             libc::F_GETFL
         ));
-        Ok(StatusFlags::from_bits_truncate(ret as u32))
+        let mut status_flags = StatusFlags::from_bits_truncate(ret as u32);
+        // The host socket may be kept non-blocking for the in-enclave peers
+        if self.is_host_always_nonblocking() {
+            status_flags.set(
+                StatusFlags::O_NONBLOCK,
+                self.nonblocking.load(Ordering::Relaxed),
+            );
+        }
+        Ok(status_flags)
     }
 
     fn set_status_flags(&self, new_status_flags: StatusFlags) -> Result<()> {
-        let raw_status_flags = (new_status_flags & STATUS_FLAGS_MASK).bits();
+        let nonblocking = new_status_flags.contains(StatusFlags::O_NONBLOCK);
+        if self.loopback_stream().is_some() {
+            self.set_nonblocking(nonblocking);
+            return Ok(());
+        }
+
+        let mut raw_status_flags = (new_status_flags & STATUS_FLAGS_MASK).bits();
+        if self.is_host_always_nonblocking() {
+            raw_status_flags |= StatusFlags::O_NONBLOCK.bits();
+        }
         try_libc!(libc::ocall::fcntl_arg1(
-            self.raw_host_fd() as i32,
+            self.raw_host_fd()? as i32,
             libc::F_SETFL,
             raw_status_flags as c_int
         ));
+
+        self.set_nonblocking(nonblocking);
         Ok(())
     }
 
     fn poll_new(&self) -> IoEvents {
-        self.host_events.load(Ordering::Acquire)
+        if let Some(events) = self.poll_loopback() {
+            return events;
+        }
+        self.readiness.events()
     }
 
     fn host_fd(&self) -> Option<&HostFd> {
-        Some(&self.host_fd)
+        // The events of an in-enclave connection are not reflected by the host fd
+        if self.loopback_stream().is_some() {
+            return None;
+        }
+        self.host_fd.get()
     }
 
     fn notifier(&self) -> Option<&IoNotifier> {
@@ -85,7 +119,10 @@ impl File for HostSocket {
     }
 
     fn update_host_events(&self, ready: &IoEvents, mask: &IoEvents, trigger_notifier: bool) {
-        self.host_events.update(ready, mask, Ordering::Release);
+        if self.loopback_stream().is_some() {
+            return;
+        }
+        self.readiness.update(ready, mask);
 
         if trigger_notifier {
             self.notifier.broadcast(ready);
@@ -96,3 +133,12 @@ impl File for HostSocket {
         self
     }
 }
+
+impl HostSocket {
+    fn set_nonblocking(&self, nonblocking: bool) {
+        self.nonblocking.store(nonblocking, Ordering::Relaxed);
+        if let Some(stream) = self.loopback_stream() {
+            stream.set_nonblocking(nonblocking);
+        }
+    }
+}
@@ -12,10 +12,10 @@ mod unix;
 
 pub use self::address_family::AddressFamily;
 pub use self::flags::{FileFlags, MsgHdrFlags, RecvFlags, SendFlags};
-pub use self::host::{HostSocket, HostSocketType};
+pub use self::host::{wait_tracked_host_sockets, HostSocket, HostSocketType};
 pub use self::iovs::{Iovs, IovsMut, SliceAsLibcIovec};
-pub use self::msg::{mmsghdr, msghdr, msghdr_mut, MsgHdr, MsgHdrMut};
+pub use self::msg::{mmsghdr, mmsghdr_mut, msghdr, msghdr_mut, MsgHdr, MsgHdrMut};
 pub use self::shutdown::HowToShut;
 pub use self::socket_address::SockAddr;
 pub use self::socket_type::SocketType;
-pub use self::unix::{socketpair, unix_socket, AsUnixSocket, UnixAddr};
+pub use self::unix::{socketpair, unix_socket, AsUnixDatagram, AsUnixSocket, UnixAddr};
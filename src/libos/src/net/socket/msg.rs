@@ -34,6 +34,13 @@ pub struct msghdr_mut {
     pub msg_flags: c_int,
 }
 
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct mmsghdr_mut {
+    pub msg_hdr: msghdr_mut,
+    pub msg_len: c_uint,
+}
+
 /// MsgHdr is a memory-safe, immutable wrapper of msghdr
 pub struct MsgHdr<'a> {
     name: Option<&'a [u8]>,
@@ -1,4 +1,5 @@
 use super::*;
+use fs::{CreationFlags, FileMode};
 use std::path::{Path, PathBuf};
 use std::{cmp, mem, slice, str};
 
@@ -58,6 +59,25 @@ impl Addr {
         }
     }
 
+    /// Create the corresponding socket file in the fs for a pathname address and fill the
+    /// address with its inode. It does nothing for an abstract address.
+    pub fn create_socket_file(&mut self) -> Result<()> {
+        if let Self::File(inode_num, path) = self {
+            let corresponding_inode_num = {
+                let current = current!();
+                let fs = current.fs().read().unwrap();
+                let file_ref = fs.open_file(
+                    path.path_str(),
+                    CreationFlags::O_CREAT.bits(),
+                    FileMode::from_bits(0o777).unwrap(),
+                )?;
+                file_ref.metadata()?.inode
+            };
+            *inode_num = Some(corresponding_inode_num);
+        }
+        Ok(())
+    }
+
     pub fn copy_to_slice(&self, dst: &mut [u8]) -> usize {
         let (raw_addr, addr_len) = self.to_raw();
         let src =
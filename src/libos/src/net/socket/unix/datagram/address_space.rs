@@ -0,0 +1,67 @@
+use super::endpoint::{Endpoint, Inner};
+use super::*;
+use std::collections::btree_map::BTreeMap;
+use std::sync::Weak;
+
+lazy_static! {
+    pub(super) static ref DGRAM_ADDRESS_SPACE: AddressSpace = AddressSpace::new();
+}
+
+/// The bound datagram and seqpacket unix sockets indexed by their addresses. The endpoints are
+/// referred weakly so that the address space never keeps a closed socket alive.
+pub struct AddressSpace {
+    space: SgxMutex<BTreeMap<AddressSpaceKey, Weak<Inner>>>,
+}
+
+impl AddressSpace {
+    pub fn new() -> Self {
+        Self {
+            space: SgxMutex::new(BTreeMap::new()),
+        }
+    }
+
+    pub fn add_binder(&self, addr: &Addr, endpoint: &Endpoint) -> Result<()> {
+        let key = AddressSpaceKey::from_addr(addr)
+            .ok_or_else(|| errno!(EINVAL, "can't find socket file"))?;
+        let mut space = self.space.lock().unwrap();
+        if let Some(bound) = space.get(&key).and_then(Weak::upgrade) {
+            if !bound.is_closed() {
+                return_errno!(EADDRINUSE, "the addr is already bound");
+            }
+        }
+        space.insert(key, Arc::downgrade(endpoint));
+        Ok(())
+    }
+
+    /// Look up the socket bound to the address. The type of the socket must match.
+    pub fn lookup(&self, addr: &Addr, socket_type: SocketType) -> Result<Endpoint> {
+        let endpoint = AddressSpaceKey::from_addr(addr)
+            .and_then(|key| self.space.lock().unwrap().get(&key).and_then(Weak::upgrade))
+            .filter(|endpoint| !endpoint.is_closed())
+            .ok_or_else(|| errno!(ECONNREFUSED, "no socket is bound to the address"))?;
+        if endpoint.socket_type() != socket_type {
+            return_errno!(
+                EPROTOTYPE,
+                "the socket type of the remote address mismatches"
+            );
+        }
+        Ok(endpoint)
+    }
+
+    /// Remove the address if it is still bound to the endpoint
+    pub fn remove_addr(&self, addr: &Addr, endpoint: &Inner) {
+        let key = match AddressSpaceKey::from_addr(addr) {
+            Some(key) => key,
+            None => {
+                warn!("address space key not exit: {:?}", addr);
+                return;
+            }
+        };
+        let mut space = self.space.lock().unwrap();
+        if let Some(bound) = space.get(&key) {
+            if bound.as_ptr() == endpoint as *const Inner {
+                space.remove(&key);
+            }
+        }
+    }
+}
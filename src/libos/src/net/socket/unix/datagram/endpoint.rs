@@ -0,0 +1,429 @@
+use super::address_space::DGRAM_ADDRESS_SPACE;
+use super::message::{Charge, Message, QueuedMessage};
+use super::*;
+use events::{Waiter, WaiterQueue};
+use fs::{IoEvents, IoNotifier};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::Weak;
+
+pub type Endpoint = Arc<Inner>;
+
+/// The maximum number of messages in the receive queue of an endpoint, which is the default
+/// value of /proc/sys/net/unix/max_dgram_qlen on Linux.
+const MAX_QUEUE_LEN: usize = 512;
+
+/// The endpoint of a datagram or seqpacket unix socket.
+///
+/// Each endpoint has a queue of the messages received. A message is charged to the send
+/// buffer of its sender until it is dequeued, so a sender cannot have more than
+/// `DEFAULT_BUF_SIZE` bytes in flight, no matter how many receivers it is sending to.
+pub struct Inner {
+    socket_type: SocketType,
+    addr: RwLock<Option<Addr>>,
+    // A datagram socket may connect to a peer and reconnect to another one later. A seqpacket
+    // socket is connected only once.
+    peer: RwLock<Option<Weak<Inner>>>,
+    queue: SgxMutex<VecDeque<QueuedMessage>>,
+    // The pending connections of a listening seqpacket socket
+    backlog: SgxMutex<Option<Backlog>>,
+    pub(super) sent_bytes: AtomicUsize,
+    read_shutdown: AtomicBool,
+    write_shutdown: AtomicBool,
+    closed: AtomicBool,
+    nonblocking: AtomicBool,
+    readers: WaiterQueue,
+    writers: WaiterQueue,
+    notifier: IoNotifier,
+}
+
+struct Backlog {
+    incoming: VecDeque<Endpoint>,
+    capacity: usize,
+}
+
+impl Inner {
+    pub fn new(socket_type: SocketType, nonblocking: bool) -> Endpoint {
+        Arc::new(Self {
+            socket_type,
+            addr: RwLock::new(None),
+            peer: RwLock::new(None),
+            queue: SgxMutex::new(VecDeque::new()),
+            backlog: SgxMutex::new(None),
+            sent_bytes: AtomicUsize::new(0),
+            read_shutdown: AtomicBool::new(false),
+            write_shutdown: AtomicBool::new(false),
+            closed: AtomicBool::new(false),
+            nonblocking: AtomicBool::new(nonblocking),
+            readers: WaiterQueue::new(),
+            writers: WaiterQueue::new(),
+            notifier: IoNotifier::new(),
+        })
+    }
+
+    /// Constructor of two connected endpoints
+    pub fn new_pair(socket_type: SocketType, nonblocking: bool) -> (Endpoint, Endpoint) {
+        let end_a = Self::new(socket_type, nonblocking);
+        let end_b = Self::new(socket_type, nonblocking);
+        end_a.set_peer(&end_b);
+        end_b.set_peer(&end_a);
+        (end_a, end_b)
+    }
+
+    pub fn socket_type(&self) -> SocketType {
+        self.socket_type
+    }
+
+    pub fn addr(&self) -> Option<Addr> {
+        self.addr.read().unwrap().clone()
+    }
+
+    pub fn set_addr(&self, addr: &Addr) {
+        *self.addr.write().unwrap() = Some(addr.clone());
+    }
+
+    pub fn is_connected(&self) -> bool {
+        self.peer.read().unwrap().is_some()
+    }
+
+    pub fn set_peer(&self, peer: &Endpoint) {
+        *self.peer.write().unwrap() = Some(Arc::downgrade(peer));
+    }
+
+    /// Get the connected peer. The error is ENOTCONN if the endpoint has never been connected,
+    /// or ECONNREFUSED (datagram) or EPIPE (seqpacket) if the peer has been closed.
+    pub fn peer(&self) -> Result<Endpoint> {
+        match &*self.peer.read().unwrap() {
+            None => return_errno!(ENOTCONN, "the socket is not connected"),
+            Some(peer) => match peer.upgrade() {
+                Some(peer) if !peer.is_closed() => Ok(peer),
+                _ if self.socket_type == SocketType::SEQPACKET => {
+                    return_errno!(EPIPE, "the peer is closed")
+                }
+                _ => return_errno!(ECONNREFUSED, "the peer is closed"),
+            },
+        }
+    }
+
+    pub fn peer_addr(&self) -> Option<Addr> {
+        self.peer.read().unwrap().as_ref()?.upgrade()?.addr()
+    }
+
+    pub fn nonblocking(&self) -> bool {
+        self.nonblocking.load(Ordering::Relaxed)
+    }
+
+    pub fn set_nonblocking(&self, nonblocking: bool) {
+        self.nonblocking.store(nonblocking, Ordering::Relaxed);
+    }
+
+    pub fn is_closed(&self) -> bool {
+        self.closed.load(Ordering::Acquire)
+    }
+
+    pub fn notifier(&self) -> &IoNotifier {
+        &self.notifier
+    }
+
+    pub(super) fn sndbuf_size(&self) -> usize {
+        DEFAULT_BUF_SIZE
+    }
+
+    /// Send a message to the receiver. The message is charged to this endpoint.
+    pub fn send_to(
+        self: &Arc<Self>,
+        receiver: &Endpoint,
+        msg: Message,
+        nonblocking: bool,
+    ) -> Result<usize> {
+        let len = msg.len();
+        if len > self.sndbuf_size() {
+            return_errno!(EMSGSIZE, "the message is too large");
+        }
+
+        let mut msg = Some(msg);
+        wait_until(&[&self.writers, &receiver.writers], nonblocking, || {
+            if self.write_shutdown.load(Ordering::Acquire) {
+                return_errno!(EPIPE, "the socket is shut down for writing");
+            }
+            receiver.try_enqueue(self, &mut msg)
+        })?;
+        Ok(len)
+    }
+
+    fn try_enqueue(&self, sender: &Endpoint, msg: &mut Option<Message>) -> Result<()> {
+        if self.is_closed() || self.read_shutdown.load(Ordering::Acquire) {
+            if self.socket_type == SocketType::SEQPACKET {
+                return_errno!(EPIPE, "the peer is shut down for reading");
+            }
+            return_errno!(ECONNREFUSED, "the receiver is shut down for reading");
+        }
+        if let Some(peer) = &*self.peer.read().unwrap() {
+            // A connected datagram socket only receives the messages from its peer
+            if peer.as_ptr() != Arc::as_ptr(sender) {
+                return_errno!(EPERM, "the receiver is connected to another socket");
+            }
+        }
+
+        {
+            let mut queue = self.queue.lock().unwrap();
+            if queue.len() >= MAX_QUEUE_LEN {
+                return_errno!(EAGAIN, "the receive queue is full");
+            }
+            let charge = Charge::try_new(sender, msg.as_ref().unwrap().len())
+                .ok_or_else(|| errno!(EAGAIN, "the send buffer is full"))?;
+            queue.push_back(QueuedMessage::new(msg.take().unwrap(), charge));
+        }
+
+        self.readers.dequeue_and_wake_all();
+        self.notifier.broadcast(&IoEvents::IN);
+        Ok(())
+    }
+
+    /// Receive a message. Return None if no more message can be received.
+    pub fn recv(&self, nonblocking: bool, peek: bool) -> Result<Option<Message>> {
+        wait_until(&[&self.readers], nonblocking, || {
+            if let Some(queued) = self.try_dequeue(peek) {
+                return Ok(Some(queued));
+            }
+            if self.read_shutdown.load(Ordering::Acquire) || self.is_peer_gone() {
+                return Ok(None);
+            }
+            return_errno!(EAGAIN, "no message to receive");
+        })
+    }
+
+    fn try_dequeue(&self, peek: bool) -> Option<Message> {
+        let queued = {
+            let mut queue = self.queue.lock().unwrap();
+            if peek {
+                return queue.front().map(|queued| queued.msg.clone());
+            }
+            queue.pop_front()?
+        };
+
+        // The senders may be waiting for the space of the queue
+        self.writers.dequeue_and_wake_all();
+        // Dropping the charge releases the send buffer of the sender
+        let QueuedMessage { msg, .. } = queued;
+        Some(msg)
+    }
+
+    pub fn bytes_to_read(&self) -> usize {
+        let queue = self.queue.lock().unwrap();
+        queue.front().map(|queued| queued.msg.len()).unwrap_or(0)
+    }
+
+    pub fn listen(&self, capacity: usize) -> Result<()> {
+        if self.is_connected() {
+            return_errno!(EINVAL, "the socket is already connected");
+        }
+
+        let mut backlog = self.backlog.lock().unwrap();
+        match &mut *backlog {
+            Some(backlog) => backlog.capacity = capacity,
+            None => {
+                *backlog = Some(Backlog {
+                    incoming: VecDeque::new(),
+                    capacity,
+                })
+            }
+        }
+        Ok(())
+    }
+
+    pub fn is_listening(&self) -> bool {
+        self.backlog.lock().unwrap().is_some()
+    }
+
+    /// Connect a seqpacket endpoint to this listening endpoint. The endpoint to be accepted is
+    /// put in the backlog.
+    pub fn push_incoming(self: &Arc<Self>, client: &Endpoint) -> Result<()> {
+        {
+            let mut backlog = self.backlog.lock().unwrap();
+            let backlog = match &mut *backlog {
+                Some(backlog) if !self.is_closed() => backlog,
+                _ => return_errno!(ECONNREFUSED, "no one's listening on the remote address"),
+            };
+            if backlog.incoming.len() >= backlog.capacity.max(1) {
+                return_errno!(ECONNREFUSED, "the backlog is full");
+            }
+
+            let server = Self::new(self.socket_type, false);
+            if let Some(addr) = self.addr() {
+                server.set_addr(&addr);
+            }
+            server.set_peer(client);
+            client.set_peer(&server);
+            backlog.incoming.push_back(server);
+        }
+
+        self.readers.dequeue_and_wake_all();
+        self.notifier.broadcast(&IoEvents::IN);
+        Ok(())
+    }
+
+    pub fn pop_incoming(&self, nonblocking: bool) -> Result<Endpoint> {
+        wait_until(&[&self.readers], nonblocking, || {
+            let mut backlog = self.backlog.lock().unwrap();
+            backlog
+                .as_mut()
+                .ok_or_else(|| errno!(EINVAL, "the socket is not listening"))?
+                .incoming
+                .pop_front()
+                .ok_or_else(|| errno!(EAGAIN, "no connection is incoming"))
+        })
+    }
+
+    pub fn shutdown(&self, how: HowToShut) -> Result<()> {
+        if self.socket_type == SocketType::SEQPACKET && !self.is_connected() {
+            return_errno!(ENOTCONN, "the socket is not connected");
+        }
+
+        if how.to_shut_read() {
+            self.read_shutdown.store(true, Ordering::Release);
+        }
+        if how.to_shut_write() {
+            self.write_shutdown.store(true, Ordering::Release);
+        }
+        self.wake_all();
+
+        // A seqpacket connection is shut down in both endpoints
+        if self.socket_type == SocketType::SEQPACKET {
+            if let Ok(peer) = self.peer() {
+                if how.to_shut_read() {
+                    peer.write_shutdown.store(true, Ordering::Release);
+                }
+                if how.to_shut_write() {
+                    peer.read_shutdown.store(true, Ordering::Release);
+                }
+                peer.wake_all();
+            }
+        }
+        Ok(())
+    }
+
+    /// Close the endpoint when its socket file is closed
+    pub fn close(&self) {
+        self.closed.store(true, Ordering::Release);
+        if let Some(addr) = self.addr() {
+            DGRAM_ADDRESS_SPACE.remove_addr(&addr, self);
+        }
+
+        // Discard the received messages and the pending connections. This also releases the
+        // files in flight, which may be the sockets referring to this endpoint.
+        let queue = std::mem::take(&mut *self.queue.lock().unwrap());
+        drop(queue);
+        if let Some(backlog) = self.backlog.lock().unwrap().take() {
+            for server in backlog.incoming {
+                server.close();
+            }
+        }
+
+        if let Some(peer) = self.peer.read().unwrap().as_ref().and_then(Weak::upgrade) {
+            peer.wake_all();
+        }
+        self.wake_all();
+    }
+
+    pub fn poll(&self) -> IoEvents {
+        let mut events = IoEvents::empty();
+
+        if !self.queue.lock().unwrap().is_empty() {
+            events |= IoEvents::IN;
+        }
+        if let Some(backlog) = &*self.backlog.lock().unwrap() {
+            if !backlog.incoming.is_empty() {
+                events |= IoEvents::IN;
+            }
+            return events;
+        }
+
+        let read_shutdown = self.read_shutdown.load(Ordering::Acquire);
+        let write_shutdown = self.write_shutdown.load(Ordering::Acquire);
+        if read_shutdown {
+            events |= IoEvents::RDHUP | IoEvents::IN;
+        }
+        if (read_shutdown && write_shutdown) || self.is_peer_gone() {
+            events |= IoEvents::HUP | IoEvents::RDHUP | IoEvents::IN;
+        }
+
+        let peer_writable = match self.peer() {
+            Ok(peer) => peer.queue.lock().unwrap().len() < MAX_QUEUE_LEN,
+            Err(_) => true,
+        };
+        if !write_shutdown
+            && peer_writable
+            && self.sent_bytes.load(Ordering::Acquire) < self.sndbuf_size()
+        {
+            events |= IoEvents::OUT;
+        }
+        events
+    }
+
+    // A seqpacket connection is broken when the peer is closed
+    fn is_peer_gone(&self) -> bool {
+        self.socket_type == SocketType::SEQPACKET && self.is_connected() && self.peer().is_err()
+    }
+
+    pub(super) fn wake_writers(&self) {
+        self.writers.dequeue_and_wake_all();
+        self.notifier.broadcast(&IoEvents::OUT);
+    }
+
+    fn wake_all(&self) {
+        self.readers.dequeue_and_wake_all();
+        self.writers.dequeue_and_wake_all();
+        self.notifier.broadcast(&self.poll());
+    }
+}
+
+impl Debug for Inner {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        f.debug_struct("Inner")
+            .field("socket_type", &self.socket_type)
+            .field("addr", &self.addr())
+            .field("nonblocking", &self.nonblocking())
+            .finish()
+    }
+}
+
+/// Retry the operation until it does not fail with EAGAIN, waiting on the waiter queues
+/// between two attempts. The caller must make sure that a waiter in one of the queues is
+/// woken after the condition of the operation changes.
+fn wait_until<T>(
+    queues: &[&WaiterQueue],
+    nonblocking: bool,
+    mut try_op: impl FnMut() -> Result<T>,
+) -> Result<T> {
+    // Try once without the waiter since the operation succeeds immediately in most cases
+    match try_op() {
+        Err(e) if e.errno() == EAGAIN && !nonblocking => {}
+        res => return res,
+    }
+
+    let waiter = Waiter::new();
+    loop {
+        for queue in queues {
+            queue.reset_and_enqueue(&waiter);
+        }
+        let res = match try_op() {
+            Err(e) if e.errno() == EAGAIN => waiter.wait(None).map(|_| None),
+            res => res.map(Some),
+        };
+        match res {
+            Ok(None) => continue,
+            Ok(Some(ret)) => {
+                for queue in queues {
+                    queue.dequeue(&waiter);
+                }
+                return Ok(ret);
+            }
+            Err(e) => {
+                for queue in queues {
+                    queue.dequeue(&waiter);
+                }
+                return Err(e);
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+use super::*;
+use fs::{AccessMode, File, FileRef, IoEvents, IoNotifier, IoctlCmd, StatusFlags};
+use rcore_fs::vfs::{FileType, Metadata, Timespec};
+use std::any::Any;
+
+impl File for Datagram {
+    fn read(&self, buf: &mut [u8]) -> Result<usize> {
+        self.recvfrom(buf, RecvFlags::empty())
+            .map(|(data_len, _)| data_len)
+    }
+
+    fn write(&self, buf: &[u8]) -> Result<usize> {
+        self.sendto(buf, SendFlags::empty(), &None)
+    }
+
+    fn read_at(&self, offset: usize, buf: &mut [u8]) -> Result<usize> {
+        if offset != 0 {
+            return_errno!(ESPIPE, "a nonzero position is not supported");
+        }
+        self.read(buf)
+    }
+
+    fn write_at(&self, offset: usize, buf: &[u8]) -> Result<usize> {
+        if offset != 0 {
+            return_errno!(ESPIPE, "a nonzero position is not supported");
+        }
+        self.write(buf)
+    }
+
+    fn readv(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        match self.recv(RecvFlags::empty())? {
+            Some(msg) => Ok(msg.copy_to_slices(bufs)),
+            None => Ok(0),
+        }
+    }
+
+    fn writev(&self, bufs: &[&[u8]]) -> Result<usize> {
+        self.send(bufs, Vec::new(), SendFlags::empty(), None)
+    }
+
+    fn ioctl(&self, cmd: &mut IoctlCmd) -> Result<i32> {
+        match cmd {
+            IoctlCmd::TCGETS(_) => return_errno!(ENOTTY, "not tty device"),
+            IoctlCmd::TCSETS(_) => return_errno!(ENOTTY, "not tty device"),
+            IoctlCmd::FIONBIO(nonblocking) => {
+                self.set_nonblocking(**nonblocking != 0);
+            }
+            // The size of the next message, which is the same as Linux
+            IoctlCmd::FIONREAD(arg) => {
+                let bytes_to_read = self.bytes_to_read().min(std::i32::MAX as usize) as i32;
+                **arg = bytes_to_read;
+            }
+            _ => return_errno!(EINVAL, "unknown ioctl cmd for unix socket"),
+        }
+        Ok(0)
+    }
+
+    fn access_mode(&self) -> Result<AccessMode> {
+        Ok(AccessMode::O_RDWR)
+    }
+
+    fn status_flags(&self) -> Result<StatusFlags> {
+        if self.nonblocking() {
+            Ok(StatusFlags::O_NONBLOCK)
+        } else {
+            Ok(StatusFlags::empty())
+        }
+    }
+
+    fn set_status_flags(&self, new_status_flags: StatusFlags) -> Result<()> {
+        // Only O_NONBLOCK is supported
+        let nonblocking = new_status_flags.contains(StatusFlags::O_NONBLOCK);
+        self.set_nonblocking(nonblocking);
+        Ok(())
+    }
+
+    fn poll_new(&self) -> IoEvents {
+        self.poll()
+    }
+
+    fn notifier(&self) -> Option<&IoNotifier> {
+        Some(self.endpoint().notifier())
+    }
+
+    fn as_any(&self) -> &dyn Any {
+        self
+    }
+
+    fn metadata(&self) -> Result<Metadata> {
+        Ok(Metadata {
+            dev: 0,
+            inode: 0,
+            size: 0,
+            blk_size: 0,
+            blocks: 0,
+            atime: Timespec { sec: 0, nsec: 0 },
+            mtime: Timespec { sec: 0, nsec: 0 },
+            ctime: Timespec { sec: 0, nsec: 0 },
+            type_: FileType::Socket,
+            mode: 0o666,
+            nlinks: 1,
+            uid: 0,
+            gid: 0,
+            rdev: 0,
+        })
+    }
+}
@@ -0,0 +1,227 @@
+use super::endpoint::Endpoint;
+use super::*;
+use fs::{FileDesc, FileRef};
+use std::mem;
+use std::ptr;
+use std::sync::atomic::Ordering;
+
+/// The maximum number of file descriptors that can be passed in one message, which is the
+/// same as SCM_MAX_FD of Linux.
+const MAX_NR_PASSED_FILES: usize = 253;
+
+const CMSG_HDR_LEN: usize = mem::size_of::<libc::cmsghdr>();
+
+/// A message of a datagram or seqpacket unix socket.
+///
+/// The payload is copied from the user buffers into a refcounted buffer once when it is sent.
+/// After that, the message moves between the sender and the receiver, or is shared by a peeking
+/// receiver, without copying the payload again.
+#[derive(Clone)]
+pub struct Message {
+    data: Arc<[u8]>,
+    addr: Option<Addr>,
+    files: Vec<FileRef>,
+}
+
+impl Message {
+    pub fn new(bufs: &[&[u8]], addr: Option<Addr>, files: Vec<FileRef>) -> Self {
+        let len = bufs.iter().map(|buf| buf.len()).sum();
+        let mut data = Arc::<[u8]>::new_uninit_slice(len);
+        let dst = Arc::get_mut(&mut data).unwrap();
+        let mut offset = 0;
+        for buf in bufs {
+            unsafe {
+                ptr::copy_nonoverlapping(
+                    buf.as_ptr(),
+                    dst[offset..].as_mut_ptr() as *mut u8,
+                    buf.len(),
+                );
+            }
+            offset += buf.len();
+        }
+        // Safety. All the bytes have been initialized above.
+        let data = unsafe { data.assume_init() };
+
+        Self { data, addr, files }
+    }
+
+    pub fn len(&self) -> usize {
+        self.data.len()
+    }
+
+    /// The address of the sender, if it is bound.
+    pub fn addr(&self) -> &Option<Addr> {
+        &self.addr
+    }
+
+    pub fn files(&self) -> &[FileRef] {
+        &self.files
+    }
+
+    /// Copy the payload to the buffers, returning the number of bytes copied. The remaining
+    /// bytes of a message that is larger than the buffers are discarded.
+    pub fn copy_to_slices(&self, bufs: &mut [&mut [u8]]) -> usize {
+        let mut copied = 0;
+        for buf in bufs.iter_mut() {
+            let len = buf.len().min(self.data.len() - copied);
+            buf[..len].copy_from_slice(&self.data[copied..copied + len]);
+            copied += len;
+            if copied == self.data.len() {
+                break;
+            }
+        }
+        copied
+    }
+}
+
+impl Debug for Message {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        f.debug_struct("Message")
+            .field("len", &self.data.len())
+            .field("addr", &self.addr)
+            .field("nr_files", &self.files.len())
+            .finish()
+    }
+}
+
+/// A message queued in the receiving endpoint. It holds a charge of the sending endpoint
+/// until it is received or discarded.
+pub struct QueuedMessage {
+    pub msg: Message,
+    _charge: Charge,
+}
+
+impl QueuedMessage {
+    pub fn new(msg: Message, charge: Charge) -> Self {
+        Self {
+            msg,
+            _charge: charge,
+        }
+    }
+}
+
+/// The bytes of a message in flight that are charged to the send buffer of its sender.
+/// The bytes are released, and the blocked senders are woken, when the charge is dropped.
+pub struct Charge {
+    sender: Endpoint,
+    len: usize,
+}
+
+impl Charge {
+    /// Charge `len` bytes to the sender if there is enough space in its send buffer. A message
+    /// is always allowed if nothing is charged, so that a message as large as the buffer can
+    /// be sent.
+    pub fn try_new(sender: &Endpoint, len: usize) -> Option<Self> {
+        let mut used = sender.sent_bytes.load(Ordering::Relaxed);
+        loop {
+            if used != 0 && used + len > sender.sndbuf_size() {
+                return None;
+            }
+            match sender.sent_bytes.compare_exchange_weak(
+                used,
+                used + len,
+                Ordering::AcqRel,
+                Ordering::Relaxed,
+            ) {
+                Ok(_) => {
+                    return Some(Self {
+                        sender: sender.clone(),
+                        len,
+                    })
+                }
+                Err(new_used) => used = new_used,
+            }
+        }
+    }
+}
+
+impl Drop for Charge {
+    fn drop(&mut self) {
+        self.sender.sent_bytes.fetch_sub(self.len, Ordering::AcqRel);
+        self.sender.wake_writers();
+    }
+}
+
+/// Get the files passed by SCM_RIGHTS control messages. Other types of control messages are
+/// ignored.
+pub fn files_from_control(control: &[u8]) -> Result<Vec<FileRef>> {
+    let mut files = Vec::new();
+    let mut offset = 0;
+    while offset + CMSG_HDR_LEN <= control.len() {
+        // The control buffer is provided by the user and may be unaligned
+        let cmsg_hdr =
+            unsafe { (control[offset..].as_ptr() as *const libc::cmsghdr).read_unaligned() };
+        let cmsg_len = cmsg_hdr.cmsg_len as usize;
+        if cmsg_len < CMSG_HDR_LEN || cmsg_len > control.len() - offset {
+            return_errno!(EINVAL, "invalid control message length");
+        }
+
+        if cmsg_hdr.cmsg_level == libc::SOL_SOCKET && cmsg_hdr.cmsg_type == libc::SCM_RIGHTS {
+            let fds = &control[offset + CMSG_HDR_LEN..offset + cmsg_len];
+            if files.len() + fds.len() / mem::size_of::<i32>() > MAX_NR_PASSED_FILES {
+                return_errno!(EINVAL, "too many files to pass");
+            }
+
+            let current = current!();
+            for fd in fds.chunks_exact(mem::size_of::<i32>()) {
+                let fd = i32::from_ne_bytes([fd[0], fd[1], fd[2], fd[3]]);
+                files.push(current.file(fd as FileDesc)?);
+            }
+        } else {
+            warn!(
+                "unsupported control message: level = {}, type = {}",
+                cmsg_hdr.cmsg_level, cmsg_hdr.cmsg_type
+            );
+        }
+
+        offset += cmsg_align(cmsg_len);
+    }
+    Ok(files)
+}
+
+/// Install the passed files in the current process and put their file descriptors in an
+/// SCM_RIGHTS control message. The files that do not fit in the control buffer are discarded.
+///
+/// Return the length of the control message and whether it is truncated.
+pub fn files_to_control(
+    files: &[FileRef],
+    control: &mut [u8],
+    close_on_spawn: bool,
+) -> (usize, bool) {
+    if files.is_empty() {
+        return (0, false);
+    }
+    if control.len() < CMSG_HDR_LEN {
+        return (0, true);
+    }
+
+    let nr_fds = files
+        .len()
+        .min((control.len() - CMSG_HDR_LEN) / mem::size_of::<i32>());
+    let cmsg_len = CMSG_HDR_LEN + nr_fds * mem::size_of::<i32>();
+    let cmsg_hdr = libc::cmsghdr {
+        cmsg_len: cmsg_len as _,
+        cmsg_level: libc::SOL_SOCKET,
+        cmsg_type: libc::SCM_RIGHTS,
+    };
+    unsafe {
+        (control.as_mut_ptr() as *mut libc::cmsghdr).write_unaligned(cmsg_hdr);
+    }
+
+    let current = current!();
+    let fds = &mut control[CMSG_HDR_LEN..cmsg_len];
+    for (file, fd_bytes) in files
+        .iter()
+        .zip(fds.chunks_exact_mut(mem::size_of::<i32>()))
+    {
+        let fd = current.add_file(file.clone(), close_on_spawn) as i32;
+        fd_bytes.copy_from_slice(&fd.to_ne_bytes());
+    }
+
+    (cmsg_len, nr_fds < files.len())
+}
+
+fn cmsg_align(len: usize) -> usize {
+    let align = mem::size_of::<usize>();
+    (len + align - 1) & !(align - 1)
+}
@@ -0,0 +1,9 @@
+use super::*;
+
+mod address_space;
+mod endpoint;
+mod file;
+mod message;
+mod socket;
+
+pub use self::socket::Datagram;
@@ -0,0 +1,282 @@
+use super::address_space::DGRAM_ADDRESS_SPACE;
+use super::endpoint::{Endpoint, Inner};
+use super::message::{files_from_control, files_to_control, Message};
+use super::*;
+use fs::{FileRef, IoEvents};
+use net::socket::{MsgHdr, MsgHdrMut};
+use std::fmt;
+
+/// SOCK_DGRAM and SOCK_SEQPACKET Unix socket.
+///
+/// Both types of sockets preserve message boundaries and share one implementation. A datagram
+/// socket can send messages to any bound datagram socket, or to the one it is connected to. A
+/// seqpacket socket is connection-oriented like a stream socket: it has to be connected to a
+/// listening socket, and the connection can be obtained through the listening socket calling
+/// accept.
+pub struct Datagram {
+    endpoint: Endpoint,
+}
+
+impl Datagram {
+    pub fn new(socket_type: SocketType, flags: FileFlags) -> Self {
+        let nonblocking = flags.contains(FileFlags::SOCK_NONBLOCK);
+        Self {
+            endpoint: Inner::new(socket_type, nonblocking),
+        }
+    }
+
+    pub fn socketpair(socket_type: SocketType, flags: FileFlags) -> Result<(Self, Self)> {
+        let nonblocking = flags.contains(FileFlags::SOCK_NONBLOCK);
+        let (end_a, end_b) = Inner::new_pair(socket_type, nonblocking);
+        Ok((Self { endpoint: end_a }, Self { endpoint: end_b }))
+    }
+
+    pub fn socket_type(&self) -> SocketType {
+        self.endpoint.socket_type()
+    }
+
+    pub fn addr(&self) -> Option<Addr> {
+        self.endpoint.addr()
+    }
+
+    pub fn peer_addr(&self) -> Result<Addr> {
+        self.endpoint.peer()?;
+        self.endpoint
+            .peer_addr()
+            .ok_or_else(|| errno!(ENOTCONN, "the peer is not bound"))
+    }
+
+    pub fn bind(&self, addr: &mut Addr) -> Result<()> {
+        if self.endpoint.addr().is_some() {
+            return_errno!(EINVAL, "the socket is already bound");
+        }
+
+        // create the corresponding file in the fs and fill Addr with its inode
+        addr.create_socket_file()?;
+
+        DGRAM_ADDRESS_SPACE.add_binder(addr, &self.endpoint)?;
+        self.endpoint.set_addr(addr);
+        Ok(())
+    }
+
+    pub fn listen(&self, backlog: i32) -> Result<()> {
+        if self.socket_type() != SocketType::SEQPACKET {
+            return_errno!(EOPNOTSUPP, "the socket is not connection-oriented");
+        }
+        //TODO: restrict backlog accroding to /proc/sys/net/core/somaxconn
+        if backlog < 0 {
+            return_errno!(EINVAL, "negative backlog is not supported");
+        }
+        if self.endpoint.addr().is_none() {
+            return_errno!(EINVAL, "the socket is not bound");
+        }
+
+        self.endpoint.listen(backlog as usize)
+    }
+
+    /// The establishment of the connection is very fast and can be done immediately.
+    /// Therefore, the connect function in our implementation will never block.
+    pub fn connect(&self, addr: &Addr) -> Result<()> {
+        debug!("connect to {:?}", addr);
+
+        let target = DGRAM_ADDRESS_SPACE.lookup(addr, self.socket_type())?;
+        match self.socket_type() {
+            SocketType::SEQPACKET => {
+                if self.endpoint.is_listening() {
+                    return_errno!(EINVAL, "invalid socket for connect");
+                }
+                if self.endpoint.is_connected() {
+                    return_errno!(EISCONN, "already connected");
+                }
+                target.push_incoming(&self.endpoint)
+            }
+            _ => {
+                self.endpoint.set_peer(&target);
+                Ok(())
+            }
+        }
+    }
+
+    pub fn accept(&self, flags: FileFlags) -> Result<(Self, Option<Addr>)> {
+        if self.socket_type() != SocketType::SEQPACKET {
+            return_errno!(EOPNOTSUPP, "the socket is not connection-oriented");
+        }
+
+        let endpoint = self.endpoint.pop_incoming(self.endpoint.nonblocking())?;
+        endpoint.set_nonblocking(flags.contains(FileFlags::SOCK_NONBLOCK));
+        let peer_addr = endpoint.peer_addr();
+
+        debug!("accept socket from {:?}", peer_addr);
+
+        Ok((Self { endpoint }, peer_addr))
+    }
+
+    pub fn sendto(&self, buf: &[u8], flags: SendFlags, addr: &Option<Addr>) -> Result<usize> {
+        self.send(&[buf], Vec::new(), flags, addr.as_ref())
+    }
+
+    pub fn recvfrom(&self, buf: &mut [u8], flags: RecvFlags) -> Result<(usize, Option<Addr>)> {
+        let msg = match self.recv(flags)? {
+            Some(msg) => msg,
+            None => return Ok((0, None)),
+        };
+
+        let copied = msg.copy_to_slices(&mut [buf]);
+        let data_len = if flags.contains(RecvFlags::MSG_TRUNC) {
+            msg.len()
+        } else {
+            copied
+        };
+        Ok((data_len, msg.addr().clone()))
+    }
+
+    pub fn sendmsg(&self, msg_hdr: &MsgHdr, flags: SendFlags) -> Result<usize> {
+        let addr = match msg_hdr.get_name() {
+            Some(name) if !name.is_empty() => {
+                Some(unsafe { Addr::try_from_raw(name.as_ptr() as *const _, name.len() as _)? })
+            }
+            _ => None,
+        };
+        let files = match msg_hdr.get_control() {
+            Some(control) => files_from_control(control)?,
+            None => Vec::new(),
+        };
+
+        let bufs = msg_hdr.get_iovs().as_slices();
+        self.send(bufs, files, flags, addr.as_ref())
+    }
+
+    pub fn recvmsg(&self, msg_hdr: &mut MsgHdrMut, flags: RecvFlags) -> Result<usize> {
+        let msg = match self.recv(flags)? {
+            Some(msg) => msg,
+            None => {
+                msg_hdr.set_name_len(0)?;
+                msg_hdr.set_control_len(0)?;
+                return Ok(0);
+            }
+        };
+
+        let close_on_spawn = flags.contains(RecvFlags::MSG_CMSG_CLOEXEC);
+        let (copied, name_len, control_len, control_truncated) = {
+            let (iovs, name, control) = msg_hdr.get_iovs_name_and_control_mut();
+            let copied = msg.copy_to_slices(iovs.as_slices_mut());
+            let name_len = match (name, msg.addr()) {
+                (Some(name), Some(addr)) => addr.copy_to_slice(name),
+                _ => 0,
+            };
+            let (control_len, control_truncated) = match control {
+                Some(control) => files_to_control(msg.files(), control, close_on_spawn),
+                None => (0, !msg.files().is_empty()),
+            };
+            (copied, name_len, control_len, control_truncated)
+        };
+        msg_hdr.set_name_len(name_len)?;
+        msg_hdr.set_control_len(control_len)?;
+
+        let mut msg_flags = MsgHdrFlags::empty();
+        if copied < msg.len() {
+            msg_flags |= MsgHdrFlags::MSG_TRUNC;
+        }
+        if control_truncated {
+            msg_flags |= MsgHdrFlags::MSG_CTRUNC;
+        }
+        msg_hdr.set_flags(msg_flags);
+
+        if flags.contains(RecvFlags::MSG_TRUNC) {
+            Ok(msg.len())
+        } else {
+            Ok(copied)
+        }
+    }
+
+    pub(super) fn send(
+        &self,
+        bufs: &[&[u8]],
+        files: Vec<FileRef>,
+        flags: SendFlags,
+        addr: Option<&Addr>,
+    ) -> Result<usize> {
+        if flags.contains(SendFlags::MSG_OOB) {
+            return_errno!(EOPNOTSUPP, "out-of-band data is not supported");
+        }
+
+        let receiver = match (self.socket_type(), addr) {
+            // The address is ignored for a connection-oriented socket
+            (SocketType::DGRAM, Some(addr)) => {
+                DGRAM_ADDRESS_SPACE.lookup(addr, SocketType::DGRAM)?
+            }
+            _ => self.endpoint.peer()?,
+        };
+
+        let msg = Message::new(bufs, self.endpoint.addr(), files);
+        let nonblocking = self.nonblocking() || flags.contains(SendFlags::MSG_DONTWAIT);
+        self.endpoint
+            .send_to(&receiver, msg, nonblocking)
+            .map_err(|e| {
+                if e.errno() == EPIPE && !flags.contains(SendFlags::MSG_NOSIGNAL) {
+                    crate::signal::do_tkill(
+                        current!().tid(),
+                        crate::signal::SIGPIPE.as_u8() as i32,
+                    );
+                }
+                e
+            })
+    }
+
+    pub(super) fn recv(&self, flags: RecvFlags) -> Result<Option<Message>> {
+        if flags.contains(RecvFlags::MSG_OOB) {
+            return_errno!(EOPNOTSUPP, "out-of-band data is not supported");
+        }
+        if self.socket_type() == SocketType::SEQPACKET && !self.endpoint.is_connected() {
+            return_errno!(ENOTCONN, "the socket is not connected");
+        }
+        if flags.contains(RecvFlags::MSG_WAITALL) {
+            warn!("MSG_WAITALL is ignored for messages");
+        }
+
+        let nonblocking = self.nonblocking() || flags.contains(RecvFlags::MSG_DONTWAIT);
+        self.endpoint
+            .recv(nonblocking, flags.contains(RecvFlags::MSG_PEEK))
+    }
+
+    /// perform shutdown on the socket.
+    pub fn shutdown(&self, how: HowToShut) -> Result<()> {
+        self.endpoint.shutdown(how)
+    }
+
+    pub(super) fn bytes_to_read(&self) -> usize {
+        self.endpoint.bytes_to_read()
+    }
+
+    pub(super) fn poll(&self) -> IoEvents {
+        self.endpoint.poll()
+    }
+
+    pub(super) fn endpoint(&self) -> &Endpoint {
+        &self.endpoint
+    }
+
+    pub(super) fn nonblocking(&self) -> bool {
+        self.endpoint.nonblocking()
+    }
+
+    pub(super) fn set_nonblocking(&self, nonblocking: bool) {
+        self.endpoint.set_nonblocking(nonblocking)
+    }
+}
+
+impl Debug for Datagram {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_struct("Datagram")
+            .field("socket_type", &self.socket_type())
+            .field("addr", &self.addr())
+            .field("nonblocking", &self.nonblocking())
+            .finish()
+    }
+}
+
+impl Drop for Datagram {
+    fn drop(&mut self) {
+        self.endpoint.close();
+    }
+}
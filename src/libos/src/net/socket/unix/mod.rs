@@ -1,22 +1,27 @@
 use self::addr::Addr;
+use self::stream::{AddressSpaceKey, DEFAULT_BUF_SIZE};
 use super::*;
 
 mod addr;
+mod datagram;
 mod stream;
 
 pub use self::addr::Addr as UnixAddr;
+pub use self::datagram::Datagram;
 pub use self::stream::Stream;
+pub(crate) use self::stream::{end_pair, Endpoint, RelayNotifier};
 
-//TODO: rewrite this file when a new kind of uds is added
-pub fn unix_socket(socket_type: SocketType, flags: FileFlags, protocol: i32) -> Result<Stream> {
+pub fn unix_socket(socket_type: SocketType, flags: FileFlags, protocol: i32) -> Result<FileRef> {
     if protocol != 0 && protocol != AddressFamily::LOCAL as i32 {
         return_errno!(EPROTONOSUPPORT, "protocol is not supported");
     }
 
-    if socket_type == SocketType::STREAM {
-        Ok(Stream::new(flags))
-    } else {
-        return_errno!(ESOCKTNOSUPPORT, "only stream type is supported");
+    match socket_type {
+        SocketType::STREAM => Ok(Arc::new(Stream::new(flags))),
+        SocketType::DGRAM | SocketType::SEQPACKET => {
+            Ok(Arc::new(Datagram::new(socket_type, flags)))
+        }
+        _ => return_errno!(ESOCKTNOSUPPORT, "the socket type is not supported"),
     }
 }
 
@@ -24,15 +29,21 @@ pub fn socketpair(
     socket_type: SocketType,
     flags: FileFlags,
     protocol: i32,
-) -> Result<(Stream, Stream)> {
+) -> Result<(FileRef, FileRef)> {
     if protocol != 0 && protocol != AddressFamily::LOCAL as i32 {
         return_errno!(EPROTONOSUPPORT, "protocol is not supported");
     }
 
-    if socket_type == SocketType::STREAM {
-        Stream::socketpair(flags)
-    } else {
-        return_errno!(ESOCKTNOSUPPORT, "only stream type is supported");
+    match socket_type {
+        SocketType::STREAM => {
+            let (socket_a, socket_b) = Stream::socketpair(flags)?;
+            Ok((Arc::new(socket_a), Arc::new(socket_b)))
+        }
+        SocketType::DGRAM | SocketType::SEQPACKET => {
+            let (socket_a, socket_b) = Datagram::socketpair(socket_type, flags)?;
+            Ok((Arc::new(socket_a), Arc::new(socket_b)))
+        }
+        _ => return_errno!(ESOCKTNOSUPPORT, "the socket type is not supported"),
     }
 }
 
@@ -47,3 +58,15 @@ impl AsUnixSocket for FileRef {
             .ok_or_else(|| errno!(EBADF, "not a unix socket"))
     }
 }
+
+pub trait AsUnixDatagram {
+    fn as_unix_datagram(&self) -> Result<&Datagram>;
+}
+
+impl AsUnixDatagram for FileRef {
+    fn as_unix_datagram(&self) -> Result<&Datagram> {
+        self.as_any()
+            .downcast_ref::<Datagram>()
+            .ok_or_else(|| errno!(EBADF, "not a unix datagram socket"))
+    }
+}
@@ -22,6 +22,30 @@ impl AddressSpaceKey {
     pub fn from_path(path: String) -> Self {
         AddressSpaceKey::AbstrKey(path)
     }
+
+    /// Get the key of an address. For a pathname address, the socket file must exist.
+    pub fn from_addr(addr: &Addr) -> Option<Self> {
+        trace!("addr = {:?}", addr);
+        match addr {
+            Addr::File(inode_num, unix_path) if inode_num.is_some() => {
+                Some(Self::from_inode(inode_num.unwrap()))
+            }
+            Addr::File(_, unix_path) => {
+                let inode = {
+                    let file_path = unix_path.absolute();
+                    let current = current!();
+                    let fs = current.fs().read().unwrap();
+                    fs.lookup_inode(&file_path)
+                };
+                if let Ok(inode) = inode {
+                    Some(Self::from_inode(inode.metadata().unwrap().inode))
+                } else {
+                    None
+                }
+            }
+            Addr::Abstract(path) => Some(Self::from_path(addr.path_str().to_string())),
+        }
+    }
 }
 
 pub struct AddressSpace {
@@ -135,25 +159,6 @@ impl AddressSpace {
     }
 
     fn get_key(addr: &Addr) -> Option<AddressSpaceKey> {
-        trace!("addr = {:?}", addr);
-        match addr {
-            Addr::File(inode_num, unix_path) if inode_num.is_some() => {
-                Some(AddressSpaceKey::from_inode(inode_num.unwrap()))
-            }
-            Addr::File(_, unix_path) => {
-                let inode = {
-                    let file_path = unix_path.absolute();
-                    let current = current!();
-                    let fs = current.fs().read().unwrap();
-                    fs.lookup_inode(&file_path)
-                };
-                if let Ok(inode) = inode {
-                    Some(AddressSpaceKey::from_inode(inode.metadata().unwrap().inode))
-                } else {
-                    None
-                }
-            }
-            Addr::Abstract(path) => Some(AddressSpaceKey::from_path(addr.path_str().to_string())),
-        }
+        AddressSpaceKey::from_addr(addr)
     }
 }
@@ -83,6 +83,21 @@ impl Inner {
         self.writer.push_slices(bufs)
     }
 
+    pub fn readv_nonblocking(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        self.reader.try_pop_slices(bufs)
+    }
+
+    pub fn writev_nonblocking(&self, bufs: &[&[u8]]) -> Result<usize> {
+        self.writer.try_push_slices(bufs)
+    }
+
+    /// Peek the data to read without blocking.
+    ///
+    /// Safety. The caller must make sure that the endpoint is not read concurrently.
+    pub unsafe fn peekv_nonblocking(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        self.reader.peek_slices(bufs)
+    }
+
     pub fn bytes_to_read(&self) -> usize {
         self.reader.items_to_consume()
     }
@@ -144,14 +159,19 @@ pub const DEFAULT_BUF_SIZE: usize = 208 * 1024;
 
 /// An observer used to observe both reader and writer of the endpoint. It also contains a
 /// notifier that relays the notification of the endpoint.
-pub(super) struct RelayNotifier {
-    notifier: IoNotifier,
+pub(crate) struct RelayNotifier {
+    notifier: Arc<IoNotifier>,
     endpoint: SgxMutex<Option<Endpoint>>,
 }
 
 impl RelayNotifier {
     pub fn new() -> Self {
-        let notifier = IoNotifier::new();
+        Self::with_notifier(Arc::new(IoNotifier::new()))
+    }
+
+    /// Relay the notification of the endpoint to an existing notifier, e.g., the notifier of a
+    /// socket that is connected in-enclave after being created.
+    pub fn with_notifier(notifier: Arc<IoNotifier>) -> Self {
         let endpoint = SgxMutex::new(None);
         Self { notifier, endpoint }
     }
@@ -55,6 +55,22 @@ impl File for Stream {
         }
     }
 
+    fn readv_nonblocking(&self, bufs: &mut [&mut [u8]]) -> Result<usize> {
+        let status = (*self.inner()).clone();
+        match status {
+            Status::Connected(endpoint) => endpoint.readv_nonblocking(bufs),
+            _ => return_errno!(ENOTCONN, "unconnected socket"),
+        }
+    }
+
+    fn writev_nonblocking(&self, bufs: &[&[u8]]) -> Result<usize> {
+        let status = (*self.inner()).clone();
+        match status {
+            Status::Connected(endpoint) => endpoint.writev_nonblocking(bufs),
+            _ => return_errno!(ENOTCONN, "unconnected socket"),
+        }
+    }
+
     fn ioctl(&self, cmd: &mut IoctlCmd) -> Result<i32> {
         match cmd {
             IoctlCmd::TCGETS(_) => return_errno!(ENOTTY, "not tty device"),
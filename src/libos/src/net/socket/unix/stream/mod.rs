@@ -5,4 +5,7 @@ mod endpoint;
 mod file;
 mod stream;
 
+pub(super) use self::address_space::AddressSpaceKey;
+pub(super) use self::endpoint::DEFAULT_BUF_SIZE;
+pub(crate) use self::endpoint::{end_pair, Endpoint, RelayNotifier};
 pub use stream::Stream;
@@ -4,7 +4,6 @@ use super::*;
 use events::{Event, EventFilter, Notifier, Observer};
 use fs::channel::Channel;
 use fs::IoEvents;
-use fs::{CreationFlags, FileMode};
 use net::socket::{Iovs, MsgHdr, MsgHdrMut};
 use std::fmt;
 use std::sync::atomic::{AtomicBool, Ordering};
@@ -71,20 +70,8 @@ impl Stream {
     }
 
     pub fn bind(&self, addr: &mut Addr) -> Result<()> {
-        if let Addr::File(inode_num, path) = addr {
-            // create the corresponding file in the fs and fill Addr with its inode
-            let corresponding_inode_num = {
-                let current = current!();
-                let fs = current.fs().read().unwrap();
-                let file_ref = fs.open_file(
-                    path.path_str(),
-                    CreationFlags::O_CREAT.bits(),
-                    FileMode::from_bits(0o777).unwrap(),
-                )?;
-                file_ref.metadata()?.inode
-            };
-            *inode_num = Some(corresponding_inode_num);
-        }
+        // create the corresponding file in the fs and fill Addr with its inode
+        addr.create_socket_file()?;
 
         match &mut *self.inner() {
             Status::Idle(ref mut info) => {
@@ -225,7 +212,7 @@ impl Stream {
     }
 
     pub fn sendmsg(&self, msg_hdr: &MsgHdr, flags: SendFlags) -> Result<usize> {
-        if !flags.is_empty() {
+        if !(flags - SendFlags::MSG_DONTWAIT).is_empty() {
             warn!("unsupported flags: {:?}", flags);
         }
         if msg_hdr.get_control().is_some() {
@@ -233,16 +220,23 @@ impl Stream {
         }
 
         let bufs = msg_hdr.get_iovs().as_slices();
-        self.writev(bufs)
+        if flags.contains(SendFlags::MSG_DONTWAIT) {
+            self.writev_nonblocking(bufs)
+        } else {
+            self.writev(bufs)
+        }
     }
 
     pub fn recvmsg(&self, msg_hdr: &mut MsgHdrMut, flags: RecvFlags) -> Result<usize> {
-        if !flags.is_empty() {
+        if !(flags - RecvFlags::MSG_DONTWAIT).is_empty() {
             warn!("unsupported flags: {:?}", flags);
         }
-
         let bufs = msg_hdr.get_iovs_mut().as_slices_mut();
-        let data_len = self.readv(bufs)?;
+        let data_len = if flags.contains(RecvFlags::MSG_DONTWAIT) {
+            self.readv_nonblocking(bufs)?
+        } else {
+            self.readv(bufs)?
+        };
 
         // For stream socket, the msg_name is ignored. And other fields are not supported.
         msg_hdr.set_name_len(0);
@@ -18,10 +18,7 @@ pub fn do_socket(domain: c_int, socket_type: c_int, protocol: c_int) -> Result<i
     let sock_type = SocketType::try_from(socket_type & (!file_flags.bits()))?;
 
     let file_ref: Arc<dyn File> = match sock_domain {
-        AddressFamily::LOCAL => {
-            let unix_socket = unix_socket(sock_type, file_flags, protocol)?;
-            Arc::new(unix_socket)
-        }
+        AddressFamily::LOCAL => unix_socket(sock_type, file_flags, protocol)?,
         _ => {
             let socket = HostSocket::new(sock_domain, sock_type, file_flags, protocol)?;
             Arc::new(socket)
@@ -48,6 +45,10 @@ pub fn do_bind(fd: c_int, addr: *const libc::sockaddr, addr_len: libc::socklen_t
         let mut unix_addr = unsafe { UnixAddr::try_from_raw(addr, addr_len)? };
         trace!("bind to addr: {:?}", unix_addr);
         unix_socket.bind(&mut unix_addr)?;
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        let mut unix_addr = unsafe { UnixAddr::try_from_raw(addr, addr_len)? };
+        trace!("bind to addr: {:?}", unix_addr);
+        unix_socket.bind(&mut unix_addr)?;
     } else {
         return_errno!(ENOTSOCK, "not a socket");
     }
@@ -61,6 +62,8 @@ pub fn do_listen(fd: c_int, backlog: c_int) -> Result<isize> {
         socket.listen(backlog)?;
     } else if let Ok(unix_socket) = file_ref.as_unix_socket() {
         unix_socket.listen(backlog)?;
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        unix_socket.listen(backlog)?;
     } else {
         return_errno!(ENOTSOCK, "not a socket");
     }
@@ -98,6 +101,15 @@ pub fn do_connect(
             return_errno!(EINVAL, "invalid address");
         };
 
+        unix_socket.connect(&addr)?;
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        // TODO: support AF_UNSPEC address for datagram socket use
+        let addr = if addr_set {
+            unsafe { UnixAddr::try_from_raw(addr, addr_len)? }
+        } else {
+            return_errno!(EINVAL, "invalid address");
+        };
+
         unix_socket.connect(&addr)?;
     } else {
         return_errno!(ENOTSOCK, "not a socket");
@@ -119,6 +131,27 @@ pub fn do_accept4(
     addr: *mut libc::sockaddr,
     addr_len: *mut libc::socklen_t,
     flags: c_int,
+) -> Result<isize> {
+    accept4(fd, addr, addr_len, flags, false)
+}
+
+/// Accept a connection without blocking, even if the socket is blocking. This is
+/// used by io_uring, whose requests must not block the ring.
+pub fn do_accept4_nowait(
+    fd: c_int,
+    addr: *mut libc::sockaddr,
+    addr_len: *mut libc::socklen_t,
+    flags: c_int,
+) -> Result<isize> {
+    accept4(fd, addr, addr_len, flags, true)
+}
+
+fn accept4(
+    fd: c_int,
+    addr: *mut libc::sockaddr,
+    addr_len: *mut libc::socklen_t,
+    flags: c_int,
+    nowait: bool,
 ) -> Result<isize> {
     let addr_set: bool = !addr.is_null();
     if addr_set {
@@ -131,7 +164,11 @@ pub fn do_accept4(
 
     let file_ref = current!().file(fd as FileDesc)?;
     if let Ok(socket) = file_ref.as_host_socket() {
-        let (new_socket_file, sock_addr_option) = socket.accept(file_flags)?;
+        let (new_socket_file, sock_addr_option) = if nowait {
+            socket.accept_nowait(file_flags)?
+        } else {
+            socket.accept(file_flags)?
+        };
         let new_file_ref: Arc<dyn File> = Arc::new(new_socket_file);
         let new_fd = current!().add_file(new_file_ref, close_on_spawn);
 
@@ -155,6 +192,26 @@ pub fn do_accept4(
         let new_file_ref: Arc<dyn File> = Arc::new(new_socket_file);
         let new_fd = current!().add_file(new_file_ref, close_on_spawn);
 
+        if addr_set {
+            if let Some(sock_addr) = sock_addr_option {
+                let mut buf =
+                    unsafe { std::slice::from_raw_parts_mut(addr as *mut u8, *addr_len as usize) };
+                sock_addr.copy_to_slice(&mut buf);
+                unsafe {
+                    *addr_len = sock_addr.raw_len() as u32;
+                }
+            } else {
+                unsafe {
+                    *addr_len = 0;
+                }
+            }
+        }
+        Ok(new_fd as isize)
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        let (new_socket_file, sock_addr_option) = unix_socket.accept(file_flags)?;
+        let new_file_ref: Arc<dyn File> = Arc::new(new_socket_file);
+        let new_fd = current!().add_file(new_file_ref, close_on_spawn);
+
         if addr_set {
             if let Some(sock_addr) = sock_addr_option {
                 let mut buf =
@@ -184,6 +241,8 @@ pub fn do_shutdown(fd: c_int, how: c_int) -> Result<isize> {
         socket.shutdown(how)?;
     } else if let Ok(unix_socket) = file_ref.as_unix_socket() {
         unix_socket.shutdown(how)?;
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        unix_socket.shutdown(how)?;
     } else {
         return_errno!(EBADF, "not a host socket")
     }
@@ -205,14 +264,14 @@ pub fn do_setsockopt(
     let file_ref = current!().file(fd as FileDesc)?;
     if let Ok(socket) = file_ref.as_host_socket() {
         let ret = try_libc!(libc::ocall::setsockopt(
-            socket.raw_host_fd() as i32,
+            socket.raw_host_fd()? as i32,
             level,
             optname,
             optval,
             optlen
         ));
         Ok(ret as isize)
-    } else if let Ok(unix_socket) = file_ref.as_unix_socket() {
+    } else if file_ref.as_unix_socket().is_ok() || file_ref.as_unix_datagram().is_ok() {
         warn!("setsockopt for unix socket is unimplemented");
         Ok(0)
     } else {
@@ -236,14 +295,14 @@ pub fn do_getsockopt(
 
     if let Ok(socket) = socket {
         let ret = try_libc!(libc::ocall::getsockopt(
-            socket.raw_host_fd() as i32,
+            socket.raw_host_fd()? as i32,
             level,
             optname,
             optval,
             optlen
         ));
         Ok(ret as isize)
-    } else if let Ok(unix_socket) = file_ref.as_unix_socket() {
+    } else if file_ref.as_unix_socket().is_ok() || file_ref.as_unix_datagram().is_ok() {
         warn!("getsockopt for unix socket is unimplemented");
         Ok(0)
     } else {
@@ -266,14 +325,27 @@ pub fn do_getpeername(
 
     let file_ref = current!().file(fd as FileDesc)?;
     if let Ok(socket) = file_ref.as_host_socket() {
+        if let Some(name) = socket.loopback_peer_addr() {
+            let dst =
+                unsafe { std::slice::from_raw_parts_mut(addr as *mut u8, *addr_len as usize) };
+            name.copy_to_slice(dst);
+            unsafe {
+                *addr_len = name.len() as u32;
+            }
+            return Ok(0);
+        }
+
         let ret = try_libc!(libc::ocall::getpeername(
-            socket.raw_host_fd() as i32,
+            socket.raw_host_fd()? as i32,
             addr,
             addr_len
         ));
         Ok(ret as isize)
-    } else if let Ok(unix_socket) = file_ref.as_unix_socket() {
-        let name = unix_socket.peer_addr()?;
+    } else if file_ref.as_unix_socket().is_ok() || file_ref.as_unix_datagram().is_ok() {
+        let name = match file_ref.as_unix_socket() {
+            Ok(unix_socket) => unix_socket.peer_addr()?,
+            Err(_) => file_ref.as_unix_datagram()?.peer_addr()?,
+        };
         let mut dst = unsafe {
             std::slice::from_raw_parts_mut(addr as *mut _ as *mut u8, *addr_len as usize)
         };
@@ -306,14 +378,27 @@ pub fn do_getsockname(
 
     let file_ref = current!().file(fd as FileDesc)?;
     if let Ok(socket) = file_ref.as_host_socket() {
+        if let Some(name) = socket.loopback_addr() {
+            let dst =
+                unsafe { std::slice::from_raw_parts_mut(addr as *mut u8, *addr_len as usize) };
+            name.copy_to_slice(dst);
+            unsafe {
+                *addr_len = name.len() as u32;
+            }
+            return Ok(0);
+        }
+
         let ret = try_libc!(libc::ocall::getsockname(
-            socket.raw_host_fd() as i32,
+            socket.raw_host_fd()? as i32,
             addr,
             addr_len
         ));
         Ok(ret as isize)
-    } else if let Ok(unix_socket) = file_ref.as_unix_socket() {
-        let name_opt = unix_socket.addr();
+    } else if file_ref.as_unix_socket().is_ok() || file_ref.as_unix_datagram().is_ok() {
+        let name_opt = match file_ref.as_unix_socket() {
+            Ok(unix_socket) => unix_socket.addr(),
+            Err(_) => file_ref.as_unix_datagram()?.addr(),
+        };
         if let Some(name) = name_opt {
             let mut dst = unsafe {
                 std::slice::from_raw_parts_mut(addr as *mut _ as *mut u8, *addr_len as usize)
@@ -378,6 +463,16 @@ pub fn do_sendto(
             None
         };
 
+        unix_socket
+            .sendto(buf, send_flags, &addr_option)
+            .map(|u| u as isize)
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        let addr_option = if addr_set {
+            Some(unsafe { UnixAddr::try_from_raw(addr, addr_len)? })
+        } else {
+            None
+        };
+
         unix_socket
             .sendto(buf, send_flags, &addr_option)
             .map(|u| u as isize)
@@ -447,6 +542,23 @@ pub fn do_recvfrom(
             }
         }
         Ok(data_len as isize)
+    } else if let Ok(unix_socket) = file_ref.as_unix_datagram() {
+        let (data_len, sock_addr_option) = unix_socket.recvfrom(buf, recv_flags)?;
+        if addr_set {
+            if let Some(sock_addr) = sock_addr_option {
+                let mut buf =
+                    unsafe { std::slice::from_raw_parts_mut(addr as *mut u8, *addr_len as usize) };
+                sock_addr.copy_to_slice(&mut buf);
+                unsafe {
+                    *addr_len = sock_addr.raw_len() as u32;
+                }
+            } else {
+                unsafe {
+                    *addr_len = 0;
+                }
+            }
+        }
+        Ok(data_len as isize)
     } else {
         return_errno!(ENOTSOCK, "not a socket");
     }
@@ -473,8 +585,8 @@ pub fn do_socketpair(
 
         let current = current!();
         let mut files = current.files().lock().unwrap();
-        sock_pair[0] = files.put(Arc::new(client_socket), close_on_spawn);
-        sock_pair[1] = files.put(Arc::new(server_socket), close_on_spawn);
+        sock_pair[0] = files.put(client_socket, close_on_spawn);
+        sock_pair[1] = files.put(server_socket, close_on_spawn);
 
         debug!("socketpair: ({}, {})", sock_pair[0], sock_pair[1]);
         Ok(0)
@@ -500,15 +612,45 @@ pub fn do_sendmsg(fd: c_int, msg_ptr: *const msghdr, flags_c: c_int) -> Result<i
     };
 
     let flags = SendFlags::from_bits_truncate(flags_c);
+    sendmsg_by_fd(fd, &msg_hdr, flags)
+}
 
+/// Send the data in the buffers without blocking, even if the socket is blocking.
+/// This is used by io_uring, whose requests must not block the ring.
+pub fn do_sendv_nowait(fd: c_int, bufs: &[&[u8]]) -> Result<usize> {
+    let c_iovs: Vec<libc::iovec> = bufs
+        .iter()
+        .map(|buf| libc::iovec {
+            iov_base: buf.as_ptr() as *mut c_void,
+            iov_len: buf.len(),
+        })
+        .collect();
+    let msg_hdr_c = msghdr {
+        msg_name: std::ptr::null(),
+        msg_namelen: 0,
+        msg_iov: c_iovs.as_ptr(),
+        msg_iovlen: c_iovs.len(),
+        msg_control: std::ptr::null(),
+        msg_controllen: 0,
+        msg_flags: 0,
+    };
+    let msg_hdr = unsafe { MsgHdr::from_c(&msg_hdr_c)? };
+    sendmsg_by_fd(fd, &msg_hdr, SendFlags::MSG_DONTWAIT).map(|bytes_sent| bytes_sent as usize)
+}
+
+fn sendmsg_by_fd(fd: c_int, msg_hdr: &MsgHdr, flags: SendFlags) -> Result<isize> {
     let file_ref = current!().file(fd as FileDesc)?;
     if let Ok(socket) = file_ref.as_host_socket() {
         socket
-            .sendmsg(&msg_hdr, flags)
+            .sendmsg(msg_hdr, flags)
             .map(|bytes_sent| bytes_sent as isize)
     } else if let Ok(socket) = file_ref.as_unix_socket() {
         socket
-            .sendmsg(&msg_hdr, flags)
+            .sendmsg(msg_hdr, flags)
+            .map(|bytes_sent| bytes_sent as isize)
+    } else if let Ok(socket) = file_ref.as_unix_datagram() {
+        socket
+            .sendmsg(msg_hdr, flags)
             .map(|bytes_sent| bytes_sent as isize)
     } else {
         return_errno!(ENOTSOCK, "not a socket")
@@ -532,21 +674,55 @@ pub fn do_recvmsg(fd: c_int, msg_mut_ptr: *mut msghdr_mut, flags_c: c_int) -> Re
     };
 
     let flags = RecvFlags::from_bits_truncate(flags_c);
+    recvmsg_by_fd(fd, &mut msg_hdr_mut, flags)
+}
+
+/// Receive the data into the buffers without blocking, even if the socket is
+/// blocking. This is used by io_uring, whose requests must not block the ring.
+pub fn do_recvv_nowait(fd: c_int, bufs: &mut [&mut [u8]]) -> Result<usize> {
+    let mut c_iovs: Vec<libc::iovec> = bufs
+        .iter_mut()
+        .map(|buf| libc::iovec {
+            iov_base: buf.as_mut_ptr() as *mut c_void,
+            iov_len: buf.len(),
+        })
+        .collect();
+    let mut msg_hdr_mut_c = msghdr_mut {
+        msg_name: std::ptr::null_mut(),
+        msg_namelen: 0,
+        msg_iov: c_iovs.as_mut_ptr(),
+        msg_iovlen: c_iovs.len(),
+        msg_control: std::ptr::null_mut(),
+        msg_controllen: 0,
+        msg_flags: 0,
+    };
+    let mut msg_hdr_mut = unsafe { MsgHdrMut::from_c(&mut msg_hdr_mut_c)? };
+    recvmsg_by_fd(fd, &mut msg_hdr_mut, RecvFlags::MSG_DONTWAIT)
+        .map(|bytes_recvd| bytes_recvd as usize)
+}
 
+fn recvmsg_by_fd(fd: c_int, msg_hdr_mut: &mut MsgHdrMut, flags: RecvFlags) -> Result<isize> {
     let file_ref = current!().file(fd as FileDesc)?;
     if let Ok(socket) = file_ref.as_host_socket() {
         socket
-            .recvmsg(&mut msg_hdr_mut, flags)
+            .recvmsg(msg_hdr_mut, flags)
             .map(|bytes_recvd| bytes_recvd as isize)
     } else if let Ok(socket) = file_ref.as_unix_socket() {
         socket
-            .recvmsg(&mut msg_hdr_mut, flags)
+            .recvmsg(msg_hdr_mut, flags)
+            .map(|bytes_recvd| bytes_recvd as isize)
+    } else if let Ok(socket) = file_ref.as_unix_datagram() {
+        socket
+            .recvmsg(msg_hdr_mut, flags)
             .map(|bytes_recvd| bytes_recvd as isize)
     } else {
         return_errno!(ENOTSOCK, "not a socket")
     }
 }
 
+/// The maximum number of messages that sendmmsg and recvmmsg handle in one call
+const UIO_MAXIOV: usize = 1024;
+
 pub fn do_sendmmsg(
     fd: c_int,
     msgvec_ptr: *mut mmsghdr,
@@ -558,13 +734,37 @@ pub fn do_sendmmsg(
         fd, msgvec_ptr, flags_c
     );
 
-    from_user::check_ptr(msgvec_ptr)?;
+    let vlen = (vlen as usize).min(UIO_MAXIOV);
+    from_user::check_mut_array(msgvec_ptr, vlen)?;
 
-    let mut msgvec = unsafe { std::slice::from_raw_parts_mut(msgvec_ptr, vlen as usize) };
+    let mut msgvec = unsafe { std::slice::from_raw_parts_mut(msgvec_ptr, vlen) };
     let flags = SendFlags::from_bits_truncate(flags_c);
     let file_ref = current!().file(fd as FileDesc)?;
 
     if let Ok(socket) = file_ref.as_host_socket() {
+        // Send all the valid messages in one batch
+        let bytes_sent = {
+            let mut msgs = Vec::with_capacity(vlen);
+            for mmsg in msgvec.iter() {
+                if !mmsg.msg_hdr.check_member_ptrs().is_ok() {
+                    break;
+                }
+                match unsafe { MsgHdr::from_c(&mmsg.msg_hdr) } {
+                    Ok(msg) => msgs.push(msg),
+                    Err(_) => break,
+                }
+            }
+            if msgs.is_empty() && vlen > 0 {
+                return_errno!(EINVAL, "the first message is invalid");
+            }
+            socket.sendmmsg(&msgs, flags)?
+        };
+
+        for (mmsg, &len) in msgvec.iter_mut().zip(bytes_sent.iter()) {
+            mmsg.msg_len = len as u32;
+        }
+        Ok(bytes_sent.len() as isize)
+    } else if let Ok(socket) = file_ref.as_unix_datagram() {
         let mut send_count = 0;
         for mmsg in (msgvec) {
             if !mmsg.msg_hdr.check_member_ptrs().is_ok() {
@@ -601,6 +801,85 @@ pub fn do_sendmmsg(
     }
 }
 
+pub fn do_recvmmsg(
+    fd: c_int,
+    msgvec_ptr: *mut mmsghdr_mut,
+    vlen: c_uint,
+    flags_c: c_int,
+    timeout_ptr: *mut timespec_t,
+) -> Result<isize> {
+    debug!(
+        "recvmmsg: fd: {}, msg: {:?}, vlen: {}, flags: 0x{:x}, timeout: {:?}",
+        fd, msgvec_ptr, vlen, flags_c, timeout_ptr
+    );
+
+    let vlen = (vlen as usize).min(UIO_MAXIOV);
+    from_user::check_mut_array(msgvec_ptr, vlen)?;
+    let mut timeout = if timeout_ptr.is_null() {
+        None
+    } else {
+        from_user::check_mut_ptr(timeout_ptr)?;
+        Some(timespec_t::from_raw_ptr(timeout_ptr)?)
+    };
+
+    let msgvec = unsafe { std::slice::from_raw_parts_mut(msgvec_ptr, vlen) };
+    let flags = RecvFlags::from_bits_truncate(flags_c);
+    let file_ref = current!().file(fd as FileDesc)?;
+
+    // The messages after the first invalid one are ignored
+    let mut msg_lens = Vec::with_capacity(vlen);
+    let mut msgs = Vec::with_capacity(vlen);
+    for mmsg in msgvec.iter_mut() {
+        if !mmsg.msg_hdr.check_member_ptrs().is_ok() {
+            break;
+        }
+        match unsafe { MsgHdrMut::from_c(&mut mmsg.msg_hdr) } {
+            Ok(msg) => {
+                msgs.push(msg);
+                msg_lens.push(&mut mmsg.msg_len);
+            }
+            Err(_) => break,
+        }
+    }
+    if msgs.is_empty() && vlen > 0 {
+        return_errno!(EINVAL, "the first message is invalid");
+    }
+
+    let bytes_recvd = if let Ok(socket) = file_ref.as_host_socket() {
+        socket.recvmmsg(&mut msgs, flags, timeout.as_mut())?
+    } else if let Ok(socket) = file_ref.as_unix_datagram() {
+        if timeout.is_some() {
+            warn!("the timeout of recvmmsg is ignored for unix sockets");
+        }
+        let mut flags = flags;
+        let mut bytes_recvd = Vec::with_capacity(msgs.len());
+        for msg in msgs.iter_mut() {
+            match socket.recvmsg(msg, flags) {
+                Ok(len) => bytes_recvd.push(len),
+                Err(e) if bytes_recvd.is_empty() => return Err(e),
+                Err(_) => break,
+            }
+            if flags.contains(RecvFlags::MSG_WAITFORONE) {
+                flags |= RecvFlags::MSG_DONTWAIT;
+            }
+        }
+        bytes_recvd
+    } else if let Ok(socket) = file_ref.as_unix_socket() {
+        return_errno!(EOPNOTSUPP, "does not support unix socket")
+    } else {
+        return_errno!(ENOTSOCK, "not a socket")
+    };
+
+    for (msg_len, &len) in msg_lens.into_iter().zip(bytes_recvd.iter()) {
+        *msg_len = len as u32;
+    }
+    // Update the remaining time as Linux does
+    if let Some(timeout) = timeout {
+        unsafe { *timeout_ptr = timeout };
+    }
+    Ok(bytes_recvd.len() as isize)
+}
+
 #[allow(non_camel_case_types)]
 trait c_msghdr_ext {
     fn check_member_ptrs(&self) -> Result<()>;
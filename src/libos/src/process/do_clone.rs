@@ -53,6 +53,7 @@ pub fn do_clone(
         let fs = current.fs().clone();
         let name = current.name().clone();
         let sig_mask = current.sig_mask().read().unwrap().clone();
+        let mempolicy = current.mempolicy().lock().unwrap().clone();
 
         let mut builder = ThreadBuilder::new()
             .process(current.process().clone())
@@ -63,7 +64,8 @@ pub fn do_clone(
             .name(name)
             .nice(nice)
             .rlimits(rlimits)
-            .sig_mask(sig_mask);
+            .sig_mask(sig_mask)
+            .mempolicy(mempolicy);
         if let Some(ctid) = ctid {
             builder = builder.clear_ctid(ctid);
         }
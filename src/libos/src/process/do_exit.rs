@@ -7,7 +7,7 @@ use super::do_vfork::{is_vforked_child_process, vfork_return_to_parent};
 use super::pgrp::clean_pgrp_when_exit;
 use super::process::{Process, ProcessFilter};
 use super::{table, ProcessRef, TermStatus, ThreadRef, ThreadStatus};
-use crate::ipc::SHM_MANAGER;
+use crate::ipc::{SEM_MANAGER, SHM_MANAGER};
 use crate::prelude::*;
 use crate::signal::{KernelSignal, SigNum};
 use crate::syscall::CpuContext;
@@ -50,6 +50,17 @@ pub fn handle_force_exit() {
     }
 }
 
+/// Terminate a new thread that cannot be started, e.g., when there is no memory for
+/// its stack, as if it were killed right after it starts.
+pub(super) fn exit_unstarted_thread(thread: ThreadRef, host_tid: pid_t) -> TermStatus {
+    let term_status = TermStatus::Killed(SIGKILL);
+    thread.start(host_tid);
+    super::current::set(thread);
+    exit_thread(term_status);
+    super::current::reset();
+    term_status
+}
+
 fn exit_thread(term_status: TermStatus) {
     let thread = current!();
     if thread.status() == ThreadStatus::Exited {
@@ -119,8 +130,14 @@ fn exit_process(thread: &ThreadRef, term_status: TermStatus) {
     // Lock the current process
     let mut process_inner = process.inner();
     // Clean used VM
+    thread.vm().reclaim_stat().clear();
     USER_SPACE_VM_MANAGER.free_chunks_when_exit(thread);
+    thread.vm().unmap_all_shared_mem();
     SHM_MANAGER.detach_shm_when_process_exit(thread);
+    SEM_MANAGER.undo_when_process_exit(thread);
+    // Delete the timers and the AIO contexts
+    process.timers().lock().unwrap().clear();
+    process.aio_contexts().lock().unwrap().clear();
 
     // The parent is the idle process
     if parent_inner.is_none() {
@@ -226,7 +243,12 @@ fn exit_process_for_execve(
     // Lock the current process
     let mut process_inner = process.inner();
     // Clean used VM
+    thread.vm().reclaim_stat().clear();
     USER_SPACE_VM_MANAGER.free_chunks_when_exit(thread);
+    thread.vm().unmap_all_shared_mem();
+    // Delete the timers and the AIO contexts
+    process.timers().lock().unwrap().clear();
+    process.aio_contexts().lock().unwrap().clear();
 
     let mut new_parent_inner = new_parent_ref.inner();
     let pid = process.pid();
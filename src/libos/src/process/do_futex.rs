@@ -2,6 +2,7 @@ use std::collections::hash_map::DefaultHasher;
 use std::hash::{Hash, Hasher};
 use std::intrinsics::atomic_load;
 use std::sync::atomic::{AtomicBool, Ordering};
+use std::time::Duration;
 
 use crate::prelude::*;
 use crate::time::{timespec_t, ClockID};
@@ -100,6 +101,18 @@ impl FutexTimeout {
     pub fn absolute_time(&self) -> bool {
         self.absolute_time
     }
+
+    /// The remaining time until the timeout.
+    pub fn remain(&self) -> Duration {
+        let ts = self.ts.as_duration();
+        if !self.absolute_time {
+            return ts;
+        }
+        let now = crate::time::do_clock_gettime(self.clock_id)
+            .unwrap()
+            .as_duration();
+        ts.checked_sub(now).unwrap_or_default()
+    }
 }
 
 /// Do futex wait
@@ -431,16 +444,26 @@ type WaiterRef = Arc<Waiter>;
 impl Waiter {
     pub fn new() -> Waiter {
         Waiter {
-            thread: unsafe { sgx_thread_get_self() },
+            thread: super::task::self_event_key(),
             is_woken: AtomicBool::new(false),
         }
     }
 
     pub fn wait_timeout(&self, timeout: &Option<FutexTimeout>) -> Result<()> {
-        let current = unsafe { sgx_thread_get_self() };
+        let current = super::task::self_event_key();
         if current != self.thread {
             return Ok(());
         }
+        if let Some(coroutine) = super::task::current_coroutine() {
+            let mut remain = timeout.as_ref().map(|timeout| timeout.remain());
+            while self.is_woken.load(Ordering::SeqCst) == false {
+                if let Err(e) = coroutine.wait_event(remain.as_mut()) {
+                    self.is_woken.store(true, Ordering::SeqCst);
+                    return_errno!(e.errno(), "wait_timeout error");
+                }
+            }
+            return Ok(());
+        }
         while self.is_woken.load(Ordering::SeqCst) == false {
             if let Err(e) = wait_event_timeout(self.thread, timeout) {
                 self.is_woken.store(true, Ordering::SeqCst);
@@ -537,6 +560,12 @@ fn wait_event_timeout(thread: *const c_void, timeout: &Option<FutexTimeout>) ->
 }
 
 fn set_events(threads: &[*const c_void]) {
+    // The events of coroutines are set without OCalls
+    let threads: Vec<*const c_void> = threads
+        .iter()
+        .filter(|&&thread| !super::task::set_coroutine_event(thread))
+        .cloned()
+        .collect();
     if threads.is_empty() {
         return;
     }
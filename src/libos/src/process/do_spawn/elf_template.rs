@@ -0,0 +1,90 @@
+//! Templates of loaded ELF images for fast process launch.
+//!
+//! Loading an ELF into a new process reads its loadable segments from the file
+//! system, which decrypts and verifies the data of the file every time. For the
+//! executables configured in `process.templates`, the loaded images of the executable
+//! and its ld.so are kept as templates when the executable is spawned for the first
+//! time. The later spawns copy the images from the templates instead.
+//!
+//! A template is taken right after the ELF is loaded, before ld.so relocates it, so the
+//! image does not depend on the address where it is loaded. A template is dropped when
+//! the file is changed.
+
+use super::*;
+use crate::config;
+use crate::vm::VMRange;
+use rcore_fs::vfs::{Metadata, Timespec};
+
+lazy_static! {
+    // K: the path of ELF, V: the template
+    static ref ELF_TEMPLATES: SgxMutex<HashMap<String, Arc<ElfTemplate>>> =
+        SgxMutex::new(HashMap::new());
+}
+
+pub struct ElfTemplate {
+    // The identity of the file from which the template is taken
+    stamp: FileStamp,
+    image: Vec<u8>,
+}
+
+#[derive(Debug, PartialEq)]
+struct FileStamp {
+    dev: usize,
+    inode: usize,
+    size: usize,
+    mtime: Timespec,
+}
+
+impl ElfTemplate {
+    /// Whether the executable at the path is configured to have a template
+    pub fn is_configured(path: &str) -> bool {
+        config::LIBOS_CONFIG
+            .process
+            .templates
+            .iter()
+            .any(|template| template == Path::new(path))
+    }
+
+    /// Find the template of the ELF at the path, which is taken from the same file
+    pub fn find(path: &str, file_ref: &FileRef) -> Option<Arc<ElfTemplate>> {
+        let mut templates = ELF_TEMPLATES.lock().unwrap();
+        let template = templates.get(path)?;
+        match FileStamp::new(file_ref) {
+            Ok(stamp) if stamp == template.stamp => Some(template.clone()),
+            _ => {
+                debug!("the template of {:?} is outdated", path);
+                templates.remove(path);
+                None
+            }
+        }
+    }
+
+    /// Take the template of the ELF at the path from the memory where it is loaded
+    pub fn take(path: &str, file_ref: &FileRef, elf_range: &VMRange) -> Result<()> {
+        let stamp = FileStamp::new(file_ref)?;
+        let image = unsafe { elf_range.as_slice() }.to_vec();
+        debug!("take the template of {:?}: {} bytes", path, image.len());
+        let template = Arc::new(ElfTemplate { stamp, image });
+        ELF_TEMPLATES
+            .lock()
+            .unwrap()
+            .insert(path.to_string(), template);
+        Ok(())
+    }
+
+    pub fn image(&self) -> &[u8] {
+        &self.image
+    }
+}
+
+impl FileStamp {
+    fn new(file_ref: &FileRef) -> Result<Self> {
+        let metadata: Metadata = file_ref.metadata()?;
+        Ok(Self {
+            dev: metadata.dev,
+            inode: metadata.inode,
+            size: metadata.size,
+            mtime: metadata.mtime,
+        })
+    }
+}
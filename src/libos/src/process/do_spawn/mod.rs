@@ -2,6 +2,7 @@ use std::ffi::{CStr, CString};
 use std::path::Path;
 
 use self::aux_vec::{AuxKey, AuxVec};
+use self::elf_template::ElfTemplate;
 use self::exec_loader::{load_exec_file_hdr_to_vec, load_file_hdr_to_vec};
 use super::elf_file::{ElfFile, ElfHeader, ProgramHeaderExt};
 use super::process::ProcessBuilder;
@@ -18,6 +19,7 @@ use crate::util::pku_util;
 use crate::vm::ProcessVM;
 
 mod aux_vec;
+mod elf_template;
 mod exec_loader;
 mod init_stack;
 mod init_vm;
@@ -182,8 +184,15 @@ fn new_process_common(
         file_path.to_string()
     };
 
-    let exec_elf_hdr = ElfFile::new(&elf_file, &mut elf_buf, elf_header)
+    // The templates of the executable and its ld.so are taken only if the executable is
+    // configured, while the template of ld.so can be used by any executables.
+    let is_template_configured = ElfTemplate::is_configured(&elf_path);
+    let exec_template = ElfTemplate::find(&elf_path, &elf_file);
+    let mut exec_elf_hdr = ElfFile::new(&elf_file, &mut elf_buf, elf_header)
         .cause_err(|e| errno!(e.errno(), "invalid executable"))?;
+    if let Some(template) = &exec_template {
+        exec_elf_hdr.set_image(template.image());
+    }
     let ldso_path = exec_elf_hdr
         .elf_interpreter()
         .ok_or_else(|| errno!(EINVAL, "cannot find the interpreter segment"))?;
@@ -196,13 +205,26 @@ fn new_process_common(
     } else {
         ldso_elf_header.unwrap()
     };
-    let ldso_elf_hdr = ElfFile::new(&ldso_file, &mut ldso_elf_hdr_buf, ldso_elf_header)
+    let ldso_template = ElfTemplate::find(ldso_path, &ldso_file);
+    let mut ldso_elf_hdr = ElfFile::new(&ldso_file, &mut ldso_elf_hdr_buf, ldso_elf_header)
         .cause_err(|e| errno!(e.errno(), "invalid ld.so"))?;
+    if let Some(template) = &ldso_template {
+        ldso_elf_hdr.set_image(template.image());
+    }
 
     let new_process_ref = {
         let process_ref = current_ref.process().clone();
 
         let vm = init_vm::do_init(&exec_elf_hdr, &ldso_elf_hdr)?;
+        if is_template_configured {
+            // Take the templates before the ELFs are relocated by ld.so
+            if exec_template.is_none() {
+                ElfTemplate::take(&elf_path, &elf_file, &vm.get_elf_ranges()[0])?;
+            }
+            if ldso_template.is_none() {
+                ElfTemplate::take(ldso_path, &ldso_file, &vm.get_elf_ranges()[1])?;
+            }
+        }
         let mut auxvec = init_auxvec(&vm, &exec_elf_hdr)?;
 
         // Notify debugger to load the symbols from elf file
@@ -266,6 +288,7 @@ fn new_process_common(
             current_ref.sig_mask().read().unwrap().clone()
         };
         trace!("new process sigmask = {:?}", sig_mask);
+        let mempolicy = current_ref.mempolicy().lock().unwrap().clone();
 
         let mut sig_dispositions = current_ref
             .process()
@@ -318,6 +341,7 @@ fn new_process_common(
             .pgrp(pgrp_ref)
             .files(files_ref)
             .sig_mask(sig_mask)
+            .mempolicy(mempolicy)
             .name(thread_name)
             .sig_dispositions(sig_dispositions)
             .build()?;
@@ -23,6 +23,9 @@ use std::mem;
 // execve is called in the child process. The reason is that since Occlum doesn't support fork, many applications will
 // use vfork to replace fork. For multi-threaded applications, if vfork doesn't stop other child threads, the application
 // will be more likely to fail because the child process directly uses the VM and the file table of the parent process.
+// 3. There is no copy-on-write snapshot of the parent's memory, even with EDMM. All processes share one address space,
+// so a child cannot have a copy of the parent's VM at the same addresses, and the parent cannot keep running while the
+// child writes its memory. Thus the parent's memory written by the child before execve or exit is not restored.
 
 // The exit status of the child process which directly calls exit after vfork.
 struct ChildExitStatus {
@@ -46,6 +49,12 @@ thread_local! {
     static VFORK_CONTEXT: RefCell<Option<(pid_t, CpuContext)>> = Default::default();
 }
 
+/// Swap the vfork context of the current SGX thread with the given one, which is
+/// needed when the SGX thread switches between LibOS threads.
+pub(super) fn swap_vfork_context(vfork_context: &mut Option<(pid_t, CpuContext)>) {
+    VFORK_CONTEXT.with(|cell| std::mem::swap(&mut *cell.borrow_mut(), vfork_context));
+}
+
 pub fn do_vfork(mut context: *mut CpuContext) -> Result<isize> {
     let current = current!();
     trace!("vfork parent process pid = {:?}", current.process().pid());
@@ -16,6 +16,8 @@ pub struct ElfFile<'a> {
     elf_buf: &'a [u8],
     elf_inner: Elf<'a>,
     file_ref: &'a FileRef,
+    // The loaded image of the ELF from a template, if any
+    image: Option<&'a [u8]>,
 }
 
 impl<'a> Debug for ElfFile<'a> {
@@ -88,6 +90,7 @@ impl<'a> ElfFile<'a> {
             elf_buf,
             elf_inner,
             file_ref,
+            image: None,
         })
     }
 
@@ -111,6 +114,16 @@ impl<'a> ElfFile<'a> {
         self.file_ref
     }
 
+    /// Set the loaded image, which is copied into memory instead of loading the
+    /// segments from the file.
+    pub fn set_image(&mut self, image: &'a [u8]) {
+        self.image = Some(image);
+    }
+
+    pub fn image(&self) -> Option<&'a [u8]> {
+        self.image
+    }
+
     pub fn parse_elf_hdr(elf_file: &FileRef, elf_buf: &mut Vec<u8>) -> Result<ElfHeader> {
         // TODO: Sanity check the number of program headers..
         let mut phdr_start = 0;
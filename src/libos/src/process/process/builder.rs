@@ -6,9 +6,11 @@ use super::super::{
     ProcessVMRef, ResourceLimitsRef, SchedAgentRef,
 };
 use super::{Process, ProcessInner};
-use crate::fs::FileMode;
+use crate::fs::{AioContexts, FileMode};
 use crate::prelude::*;
 use crate::signal::{SigDispositions, SigQueues, SigSet};
+use crate::time::ProcessTimers;
+use crate::vm::MemPolicy;
 
 #[derive(Debug)]
 pub struct ProcessBuilder {
@@ -100,6 +102,10 @@ impl ProcessBuilder {
         self.thread_builder(|tb| tb.sig_mask(sig_mask))
     }
 
+    pub fn mempolicy(mut self, mempolicy: MemPolicy) -> Self {
+        self.thread_builder(|tb| tb.mempolicy(mempolicy))
+    }
+
     pub fn nice(mut self, nice: NiceValueRef) -> Self {
         self.thread_builder(|tb| tb.nice(nice))
     }
@@ -135,6 +141,8 @@ impl ProcessBuilder {
             let sig_dispositions = RwLock::new(self.sig_dispositions.unwrap_or_default());
             let sig_queues = RwLock::new(SigQueues::new());
             let forced_exit_status = ForcedExitStatus::new();
+            let timers = SgxMutex::new(ProcessTimers::new());
+            let aio_contexts = SgxMutex::new(AioContexts::new());
             let start_time = crate::time::up_time::get().unwrap();
             Arc::new(Process {
                 pid,
@@ -147,6 +155,8 @@ impl ProcessBuilder {
                 sig_dispositions,
                 sig_queues,
                 forced_exit_status,
+                timers,
+                aio_contexts,
             })
         };
 
@@ -3,9 +3,10 @@ use std::time::Duration;
 
 use super::wait::WaitQueue;
 use super::{ForcedExitStatus, ProcessGrpRef, ProcessRef, TermStatus, ThreadRef};
-use crate::fs::FileMode;
+use crate::fs::{AioContexts, FileMode};
 use crate::prelude::*;
 use crate::signal::{SigDispositions, SigNum, SigQueues};
+use crate::time::ProcessTimers;
 
 pub use self::builder::ProcessBuilder;
 pub use self::idle::IDLE;
@@ -27,6 +28,10 @@ pub struct Process {
     sig_dispositions: RwLock<SigDispositions>,
     sig_queues: RwLock<SigQueues>,
     forced_exit_status: ForcedExitStatus,
+    // Timers
+    timers: SgxMutex<ProcessTimers>,
+    // Asynchronous I/O
+    aio_contexts: SgxMutex<AioContexts>,
 }
 
 #[derive(Debug, PartialEq, Clone, Copy)]
@@ -156,6 +161,16 @@ impl Process {
         &self.sig_dispositions
     }
 
+    /// Get the POSIX timers and interval timers of the process.
+    pub fn timers(&self) -> &SgxMutex<ProcessTimers> {
+        &self.timers
+    }
+
+    /// Get the AIO contexts of the process.
+    pub fn aio_contexts(&self) -> &SgxMutex<AioContexts> {
+        &self.aio_contexts
+    }
+
     pub fn term_status(&self) -> Option<TermStatus> {
         self.forced_exit_status.term_status()
     }
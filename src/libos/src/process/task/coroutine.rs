@@ -0,0 +1,561 @@
+//! Coroutines that execute LibOS threads in the M:N mode.
+//!
+//! In the M:N mode, every LibOS thread is executed by a coroutine, which has a kernel
+//! stack of its own on the enclave heap. A coroutine is pinned to the vCPU that starts
+//! it and is switched to and from the scheduler loop of the vCPU cooperatively, i.e.,
+//! only when the LibOS thread blocks (`park`), yields (`yield_now`) or exits.
+//!
+//! As a coroutine holds its vCPU until it switches away, it must not block in the host.
+//! A thread that waits for host fds parks with `poll_host_fds` instead, and the I/O
+//! on host sockets and host stdin waits that way (see `HostSocket::block_on_host`).
+//! Likewise, a thread sleeps by parking with a timeout rather than in the host.
+//!
+//! Parking works like `std::thread::park`: an `unpark` makes the next (or the ongoing)
+//! `park` return, so the users of `park` must check their wakeup conditions in a loop.
+
+use std::alloc::{alloc, dealloc, Layout};
+use std::cell::UnsafeCell;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Weak;
+use std::time::Duration;
+
+use atomic::Atomic;
+
+use super::super::thread::sgx_thread_get_self;
+use super::super::{current, TermStatus, ThreadRef};
+use super::vcpu::Vcpu;
+use super::Task;
+use crate::events::poll_host_fds;
+use crate::interrupt;
+use crate::prelude::*;
+use crate::process::do_vfork::swap_vfork_context;
+use crate::signal::{swap_pre_ucontexts, CpuContextStack};
+use crate::syscall::CpuContext;
+use crate::time::{do_clock_gettime, ClockID};
+
+pub type CoroutineRef = Arc<Coroutine>;
+
+lazy_static! {
+    // All live coroutines indexed by their addresses, which are also the keys of
+    // their events (see `self_event_key`)
+    static ref COROUTINES: SgxMutex<HashMap<usize, Weak<Coroutine>>> = Default::default();
+}
+
+thread_local! {
+    // The coroutine that is running on the current vCPU
+    static CURRENT_COROUTINE: RefCell<Option<CoroutineRef>> = Default::default();
+}
+
+/// Get the coroutine of the current LibOS thread, if it is executed in the M:N mode.
+pub fn current_coroutine() -> Option<CoroutineRef> {
+    if !super::vcpu::is_enabled() {
+        return None;
+    }
+    CURRENT_COROUTINE.with(|cell| cell.borrow().clone())
+}
+
+/// Get the key of the current thread to wait for an untrusted event.
+///
+/// In the 1:1 mode, this is the SGX thread of the current thread. In the M:N mode,
+/// a vCPU (and thus its SGX thread) is shared by many LibOS threads, so the key is
+/// the coroutine of the current thread instead.
+pub fn self_event_key() -> *const c_void {
+    match current_coroutine() {
+        Some(coroutine) => Arc::as_ptr(&coroutine) as *const c_void,
+        None => unsafe { sgx_thread_get_self() },
+    }
+}
+
+/// Set the event of the coroutine with the given key. Return false if the key does
+/// not belong to any coroutine, in which case the event should be set in the host.
+pub fn set_coroutine_event(key: *const c_void) -> bool {
+    if !super::vcpu::is_enabled() {
+        return false;
+    }
+    let coroutine = COROUTINES
+        .lock()
+        .unwrap()
+        .get(&(key as usize))
+        .and_then(Weak::upgrade);
+    match coroutine {
+        Some(coroutine) => {
+            coroutine.set_event();
+            true
+        }
+        None => false,
+    }
+}
+
+/// Interrupt the coroutine with the given key if it is parked. Return false if the
+/// coroutine does not exist or is not parked.
+pub fn interrupt_parked_coroutine(key: usize) -> bool {
+    if !super::vcpu::is_enabled() {
+        return false;
+    }
+    let coroutine = COROUTINES.lock().unwrap().get(&key).and_then(Weak::upgrade);
+    match coroutine {
+        Some(coroutine) if coroutine.is_parked() => {
+            coroutine.interrupt();
+            true
+        }
+        _ => false,
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+enum State {
+    // In the run queue of its vCPU
+    Ready,
+    Running,
+    // Going to switch to the vCPU to be parked
+    Parking,
+    Parked,
+    // Unparked during parking, so it should not be parked
+    Woken,
+    // Going to switch to the vCPU to be put back into the run queue
+    Yielding,
+    Exited,
+}
+
+/// The context of a coroutine or a vCPU.
+///
+/// Note: this definition must be in sync with task.h
+#[derive(Debug, Default)]
+#[repr(C)]
+pub struct Context {
+    rsp: usize,
+    stack_base: usize,
+    stack_limit: usize,
+    task: usize,
+}
+
+impl Context {
+    /// Switch from this context to another one.
+    ///
+    /// Safety. The caller must ensure that the target context is valid.
+    pub unsafe fn switch_to(&mut self, target: &mut Context) {
+        do_switch_context(self, target);
+    }
+}
+
+/// The states of a LibOS thread that are kept in thread-local storage (i.e., per SGX
+/// thread) in the 1:1 mode. They are swapped in and out with the coroutine.
+#[derive(Default)]
+struct TaskLocals {
+    pre_ucontexts: CpuContextStack,
+    vfork_context: Option<(pid_t, CpuContext)>,
+}
+
+impl TaskLocals {
+    fn swap(&mut self) {
+        swap_pre_ucontexts(&mut self.pre_ucontexts);
+        swap_vfork_context(&mut self.vfork_context);
+    }
+}
+
+/// The caller that waits for a LibOS thread to exit on a host thread.
+pub struct Joiner {
+    status: SgxMutex<Option<i32>>,
+    host_thread: *const c_void,
+}
+
+unsafe impl Send for Joiner {}
+unsafe impl Sync for Joiner {}
+
+impl Joiner {
+    /// Create a joiner for the current host thread.
+    pub fn new() -> Self {
+        Self {
+            status: SgxMutex::new(None),
+            host_thread: unsafe { sgx_thread_get_self() },
+        }
+    }
+
+    /// Wait for the exit status of the LibOS thread.
+    pub fn join(&self) -> i32 {
+        loop {
+            if let Some(status) = *self.status.lock().unwrap() {
+                return status;
+            }
+            super::super::untrusted_event::wait_event(self.host_thread);
+        }
+    }
+
+    pub(super) fn finish(&self, status: i32) {
+        *self.status.lock().unwrap() = Some(status);
+        super::super::untrusted_event::set_event(self.host_thread);
+    }
+}
+
+pub struct Coroutine {
+    thread: ThreadRef,
+    joiner: Option<Arc<Joiner>>,
+    vcpu: Arc<Vcpu>,
+    state: Atomic<State>,
+    permit: AtomicBool,
+    event: AtomicBool,
+    interrupted: AtomicBool,
+    // Only accessed by the vCPU of the coroutine
+    context: UnsafeCell<Context>,
+    locals: UnsafeCell<TaskLocals>,
+    stack: Stack,
+}
+
+unsafe impl Send for Coroutine {}
+unsafe impl Sync for Coroutine {}
+
+impl Coroutine {
+    pub fn new(
+        thread: ThreadRef,
+        joiner: Option<Arc<Joiner>>,
+        vcpu: Arc<Vcpu>,
+    ) -> Result<Arc<Self>> {
+        let stack = Stack::new(crate::config::LIBOS_CONFIG.scheduler.task_stack_size)?;
+        let context = Context {
+            stack_base: stack.base(),
+            stack_limit: stack.limit(),
+            ..Default::default()
+        };
+        let coroutine = Arc::new(Self {
+            thread,
+            joiner,
+            vcpu,
+            state: Atomic::new(State::Ready),
+            permit: AtomicBool::new(false),
+            event: AtomicBool::new(false),
+            interrupted: AtomicBool::new(false),
+            context: UnsafeCell::new(context),
+            locals: Default::default(),
+            stack,
+        });
+        unsafe {
+            do_init_context(
+                coroutine.context.get(),
+                coroutine_main,
+                Arc::as_ptr(&coroutine) as *mut c_void,
+            );
+        }
+        COROUTINES
+            .lock()
+            .unwrap()
+            .insert(Arc::as_ptr(&coroutine) as usize, Arc::downgrade(&coroutine));
+        Ok(coroutine)
+    }
+
+    pub fn thread(&self) -> &ThreadRef {
+        &self.thread
+    }
+
+    /// The ID of the vCPU, to which the coroutine is pinned
+    pub fn vcpu_id(&self) -> usize {
+        self.vcpu.id()
+    }
+
+    /// Park the current coroutine until it is unparked, or the method call is timeout
+    /// or interrupted. The timeout is updated to reflect the remaining time.
+    ///
+    /// The method may also return `Ok(())` spuriously.
+    pub fn park(self: &Arc<Self>, timeout: Option<&mut Duration>) -> Result<()> {
+        if self.interrupted.swap(false, Ordering::SeqCst) {
+            return_errno!(EINTR, "interrupted");
+        }
+        if self.permit.swap(false, Ordering::SeqCst) {
+            return Ok(());
+        }
+
+        const ZERO: Duration = Duration::from_secs(0);
+        let deadline = match timeout.as_ref() {
+            None => None,
+            Some(timeout) if **timeout == ZERO => {
+                return_errno!(ETIMEDOUT, "should return immediately");
+            }
+            Some(timeout) => {
+                let deadline = now() + **timeout;
+                self.vcpu.add_timer(deadline, self);
+                Some(deadline)
+            }
+        };
+
+        self.state.store(State::Parking, Ordering::SeqCst);
+        // Check again in case that the coroutine is unparked or interrupted before its
+        // state becomes Parking
+        if !self.permit.load(Ordering::SeqCst) && !self.interrupted.load(Ordering::SeqCst) {
+            self.switch_to_vcpu();
+        }
+        self.state.store(State::Running, Ordering::SeqCst);
+
+        if let (Some(deadline), Some(timeout)) = (deadline, timeout) {
+            self.vcpu.remove_timer(deadline, self);
+            *timeout = deadline.checked_sub(now()).unwrap_or(ZERO);
+            if *timeout == ZERO {
+                return_errno!(ETIMEDOUT, "time is up");
+            }
+        }
+        if self.interrupted.swap(false, Ordering::SeqCst) {
+            return_errno!(EINTR, "interrupted");
+        }
+        self.permit.store(false, Ordering::SeqCst);
+        Ok(())
+    }
+
+    /// Park the current coroutine until any of the host fds has the events of interest,
+    /// or the method call returns as `park` does. The host fds are polled by the vCPU
+    /// on behalf of the coroutine, so no OCall blocks the vCPU.
+    ///
+    /// Return the number of the host fds that have events, whose `revents` are set.
+    /// Unlike `park`, the method returns `Ok(0)` if the time is up.
+    pub fn poll_host_fds(
+        self: &Arc<Self>,
+        pollfds: &mut [libc::pollfd],
+        timeout: Option<&mut Duration>,
+    ) -> Result<usize> {
+        const ZERO: Duration = Duration::from_secs(0);
+        if timeout.as_ref().map_or(false, |timeout| **timeout == ZERO) {
+            // A poll that returns immediately never blocks the vCPU
+            return poll_host_fds(pollfds, timeout, None);
+        }
+
+        for pollfd in pollfds.iter_mut() {
+            pollfd.revents = 0;
+        }
+        unsafe {
+            self.vcpu.add_host_poller(self, pollfds);
+        }
+        let ret = self.park(timeout);
+        self.vcpu.remove_host_poller(self);
+
+        let num_events = pollfds.iter().filter(|pollfd| pollfd.revents != 0).count();
+        match ret {
+            Err(e) if e.errno() == ETIMEDOUT => Ok(num_events),
+            Err(e) if num_events == 0 => Err(e),
+            _ => Ok(num_events),
+        }
+    }
+
+    /// Make the coroutine's ongoing or next `park` return.
+    pub fn unpark(self: &Arc<Self>) {
+        self.permit.store(true, Ordering::SeqCst);
+        self.resume();
+    }
+
+    /// Wait until the event of the coroutine is set, or the method call is timeout or
+    /// interrupted.
+    pub fn wait_event(self: &Arc<Self>, mut timeout: Option<&mut Duration>) -> Result<()> {
+        while !self.event.swap(false, Ordering::SeqCst) {
+            self.park(timeout.as_mut().map(|timeout| &mut **timeout))?;
+        }
+        Ok(())
+    }
+
+    fn set_event(self: &Arc<Self>) {
+        self.event.store(true, Ordering::SeqCst);
+        self.unpark();
+    }
+
+    fn interrupt(self: &Arc<Self>) {
+        self.interrupted.store(true, Ordering::SeqCst);
+        self.resume();
+    }
+
+    fn is_parked(&self) -> bool {
+        match self.state.load(Ordering::SeqCst) {
+            State::Parking | State::Parked => true,
+            _ => false,
+        }
+    }
+
+    /// Give up the vCPU to other coroutines that are ready to run.
+    pub fn yield_now(&self) {
+        self.state.store(State::Yielding, Ordering::SeqCst);
+        self.switch_to_vcpu();
+        self.state.store(State::Running, Ordering::SeqCst);
+    }
+
+    // Put the coroutine back into the run queue of its vCPU if it is parked
+    fn resume(self: &Arc<Self>) {
+        if self.make_ready() {
+            self.vcpu.enqueue(self.clone());
+        }
+    }
+
+    /// Change the state from Parked to Ready. Return true if the change is made, in
+    /// which case the caller must put the coroutine into the run queue.
+    pub(super) fn make_ready(&self) -> bool {
+        let parked_to_ready = self.state.compare_exchange(
+            State::Parked,
+            State::Ready,
+            Ordering::SeqCst,
+            Ordering::SeqCst,
+        );
+        match parked_to_ready {
+            Ok(_) => true,
+            Err(State::Parking) => {
+                // The vCPU will put the coroutine into the run queue once it sees
+                // the state of Woken
+                let parking_to_woken = self.state.compare_exchange(
+                    State::Parking,
+                    State::Woken,
+                    Ordering::SeqCst,
+                    Ordering::SeqCst,
+                );
+                if parking_to_woken.is_err() {
+                    // The coroutine has just been parked
+                    return self.make_ready();
+                }
+                false
+            }
+            Err(_) => false,
+        }
+    }
+
+    /// Switch to the coroutine from its vCPU. Return whether the coroutine should be put
+    /// back into the run queue.
+    ///
+    /// Safety. The method must be called by the vCPU of the coroutine.
+    pub(super) unsafe fn switch_from(self: &Arc<Self>, vcpu_context: &mut Context) -> bool {
+        self.state.store(State::Running, Ordering::SeqCst);
+        CURRENT_COROUTINE.with(|cell| *cell.borrow_mut() = Some(self.clone()));
+        current::set(self.thread.clone());
+        (*self.locals.get()).swap();
+        interrupt::enable_current_thread();
+
+        vcpu_context.switch_to(&mut *self.context.get());
+
+        interrupt::disable_current_thread();
+        (*self.locals.get()).swap();
+        current::reset();
+        CURRENT_COROUTINE.with(|cell| cell.borrow_mut().take());
+
+        let should_run = match self.state.load(Ordering::SeqCst) {
+            // Unparked during parking if the state is not Parking any more
+            State::Parking => self
+                .state
+                .compare_exchange(
+                    State::Parking,
+                    State::Parked,
+                    Ordering::SeqCst,
+                    Ordering::SeqCst,
+                )
+                .is_err(),
+            State::Woken | State::Yielding => true,
+            State::Exited => false,
+            state => unreachable!("unexpected state of coroutine: {:?}", state),
+        };
+        if should_run {
+            self.state.store(State::Ready, Ordering::SeqCst);
+        }
+        should_run
+    }
+
+    pub fn is_exited(&self) -> bool {
+        self.state.load(Ordering::SeqCst) == State::Exited
+    }
+
+    fn switch_to_vcpu(&self) {
+        unsafe {
+            (*self.context.get()).switch_to(&mut *self.vcpu.context());
+        }
+    }
+
+    fn exec_thread(&self) {
+        let this_thread = &self.thread;
+        this_thread.start(self.vcpu.host_tid());
+
+        unsafe {
+            // task may only be modified by this function; so no lock is needed
+            do_exec_task(this_thread.task() as *const Task as *mut Task);
+        }
+
+        let term_status = this_thread.inner().term_status().unwrap();
+        match term_status {
+            TermStatus::Exited(status) => {
+                info!(
+                    "Thread exited: tid = {}, status = {}",
+                    this_thread.tid(),
+                    status
+                );
+            }
+            TermStatus::Killed(signum) => {
+                info!(
+                    "Thread killed: tid = {}, signum = {:?}",
+                    this_thread.tid(),
+                    signum
+                );
+            }
+        }
+        if let Some(joiner) = self.joiner.as_ref() {
+            joiner.finish(term_status.as_u32() as i32);
+        }
+    }
+}
+
+impl Drop for Coroutine {
+    fn drop(&mut self) {
+        COROUTINES
+            .lock()
+            .unwrap()
+            .remove(&(self as *const Self as usize));
+    }
+}
+
+extern "C" fn coroutine_main(arg: *mut c_void) {
+    // The vCPU holds a reference to the coroutine while the coroutine is running
+    let coroutine = unsafe { &*(arg as *const Coroutine) };
+    coroutine.exec_thread();
+
+    // Never switched back again
+    coroutine.state.store(State::Exited, Ordering::SeqCst);
+    coroutine.switch_to_vcpu();
+    unreachable!("an exited coroutine is resumed");
+}
+
+/// The kernel stack of a coroutine.
+struct Stack {
+    ptr: *mut u8,
+    layout: Layout,
+}
+
+impl Stack {
+    // Enough for the syscall stack gap and the two pages reserved for the SDK
+    // exception handler (see task.c)
+    const MIN_SIZE: usize = 64 * 1024;
+
+    fn new(size: usize) -> Result<Self> {
+        let size = align_up(size.max(Self::MIN_SIZE), PAGE_SIZE);
+        let layout = Layout::from_size_align(size, PAGE_SIZE).unwrap();
+        let ptr = unsafe { alloc(layout) };
+        if ptr.is_null() {
+            return_errno!(ENOMEM, "no memory for the task stack");
+        }
+        Ok(Self { ptr, layout })
+    }
+
+    fn base(&self) -> usize {
+        self.ptr as usize + self.layout.size()
+    }
+
+    fn limit(&self) -> usize {
+        self.ptr as usize
+    }
+}
+
+impl Drop for Stack {
+    fn drop(&mut self) {
+        unsafe { dealloc(self.ptr, self.layout) };
+    }
+}
+
+const PAGE_SIZE: usize = 4096;
+
+/// The current monotonic time, which is used for the deadlines of parking.
+pub fn now() -> Duration {
+    do_clock_gettime(ClockID::CLOCK_MONOTONIC)
+        .unwrap()
+        .as_duration()
+}
+
+extern "C" {
+    fn do_init_context(context: *mut Context, entry: extern "C" fn(*mut c_void), arg: *mut c_void);
+    fn do_switch_context(from: *mut Context, to: *mut Context);
+    fn do_exec_task(task: *mut Task) -> i32;
+}
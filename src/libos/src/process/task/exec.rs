@@ -1,5 +1,6 @@
 use super::super::{current, TermStatus, ThreadRef};
-use super::Task;
+use super::coroutine::Joiner;
+use super::{vcpu, Task};
 use crate::interrupt;
 use crate::prelude::*;
 
@@ -13,8 +14,14 @@ pub fn enqueue(new_thread: ThreadRef) {
     assert!(existing_thread.is_none());
 }
 
-/// Enqueue a new thread and execute it in a separate host thread.
+/// Enqueue a new thread and execute it in a separate host thread, or on a vCPU in the
+/// M:N mode.
 pub fn enqueue_and_exec(new_thread: ThreadRef) {
+    if vcpu::is_enabled() {
+        vcpu::spawn(new_thread, None);
+        return;
+    }
+
     let new_tid = new_thread.tid();
     enqueue(new_thread);
 
@@ -33,8 +40,17 @@ fn dequeue(libos_tid: pid_t) -> Result<ThreadRef> {
 }
 
 /// Execute the specified LibOS thread in the current host thread.
+///
+/// In the M:N mode, the thread is executed on a vCPU instead, while the current host
+/// thread waits for it to exit.
 pub fn exec(libos_tid: pid_t, host_tid: pid_t) -> Result<i32> {
     let this_thread: ThreadRef = dequeue(libos_tid)?;
+    if vcpu::is_enabled() {
+        let joiner = Arc::new(Joiner::new());
+        vcpu::spawn(this_thread, Some(joiner.clone()));
+        return Ok(joiner.join());
+    }
+
     this_thread.start(host_tid);
 
     // Enable current::get() from now on
@@ -65,6 +81,14 @@ pub fn exec(libos_tid: pid_t, host_tid: pid_t) -> Result<i32> {
     Ok(term_status.as_u32() as i32)
 }
 
+/// Run the specified vCPU in the current host thread until it has no threads to run.
+pub fn exec_vcpu(vcpu_id: usize, host_tid: pid_t) -> Result<()> {
+    if !vcpu::is_enabled() {
+        return_errno!(EINVAL, "vCPUs are only used in the M:N mode");
+    }
+    vcpu::run(vcpu_id, host_tid)
+}
+
 lazy_static! {
     static ref NEW_THREAD_TABLE: SgxMutex<HashMap<pid_t, ThreadRef>> =
         { SgxMutex::new(HashMap::new()) };
@@ -3,9 +3,16 @@ use std::sync::atomic::{AtomicUsize, Ordering};
 
 use crate::prelude::*;
 
-pub use self::exec::{enqueue, enqueue_and_exec, exec};
+pub use self::coroutine::{
+    current_coroutine, interrupt_parked_coroutine, self_event_key, set_coroutine_event, Coroutine,
+    CoroutineRef,
+};
+pub use self::exec::{enqueue, enqueue_and_exec, exec, exec_vcpu};
+pub use self::vcpu::is_enabled as is_vcpu_enabled;
 
+mod coroutine;
 mod exec;
+mod vcpu;
 
 /// Note: this definition must be in sync with task.h
 #[derive(Debug, Default)]
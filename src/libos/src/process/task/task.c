@@ -14,6 +14,8 @@ extern thread_data_t *get_thread_data(void);
 
 
 extern void __exec_task(struct Task *task);
+extern void __switch_context(uint64_t *from_rsp, uint64_t to_rsp);
+extern void __coroutine_entry(void);
 
 extern uint64_t __get_stack_guard(void);
 extern void __set_stack_guard(uint64_t new_val);
@@ -69,3 +71,42 @@ void do_exit_task(void) {
     jmp_buf *jb = task->saved_state;
     longjmp(*jb, 1);
 }
+
+// Prepare a context that starts to run entry(arg) on the stack of the context when
+// it is switched to for the first time.
+//
+// The initial stack is laid out as if the context had been switched out by
+// __switch_context: six callee-saved registers (with %r12 = arg and %r13 = entry)
+// followed by the return address __coroutine_entry.
+void do_init_context(struct Context *context, void (*entry)(void *), void *arg) {
+    uint64_t *sp = (uint64_t *)(context->stack_base & ~0x0FUL);
+    *(--sp) = (uint64_t)__coroutine_entry;
+    *(--sp) = 0;                // %rbp
+    *(--sp) = 0;                // %rbx
+    *(--sp) = (uint64_t)arg;    // %r12
+    *(--sp) = (uint64_t)entry;  // %r13
+    *(--sp) = 0;                // %r14
+    *(--sp) = 0;                // %r15
+    // The default x87 control word (at 4(%rsp)) and MXCSR (at 0(%rsp))
+    *(--sp) = ((uint64_t)0x037F << 32) | 0x1F80;
+    context->rsp = (uint64_t)sp;
+    // The new context inherits the stack guard of the context that initializes it
+    context->task = __get_stack_guard();
+}
+
+// Switch from the current context to another one on the same TCS.
+//
+// Besides the registers, the stack bounds in the thread data of SGX SDK (used by the
+// exception handling of SDK) and the current task (or the stack guard) in %gs are
+// per-context states, so they are switched as well.
+void do_switch_context(struct Context *from, struct Context *to) {
+    thread_data_t *td = get_thread_data();
+    from->stack_base = td->stack_base_addr;
+    from->stack_limit = td->stack_limit_addr;
+    from->task = __get_stack_guard();
+
+    td->stack_base_addr = to->stack_base;
+    td->stack_limit_addr = to->stack_limit;
+    __set_stack_guard(to->task);
+    __switch_context(&from->rsp, to->rsp);
+}
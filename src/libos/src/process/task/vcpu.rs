@@ -0,0 +1,386 @@
+//! vCPUs that execute LibOS threads in the M:N mode.
+//!
+//! A vCPU is a host thread that enters the enclave to run a scheduler loop, which
+//! switches between the coroutines of LibOS threads. Each vCPU has two run queues:
+//!
+//! * The new threads that have not been started, which can be stolen by idle vCPUs;
+//! * The coroutines that are ready to run, which are pinned to the vCPU as they
+//!   depend on the per-SGX-thread states of the vCPU (e.g., the kernel stack bounds).
+//!
+//! A vCPU sleeps on a host eventfd when it has nothing to run, and it exits when it
+//! has no coroutines at all. A vCPU is (re)started by the first thread enqueued to it
+//! after it exits.
+//!
+//! A coroutine must never block in the host, or the other coroutines of its vCPU could
+//! not run until the OCall returns. So a coroutine that waits for host fds (e.g., a
+//! blocking recv on a host socket, which is non-blocking in the host) parks, and its
+//! vCPU polls the host fds of all such coroutines on their behalf in one OCall:
+//! together with the host eventfd when the vCPU is idle, or without waiting every
+//! `HOST_POLL_INTERVAL` switches when the vCPU is busy. Thus, the only OCalls made by
+//! the scheduler are the ones that start vCPUs, wake up sleeping vCPUs and poll the
+//! host fds.
+
+use std::cell::UnsafeCell;
+use std::collections::BTreeMap;
+use std::sync::atomic::{AtomicI32, Ordering};
+use std::time::Duration;
+
+use super::super::do_exit::exit_unstarted_thread;
+use super::super::ThreadRef;
+use super::coroutine::{now, Context, Coroutine, CoroutineRef, Joiner};
+use crate::config::{ConfigSchedMode, LIBOS_CONFIG};
+use crate::events::{poll_host_fds, HostEventFd};
+use crate::prelude::*;
+
+lazy_static! {
+    static ref VCPUS: Vec<Arc<Vcpu>> = (0..LIBOS_CONFIG.scheduler.num_of_vcpus)
+        .map(|id| Arc::new(Vcpu::new(id)))
+        .collect();
+}
+
+/// Whether LibOS threads are executed in the M:N mode.
+pub fn is_enabled() -> bool {
+    LIBOS_CONFIG.scheduler.mode == ConfigSchedMode::ManyToMany
+}
+
+/// Execute a new thread on the least loaded vCPU.
+pub fn spawn(new_thread: ThreadRef, joiner: Option<Arc<Joiner>>) {
+    let vcpu = VCPUS
+        .iter()
+        .min_by_key(|vcpu| vcpu.load())
+        .expect("there must be at least one vCPU");
+    vcpu.push_and_kick(|inner| inner.new_threads.push_back((new_thread, joiner)));
+}
+
+/// Run the scheduler loop of a vCPU in the current host thread until the vCPU has no
+/// coroutines to run.
+pub fn run(vcpu_id: usize, host_tid: pid_t) -> Result<()> {
+    let vcpu = VCPUS
+        .get(vcpu_id)
+        .ok_or_else(|| errno!(EINVAL, "invalid vCPU ID"))?
+        .clone();
+    vcpu.host_tid.store(host_tid, Ordering::Relaxed);
+
+    while let Some(next) = vcpu.pick_next() {
+        let coroutine = match next {
+            Next::Coroutine(coroutine) => coroutine,
+            Next::Thread(new_thread, joiner) => {
+                match Coroutine::new(new_thread.clone(), joiner.clone(), vcpu.clone()) {
+                    Ok(coroutine) => coroutine,
+                    Err(e) => {
+                        error!("failed to create a coroutine: {}", e.backtrace());
+                        // Terminate the thread so that its joiner and the waiters of its
+                        // process are woken up
+                        let term_status = exit_unstarted_thread(new_thread, vcpu.host_tid());
+                        if let Some(joiner) = joiner {
+                            joiner.finish(term_status.as_u32() as i32);
+                        }
+                        vcpu.inner.lock().unwrap().num_coroutines -= 1;
+                        continue;
+                    }
+                }
+            }
+        };
+
+        let should_run = unsafe { coroutine.switch_from(&mut *vcpu.context()) };
+        if should_run {
+            vcpu.inner.lock().unwrap().ready.push_back(coroutine);
+        } else if coroutine.is_exited() {
+            vcpu.inner.lock().unwrap().num_coroutines -= 1;
+        }
+    }
+    Ok(())
+}
+
+enum Next {
+    Coroutine(CoroutineRef),
+    Thread(ThreadRef, Option<Arc<Joiner>>),
+}
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+enum VcpuState {
+    // No host thread is running the vCPU
+    Stopped,
+    Running,
+    // Sleeping on the host eventfd
+    Idle,
+}
+
+pub struct Vcpu {
+    id: usize,
+    host_tid: AtomicI32,
+    inner: SgxMutex<Inner>,
+    host_eventfd: HostEventFd,
+    // Only accessed by the host thread of the vCPU
+    context: UnsafeCell<Context>,
+}
+
+unsafe impl Send for Vcpu {}
+unsafe impl Sync for Vcpu {}
+
+struct Inner {
+    state: VcpuState,
+    new_threads: VecDeque<(ThreadRef, Option<Arc<Joiner>>)>,
+    ready: VecDeque<CoroutineRef>,
+    // The parked coroutines with timeouts, indexed by their deadlines and addresses
+    timers: BTreeMap<(Duration, usize), CoroutineRef>,
+    // The number of coroutines that are created by the vCPU and not exited
+    num_coroutines: usize,
+    // The parked coroutines that wait for host fds
+    host_pollers: Vec<HostPoller>,
+    // The number of coroutines switched to since the host fds were polled last time
+    switches_since_host_poll: usize,
+}
+
+// A parked coroutine that waits for any of its host fds to have events
+struct HostPoller {
+    coroutine: CoroutineRef,
+    // The array of pollfds owned by the coroutine, which is only accessed by the host
+    // thread of the vCPU
+    pollfds: *mut libc::pollfd,
+    nfds: usize,
+}
+
+impl Vcpu {
+    fn new(id: usize) -> Self {
+        let inner = Inner {
+            state: VcpuState::Stopped,
+            new_threads: VecDeque::new(),
+            ready: VecDeque::new(),
+            timers: BTreeMap::new(),
+            num_coroutines: 0,
+            host_pollers: Vec::new(),
+            switches_since_host_poll: 0,
+        };
+        Self {
+            id,
+            host_tid: AtomicI32::new(0),
+            inner: SgxMutex::new(inner),
+            host_eventfd: HostEventFd::new().expect("failed to create the eventfd of vCPU"),
+            context: UnsafeCell::new(Context::default()),
+        }
+    }
+
+    pub fn id(&self) -> usize {
+        self.id
+    }
+
+    pub fn host_tid(&self) -> pid_t {
+        self.host_tid.load(Ordering::Relaxed)
+    }
+
+    pub fn context(&self) -> *mut Context {
+        self.context.get()
+    }
+
+    /// Put a coroutine that becomes ready into the run queue.
+    pub fn enqueue(&self, coroutine: CoroutineRef) {
+        self.push_and_kick(|inner| inner.ready.push_back(coroutine));
+    }
+
+    pub fn add_timer(&self, deadline: Duration, coroutine: &CoroutineRef) {
+        let key = (deadline, Arc::as_ptr(coroutine) as usize);
+        self.inner
+            .lock()
+            .unwrap()
+            .timers
+            .insert(key, coroutine.clone());
+    }
+
+    pub fn remove_timer(&self, deadline: Duration, coroutine: &CoroutineRef) {
+        let key = (deadline, Arc::as_ptr(coroutine) as usize);
+        self.inner.lock().unwrap().timers.remove(&key);
+    }
+
+    /// Poll the host fds on behalf of the coroutine, which is going to be parked. Once
+    /// any of the host fds has events, their `revents` are set and the coroutine is
+    /// made ready.
+    ///
+    /// Safety. The caller must be the coroutine, and the pollfds must be valid until
+    /// `remove_host_poller` is called.
+    pub unsafe fn add_host_poller(&self, coroutine: &CoroutineRef, pollfds: &mut [libc::pollfd]) {
+        self.inner.lock().unwrap().host_pollers.push(HostPoller {
+            coroutine: coroutine.clone(),
+            pollfds: pollfds.as_mut_ptr(),
+            nfds: pollfds.len(),
+        });
+    }
+
+    /// Stop polling the host fds of the coroutine if they are still polled.
+    pub fn remove_host_poller(&self, coroutine: &CoroutineRef) {
+        self.inner
+            .lock()
+            .unwrap()
+            .host_pollers
+            .retain(|poller| !Arc::ptr_eq(&poller.coroutine, coroutine));
+    }
+
+    fn load(&self) -> usize {
+        let inner = self.inner.lock().unwrap();
+        inner.num_coroutines + inner.new_threads.len()
+    }
+
+    fn push_and_kick<F: FnOnce(&mut Inner)>(&self, push: F) {
+        let prev_state = {
+            let mut inner = self.inner.lock().unwrap();
+            push(&mut inner);
+            std::mem::replace(&mut inner.state, VcpuState::Running)
+        };
+        match prev_state {
+            VcpuState::Running => {}
+            VcpuState::Idle => self.host_eventfd.write_u64(1),
+            VcpuState::Stopped => {
+                let mut ret = 0;
+                let ocall_status =
+                    unsafe { occlum_ocall_exec_vcpu_async(&mut ret, self.id as i32) };
+                assert!(ocall_status == sgx_status_t::SGX_SUCCESS && ret == 0);
+            }
+        }
+    }
+
+    // Pick the next coroutine or new thread to run, or return None if the vCPU should
+    // stop
+    fn pick_next(&self) -> Option<Next> {
+        loop {
+            if self.inner.lock().unwrap().is_host_poll_due() {
+                self.poll_host(Some(Duration::default()), false);
+            }
+
+            let (timeout, has_host_pollers) = {
+                let mut inner = self.inner.lock().unwrap();
+                inner.fire_timers();
+                if let Some(coroutine) = inner.ready.pop_front() {
+                    inner.switches_since_host_poll += 1;
+                    return Some(Next::Coroutine(coroutine));
+                }
+                if let Some((new_thread, joiner)) = inner.new_threads.pop_front() {
+                    inner.num_coroutines += 1;
+                    return Some(Next::Thread(new_thread, joiner));
+                }
+                drop(inner);
+
+                if let Some((new_thread, joiner)) = self.steal() {
+                    self.inner.lock().unwrap().num_coroutines += 1;
+                    return Some(Next::Thread(new_thread, joiner));
+                }
+
+                let mut inner = self.inner.lock().unwrap();
+                if !inner.ready.is_empty() || !inner.new_threads.is_empty() {
+                    continue;
+                }
+                if inner.num_coroutines == 0 {
+                    inner.state = VcpuState::Stopped;
+                    return None;
+                }
+                inner.state = VcpuState::Idle;
+                let timeout = inner
+                    .timers
+                    .keys()
+                    .next()
+                    .map(|(deadline, _)| deadline.checked_sub(now()).unwrap_or_default());
+                (timeout, !inner.host_pollers.is_empty())
+            };
+
+            // Wake up when a coroutine becomes ready, the earliest timer expires or any
+            // host fd polled for the parked coroutines has events
+            if has_host_pollers {
+                self.poll_host(timeout, true);
+            } else if timeout != Some(Duration::default()) {
+                let _ = self.host_eventfd.poll(timeout.as_ref());
+            }
+            self.inner.lock().unwrap().state = VcpuState::Running;
+        }
+    }
+
+    // Poll the host fds of the host pollers, and the host eventfd of the vCPU if it is
+    // idle, in one OCall. Then make the coroutines whose host fds have events ready.
+    //
+    // The host pollers are only added or removed by the coroutines of the vCPU, which
+    // do not run during the poll.
+    fn poll_host(&self, mut timeout: Option<Duration>, is_idle: bool) {
+        let mut pollfds = Vec::new();
+        if is_idle {
+            pollfds.push(libc::pollfd {
+                fd: self.host_eventfd.host_fd() as i32,
+                events: libc::POLLIN,
+                revents: 0,
+            });
+        }
+        {
+            let mut inner = self.inner.lock().unwrap();
+            inner.switches_since_host_poll = 0;
+            for poller in inner.host_pollers.iter() {
+                pollfds.extend_from_slice(unsafe { poller.pollfds() });
+            }
+        }
+
+        let eventfd_idx = if is_idle { Some(0) } else { None };
+        if poll_host_fds(&mut pollfds, timeout.as_mut(), eventfd_idx).is_err() {
+            // E.g., interrupted by a signal, in which case the vCPU just goes on
+            return;
+        }
+
+        let mut inner = self.inner.lock().unwrap();
+        let mut polled = &pollfds[eventfd_idx.map_or(0, |_| 1)..];
+        for poller in std::mem::take(&mut inner.host_pollers) {
+            let (poller_pollfds, rest) = polled.split_at(poller.nfds);
+            polled = rest;
+            if poller_pollfds.iter().all(|pollfd| pollfd.revents == 0) {
+                inner.host_pollers.push(poller);
+                continue;
+            }
+            unsafe {
+                poller.pollfds().copy_from_slice(poller_pollfds);
+            }
+            if poller.coroutine.make_ready() {
+                inner.ready.push_back(poller.coroutine);
+            }
+        }
+    }
+
+    // Steal a new thread from another vCPU
+    fn steal(&self) -> Option<(ThreadRef, Option<Arc<Joiner>>)> {
+        VCPUS
+            .iter()
+            .filter(|vcpu| vcpu.id != self.id)
+            .find_map(|vcpu| vcpu.inner.lock().unwrap().new_threads.pop_back())
+    }
+}
+
+impl Inner {
+    // The host fds are polled without waiting every `HOST_POLL_INTERVAL` switches if
+    // the vCPU is busy
+    const HOST_POLL_INTERVAL: usize = 32;
+
+    fn is_host_poll_due(&self) -> bool {
+        !self.host_pollers.is_empty() && self.switches_since_host_poll >= Self::HOST_POLL_INTERVAL
+    }
+
+    // Put the coroutines whose timers expire into the run queue
+    fn fire_timers(&mut self) {
+        if self.timers.is_empty() {
+            return;
+        }
+        let now = now();
+        while let Some(&key) = self.timers.keys().next() {
+            if key.0 > now {
+                break;
+            }
+            let coroutine = self.timers.remove(&key).unwrap();
+            if coroutine.make_ready() {
+                self.ready.push_back(coroutine);
+            }
+        }
+    }
+}
+
+impl HostPoller {
+    // Safety. The caller must be the host thread of the vCPU.
+    unsafe fn pollfds(&self) -> &mut [libc::pollfd] {
+        std::slice::from_raw_parts_mut(self.pollfds, self.nfds)
+    }
+}
+
+extern "C" {
+    fn occlum_ocall_exec_vcpu_async(ret: *mut i32, vcpu_id: i32) -> sgx_status_t;
+}
@@ -1,4 +1,5 @@
 use std::ptr::NonNull;
+use std::sync::atomic::AtomicUsize;
 
 use super::{
     FileTableRef, FsViewRef, NiceValueRef, ProcessRef, ProcessVM, ProcessVMRef, ResourceLimitsRef,
@@ -8,6 +9,7 @@ use super::{
 use crate::events::HostEventFd;
 use crate::prelude::*;
 use crate::time::ThreadProfiler;
+use crate::vm::MemPolicy;
 
 #[derive(Debug)]
 pub struct ThreadBuilder {
@@ -23,6 +25,7 @@ pub struct ThreadBuilder {
     nice: Option<NiceValueRef>,
     rlimits: Option<ResourceLimitsRef>,
     sig_mask: Option<SigSet>,
+    mempolicy: Option<MemPolicy>,
     clear_ctid: Option<NonNull<pid_t>>,
     robust_list: Option<NonNull<RobustListHead>>,
     name: Option<ThreadName>,
@@ -41,6 +44,7 @@ impl ThreadBuilder {
             nice: None,
             rlimits: None,
             sig_mask: None,
+            mempolicy: None,
             clear_ctid: None,
             robust_list: None,
             name: None,
@@ -82,6 +86,11 @@ impl ThreadBuilder {
         self
     }
 
+    pub fn mempolicy(mut self, mempolicy: MemPolicy) -> Self {
+        self.mempolicy = Some(mempolicy);
+        self
+    }
+
     pub fn sched(mut self, sched: SchedAgentRef) -> Self {
         self.sched = Some(sched);
         self
@@ -136,12 +145,15 @@ impl ThreadBuilder {
         let sig_queues = RwLock::new(SigQueues::new());
         let sig_tmp_mask = RwLock::new(SigSet::new_empty());
         let sig_stack = SgxMutex::new(None);
+        let rseq = SgxMutex::new(None);
+        let mempolicy = SgxMutex::new(self.mempolicy.unwrap_or_default());
         let profiler = if cfg!(feature = "syscall_timing") {
             SgxMutex::new(Some(ThreadProfiler::new()))
         } else {
             SgxMutex::new(None)
         };
         let host_eventfd = Arc::new(HostEventFd::new()?);
+        let libos_seq = AtomicUsize::new(0);
         let raw_ptr = RwLock::new(0);
 
         let new_thread = Arc::new(Thread {
@@ -162,7 +174,10 @@ impl ThreadBuilder {
             sig_mask,
             sig_tmp_mask,
             sig_stack,
+            rseq,
+            mempolicy,
             profiler,
+            libos_seq,
             host_eventfd,
             raw_ptr,
         });
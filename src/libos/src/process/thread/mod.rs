@@ -1,5 +1,6 @@
 use std::fmt;
 use std::ptr::NonNull;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
 use super::task::Task;
 use super::{
@@ -10,8 +11,10 @@ use crate::events::HostEventFd;
 use crate::fs::{EventCreationFlags, EventFile};
 use crate::net::THREAD_NOTIFIERS;
 use crate::prelude::*;
+use crate::sched::Rseq;
 use crate::signal::{SigQueues, SigSet, SigStack};
 use crate::time::ThreadProfiler;
+use crate::vm::MemPolicy;
 
 pub use self::builder::ThreadBuilder;
 pub use self::id::ThreadId;
@@ -45,8 +48,14 @@ pub struct Thread {
     sig_mask: RwLock<SigSet>,
     sig_tmp_mask: RwLock<SigSet>,
     sig_stack: SgxMutex<Option<SigStack>>,
+    // Restartable sequences
+    rseq: SgxMutex<Option<Rseq>>,
+    // NUMA memory policy
+    mempolicy: SgxMutex<MemPolicy>,
     // System call timing
     profiler: SgxMutex<Option<ThreadProfiler>>,
+    // The count of the entries into and the exits from the LibOS, for membarrier
+    libos_seq: AtomicUsize,
     // Misc
     host_eventfd: Arc<HostEventFd>,
     raw_ptr: RwLock<usize>,
@@ -112,11 +121,40 @@ impl Thread {
         &self.sig_stack
     }
 
+    /// Get the rseq registration.
+    pub fn rseq(&self) -> &SgxMutex<Option<Rseq>> {
+        &self.rseq
+    }
+
+    /// Get the NUMA memory policy.
+    pub fn mempolicy(&self) -> &SgxMutex<MemPolicy> {
+        &self.mempolicy
+    }
+
     /// Get the alternate thread performance profiler
     pub fn profiler(&self) -> &SgxMutex<Option<ThreadProfiler>> {
         &self.profiler
     }
 
+    /// Mark that the thread enters the LibOS, i.e., by a syscall, an exception or
+    /// an interrupt, which is a full memory barrier.
+    pub fn enter_libos(&self) {
+        self.libos_seq.fetch_add(1, Ordering::SeqCst);
+    }
+
+    /// Mark that the thread leaves the LibOS for the user space, which is a full
+    /// memory barrier.
+    pub fn leave_libos(&self) {
+        self.libos_seq.fetch_add(1, Ordering::SeqCst);
+    }
+
+    /// Get the count of the entries into and the exits from the LibOS, which is odd
+    /// while the thread is in the LibOS. A new thread has an even count, as if it
+    /// is in the user space.
+    pub fn libos_seq(&self) -> usize {
+        self.libos_seq.load(Ordering::SeqCst)
+    }
+
     /// Get the host thread's raw pointer of this libos thread
     pub fn raw_ptr(&self) -> usize {
         self.raw_ptr.read().unwrap().clone()
@@ -219,7 +257,7 @@ impl Thread {
     pub(super) fn start(&self, host_tid: pid_t) {
         self.sched().lock().unwrap().attach(host_tid);
         let mut raw_ptr = self.raw_ptr.write().unwrap();
-        *raw_ptr = (unsafe { sgx_thread_get_self() } as usize);
+        *raw_ptr = super::task::self_event_key() as usize;
 
         // Before the thread starts, this thread could be stopped by other threads
         if self.is_forced_to_stop() {
@@ -1,6 +1,19 @@
+use super::task;
 use crate::prelude::*;
 
+// In the M:N mode, the events of LibOS threads are kept by their coroutines, which are
+// waited and set without OCalls (see `task::self_event_key`).
+
 pub(crate) fn wait_event(thread: *const c_void) {
+    if let Some(coroutine) = task::current_coroutine() {
+        debug_assert!(thread == task::self_event_key());
+        // Interrupts are ignored as the wait on the host does
+        while let Err(e) = coroutine.wait_event(None) {
+            debug_assert!(e.errno() == EINTR);
+        }
+        return;
+    }
+
     let mut ret: c_int = 0;
     let mut sgx_ret: c_int = 0;
     unsafe {
@@ -12,6 +25,10 @@ pub(crate) fn wait_event(thread: *const c_void) {
 }
 
 pub(crate) fn set_event(thread: *const c_void) {
+    if task::set_coroutine_event(thread) {
+        return;
+    }
+
     let mut ret: c_int = 0;
     let mut sgx_ret: c_int = 0;
     unsafe {
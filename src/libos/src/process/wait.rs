@@ -1,4 +1,3 @@
-use super::thread::sgx_thread_get_self;
 use super::untrusted_event::{set_event, wait_event};
 /// A wait/wakeup mechanism that connects wait4 and exit system calls.
 use crate::prelude::*;
@@ -38,7 +37,7 @@ where
 {
     pub fn new(data: &D) -> Waiter<D, R> {
         Waiter {
-            thread: unsafe { sgx_thread_get_self() },
+            thread: super::task::self_event_key(),
             inner: Arc::new(SgxMutex::new(WaiterInner {
                 is_woken: false,
                 data: *data,
@@ -1,21 +1,47 @@
 use super::cpu_set::{CpuSet, NCORES};
+use super::rseq::current_vcpu_id;
+use crate::exception::is_rdpid_supported;
 use crate::prelude::*;
 use crate::process::ThreadRef;
 
 pub fn do_getcpu() -> Result<(u32, u32)> {
-    let cpu = pick_cpu_within_affinity_mask();
+    let cpu = current_cpu();
     let node = NUMA_TOPOLOGY[cpu as usize];
     debug!("do_getcpu cpu = {}, node = {}", cpu, node);
     Ok((cpu, node))
 }
 
-fn pick_cpu_within_affinity_mask() -> u32 {
-    // Always return the idx of the first bit in the affnity mask for now.
-    // TODO: randomly choose a bit in the affinity mask.
-    let thread = current!();
-    let sched = thread.sched().lock().unwrap();
-    let idx = sched.affinity().first_cpu_idx().unwrap();
-    idx as u32
+/// Get the NUMA node on which the current thread is running.
+pub fn current_numa_node() -> u32 {
+    NUMA_TOPOLOGY[current_cpu() as usize]
+}
+
+/// Get the CPU on which the current thread is running.
+///
+/// In the M:N mode, it is the vCPU of the thread, which agrees with rseq. Otherwise,
+/// it is the host CPU, which is read by RDPID, or by an OCALL if RDPID is unavailable.
+fn current_cpu() -> u32 {
+    if let Some(vcpu_id) = current_vcpu_id() {
+        return vcpu_id;
+    }
+
+    let cpu = if *RDPID_SUPPORTED {
+        extern "C" {
+            fn __occlum_rdpid() -> u64;
+        }
+        // Linux sets TSC_AUX to (node << 12 | cpu)
+        (unsafe { __occlum_rdpid() } & 0xfff) as u32
+    } else {
+        extern "C" {
+            fn occlum_ocall_sched_getcpu(ret: *mut i32) -> sgx_status_t;
+        }
+        let mut cpu: i32 = 0;
+        let status = unsafe { occlum_ocall_sched_getcpu(&mut cpu) };
+        assert!(status == sgx_status_t::SGX_SUCCESS);
+        max(cpu, 0) as u32
+    };
+    // The host may report a CPU out of the range in the enclave
+    min(cpu, *NCORES as u32 - 1)
 }
 
 fn validate_numa_topology(numa_topology: &Vec<u32>) -> Result<()> {
@@ -28,6 +54,8 @@ fn validate_numa_topology(numa_topology: &Vec<u32>) -> Result<()> {
 }
 
 lazy_static! {
+    static ref RDPID_SUPPORTED: bool = is_rdpid_supported();
+
     /// The information of Non-Uniform Memory Access(NUMA) topology
     pub static ref NUMA_TOPOLOGY: Vec<u32> = {
         extern "C" {
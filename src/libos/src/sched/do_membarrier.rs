@@ -0,0 +1,107 @@
+//! Memory barriers on the threads of a process or all processes, i.e., membarrier.
+//!
+//! A thread in the LibOS needs nothing, as it passes a full barrier when it leaves the
+//! LibOS. A thread in the user space is interrupted, which makes it enter the LibOS, and
+//! membarrier returns after every such thread has entered or left the LibOS once.
+
+use std::sync::atomic::{fence, Ordering};
+
+use crate::interrupt::interrupt_thread;
+use crate::prelude::*;
+use crate::process::{table, ThreadRef, ThreadStatus};
+
+// The commands of membarrier
+const MEMBARRIER_CMD_QUERY: i32 = 0;
+const MEMBARRIER_CMD_GLOBAL: i32 = 1 << 0;
+const MEMBARRIER_CMD_GLOBAL_EXPEDITED: i32 = 1 << 1;
+const MEMBARRIER_CMD_REGISTER_GLOBAL_EXPEDITED: i32 = 1 << 2;
+const MEMBARRIER_CMD_PRIVATE_EXPEDITED: i32 = 1 << 3;
+const MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED: i32 = 1 << 4;
+const MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE: i32 = 1 << 5;
+const MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE: i32 = 1 << 6;
+const MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ: i32 = 1 << 7;
+const MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_RSEQ: i32 = 1 << 8;
+const MEMBARRIER_CMD_FLAG_CPU: u32 = 1 << 0;
+
+const SUPPORTED_CMDS: i32 = MEMBARRIER_CMD_GLOBAL
+    | MEMBARRIER_CMD_GLOBAL_EXPEDITED
+    | MEMBARRIER_CMD_REGISTER_GLOBAL_EXPEDITED
+    | MEMBARRIER_CMD_PRIVATE_EXPEDITED
+    | MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED
+    | MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE
+    | MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE
+    | MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ
+    | MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_RSEQ;
+
+// The threads that do not leave the user space after being waited for so many times
+// are interrupted again, e.g., those that were in the LibOS when interrupted
+const REINTERRUPT_INTERVAL: usize = 64;
+
+pub fn do_membarrier(cmd: i32, flags: u32, _cpu_id: i32) -> Result<isize> {
+    debug!("membarrier: cmd: {:#x}, flags: {:#x}", cmd, flags);
+    // Only the rseq command can target a CPU, which is taken as all the CPUs
+    if flags != 0
+        && (cmd != MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ || flags != MEMBARRIER_CMD_FLAG_CPU)
+    {
+        return_errno!(EINVAL, "invalid flags");
+    }
+
+    match cmd {
+        MEMBARRIER_CMD_QUERY => return Ok(SUPPORTED_CMDS as isize),
+        // Every process is registered, as the interrupts are always available
+        MEMBARRIER_CMD_REGISTER_GLOBAL_EXPEDITED
+        | MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED
+        | MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE
+        | MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_RSEQ => {}
+        MEMBARRIER_CMD_GLOBAL | MEMBARRIER_CMD_GLOBAL_EXPEDITED => {
+            membarrier_threads(table::get_all_threads());
+        }
+        // An interrupt also serializes the instructions, and aborts the rseq critical
+        // section of the interrupted thread
+        MEMBARRIER_CMD_PRIVATE_EXPEDITED
+        | MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE
+        | MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ => {
+            membarrier_threads(current!().process().threads());
+        }
+        _ => return_errno!(EINVAL, "invalid command"),
+    }
+    Ok(0)
+}
+
+fn membarrier_threads(threads: Vec<ThreadRef>) {
+    // Order the memory accesses of the current thread before those of the others
+    fence(Ordering::SeqCst);
+
+    // The threads in the user space, with their counts of entering or leaving the LibOS
+    let current_tid = current!().tid();
+    let mut user_threads: Vec<(ThreadRef, usize)> = threads
+        .into_iter()
+        .filter(|thread| thread.tid() != current_tid && thread.status() == ThreadStatus::Running)
+        .filter_map(|thread| {
+            let seq = thread.libos_seq();
+            if seq % 2 == 0 {
+                Some((thread, seq))
+            } else {
+                None
+            }
+        })
+        .collect();
+
+    let mut waits = 0;
+    while !user_threads.is_empty() {
+        if waits % REINTERRUPT_INTERVAL == 0 {
+            user_threads.iter().for_each(|(thread, _)| {
+                interrupt_thread(thread);
+            });
+        }
+        super::do_sched_yield::do_sched_yield();
+        waits += 1;
+
+        user_threads.retain(|(thread, seq)| {
+            thread.libos_seq() == *seq && thread.status() == ThreadStatus::Running
+        });
+    }
+
+    // Order the memory accesses of the others before those of the current thread
+    fence(Ordering::SeqCst);
+}
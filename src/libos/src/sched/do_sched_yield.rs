@@ -1,6 +1,13 @@
 use crate::prelude::*;
+use crate::process::task::current_coroutine;
 
 pub fn do_sched_yield() {
+    // In the M:N mode, yield to the other threads on the same vCPU
+    if let Some(coroutine) = current_coroutine() {
+        coroutine.yield_now();
+        return;
+    }
+
     extern "C" {
         fn occlum_ocall_sched_yield() -> sgx_status_t;
     }
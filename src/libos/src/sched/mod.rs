@@ -1,14 +1,18 @@
 /// CPU scheduling for threads.
 mod cpu_set;
 mod do_getcpu;
+mod do_membarrier;
 mod do_priority;
 mod do_sched_affinity;
 mod do_sched_yield;
 mod priority;
+mod rseq;
 mod sched_agent;
 mod syscalls;
 
 pub use cpu_set::NCORES;
+pub use do_getcpu::{current_numa_node, NUMA_TOPOLOGY};
 pub use priority::NiceValue;
+pub use rseq::{abort_critical_section as abort_rseq_critical_section, Rseq};
 pub use sched_agent::SchedAgent;
 pub use syscalls::*;
@@ -0,0 +1,180 @@
+//! Restartable sequences (rseq).
+//!
+//! A thread registers an rseq area, where the LibOS stores the CPU of the thread and
+//! the thread declares its current critical section. If the thread is interrupted or
+//! a signal is delivered in the critical section, the section is aborted, i.e., the
+//! thread resumes at the abort handler of the section. Thus, a per-CPU data structure
+//! can be updated in a critical section without atomic instructions.
+//!
+//! This requires that no other threads run on the CPU of a thread in the middle of its
+//! critical section without the LibOS being aware. This holds only in the M:N mode,
+//! where the CPU of a thread is its vCPU and the threads on a vCPU are switched by the
+//! LibOS. In the 1:1 mode, host threads are preempted and migrated by the host
+//! silently, so rseq is not supported.
+
+use super::cpu_set::NCORES;
+use crate::config::LIBOS_CONFIG;
+use crate::prelude::*;
+use crate::process::task::current_coroutine;
+use crate::process::TermStatus;
+use crate::signal::SIGSEGV;
+use crate::syscall::CpuContext;
+use crate::util::mem_util::from_user::*;
+
+const RSEQ_FLAG_UNREGISTER: i32 = 1;
+// The size of the rseq area in the original ABI, which is also the min size
+const ORIG_RSEQ_SIZE: u32 = 32;
+const RSEQ_CPU_ID_UNINITIALIZED: u32 = -1i32 as u32;
+
+/// The rseq area, i.e., `struct rseq` of Linux, which is shared with the user
+#[repr(C, align(32))]
+struct RseqArea {
+    cpu_id_start: u32,
+    cpu_id: u32,
+    rseq_cs: u64,
+    flags: u32,
+}
+
+/// The descriptor of a critical section, i.e., `struct rseq_cs` of Linux
+#[repr(C, align(32))]
+#[derive(Clone, Copy)]
+struct RseqCs {
+    version: u32,
+    flags: u32,
+    start_ip: u64,
+    post_commit_offset: u64,
+    abort_ip: u64,
+}
+
+/// The rseq registration of a thread
+#[derive(Debug)]
+pub struct Rseq {
+    addr: usize,
+    len: u32,
+    // The signature which must precede the abort handlers
+    sig: u32,
+}
+
+/// Get the vCPU of the current thread if rseq is supported.
+pub fn current_vcpu_id() -> Option<u32> {
+    // The vCPU IDs are used as CPU IDs, which must be valid CPUs
+    if LIBOS_CONFIG.scheduler.num_of_vcpus > *NCORES {
+        return None;
+    }
+    current_coroutine().map(|coroutine| coroutine.vcpu_id() as u32)
+}
+
+pub fn do_rseq(addr: usize, len: u32, flags: i32, sig: u32) -> Result<isize> {
+    let cpu = match current_vcpu_id() {
+        Some(vcpu_id) => vcpu_id,
+        None => return_errno!(ENOSYS, "rseq is only supported in the M:N mode"),
+    };
+    let current = current!();
+    let mut rseq = current.rseq().lock().unwrap();
+
+    if flags & RSEQ_FLAG_UNREGISTER != 0 {
+        if flags != RSEQ_FLAG_UNREGISTER {
+            return_errno!(EINVAL, "invalid flags");
+        }
+        match &*rseq {
+            Some(registered) if registered.addr == addr && registered.len == len => {
+                if registered.sig != sig {
+                    return_errno!(EPERM, "the signature mismatches");
+                }
+                registered.area()?.cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
+            }
+            _ => return_errno!(EINVAL, "the rseq area is not registered"),
+        }
+        *rseq = None;
+        return Ok(0);
+    }
+
+    if flags != 0 {
+        return_errno!(EINVAL, "invalid flags");
+    }
+    if let Some(registered) = &*rseq {
+        if registered.addr != addr || registered.len != len {
+            return_errno!(EINVAL, "another rseq area is registered");
+        }
+        if registered.sig != sig {
+            return_errno!(EPERM, "the signature mismatches");
+        }
+        return_errno!(EBUSY, "the rseq area is registered");
+    }
+    if addr % ORIG_RSEQ_SIZE as usize != 0 || len < ORIG_RSEQ_SIZE {
+        return_errno!(EINVAL, "invalid rseq area");
+    }
+    check_mut_array(addr as *mut u8, len as usize)?;
+
+    let new_rseq = Rseq { addr, len, sig };
+    let area = new_rseq.area()?;
+    area.cpu_id_start = cpu;
+    area.cpu_id = cpu;
+    *rseq = Some(new_rseq);
+    Ok(0)
+}
+
+/// Abort the critical section of the current thread, if any, as the thread is
+/// interrupted or a signal is delivered. The process is killed if the rseq area or
+/// the critical section is invalid, as Linux does.
+pub fn abort_critical_section(context: &mut CpuContext) {
+    let current = current!();
+    let rseq = current.rseq().lock().unwrap();
+    let ret = match &*rseq {
+        Some(rseq) => rseq.abort_critical_section(context),
+        None => return,
+    };
+    if let Err(e) = ret {
+        warn!("invalid rseq critical section: {}", e.backtrace());
+        current.process().force_exit(TermStatus::Killed(SIGSEGV));
+    }
+}
+
+impl Rseq {
+    fn area(&self) -> Result<&mut RseqArea> {
+        let ptr = self.addr as *mut RseqArea;
+        check_mut_ptr(ptr)?;
+        Ok(unsafe { &mut *ptr })
+    }
+
+    fn abort_critical_section(&self, context: &mut CpuContext) -> Result<()> {
+        let area = self.area()?;
+        if area.rseq_cs == 0 {
+            return Ok(());
+        }
+        let cs = {
+            let ptr = area.rseq_cs as *const RseqCs;
+            check_ptr(ptr)?;
+            unsafe { *ptr }
+        };
+        let end_ip = cs
+            .start_ip
+            .checked_add(cs.post_commit_offset)
+            .ok_or_else(|| errno!(EINVAL, "invalid critical section"))?;
+        if cs.version != 0 || (cs.start_ip..end_ip).contains(&cs.abort_ip) {
+            return_errno!(EINVAL, "invalid critical section");
+        }
+
+        // The descriptor is cleared, as the critical section is either finished or aborted
+        area.rseq_cs = 0;
+        if !(cs.start_ip..end_ip).contains(&context.rip) {
+            return Ok(());
+        }
+
+        let sig = {
+            let ptr = (cs.abort_ip as usize).wrapping_sub(std::mem::size_of::<u32>()) as *const u32;
+            check_ptr(ptr)?;
+            unsafe { ptr.read_unaligned() }
+        };
+        if sig != self.sig {
+            return_errno!(EINVAL, "the signature of abort handler mismatches");
+        }
+        trace!(
+            "abort rseq critical section: ip = {:#x}, abort_ip = {:#x}",
+            context.rip,
+            cs.abort_ip
+        );
+        context.rip = cs.abort_ip;
+        Ok(())
+    }
+}
@@ -81,6 +81,14 @@ pub fn do_getcpu(cpu_ptr: *mut u32, node_ptr: *mut u32) -> Result<isize> {
     Ok(0)
 }
 
+pub fn do_rseq(rseq_ptr: usize, rseq_len: u32, flags: i32, sig: u32) -> Result<isize> {
+    super::rseq::do_rseq(rseq_ptr, rseq_len, flags, sig)
+}
+
+pub fn do_membarrier(cmd: i32, flags: u32, cpu_id: i32) -> Result<isize> {
+    super::do_membarrier::do_membarrier(cmd, flags, cpu_id)
+}
+
 pub fn do_set_priority(which: i32, who: i32, prio: i32) -> Result<isize> {
     let which = PrioWhich::try_from(which)?;
     let prio = NiceValue::from(prio);
@@ -2,6 +2,7 @@
 
 use std::fmt;
 
+use super::constants::{SIGBUS, SIGCHLD, SIGFPE, SIGILL, SIGSEGV, SIGTRAP};
 use super::SigNum;
 use crate::prelude::*;
 use crate::syscall::CpuContext;
@@ -199,6 +200,81 @@ impl siginfo_t {
     }
 }
 
+/// The signal information read from a signalfd
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+pub struct signalfd_siginfo_t {
+    pub ssi_signo: u32,
+    pub ssi_errno: i32,
+    pub ssi_code: i32,
+    pub ssi_pid: u32,
+    pub ssi_uid: u32,
+    pub ssi_fd: i32,
+    pub ssi_tid: u32,
+    pub ssi_band: u32,
+    pub ssi_overrun: u32,
+    pub ssi_trapno: u32,
+    pub ssi_status: i32,
+    pub ssi_int: i32,
+    pub ssi_ptr: u64,
+    pub ssi_utime: u64,
+    pub ssi_stime: u64,
+    pub ssi_addr: u64,
+    pub ssi_addr_lsb: u16,
+    _pad2: u16,
+    pub ssi_syscall: i32,
+    pub ssi_call_addr: u64,
+    pub ssi_arch: u32,
+    _pad: [u8; 28],
+}
+
+impl signalfd_siginfo_t {
+    /// Copy the fields of siginfo_t that are valid for its signal and code.
+    pub fn from_info(info: &siginfo_t) -> Self {
+        let mut ssi: Self = unsafe { std::mem::zeroed() };
+        ssi.ssi_signo = info.si_signo as u32;
+        ssi.ssi_errno = info.si_errno;
+        ssi.ssi_code = info.si_code;
+
+        let signo = info.si_signo as u8;
+        match info.si_code {
+            SI_USER | SI_TKILL => {
+                ssi.ssi_pid = info.si_pid() as u32;
+                ssi.ssi_uid = info.si_uid() as u32;
+            }
+            SI_QUEUE => {
+                ssi.ssi_pid = info.si_pid() as u32;
+                ssi.ssi_uid = info.si_uid() as u32;
+                ssi.ssi_int = unsafe { info.si_value().sigval_int };
+                ssi.ssi_ptr = unsafe { info.si_value().sigval_ptr } as u64;
+            }
+            SI_TIMER => {
+                ssi.ssi_tid = info.si_timerid() as u32;
+                ssi.ssi_overrun = info.si_overrune() as u32;
+                ssi.ssi_int = unsafe { info.si_value().sigval_int };
+                ssi.ssi_ptr = unsafe { info.si_value().sigval_ptr } as u64;
+            }
+            code if code > 0 && signo == SIGCHLD.as_u8() => {
+                ssi.ssi_pid = info.si_pid() as u32;
+                ssi.ssi_uid = info.si_uid() as u32;
+                ssi.ssi_status = info.si_status();
+                ssi.ssi_utime = info.si_utime() as u64;
+                ssi.ssi_stime = info.si_stime() as u64;
+            }
+            code if code > 0
+                && [SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGTRAP]
+                    .iter()
+                    .any(|signum| signum.as_u8() == signo) =>
+            {
+                ssi.ssi_addr = info.si_addr() as u64;
+                ssi.ssi_addr_lsb = info.si_addr_lsb() as u16;
+            }
+            _ => {}
+        }
+        ssi
+    }
+}
+
 #[derive(Clone, Copy)]
 #[repr(C)]
 pub struct ucontext_t {
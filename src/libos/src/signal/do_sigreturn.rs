@@ -88,6 +88,13 @@ fn do_deliver_signal(thread: &ThreadRef, process: &ProcessRef, cpu_context: &mut
             // Dequeue a signal, respecting the signal mask and tmp mask
             let sig_mask =
                 *thread.sig_mask().read().unwrap() | *thread.sig_tmp_mask().read().unwrap();
+            // The blocked signals, e.g., those left for signalfd, are skipped without
+            // taking the write locks
+            let pending = process.sig_queues().read().unwrap().pending()
+                | thread.sig_queues().read().unwrap().pending();
+            if (pending & !sig_mask).empty() {
+                return;
+            }
 
             let signal_opt = process
                 .sig_queues()
@@ -203,6 +210,9 @@ fn handle_signals_by_user(
     new_sigmask: SigSet,
     curr_user_ctxt: &mut CpuContext,
 ) -> Result<()> {
+    // The signal handler returns to the abort handler of the rseq critical section, if any
+    crate::sched::abort_rseq_critical_section(curr_user_ctxt);
+
     let old_sigmask = {
         let mut sigmask = thread.sig_mask().write().unwrap();
         let old_sigmask = *sigmask;
@@ -377,8 +387,14 @@ thread_local! {
     static PRE_UCONTEXTS: RefCell<CpuContextStack> = Default::default();
 }
 
+/// Swap the saved user contexts of the current SGX thread with the given ones, which
+/// is needed when the SGX thread switches between LibOS threads.
+pub fn swap_pre_ucontexts(pre_ucontexts: &mut CpuContextStack) {
+    PRE_UCONTEXTS.with(|ref_cell| std::mem::swap(&mut *ref_cell.borrow_mut(), pre_ucontexts));
+}
+
 #[derive(Debug, Default)]
-struct CpuContextStack {
+pub struct CpuContextStack {
     stack: [Option<*mut ucontext_t>; 32],
     count: usize,
 }
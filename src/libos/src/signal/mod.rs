@@ -4,16 +4,18 @@ use crate::prelude::*;
 
 use sig_action::{SigAction, SigActionFlags, SigDefaultAction};
 
-pub use self::c_types::{sigaction_t, siginfo_t, sigset_t, stack_t};
+pub use self::c_types::{sigaction_t, siginfo_t, signalfd_siginfo_t, sigset_t, sigval_t, stack_t};
 pub use self::constants::*;
 pub use self::do_kill::do_kill_from_outside_enclave;
-pub use self::do_sigreturn::{deliver_signal, force_signal};
+pub use self::do_sigreturn::{deliver_signal, force_signal, swap_pre_ucontexts, CpuContextStack};
 pub use self::sig_dispositions::SigDispositions;
 pub use self::sig_num::SigNum;
 pub use self::sig_queues::SigQueues;
 pub use self::sig_set::SigSet;
 pub use self::sig_stack::SigStack;
-pub use self::signals::{FaultSignal, KernelSignal, Signal, UserSignal, UserSignalKind};
+pub use self::signals::{
+    FaultSignal, KernelSignal, Signal, TimerSignal, UserSignal, UserSignalKind,
+};
 pub use self::syscalls::*;
 
 mod c_types;
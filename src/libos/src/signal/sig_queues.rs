@@ -8,6 +8,8 @@ use crate::prelude::*;
 
 pub struct SigQueues {
     count: usize,
+    // The signals in the queues, which are checked without scanning the queues
+    pending: SigSet,
     std_queues: Vec<Option<Box<dyn Signal>>>,
     rt_queues: Vec<VecDeque<Box<dyn Signal>>>,
     notifier: Notifier<SigNum, SigSet>,
@@ -16,11 +18,13 @@ pub struct SigQueues {
 impl SigQueues {
     pub fn new() -> Self {
         let count = 0;
+        let pending = SigSet::new_empty();
         let std_queues = (0..COUNT_STD_SIGS).map(|_| None).collect();
         let rt_queues = (0..COUNT_RT_SIGS).map(|_| Default::default()).collect();
         let notifier = Notifier::new();
         SigQueues {
             count,
+            pending,
             std_queues,
             rt_queues,
             notifier,
@@ -54,19 +58,21 @@ impl SigQueues {
             }
             *queue = Some(signal);
             self.count += 1;
+            self.pending += signum;
         } else {
             // Real-time signals
             let queue = self.get_rt_queue_mut(signum);
             queue.push_back(signal);
             self.count += 1;
+            self.pending += signum;
         }
 
         self.notifier.broadcast(&signum);
     }
 
     pub fn dequeue(&mut self, blocked: &SigSet) -> Option<Box<dyn Signal>> {
-        // Fast path for the common case of no pending signals
-        if self.empty() {
+        // Fast path for the common case of no pending, unblocked signals
+        if (self.pending & !*blocked).empty() {
             return None;
         }
 
@@ -96,6 +102,7 @@ impl SigQueues {
             let signal = queue.take();
             if signal.is_some() {
                 self.count -= 1;
+                self.pending -= signum;
                 return signal;
             }
         }
@@ -117,6 +124,9 @@ impl SigQueues {
             let queue = self.get_rt_queue_mut(signum);
             let signal = queue.pop_front();
             if signal.is_some() {
+                if queue.is_empty() {
+                    self.pending -= signum;
+                }
                 self.count -= 1;
                 return signal;
             }
@@ -130,35 +140,20 @@ impl SigQueues {
         &self.notifier
     }
 
-    pub fn pending(&self) -> SigSet {
-        let mut pending_sigs = SigSet::new_empty();
-        for signum in MIN_STD_SIG_NUM..=MAX_STD_SIG_NUM {
-            let signum = unsafe { SigNum::from_u8_unchecked(signum) };
-            let queue = self.get_std_queue(signum);
-            if queue.is_some() {
-                pending_sigs += signum;
-            }
-        }
-        for signum in MIN_RT_SIG_NUM..=MAX_RT_SIG_NUM {
-            let signum = unsafe { SigNum::from_u8_unchecked(signum) };
-            let queue = self.get_rt_queue(signum);
-            if !queue.is_empty() {
-                pending_sigs += signum;
+    /// Dequeue at most `max` signals that are not blocked, in the same order as `dequeue`.
+    pub fn dequeue_batch(&mut self, blocked: &SigSet, max: usize) -> Vec<Box<dyn Signal>> {
+        let mut signals = Vec::new();
+        while signals.len() < max {
+            match self.dequeue(blocked) {
+                Some(signal) => signals.push(signal),
+                None => break,
             }
         }
-        pending_sigs
+        signals
     }
 
-    fn get_std_queue(&self, signum: SigNum) -> &Option<Box<dyn Signal>> {
-        debug_assert!(signum.is_std());
-        let idx = (signum.as_u8() - MIN_STD_SIG_NUM) as usize;
-        &self.std_queues[idx]
-    }
-
-    fn get_rt_queue(&self, signum: SigNum) -> &VecDeque<Box<dyn Signal>> {
-        debug_assert!(signum.is_real_time());
-        let idx = (signum.as_u8() - MIN_RT_SIG_NUM) as usize;
-        &self.rt_queues[idx]
+    pub fn pending(&self) -> SigSet {
+        self.pending
     }
 
     fn get_std_queue_mut(&mut self, signum: SigNum) -> &mut Option<Box<dyn Signal>> {
@@ -1,10 +1,12 @@
 /// Implementation of signals generated from various sources.
 mod fault;
 mod kernel;
+mod timer;
 mod user;
 
 pub use self::fault::FaultSignal;
 pub use self::kernel::KernelSignal;
+pub use self::timer::TimerSignal;
 pub use self::user::{UserSignal, UserSignalKind};
 
 use super::c_types::siginfo_t;
@@ -0,0 +1,45 @@
+use super::super::c_types::*;
+use super::super::constants::*;
+use super::super::{SigNum, Signal};
+use crate::prelude::*;
+
+/// A signal sent by the expiration of a POSIX timer
+#[derive(Debug, Copy, Clone)]
+pub struct TimerSignal {
+    num: SigNum,
+    timerid: i32,
+    overrun: i32,
+    value: sigval_t,
+}
+
+unsafe impl Sync for TimerSignal {}
+unsafe impl Send for TimerSignal {}
+
+impl TimerSignal {
+    pub fn new(num: SigNum, timerid: i32, overrun: i32, value: sigval_t) -> Self {
+        Self {
+            num,
+            timerid,
+            overrun,
+            value,
+        }
+    }
+
+    pub fn set_overrun(&mut self, overrun: i32) {
+        self.overrun = overrun;
+    }
+}
+
+impl Signal for TimerSignal {
+    fn num(&self) -> SigNum {
+        self.num
+    }
+
+    fn to_info(&self) -> siginfo_t {
+        let mut info = siginfo_t::new(self.num, SI_TIMER);
+        info.set_si_timerid(self.timerid);
+        info.set_si_overrune(self.overrun);
+        info.set_si_value(self.value);
+        info
+    }
+}
@@ -16,33 +16,39 @@ use std::ffi::{CStr, CString};
 use std::io::{Read, Seek, SeekFrom, Write};
 use std::mem::MaybeUninit;
 use std::ptr;
-use time::{clockid_t, itimerspec_t, timespec_t, timeval_t};
+use time::{clockid_t, itimerspec_t, itimerval_t, sigevent_t, timespec_t, timeval_t};
 use util::log::{self, LevelFilter};
 use util::mem_util::from_user::*;
 
 use crate::config::user_rootfs_config;
 use crate::exception::do_handle_exception;
 use crate::fs::{
-    do_access, do_chdir, do_chmod, do_chown, do_close, do_creat, do_dup, do_dup2, do_dup3,
-    do_eventfd, do_eventfd2, do_faccessat, do_fallocate, do_fchdir, do_fchmod, do_fchmodat,
-    do_fchown, do_fchownat, do_fcntl, do_fdatasync, do_flock, do_fstat, do_fstatat, do_fstatfs,
-    do_fsync, do_ftruncate, do_futimesat, do_getcwd, do_getdents, do_getdents64, do_ioctl,
-    do_lchown, do_link, do_linkat, do_lseek, do_lstat, do_mkdir, do_mkdirat, do_mount,
-    do_mount_rootfs, do_open, do_openat, do_pipe, do_pipe2, do_pread, do_preadv, do_pwrite,
-    do_pwritev, do_read, do_readlink, do_readlinkat, do_readv, do_rename, do_renameat, do_rmdir,
-    do_sendfile, do_stat, do_statfs, do_symlink, do_symlinkat, do_sync, do_timerfd_create,
-    do_timerfd_gettime, do_timerfd_settime, do_truncate, do_umask, do_umount, do_unlink,
-    do_unlinkat, do_utime, do_utimensat, do_utimes, do_write, do_writev, iovec_t, utimbuf_t,
-    AsTimer, File, FileDesc, FileRef, HostStdioFds, Stat, Statfs,
+    aio_context_t, do_access, do_chdir, do_chmod, do_chown, do_close, do_creat, do_dup, do_dup2,
+    do_dup3, do_eventfd, do_eventfd2, do_faccessat, do_fallocate, do_fchdir, do_fchmod,
+    do_fchmodat, do_fchown, do_fchownat, do_fcntl, do_fdatasync, do_flock, do_fstat, do_fstatat,
+    do_fstatfs, do_fsync, do_ftruncate, do_futimesat, do_getcwd, do_getdents, do_getdents64,
+    do_io_cancel, do_io_destroy, do_io_getevents, do_io_setup, do_io_submit, do_io_uring_enter,
+    do_io_uring_setup, do_ioctl, do_lchown, do_link, do_linkat, do_lseek, do_lstat,
+    do_memfd_create, do_mkdir, do_mkdirat, do_mount, do_mount_rootfs, do_open, do_openat, do_pipe,
+    do_pipe2, do_pread, do_preadv, do_pwrite, do_pwritev, do_read, do_readlink, do_readlinkat,
+    do_readv, do_rename, do_renameat, do_rmdir, do_sendfile, do_signalfd, do_signalfd4, do_stat,
+    do_statfs, do_symlink, do_symlinkat, do_sync, do_timerfd_create, do_timerfd_gettime,
+    do_timerfd_settime, do_truncate, do_umask, do_umount, do_unlink, do_unlinkat, do_utime,
+    do_utimensat, do_utimes, do_write, do_writev, io_event_t, io_uring_params, iocb_t, iovec_t,
+    utimbuf_t, AsTimer, File, FileDesc, FileRef, HostStdioFds, Stat, Statfs,
 };
 use crate::interrupt::{do_handle_interrupt, sgx_interrupt_info_t};
-use crate::ipc::{do_shmat, do_shmctl, do_shmdt, do_shmget, key_t, shmids_t};
+use crate::ipc::{
+    do_msgctl, do_msgget, do_msgrcv, do_msgsnd, do_semctl, do_semget, do_semop, do_semtimedop,
+    do_shmat, do_shmctl, do_shmdt, do_shmget, key_t, sembuf, shmids_t,
+};
 use crate::misc::{resource_t, rlimit_t, sysinfo_t, utsname_t, RandFlags};
 use crate::net::{
     do_accept, do_accept4, do_bind, do_connect, do_epoll_create, do_epoll_create1, do_epoll_ctl,
     do_epoll_pwait, do_epoll_wait, do_getpeername, do_getsockname, do_getsockopt, do_listen,
-    do_poll, do_ppoll, do_recvfrom, do_recvmsg, do_select, do_sendmmsg, do_sendmsg, do_sendto,
-    do_setsockopt, do_shutdown, do_socket, do_socketpair, mmsghdr, msghdr, msghdr_mut,
+    do_poll, do_ppoll, do_recvfrom, do_recvmmsg, do_recvmsg, do_select, do_sendmmsg, do_sendmsg,
+    do_sendto, do_setsockopt, do_shutdown, do_socket, do_socketpair, mmsghdr, mmsghdr_mut, msghdr,
+    msghdr_mut,
 };
 use crate::process::{
     do_arch_prctl, do_clone, do_execve, do_exit, do_exit_group, do_futex, do_get_robust_list,
@@ -52,15 +58,15 @@ use crate::process::{
     RobustListHead, SpawnFileActions, ThreadStatus,
 };
 use crate::sched::{
-    do_get_priority, do_getcpu, do_sched_getaffinity, do_sched_setaffinity, do_sched_yield,
-    do_set_priority,
+    do_get_priority, do_getcpu, do_membarrier, do_rseq, do_sched_getaffinity, do_sched_setaffinity,
+    do_sched_yield, do_set_priority,
 };
 use crate::signal::{
     do_kill, do_rt_sigaction, do_rt_sigpending, do_rt_sigprocmask, do_rt_sigreturn,
     do_rt_sigtimedwait, do_sigaltstack, do_tgkill, do_tkill, sigaction_t, siginfo_t, sigset_t,
     stack_t,
 };
-use crate::vm::{MMapFlags, MRemapFlags, MSyncFlags, VMPerms};
+use crate::vm::{MAdvice, MMapFlags, MRemapFlags, MSyncFlags, VMPerms};
 use crate::{fs, process, std, vm};
 
 use super::*;
@@ -122,7 +128,7 @@ macro_rules! process_syscall_table_with_callback {
             (Mremap = 25) => do_mremap(old_addr: usize, old_size: usize, new_size: usize, flags: i32, new_addr: usize),
             (Msync = 26) => do_msync(addr: usize, size: usize, flags: u32),
             (Mincore = 27) => handle_unsupported(),
-            (Madvise = 28) => handle_unsupported(),
+            (Madvise = 28) => do_madvise(addr: usize, size: usize, advice: i32),
             (Shmget = 29) => do_shmget(key: key_t, size: size_t, shmflg: i32),
             (Shmat = 30) => do_shmat(shmid: i32, shmaddr: usize, shmflg: i32),
             (Shmctl = 31) => do_shmctl(shmid: i32, cmd: i32, buf: *mut shmids_t),
@@ -130,9 +136,9 @@ macro_rules! process_syscall_table_with_callback {
             (Dup2 = 33) => do_dup2(old_fd: FileDesc, new_fd: FileDesc),
             (Pause = 34) => handle_unsupported(),
             (Nanosleep = 35) => do_nanosleep(req_u: *const timespec_t, rem_u: *mut timespec_t),
-            (Getitimer = 36) => handle_unsupported(),
-            (Alarm = 37) => handle_unsupported(),
-            (Setitimer = 38) => handle_unsupported(),
+            (Getitimer = 36) => do_getitimer(which: i32, curr_value: *mut itimerval_t),
+            (Alarm = 37) => do_alarm(seconds: u32),
+            (Setitimer = 38) => do_setitimer(which: i32, new_value: *const itimerval_t, old_value: *mut itimerval_t),
             (Getpid = 39) => do_getpid(),
             (Sendfile = 40) => do_sendfile(out_fd: FileDesc, in_fd: FileDesc, offset_ptr: *mut off_t, count: usize),
             (Socket = 41) => do_socket(domain: c_int, socket_type: c_int, protocol: c_int),
@@ -158,14 +164,14 @@ macro_rules! process_syscall_table_with_callback {
             (Wait4 = 61) => do_wait4(pid: i32, _exit_status: *mut i32, options: u32),
             (Kill = 62) => do_kill(pid: i32, sig: c_int),
             (Uname = 63) => do_uname(name: *mut utsname_t),
-            (Semget = 64) => handle_unsupported(),
-            (Semop = 65) => handle_unsupported(),
-            (Semctl = 66) => handle_unsupported(),
+            (Semget = 64) => do_semget(key: key_t, nsems: i32, semflg: i32),
+            (Semop = 65) => do_semop(semid: i32, sops: *const sembuf, nsops: size_t),
+            (Semctl = 66) => do_semctl(semid: i32, semnum: i32, cmd: i32, arg: usize),
             (Shmdt = 67) => do_shmdt(shmaddr: usize),
-            (Msgget = 68) => handle_unsupported(),
-            (Msgsnd = 69) => handle_unsupported(),
-            (Msgrcv = 70) => handle_unsupported(),
-            (Msgctl = 71) => handle_unsupported(),
+            (Msgget = 68) => do_msgget(key: key_t, msgflg: i32),
+            (Msgsnd = 69) => do_msgsnd(msqid: i32, msgp: *const c_void, msgsz: size_t, msgflg: i32),
+            (Msgrcv = 70) => do_msgrcv(msqid: i32, msgp: *mut c_void, msgsz: size_t, msgtyp: i64, msgflg: i32),
+            (Msgctl = 71) => do_msgctl(msqid: i32, cmd: i32, buf: usize),
             (Fcntl = 72) => do_fcntl(fd: FileDesc, cmd: u32, arg: u64),
             (Flock = 73) => do_flock(fd: FileDesc, operation: i32),
             (Fsync = 74) => do_fsync(fd: FileDesc),
@@ -300,11 +306,11 @@ macro_rules! process_syscall_table_with_callback {
             (SchedSetaffinity = 203) => do_sched_setaffinity(pid: pid_t, cpusize: size_t, buf: *const c_uchar),
             (SchedGetaffinity = 204) => do_sched_getaffinity(pid: pid_t, cpusize: size_t, buf: *mut c_uchar),
             (SetThreadArea = 205) => handle_unsupported(),
-            (IoSetup = 206) => handle_unsupported(),
-            (IoDestroy = 207) => handle_unsupported(),
-            (IoGetevents = 208) => handle_unsupported(),
-            (IoSubmit = 209) => handle_unsupported(),
-            (IoCancel = 210) => handle_unsupported(),
+            (IoSetup = 206) => do_io_setup(nr_events: u32, ctx_ptr: *mut aio_context_t),
+            (IoDestroy = 207) => do_io_destroy(ctx: aio_context_t),
+            (IoGetevents = 208) => do_io_getevents(ctx: aio_context_t, min_nr: i64, nr: i64, events_ptr: *mut io_event_t, timeout_ptr: *const timespec_t),
+            (IoSubmit = 209) => do_io_submit(ctx: aio_context_t, nr: i64, iocbs_ptr: *const *const iocb_t),
+            (IoCancel = 210) => do_io_cancel(ctx: aio_context_t, iocb_ptr: *const iocb_t, result_ptr: *mut io_event_t),
             (GetThreadArea = 211) => handle_unsupported(),
             (LookupDcookie = 212) => handle_unsupported(),
             (EpollCreate = 213) => do_epoll_create(size: c_int),
@@ -314,13 +320,13 @@ macro_rules! process_syscall_table_with_callback {
             (Getdents64 = 217) => do_getdents64(fd: FileDesc, buf: *mut u8, buf_size: usize),
             (SetTidAddress = 218) => do_set_tid_address(tidptr: *mut pid_t),
             (RestartSysCall = 219) => handle_unsupported(),
-            (Semtimedop = 220) => handle_unsupported(),
+            (Semtimedop = 220) => do_semtimedop(semid: i32, sops: *const sembuf, nsops: size_t, timeout: *const timespec_t),
             (Fadvise64 = 221) => handle_unsupported(),
-            (TimerCreate = 222) => handle_unsupported(),
-            (TimerSettime = 223) => handle_unsupported(),
-            (TimerGettime = 224) => handle_unsupported(),
-            (TimerGetoverrun = 225) => handle_unsupported(),
-            (TimerDelete = 226) => handle_unsupported(),
+            (TimerCreate = 222) => do_timer_create(clockid: clockid_t, sevp: *const sigevent_t, timerid: *mut i32),
+            (TimerSettime = 223) => do_timer_settime(timerid: i32, flags: i32, new_value: *const itimerspec_t, old_value: *mut itimerspec_t),
+            (TimerGettime = 224) => do_timer_gettime(timerid: i32, curr_value: *mut itimerspec_t),
+            (TimerGetoverrun = 225) => do_timer_getoverrun(timerid: i32),
+            (TimerDelete = 226) => do_timer_delete(timerid: i32),
             (ClockSettime = 227) => handle_unsupported(),
             (ClockGettime = 228) => do_clock_gettime(clockid: clockid_t, ts_u: *mut timespec_t),
             (ClockGetres = 229) => do_clock_getres(clockid: clockid_t, res_u: *mut timespec_t),
@@ -331,9 +337,9 @@ macro_rules! process_syscall_table_with_callback {
             (Tgkill = 234) => do_tgkill(pid: i32, tid: pid_t, sig: c_int),
             (Utimes = 235) => do_utimes(path: *const i8, times: *const timeval_t),
             (Vserver = 236) => handle_unsupported(),
-            (Mbind = 237) => handle_unsupported(),
-            (SetMempolicy = 238) => handle_unsupported(),
-            (GetMempolicy = 239) => handle_unsupported(),
+            (Mbind = 237) => do_mbind(addr: usize, len: usize, mode: i32, nodemask: *const u64, maxnode: u64, flags: u32),
+            (SetMempolicy = 238) => do_set_mempolicy(mode: i32, nodemask: *const u64, maxnode: u64),
+            (GetMempolicy = 239) => do_get_mempolicy(mode: *mut i32, nodemask: *mut u64, maxnode: u64, addr: usize, flags: u32),
             (MqOpen = 240) => handle_unsupported(),
             (MqUnlink = 241) => handle_unsupported(),
             (MqTimedsend = 242) => handle_unsupported(),
@@ -376,14 +382,14 @@ macro_rules! process_syscall_table_with_callback {
             (MovePages = 279) => handle_unsupported(),
             (Utimensat = 280) => do_utimensat(dirfd: i32, path: *const i8, times: *const timespec_t, flags: i32),
             (EpollPwait = 281) => do_epoll_pwait(epfd: c_int, events: *mut libc::epoll_event, maxevents: c_int, timeout: c_int, sigmask: *const usize),
-            (Signalfd = 282) => handle_unsupported(),
+            (Signalfd = 282) => do_signalfd(fd: c_int, mask: *const sigset_t, sizemask: usize),
             (TimerfdCreate = 283) => do_timerfd_create(clockid: clockid_t, flags: i32 ),
             (Eventfd = 284) => do_eventfd(init_val: u32),
             (Fallocate = 285) => do_fallocate(fd: FileDesc, mode: u32, offset: off_t, len: off_t),
             (TimerfdSettime = 286) => do_timerfd_settime(fd: FileDesc, flags: i32, new_value: *const itimerspec_t, old_value: *mut itimerspec_t),
             (TimerfdGettime = 287) => do_timerfd_gettime(fd: FileDesc, curr_value: *mut itimerspec_t),
             (Accept4 = 288) => do_accept4(fd: c_int, addr: *mut libc::sockaddr, addr_len: *mut libc::socklen_t, flags: c_int),
-            (Signalfd4 = 289) => handle_unsupported(),
+            (Signalfd4 = 289) => do_signalfd4(fd: c_int, mask: *const sigset_t, sizemask: usize, flags: i32),
             (Eventfd2 = 290) => do_eventfd2(init_val: u32, flags: i32),
             (EpollCreate1 = 291) => do_epoll_create1(flags: c_int),
             (Dup3 = 292) => do_dup3(old_fd: FileDesc, new_fd: FileDesc, flags: u32),
@@ -393,7 +399,7 @@ macro_rules! process_syscall_table_with_callback {
             (Pwritev = 296) => do_pwritev(fd: FileDesc, iov: *const iovec_t, count: i32, offset: off_t),
             (RtTgsigqueueinfo = 297) => handle_unsupported(),
             (PerfEventOpen = 298) => handle_unsupported(),
-            (Recvmmsg = 299) => handle_unsupported(),
+            (Recvmmsg = 299) => do_recvmmsg(fd: c_int, msg_ptr: *mut mmsghdr_mut, vlen: c_uint, flags_c: c_int, timeout: *mut timespec_t),
             (FanotifyInit = 300) => handle_unsupported(),
             (FanotifyMark = 301) => handle_unsupported(),
             (Prlimit64 = 302) => do_prlimit(pid: pid_t, resource: u32, new_limit: *const rlimit_t, old_limit: *mut rlimit_t),
@@ -404,8 +410,8 @@ macro_rules! process_syscall_table_with_callback {
             (Sendmmsg = 307) => do_sendmmsg(fd: c_int, msg_ptr: *mut mmsghdr, vlen: c_uint, flags_c: c_int),
             (Setns = 308) => handle_unsupported(),
             (Getcpu = 309) => do_getcpu(cpu_ptr: *mut u32, node_ptr: *mut u32),
-            (ProcessVmReadv = 310) => handle_unsupported(),
-            (ProcessVmWritev = 311) => handle_unsupported(),
+            (ProcessVmReadv = 310) => do_process_vm_readv(pid: pid_t, local_iov: *const libc::iovec, liovcnt: u64, remote_iov: *const libc::iovec, riovcnt: u64, flags: u64),
+            (ProcessVmWritev = 311) => do_process_vm_writev(pid: pid_t, local_iov: *const libc::iovec, liovcnt: u64, remote_iov: *const libc::iovec, riovcnt: u64, flags: u64),
             (Kcmp = 312) => handle_unsupported(),
             (FinitModule = 313) => handle_unsupported(),
             (SchedSetattr = 314) => handle_unsupported(),
@@ -413,13 +419,25 @@ macro_rules! process_syscall_table_with_callback {
             (Renameat2 = 316) => handle_unsupported(),
             (Seccomp = 317) => handle_unsupported(),
             (Getrandom = 318) => do_getrandom(buf: *mut u8, len: size_t, flags: u32),
-            (MemfdCreate = 319) => handle_unsupported(),
+            (MemfdCreate = 319) => do_memfd_create(name: *const i8, flags: u32),
             (KexecFileLoad = 320) => handle_unsupported(),
             (Bpf = 321) => handle_unsupported(),
             (Execveat = 322) => handle_unsupported(),
             (Userfaultfd = 323) => handle_unsupported(),
-            (Membarrier = 324) => handle_unsupported(),
+            (Membarrier = 324) => do_membarrier(cmd: i32, flags: u32, cpu_id: i32),
             (Mlock2 = 325) => handle_unsupported(),
+            (CopyFileRange = 326) => handle_unsupported(),
+            (Preadv2 = 327) => handle_unsupported(),
+            (Pwritev2 = 328) => handle_unsupported(),
+            (PkeyMprotect = 329) => handle_unsupported(),
+            (PkeyAlloc = 330) => handle_unsupported(),
+            (PkeyFree = 331) => handle_unsupported(),
+            (Statx = 332) => handle_unsupported(),
+            (IoPgetevents = 333) => handle_unsupported(),
+            (Rseq = 334) => do_rseq(rseq_ptr: usize, rseq_len: u32, flags: i32, sig: u32),
+            (IoUringSetup = 425) => do_io_uring_setup(entries: u32, params_ptr: *mut io_uring_params),
+            (IoUringEnter = 426) => do_io_uring_enter(fd: FileDesc, to_submit: u32, min_complete: u32, flags: u32, sigmask: *const c_void, sigmask_size: size_t),
+            (IoUringRegister = 427) => handle_unsupported(),
 
             // Occlum-specific system calls
             (SpawnGlibc = 359) => do_spawn_for_glibc(child_pid_ptr: *mut u32, path: *const i8, argv: *const *const i8, envp: *const *const i8, fa: *const SpawnFileActions, attribute_list: *const posix_spawnattr_t),
@@ -619,6 +637,8 @@ pub extern "C" fn occlum_syscall(user_context: *mut CpuContext) -> ! {
 }
 
 fn do_syscall(user_context: &mut CpuContext) {
+    current!().enter_libos();
+
     // Extract arguments from the CPU context. The arguments follows Linux's syscall ABI.
     let num = user_context.rax as u32;
     let arg0 = user_context.rdi as isize;
@@ -737,6 +757,8 @@ fn do_syscall(user_context: &mut CpuContext) {
     crate::process::handle_force_stop();
 
     crate::process::handle_force_exit();
+
+    current!().leave_libos();
 }
 
 /// Return to the user space according to the given CPU context
@@ -828,6 +850,64 @@ fn do_msync(addr: usize, size: usize, flags: u32) -> Result<isize> {
     Ok(0)
 }
 
+fn do_madvise(addr: usize, size: usize, advice: i32) -> Result<isize> {
+    let advice = MAdvice::from_i32(advice)?;
+    vm::do_madvise(addr, size, advice)?;
+    Ok(0)
+}
+
+fn do_mbind(
+    addr: usize,
+    len: usize,
+    mode: i32,
+    nodemask: *const u64,
+    maxnode: u64,
+    flags: u32,
+) -> Result<isize> {
+    vm::do_mbind(addr, len, mode, nodemask, maxnode, flags)?;
+    Ok(0)
+}
+
+fn do_process_vm_readv(
+    pid: pid_t,
+    local_iov: *const libc::iovec,
+    liovcnt: u64,
+    remote_iov: *const libc::iovec,
+    riovcnt: u64,
+    flags: u64,
+) -> Result<isize> {
+    let len = vm::do_process_vm_readv(pid, local_iov, liovcnt, remote_iov, riovcnt, flags)?;
+    Ok(len as isize)
+}
+
+fn do_process_vm_writev(
+    pid: pid_t,
+    local_iov: *const libc::iovec,
+    liovcnt: u64,
+    remote_iov: *const libc::iovec,
+    riovcnt: u64,
+    flags: u64,
+) -> Result<isize> {
+    let len = vm::do_process_vm_writev(pid, local_iov, liovcnt, remote_iov, riovcnt, flags)?;
+    Ok(len as isize)
+}
+
+fn do_set_mempolicy(mode: i32, nodemask: *const u64, maxnode: u64) -> Result<isize> {
+    vm::do_set_mempolicy(mode, nodemask, maxnode)?;
+    Ok(0)
+}
+
+fn do_get_mempolicy(
+    mode: *mut i32,
+    nodemask: *mut u64,
+    maxnode: u64,
+    addr: usize,
+    flags: u32,
+) -> Result<isize> {
+    vm::do_get_mempolicy(mode, nodemask, maxnode, addr, flags)?;
+    Ok(0)
+}
+
 fn do_sysinfo(info: *mut sysinfo_t) -> Result<isize> {
     check_mut_ptr(info)?;
     let info = unsafe { &mut *info };
@@ -880,6 +960,105 @@ fn do_time(tloc_u: *mut time_t) -> Result<isize> {
     Ok(ts.sec() as isize)
 }
 
+fn do_getitimer(which: i32, curr_value_u: *mut itimerval_t) -> Result<isize> {
+    check_mut_ptr(curr_value_u)?;
+    let curr_value = time::do_getitimer(which)?;
+    unsafe {
+        *curr_value_u = curr_value;
+    }
+    Ok(0)
+}
+
+fn do_setitimer(
+    which: i32,
+    new_value_u: *const itimerval_t,
+    old_value_u: *mut itimerval_t,
+) -> Result<isize> {
+    // A null new value disarms the timer, as Linux does
+    let new_value = if !new_value_u.is_null() {
+        check_ptr(new_value_u)?;
+        itimerval_t::from_raw_ptr(new_value_u)?
+    } else {
+        Default::default()
+    };
+    if !old_value_u.is_null() {
+        check_mut_ptr(old_value_u)?;
+    }
+    let old_value = time::do_setitimer(which, &new_value)?;
+    if !old_value_u.is_null() {
+        unsafe {
+            *old_value_u = old_value;
+        }
+    }
+    Ok(0)
+}
+
+fn do_alarm(seconds: u32) -> Result<isize> {
+    let remaining = time::do_alarm(seconds)?;
+    Ok(remaining as isize)
+}
+
+fn do_timer_create(
+    clockid: clockid_t,
+    sevp_u: *const sigevent_t,
+    timerid_u: *mut i32,
+) -> Result<isize> {
+    let clockid = time::ClockID::from_raw(clockid)?;
+    let sigevent = if !sevp_u.is_null() {
+        check_ptr(sevp_u)?;
+        Some(unsafe { &*sevp_u })
+    } else {
+        None
+    };
+    check_mut_ptr(timerid_u)?;
+    let timerid = time::do_timer_create(clockid, sigevent)?;
+    unsafe {
+        *timerid_u = timerid;
+    }
+    Ok(0)
+}
+
+fn do_timer_settime(
+    timerid: i32,
+    flags: i32,
+    new_value_u: *const itimerspec_t,
+    old_value_u: *mut itimerspec_t,
+) -> Result<isize> {
+    let new_value = {
+        check_ptr(new_value_u)?;
+        itimerspec_t::from_raw_ptr(new_value_u)?
+    };
+    if !old_value_u.is_null() {
+        check_mut_ptr(old_value_u)?;
+    }
+    let old_value = time::do_timer_settime(timerid, flags, &new_value)?;
+    if !old_value_u.is_null() {
+        unsafe {
+            *old_value_u = old_value;
+        }
+    }
+    Ok(0)
+}
+
+fn do_timer_gettime(timerid: i32, curr_value_u: *mut itimerspec_t) -> Result<isize> {
+    check_mut_ptr(curr_value_u)?;
+    let curr_value = time::do_timer_gettime(timerid)?;
+    unsafe {
+        *curr_value_u = curr_value;
+    }
+    Ok(0)
+}
+
+fn do_timer_getoverrun(timerid: i32) -> Result<isize> {
+    let overrun = time::do_timer_getoverrun(timerid)?;
+    Ok(overrun as isize)
+}
+
+fn do_timer_delete(timerid: i32) -> Result<isize> {
+    time::do_timer_delete(timerid)?;
+    Ok(0)
+}
+
 fn do_clock_getres(clockid: clockid_t, res_u: *mut timespec_t) -> Result<isize> {
     if res_u.is_null() {
         return Ok(0);
@@ -1,19 +1,28 @@
 use self::timer_slack::*;
 use super::*;
 use core::convert::TryFrom;
+use events::Waiter;
 use process::pid_t;
+use process::task::current_coroutine;
 use rcore_fs::dev::TimeProvider;
 use rcore_fs::vfs::Timespec;
 use std::time::Duration;
 use std::{fmt, u64};
 use syscall::SyscallNum;
 
+mod posix_timer;
 mod profiler;
 pub mod timer_slack;
+pub mod timer_wheel;
 pub mod up_time;
 
+pub use posix_timer::{
+    do_alarm, do_getitimer, do_setitimer, do_timer_create, do_timer_delete, do_timer_getoverrun,
+    do_timer_gettime, do_timer_settime, sigevent_t, ProcessTimers,
+};
 pub use profiler::ThreadProfiler;
 pub use timer_slack::TIMERSLACK;
+pub use timer_wheel::Timer;
 
 #[allow(non_camel_case_types)]
 pub type time_t = i64;
@@ -246,6 +255,15 @@ pub fn do_clock_nanosleep(
             return_errno!(EOPNOTSUPP, "does not support sleeping against this clockid");
         }
     }
+    // In the M:N mode, a thread must not sleep in the host, or it would block its vCPU.
+    // The CPU time of the process does not advance as the time of a timer does, so an
+    // absolute sleep against it is still left to the host.
+    let is_cputime_deadline =
+        flags == TIMER_ABSTIME && matches!(clockid, ClockID::CLOCK_PROCESS_CPUTIME_ID);
+    if current_coroutine().is_some() && !is_cputime_deadline {
+        return do_clock_nanosleep_parked(clockid, flags, req, rem);
+    }
+
     let sgx_status = unsafe {
         occlum_ocall_clock_nanosleep(&mut ret, clockid as clockid_t, flags, req, &mut u_rem)
     };
@@ -264,6 +282,39 @@ pub fn do_clock_nanosleep(
     return Ok(());
 }
 
+// Sleep by parking the coroutine of the current thread
+fn do_clock_nanosleep_parked(
+    clockid: ClockID,
+    flags: i32,
+    req: &timespec_t,
+    rem: Option<&mut timespec_t>,
+) -> Result<()> {
+    let mut remain = if flags == TIMER_ABSTIME {
+        let now = do_clock_gettime(clockid)?.as_duration();
+        req.as_duration().checked_sub(now).unwrap_or_default()
+    } else {
+        req.as_duration()
+    };
+    if remain == Duration::from_secs(0) {
+        return Ok(());
+    }
+
+    // Nobody wakes up the waiter, so it returns only when timeout or interrupted
+    match Waiter::new().wait_mut(Some(&mut remain)) {
+        Err(e) if e.errno() == EINTR => {
+            // rem is only valid if TIMER_ABSTIME flag is not set
+            if flags != TIMER_ABSTIME {
+                if let Some(rem) = rem {
+                    *rem = timespec_t::from(remain);
+                }
+            }
+            return_errno!(EINTR, "sleep interrupted");
+        }
+        Err(e) if e.errno() != ETIMEDOUT => Err(e),
+        _ => Ok(()),
+    }
+}
+
 pub fn do_nanosleep(req: &timespec_t, rem: Option<&mut timespec_t>) -> Result<()> {
     // POSIX.1 specifies that nanosleep() should measure time against
     // the CLOCK_REALTIME clock.  However, Linux measures the time using
@@ -313,7 +364,7 @@ impl TimeProvider for OcclumTimeProvider {
     }
 }
 
-// For Timerfd
+// For timerfd and POSIX timers
 #[repr(C)]
 #[derive(Debug, Default, Copy, Clone)]
 #[allow(non_camel_case_types)]
@@ -323,6 +374,13 @@ pub struct itimerspec_t {
 }
 
 impl itimerspec_t {
+    pub fn new(it_interval: timespec_t, it_value: timespec_t) -> Self {
+        Self {
+            it_interval,
+            it_value,
+        }
+    }
+
     pub fn from_raw_ptr(ptr: *const itimerspec_t) -> Result<itimerspec_t> {
         let its = unsafe { *ptr };
         its.validate()?;
@@ -333,4 +391,50 @@ impl itimerspec_t {
         self.it_value.validate()?;
         Ok(())
     }
+
+    pub fn it_interval(&self) -> &timespec_t {
+        &self.it_interval
+    }
+
+    pub fn it_value(&self) -> &timespec_t {
+        &self.it_value
+    }
+}
+
+// For setitimer and getitimer
+#[repr(C)]
+#[derive(Debug, Default, Copy, Clone)]
+#[allow(non_camel_case_types)]
+pub struct itimerval_t {
+    it_interval: timeval_t,
+    it_value: timeval_t,
+}
+
+impl itimerval_t {
+    pub fn new(it_interval: timeval_t, it_value: timeval_t) -> Self {
+        Self {
+            it_interval,
+            it_value,
+        }
+    }
+
+    pub fn from_raw_ptr(ptr: *const itimerval_t) -> Result<itimerval_t> {
+        let itv = unsafe { *ptr };
+        itv.validate()?;
+        Ok(itv)
+    }
+
+    pub fn validate(&self) -> Result<()> {
+        self.it_interval.validate()?;
+        self.it_value.validate()?;
+        Ok(())
+    }
+
+    pub fn it_interval(&self) -> &timeval_t {
+        &self.it_interval
+    }
+
+    pub fn it_value(&self) -> &timeval_t {
+        &self.it_value
+    }
 }
@@ -0,0 +1,281 @@
+//! POSIX timers and interval timers of processes.
+//!
+//! Both are timers on the timer wheel, which send signals to their processes, or to
+//! threads for the POSIX timers with `SIGEV_THREAD_ID`, when they expire.
+//!
+//! The enclave cannot tell how much CPU time a process consumes, so `ITIMER_VIRTUAL`,
+//! `ITIMER_PROF` and the timers of the CPU-time clocks count the real time instead.
+
+use super::timer_wheel::{interrupt_after_batch, Timer};
+use super::*;
+use crate::process::{table, Process};
+use crate::signal::{
+    sigval_t, KernelSignal, SigNum, Signal, TimerSignal, SIGALRM, SIGPROF, SIGVTALRM,
+};
+use std::sync::atomic::{AtomicI32, Ordering};
+use std::sync::Weak;
+
+const SIGEV_SIGNAL: i32 = 0;
+const SIGEV_NONE: i32 = 1;
+const SIGEV_THREAD_ID: i32 = 4;
+
+const TIMER_ABSTIME: i32 = 0x01;
+
+const ITIMER_REAL: i32 = 0;
+const ITIMER_VIRTUAL: i32 = 1;
+const ITIMER_PROF: i32 = 2;
+const NUM_ITIMERS: usize = 3;
+
+// The max number of POSIX timers of a process
+const MAX_NUM_TIMERS: usize = 32768;
+
+/// The notification of a POSIX timer, i.e., `struct sigevent` of Linux
+#[repr(C)]
+#[derive(Clone, Copy)]
+#[allow(non_camel_case_types)]
+pub struct sigevent_t {
+    sigev_value: sigval_t,
+    sigev_signo: i32,
+    sigev_notify: i32,
+    sigev_tid: i32,
+    _pad: [i32; 11],
+}
+
+/// The timers of a process
+pub struct ProcessTimers {
+    itimers: Vec<Option<Timer>>,
+    posix_timers: HashMap<i32, PosixTimer>,
+    next_id: i32,
+}
+
+struct PosixTimer {
+    timer: Timer,
+    clockid: ClockID,
+    // The number of extra expirations of the last expiration
+    overrun: Arc<AtomicI32>,
+}
+
+impl ProcessTimers {
+    pub fn new() -> Self {
+        Self {
+            itimers: (0..NUM_ITIMERS).map(|_| None).collect(),
+            posix_timers: HashMap::new(),
+            next_id: 0,
+        }
+    }
+
+    /// Delete all the timers, as the process exits
+    pub fn clear(&mut self) {
+        self.itimers.iter_mut().for_each(|itimer| *itimer = None);
+        self.posix_timers.clear();
+    }
+
+    fn find(&self, id: i32) -> Result<&PosixTimer> {
+        self.posix_timers
+            .get(&id)
+            .ok_or_else(|| errno!(EINVAL, "the timer does not exist"))
+    }
+}
+
+// The target of the signals of a timer
+enum SignalTarget {
+    Process(Weak<Process>),
+    Thread(pid_t),
+}
+
+impl SignalTarget {
+    fn send(&self, signal: Box<dyn Signal>) {
+        match self {
+            Self::Process(process) => {
+                if let Some(process) = process.upgrade() {
+                    process.sig_queues().write().unwrap().enqueue(signal);
+                }
+            }
+            Self::Thread(tid) => {
+                if let Ok(thread) = table::get_thread(*tid) {
+                    thread.sig_queues().write().unwrap().enqueue(signal);
+                }
+            }
+        }
+        interrupt_after_batch();
+    }
+}
+
+pub fn do_timer_create(clockid: ClockID, sigevent: Option<&sigevent_t>) -> Result<i32> {
+    debug!("timer_create: clockid: {:?}", clockid);
+    match clockid {
+        ClockID::CLOCK_REALTIME
+        | ClockID::CLOCK_MONOTONIC
+        | ClockID::CLOCK_BOOTTIME
+        | ClockID::CLOCK_PROCESS_CPUTIME_ID
+        | ClockID::CLOCK_THREAD_CPUTIME_ID => {}
+        _ => return_errno!(EINVAL, "the clock is not supported"),
+    }
+
+    let current = current!();
+    let process = current.process();
+    let mut timers = process.timers().lock().unwrap();
+    if timers.posix_timers.len() >= MAX_NUM_TIMERS {
+        return_errno!(EAGAIN, "too many timers");
+    }
+    let id = timers.next_id;
+    timers.next_id = id
+        .checked_add(1)
+        .ok_or_else(|| errno!(EAGAIN, "no timer ID is available"))?;
+
+    // By default, the timer sends SIGALRM with the timer ID to the process
+    let (target, signum, value) = match sigevent {
+        None => (
+            Some(SignalTarget::Process(Arc::downgrade(process))),
+            SIGALRM,
+            sigval_t::from(id),
+        ),
+        Some(sigevent) => {
+            let target = match sigevent.sigev_notify {
+                SIGEV_NONE => None,
+                SIGEV_SIGNAL => Some(SignalTarget::Process(Arc::downgrade(process))),
+                SIGEV_THREAD_ID => {
+                    let thread = table::get_thread(sigevent.sigev_tid)
+                        .map_err(|_| errno!(EINVAL, "the thread does not exist"))?;
+                    if thread.process().pid() != process.pid() {
+                        return_errno!(EINVAL, "the thread is not in the current process");
+                    }
+                    Some(SignalTarget::Thread(sigevent.sigev_tid))
+                }
+                _ => return_errno!(EINVAL, "the notification is not supported"),
+            };
+            let signum = if target.is_some() {
+                if sigevent.sigev_signo <= 0 || sigevent.sigev_signo > u8::MAX as i32 {
+                    return_errno!(EINVAL, "invalid signal");
+                }
+                SigNum::from_u8(sigevent.sigev_signo as u8)?
+            } else {
+                SIGALRM
+            };
+            (target, signum, sigevent.sigev_value)
+        }
+    };
+
+    let overrun = Arc::new(AtomicI32::new(0));
+    let timer = {
+        let overrun = overrun.clone();
+        let signal = TimerSignal::new(signum, id, 0, value);
+        Timer::new(move |expirations| {
+            let extra = min(expirations - 1, i32::MAX as u64) as i32;
+            overrun.store(extra, Ordering::Relaxed);
+            if let Some(target) = &target {
+                let mut signal = signal;
+                signal.set_overrun(extra);
+                target.send(Box::new(signal));
+            }
+        })
+    };
+    timers.posix_timers.insert(
+        id,
+        PosixTimer {
+            timer,
+            clockid,
+            overrun,
+        },
+    );
+    Ok(id)
+}
+
+pub fn do_timer_settime(id: i32, flags: i32, new_value: &itimerspec_t) -> Result<itimerspec_t> {
+    if flags & !TIMER_ABSTIME != 0 {
+        return_errno!(EINVAL, "invalid flags");
+    }
+    let current = current!();
+    let timers = current.process().timers().lock().unwrap();
+    let posix_timer = timers.find(id)?;
+    let (value, interval) = posix_timer.timer.set(
+        posix_timer.clockid,
+        flags & TIMER_ABSTIME != 0,
+        new_value.it_value().as_duration(),
+        new_value.it_interval().as_duration(),
+    )?;
+    Ok(itimerspec_t::new(interval.into(), value.into()))
+}
+
+pub fn do_timer_gettime(id: i32) -> Result<itimerspec_t> {
+    let current = current!();
+    let timers = current.process().timers().lock().unwrap();
+    let (value, interval) = timers.find(id)?.timer.get();
+    Ok(itimerspec_t::new(interval.into(), value.into()))
+}
+
+pub fn do_timer_getoverrun(id: i32) -> Result<i32> {
+    let current = current!();
+    let timers = current.process().timers().lock().unwrap();
+    Ok(timers.find(id)?.overrun.load(Ordering::Relaxed))
+}
+
+pub fn do_timer_delete(id: i32) -> Result<()> {
+    let current = current!();
+    let mut timers = current.process().timers().lock().unwrap();
+    timers
+        .posix_timers
+        .remove(&id)
+        .ok_or_else(|| errno!(EINVAL, "the timer does not exist"))?;
+    Ok(())
+}
+
+pub fn do_setitimer(which: i32, new_value: &itimerval_t) -> Result<itimerval_t> {
+    let signum = match which {
+        ITIMER_REAL => SIGALRM,
+        ITIMER_VIRTUAL => SIGVTALRM,
+        ITIMER_PROF => SIGPROF,
+        _ => return_errno!(EINVAL, "invalid timer"),
+    };
+    let current = current!();
+    let process = current.process();
+    let mut timers = process.timers().lock().unwrap();
+    let itimer = timers.itimers[which as usize].get_or_insert_with(|| {
+        let target = SignalTarget::Process(Arc::downgrade(process));
+        Timer::new(move |_| target.send(Box::new(KernelSignal::new(signum))))
+    });
+    let (value, interval) = itimer.set(
+        ClockID::CLOCK_MONOTONIC,
+        false,
+        new_value.it_value().as_duration(),
+        new_value.it_interval().as_duration(),
+    )?;
+    Ok(to_itimerval(value, interval))
+}
+
+pub fn do_getitimer(which: i32) -> Result<itimerval_t> {
+    if which < 0 || which as usize >= NUM_ITIMERS {
+        return_errno!(EINVAL, "invalid timer");
+    }
+    let current = current!();
+    let timers = current.process().timers().lock().unwrap();
+    let (value, interval) = match &timers.itimers[which as usize] {
+        Some(itimer) => itimer.get(),
+        None => Default::default(),
+    };
+    Ok(to_itimerval(value, interval))
+}
+
+/// Arm the `ITIMER_REAL` timer to expire after the seconds, or disarm it if the
+/// seconds is zero. Return the seconds remaining of the previous alarm.
+pub fn do_alarm(seconds: u32) -> Result<u32> {
+    let new_value = itimerval_t::new(Default::default(), timeval_t::new(seconds as time_t, 0));
+    let old_value = do_setitimer(ITIMER_REAL, &new_value)?;
+    // Round to the nearest second, but an alarm pending is never reported as zero
+    let old_value = old_value.it_value();
+    let mut remaining = old_value.sec() as u32;
+    if (remaining == 0 && old_value.usec() > 0) || old_value.usec() >= 500_000 {
+        remaining += 1;
+    }
+    Ok(remaining)
+}
+
+// An armed timer is never reported as zero in microseconds
+fn to_itimerval(value: Duration, interval: Duration) -> itimerval_t {
+    let value = if value > Duration::from_secs(0) {
+        max(value, Duration::from_micros(1))
+    } else {
+        value
+    };
+    itimerval_t::new(interval.into(), value.into())
+}
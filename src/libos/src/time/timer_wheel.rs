@@ -0,0 +1,462 @@
+//! A hierarchical timing wheel, on which all the timers of the LibOS are armed.
+//!
+//! POSIX timers, interval timers and timerfds are timers on the wheel, so arming and
+//! cancelling a timer are done inside the enclave in O(1), without any host timer. The
+//! wheel is driven by the timer thread of the PAL, which enters the enclave to run the
+//! expired timers in batch, and then sleeps on an eventfd of the PAL until the next
+//! timer expires. The eventfd is written to wake up the thread when an earlier timer is
+//! armed, or by the PAL to stop the thread.
+//!
+//! The wheel has 4 levels of 64 slots, and the tick is 1ms. A timer is put into the
+//! lowest level whose range covers its deadline, and is moved down level by level as
+//! the time goes on. The timers beyond the range of the top level (~4.6 hours) are kept
+//! in an overflow list. Cancelling a timer only marks its entry on the wheel as stale,
+//! which is dropped when its slot is processed.
+//!
+//! The timer thread also keeps a coarse realtime clock in seconds, which is read
+//! without any OCall. While the clock is used, the timer thread wakes up at least once
+//! a second to refresh it.
+
+use super::{do_clock_gettime, do_gettimeofday, time_t, ClockID};
+use crate::events::HostEventFd;
+use crate::prelude::*;
+use std::sync::atomic::{AtomicBool, AtomicI32, AtomicI64, AtomicU64, Ordering};
+use std::time::Duration;
+
+const TICK_NS: u64 = 1_000_000;
+const SLOT_BITS: u32 = 6;
+const NUM_SLOTS: usize = 1 << SLOT_BITS;
+const NUM_LEVELS: usize = 4;
+// The interval to refresh the coarse clock
+const COARSE_TICKS: u64 = 1000;
+
+lazy_static! {
+    static ref WHEEL: SgxMutex<TimerWheel> = SgxMutex::new(TimerWheel::new());
+    static ref START_TIME: Duration = monotonic_now();
+}
+
+// The host eventfd on which the timer thread sleeps, which is given by the PAL
+static WAKEUP_FD: AtomicI32 = AtomicI32::new(-1);
+
+// Whether the timers fired in the current batch have sent signals
+static HAS_SENT_SIGNALS: AtomicBool = AtomicBool::new(false);
+
+// The coarse realtime clock in seconds, which is refreshed by the timer thread
+static COARSE_SECS: AtomicI64 = AtomicI64::new(0);
+// Whether the coarse clock is read since the last run of the timer thread
+static COARSE_USED: AtomicBool = AtomicBool::new(false);
+// Whether the timer thread refreshes the coarse clock at least once a second
+static COARSE_TICKING: AtomicBool = AtomicBool::new(false);
+
+/// A timer on the timer wheel, which is cancelled when dropped.
+///
+/// When the timer expires, its callback is called in the timer thread with the number
+/// of expirations since the last call, which is greater than one if the timer is
+/// periodic and the timer thread is late. The callback must not block.
+pub struct Timer {
+    core: Arc<TimerCore>,
+}
+
+struct TimerCore {
+    state: SgxMutex<TimerState>,
+    // Bumped whenever the timer is armed or disarmed, so the entries of the previous
+    // arming on the wheel become stale. It is only changed with the state locked.
+    seq: AtomicU64,
+    callback: Box<dyn Fn(u64) + Send + Sync>,
+}
+
+#[derive(Default)]
+struct TimerState {
+    // The monotonic time of the next expiration if the timer is armed
+    deadline: Option<Duration>,
+    interval: Duration,
+}
+
+struct Entry {
+    core: Arc<TimerCore>,
+    seq: u64,
+    tick: u64,
+}
+
+impl Timer {
+    pub fn new<F: Fn(u64) + Send + Sync + 'static>(callback: F) -> Self {
+        let core = Arc::new(TimerCore {
+            state: SgxMutex::new(TimerState::default()),
+            seq: AtomicU64::new(0),
+            callback: Box::new(callback),
+        });
+        Self { core }
+    }
+
+    /// Arm the timer to expire after `value`, or at `value` of the clock if `is_abs`,
+    /// and then every `interval` if it is not zero. A zero `value` disarms the timer.
+    ///
+    /// Return the old setting as `get` does.
+    ///
+    /// The absolute time of the real-time clock is converted to the monotonic time
+    /// when the timer is armed, so the changes of the host clock afterwards are not
+    /// followed. The CPU-time clocks are approximated with the monotonic clock.
+    pub fn set(
+        &self,
+        clockid: ClockID,
+        is_abs: bool,
+        value: Duration,
+        interval: Duration,
+    ) -> Result<(Duration, Duration)> {
+        let now = monotonic_now();
+        let deadline = if value == Duration::from_secs(0) {
+            None
+        } else if !is_abs {
+            Some(now + value)
+        } else {
+            Some(match clockid {
+                ClockID::CLOCK_REALTIME | ClockID::CLOCK_REALTIME_COARSE => {
+                    let realtime_now = do_clock_gettime(clockid)?.as_duration();
+                    now + value.checked_sub(realtime_now).unwrap_or_default()
+                }
+                ClockID::CLOCK_PROCESS_CPUTIME_ID | ClockID::CLOCK_THREAD_CPUTIME_ID => {
+                    return_errno!(EINVAL, "absolute CPU time is not supported");
+                }
+                _ => value,
+            })
+        };
+
+        let mut state = self.core.state.lock().unwrap();
+        let old = state.setting(now);
+        state.interval = interval;
+        let should_wake = match deadline {
+            Some(deadline) => self.core.arm(&mut state, deadline),
+            None => {
+                self.core.disarm(&mut state);
+                false
+            }
+        };
+        drop(state);
+
+        if should_wake {
+            wake_up_timer_thread();
+        }
+        Ok(old)
+    }
+
+    /// Get the setting of the timer as (the time until the next expiration, the
+    /// interval). The time until the next expiration is zero if the timer is disarmed.
+    pub fn get(&self) -> (Duration, Duration) {
+        let now = monotonic_now();
+        self.core.state.lock().unwrap().setting(now)
+    }
+}
+
+impl Drop for Timer {
+    fn drop(&mut self) {
+        let mut state = self.core.state.lock().unwrap();
+        self.core.disarm(&mut state);
+    }
+}
+
+impl std::fmt::Debug for Timer {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        let state = self.core.state.lock().unwrap();
+        f.debug_struct("Timer")
+            .field("deadline", &state.deadline)
+            .field("interval", &state.interval)
+            .finish()
+    }
+}
+
+impl TimerCore {
+    // Put a new entry of the timer on the wheel. Return whether the timer thread
+    // should be woken up.
+    fn arm(self: &Arc<Self>, state: &mut TimerState, deadline: Duration) -> bool {
+        state.deadline = Some(deadline);
+        let seq = self.seq.fetch_add(1, Ordering::SeqCst) + 1;
+        let entry = Entry {
+            core: self.clone(),
+            seq,
+            tick: tick_of_deadline(deadline),
+        };
+        WHEEL.lock().unwrap().insert(entry)
+    }
+
+    fn disarm(&self, state: &mut TimerState) {
+        if state.deadline.take().is_some() {
+            self.seq.fetch_add(1, Ordering::SeqCst);
+        }
+    }
+
+    // Run the callback if the entry is not stale, and re-arm the timer if it is
+    // periodic. Return whether the callback is called.
+    fn fire(self: &Arc<Self>, seq: u64, now: Duration) -> bool {
+        let expirations = {
+            let mut state = self.state.lock().unwrap();
+            if self.seq.load(Ordering::SeqCst) != seq {
+                return false;
+            }
+            let deadline = state.deadline.unwrap();
+            if state.interval == Duration::from_secs(0) {
+                self.disarm(&mut state);
+                1
+            } else {
+                let interval_ns = state.interval.as_nanos();
+                let late_ns = now.checked_sub(deadline).unwrap_or_default().as_nanos();
+                let expirations = 1 + late_ns / interval_ns;
+                let next_deadline_ns = deadline.as_nanos() + expirations * interval_ns;
+                let next_deadline = Duration::new(
+                    (next_deadline_ns / 1_000_000_000) as u64,
+                    (next_deadline_ns % 1_000_000_000) as u32,
+                );
+                // The timer thread is running, so there is no need to wake it up
+                self.arm(&mut state, next_deadline);
+                expirations as u64
+            }
+        };
+        (self.callback)(expirations);
+        true
+    }
+}
+
+impl TimerState {
+    fn setting(&self, now: Duration) -> (Duration, Duration) {
+        let remaining = match self.deadline {
+            // An expired timer that is not run yet is reported as expiring soon
+            Some(deadline) => max(
+                deadline.checked_sub(now).unwrap_or_default(),
+                Duration::from_nanos(1),
+            ),
+            None => Duration::from_secs(0),
+        };
+        (remaining, self.interval)
+    }
+}
+
+impl Entry {
+    fn is_stale(&self) -> bool {
+        self.core.seq.load(Ordering::SeqCst) != self.seq
+    }
+}
+
+struct TimerWheel {
+    // The next tick to process
+    curr_tick: u64,
+    // Indexed by level and then slot
+    levels: Vec<Vec<Vec<Entry>>>,
+    overflow: Vec<Entry>,
+    // The number of entries on the wheel, including the stale ones
+    len: usize,
+    // The tick at which the timer thread wakes up, zero if it is running, or u64::MAX
+    // if it sleeps until woken up
+    wakeup_tick: u64,
+}
+
+impl TimerWheel {
+    fn new() -> Self {
+        let levels = (0..NUM_LEVELS)
+            .map(|_| (0..NUM_SLOTS).map(|_| Vec::new()).collect())
+            .collect();
+        Self {
+            curr_tick: 0,
+            levels,
+            overflow: Vec::new(),
+            len: 0,
+            wakeup_tick: 0,
+        }
+    }
+
+    // Return whether the entry is earlier than the wakeup of the timer thread
+    fn insert(&mut self, mut entry: Entry) -> bool {
+        entry.tick = max(entry.tick, self.curr_tick);
+        let is_earlier = entry.tick < self.wakeup_tick;
+        if is_earlier {
+            self.wakeup_tick = entry.tick;
+        }
+        self.len += 1;
+        self.place(entry);
+        is_earlier
+    }
+
+    fn place(&mut self, entry: Entry) {
+        for level in 0..NUM_LEVELS {
+            let shift = SLOT_BITS * (level as u32 + 1);
+            if entry.tick >> shift == self.curr_tick >> shift {
+                let slot = slot_of(entry.tick, level);
+                self.levels[level][slot].push(entry);
+                return;
+            }
+        }
+        self.overflow.push(entry);
+    }
+
+    // Process the ticks up to `now_tick`, and return the live entries expired
+    fn advance(&mut self, now_tick: u64) -> Vec<Entry> {
+        let mut expired = Vec::new();
+        while self.curr_tick <= now_tick {
+            if self.len == 0 {
+                self.curr_tick = now_tick + 1;
+                break;
+            }
+            self.cascade();
+            let slot = slot_of(self.curr_tick, 0);
+            let entries = std::mem::take(&mut self.levels[0][slot]);
+            self.len -= entries.len();
+            expired.extend(entries.into_iter().filter(|entry| !entry.is_stale()));
+            self.curr_tick += 1;
+        }
+        expired
+    }
+
+    // Move the entries of the higher levels, which are due in the range of the lower
+    // levels starting from the current tick, down to the lower levels
+    fn cascade(&mut self) {
+        let tick = self.curr_tick;
+        if slot_of(tick, 0) != 0 {
+            return;
+        }
+        let mut top_level = 1;
+        while top_level < NUM_LEVELS && slot_of(tick, top_level) == 0 {
+            top_level += 1;
+        }
+        if top_level == NUM_LEVELS {
+            let entries = std::mem::take(&mut self.overflow);
+            self.replace(entries);
+            top_level -= 1;
+        }
+        for level in (1..=top_level).rev() {
+            let slot = slot_of(tick, level);
+            let entries = std::mem::take(&mut self.levels[level][slot]);
+            self.replace(entries);
+        }
+    }
+
+    fn replace(&mut self, entries: Vec<Entry>) {
+        for entry in entries {
+            if entry.is_stale() {
+                self.len -= 1;
+            } else {
+                self.place(entry);
+            }
+        }
+    }
+
+    // The earliest tick at which some entries may expire or cascade
+    fn next_tick(&self) -> Option<u64> {
+        if self.len == 0 {
+            return None;
+        }
+        for level in 0..NUM_LEVELS {
+            let shift = SLOT_BITS * level as u32;
+            let curr_slot = slot_of(self.curr_tick, level);
+            // The current slot of a higher level is already cascaded
+            let first_slot = if level == 0 { curr_slot } else { curr_slot + 1 };
+            let base = self.curr_tick >> (shift + SLOT_BITS) << (shift + SLOT_BITS);
+            if let Some(slot) =
+                (first_slot..NUM_SLOTS).find(|&slot| !self.levels[level][slot].is_empty())
+            {
+                return Some(base + ((slot as u64) << shift));
+            }
+        }
+        let top_shift = SLOT_BITS * NUM_LEVELS as u32;
+        Some(((self.curr_tick >> top_shift) + 1) << top_shift)
+    }
+}
+
+fn slot_of(tick: u64, level: usize) -> usize {
+    (tick >> (SLOT_BITS * level as u32)) as usize & (NUM_SLOTS - 1)
+}
+
+// The first tick at or after the deadline, so a timer never expires early
+fn tick_of_deadline(deadline: Duration) -> u64 {
+    let ns = deadline
+        .checked_sub(*START_TIME)
+        .unwrap_or_default()
+        .as_nanos() as u64;
+    (ns + TICK_NS - 1) / TICK_NS
+}
+
+fn tick_of_now(now: Duration) -> u64 {
+    now.checked_sub(*START_TIME).unwrap_or_default().as_nanos() as u64 / TICK_NS
+}
+
+fn time_of_tick(tick: u64) -> Duration {
+    *START_TIME + Duration::from_nanos(tick * TICK_NS)
+}
+
+pub fn monotonic_now() -> Duration {
+    do_clock_gettime(ClockID::CLOCK_MONOTONIC)
+        .unwrap()
+        .as_duration()
+}
+
+/// Request the timer thread to interrupt the threads with pending signals after the
+/// current batch of timers, so that the signals sent by the timers are handled
+/// without waiting for the interrupt thread.
+pub fn interrupt_after_batch() {
+    HAS_SENT_SIGNALS.store(true, Ordering::Relaxed);
+}
+
+/// Run the expired timers in batch, and then sleep on the eventfd until the next timer
+/// expires or the eventfd is written. Without any timer on the wheel, the sleep lasts
+/// until an earlier timer is armed or the PAL stops the timer thread.
+pub fn run_timers(wakeup_fd: FileDesc) -> Result<()> {
+    WAKEUP_FD.store(wakeup_fd as i32, Ordering::Release);
+
+    let now = monotonic_now();
+    let expired = {
+        let mut wheel = WHEEL.lock().unwrap();
+        wheel.wakeup_tick = 0;
+        wheel.advance(tick_of_now(now))
+    };
+    for entry in expired {
+        entry.core.fire(entry.seq, now);
+    }
+    if HAS_SENT_SIGNALS.swap(false, Ordering::Relaxed) {
+        crate::interrupt::broadcast_interrupts()?;
+    }
+
+    // Keep the coarse clock ticking as long as it is read
+    COARSE_SECS.store(do_gettimeofday().sec(), Ordering::Relaxed);
+    let is_coarse_used = COARSE_USED.swap(false, Ordering::Relaxed);
+    COARSE_TICKING.store(is_coarse_used, Ordering::Release);
+
+    let now = monotonic_now();
+    let wakeup_tick = {
+        let mut wheel = WHEEL.lock().unwrap();
+        let mut wakeup_tick = wheel.next_tick();
+        if is_coarse_used {
+            let coarse_tick = tick_of_now(now) + COARSE_TICKS;
+            wakeup_tick = Some(wakeup_tick.map_or(coarse_tick, |tick| min(tick, coarse_tick)));
+        }
+        // Make sure that the timers armed from now on can wake up the thread
+        wheel.wakeup_tick = wakeup_tick.map_or(u64::MAX, |tick| max(tick, 1));
+        wakeup_tick
+    };
+    let timeout = wakeup_tick.map(|tick| time_of_tick(tick).checked_sub(now).unwrap_or_default());
+    if timeout == Some(Duration::from_secs(0)) {
+        return Ok(());
+    }
+    match unsafe { HostEventFd::poll_raw(wakeup_fd, timeout.as_ref()) } {
+        Err(e) if e.errno() != Errno::EINTR => Err(e),
+        _ => Ok(()),
+    }
+}
+
+/// The realtime in seconds, which is behind by up to a second. It is read without any
+/// OCall, except for the first read after the clock has been unused for a while.
+pub fn coarse_realtime_secs() -> time_t {
+    COARSE_USED.store(true, Ordering::Relaxed);
+    if COARSE_TICKING.load(Ordering::Acquire) {
+        return COARSE_SECS.load(Ordering::Relaxed);
+    }
+    // The timer thread may sleep without a deadline, so it is woken up to refresh the
+    // clock from now on
+    wake_up_timer_thread();
+    do_gettimeofday().sec()
+}
+
+fn wake_up_timer_thread() {
+    let wakeup_fd = WAKEUP_FD.load(Ordering::Acquire);
+    // Before the timer thread runs for the first time, the timers are run anyway
+    if wakeup_fd < 0 {
+        return;
+    }
+    unsafe { HostEventFd::write_u64_raw_and_batch(&[wakeup_fd as FileDesc], 1) };
+}
@@ -7,5 +7,6 @@ pub mod log;
 pub mod mem_util;
 pub mod mpx_util;
 pub mod pku_util;
+pub mod ring_buf;
 pub mod sgx;
 pub mod sync;
@@ -0,0 +1,325 @@
+//! A bounded, lock-free, multi-producer multi-consumer ring buffer.
+//!
+//! The design follows the classic two-phase "reserve/commit" scheme used by
+//! DPDK's `rte_ring`. Each side (producers or consumers) owns a pair of
+//! monotonically increasing cursors:
+//!
+//! * `head` is where the next reservation of that side starts. A producer
+//! (consumer) claims a contiguous range of slots by advancing `head` with a
+//! CAS, after which it can copy items into (out of) the claimed slots without
+//! holding any lock.
+//! * `tail` is where the committed region of that side ends. Once the copy is
+//! done, the range is made visible to the other side by advancing `tail`.
+//! Commits are done in reservation order, so a thread waits for the
+//! reservations that precede its own to be committed first.
+//!
+//! Producers can only reserve slots that consumers have released (i.e., below
+//! `cons.tail + capacity`); consumers can only reserve items that producers
+//! have committed (i.e., below `prod.tail`).
+//!
+//! Bulk operations (`push_slices`/`pop_slices`) reserve the whole range at
+//! once and copy at most two contiguous segments per slice, so that the
+//! copies are plain `memcpy`s that the compiler is free to vectorize.
+
+use std::cell::UnsafeCell;
+use std::hint;
+use std::mem::MaybeUninit;
+use std::ptr;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use crate::prelude::*;
+
+pub struct RingBuf<T> {
+    buf: Box<[UnsafeCell<MaybeUninit<T>>]>,
+    prod: Cursors,
+    cons: Cursors,
+}
+
+// The head and tail of one side are padded to a cache line so that producers
+// and consumers do not false-share the cursors of each other.
+#[repr(align(64))]
+struct Cursors {
+    head: AtomicUsize,
+    tail: AtomicUsize,
+}
+
+unsafe impl<T: Send> Send for RingBuf<T> {}
+unsafe impl<T: Send> Sync for RingBuf<T> {}
+
+impl<T> RingBuf<T> {
+    /// Create a ring buffer that can hold at most `capacity` items.
+    pub fn new(capacity: usize) -> Self {
+        assert!(capacity > 0);
+        let buf = (0..capacity)
+            .map(|_| UnsafeCell::new(MaybeUninit::uninit()))
+            .collect::<Vec<_>>()
+            .into_boxed_slice();
+        Self {
+            buf,
+            prod: Cursors::new(),
+            cons: Cursors::new(),
+        }
+    }
+
+    pub fn capacity(&self) -> usize {
+        self.buf.len()
+    }
+
+    /// The number of items that are ready to be popped.
+    pub fn len(&self) -> usize {
+        let cons_head = self.cons.head.load(Ordering::Acquire);
+        let prod_tail = self.prod.tail.load(Ordering::Acquire);
+        distance(cons_head, prod_tail)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn is_full(&self) -> bool {
+        self.free_len() == 0
+    }
+
+    /// The number of free slots that are ready to be pushed into.
+    pub fn free_len(&self) -> usize {
+        let cons_tail = self.cons.tail.load(Ordering::Acquire);
+        let prod_head = self.prod.head.load(Ordering::Acquire);
+        self.capacity()
+            .saturating_sub(distance(cons_tail, prod_head))
+    }
+
+    /// Push an item. The item is given back if the ring buffer is full.
+    pub fn push(&self, item: T) -> core::result::Result<(), T> {
+        let start = match self.reserve_push(1, 1) {
+            Some((start, _)) => start,
+            None => return Err(item),
+        };
+        unsafe {
+            (*self.slot(start)).as_mut_ptr().write(item);
+        }
+        Self::commit(&self.prod.tail, start, 1);
+        Ok(())
+    }
+
+    /// Pop an item if there is any.
+    pub fn pop(&self) -> Option<T> {
+        let (start, _) = self.reserve_pop(1)?;
+        let item = unsafe { (*self.slot(start)).as_ptr().read() };
+        Self::commit(&self.cons.tail, start, 1);
+        Some(item)
+    }
+
+    /// Reserve between `min_len` and `max_len` free slots for pushing.
+    fn reserve_push(&self, min_len: usize, max_len: usize) -> Option<(usize, usize)> {
+        let capacity = self.capacity();
+        let cons_tail = &self.cons.tail;
+        Self::reserve(&self.prod.head, min_len, max_len, |head| {
+            capacity.saturating_sub(distance(cons_tail.load(Ordering::Acquire), head))
+        })
+    }
+
+    /// Reserve between one and `max_len` committed items for popping.
+    fn reserve_pop(&self, max_len: usize) -> Option<(usize, usize)> {
+        let prod_tail = &self.prod.tail;
+        Self::reserve(&self.cons.head, 1, max_len, |head| {
+            distance(head, prod_tail.load(Ordering::Acquire))
+        })
+    }
+
+    fn reserve(
+        head: &AtomicUsize,
+        min_len: usize,
+        max_len: usize,
+        avail_len: impl Fn(usize) -> usize,
+    ) -> Option<(usize, usize)> {
+        debug_assert!(min_len >= 1 && min_len <= max_len);
+        loop {
+            let start = head.load(Ordering::Acquire);
+            let avail_len = avail_len(start);
+            if avail_len < min_len {
+                return None;
+            }
+            let len = avail_len.min(max_len);
+            if head
+                .compare_exchange_weak(
+                    start,
+                    start.wrapping_add(len),
+                    Ordering::AcqRel,
+                    Ordering::Relaxed,
+                )
+                .is_ok()
+            {
+                return Some((start, len));
+            }
+        }
+    }
+
+    /// Publish a reserved range once all the preceding reservations of the
+    /// same side are published.
+    fn commit(tail: &AtomicUsize, start: usize, len: usize) {
+        while tail.load(Ordering::Acquire) != start {
+            hint::spin_loop();
+        }
+        tail.store(start.wrapping_add(len), Ordering::Release);
+    }
+
+    fn slot(&self, pos: usize) -> *mut MaybeUninit<T> {
+        self.buf[pos % self.capacity()].get()
+    }
+
+    fn slots_ptr(&self) -> *mut T {
+        // UnsafeCell<MaybeUninit<T>> has the same memory layout as T
+        self.buf.as_ptr() as *mut T
+    }
+}
+
+impl<T: Copy> RingBuf<T> {
+    /// Push the items in a sequence of slices, returning the number of items
+    /// pushed.
+    ///
+    /// The pushed items are always contiguous in the ring buffer, even if other
+    /// threads are pushing concurrently. If less than `min_len` slots are
+    /// free, nothing is pushed. This can be used to make small pushes atomic.
+    pub fn push_slices(&self, item_slices: &[&[T]], min_len: usize) -> usize {
+        let total_len: usize = item_slices.iter().map(|slice| slice.len()).sum();
+        if total_len == 0 {
+            return 0;
+        }
+        let min_len = min_len.max(1).min(total_len).min(self.capacity());
+        let (start, len) = match self.reserve_push(min_len, total_len) {
+            Some(range) => range,
+            None => return 0,
+        };
+
+        let mut pos = start;
+        let mut remain = len;
+        for items in item_slices {
+            if remain == 0 {
+                break;
+            }
+            let count = items.len().min(remain);
+            unsafe {
+                self.copy_in(pos, &items[..count]);
+            }
+            pos = pos.wrapping_add(count);
+            remain -= count;
+        }
+
+        Self::commit(&self.prod.tail, start, len);
+        len
+    }
+
+    /// Pop items into a sequence of slices, returning the number of items
+    /// popped.
+    pub fn pop_slices(&self, item_slices: &mut [&mut [T]]) -> usize {
+        let total_len: usize = item_slices.iter().map(|slice| slice.len()).sum();
+        if total_len == 0 {
+            return 0;
+        }
+        let (start, len) = match self.reserve_pop(total_len) {
+            Some(range) => range,
+            None => return 0,
+        };
+
+        let mut pos = start;
+        let mut remain = len;
+        for items in item_slices.iter_mut() {
+            if remain == 0 {
+                break;
+            }
+            let count = items.len().min(remain);
+            unsafe {
+                self.copy_out(pos, &mut items[..count]);
+            }
+            pos = pos.wrapping_add(count);
+            remain -= count;
+        }
+
+        Self::commit(&self.cons.tail, start, len);
+        len
+    }
+
+    /// Copy the items that are ready to be popped into a sequence of slices
+    /// without popping them, returning the number of items copied.
+    ///
+    /// Safety. No item may be popped concurrently, otherwise the slots being
+    /// copied may be released and then overwritten by producers.
+    pub unsafe fn peek_slices(&self, item_slices: &mut [&mut [T]]) -> usize {
+        let total_len: usize = item_slices.iter().map(|slice| slice.len()).sum();
+        let start = self.cons.head.load(Ordering::Acquire);
+        let len = distance(start, self.prod.tail.load(Ordering::Acquire)).min(total_len);
+
+        let mut pos = start;
+        let mut remain = len;
+        for items in item_slices.iter_mut() {
+            if remain == 0 {
+                break;
+            }
+            let count = items.len().min(remain);
+            self.copy_out(pos, &mut items[..count]);
+            pos = pos.wrapping_add(count);
+            remain -= count;
+        }
+        len
+    }
+
+    // Safety. The slots in [pos, pos + items.len()) must have been reserved by
+    // the caller for pushing.
+    unsafe fn copy_in(&self, pos: usize, items: &[T]) {
+        let capacity = self.capacity();
+        let offset = pos % capacity;
+        let first_len = items.len().min(capacity - offset);
+        let slots = self.slots_ptr();
+        ptr::copy_nonoverlapping(items.as_ptr(), slots.add(offset), first_len);
+        ptr::copy_nonoverlapping(
+            items.as_ptr().add(first_len),
+            slots,
+            items.len() - first_len,
+        );
+    }
+
+    // Safety. The items in [pos, pos + items.len()) must have been reserved by
+    // the caller for popping.
+    unsafe fn copy_out(&self, pos: usize, items: &mut [T]) {
+        let capacity = self.capacity();
+        let offset = pos % capacity;
+        let first_len = items.len().min(capacity - offset);
+        let slots = self.slots_ptr();
+        ptr::copy_nonoverlapping(slots.add(offset), items.as_mut_ptr(), first_len);
+        ptr::copy_nonoverlapping(
+            slots,
+            items.as_mut_ptr().add(first_len),
+            items.len() - first_len,
+        );
+    }
+}
+
+impl<T> Drop for RingBuf<T> {
+    fn drop(&mut self) {
+        // No reservation can be in progress since we have the exclusive access
+        while let Some(item) = self.pop() {
+            drop(item);
+        }
+    }
+}
+
+// The distance between two cursors. As the two cursors are not loaded at the
+// same instant, `to` may appear to be behind `from`, which is treated as zero.
+// A reservation made upon such a stale value is rejected by the CAS anyway.
+fn distance(from: usize, to: usize) -> usize {
+    let distance = to.wrapping_sub(from) as isize;
+    if distance < 0 {
+        0
+    } else {
+        distance as usize
+    }
+}
+
+impl Cursors {
+    fn new() -> Self {
+        Self {
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+        }
+    }
+}
@@ -12,7 +12,7 @@ use std::hash::{Hash, Hasher};
 
 // For single VMA chunk, the vma struct doesn't need to update the pid field. Because all the chunks are recorded by the process VM already.
 pub const DUMMY_CHUNK_PROCESS_ID: pid_t = 0;
-// Default chunk size: 32MB
+// Default chunk size: 32MB, which is a multiple of the huge page size
 pub const CHUNK_DEFAULT_SIZE: usize = 32 * 1024 * 1024;
 
 pub type ChunkID = usize;
@@ -217,12 +217,21 @@ impl Chunk {
     }
 
     pub fn find_mmap_region(&self, addr: usize) -> Result<VMRange> {
-        let internal = &self.internal;
+        self.find_vma(addr).map(|vma| vma.range().clone())
+    }
+
+    // Return: a copy of the vma that contains the address
+    pub fn find_vma(&self, addr: usize) -> Result<VMArea> {
+        self.find_vma_of_process(addr, current!().process().pid())
+    }
+
+    // Return: a copy of the vma of the process that contains the address
+    pub fn find_vma_of_process(&self, addr: usize, pid: pid_t) -> Result<VMArea> {
         match self.internal() {
             ChunkType::SingleVMA(vma) => {
                 let vma = vma.lock().unwrap();
                 if vma.contains(addr) {
-                    return Ok(vma.range().clone());
+                    return Ok(vma.clone());
                 } else {
                     return_errno!(ESRCH, "addr not found in this chunk")
                 }
@@ -232,7 +241,7 @@ impl Chunk {
                     .lock()
                     .unwrap()
                     .chunk_manager
-                    .find_mmap_region(addr);
+                    .find_vma_of_process(addr, pid);
             }
         }
     }
@@ -1,7 +1,8 @@
 // Implements free space management for memory.
 // Currently only use simple vector as the base structure.
 //
-// Basically use address-ordered first fit to find free ranges.
+// Basically use address-ordered first fit to find free ranges. Large mappings use the
+// last fit from the top instead, to keep them apart from the small ones.
 use std::cmp::Ordering;
 
 use super::vm_util::VMMapAddr;
@@ -30,7 +31,6 @@ impl VMFreeSpaceManager {
             .fold(0, |acc, free_range| acc + free_range.size())
     }
 
-    // TODO: respect options.align when mmap
     pub fn find_free_range_internal(
         &mut self,
         size: usize,
@@ -54,7 +54,11 @@ impl VMFreeSpaceManager {
 
             match addr {
                 // Want a minimal free_range
-                VMMapAddr::Any => {}
+                VMMapAddr::Any => {
+                    if !Self::fits_aligned(&free_range, size, align) {
+                        continue;
+                    }
+                }
                 // Prefer to have free_range.start == addr
                 VMMapAddr::Hint(addr) => {
                     if addr % align == 0
@@ -67,8 +71,9 @@ impl VMFreeSpaceManager {
                         return Ok(free_range);
                     } else {
                         // Hint failure, record the result but keep iterating.
-                        if result_free_range == None
-                            || result_free_range.as_ref().unwrap().size() > free_range.size()
+                        if Self::fits_aligned(&free_range, size, align)
+                            && (result_free_range == None
+                                || result_free_range.as_ref().unwrap().size() > free_range.size())
                         {
                             result_free_range = Some(free_range);
                             result_idx = Some(idx);
@@ -114,6 +119,54 @@ impl VMFreeSpaceManager {
         return Ok(result_free_range);
     }
 
+    // Find a free range with the size and alignment inside `within`, which is the lowest
+    // one, or the highest one if `from_top` is set
+    pub fn find_free_range_within(
+        &mut self,
+        size: usize,
+        align: usize,
+        within: &VMRange,
+        from_top: bool,
+    ) -> Result<VMRange> {
+        let fits = |(idx, free_range): (usize, &VMRange)| {
+            free_range
+                .intersect(within)
+                .filter(|candidate| Self::fits_aligned(candidate, size, align))
+                .map(|candidate| (idx, candidate))
+        };
+        let found = if from_top {
+            self.free_manager.iter().enumerate().rev().find_map(fits)
+        } else {
+            self.free_manager.iter().enumerate().find_map(fits)
+        };
+        let (index, candidate) = found.ok_or_else(|| errno!(ENOMEM, "not enough memory"))?;
+        let result_free_range = {
+            let start = if from_top {
+                align_down(candidate.end() - size, align)
+            } else {
+                align_up(candidate.start(), align)
+            };
+            let end = start + size;
+            VMRange { start, end }
+        };
+
+        self.free_list_update_range(index, result_free_range);
+        trace!("after find free range, free list = {:?}", self.free_manager);
+        Ok(result_free_range)
+    }
+
+    pub fn free_size_within(&self, within: &VMRange) -> usize {
+        self.free_manager
+            .iter()
+            .filter_map(|free_range| free_range.intersect(within))
+            .fold(0, |acc, free_range| acc + free_range.size())
+    }
+
+    fn fits_aligned(free_range: &VMRange, size: usize, align: usize) -> bool {
+        let start = align_up(free_range.start(), align);
+        start < free_range.end() && free_range.end() - start >= size
+    }
+
     fn free_list_update_range(&mut self, index: usize, range: VMRange) {
         let mut free_list = &mut self.free_manager;
         let ranges_after_subtraction = free_list[index].subtract(&range);
@@ -14,6 +14,14 @@ This design can help to achieve mainly two goals:
 running in the same Occlum instance can use dramatically different sizes of memory.
 (2) Gain better performance: Two-level management(chunks & VMAs) reduces the time for finding, inserting, deleting, and iterating.
 
+The layout of chunks is huge-page-aware. Multi VMA chunks are aligned to 2MB and allocated from the bottom of the
+userspace. Large mappings (i.e., larger than the default chunk size, or with MAP_HUGETLB, or anonymous ones of at least
+2MB after MADV_HUGEPAGE) are single VMA chunks aligned to 2MB, which are allocated from the top of the userspace. Thus
+the large mappings are contiguous and kept apart from the fragmentation of small ones.
+
+On hosts with multiple NUMA nodes, the userspace is split into a pool per node, and the layout above applies to each
+pool. New chunks are allocated from the pools of the nodes allowed by the memory policy of the thread (see numa.rs).
+
 ***************** Chart for Occlum User Space Memory Management ***************
  User Space VM Manager
 ┌──────────────────────────────────────────────────────────────┐
@@ -57,13 +65,17 @@ running in the same Occlum instance can use dramatically different sizes of memo
 */
 
 use super::*;
-use fs::{File, FileDesc, FileRef};
+use fs::{AsIoUring, AsTmpFile, File, FileDesc, FileRef};
 use process::{Process, ProcessRef};
 use std::fmt;
 
 mod chunk;
 mod free_space_manager;
+mod numa;
 mod process_vm;
+mod process_vm_rw;
+mod reclaim_stat;
+mod shared_mem;
 mod user_space_vm;
 mod vm_area;
 mod vm_chunk_manager;
@@ -76,7 +88,13 @@ mod vm_util;
 use self::vm_layout::VMLayout;
 
 pub use self::chunk::{ChunkRef, ChunkType};
-pub use self::process_vm::{MMapFlags, MRemapFlags, MSyncFlags, ProcessVM, ProcessVMBuilder};
+pub use self::numa::{do_get_mempolicy, do_mbind, do_set_mempolicy, MemPolicy};
+pub use self::process_vm::{
+    MAdvice, MMapFlags, MRemapFlags, MSyncFlags, ProcessVM, ProcessVMBuilder,
+};
+pub use self::process_vm_rw::{do_process_vm_readv, do_process_vm_writev};
+pub use self::reclaim_stat::ReclaimStat;
+pub use self::shared_mem::{SharedMapping, SharedMem, SHMEM_SIZE};
 pub use self::user_space_vm::USER_SPACE_VM_MANAGER;
 pub use self::vm_area::VMArea;
 pub use self::vm_perms::VMPerms;
@@ -101,6 +119,23 @@ pub fn do_mmap(
             "mmap: addr: {:#x}, size: {:#x}, perms: {:?}, flags: {:?}, fd: {:?}, offset: {:?}",
             addr, size, perms, flags, fd, offset
         );
+        // The rings of io_uring are mapped when it is set up
+        let file = current!().file(fd)?;
+        if let Ok(ring) = file.as_io_uring() {
+            return ring.mmap(addr, size, flags, offset);
+        }
+        // The pages of tmpfs files are shared by their shared mappings
+        if flags.contains(MMapFlags::MAP_SHARED) {
+            if let Ok(tmp_file) = file.as_tmp_file() {
+                if !file.access_mode()?.readable()
+                    || (perms.can_write() && !file.access_mode()?.writable())
+                {
+                    return_errno!(EACCES, "the file is not opened for the mapping");
+                }
+                let mapping = tmp_file.mmap(offset, size, perms)?;
+                return current!().vm().mmap_shared_mem(mapping, addr, flags);
+            }
+        }
     }
 
     current!().vm().mmap(addr, size, perms, flags, fd, offset)
@@ -152,4 +187,13 @@ pub fn do_msync(addr: usize, size: usize, flags: MSyncFlags) -> Result<()> {
     current!().vm().msync(addr, size)
 }
 
+pub fn do_madvise(addr: usize, size: usize, advice: MAdvice) -> Result<()> {
+    debug!(
+        "madvise: addr: {:#x}, size: {:#x}, advice: {:?}",
+        addr, size, advice
+    );
+    current!().vm().madvise(addr, size, advice)
+}
+
 pub const PAGE_SIZE: usize = 4096;
+pub const HUGE_PAGE_SIZE: usize = 2 * 1024 * 1024;
@@ -0,0 +1,395 @@
+//! NUMA-aware placement of user memory.
+//!
+//! The user space is split into a pool per NUMA node of the host. A new chunk is allocated
+//! from the pools of the nodes allowed by the memory policy of the current thread, in the
+//! order of preference:
+//! - MPOL_DEFAULT and MPOL_LOCAL: the node of the current CPU first, then the others;
+//! - MPOL_PREFERRED: the preferred node first, then the others;
+//! - MPOL_BIND: the given nodes only;
+//! - MPOL_INTERLEAVE: the given nodes only, starting from the next node of interleaving,
+//!   which moves forward whenever a new chunk is allocated.
+//!
+//! Except for MPOL_BIND, a chunk that fits in none of the pools is allocated anywhere in
+//! the user space, like the fallback of Linux to the other nodes.
+//!
+//! The LibOS cannot choose or migrate the EPC pages backing an address, which is done by
+//! the host. A pool is only a fixed part of the user space for the chunks allocated for
+//! a node, which keeps them apart from those of the other nodes; the pages backing it are
+//! not necessarily on the node. Thus the node of an address, as reported by
+//! get_mempolicy and checked by mbind, is the index of the pool containing the address.
+//! The policies are applied at the granularity of chunks, and mbind only checks the
+//! placement of existing mappings.
+
+use super::*;
+
+use crate::sched::{current_numa_node, NUMA_TOPOLOGY};
+use crate::util::mem_util::from_user::*;
+
+// Memory policy modes
+const MPOL_DEFAULT: i32 = 0;
+const MPOL_PREFERRED: i32 = 1;
+const MPOL_BIND: i32 = 2;
+const MPOL_INTERLEAVE: i32 = 3;
+const MPOL_LOCAL: i32 = 4;
+
+// Mode flags, which make no difference as the nodes never change
+const MPOL_F_STATIC_NODES: i32 = 1 << 15;
+const MPOL_F_RELATIVE_NODES: i32 = 1 << 14;
+
+// Flags of get_mempolicy
+const MPOL_F_NODE: u32 = 1 << 0;
+const MPOL_F_ADDR: u32 = 1 << 1;
+const MPOL_F_MEMS_ALLOWED: u32 = 1 << 2;
+
+// Flags of mbind
+const MPOL_MF_STRICT: u32 = 1 << 0;
+const MPOL_MF_MOVE: u32 = 1 << 1;
+const MPOL_MF_MOVE_ALL: u32 = 1 << 2;
+
+// The max number of bits in a node mask, which is the same as Linux
+const MAX_NODEMASK_BITS: usize = PAGE_SIZE * 8;
+
+/// The memory pools of NUMA nodes
+#[derive(Debug, Clone)]
+pub struct NumaPools {
+    // The range of the pool of each node, indexed by the node ID
+    pools: Vec<VMRange>,
+}
+
+impl NumaPools {
+    /// Split the range evenly into a pool per node, which is aligned to huge page.
+    pub fn new(range: &VMRange) -> Self {
+        let num_nodes = NUMA_TOPOLOGY
+            .iter()
+            .max()
+            .map_or(1, |&node| node as usize + 1);
+        let pool_size = align_down(range.size() / num_nodes, HUGE_PAGE_SIZE);
+        if num_nodes == 1 || pool_size == 0 {
+            return Self {
+                pools: vec![*range],
+            };
+        }
+        let pools = (0..num_nodes)
+            .map(|node| {
+                let start = range.start() + node * pool_size;
+                let end = if node == num_nodes - 1 {
+                    range.end()
+                } else {
+                    start + pool_size
+                };
+                VMRange { start, end }
+            })
+            .collect();
+        info!("NUMA pools of user space: {:?}", pools);
+        Self { pools }
+    }
+
+    pub fn num_nodes(&self) -> usize {
+        self.pools.len()
+    }
+
+    pub fn pool(&self, node: u32) -> &VMRange {
+        &self.pools[node as usize]
+    }
+
+    /// Get the node whose pool contains the address.
+    pub fn node_of(&self, addr: usize) -> u32 {
+        self.pools
+            .iter()
+            .position(|pool| pool.contains(addr))
+            .unwrap_or(0) as u32
+    }
+
+    /// Get the nodes whose pools overlap with the range.
+    pub fn nodes_of(&self, range: &VMRange) -> impl Iterator<Item = u32> + '_ {
+        let range = *range;
+        self.pools
+            .iter()
+            .enumerate()
+            .filter(move |(_, pool)| pool.overlap_with(&range))
+            .map(|(node, _)| node as u32)
+    }
+}
+
+/// The memory policy of a thread, which is inherited by its children
+#[derive(Debug, Clone)]
+pub enum MemPolicy {
+    Default,
+    Local,
+    Preferred(u32),
+    Bind(Vec<u32>),
+    Interleave { nodes: Vec<u32>, next: usize },
+}
+
+impl Default for MemPolicy {
+    fn default() -> Self {
+        MemPolicy::Default
+    }
+}
+
+impl MemPolicy {
+    fn new(mode: i32, nodes: Vec<u32>) -> Result<Self> {
+        let policy = match mode {
+            MPOL_DEFAULT | MPOL_LOCAL if !nodes.is_empty() => {
+                return_errno!(EINVAL, "nodes must be empty");
+            }
+            MPOL_DEFAULT => MemPolicy::Default,
+            MPOL_LOCAL => MemPolicy::Local,
+            // An empty node mask means the local allocation
+            MPOL_PREFERRED if nodes.is_empty() => MemPolicy::Local,
+            MPOL_PREFERRED => MemPolicy::Preferred(nodes[0]),
+            MPOL_BIND | MPOL_INTERLEAVE if nodes.is_empty() => {
+                return_errno!(EINVAL, "nodes must not be empty");
+            }
+            MPOL_BIND => MemPolicy::Bind(nodes),
+            MPOL_INTERLEAVE => MemPolicy::Interleave { nodes, next: 0 },
+            _ => return_errno!(EINVAL, "unknown memory policy mode"),
+        };
+        Ok(policy)
+    }
+
+    fn mode(&self) -> i32 {
+        match self {
+            MemPolicy::Default => MPOL_DEFAULT,
+            MemPolicy::Local => MPOL_LOCAL,
+            MemPolicy::Preferred(_) => MPOL_PREFERRED,
+            MemPolicy::Bind(_) => MPOL_BIND,
+            MemPolicy::Interleave { .. } => MPOL_INTERLEAVE,
+        }
+    }
+
+    fn nodes(&self) -> Vec<u32> {
+        match self {
+            MemPolicy::Default | MemPolicy::Local => Vec::new(),
+            MemPolicy::Preferred(node) => vec![*node],
+            MemPolicy::Bind(nodes) | MemPolicy::Interleave { nodes, .. } => nodes.clone(),
+        }
+    }
+
+    /// Get the nodes to allocate memory from, in the order of preference.
+    fn nodes_to_alloc(&self, num_nodes: usize) -> Vec<u32> {
+        let first_then_others = |first: u32| {
+            std::iter::once(first)
+                .chain((0..num_nodes as u32).filter(|&node| node != first))
+                .collect()
+        };
+        match self {
+            MemPolicy::Default | MemPolicy::Local => first_then_others(current_numa_node()),
+            MemPolicy::Preferred(node) => first_then_others(*node),
+            MemPolicy::Bind(nodes) => nodes.clone(),
+            MemPolicy::Interleave { nodes, next } => {
+                let (head, tail) = nodes.split_at(*next);
+                tail.iter().chain(head.iter()).cloned().collect()
+            }
+        }
+    }
+
+    fn on_chunk_allocated(&mut self, node: u32) {
+        if let MemPolicy::Interleave { nodes, next } = self {
+            if let Some(idx) = nodes.iter().position(|&n| n == node) {
+                *next = (idx + 1) % nodes.len();
+            }
+        }
+    }
+}
+
+/// Get the nodes to allocate memory from for the current thread, in the order of preference.
+pub fn current_alloc_nodes(pools: &NumaPools) -> Vec<u32> {
+    if pools.num_nodes() == 1 {
+        return vec![0];
+    }
+    current!()
+        .mempolicy()
+        .lock()
+        .unwrap()
+        .nodes_to_alloc(pools.num_nodes())
+}
+
+/// Whether the memory of the current thread may be allocated out of the nodes of its
+/// memory policy, which is not allowed by MPOL_BIND.
+pub fn current_may_fall_back(pools: &NumaPools) -> bool {
+    if pools.num_nodes() == 1 {
+        return false;
+    }
+    match *current!().mempolicy().lock().unwrap() {
+        MemPolicy::Bind(_) => false,
+        _ => true,
+    }
+}
+
+/// Notify the memory policy of the current thread that a chunk is allocated on the node.
+pub fn current_chunk_allocated(pools: &NumaPools, node: u32) {
+    if pools.num_nodes() == 1 {
+        return;
+    }
+    current!()
+        .mempolicy()
+        .lock()
+        .unwrap()
+        .on_chunk_allocated(node);
+}
+
+pub fn do_set_mempolicy(mode: i32, nodemask: *const u64, maxnode: u64) -> Result<()> {
+    let mode = mode & !(MPOL_F_STATIC_NODES | MPOL_F_RELATIVE_NODES);
+    let nodes = read_nodemask(nodemask, maxnode)?;
+    let policy = MemPolicy::new(mode, nodes)?;
+    debug!("set_mempolicy: {:?}", policy);
+    *current!().mempolicy().lock().unwrap() = policy;
+    Ok(())
+}
+
+pub fn do_get_mempolicy(
+    mode_ptr: *mut i32,
+    nodemask: *mut u64,
+    maxnode: u64,
+    addr: usize,
+    flags: u32,
+) -> Result<()> {
+    if flags & !(MPOL_F_NODE | MPOL_F_ADDR | MPOL_F_MEMS_ALLOWED) != 0 {
+        return_errno!(EINVAL, "invalid flags");
+    }
+    let pools = USER_SPACE_VM_MANAGER.numa_pools();
+    let current = current!();
+
+    let (mode, nodes) = if flags & MPOL_F_MEMS_ALLOWED != 0 {
+        if flags & (MPOL_F_NODE | MPOL_F_ADDR) != 0 {
+            return_errno!(EINVAL, "invalid flags");
+        }
+        (MPOL_DEFAULT, (0..pools.num_nodes() as u32).collect())
+    } else if flags & MPOL_F_ADDR != 0 {
+        current
+            .vm()
+            .find_mmap_region(addr)
+            .map_err(|_| errno!(EFAULT, "the address is not mapped"))?;
+        if flags & MPOL_F_NODE != 0 {
+            // The index of the pool of the address, not the node of its page
+            (pools.node_of(addr) as i32, Vec::new())
+        } else {
+            // There are no policies of mappings
+            (MPOL_DEFAULT, Vec::new())
+        }
+    } else {
+        if addr != 0 {
+            return_errno!(EINVAL, "addr must be zero without MPOL_F_ADDR");
+        }
+        let policy = current.mempolicy().lock().unwrap();
+        if flags & MPOL_F_NODE != 0 {
+            match &*policy {
+                MemPolicy::Interleave { nodes, next } => (nodes[*next] as i32, Vec::new()),
+                _ => return_errno!(EINVAL, "MPOL_F_NODE requires MPOL_INTERLEAVE"),
+            }
+        } else {
+            (policy.mode(), policy.nodes())
+        }
+    };
+
+    if !mode_ptr.is_null() {
+        check_mut_ptr(mode_ptr)?;
+        unsafe {
+            *mode_ptr = mode;
+        }
+    }
+    if !nodemask.is_null() {
+        write_nodemask(nodemask, maxnode, &nodes, pools.num_nodes())?;
+    }
+    Ok(())
+}
+
+pub fn do_mbind(
+    addr: usize,
+    len: usize,
+    mode: i32,
+    nodemask: *const u64,
+    maxnode: u64,
+    flags: u32,
+) -> Result<()> {
+    if flags & !(MPOL_MF_STRICT | MPOL_MF_MOVE | MPOL_MF_MOVE_ALL) != 0 {
+        return_errno!(EINVAL, "invalid flags");
+    }
+    if flags & MPOL_MF_MOVE_ALL != 0 {
+        return_errno!(EPERM, "MPOL_MF_MOVE_ALL is not permitted");
+    }
+    if addr % PAGE_SIZE != 0 {
+        return_errno!(EINVAL, "addr must be page aligned");
+    }
+    let mode = mode & !(MPOL_F_STATIC_NODES | MPOL_F_RELATIVE_NODES);
+    let policy = MemPolicy::new(mode, read_nodemask(nodemask, maxnode)?)?;
+    if len == 0 {
+        return Ok(());
+    }
+    let range = VMRange::new_with_size(addr, align_up(len, PAGE_SIZE))?;
+    debug!("mbind: range = {:?}, policy = {:?}", range, policy);
+
+    let pools = USER_SPACE_VM_MANAGER.numa_pools();
+    let allowed_nodes = match policy {
+        MemPolicy::Bind(nodes) | MemPolicy::Interleave { nodes, .. } => nodes,
+        _ => (0..pools.num_nodes() as u32).collect(),
+    };
+    // The pages cannot be moved, so the strict mode fails if any of them is misplaced
+    let current = current!();
+    let mut addr = range.start();
+    while addr < range.end() {
+        let vma_range = current
+            .vm()
+            .find_mmap_region(addr)
+            .map_err(|_| errno!(EFAULT, "the memory is not mapped"))?;
+        let mapped_range = vma_range.intersect(&range).unwrap();
+        if flags & MPOL_MF_STRICT != 0
+            && pools
+                .nodes_of(&mapped_range)
+                .any(|node| !allowed_nodes.contains(&node))
+        {
+            return_errno!(EIO, "the memory is not on the nodes of the policy");
+        }
+        addr = mapped_range.end();
+    }
+    Ok(())
+}
+
+fn read_nodemask(nodemask: *const u64, maxnode: u64) -> Result<Vec<u32>> {
+    // As Linux, the number of bits is maxnode - 1
+    let num_bits = (maxnode as usize).saturating_sub(1);
+    if nodemask.is_null() || num_bits == 0 {
+        return Ok(Vec::new());
+    }
+    if num_bits > MAX_NODEMASK_BITS {
+        return_errno!(EINVAL, "maxnode is too large");
+    }
+    let words = {
+        let len = align_up(num_bits, 64) / 64;
+        check_array(nodemask, len)?;
+        unsafe { std::slice::from_raw_parts(nodemask, len) }
+    };
+
+    let num_nodes = USER_SPACE_VM_MANAGER.numa_pools().num_nodes();
+    let mut nodes = Vec::new();
+    for bit in 0..num_bits {
+        if words[bit / 64] & (1 << (bit % 64)) == 0 {
+            continue;
+        }
+        if bit >= num_nodes {
+            return_errno!(EINVAL, "the node does not exist");
+        }
+        nodes.push(bit as u32);
+    }
+    Ok(nodes)
+}
+
+fn write_nodemask(nodemask: *mut u64, maxnode: u64, nodes: &[u32], num_nodes: usize) -> Result<()> {
+    let num_bits = (maxnode as usize).saturating_sub(1);
+    if num_bits < num_nodes {
+        return_errno!(EINVAL, "maxnode is too small");
+    }
+    let words = {
+        let len = align_up(num_bits, 64) / 64;
+        check_mut_array(nodemask, len)?;
+        unsafe { std::slice::from_raw_parts_mut(nodemask, len) }
+    };
+    for word in words.iter_mut() {
+        *word = 0;
+    }
+    for &node in nodes {
+        words[node as usize / 64] |= 1 << (node % 64);
+    }
+    Ok(())
+}
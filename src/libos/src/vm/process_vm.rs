@@ -4,6 +4,7 @@ use super::chunk::*;
 use super::config;
 use super::ipc::SHM_MANAGER;
 use super::process::elf_file::{ElfFile, ProgramHeaderExt};
+use super::shared_mem::SharedMapping;
 use super::user_space_vm::USER_SPACE_VM_MANAGER;
 use super::vm_area::VMArea;
 use super::vm_perms::VMPerms;
@@ -11,6 +12,7 @@ use super::vm_util::{
     FileBacked, VMInitializer, VMMapAddr, VMMapOptions, VMMapOptionsBuilder, VMRemapOptions,
 };
 use std::collections::HashSet;
+use std::sync::atomic::{AtomicBool, Ordering};
 use util::sync::rw_lock::RwLockWriteGuard;
 
 // Used for heap and stack start address randomization.
@@ -190,6 +192,9 @@ impl<'a, 'b> ProcessVMBuilder<'a, 'b> {
             heap_range,
             stack_range,
             brk,
+            reclaim_stat: Default::default(),
+            huge_page_advised: AtomicBool::new(false),
+            shared_mappings: SgxMutex::new(Vec::new()),
             mem_chunks,
         })
     }
@@ -218,6 +223,16 @@ impl<'a, 'b> ProcessVMBuilder<'a, 'b> {
     fn init_elf_memory(elf_range: &VMRange, elf_file: &ElfFile) -> Result<()> {
         // Destination buffer: ELF appeared in the process
         let elf_proc_buf = unsafe { elf_range.as_slice_mut() };
+
+        // The image of a template is loaded already
+        if let Some(image) = elf_file.image() {
+            if image.len() != elf_proc_buf.len() {
+                return_errno!(EINVAL, "the size of ELF image mismatches");
+            }
+            elf_proc_buf.copy_from_slice(image);
+            return Ok(());
+        }
+
         // Source buffer: ELF stored in the ELF file
         let elf_file_buf = elf_file.as_slice();
 
@@ -275,6 +290,12 @@ pub struct ProcessVM {
     heap_range: VMRange,
     stack_range: VMRange,
     brk: RwLock<usize>,
+    reclaim_stat: ReclaimStat,
+    // Whether MADV_HUGEPAGE is advised, after which the large anonymous mappings are
+    // aligned to huge page
+    huge_page_advised: AtomicBool,
+    // The mappings of shared memory, e.g., memfd, which are not in mem_chunks
+    shared_mappings: SgxMutex<Vec<SharedMapping>>,
     // Memory safety notes: the mem_chunks field must be the last one.
     //
     // Rust drops fields in the same order as they are declared. So by making
@@ -291,6 +312,9 @@ impl Default for ProcessVM {
             heap_range: Default::default(),
             stack_range: Default::default(),
             brk: Default::default(),
+            reclaim_stat: Default::default(),
+            huge_page_advised: AtomicBool::new(false),
+            shared_mappings: SgxMutex::new(Vec::new()),
             mem_chunks: Arc::new(RwLock::new(HashSet::new())),
         }
     }
@@ -462,6 +486,7 @@ impl ProcessVM {
             if new_brk < old_brk {
                 let shrink_brk_range =
                     VMRange::new(new_brk, old_brk).expect("shrink brk range must be valid");
+                self.reclaim_stat.forget(&shrink_brk_range);
                 USER_SPACE_VM_MANAGER.reset_memory(shrink_brk_range)?;
             }
 
@@ -502,6 +527,10 @@ impl ProcessVM {
     ) -> Result<usize> {
         let addr_option = {
             if flags.contains(MMapFlags::MAP_FIXED) {
+                // The memory mapped before is replaced
+                if let Ok(range) = VMRange::new_with_size(addr, align_up(size, PAGE_SIZE)) {
+                    self.reclaim_stat.forget(&range);
+                }
                 VMMapAddr::Force(addr)
             } else {
                 if addr == 0 {
@@ -528,8 +557,26 @@ impl ProcessVM {
                 }
             }
         };
+        let (size, align) = if flags.contains(MMapFlags::MAP_HUGETLB) {
+            // SGX enclave memory can not be backed by huge pages. Instead, the mapping is aligned
+            // to huge page and placed in the region of large mappings.
+            let size = size
+                .checked_add(HUGE_PAGE_SIZE - 1)
+                .ok_or_else(|| errno!(ENOMEM, "size overflow"))?;
+            (align_down(size, HUGE_PAGE_SIZE), HUGE_PAGE_SIZE)
+        } else if self.huge_page_advised.load(Ordering::Relaxed)
+            && flags.contains(MMapFlags::MAP_ANONYMOUS)
+            && size >= HUGE_PAGE_SIZE
+        {
+            // Like THP, the large anonymous mappings are placed for huge pages after
+            // MADV_HUGEPAGE, without rounding up the size
+            (size, HUGE_PAGE_SIZE)
+        } else {
+            (size, PAGE_SIZE)
+        };
         let mmap_options = VMMapOptionsBuilder::default()
             .size(size)
+            .align(align)
             .addr(addr_option)
             .perms(perms)
             .initializer(initializer)
@@ -538,6 +585,26 @@ impl ProcessVM {
         Ok(mmap_addr)
     }
 
+    /// Add the mapping of shared memory, whose pages are shared with the other
+    /// mappings of it rather than copied in
+    pub fn mmap_shared_mem(
+        &self,
+        mapping: SharedMapping,
+        addr: usize,
+        flags: MMapFlags,
+    ) -> Result<usize> {
+        let mmap_addr = mapping.range().start();
+        if flags.contains(MMapFlags::MAP_FIXED) && addr != mmap_addr {
+            return_errno!(EINVAL, "shared memory cannot be mapped at a fixed address");
+        }
+        self.shared_mappings.lock().unwrap().push(mapping);
+        Ok(mmap_addr)
+    }
+
+    pub fn unmap_all_shared_mem(&self) {
+        self.shared_mappings.lock().unwrap().clear();
+    }
+
     pub fn mremap(
         &self,
         old_addr: usize,
@@ -546,10 +613,28 @@ impl ProcessVM {
         flags: MRemapFlags,
     ) -> Result<usize> {
         let mremap_option = VMRemapOptions::new(old_addr, old_size, new_size, flags)?;
+        // The memory may be moved or shrunk, and is no longer tracked as reclaimed
+        if let Ok(old_range) = VMRange::new_with_size(old_addr, align_up(old_size, PAGE_SIZE)) {
+            self.reclaim_stat.forget(&old_range);
+        }
+        if let Some(new_addr) = flags.new_addr() {
+            if let Ok(new_range) = VMRange::new_with_size(new_addr, align_up(new_size, PAGE_SIZE)) {
+                self.reclaim_stat.forget(&new_range);
+            }
+        }
         USER_SPACE_VM_MANAGER.mremap(&mremap_option)
     }
 
     pub fn munmap(&self, addr: usize, size: usize) -> Result<()> {
+        if size > 0 {
+            // A shared mapping is split if it is unmapped partially
+            let munmap_range = VMRange::new_with_size(addr, align_up(size, PAGE_SIZE))?;
+            let mut shared_mappings = self.shared_mappings.lock().unwrap();
+            Self::split_shared_mappings(&mut shared_mappings, &munmap_range);
+            shared_mappings.retain(|mapping| !munmap_range.is_superset_of(mapping.range()));
+            drop(shared_mappings);
+            self.reclaim_stat.forget(&munmap_range);
+        }
         USER_SPACE_VM_MANAGER.munmap(addr, size)
     }
 
@@ -561,8 +646,60 @@ impl ProcessVM {
             align_up(size, PAGE_SIZE)
         };
         let protect_range = VMRange::new_with_size(addr, size)?;
+        // The reclaimed memory is tracked by reading it
+        if !perms.can_read() {
+            self.reclaim_stat.forget(&protect_range);
+        }
+        // The permissions of the shared mappings are kept by themselves, and the rest
+        // of the range is protected as usual
+        let other_ranges = {
+            let shared_mappings = self.shared_mappings.lock().unwrap();
+            let mut other_ranges = vec![protect_range];
+            for mapping in shared_mappings
+                .iter()
+                .filter(|mapping| mapping.range().overlap_with(&protect_range))
+            {
+                if perms.can_write() && !mapping.is_writable() {
+                    return_errno!(EACCES, "the shared mapping cannot be writable");
+                }
+                other_ranges = other_ranges
+                    .iter()
+                    .flat_map(|range| range.subtract(mapping.range()))
+                    .collect();
+            }
+            other_ranges
+        };
+        if other_ranges.len() == 1 && other_ranges[0] == protect_range {
+            return USER_SPACE_VM_MANAGER.mprotect(addr, size, perms);
+        }
+
+        for range in other_ranges.iter() {
+            USER_SPACE_VM_MANAGER.mprotect(range.start(), range.size(), perms)?;
+        }
+        let mut shared_mappings = self.shared_mappings.lock().unwrap();
+        Self::split_shared_mappings(&mut shared_mappings, &protect_range);
+        for mapping in shared_mappings
+            .iter_mut()
+            .filter(|mapping| protect_range.is_superset_of(mapping.range()))
+        {
+            mapping.set_perms(perms)?;
+        }
+        Ok(())
+    }
 
-        return USER_SPACE_VM_MANAGER.mprotect(addr, size, perms);
+    // Split the shared mappings at the boundaries of the range, so that each of them is
+    // either inside or outside of the range
+    fn split_shared_mappings(shared_mappings: &mut Vec<SharedMapping>, range: &VMRange) {
+        for &boundary in [range.start(), range.end()].iter() {
+            let tails: Vec<SharedMapping> = shared_mappings
+                .iter_mut()
+                .filter(|mapping| {
+                    mapping.range().start() < boundary && boundary < mapping.range().end()
+                })
+                .map(|mapping| mapping.split_off(boundary))
+                .collect();
+            shared_mappings.extend(tails);
+        }
     }
 
     pub fn msync(&self, addr: usize, size: usize) -> Result<()> {
@@ -573,10 +710,70 @@ impl ProcessVM {
         return USER_SPACE_VM_MANAGER.msync_by_file(sync_file);
     }
 
+    pub fn madvise(&self, addr: usize, size: usize, advice: MAdvice) -> Result<()> {
+        if addr % PAGE_SIZE != 0 {
+            return_errno!(EINVAL, "addr must be page aligned");
+        }
+        if size == 0 {
+            return Ok(());
+        }
+        let advise_range = VMRange::new_with_size(addr, align_up(size, PAGE_SIZE))?;
+
+        match advice {
+            MAdvice::HugePage => self.huge_page_advised.store(true, Ordering::Relaxed),
+            MAdvice::NoHugePage => self.huge_page_advised.store(false, Ordering::Relaxed),
+            _ => {}
+        }
+        let (mapped_size, reclaimed_ranges) =
+            USER_SPACE_VM_MANAGER.madvise(&advise_range, advice, &self.elf_ranges)?;
+        for range in reclaimed_ranges.iter() {
+            self.reclaim_stat.add(range, advice);
+        }
+
+        // Like Linux, the advice is applied to the mapped memory even if the range is not
+        // fully mapped
+        if mapped_size < advise_range.size() {
+            return_errno!(ENOMEM, "the range is not fully mapped");
+        }
+        Ok(())
+    }
+
+    pub fn reclaim_stat(&self) -> &ReclaimStat {
+        &self.reclaim_stat
+    }
+
     // Return: a copy of the found region
     pub fn find_mmap_region(&self, addr: usize) -> Result<VMRange> {
         USER_SPACE_VM_MANAGER.find_mmap_region(addr)
     }
+
+    /// Check that the range is mapped with the permissions in this process, which is
+    /// not necessarily the current one. The range may span multiple mappings.
+    pub fn check_range_perms(&self, pid: pid_t, range: &VMRange, perms: VMPerms) -> Result<()> {
+        let mem_chunks = self.mem_chunks.read().unwrap();
+        let shared_mappings = self.shared_mappings.lock().unwrap();
+        let mut addr = range.start();
+        while addr < range.end() {
+            let (end, mapping_perms) = if let Some(mapping) = shared_mappings
+                .iter()
+                .find(|mapping| mapping.range().contains(addr))
+            {
+                (mapping.range().end(), mapping.perms())
+            } else {
+                let vma = mem_chunks
+                    .iter()
+                    .filter(|chunk| chunk.range().contains(addr))
+                    .find_map(|chunk| chunk.find_vma_of_process(addr, pid).ok())
+                    .ok_or_else(|| errno!(EFAULT, "the address is not mapped"))?;
+                (vma.end(), vma.perms())
+            };
+            if !mapping_perms.contains(perms) {
+                return_errno!(EFAULT, "the mapping has no permissions for the access");
+            }
+            addr = end;
+        }
+        Ok(())
+    }
 }
 
 bitflags! {
@@ -665,3 +862,55 @@ impl MSyncFlags {
         Ok(flags)
     }
 }
+
+// The advice of madvise. The advice that only affects the page cache, swapping, KSM
+// or core dumps of Linux is accepted and ignored, as there is no such thing in Occlum.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum MAdvice {
+    Normal,
+    Random,
+    Sequential,
+    WillNeed,
+    DontNeed,
+    Free,
+    HugePage,
+    NoHugePage,
+    Ignored,
+}
+
+impl MAdvice {
+    pub fn from_i32(raw_advice: i32) -> Result<Self> {
+        const MADV_NORMAL: i32 = 0;
+        const MADV_RANDOM: i32 = 1;
+        const MADV_SEQUENTIAL: i32 = 2;
+        const MADV_WILLNEED: i32 = 3;
+        const MADV_DONTNEED: i32 = 4;
+        const MADV_FREE: i32 = 8;
+        const MADV_DONTFORK: i32 = 10;
+        const MADV_DOFORK: i32 = 11;
+        const MADV_MERGEABLE: i32 = 12;
+        const MADV_UNMERGEABLE: i32 = 13;
+        const MADV_HUGEPAGE: i32 = 14;
+        const MADV_NOHUGEPAGE: i32 = 15;
+        const MADV_DONTDUMP: i32 = 16;
+        const MADV_DODUMP: i32 = 17;
+        const MADV_COLD: i32 = 20;
+        const MADV_PAGEOUT: i32 = 21;
+
+        #[deny(unreachable_patterns)]
+        let advice = match raw_advice {
+            MADV_NORMAL => Self::Normal,
+            MADV_RANDOM => Self::Random,
+            MADV_SEQUENTIAL => Self::Sequential,
+            MADV_WILLNEED => Self::WillNeed,
+            MADV_DONTNEED => Self::DontNeed,
+            MADV_FREE => Self::Free,
+            MADV_HUGEPAGE => Self::HugePage,
+            MADV_NOHUGEPAGE => Self::NoHugePage,
+            MADV_DONTFORK | MADV_DOFORK | MADV_MERGEABLE | MADV_UNMERGEABLE | MADV_DONTDUMP
+            | MADV_DODUMP | MADV_COLD | MADV_PAGEOUT => Self::Ignored,
+            _ => return_errno!(EINVAL, "unsupported advice"),
+        };
+        Ok(advice)
+    }
+}
@@ -0,0 +1,153 @@
+//! Copy the memory between processes, i.e., process_vm_readv and process_vm_writev.
+//!
+//! As all the processes share the address space of the enclave, the remote buffers are
+//! checked against the mappings of the target process and then copied from or to the
+//! local buffers directly, without any intermediate buffer.
+
+use super::*;
+
+use crate::process::table;
+use crate::util::mem_util::from_user;
+
+// The max number of iovecs, which is UIO_MAXIOV of Linux
+const IOV_MAX: u64 = 1024;
+
+pub fn do_process_vm_readv(
+    pid: pid_t,
+    local_iov: *const libc::iovec,
+    liovcnt: u64,
+    remote_iov: *const libc::iovec,
+    riovcnt: u64,
+    flags: u64,
+) -> Result<usize> {
+    debug!(
+        "process_vm_readv: pid: {}, liovcnt: {}, riovcnt: {}",
+        pid, liovcnt, riovcnt
+    );
+    do_process_vm_rw(pid, local_iov, liovcnt, remote_iov, riovcnt, flags, false)
+}
+
+pub fn do_process_vm_writev(
+    pid: pid_t,
+    local_iov: *const libc::iovec,
+    liovcnt: u64,
+    remote_iov: *const libc::iovec,
+    riovcnt: u64,
+    flags: u64,
+) -> Result<usize> {
+    debug!(
+        "process_vm_writev: pid: {}, liovcnt: {}, riovcnt: {}",
+        pid, liovcnt, riovcnt
+    );
+    do_process_vm_rw(pid, local_iov, liovcnt, remote_iov, riovcnt, flags, true)
+}
+
+fn do_process_vm_rw(
+    pid: pid_t,
+    local_iov: *const libc::iovec,
+    liovcnt: u64,
+    remote_iov: *const libc::iovec,
+    riovcnt: u64,
+    flags: u64,
+    is_write: bool,
+) -> Result<usize> {
+    if flags != 0 {
+        return_errno!(EINVAL, "flags must be zero");
+    }
+    let local_iovs = clone_iovs(local_iov, liovcnt)?;
+    let remote_iovs = clone_iovs(remote_iov, riovcnt)?;
+    // The local buffers are in the user space, which is checked as a whole
+    for iov in &local_iovs {
+        from_user::check_array(iov.iov_base as *const u8, iov.iov_len)?;
+    }
+
+    let target_vm = {
+        let process = table::get_process(pid)?;
+        let thread = process
+            .leader_thread()
+            .ok_or_else(|| errno!(ESRCH, "the process has exited"))?;
+        thread.vm().clone()
+    };
+    let perms = if is_write {
+        VMPerms::WRITE
+    } else {
+        VMPerms::READ
+    };
+
+    let mut local_iovs = local_iovs.iter().filter(|iov| iov.iov_len > 0);
+    let mut local = local_iovs.next();
+    let mut local_offset = 0;
+    let mut copied_len = 0;
+    for remote in remote_iovs.iter().filter(|iov| iov.iov_len > 0) {
+        if local.is_none() {
+            break;
+        }
+        // A remote buffer is either copied as a whole or not at all
+        let remote_start = remote.iov_base as usize;
+        let checked = remote_start
+            .checked_add(remote.iov_len)
+            .ok_or_else(|| errno!(EFAULT, "the remote buffer overflows"))
+            .and_then(|remote_end| {
+                let remote_range = VMRange::new(
+                    align_down(remote_start, PAGE_SIZE),
+                    align_up(remote_end, PAGE_SIZE),
+                )?;
+                target_vm.check_range_perms(pid, &remote_range, perms)
+            });
+        if let Err(e) = checked {
+            if copied_len == 0 {
+                return Err(e);
+            }
+            break;
+        }
+
+        let mut remote_offset = 0;
+        while let Some(local_iov) = local {
+            let len = min(
+                remote.iov_len - remote_offset,
+                local_iov.iov_len - local_offset,
+            );
+            let remote_ptr = (remote_start + remote_offset) as *mut u8;
+            let local_ptr = (local_iov.iov_base as usize + local_offset) as *mut u8;
+            // The buffers may overlap if the target is the current process
+            unsafe {
+                if is_write {
+                    std::ptr::copy(local_ptr, remote_ptr, len);
+                } else {
+                    std::ptr::copy(remote_ptr, local_ptr, len);
+                }
+            }
+            copied_len += len;
+            remote_offset += len;
+            local_offset += len;
+            if local_offset == local_iov.iov_len {
+                local = local_iovs.next();
+                local_offset = 0;
+            }
+            if remote_offset == remote.iov_len {
+                break;
+            }
+        }
+    }
+    Ok(copied_len)
+}
+
+fn clone_iovs(iov: *const libc::iovec, count: u64) -> Result<Vec<libc::iovec>> {
+    if count > IOV_MAX {
+        return_errno!(EINVAL, "too many iovecs");
+    }
+    let count = count as usize;
+    if count == 0 {
+        return Ok(Vec::new());
+    }
+    from_user::check_array(iov, count)?;
+    let iovs = unsafe { std::slice::from_raw_parts(iov, count) }.to_vec();
+    let total_len = iovs
+        .iter()
+        .try_fold(0usize, |total, iov| total.checked_add(iov.iov_len))
+        .ok_or_else(|| errno!(EINVAL, "the total length overflows"))?;
+    if total_len > isize::MAX as usize {
+        return_errno!(EINVAL, "the total length overflows");
+    }
+    Ok(iovs)
+}
@@ -0,0 +1,157 @@
+//! The memory of a process reclaimed by madvise, i.e., discarded by MADV_DONTNEED or
+//! freed lazily by MADV_FREE, which is shown in /proc/meminfo and /proc/[pid]/status.
+//!
+//! The memory of the user space is committed as a whole, so a reclaimed page is never
+//! decommitted, and there is no page fault to tell when it is used again. Instead, the
+//! reclaimed pages are tracked by ranges, which are forgotten when they are unmapped,
+//! mapped again or made unreadable. A discarded page is known to be zeros, and a page
+//! freed lazily is remembered by the digest of its content. So the pages written since
+//! they are reclaimed are found, and forgotten, when the sizes are read.
+//!
+//! Only the readable anonymous memory is tracked, as its pages are read to find the
+//! writes. The ranges are forgotten before the pages are unmapped, so the pages of a
+//! tracked range can always be read.
+
+use super::*;
+
+use std::collections::BTreeMap;
+
+#[derive(Debug, Default)]
+pub struct ReclaimStat {
+    // The reclaimed ranges, which never overlap, by their start addresses
+    ranges: SgxMutex<BTreeMap<usize, ReclaimedRange>>,
+}
+
+#[derive(Debug)]
+struct ReclaimedRange {
+    end: usize,
+    // The digests of the pages freed lazily, or None if the pages are discarded
+    digests: Option<Vec<u64>>,
+}
+
+impl ReclaimStat {
+    /// Track the range reclaimed by the advice, which replaces the advice taken by the
+    /// range before
+    pub fn add(&self, range: &VMRange, advice: MAdvice) {
+        let digests = match advice {
+            MAdvice::DontNeed => None,
+            MAdvice::Free => Some(
+                (range.start()..range.end())
+                    .step_by(PAGE_SIZE)
+                    .map(|addr| unsafe { page_digest(addr) })
+                    .collect(),
+            ),
+            _ => return,
+        };
+        let mut ranges = self.ranges.lock().unwrap();
+        Self::remove(&mut ranges, range);
+        ranges.insert(
+            range.start(),
+            ReclaimedRange {
+                end: range.end(),
+                digests,
+            },
+        );
+    }
+
+    /// Forget the reclaimed memory in the range, which must be called before the pages
+    /// are unmapped, mapped again or made unreadable
+    pub fn forget(&self, range: &VMRange) {
+        let mut ranges = self.ranges.lock().unwrap();
+        Self::remove(&mut ranges, range);
+    }
+
+    pub fn clear(&self) {
+        self.ranges.lock().unwrap().clear();
+    }
+
+    /// Return the sizes of the memory discarded and freed lazily, which are still not
+    /// written
+    pub fn sizes(&self) -> (usize, usize) {
+        let mut ranges = self.ranges.lock().unwrap();
+        // Keep the runs of the pages that are not written
+        for (start, range) in std::mem::take(&mut *ranges) {
+            let mut run_start = None;
+            for (idx, addr) in (start..range.end).step_by(PAGE_SIZE).enumerate() {
+                let is_reclaimed = match &range.digests {
+                    None => unsafe { is_zero_page(addr) },
+                    Some(digests) => unsafe { page_digest(addr) == digests[idx] },
+                };
+                match (is_reclaimed, run_start) {
+                    (true, None) => run_start = Some(addr),
+                    (false, Some(run)) => {
+                        ranges.insert(run, range.part(start, run, addr));
+                        run_start = None;
+                    }
+                    _ => {}
+                }
+            }
+            if let Some(run) = run_start {
+                ranges.insert(run, range.part(start, run, range.end));
+            }
+        }
+
+        ranges
+            .iter()
+            .fold((0, 0), |(discarded, lazy_freed), (start, range)| {
+                let size = range.end - start;
+                match range.digests {
+                    None => (discarded + size, lazy_freed),
+                    Some(_) => (discarded, lazy_freed + size),
+                }
+            })
+    }
+
+    fn remove(ranges: &mut BTreeMap<usize, ReclaimedRange>, range: &VMRange) {
+        // The ranges overlapping with the range, whose ends are in order as their starts
+        let overlapped: Vec<usize> = ranges
+            .range(..range.end())
+            .rev()
+            .take_while(|(_, reclaimed)| reclaimed.end > range.start())
+            .map(|(&start, _)| start)
+            .collect();
+        for start in overlapped {
+            let reclaimed = ranges.remove(&start).unwrap();
+            if start < range.start() {
+                ranges.insert(start, reclaimed.part(start, start, range.start()));
+            }
+            if reclaimed.end > range.end() {
+                ranges.insert(
+                    range.end(),
+                    reclaimed.part(start, range.end(), reclaimed.end),
+                );
+            }
+        }
+    }
+}
+
+impl ReclaimedRange {
+    // The part from `part_start` to `part_end` of the range starting at `start`
+    fn part(&self, start: usize, part_start: usize, part_end: usize) -> Self {
+        let digests = self.digests.as_ref().map(|digests| {
+            digests[(part_start - start) / PAGE_SIZE..(part_end - start) / PAGE_SIZE].to_vec()
+        });
+        Self {
+            end: part_end,
+            digests,
+        }
+    }
+}
+
+// The words of a page, which are read volatile as they may be written by the user
+// at the same time
+unsafe fn page_words(addr: usize) -> impl Iterator<Item = u64> {
+    let words = addr as *const u64;
+    (0..PAGE_SIZE / 8).map(move |idx| words.add(idx).read_volatile())
+}
+
+unsafe fn is_zero_page(addr: usize) -> bool {
+    page_words(addr).all(|word| word == 0)
+}
+
+// The FNV-1a digest of the words of a page
+unsafe fn page_digest(addr: usize) -> u64 {
+    page_words(addr).fold(0xcbf2_9ce4_8422_2325, |digest, word| {
+        (digest ^ word).wrapping_mul(0x100_0000_01b3)
+    })
+}
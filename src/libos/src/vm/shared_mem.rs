@@ -0,0 +1,291 @@
+//! Shared memory, i.e., the pages of the files of tmpfs, e.g., memfd.
+//!
+//! The pages of a file are kept in one chunk of the user space. As all the processes
+//! share the address space of the enclave, a shared mapping of the file is just the
+//! address of its pages, so that every sharer accesses the same pages without copying
+//! them in at mmap or writing them back at munmap, like SysV shared memory. The pages
+//! are freed when the file is dropped and no process maps it anymore.
+//!
+//! The chunk cannot move while the file is mapped. So a mapped file cannot grow
+//! beyond the pages that it has when it is mapped first, which is usually its size,
+//! as the file is truncated to its size before it is mapped.
+
+use super::*;
+
+use super::user_space_vm::USER_SPACE_VM_MANAGER;
+use super::vm_util::{VMInitializer, VMMapOptionsBuilder};
+use std::collections::HashSet;
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+/// The total size of the shared memory (bytes)
+pub static SHMEM_SIZE: AtomicUsize = AtomicUsize::new(0);
+
+lazy_static! {
+    // All the chunks of the shared memory, e.g., those of the files left in /dev/shm,
+    // which are freed when LibOS exits
+    static ref SHMEM_CHUNKS: SgxMutex<HashSet<ChunkRef>> = SgxMutex::new(HashSet::new());
+}
+
+fn alloc_chunk(size: usize) -> Result<ChunkRef> {
+    let options = VMMapOptionsBuilder::default()
+        .size(size)
+        .perms(VMPerms::READ | VMPerms::WRITE)
+        .initializer(VMInitializer::FillZeros())
+        .build()?;
+    let chunk = USER_SPACE_VM_MANAGER.internal().mmap_chunk(&options)?;
+    SHMEM_CHUNKS.lock().unwrap().insert(chunk.clone());
+    SHMEM_SIZE.fetch_add(size, Ordering::Relaxed);
+    Ok(chunk)
+}
+
+fn free_chunk(chunk: &ChunkRef) {
+    if SHMEM_CHUNKS.lock().unwrap().remove(chunk) {
+        SHMEM_SIZE.fetch_sub(chunk.range().size(), Ordering::Relaxed);
+        USER_SPACE_VM_MANAGER.internal().munmap_chunk(chunk, None);
+    }
+}
+
+pub fn clean_shared_mem_when_libos_exit() {
+    let chunks: Vec<ChunkRef> = SHMEM_CHUNKS.lock().unwrap().iter().cloned().collect();
+    chunks.iter().for_each(|chunk| free_chunk(chunk));
+}
+
+pub struct SharedMem {
+    inner: SgxMutex<Inner>,
+}
+
+struct Inner {
+    chunk: Option<ChunkRef>,
+    len: usize,
+    nr_mappings: usize,
+    nr_writable_mappings: usize,
+}
+
+impl SharedMem {
+    pub fn new() -> Self {
+        Self {
+            inner: SgxMutex::new(Inner {
+                chunk: None,
+                len: 0,
+                nr_mappings: 0,
+                nr_writable_mappings: 0,
+            }),
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.inner.lock().unwrap().len
+    }
+
+    pub fn nr_writable_mappings(&self) -> usize {
+        self.inner.lock().unwrap().nr_writable_mappings
+    }
+
+    pub fn read_at(&self, offset: usize, buf: &mut [u8]) -> usize {
+        let inner = self.inner.lock().unwrap();
+        let start = inner.len.min(offset);
+        let end = inner.len.min(offset.saturating_add(buf.len()));
+        let len = end - start;
+        buf[..len].copy_from_slice(&inner.pages()[start..end]);
+        len
+    }
+
+    pub fn write_at(&self, offset: usize, buf: &[u8]) -> Result<usize> {
+        let mut inner = self.inner.lock().unwrap();
+        let end = offset
+            .checked_add(buf.len())
+            .ok_or_else(|| errno!(EFBIG, "the file is too large"))?;
+        if end > inner.capacity() {
+            // Reserve more to append without moving the pages each time
+            let capacity = max(align_up(end, PAGE_SIZE), inner.capacity() * 2);
+            inner.reserve(capacity)?;
+        }
+        inner.pages()[offset..end].copy_from_slice(buf);
+        inner.len = max(inner.len, end);
+        Ok(buf.len())
+    }
+
+    pub fn resize(&self, len: usize) -> Result<()> {
+        let mut inner = self.inner.lock().unwrap();
+        if len > inner.len {
+            inner.reserve(align_up(len, PAGE_SIZE))?;
+        } else {
+            // The truncated bytes are zeros when the file grows again
+            let old_len = inner.len;
+            for byte in &mut inner.pages()[len..old_len] {
+                *byte = 0;
+            }
+            if inner.nr_mappings == 0 && align_up(len, PAGE_SIZE) < inner.capacity() {
+                inner.realloc(align_up(len, PAGE_SIZE))?;
+            }
+        }
+        inner.len = len;
+        Ok(())
+    }
+
+    /// Map the pages from the offset with the permissions, and return the address of
+    /// them
+    pub fn map(
+        self: &Arc<Self>,
+        offset: usize,
+        size: usize,
+        perms: VMPerms,
+    ) -> Result<SharedMapping> {
+        if offset % PAGE_SIZE != 0 {
+            return_errno!(EINVAL, "the offset must be page aligned");
+        }
+        let size = align_up(size, PAGE_SIZE);
+        let end = offset
+            .checked_add(size)
+            .ok_or_else(|| errno!(EINVAL, "the mapping is too large"))?;
+
+        let mut inner = self.inner.lock().unwrap();
+        inner.reserve(end)?;
+        let addr = inner.chunk.as_ref().unwrap().range().start() + offset;
+        let range = VMRange::new_with_size(addr, size)?;
+        drop(inner);
+        Ok(self.new_mapping(range, perms, perms.can_write()))
+    }
+
+    fn new_mapping(
+        self: &Arc<Self>,
+        range: VMRange,
+        perms: VMPerms,
+        is_writable: bool,
+    ) -> SharedMapping {
+        let mut inner = self.inner.lock().unwrap();
+        inner.nr_mappings += 1;
+        if is_writable {
+            inner.nr_writable_mappings += 1;
+        }
+        SharedMapping {
+            range,
+            mem: self.clone(),
+            perms,
+            is_writable,
+        }
+    }
+
+    fn unmap(&self, is_writable: bool) {
+        let mut inner = self.inner.lock().unwrap();
+        inner.nr_mappings -= 1;
+        if is_writable {
+            inner.nr_writable_mappings -= 1;
+        }
+    }
+}
+
+impl Drop for SharedMem {
+    fn drop(&mut self) {
+        let inner = self.inner.get_mut().unwrap();
+        if let Some(chunk) = inner.chunk.take() {
+            free_chunk(&chunk);
+        }
+    }
+}
+
+impl Inner {
+    fn capacity(&self) -> usize {
+        self.chunk
+            .as_ref()
+            .map(|chunk| chunk.range().size())
+            .unwrap_or(0)
+    }
+
+    fn pages(&self) -> &mut [u8] {
+        match &self.chunk {
+            Some(chunk) => unsafe { chunk.range().as_slice_mut() },
+            None => &mut [],
+        }
+    }
+
+    fn reserve(&mut self, capacity: usize) -> Result<()> {
+        if capacity <= self.capacity() {
+            return Ok(());
+        }
+        if self.nr_mappings > 0 {
+            return_errno!(ENOMEM, "the mapped shared memory cannot grow");
+        }
+        self.realloc(capacity)
+    }
+
+    // Move the pages to a new chunk of the capacity, which is page aligned
+    fn realloc(&mut self, capacity: usize) -> Result<()> {
+        debug_assert!(self.nr_mappings == 0 && capacity % PAGE_SIZE == 0);
+        let new_chunk = if capacity > 0 {
+            let chunk = alloc_chunk(capacity)?;
+            let len = self.len.min(capacity);
+            unsafe { chunk.range().as_slice_mut() }
+            [..len].copy_from_slice(&self.pages()[..len]);
+            Some(chunk)
+        } else {
+            None
+        };
+        if let Some(old_chunk) = std::mem::replace(&mut self.chunk, new_chunk) {
+            free_chunk(&old_chunk);
+        }
+        Ok(())
+    }
+}
+
+/// A shared mapping of a process, which keeps the pages mapped until it is dropped
+///
+/// The pages are shared by all the mappings, so the permissions of a mapping are not
+/// applied to the pages but checked when the kernel accesses the mapping. A mapping
+/// that is not writable when it is mapped never becomes writable, as the file may not
+/// be opened for writes or may be sealed against them.
+pub struct SharedMapping {
+    range: VMRange,
+    mem: Arc<SharedMem>,
+    perms: VMPerms,
+    is_writable: bool,
+}
+
+impl SharedMapping {
+    pub fn range(&self) -> &VMRange {
+        &self.range
+    }
+
+    pub fn perms(&self) -> VMPerms {
+        self.perms
+    }
+
+    pub fn is_writable(&self) -> bool {
+        self.is_writable
+    }
+
+    pub fn set_perms(&mut self, perms: VMPerms) -> Result<()> {
+        if perms.can_write() && !self.is_writable {
+            return_errno!(EACCES, "the shared mapping cannot be writable");
+        }
+        self.perms = perms;
+        Ok(())
+    }
+
+    /// Split the mapping at the page-aligned address inside it, and return the part
+    /// from the address, which is another mapping of the pages
+    pub fn split_off(&mut self, addr: usize) -> SharedMapping {
+        debug_assert!(addr % PAGE_SIZE == 0);
+        debug_assert!(addr > self.range.start() && addr < self.range.end());
+        let tail_range = VMRange::new(addr, self.range.end()).unwrap();
+        self.range.set_end(addr);
+        self.mem
+            .new_mapping(tail_range, self.perms, self.is_writable)
+    }
+}
+
+impl Drop for SharedMapping {
+    fn drop(&mut self) {
+        self.mem.unmap(self.is_writable);
+    }
+}
+
+impl Debug for SharedMapping {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        f.debug_struct("SharedMapping")
+            .field("range", &self.range)
+            .field("perms", &self.perms)
+            .field("is_writable", &self.is_writable)
+            .finish()
+    }
+}
@@ -1,4 +1,5 @@
 use super::ipc::SHM_MANAGER;
+use super::shared_mem::clean_shared_mem_when_libos_exit;
 use super::*;
 use crate::ctor::dtor;
 use crate::util::pku_util;
@@ -51,6 +52,7 @@ impl UserSpaceVMManager {
 #[dtor]
 fn free_user_space() {
     SHM_MANAGER.clean_when_libos_exit();
+    clean_shared_mem_when_libos_exit();
     let range = USER_SPACE_VM_MANAGER.range();
     assert!(USER_SPACE_VM_MANAGER.verified_clean_when_exit());
     let addr = range.start();
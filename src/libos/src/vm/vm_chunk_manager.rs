@@ -404,6 +404,100 @@ impl ChunkManager {
         Ok(())
     }
 
+    /// Apply the advice to the VMAs of the current process in the given range. Return the
+    /// size of the VMAs in the range and the ranges of the memory reclaimed.
+    pub fn madvise_by_range(
+        &mut self,
+        advise_range: &VMRange,
+        advice: MAdvice,
+        elf_ranges: &[VMRange],
+    ) -> Result<(usize, Vec<VMRange>)> {
+        let current_pid = current!().process().pid();
+        let mut mapped_size = 0;
+        let mut reclaimed_ranges = Vec::new();
+        for vma_obj in &self.vmas {
+            if vma_obj.vma().pid() != current_pid {
+                continue;
+            }
+            let vma = match vma_obj.vma().intersect(advise_range) {
+                None => continue,
+                Some(vma) => vma,
+            };
+            mapped_size += vma.size();
+            if Self::madvise_vma(&vma, advice, elf_ranges)? {
+                reclaimed_ranges.push(*vma.range());
+            }
+        }
+        Ok((mapped_size, reclaimed_ranges))
+    }
+
+    /// Apply the advice to a VMA. Return whether the memory is reclaimed and can be
+    /// tracked by ReclaimStat, i.e., it is readable anonymous memory.
+    ///
+    /// The memory of Occlum is committed when the user space is initialized, so there is
+    /// no page to be decommitted or faulted in. Instead, MADV_DONTNEED discards the
+    /// content, MADV_FREE keeps the content (which is allowed as the memory may be
+    /// written again), and MADV_WILLNEED touches the pages to get them paged in EPC.
+    pub fn madvise_vma(vma: &VMArea, advice: MAdvice, elf_ranges: &[VMRange]) -> Result<bool> {
+        match advice {
+            MAdvice::DontNeed => {
+                let is_discarded = Self::discard_vma(vma, elf_ranges)?;
+                Ok(is_discarded && vma.init_file().is_none() && vma.perms().can_read())
+            }
+            MAdvice::Free => {
+                if vma.init_file().is_some() {
+                    return_errno!(EINVAL, "MADV_FREE is only for private anonymous memory");
+                }
+                Ok(vma.perms().can_read())
+            }
+            MAdvice::WillNeed => {
+                if vma.init_file().is_some() && vma.perms().can_read() {
+                    for addr in (vma.start()..vma.end()).step_by(PAGE_SIZE) {
+                        unsafe { core::ptr::read_volatile(addr as *const u8) };
+                    }
+                }
+                Ok(false)
+            }
+            _ => Ok(false),
+        }
+    }
+
+    /// Discard the content of a VMA, so that it reads the same as a new mapping, i.e.,
+    /// zeros for anonymous memory and the file content for private file-backed memory.
+    /// Return whether the content is discarded.
+    fn discard_vma(vma: &VMArea, elf_ranges: &[VMRange]) -> Result<bool> {
+        // The content of shared file-backed memory is the content of the file
+        if vma.writeback_file().is_some() {
+            return Ok(false);
+        }
+        // The ELF segments are loaded specially and can't be read again from the file
+        if elf_ranges
+            .iter()
+            .any(|range| range.overlap_with(vma.range()))
+        {
+            return Ok(false);
+        }
+
+        if !vma.perms().is_default() {
+            VMPerms::apply_perms(vma, VMPerms::default());
+        }
+        let buf = unsafe { vma.as_slice_mut() };
+        let ret = match vma.init_file() {
+            Some((file, file_offset)) => file
+                .read_at(file_offset, buf)
+                .map(|len| buf[len..].iter_mut().for_each(|b| *b = 0))
+                .cause_err(|_| errno!(EACCES, "failed to read memory from file")),
+            None => {
+                buf.iter_mut().for_each(|b| *b = 0);
+                Ok(())
+            }
+        };
+        if !vma.perms().is_default() {
+            VMPerms::apply_perms(vma, vma.perms());
+        }
+        ret.map(|_| true)
+    }
+
     /// Sync all shared, file-backed memory mappings of the given file by flushing
     /// the memory content to the file.
     pub fn msync_by_file(&mut self, sync_file: &FileRef) {
@@ -438,16 +532,26 @@ impl ChunkManager {
     }
 
     pub fn find_mmap_region(&self, addr: usize) -> Result<VMRange> {
+        self.find_vma(addr).map(|vma| vma.range().clone())
+    }
+
+    // Return: a copy of the vma that contains the address
+    pub fn find_vma(&self, addr: usize) -> Result<VMArea> {
+        self.find_vma_of_process(addr, current!().process().pid())
+    }
+
+    // Return: a copy of the vma of the process that contains the address
+    pub fn find_vma_of_process(&self, addr: usize, pid: pid_t) -> Result<VMArea> {
         let vma = self.vmas.upper_bound(Bound::Included(&addr));
         if vma.is_null() {
             return_errno!(ESRCH, "no mmap regions that contains the address");
         }
         let vma = vma.get().unwrap().vma();
-        if vma.pid() != current!().process().pid() || !vma.contains(addr) {
+        if vma.pid() != pid || !vma.contains(addr) {
             return_errno!(ESRCH, "no mmap regions that contains the address");
         }
 
-        return Ok(vma.range().clone());
+        return Ok(vma.clone());
     }
 
     pub fn usage_percentage(&self) -> f32 {
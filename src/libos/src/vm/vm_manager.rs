@@ -4,6 +4,7 @@ use super::chunk::{
     Chunk, ChunkID, ChunkRef, ChunkType, CHUNK_DEFAULT_SIZE, DUMMY_CHUNK_PROCESS_ID,
 };
 use super::free_space_manager::VMFreeSpaceManager;
+use super::numa::{self, NumaPools};
 use super::vm_area::VMArea;
 use super::vm_chunk_manager::ChunkManager;
 use super::vm_perms::VMPerms;
@@ -22,14 +23,17 @@ use std::collections::{BTreeSet, HashSet};
 #[derive(Debug)]
 pub struct VMManager {
     range: VMRange,
+    numa_pools: NumaPools,
     internal: SgxMutex<InternalVMManager>,
 }
 
 impl VMManager {
     pub fn init(vm_range: VMRange) -> Result<Self> {
-        let internal = InternalVMManager::init(vm_range.clone());
+        let numa_pools = NumaPools::new(&vm_range);
+        let internal = InternalVMManager::init(vm_range.clone(), numa_pools.clone());
         Ok(VMManager {
             range: vm_range,
+            numa_pools,
             internal: SgxMutex::new(internal),
         })
     }
@@ -38,6 +42,17 @@ impl VMManager {
         &self.range
     }
 
+    pub fn numa_pools(&self) -> &NumaPools {
+        &self.numa_pools
+    }
+
+    // Return the total size and the free size of the pool of the node
+    pub fn numa_node_usage(&self, node: u32) -> (usize, usize) {
+        let pool = self.numa_pools.pool(node);
+        let free_size = self.internal().free_manager.free_size_within(pool);
+        (pool.size(), free_size)
+    }
+
     pub fn internal(&self) -> SgxMutexGuard<InternalVMManager> {
         self.internal.lock().unwrap()
     }
@@ -84,7 +99,7 @@ impl VMManager {
             }
         }
 
-        if size > CHUNK_DEFAULT_SIZE {
+        if is_large_mapping(size, align) {
             if let Ok(new_chunk) = self.internal().mmap_chunk(options) {
                 let start = new_chunk.range().start();
                 current!().vm().add_mem_chunk(new_chunk);
@@ -96,17 +111,22 @@ impl VMManager {
 
         // Allocate in default chunk
         let current = current!();
+        // The nodes allowed by the memory policy, in the order of preference
+        let nodes = numa::current_alloc_nodes(&self.numa_pools);
+        let node_of_chunk = |chunk: &ChunkRef| self.numa_pools.node_of(chunk.range().start());
         {
             // Fast path: Try to go to assigned chunks to do mmap
             // There is no lock on VMManager in this path.
             let process_mem_chunks = current.vm().mem_chunks().read().unwrap();
-            for chunk in process_mem_chunks
-                .iter()
-                .filter(|&chunk| !chunk.is_single_vma())
-            {
-                let result_start = chunk.try_mmap(options);
-                if result_start.is_ok() {
-                    return result_start;
+            for &node in nodes.iter() {
+                for chunk in process_mem_chunks
+                    .iter()
+                    .filter(|&chunk| !chunk.is_single_vma() && node_of_chunk(chunk) == node)
+                {
+                    let result_start = chunk.try_mmap(options);
+                    if result_start.is_ok() {
+                        return result_start;
+                    }
                 }
             }
         }
@@ -131,7 +151,7 @@ impl VMManager {
             let chunks = &self.internal().chunks;
             let chunk = chunks
                 .iter()
-                .filter(|&chunk| !chunk.is_single_vma())
+                .filter(|&chunk| !chunk.is_single_vma() && nodes.contains(&node_of_chunk(chunk)))
                 .find(|&chunk| {
                     result_start = chunk.mmap(options);
                     result_start.is_ok()
@@ -360,6 +380,51 @@ impl VMManager {
         Ok(())
     }
 
+    /// Apply the advice to the memory of the current process in the range. Return the
+    /// size of the mapped memory in the range and the ranges of the memory reclaimed.
+    pub fn madvise(
+        &self,
+        advise_range: &VMRange,
+        advice: MAdvice,
+        elf_ranges: &[VMRange],
+    ) -> Result<(usize, Vec<VMRange>)> {
+        let chunks = {
+            let current = current!();
+            let process_mem_chunks = current.vm().mem_chunks().read().unwrap();
+            process_mem_chunks
+                .iter()
+                .filter(|chunk| chunk.range().overlap_with(advise_range))
+                .cloned()
+                .collect::<Vec<ChunkRef>>()
+        };
+
+        let mut mapped_size = 0;
+        let mut reclaimed_ranges = Vec::new();
+        for chunk in chunks {
+            match chunk.internal() {
+                ChunkType::MultiVMA(manager) => {
+                    let (mapped, reclaimed) = manager
+                        .lock()
+                        .unwrap()
+                        .chunk_manager_mut()
+                        .madvise_by_range(advise_range, advice, elf_ranges)?;
+                    mapped_size += mapped;
+                    reclaimed_ranges.extend(reclaimed);
+                }
+                ChunkType::SingleVMA(vma) => {
+                    let vma = vma.lock().unwrap();
+                    if let Some(vma) = vma.intersect(advise_range) {
+                        mapped_size += vma.size();
+                        if ChunkManager::madvise_vma(&vma, advice, elf_ranges)? {
+                            reclaimed_ranges.push(*vma.range());
+                        }
+                    }
+                }
+            }
+        }
+        Ok((mapped_size, reclaimed_ranges))
+    }
+
     pub fn msync_by_file(&self, sync_file: &FileRef) {
         let current = current!();
         let process_mem_chunks = current.vm().mem_chunks().read().unwrap();
@@ -383,6 +448,9 @@ impl VMManager {
     pub fn mremap(&self, options: &VMRemapOptions) -> Result<usize> {
         let old_addr = options.old_addr();
         let old_size = options.old_size();
+        if old_size == 0 {
+            return self.mremap_duplicate(options);
+        }
         let old_range = VMRange::new_with_size(old_addr, old_size)?;
         let new_size = options.new_size();
         let size_type = VMRemapSizeType::new(&old_size, &new_size);
@@ -421,38 +489,63 @@ impl VMManager {
             chunk.unwrap().clone()
         };
 
-        // Parse the mremap options to mmap options and munmap options
-        let remap_result_option = match chunk.internal() {
-            ChunkType::MultiVMA(manager) => manager
-                .lock()
-                .unwrap()
-                .chunk_manager_mut()
-                .parse_mremap_options(options),
-            ChunkType::SingleVMA(vma) => {
-                self.parse_mremap_options_for_single_vma_chunk(options, vma)
+        // Grow a single VMA chunk into the adjacent free range in place, which needs neither
+        // a new chunk nor copying
+        if size_type == VMRemapSizeType::Growing && options.flags().new_addr().is_none() {
+            if let ChunkType::SingleVMA(_) = chunk.internal() {
+                let mut internal_manager = self.internal();
+                if internal_manager
+                    .grow_single_vma_chunk(&current, &chunk, &old_range, new_size)
+                    .is_ok()
+                {
+                    return Ok(old_addr);
+                }
             }
-        }?;
-        trace!("mremap options after parsing = {:?}", remap_result_option);
-
-        let ret_addr = if let Some(mmap_options) = remap_result_option.mmap_options() {
-            let mmap_addr = self.mmap(mmap_options);
+        }
 
-            // FIXME: For MRemapFlags::MayMove flag, we checked if the prefered range is free when parsing the options.
-            // But there is no lock after the checking, thus the mmap might fail. In this case, we should try mmap again.
-            if mmap_addr.is_err() && remap_result_option.may_move() == true {
-                return_errno!(
-                    EAGAIN,
-                    "There might still be a space for this mremap request"
-                );
-            }
+        let mut retries = 0;
+        let (remap_result_option, ret_addr) = loop {
+            // Parse the mremap options to mmap options and munmap options
+            let remap_result_option = match chunk.internal() {
+                ChunkType::MultiVMA(manager) => manager
+                    .lock()
+                    .unwrap()
+                    .chunk_manager_mut()
+                    .parse_mremap_options(options),
+                ChunkType::SingleVMA(vma) => {
+                    self.parse_mremap_options_for_single_vma_chunk(options, vma)
+                }
+            }?;
+            trace!("mremap options after parsing = {:?}", remap_result_option);
+
+            let ret_addr = if let Some(mmap_options) = remap_result_option.mmap_options() {
+                let mmap_addr = self.mmap(mmap_options);
+
+                // For MRemapFlags::MayMove flag, we checked if the prefered range is free when parsing the options.
+                // But there is no lock after the checking, thus the mmap might fail. In this case, parse the options
+                // again, which moves the old range if the prefered range is not free any more.
+                if mmap_addr.is_err() && remap_result_option.may_move() {
+                    retries += 1;
+                    if retries < MREMAP_MAX_RETRIES {
+                        continue;
+                    }
+                    return_errno!(
+                        EAGAIN,
+                        "There might still be a space for this mremap request"
+                    );
+                }
 
-            if remap_result_option.mmap_result_addr().is_none() {
-                mmap_addr.unwrap()
+                match remap_result_option.mmap_result_addr() {
+                    None => mmap_addr?,
+                    Some(addr) => {
+                        mmap_addr?;
+                        *addr
+                    }
+                }
             } else {
-                remap_result_option.mmap_result_addr().unwrap()
-            }
-        } else {
-            old_addr
+                old_addr
+            };
+            break (remap_result_option, ret_addr);
         };
 
         if let Some((munmap_addr, munmap_size)) = remap_result_option.munmap_args() {
@@ -463,6 +556,39 @@ impl VMManager {
         return Ok(ret_addr);
     }
 
+    // Duplicate a shared mapping for mremap with zero old_size. Only shared file-backed mappings
+    // can be duplicated, as two ranges can not share the same memory pages without paging. The new
+    // mapping is backed by the same file, which is synced on msync and munmap.
+    fn mremap_duplicate(&self, options: &VMRemapOptions) -> Result<usize> {
+        let old_addr = options.old_addr();
+        let vma = {
+            let current = current!();
+            let process_mem_chunks = current.vm().mem_chunks().read().unwrap();
+            process_mem_chunks
+                .iter()
+                .find_map(|chunk| chunk.find_vma(old_addr).ok())
+                .ok_or_else(|| errno!(EFAULT, "no mapping contains the old address"))?
+        };
+        let file_backed = match vma.writeback_file() {
+            Some((file, offset)) => {
+                FileBacked::new(file.clone(), offset + (old_addr - vma.start()), true)
+            }
+            None => return_errno!(EINVAL, "only shared file-backed mappings can be duplicated"),
+        };
+        let addr = match options.flags() {
+            MRemapFlags::MayMove => VMMapAddr::Any,
+            MRemapFlags::FixedAddr(new_addr) => VMMapAddr::Force(new_addr),
+            MRemapFlags::None => unreachable!(),
+        };
+        let mmap_options = VMMapOptionsBuilder::default()
+            .size(options.new_size())
+            .addr(addr)
+            .perms(vma.perms())
+            .initializer(VMInitializer::FileBacked { file: file_backed })
+            .build()?;
+        self.mmap(&mmap_options)
+    }
+
     fn parse_mremap_options_for_single_vma_chunk(
         &self,
         options: &VMRemapOptions,
@@ -494,10 +620,11 @@ pub struct InternalVMManager {
     chunks: BTreeSet<ChunkRef>, // track in-use chunks, use B-Tree for better performance and simplicity (compared with red-black tree)
     fast_default_chunks: Vec<ChunkRef>, // empty default chunks
     free_manager: VMFreeSpaceManager,
+    numa_pools: NumaPools,
 }
 
 impl InternalVMManager {
-    pub fn init(vm_range: VMRange) -> Self {
+    pub fn init(vm_range: VMRange, numa_pools: NumaPools) -> Self {
         let chunks = BTreeSet::new();
         let fast_default_chunks = Vec::new();
         let free_manager = VMFreeSpaceManager::new(vm_range);
@@ -505,13 +632,16 @@ impl InternalVMManager {
             chunks,
             fast_default_chunks,
             free_manager,
+            numa_pools,
         }
     }
 
     // Allocate a new chunk with default size
     pub fn mmap_chunk_default(&mut self, addr: VMMapAddr) -> Result<ChunkRef> {
-        // Find a free range from free_manager
-        let free_range = self.find_free_gaps(CHUNK_DEFAULT_SIZE, PAGE_SIZE, addr)?;
+        // Find a free range from free_manager. The chunk is aligned to huge page so that the
+        // mappings in it could be backed by huge pages of host.
+        let free_range =
+            self.find_free_range_for_chunk(CHUNK_DEFAULT_SIZE, HUGE_PAGE_SIZE, addr, false)?;
 
         // Add this range to chunks
         let chunk = Arc::new(Chunk::new_default_chunk(free_range)?);
@@ -525,7 +655,12 @@ impl InternalVMManager {
         let addr = *options.addr();
         let size = *options.size();
         let align = *options.align();
-        let free_range = self.find_free_gaps(size, align, addr)?;
+        let free_range = if is_large_mapping(size, align) && addr == VMMapAddr::Any {
+            // Large mappings are aligned to huge page and placed from the top of the pool
+            self.find_free_range_for_chunk(size, max(align, HUGE_PAGE_SIZE), addr, true)?
+        } else {
+            self.find_free_range_for_chunk(size, align, addr, false)?
+        };
         let free_chunk = Chunk::new_single_vma_chunk(&free_range, options);
         if let Err(e) = free_chunk {
             // Error when creating chunks. Must return the free space before returning error
@@ -635,6 +770,54 @@ impl InternalVMManager {
         Ok(())
     }
 
+    // Grow the single VMA chunk that ends with the old range into the adjacent free range
+    pub fn grow_single_vma_chunk(
+        &mut self,
+        current_thread: &ThreadRef,
+        chunk: &ChunkRef,
+        old_range: &VMRange,
+        new_size: usize,
+    ) -> Result<()> {
+        let vma = chunk.get_vma_for_single_vma_chunk();
+        if vma.end() != old_range.end() {
+            return_errno!(EINVAL, "the old range is not at the end of the chunk");
+        }
+        let writeback_file = vma.writeback_file();
+        if writeback_file.is_some() && old_range != vma.range() {
+            return_errno!(EINVAL, "Known limition");
+        }
+        let grow_range = VMRange::new_with_size(old_range.end(), new_size - old_range.size())?;
+        if !self.free_manager.is_free_range(&grow_range) {
+            return_errno!(ENOMEM, "the adjacent range is not free");
+        }
+        self.free_manager.find_free_range_internal(
+            grow_range.size(),
+            PAGE_SIZE,
+            VMMapAddr::Need(grow_range.start()),
+        )?;
+
+        // The free memory is zeros already. Only the file-backed memory needs to be initialized.
+        if let Some((file, offset)) = writeback_file {
+            let initializer = VMInitializer::FileBacked {
+                file: FileBacked::new(file.clone(), offset + vma.size(), true),
+            };
+            let buf = unsafe { grow_range.as_slice_mut() };
+            if let Err(e) = initializer.init_slice(buf) {
+                self.free_manager
+                    .add_range_back_to_free_manager(&grow_range);
+                return Err(e);
+            }
+        }
+        if !vma.perms().is_default() {
+            VMPerms::apply_perms(&grow_range, vma.perms());
+        }
+
+        let mut new_vma = vma;
+        new_vma.set_end(grow_range.end());
+        self.update_single_vma_chunk(current_thread, chunk, new_vma);
+        Ok(())
+    }
+
     fn update_single_vma_chunk(
         &mut self,
         current_thread: &ThreadRef,
@@ -779,6 +962,40 @@ impl InternalVMManager {
         Ok(())
     }
 
+    // Find a free range for a new chunk. Without an address, the range is found in the NUMA
+    // pools of the nodes allowed by the memory policy of the current thread, in the order
+    // of preference, from the top of the pool if `from_top` is set. If none of the pools
+    // fits, the range may be found in the whole user space unless the policy is MPOL_BIND.
+    fn find_free_range_for_chunk(
+        &mut self,
+        size: usize,
+        align: usize,
+        addr: VMMapAddr,
+        from_top: bool,
+    ) -> Result<VMRange> {
+        if addr != VMMapAddr::Any {
+            return self.find_free_gaps(size, align, addr);
+        }
+        for node in numa::current_alloc_nodes(&self.numa_pools) {
+            let pool = *self.numa_pools.pool(node);
+            if let Ok(free_range) = self
+                .free_manager
+                .find_free_range_within(size, align, &pool, from_top)
+            {
+                numa::current_chunk_allocated(&self.numa_pools, node);
+                return Ok(free_range);
+            }
+        }
+        // A large chunk may only fit across the pools
+        if numa::current_may_fall_back(&self.numa_pools) {
+            return self.find_free_gaps(size, align, addr);
+        }
+        return_errno!(
+            ENOMEM,
+            "not enough memory on the nodes of the memory policy"
+        );
+    }
+
     pub fn find_free_gaps(
         &mut self,
         size: usize,
@@ -980,3 +1197,11 @@ impl VMRemapParser for InternalVMManager {
         self.free_manager.is_free_range(request_range)
     }
 }
+
+// The max times of trying mremap when the free range is taken by others
+const MREMAP_MAX_RETRIES: usize = 3;
+
+// Large mappings are allocated as single VMA chunks aligned to huge page
+fn is_large_mapping(size: usize, align: usize) -> bool {
+    size > CHUNK_DEFAULT_SIZE || align >= HUGE_PAGE_SIZE
+}
@@ -51,12 +51,11 @@ impl VMInitializer {
                 }
             }
             VMInitializer::CopyFrom { range } => {
+                // Copy in bulk. The rest of the buffer is zeros already, as the free memory is
+                // always cleaned on munmap.
                 let src_slice = unsafe { range.as_slice() };
                 let copy_len = min(buf.len(), src_slice.len());
                 buf[..copy_len].copy_from_slice(&src_slice[..copy_len]);
-                for b in &mut buf[copy_len..] {
-                    *b = 0;
-                }
             }
             VMInitializer::FileBacked { file } => {
                 // TODO: make sure that read_at does not move file cursor
@@ -299,10 +298,12 @@ impl VMRemapOptions {
         } else {
             old_addr
         };
+        // Zero old_size means duplicating a shared mapping, which must move
         let old_size = if old_size == 0 {
-            // TODO: support old_size is zero for shareable mapping
-            warn!("do not support old_size is zero");
-            return_errno!(EINVAL, "invalid old size");
+            if flags == MRemapFlags::None {
+                return_errno!(EINVAL, "duplicating a mapping needs MREMAP_MAYMOVE");
+            }
+            0
         } else {
             align_up(old_size, PAGE_SIZE)
         };
@@ -8,7 +8,7 @@ extern "C" {
 /*
  * Occlum PAL API version number
  */
-#define OCCLUM_PAL_VERSION 2
+#define OCCLUM_PAL_VERSION 3
 
 /*
  * @brief Get version of Occlum PAL API
@@ -139,6 +139,22 @@ int occlum_pal_init(const struct occlum_pal_attr *attr);
  */
 int occlum_pal_create_process(struct occlum_pal_create_process_args *args);
 
+/*
+ * @brief Create a batch of new processes inside the Occlum enclave
+ *
+ * All the processes are created in one enclave entry, which is much cheaper
+ * than calling occlum_pal_create_process for each of them.
+ *
+ * @param args  Mandatory input. An array of arguments, one for each process.
+ *              The pid of each process is updated, or set to -errno if the
+ *              process fails to be created.
+ * @param num   The number of processes, which must be positive.
+ *
+ * @retval If 0, then success, even if some processes fail to be created;
+ *         otherwise, check errno for the exact error type.
+ */
+int occlum_pal_create_processes(struct occlum_pal_create_process_args *args, int num);
+
 /*
  * @brief Execute the process inside the Occlum enclave
  *
@@ -9,6 +9,62 @@ void occlum_ocall_sync(void) {
     sync();
 }
 
+// The opcodes of AIO requests, which must be consistent with the LibOS
+#define OCCLUM_AIO_NONE     (-1)
+#define OCCLUM_AIO_READ     0
+#define OCCLUM_AIO_WRITE    1
+#define OCCLUM_AIO_FSYNC    2
+#define OCCLUM_AIO_FDSYNC   3
+
+struct occlum_aio_req {
+    int fd;
+    int opcode;
+    // The sync done after writing
+    int sync_op;
+    void *buf;
+    size_t len;
+    off_t offset;
+    ssize_t res;
+};
+
+static ssize_t do_aio_sync(int fd, int sync_op) {
+    switch (sync_op) {
+        case OCCLUM_AIO_FSYNC:
+            return fsync(fd);
+        case OCCLUM_AIO_FDSYNC:
+            return fdatasync(fd);
+        default:
+            return 0;
+    }
+}
+
+void occlum_ocall_aio_batch(void *reqs, size_t nr_reqs) {
+    struct occlum_aio_req *req = (struct occlum_aio_req *) reqs;
+    for (size_t i = 0; i < nr_reqs; i++, req++) {
+        ssize_t ret;
+        switch (req->opcode) {
+            case OCCLUM_AIO_READ:
+                ret = pread(req->fd, req->buf, req->len, req->offset);
+                break;
+            case OCCLUM_AIO_WRITE:
+                ret = pwrite(req->fd, req->buf, req->len, req->offset);
+                if (ret >= 0 && do_aio_sync(req->fd, req->sync_op) < 0) {
+                    ret = -1;
+                }
+                break;
+            case OCCLUM_AIO_FSYNC:
+            case OCCLUM_AIO_FDSYNC:
+                ret = do_aio_sync(req->fd, req->opcode);
+                break;
+            default:
+                ret = -1;
+                errno = EINVAL;
+                break;
+        }
+        req->res = ret < 0 ? -errno : ret;
+    }
+}
+
 int occlum_ocall_ioctl_repack(int fd, int request, char *buf, int len, int *recv_len) {
     int ret = 0;
 
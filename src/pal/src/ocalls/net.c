@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/select.h>
@@ -56,6 +57,23 @@ ssize_t occlum_ocall_recvmsg(int sockfd,
     return ret;
 }
 
+int occlum_ocall_sendmmsg(int sockfd,
+                          void *msgvec,
+                          unsigned int vlen,
+                          int flags) {
+    // The messages are marshaled into an untrusted arena by the LibOS, which
+    // is passed as is to send all of them at once
+    return sendmmsg(sockfd, (struct mmsghdr *) msgvec, vlen, flags);
+}
+
+int occlum_ocall_recvmmsg(int sockfd,
+                          void *msgvec,
+                          unsigned int vlen,
+                          int flags,
+                          struct timespec *timeout) {
+    return recvmmsg(sockfd, (struct mmsghdr *) msgvec, vlen, flags, timeout);
+}
+
 int occlum_ocall_poll(struct pollfd *fds,
                       nfds_t nfds,
                       struct timeval *timeout,
@@ -28,6 +28,10 @@ int occlum_ocall_ncores(void) {
     return sysconf(_SC_NPROCESSORS_CONF);
 }
 
+int occlum_ocall_sched_getcpu(void) {
+    return sched_getcpu();
+}
+
 static int is_number(const char *str) {
     size_t len = strlen(str);
     for (size_t i = 0; i < len; i++) {
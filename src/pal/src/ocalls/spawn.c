@@ -2,6 +2,7 @@
 #include <pthread.h>
 #include "ocalls.h"
 #include "../pal_thread_counter.h"
+#include "../errno2str.h"
 
 typedef struct {
     sgx_enclave_id_t    enclave_id;
@@ -49,3 +50,52 @@ int occlum_ocall_exec_thread_async(int libos_tid) {
 
     return 0;
 }
+
+typedef struct {
+    sgx_enclave_id_t    enclave_id;
+    int                 vcpu_id;
+} vcpu_data_t;
+
+void *exec_libos_vcpu(void *_vcpu_data) {
+    vcpu_data_t *vcpu_data = _vcpu_data;
+    sgx_enclave_id_t eid = vcpu_data->enclave_id;
+    int host_tid = GETTID();
+    int vcpu_id = vcpu_data->vcpu_id;
+    int ret = 0;
+    sgx_status_t status = occlum_ecall_exec_vcpu(eid, &ret, vcpu_id, host_tid);
+    if (status != SGX_SUCCESS) {
+        const char *sgx_err = pal_get_sgx_error_msg(status);
+        PAL_ERROR("Failed to enter the enclave to run a vCPU (host tid = %d) with error code 0x%x: %s",
+                  host_tid, status, sgx_err);
+        exit(EXIT_FAILURE);
+    }
+    if (ret < 0) {
+        PAL_ERROR("occlum_ecall_exec_vcpu returns %s", errno2str(-ret));
+    }
+
+    free(vcpu_data);
+    pal_thread_counter_dec();
+    return NULL;
+}
+
+// Start a new host OS thread and enter the enclave to run the vCPU
+int occlum_ocall_exec_vcpu_async(int vcpu_id) {
+    int ret = 0;
+    pthread_t thread;
+
+    vcpu_data_t *vcpu_data = malloc(sizeof * vcpu_data);
+    vcpu_data->enclave_id = pal_get_enclave_id();
+    vcpu_data->vcpu_id = vcpu_id;
+
+    pal_thread_counter_inc();
+    if ((ret = pthread_create(&thread, NULL, exec_libos_vcpu, vcpu_data)) < 0) {
+        pal_thread_counter_dec();
+        free(vcpu_data);
+        return -1;
+    }
+    pthread_detach(thread);
+
+    // Note: vcpu_data is freed and thread counter is decreased just before the thread exits
+
+    return 0;
+}
@@ -1,6 +1,5 @@
 #include <pthread.h>
 #include <sys/time.h>
-#include <sys/timerfd.h>
 #include <sys/prctl.h>
 #include "ocalls.h"
 
@@ -43,16 +42,3 @@ void occlum_ocall_get_timerslack(int *timer_slack) {
     int nanoseconds = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
     *timer_slack = nanoseconds;
 }
-
-int occlum_ocall_timerfd_create(int clockid, int flags) {
-    return timerfd_create(clockid, flags);
-}
-
-int occlum_ocall_timerfd_settime(int fd, int flags, const struct itimerspec *new_value,
-                                 struct itimerspec *old_value) {
-    return timerfd_settime(fd, flags, new_value, old_value);
-}
-
-int occlum_ocall_timerfd_gettime(int fd, struct itimerspec *curr_value) {
-    return timerfd_gettime(fd, curr_value);
-}
\ No newline at end of file
@@ -8,12 +8,14 @@
 #include "pal_sig_handler.h"
 #include "pal_syscall.h"
 #include "pal_thread_counter.h"
+#include "pal_timer_thread.h"
 #include "pal_check_fsgsbase.h"
 #ifdef SGX_MODE_HYPER
 #include "pal_ms_buffer.h"
 #endif
 #include "errno2str.h"
 #include <linux/limits.h>
+#include <stdlib.h>
 
 int occlum_pal_get_version(void) {
     return OCCLUM_PAL_VERSION;
@@ -156,6 +158,13 @@ int occlum_pal_init(const struct occlum_pal_attr *attr) {
     }
     pal_clock(&ts, "finish pal_interrupt_thread_start");
 
+    pal_clock(&ts, "start pal_timer_thread_start");
+    if (pal_timer_thread_start() < 0) {
+        PAL_ERROR("Failed to start the timer thread: %s", errno2str(errno));
+        goto stop_interrupt_thread;
+    }
+    pal_clock(&ts, "finish pal_timer_thread_start");
+
     //pal_clock(&ts, "start pal_run_init_process");
     //if (pal_run_init_process() < 0) {
     //    PAL_ERROR("Failed to run the init process: %s", errno2str(errno));
@@ -165,10 +174,10 @@ int occlum_pal_init(const struct occlum_pal_attr *attr) {
 
     return 0;
 
-//stop_interrupt_thread:
-//    if (pal_interrupt_thread_stop() < 0) {
-//        PAL_WARN("Cannot stop the interrupt thread: %s", errno2str(errno));
-//    }
+stop_interrupt_thread:
+    if (pal_interrupt_thread_stop() < 0) {
+        PAL_WARN("Cannot stop the interrupt thread: %s", errno2str(errno));
+    }
 on_destroy_enclave:
     if (pal_destroy_enclave() < 0) {
         PAL_WARN("Cannot destroy the enclave");
@@ -226,6 +235,89 @@ int occlum_pal_create_process(struct occlum_pal_create_process_args *args) {
     return 0;
 }
 
+int occlum_pal_create_processes(struct occlum_pal_create_process_args *args, int num) {
+    int ecall_ret = 0;
+
+    if (args == NULL || num <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int i = 0; i < num; i++) {
+        if (args[i].path == NULL || args[i].argv == NULL || args[i].pid == NULL) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    sgx_enclave_id_t eid = pal_get_enclave_id();
+    if (eid == SGX_INVALID_ENCLAVE_ID) {
+        PAL_ERROR("Enclave is not initialized yet.");
+        errno = ENOENT;
+        return -1;
+    }
+
+    int *pids = calloc(num, sizeof(int));
+    if (pids == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+#ifndef SGX_MODE_HYPER
+    sgx_status_t ecall_status = occlum_ecall_new_processes(eid, &ecall_ret, args, pids,
+                                num);
+#else
+    struct occlum_pal_create_process_args *ms_args = calloc(num, sizeof(*ms_args));
+    if (ms_args == NULL) {
+        free(pids);
+        errno = ENOMEM;
+        return -1;
+    }
+    int num_converted = 0;
+    for (; num_converted < num; num_converted++) {
+        struct occlum_pal_create_process_args *ms_arg = &ms_args[num_converted];
+        *ms_arg = args[num_converted];
+        ms_arg->argv = ms_buffer_convert_string_array(eid, args[num_converted].argv);
+        ms_arg->env = ms_buffer_convert_string_array(eid, args[num_converted].env);
+        if ((!args[num_converted].argv != !ms_arg->argv) ||
+                (!args[num_converted].env != !ms_arg->env)) {
+            ms_buffer_string_array_free(eid, ms_arg->argv);
+            ms_buffer_string_array_free(eid, ms_arg->env);
+            break;
+        }
+    }
+    sgx_status_t ecall_status = SGX_SUCCESS;
+    if (num_converted < num) {
+        PAL_ERROR("Marshal buffer size is not enough");
+        ecall_ret = -ENOMEM;
+    } else {
+        ecall_status = occlum_ecall_new_processes(eid, &ecall_ret, ms_args, pids, num);
+    }
+    for (int i = 0; i < num_converted; i++) {
+        ms_buffer_string_array_free(eid, ms_args[i].argv);
+        ms_buffer_string_array_free(eid, ms_args[i].env);
+    }
+    free(ms_args);
+#endif
+    if (ecall_status != SGX_SUCCESS) {
+        const char *sgx_err = pal_get_sgx_error_msg(ecall_status);
+        PAL_ERROR("Failed to do ECall with error code 0x%x: %s", ecall_status, sgx_err);
+        free(pids);
+        return -1;
+    }
+    if (ecall_ret < 0) {
+        errno = -ecall_ret;
+        PAL_ERROR("occlum_ecall_new_processes returns %s", errno2str(errno));
+        free(pids);
+        return -1;
+    }
+
+    for (int i = 0; i < num; i++) {
+        *args[i].pid = pids[i];
+    }
+    free(pids);
+    return 0;
+}
+
 int occlum_pal_exec(struct occlum_pal_exec_args *args) {
     int host_tid = GETTID();
     int ecall_ret = 0;
@@ -295,6 +387,11 @@ int occlum_pal_destroy(void) {
     }
 
     int ret = 0;
+    if (pal_timer_thread_stop() < 0) {
+        ret = -1;
+        PAL_WARN("Cannot stop the timer thread: %s", errno2str(errno));
+    }
+
     if (pal_interrupt_thread_stop() < 0) {
         ret = -1;
         PAL_WARN("Cannot stop the interrupt thread: %s", errno2str(errno));
@@ -315,6 +412,9 @@ __attribute__ ((weak, alias ("occlum_pal_init")));
 int pal_create_process(struct occlum_pal_create_process_args *args)\
 __attribute__ ((weak, alias ("occlum_pal_create_process")));
 
+int pal_create_processes(struct occlum_pal_create_process_args *args, int num)\
+__attribute__ ((weak, alias ("occlum_pal_create_processes")));
+
 int pal_exec(struct occlum_pal_exec_args *args)\
 __attribute__ ((weak, alias ("occlum_pal_exec")));
 
@@ -0,0 +1,92 @@
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "Enclave_u.h"
+#include "pal_enclave.h"
+#include "pal_error.h"
+#include "pal_log.h"
+#include "pal_timer_thread.h"
+#include "errno2str.h"
+
+static pthread_t thread;
+static volatile int is_running = 0;
+// The eventfd on which the thread sleeps in the enclave
+static int wakeup_fd = -1;
+
+static void *thread_func(void *_data) {
+    sgx_enclave_id_t eid = pal_get_enclave_id();
+
+    // The ECall sleeps in the enclave until the next timer expires or the eventfd
+    // is written, which is done to stop the thread.
+    while (__atomic_load_n(&is_running, __ATOMIC_SEQ_CST)) {
+        int ret = 0;
+        sgx_status_t ecall_status = occlum_ecall_run_timers(eid, &ret, wakeup_fd);
+        if (ecall_status != SGX_SUCCESS) {
+            const char *sgx_err = pal_get_sgx_error_msg(ecall_status);
+            PAL_ERROR("Failed to do ECall: occlum_ecall_run_timers with error code 0x%x: %s",
+                      ecall_status, sgx_err);
+            exit(EXIT_FAILURE);
+        }
+        if (ret < 0) {
+            int errno_ = -ret;
+            PAL_ERROR("Unexpected error from occlum_ecall_run_timers: %s", errno2str(errno_));
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return NULL;
+}
+
+int pal_timer_thread_start(void) {
+    if (is_running) {
+        errno = EEXIST;
+        PAL_ERROR("The timer thread is already running: %s", errno2str(errno));
+        return -1;
+    }
+
+    wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd < 0) {
+        PAL_ERROR("Failed to create the eventfd of the timer thread: %s", errno2str(errno));
+        return -1;
+    }
+
+    is_running = 1;
+
+    int ret = 0;
+    if ((ret = pthread_create(&thread, NULL, thread_func, NULL))) {
+        is_running = 0;
+        close(wakeup_fd);
+        wakeup_fd = -1;
+
+        errno = ret;
+        PAL_ERROR("Failed to start the timer thread: %s", errno2str(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int pal_timer_thread_stop(void) {
+    if (!is_running) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    __atomic_store_n(&is_running, 0, __ATOMIC_SEQ_CST);
+    // Wake up the thread sleeping in the enclave
+    uint64_t val = 1;
+    if (write(wakeup_fd, &val, sizeof(val)) < 0) {
+        PAL_ERROR("Failed to wake up the timer thread: %s", errno2str(errno));
+        return -1;
+    }
+
+    int ret = 0;
+    if ((ret = pthread_join(thread, NULL))) {
+        errno = ret;
+        PAL_ERROR("Failed to free the timer thread: %s", errno2str(errno));
+        return -1;
+    }
+
+    close(wakeup_fd);
+    wakeup_fd = -1;
+    return 0;
+}
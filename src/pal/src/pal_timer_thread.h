@@ -0,0 +1,8 @@
+#ifndef __PAL_TIMER_THREAD_H__
+#define __PAL_TIMER_THREAD_H__
+
+int pal_timer_thread_start(void);
+
+int pal_timer_thread_stop(void);
+
+#endif /* __PAL_TIMER_THREAD_H__ */
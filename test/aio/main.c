@@ -0,0 +1,260 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/aio_abi.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include "test.h"
+
+// ============================================================================
+// Helper functions
+// ============================================================================
+
+#define AIO_RING_MAGIC  0xa10a10a1
+#define BUF_SIZE        4096
+
+// The completion ring in the user space, i.e., struct aio_ring of Linux
+struct aio_ring {
+    unsigned id;
+    unsigned nr;
+    unsigned head;
+    unsigned tail;
+    unsigned magic;
+    unsigned compat_features;
+    unsigned incompat_features;
+    unsigned header_length;
+    struct io_event io_events[0];
+};
+
+static int io_setup(unsigned nr_events, aio_context_t *ctx) {
+    return syscall(__NR_io_setup, nr_events, ctx);
+}
+
+static int io_destroy(aio_context_t ctx) {
+    return syscall(__NR_io_destroy, ctx);
+}
+
+static int io_submit(aio_context_t ctx, long nr, struct iocb **iocbs) {
+    return syscall(__NR_io_submit, ctx, nr, iocbs);
+}
+
+static int io_getevents(aio_context_t ctx, long min_nr, long nr, struct io_event *events,
+                        struct timespec *timeout) {
+    return syscall(__NR_io_getevents, ctx, min_nr, nr, events, timeout);
+}
+
+static void prep_rw(struct iocb *iocb, int opcode, int fd, void *buf, size_t len,
+                    off_t offset, uint64_t data) {
+    memset(iocb, 0, sizeof(*iocb));
+    iocb->aio_lio_opcode = opcode;
+    iocb->aio_fildes = fd;
+    iocb->aio_buf = (uint64_t)buf;
+    iocb->aio_nbytes = len;
+    iocb->aio_offset = offset;
+    iocb->aio_data = data;
+}
+
+// Write two blocks and sync them in a batch, then read them back by preadv
+static int test_read_write_on_file(const char *file_path) {
+    static char write_buf[2][BUF_SIZE];
+    static char read_buf[2][BUF_SIZE];
+    aio_context_t ctx = 0;
+    struct iocb iocbs[3];
+    struct iocb *iocb_ptrs[3] = { &iocbs[0], &iocbs[1], &iocbs[2] };
+    struct io_event events[3];
+
+    int fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        THROW_ERROR("failed to open a file");
+    }
+    if (io_setup(8, &ctx) < 0) {
+        THROW_ERROR("io_setup failed");
+    }
+
+    memset(write_buf[0], 'a', BUF_SIZE);
+    memset(write_buf[1], 'b', BUF_SIZE);
+    prep_rw(&iocbs[0], IOCB_CMD_PWRITE, fd, write_buf[0], BUF_SIZE, 0, 0);
+    prep_rw(&iocbs[1], IOCB_CMD_PWRITE, fd, write_buf[1], BUF_SIZE, BUF_SIZE, 1);
+    prep_rw(&iocbs[2], IOCB_CMD_FDSYNC, fd, NULL, 0, 0, 2);
+    if (io_submit(ctx, 3, iocb_ptrs) != 3) {
+        THROW_ERROR("failed to submit the writes");
+    }
+    if (io_getevents(ctx, 3, 3, events, NULL) != 3) {
+        THROW_ERROR("failed to get the events of the writes");
+    }
+    for (int i = 0; i < 3; i++) {
+        struct iocb *iocb = (struct iocb *)events[i].obj;
+        if (events[i].data != iocb->aio_data || events[i].res != iocb->aio_nbytes) {
+            THROW_ERROR("the event of a write is incorrect");
+        }
+    }
+
+    struct iovec iov[2] = {
+        { .iov_base = read_buf[0], .iov_len = BUF_SIZE },
+        { .iov_base = read_buf[1], .iov_len = BUF_SIZE },
+    };
+    prep_rw(&iocbs[0], IOCB_CMD_PREADV, fd, iov, 2, 0, 3);
+    if (io_submit(ctx, 1, iocb_ptrs) != 1) {
+        THROW_ERROR("failed to submit the read");
+    }
+    if (io_getevents(ctx, 1, 3, events, NULL) != 1) {
+        THROW_ERROR("failed to get the event of the read");
+    }
+    if (events[0].data != 3 || events[0].res != 2 * BUF_SIZE) {
+        THROW_ERROR("the event of the read is incorrect");
+    }
+    if (memcmp(read_buf, write_buf, sizeof(read_buf)) != 0) {
+        THROW_ERROR("the data read is incorrect");
+    }
+
+    io_destroy(ctx);
+    close(fd);
+    unlink(file_path);
+    return 0;
+}
+
+// ============================================================================
+// Test cases
+// ============================================================================
+
+int test_read_write() {
+    return test_read_write_on_file("/root/test_aio.txt");
+}
+
+int test_read_write_on_hostfs() {
+    return test_read_write_on_file("/host/test_aio.txt");
+}
+
+int test_resfd() {
+    char buf[BUF_SIZE];
+    aio_context_t ctx = 0;
+    struct iocb iocb;
+    struct iocb *iocb_ptr = &iocb;
+    uint64_t count = 0;
+
+    int fd = open("/dev/zero", O_RDONLY);
+    int efd = eventfd(0, EFD_NONBLOCK);
+    if (fd < 0 || efd < 0) {
+        THROW_ERROR("failed to open the files");
+    }
+    if (io_setup(1, &ctx) < 0) {
+        THROW_ERROR("io_setup failed");
+    }
+    prep_rw(&iocb, IOCB_CMD_PREAD, fd, buf, sizeof(buf), 0, 0);
+    iocb.aio_flags = IOCB_FLAG_RESFD;
+    iocb.aio_resfd = efd;
+    if (io_submit(ctx, 1, &iocb_ptr) != 1) {
+        THROW_ERROR("failed to submit the read");
+    }
+    if (read(efd, &count, sizeof(count)) != sizeof(count) || count != 1) {
+        THROW_ERROR("the completion is not notified by the eventfd");
+    }
+
+    io_destroy(ctx);
+    close(efd);
+    close(fd);
+    return 0;
+}
+
+int test_user_ring() {
+    char buf[BUF_SIZE];
+    aio_context_t ctx = 0;
+    struct iocb iocb;
+    struct iocb *iocb_ptr = &iocb;
+    struct io_event event;
+    struct timespec zero_timeout = { 0, 0 };
+
+    int fd = open("/dev/zero", O_RDONLY);
+    if (fd < 0) {
+        THROW_ERROR("failed to open a file");
+    }
+    if (io_setup(1, &ctx) < 0) {
+        THROW_ERROR("io_setup failed");
+    }
+    struct aio_ring *ring = (struct aio_ring *)ctx;
+    if (ring->magic != AIO_RING_MAGIC || ring->head != ring->tail) {
+        THROW_ERROR("the ring is not initialized");
+    }
+
+    prep_rw(&iocb, IOCB_CMD_PREAD, fd, buf, sizeof(buf), 0, 7);
+    if (io_submit(ctx, 1, &iocb_ptr) != 1) {
+        THROW_ERROR("failed to submit the read");
+    }
+
+    // Fetch the completion from the ring without syscalls
+    if (ring->head == ring->tail) {
+        THROW_ERROR("the completion is not in the ring");
+    }
+    event = ring->io_events[ring->head];
+    if (event.data != 7 || event.res != sizeof(buf)) {
+        THROW_ERROR("the event in the ring is incorrect");
+    }
+    ring->head = (ring->head + 1) % ring->nr;
+    if (io_getevents(ctx, 0, 1, &event, &zero_timeout) != 0) {
+        THROW_ERROR("the event fetched should not be got again");
+    }
+
+    io_destroy(ctx);
+    close(fd);
+    return 0;
+}
+
+int test_invalid_argument() {
+    char buf[BUF_SIZE];
+    aio_context_t ctx = 1;
+    struct iocb iocb;
+    struct iocb *iocb_ptr = &iocb;
+    struct io_event event;
+
+    if (io_setup(1, &ctx) >= 0 || errno != EINVAL) {
+        THROW_ERROR("io_setup should fail with a non-zero context");
+    }
+    ctx = 0;
+    if (io_setup(0, &ctx) >= 0 || errno != EINVAL) {
+        THROW_ERROR("io_setup should fail with zero events");
+    }
+    if (io_setup(4, &ctx) < 0) {
+        THROW_ERROR("io_setup failed");
+    }
+
+    prep_rw(&iocb, IOCB_CMD_PREAD, -1, buf, sizeof(buf), 0, 0);
+    if (io_submit(ctx, 1, &iocb_ptr) >= 0 || errno != EBADF) {
+        THROW_ERROR("io_submit should fail with an invalid fd");
+    }
+    prep_rw(&iocb, 0xff, STDOUT_FILENO, buf, sizeof(buf), 0, 0);
+    if (io_submit(ctx, 1, &iocb_ptr) >= 0 || errno != EINVAL) {
+        THROW_ERROR("io_submit should fail with an invalid opcode");
+    }
+    if (io_getevents(ctx, 2, 1, &event, NULL) >= 0 || errno != EINVAL) {
+        THROW_ERROR("io_getevents should fail when min_nr > nr");
+    }
+
+    if (io_destroy(ctx) < 0) {
+        THROW_ERROR("io_destroy failed");
+    }
+    if (io_destroy(ctx) >= 0 || errno != EINVAL) {
+        THROW_ERROR("io_destroy should fail with a destroyed context");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_read_write),
+    TEST_CASE(test_read_write_on_hostfs),
+    TEST_CASE(test_resfd),
+    TEST_CASE(test_user_ring),
+    TEST_CASE(test_invalid_argument),
+};
+
+int main() {
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "test.h"
+
+// ============================================================================
+// Test cases for the commands executed in a batch
+// ============================================================================
+
+// The commands are launched by `occlum exec-batch` with the number of the arguments
+// that follow as the first argument, which is checked to know that the arguments of
+// the commands in a batch are not mixed up.
+static int argc_of_command;
+static char **argv_of_command;
+
+int test_args() {
+    if (argc_of_command < 2) {
+        THROW_ERROR("the number of the arguments is not given");
+    }
+    if (atoi(argv_of_command[1]) != argc_of_command - 2) {
+        THROW_ERROR("the arguments are wrong");
+    }
+    return 0;
+}
+
+int test_stdio() {
+    // The stdio fds of every command are received from the client
+    if (printf("the command with %d arguments runs\n", argc_of_command - 2) < 0 ||
+            fflush(stdout) != 0) {
+        THROW_ERROR("failed to write to the stdout");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_args),
+    TEST_CASE(test_stdio),
+};
+
+int main(int argc, char **argv) {
+    argc_of_command = argc;
+    argv_of_command = argv;
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
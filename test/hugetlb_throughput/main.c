@@ -0,0 +1,94 @@
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define KB              (1024UL)
+#define MB              (1024UL * 1024UL)
+
+#define HUGE_PAGE_SIZE  (2 * MB)
+#define TOTAL_BYTES     (256 * MB)
+#define NR_ACCESSES     (16UL * 1024UL * 1024UL)
+#define STRIDE          (4 * KB)
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB     0x40000
+#endif
+
+// Measure the throughput of random memory accesses over a large mapping. Each
+// access touches a different page and depends on the previous one, so the
+// throughput is sensitive to TLB misses.
+static int bench_random_access(const char *name, int extra_flags) {
+    char *buf = mmap(NULL, TOTAL_BYTES, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        printf("ERROR: failed to mmap with %s\n", name);
+        return -1;
+    }
+    if ((extra_flags & MAP_HUGETLB) && (uintptr_t)buf % HUGE_PAGE_SIZE != 0) {
+        printf("ERROR: the mapping with %s is not aligned to huge page\n", name);
+        return -1;
+    }
+
+    // Link the pages in a random cycle, so the accesses can not be prefetched
+    size_t nr_pages = TOTAL_BYTES / STRIDE;
+    size_t *order = malloc(nr_pages * sizeof(size_t));
+    if (order == NULL) {
+        printf("ERROR: failed to allocate the order\n");
+        return -1;
+    }
+    for (size_t i = 0; i < nr_pages; i++) {
+        order[i] = i;
+    }
+    srand(0);
+    for (size_t i = nr_pages - 1; i > 0; i--) {
+        size_t j = (size_t)rand() % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for (size_t i = 0; i < nr_pages; i++) {
+        size_t next = order[(i + 1) % nr_pages];
+        *(char **)(buf + order[i] * STRIDE) = buf + next * STRIDE;
+    }
+    free(order);
+
+    // Start the timer
+    struct timeval tv_start, tv_end;
+    gettimeofday(&tv_start, NULL);
+
+    char *p = buf;
+    for (size_t i = 0; i < NR_ACCESSES; i++) {
+        p = *(char **)p;
+    }
+
+    // Stop the timer
+    gettimeofday(&tv_end, NULL);
+    // Keep the loop from being optimized out
+    if (p == NULL) {
+        printf("ERROR: the cycle is broken\n");
+        return -1;
+    }
+    munmap(buf, TOTAL_BYTES);
+
+    double total_s = (tv_end.tv_sec - tv_start.tv_sec)
+                     + (double)(tv_end.tv_usec - tv_start.tv_usec) / 1000000;
+    if (total_s < 1.0) {
+        printf("WARNING: run long enough to get meaningful results\n");
+        if (total_s == 0) { return 0; }
+    }
+    double throughput = (double)NR_ACCESSES / total_s / 1000000;
+    printf("Throughput of random accesses with %s is %.2f M/s\n", name, throughput);
+    return 0;
+}
+
+int main(int argc, const char *argv[]) {
+    if (bench_random_access("regular pages", 0) < 0) {
+        return -1;
+    }
+    if (bench_random_access("MAP_HUGETLB", MAP_HUGETLB) < 0) {
+        return -1;
+    }
+    return 0;
+}
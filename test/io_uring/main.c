@@ -0,0 +1,433 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include "test.h"
+
+// ============================================================================
+// Helper functions
+// ============================================================================
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup     425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter     426
+#endif
+
+#define BUF_SIZE                4096
+
+struct ring {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *rings_addr;
+    size_t rings_size;
+    size_t sqes_size;
+};
+
+static int io_uring_setup(unsigned entries, struct io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                          unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int ring_init(struct ring *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = io_uring_setup(entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        return -1;
+    }
+
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->rings_size = sq_size > cq_size ? sq_size : cq_size;
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    char *rings = mmap(NULL, ring->rings_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    void *sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (rings == MAP_FAILED || sqes == MAP_FAILED) {
+        return -1;
+    }
+
+    ring->rings_addr = rings;
+    ring->sq_head = (unsigned *)(rings + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(rings + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(rings + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(rings + params.sq_off.array);
+    ring->cq_head = (unsigned *)(rings + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(rings + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(rings + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(rings + params.cq_off.cqes);
+    ring->sqes = sqes;
+    return 0;
+}
+
+static void ring_exit(struct ring *ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->rings_addr, ring->rings_size);
+    close(ring->fd);
+}
+
+// Get the SQE at the tail, which is submitted by queue_sqe after it is filled
+static struct io_uring_sqe *get_sqe(struct ring *ring, int opcode, int fd,
+                                    uint64_t user_data) {
+    unsigned idx = *ring->sq_tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    ring->sq_array[idx] = idx;
+    return sqe;
+}
+
+static void queue_sqe(struct ring *ring) {
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+// Fetch a CQE from the ring without syscalls
+static int pop_cqe(struct ring *ring, struct io_uring_cqe *cqe) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
+    *cqe = ring->cqes[head & *ring->cq_mask];
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Pop `nr` CQEs, sorted by their user data, which are 0..nr-1
+static int pop_cqes(struct ring *ring, struct io_uring_cqe *cqes, int nr) {
+    for (int i = 0; i < nr; i++) {
+        struct io_uring_cqe cqe;
+        if (pop_cqe(ring, &cqe) < 0 || cqe.user_data >= nr) {
+            return -1;
+        }
+        cqes[cqe.user_data] = cqe;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases
+// ============================================================================
+
+int test_nop() {
+    struct ring ring;
+    struct io_uring_cqe cqe;
+
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+    get_sqe(&ring, IORING_OP_NOP, -1, 7);
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 1, 1, IORING_ENTER_GETEVENTS) != 1) {
+        THROW_ERROR("failed to submit the NOP");
+    }
+    if (*ring.sq_head != *ring.sq_tail) {
+        THROW_ERROR("the SQE is not consumed");
+    }
+    if (pop_cqe(&ring, &cqe) < 0 || cqe.user_data != 7 || cqe.res != 0) {
+        THROW_ERROR("the CQE of the NOP is incorrect");
+    }
+    if (pop_cqe(&ring, &cqe) == 0) {
+        THROW_ERROR("there should be only one CQE");
+    }
+
+    ring_exit(&ring);
+    return 0;
+}
+
+int test_read_write() {
+    static char write_buf[2][BUF_SIZE];
+    static char read_buf[2][BUF_SIZE];
+    const char *file_path = "/root/test_io_uring.txt";
+    struct ring ring;
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe cqes[3];
+
+    int fd = open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        THROW_ERROR("failed to open a file");
+    }
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+
+    memset(write_buf[0], 'a', BUF_SIZE);
+    memset(write_buf[1], 'b', BUF_SIZE);
+    for (int i = 0; i < 2; i++) {
+        sqe = get_sqe(&ring, IORING_OP_WRITE, fd, i);
+        sqe->addr = (uint64_t)write_buf[i];
+        sqe->len = BUF_SIZE;
+        sqe->off = i * BUF_SIZE;
+        queue_sqe(&ring);
+    }
+    sqe = get_sqe(&ring, IORING_OP_FSYNC, fd, 2);
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 3, 3, IORING_ENTER_GETEVENTS) != 3) {
+        THROW_ERROR("failed to submit the writes");
+    }
+    if (pop_cqes(&ring, cqes, 3) < 0) {
+        THROW_ERROR("failed to get the CQEs of the writes");
+    }
+    if (cqes[0].res != BUF_SIZE || cqes[1].res != BUF_SIZE || cqes[2].res != 0) {
+        THROW_ERROR("the results of the writes are incorrect");
+    }
+
+    struct iovec iov[2] = {
+        { .iov_base = read_buf[0], .iov_len = BUF_SIZE },
+        { .iov_base = read_buf[1], .iov_len = BUF_SIZE },
+    };
+    sqe = get_sqe(&ring, IORING_OP_READV, fd, 0);
+    sqe->addr = (uint64_t)iov;
+    sqe->len = 2;
+    sqe->off = 0;
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 1, 1, IORING_ENTER_GETEVENTS) != 1) {
+        THROW_ERROR("failed to submit the read");
+    }
+    if (pop_cqes(&ring, cqes, 1) < 0 || cqes[0].res != 2 * BUF_SIZE) {
+        THROW_ERROR("the result of the read is incorrect");
+    }
+    if (memcmp(read_buf, write_buf, sizeof(read_buf)) != 0) {
+        THROW_ERROR("the data read is incorrect");
+    }
+
+    ring_exit(&ring);
+    close(fd);
+    unlink(file_path);
+    return 0;
+}
+
+int test_poll_and_read_pipe() {
+    char buf[BUF_SIZE];
+    const char *msg = "Hello, io_uring";
+    struct ring ring;
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe cqes[2];
+    int pipe_fds[2];
+
+    if (pipe(pipe_fds) < 0) {
+        THROW_ERROR("failed to create a pipe");
+    }
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+
+    sqe = get_sqe(&ring, IORING_OP_POLL_ADD, pipe_fds[0], 0);
+    sqe->poll_events = POLLIN;
+    queue_sqe(&ring);
+    sqe = get_sqe(&ring, IORING_OP_READ, pipe_fds[0], 1);
+    sqe->addr = (uint64_t)buf;
+    sqe->len = sizeof(buf);
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 2, 0, 0) != 2) {
+        THROW_ERROR("failed to submit the requests");
+    }
+    if (pop_cqe(&ring, &cqes[0]) == 0) {
+        THROW_ERROR("the requests should wait for the pipe");
+    }
+
+    if (write(pipe_fds[1], msg, strlen(msg)) != strlen(msg)) {
+        THROW_ERROR("failed to write the pipe");
+    }
+    if (io_uring_enter(ring.fd, 0, 2, IORING_ENTER_GETEVENTS) != 0) {
+        THROW_ERROR("failed to wait for the completions");
+    }
+    if (pop_cqes(&ring, cqes, 2) < 0) {
+        THROW_ERROR("failed to get the CQEs");
+    }
+    if (!(cqes[0].res & POLLIN) || cqes[1].res != strlen(msg)) {
+        THROW_ERROR("the results are incorrect");
+    }
+    if (strncmp(buf, msg, strlen(msg)) != 0) {
+        THROW_ERROR("the data read is incorrect");
+    }
+
+    ring_exit(&ring);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return 0;
+}
+
+int test_send_recv() {
+    char buf[BUF_SIZE];
+    const char *msg = "Hello, io_uring";
+    struct ring ring;
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe cqes[2];
+    int socks[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, socks) < 0) {
+        THROW_ERROR("failed to create a socket pair");
+    }
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+
+    sqe = get_sqe(&ring, IORING_OP_RECV, socks[1], 0);
+    sqe->addr = (uint64_t)buf;
+    sqe->len = sizeof(buf);
+    queue_sqe(&ring);
+    sqe = get_sqe(&ring, IORING_OP_SEND, socks[0], 1);
+    sqe->addr = (uint64_t)msg;
+    sqe->len = strlen(msg);
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 2, 2, IORING_ENTER_GETEVENTS) != 2) {
+        THROW_ERROR("failed to submit the requests");
+    }
+    if (pop_cqes(&ring, cqes, 2) < 0) {
+        THROW_ERROR("failed to get the CQEs");
+    }
+    if (cqes[0].res != strlen(msg) || cqes[1].res != strlen(msg)) {
+        THROW_ERROR("the results are incorrect");
+    }
+    if (strncmp(buf, msg, strlen(msg)) != 0) {
+        THROW_ERROR("the data received is incorrect");
+    }
+
+    ring_exit(&ring);
+    close(socks[0]);
+    close(socks[1]);
+    return 0;
+}
+
+int test_timeout() {
+    struct __kernel_timespec ts = { .tv_sec = 0, .tv_nsec = 10 * 1000 * 1000 };
+    struct ring ring;
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe cqe;
+
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+    sqe = get_sqe(&ring, IORING_OP_TIMEOUT, -1, 0);
+    sqe->addr = (uint64_t)&ts;
+    sqe->len = 1;
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 1, 1, IORING_ENTER_GETEVENTS) != 1) {
+        THROW_ERROR("failed to submit the timeout");
+    }
+    if (pop_cqe(&ring, &cqe) < 0 || cqe.res != -ETIME) {
+        THROW_ERROR("the timeout should expire");
+    }
+
+    ring_exit(&ring);
+    return 0;
+}
+
+int test_cancel_poll() {
+    struct ring ring;
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe cqes[2];
+    int pipe_fds[2];
+
+    if (pipe(pipe_fds) < 0) {
+        THROW_ERROR("failed to create a pipe");
+    }
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+    sqe = get_sqe(&ring, IORING_OP_POLL_ADD, pipe_fds[0], 0);
+    sqe->poll_events = POLLIN;
+    queue_sqe(&ring);
+    sqe = get_sqe(&ring, IORING_OP_POLL_REMOVE, -1, 1);
+    sqe->addr = 0;
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 2, 2, IORING_ENTER_GETEVENTS) != 2) {
+        THROW_ERROR("failed to submit the requests");
+    }
+    if (pop_cqes(&ring, cqes, 2) < 0) {
+        THROW_ERROR("failed to get the CQEs");
+    }
+    if (cqes[0].res != -ECANCELED || cqes[1].res != 0) {
+        THROW_ERROR("the poll is not canceled");
+    }
+
+    ring_exit(&ring);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    return 0;
+}
+
+int test_invalid_argument() {
+    struct io_uring_params params;
+    struct ring ring;
+    struct io_uring_cqe cqe;
+
+    memset(&params, 0, sizeof(params));
+    if (io_uring_setup(0, &params) >= 0 || errno != EINVAL) {
+        THROW_ERROR("io_uring_setup should fail with zero entries");
+    }
+    if (io_uring_enter(STDOUT_FILENO, 0, 0, 0) >= 0 || errno != EOPNOTSUPP) {
+        THROW_ERROR("io_uring_enter should fail with a file that is not io_uring");
+    }
+
+    if (ring_init(&ring, 4) < 0) {
+        THROW_ERROR("failed to set up the ring");
+    }
+    get_sqe(&ring, 0xff, -1, 0);
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 1, 1, IORING_ENTER_GETEVENTS) != 1) {
+        THROW_ERROR("failed to submit the SQE");
+    }
+    if (pop_cqe(&ring, &cqe) < 0 || cqe.res != -EINVAL) {
+        THROW_ERROR("the SQE of an invalid opcode should fail");
+    }
+    get_sqe(&ring, IORING_OP_READ, -1, 0);
+    queue_sqe(&ring);
+    if (io_uring_enter(ring.fd, 1, 1, IORING_ENTER_GETEVENTS) != 1) {
+        THROW_ERROR("failed to submit the SQE");
+    }
+    if (pop_cqe(&ring, &cqe) < 0 || cqe.res != -EBADF) {
+        THROW_ERROR("the SQE of an invalid fd should fail");
+    }
+
+    ring_exit(&ring);
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_nop),
+    TEST_CASE(test_read_write),
+    TEST_CASE(test_poll_and_read_pipe),
+    TEST_CASE(test_send_recv),
+    TEST_CASE(test_timeout),
+    TEST_CASE(test_cancel_poll),
+    TEST_CASE(test_invalid_argument),
+};
+
+int main() {
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
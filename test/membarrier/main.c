@@ -0,0 +1,179 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "test.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#ifndef __NR_membarrier
+#define __NR_membarrier 324
+#endif
+
+#define MEMBARRIER_CMD_QUERY                        0
+#define MEMBARRIER_CMD_GLOBAL                       (1 << 0)
+#define MEMBARRIER_CMD_PRIVATE_EXPEDITED            (1 << 3)
+#define MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED   (1 << 4)
+
+#define PAGE_SIZE       4096
+#define NTHREADS        4
+#define NREPEATS        1000
+
+static int membarrier(int cmd, unsigned int flags) {
+    return syscall(__NR_membarrier, cmd, flags, 0);
+}
+
+static unsigned long elapsed_us(struct timeval *start, struct timeval *end) {
+    return (end->tv_sec - start->tv_sec) * 1000000UL + (end->tv_usec - start->tv_usec);
+}
+
+// The threads that spin in the user space until told to stop
+static volatile int should_stop;
+static volatile unsigned long spin_counts[NTHREADS];
+
+static void *spin_thread(void *arg) {
+    unsigned long i = (unsigned long)arg;
+    while (!should_stop) {
+        spin_counts[i]++;
+    }
+    return NULL;
+}
+
+static int start_spin_threads(pthread_t *threads) {
+    should_stop = 0;
+    for (unsigned long i = 0; i < NTHREADS; i++) {
+        if (pthread_create(&threads[i], NULL, spin_thread, (void *)i) != 0) {
+            THROW_ERROR("failed to create a thread");
+        }
+    }
+    return 0;
+}
+
+static int stop_spin_threads(pthread_t *threads) {
+    should_stop = 1;
+    for (int i = 0; i < NTHREADS; i++) {
+        if (pthread_join(threads[i], NULL) != 0) {
+            THROW_ERROR("failed to join a thread");
+        }
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases for membarrier
+// ============================================================================
+
+int test_query() {
+    int cmds = membarrier(MEMBARRIER_CMD_QUERY, 0);
+    if (cmds < 0) {
+        THROW_ERROR("failed to query the commands");
+    }
+    if ((cmds & MEMBARRIER_CMD_GLOBAL) == 0 ||
+            (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) == 0) {
+        THROW_ERROR("the commands are not supported");
+    }
+    return 0;
+}
+
+int test_invalid_args() {
+    if (membarrier(1 << 20, 0) == 0 || errno != EINVAL) {
+        THROW_ERROR("the command is not checked");
+    }
+    if (membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 1) == 0 || errno != EINVAL) {
+        THROW_ERROR("the flags are not checked");
+    }
+    return 0;
+}
+
+int test_private_expedited() {
+    pthread_t threads[NTHREADS];
+
+    if (membarrier(MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) < 0) {
+        THROW_ERROR("failed to register");
+    }
+    if (start_spin_threads(threads) < 0) {
+        return -1;
+    }
+    // The threads spinning in the user space must not block the barriers
+    for (int i = 0; i < NREPEATS; i++) {
+        if (membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) < 0) {
+            stop_spin_threads(threads);
+            THROW_ERROR("failed to run the barrier");
+        }
+    }
+    return stop_spin_threads(threads);
+}
+
+int test_global() {
+    pthread_t threads[NTHREADS];
+
+    if (start_spin_threads(threads) < 0) {
+        return -1;
+    }
+    if (membarrier(MEMBARRIER_CMD_GLOBAL, 0) < 0) {
+        stop_spin_threads(threads);
+        THROW_ERROR("failed to run the barrier");
+    }
+    return stop_spin_threads(threads);
+}
+
+int test_latency_vs_mprotect() {
+    pthread_t threads[NTHREADS];
+    struct timeval start, end;
+
+    char *page = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) {
+        THROW_ERROR("failed to map the page");
+    }
+    if (start_spin_threads(threads) < 0) {
+        return -1;
+    }
+
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < NREPEATS; i++) {
+        membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+    }
+    gettimeofday(&end, NULL);
+    unsigned long membarrier_us = elapsed_us(&start, &end);
+
+    // The trick used without membarrier, i.e., changing the permissions of a dirty page
+    gettimeofday(&start, NULL);
+    for (int i = 0; i < NREPEATS; i++) {
+        page[0] = i;
+        mprotect(page, PAGE_SIZE, PROT_READ);
+        mprotect(page, PAGE_SIZE, PROT_READ | PROT_WRITE);
+    }
+    gettimeofday(&end, NULL);
+    unsigned long mprotect_us = elapsed_us(&start, &end);
+
+    if (stop_spin_threads(threads) < 0) {
+        return -1;
+    }
+    munmap(page, PAGE_SIZE);
+    printf("membarrier: %lu us per call, mprotect: %lu us per call\n",
+           membarrier_us / NREPEATS, mprotect_us / NREPEATS);
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_query),
+    TEST_CASE(test_invalid_args),
+    TEST_CASE(test_private_expedited),
+    TEST_CASE(test_global),
+    TEST_CASE(test_latency_vs_mprotect),
+};
+
+int main() {
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
@@ -0,0 +1,323 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define PAGE_SIZE   4096
+
+#define SHM_PATH    "/dev/shm/test_memfd"
+#define SHM_SIZE    (2 * PAGE_SIZE)
+
+const char prog_name[] = "/bin/memfd";
+const char msg[] = "shared by every mapping";
+const char child_msg[] = "written by the child";
+
+// ============================================================================
+// Test cases for memfd
+// ============================================================================
+
+int test_memfd_write_and_read() {
+    char buf[sizeof(msg)] = {0};
+    struct stat stat_buf;
+
+    int fd = memfd_create("test", MFD_CLOEXEC);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a memfd");
+    }
+    if (write(fd, msg, sizeof(msg)) != sizeof(msg)) {
+        THROW_ERROR("failed to write the memfd");
+    }
+    if (pread(fd, buf, sizeof(buf), 0) != sizeof(buf) || strcmp(buf, msg) != 0) {
+        THROW_ERROR("failed to read what is written");
+    }
+    if (fstat(fd, &stat_buf) < 0 || stat_buf.st_size != sizeof(msg)) {
+        THROW_ERROR("the size of the memfd is wrong");
+    }
+    if ((fcntl(fd, F_GETFD) & FD_CLOEXEC) == 0) {
+        THROW_ERROR("the memfd is not close-on-exec");
+    }
+    close(fd);
+    return 0;
+}
+
+int test_memfd_shared_mappings() {
+    char buf[sizeof(msg)] = {0};
+
+    int fd = memfd_create("test", 0);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a memfd");
+    }
+    if (ftruncate(fd, SHM_SIZE) < 0) {
+        THROW_ERROR("failed to truncate the memfd");
+    }
+    char *addr1 = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    char *addr2 = mmap(NULL, PAGE_SIZE, PROT_READ, MAP_SHARED, fd, PAGE_SIZE);
+    if (addr1 == MAP_FAILED || addr2 == MAP_FAILED) {
+        THROW_ERROR("failed to map the memfd");
+    }
+
+    // The writes through a mapping are seen by the others and the file at once
+    strcpy(addr1 + PAGE_SIZE, msg);
+    if (strcmp(addr2, msg) != 0) {
+        THROW_ERROR("the write is not seen by the other mapping");
+    }
+    if (pread(fd, buf, sizeof(buf), PAGE_SIZE) != sizeof(buf) || strcmp(buf, msg) != 0) {
+        THROW_ERROR("the write is not seen by the file");
+    }
+    if (pwrite(fd, child_msg, sizeof(child_msg), PAGE_SIZE) != sizeof(child_msg) ||
+            strcmp(addr2, child_msg) != 0) {
+        THROW_ERROR("the write of the file is not seen by the mapping");
+    }
+
+    // The pages are kept by the mappings after the file is closed
+    close(fd);
+    if (strcmp(addr1 + PAGE_SIZE, child_msg) != 0) {
+        THROW_ERROR("the pages are freed after the file is closed");
+    }
+    munmap(addr1, SHM_SIZE);
+    munmap(addr2, PAGE_SIZE);
+    return 0;
+}
+
+int test_memfd_seals() {
+    int fd = memfd_create("test", MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a memfd");
+    }
+    if (ftruncate(fd, PAGE_SIZE) < 0) {
+        THROW_ERROR("failed to truncate the memfd");
+    }
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) < 0) {
+        THROW_ERROR("failed to add the seals");
+    }
+    if (ftruncate(fd, SHM_SIZE) == 0 || errno != EPERM ||
+            ftruncate(fd, 0) == 0 || errno != EPERM) {
+        THROW_ERROR("the sealed memfd is resized");
+    }
+    if (pwrite(fd, msg, sizeof(msg), PAGE_SIZE) >= 0 || errno != EPERM) {
+        THROW_ERROR("the sealed memfd grows by a write");
+    }
+
+    // The writes cannot be sealed while there are writable shared mappings
+    char *addr = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        THROW_ERROR("failed to map the memfd");
+    }
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE) == 0 || errno != EBUSY) {
+        THROW_ERROR("the writes are sealed with a writable mapping");
+    }
+    munmap(addr, PAGE_SIZE);
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE | F_SEAL_SEAL) < 0) {
+        THROW_ERROR("failed to seal the writes");
+    }
+    if (pwrite(fd, msg, sizeof(msg), 0) >= 0 || errno != EPERM) {
+        THROW_ERROR("the sealed memfd is written");
+    }
+    if (mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) != MAP_FAILED ||
+            errno != EPERM) {
+        THROW_ERROR("the sealed memfd is mapped writable");
+    }
+    if (fcntl(fd, F_GET_SEALS) !=
+            (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)) {
+        THROW_ERROR("the seals are wrong");
+    }
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK) == 0 || errno != EPERM) {
+        THROW_ERROR("the seals are changed after they are sealed");
+    }
+    close(fd);
+    return 0;
+}
+
+int test_memfd_without_sealing() {
+    int fd = memfd_create("test", 0);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a memfd");
+    }
+    if (fcntl(fd, F_GET_SEALS) != F_SEAL_SEAL) {
+        THROW_ERROR("the memfd can be sealed");
+    }
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE) == 0 || errno != EPERM) {
+        THROW_ERROR("the memfd is sealed without MFD_ALLOW_SEALING");
+    }
+    close(fd);
+    return 0;
+}
+
+int test_memfd_partial_mappings() {
+    char buf[sizeof(msg)] = {0};
+
+    int fd = memfd_create("test", MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a memfd");
+    }
+    if (pwrite(fd, msg, sizeof(msg), 0) != sizeof(msg) || ftruncate(fd, SHM_SIZE) < 0) {
+        THROW_ERROR("failed to write the memfd");
+    }
+    char *addr = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        THROW_ERROR("failed to map the memfd");
+    }
+
+    // The protection of a part of the mapping is honored by process_vm_writev
+    if (mprotect(addr, PAGE_SIZE, PROT_READ) < 0) {
+        THROW_ERROR("failed to protect a part of the mapping");
+    }
+    struct iovec local_iov = {.iov_base = (void *)child_msg, .iov_len = sizeof(child_msg)};
+    struct iovec remote_iov = {.iov_base = addr, .iov_len = sizeof(child_msg)};
+    if (process_vm_writev(getpid(), &local_iov, 1, &remote_iov, 1, 0) >= 0 ||
+            errno != EFAULT) {
+        THROW_ERROR("the read-only part is written");
+    }
+    remote_iov.iov_base = addr + PAGE_SIZE;
+    if (process_vm_writev(getpid(), &local_iov, 1, &remote_iov, 1, 0) != sizeof(child_msg) ||
+            strcmp(addr + PAGE_SIZE, child_msg) != 0) {
+        THROW_ERROR("the writable part is not written");
+    }
+
+    // The writes are sealed only after every part of the mapping is unmapped
+    if (munmap(addr, PAGE_SIZE) < 0) {
+        THROW_ERROR("failed to unmap a part of the mapping");
+    }
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE) == 0 || errno != EBUSY) {
+        THROW_ERROR("the writes are sealed with a part of the mapping");
+    }
+    if (munmap(addr + PAGE_SIZE, PAGE_SIZE) < 0) {
+        THROW_ERROR("failed to unmap the other part of the mapping");
+    }
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_WRITE) < 0) {
+        THROW_ERROR("failed to seal the writes");
+    }
+
+    // A mapping of the sealed memfd cannot become writable
+    addr = mmap(NULL, PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        THROW_ERROR("failed to map the sealed memfd");
+    }
+    if (mprotect(addr, PAGE_SIZE, PROT_READ | PROT_WRITE) == 0 || errno != EACCES) {
+        THROW_ERROR("the mapping of the sealed memfd becomes writable");
+    }
+    memcpy(buf, addr, sizeof(buf));
+    if (strcmp(buf, msg) != 0) {
+        THROW_ERROR("the pages of the sealed memfd are wrong");
+    }
+    munmap(addr, PAGE_SIZE);
+    close(fd);
+    return 0;
+}
+
+// ============================================================================
+// Test cases for /dev/shm
+// ============================================================================
+
+static int child_write_dev_shm() {
+    int fd = open(SHM_PATH, O_RDWR);
+    if (fd < 0) {
+        THROW_ERROR("failed to open the file in the child");
+    }
+    char *addr = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        THROW_ERROR("failed to map the file in the child");
+    }
+    if (strcmp(addr, msg) != 0) {
+        THROW_ERROR("the write of the parent is not seen by the child");
+    }
+    strcpy(addr + PAGE_SIZE, child_msg);
+    munmap(addr, SHM_SIZE);
+    close(fd);
+    return 0;
+}
+
+int test_dev_shm_shared_by_processes() {
+    char *child_argv[] = {(char *)prog_name, "child", NULL};
+    pid_t child_pid;
+    int status;
+
+    int fd = open(SHM_PATH, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        THROW_ERROR("failed to create the file in /dev/shm");
+    }
+    if (ftruncate(fd, SHM_SIZE) < 0) {
+        THROW_ERROR("failed to truncate the file");
+    }
+    char *addr = mmap(NULL, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        THROW_ERROR("failed to map the file");
+    }
+    strcpy(addr, msg);
+
+    if (posix_spawn(&child_pid, prog_name, NULL, NULL, child_argv, NULL) != 0) {
+        THROW_ERROR("failed to spawn a child process");
+    }
+    if (waitpid(child_pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+        THROW_ERROR("the child process failed");
+    }
+    if (strcmp(addr + PAGE_SIZE, child_msg) != 0) {
+        THROW_ERROR("the write of the child is not seen by the parent");
+    }
+
+    munmap(addr, SHM_SIZE);
+    close(fd);
+    if (unlink(SHM_PATH) < 0) {
+        THROW_ERROR("failed to unlink the file");
+    }
+    return 0;
+}
+
+int test_meminfo_shmem() {
+    char buf[1024] = {0};
+
+    int memfd = memfd_create("test", 0);
+    if (memfd < 0 || ftruncate(memfd, SHM_SIZE) < 0) {
+        THROW_ERROR("failed to create a memfd");
+    }
+    int fd = open("/proc/meminfo", O_RDONLY);
+    if (fd < 0) {
+        THROW_ERROR("failed to open /proc/meminfo");
+    }
+    if (read(fd, buf, sizeof(buf) - 1) < 0) {
+        THROW_ERROR("failed to read /proc/meminfo");
+    }
+    char *line = strstr(buf, "Shmem:");
+    if (line == NULL || atol(line + strlen("Shmem:")) < SHM_SIZE / 1024) {
+        THROW_ERROR("the memfd is not counted in Shmem");
+    }
+    close(fd);
+    close(memfd);
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_memfd_write_and_read),
+    TEST_CASE(test_memfd_shared_mappings),
+    TEST_CASE(test_memfd_seals),
+    TEST_CASE(test_memfd_without_sealing),
+    TEST_CASE(test_memfd_partial_mappings),
+    TEST_CASE(test_dev_shm_shared_by_processes),
+    TEST_CASE(test_meminfo_shmem),
+};
+
+int main(int argc, const char *argv[]) {
+    if (argc > 1) {
+        // The child process arrives here
+        return child_write_dev_shm() < 0 ? -1 : 0;
+    }
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
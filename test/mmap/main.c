@@ -26,6 +26,7 @@
 
 #define MAX_MMAP_USED_MEMORY    (4 * MB)
 #define DEFAULT_CHUNK_SIZE      (32 * MB) // This is the default chunk size used in Occlum kernel.
+#define HUGE_PAGE_SIZE          (2 * MB)
 
 // ============================================================================
 // Helper functions
@@ -229,6 +230,51 @@ int test_anonymous_mmap_with_non_page_aligned_len() {
     return 0;
 }
 
+int test_anonymous_mmap_with_hugetlb() {
+    size_t len = HUGE_PAGE_SIZE + 17;
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    void *buf = mmap(NULL, len, prot, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap with MAP_HUGETLB failed");
+    }
+    if ((size_t)buf % HUGE_PAGE_SIZE != 0) {
+        THROW_ERROR("the mmap with MAP_HUGETLB is not aligned to huge page");
+    }
+
+    // The length is rounded up to huge page
+    len = ALIGN_UP(len, HUGE_PAGE_SIZE);
+    if (check_bytes_in_buf(buf, len, 0) < 0) {
+        THROW_ERROR("the buffer is not initialized to zeros");
+    }
+
+    int ret = munmap(buf, len);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
+int test_anonymous_mmap_larger_than_chunk() {
+    size_t len = DEFAULT_CHUNK_SIZE + PAGE_SIZE;
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void *buf = mmap(NULL, len, prot, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    // Large mappings are aligned to huge page
+    if ((size_t)buf % HUGE_PAGE_SIZE != 0) {
+        THROW_ERROR("the large mmap is not aligned to huge page");
+    }
+
+    int ret = munmap(buf, len);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
 // ============================================================================
 // Test cases for file-backed mmap
 // ============================================================================
@@ -949,6 +995,90 @@ int test_mremap_with_fixed_addr() {
     return 0;
 }
 
+int test_mremap_large_mapping_in_place() {
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    // A mapping larger than the default chunk is not in any default chunk
+    size_t len = DEFAULT_CHUNK_SIZE * 2;
+    char *buf = mmap(NULL, len, prot, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    memset(buf, 'a', len);
+
+    // Shrink the mapping to free the range after it
+    size_t small_len = len / 2;
+    if (mremap(buf, len, small_len, 0) != buf) {
+        THROW_ERROR("mremap to shrink failed");
+    }
+    // The mapping can grow in place without MREMAP_MAYMOVE
+    if (mremap(buf, small_len, len, 0) != buf) {
+        THROW_ERROR("mremap to grow in place failed");
+    }
+    if (check_bytes_in_buf(buf, small_len, 'a') < 0) {
+        THROW_ERROR("the old part of buffer is not correct");
+    }
+    if (check_bytes_in_buf(buf + small_len, len - small_len, 0) < 0) {
+        THROW_ERROR("the grown part of buffer is not zero");
+    }
+
+    int ret = munmap(buf, len);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
+int test_mremap_with_zero_old_size() {
+    const char *file_path = "/root/mmap_file.data";
+    int fd = open(file_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) {
+        THROW_ERROR("file creation failed");
+    }
+    int byte_val = 0xab;
+    if (fill_file_with_repeated_bytes(fd, PAGE_SIZE * 2, byte_val) < 0) {
+        THROW_ERROR("file init failed");
+    }
+
+    size_t len = PAGE_SIZE * 2;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+
+    // Duplicate the second page of the shared mapping
+    char *dup_buf = mremap(buf + PAGE_SIZE, 0, PAGE_SIZE, MREMAP_MAYMOVE);
+    if (dup_buf == MAP_FAILED) {
+        THROW_ERROR("mremap with zero old size failed");
+    }
+    if (check_bytes_in_buf(dup_buf, PAGE_SIZE, byte_val) < 0) {
+        THROW_ERROR("the duplicated buffer is not correct");
+    }
+    // The old mapping is kept
+    if (check_bytes_in_buf(buf, len, byte_val) < 0) {
+        THROW_ERROR("the old buffer is not correct");
+    }
+
+    // A private mapping can not be duplicated
+    char *private_buf = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                             -1, 0);
+    if (private_buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    if (mremap(private_buf, 0, len, MREMAP_MAYMOVE) != MAP_FAILED || errno != EINVAL) {
+        THROW_ERROR("mremap with zero old size of private mapping should fail");
+    }
+
+    if (munmap(dup_buf, PAGE_SIZE) < 0 || munmap(buf, len) < 0
+            || munmap(private_buf, len) < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    close(fd);
+    unlink(file_path);
+    return 0;
+}
+
 // ============================================================================
 // Test cases for mprotect
 // ============================================================================
@@ -1417,6 +1547,324 @@ int test_file_backed_mremap_mem_may_move() {
     return _test_file_backed_mremap(file_backed_mremap_mem_may_move);
 }
 
+// ============================================================================
+// Test cases for madvise
+// ============================================================================
+
+int test_madvise_dontneed_anonymous() {
+    size_t len = 4 * PAGE_SIZE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    memset(buf, 0xab, len);
+
+    // Discard the two pages in the middle
+    int ret = madvise(buf + PAGE_SIZE, 2 * PAGE_SIZE, MADV_DONTNEED);
+    if (ret < 0) {
+        THROW_ERROR("madvise failed");
+    }
+    if (check_bytes_in_buf(buf, PAGE_SIZE, 0xab) < 0 ||
+            check_bytes_in_buf(buf + 3 * PAGE_SIZE, PAGE_SIZE, 0xab) < 0) {
+        THROW_ERROR("the pages out of the range are changed");
+    }
+    if (check_bytes_in_buf(buf + PAGE_SIZE, 2 * PAGE_SIZE, 0) < 0) {
+        THROW_ERROR("the pages in the range are not zeroed");
+    }
+
+    ret = munmap(buf, len);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
+int test_madvise_dontneed_private_file() {
+    const char *file_path = "/root/mmap_file.data";
+    int fd = open(file_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) {
+        THROW_ERROR("file creation failed");
+    }
+    size_t file_len = 2 * PAGE_SIZE + 128;
+    fill_file_with_repeated_bytes(fd, file_len, 0xab);
+
+    size_t len = ALIGN_UP(file_len, PAGE_SIZE);
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    memset(buf, 0xcd, len);
+
+    // The private copy is discarded, and the content is read from the file again
+    int ret = madvise(buf, len, MADV_DONTNEED);
+    if (ret < 0) {
+        THROW_ERROR("madvise failed");
+    }
+    if (check_bytes_in_buf(buf, file_len, 0xab) < 0) {
+        THROW_ERROR("the content is not the same as the file");
+    }
+    if (check_bytes_in_buf(buf + file_len, len - file_len, 0) < 0) {
+        THROW_ERROR("the memory beyond the end of file is not zeroed");
+    }
+
+    ret = munmap(buf, len);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    close(fd);
+    unlink(file_path);
+    return 0;
+}
+
+int test_madvise_free_and_willneed() {
+    size_t len = 4 * PAGE_SIZE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    memset(buf, 0xab, len);
+
+    int advices[] = { MADV_FREE, MADV_WILLNEED, MADV_NORMAL, MADV_HUGEPAGE };
+    for (int i = 0; i < ARRAY_SIZE(advices); i++) {
+        if (madvise(buf, len, advices[i]) < 0) {
+            THROW_ERROR("madvise failed with advice %d", advices[i]);
+        }
+    }
+
+    // The memory freed lazily is still usable after being written
+    memset(buf, 0xcd, len);
+    if (check_bytes_in_buf(buf, len, 0xcd) < 0) {
+        THROW_ERROR("the memory is not writable after MADV_FREE");
+    }
+
+    int ret = munmap(buf, len);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
+// Get the size in kB of the field in /proc/self/status
+static long get_status_kb(const char *field) {
+    char buf[1024] = {0};
+    int fd = open("/proc/self/status", O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    int len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    char *line = len > 0 ? strstr(buf, field) : NULL;
+    if (line == NULL) {
+        return -1;
+    }
+    return atol(line + strlen(field));
+}
+
+int test_madvise_reclaim_stat() {
+    size_t len = 4 * PAGE_SIZE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    memset(buf, 0xab, len);
+
+    long discarded = get_status_kb("VmDiscarded:");
+    long lazy_free = get_status_kb("VmLazyFree:");
+    if (discarded < 0 || lazy_free < 0) {
+        THROW_ERROR("failed to get the reclaimed memory");
+    }
+    if (madvise(buf, 2 * PAGE_SIZE, MADV_DONTNEED) < 0 ||
+            madvise(buf + 2 * PAGE_SIZE, 2 * PAGE_SIZE, MADV_FREE) < 0) {
+        THROW_ERROR("madvise failed");
+    }
+    if (get_status_kb("VmDiscarded:") != discarded + 2 * PAGE_SIZE / KB ||
+            get_status_kb("VmLazyFree:") != lazy_free + 2 * PAGE_SIZE / KB) {
+        THROW_ERROR("the reclaimed memory is not counted");
+    }
+
+    // The pages written again are no longer reclaimed
+    buf[0] = 1;
+    buf[3 * PAGE_SIZE] = 1;
+    if (get_status_kb("VmDiscarded:") != discarded + PAGE_SIZE / KB ||
+            get_status_kb("VmLazyFree:") != lazy_free + PAGE_SIZE / KB) {
+        THROW_ERROR("the pages written again are counted");
+    }
+
+    // Nor are the pages unmapped
+    if (munmap(buf, len) < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    if (get_status_kb("VmDiscarded:") != discarded ||
+            get_status_kb("VmLazyFree:") != lazy_free) {
+        THROW_ERROR("the unmapped pages are counted");
+    }
+    return 0;
+}
+
+int test_madvise_hugepage() {
+    size_t len = 2 * HUGE_PAGE_SIZE + PAGE_SIZE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *buf = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+
+    // The large anonymous mappings are aligned to huge page after MADV_HUGEPAGE
+    if (madvise(buf, PAGE_SIZE, MADV_HUGEPAGE) < 0) {
+        THROW_ERROR("madvise failed");
+    }
+    char *huge_buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (huge_buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    if ((size_t)huge_buf % HUGE_PAGE_SIZE != 0) {
+        THROW_ERROR("the large mapping is not aligned to huge page");
+    }
+    if (madvise(buf, PAGE_SIZE, MADV_NOHUGEPAGE) < 0) {
+        THROW_ERROR("madvise failed");
+    }
+
+    if (munmap(huge_buf, len) < 0 || munmap(buf, PAGE_SIZE) < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
+int test_madvise_with_invalid_args() {
+    size_t len = 2 * PAGE_SIZE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+
+    int ret = madvise(buf + 1, PAGE_SIZE, MADV_DONTNEED);
+    if (!(ret < 0 && errno == EINVAL)) {
+        THROW_ERROR("madvise with non-page-aligned addr should fail with EINVAL");
+    }
+    ret = madvise(buf, len, 0x1234);
+    if (!(ret < 0 && errno == EINVAL)) {
+        THROW_ERROR("madvise with invalid advice should fail with EINVAL");
+    }
+    ret = madvise(buf, 0, MADV_DONTNEED);
+    if (ret < 0) {
+        THROW_ERROR("madvise with zero len failed");
+    }
+
+    ret = munmap(buf + PAGE_SIZE, PAGE_SIZE);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    ret = madvise(buf, len, MADV_DONTNEED);
+    if (!(ret < 0 && errno == ENOMEM)) {
+        THROW_ERROR("madvise on unmapped memory should fail with ENOMEM");
+    }
+
+    ret = munmap(buf, PAGE_SIZE);
+    if (ret < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases for NUMA memory policy
+// ============================================================================
+
+#define MPOL_DEFAULT            0
+#define MPOL_BIND               2
+#define MPOL_F_NODE             (1 << 0)
+#define MPOL_F_ADDR             (1 << 1)
+#define MPOL_F_MEMS_ALLOWED     (1 << 2)
+#define MPOL_MF_STRICT          (1 << 0)
+#define MAX_NODE                64
+
+int test_set_get_mempolicy() {
+    unsigned long allowed = 0;
+    int mode = -1;
+    // The number of bits is maxnode - 1
+    if (syscall(__NR_get_mempolicy, &mode, &allowed, MAX_NODE + 1, NULL,
+                MPOL_F_MEMS_ALLOWED) < 0) {
+        THROW_ERROR("get_mempolicy with MPOL_F_MEMS_ALLOWED failed");
+    }
+    if ((allowed & 1) == 0) {
+        THROW_ERROR("node 0 is not allowed");
+    }
+
+    unsigned long nodemask = 1;
+    if (syscall(__NR_set_mempolicy, MPOL_BIND, &nodemask, MAX_NODE + 1) < 0) {
+        THROW_ERROR("set_mempolicy failed");
+    }
+    nodemask = 0;
+    if (syscall(__NR_get_mempolicy, &mode, &nodemask, MAX_NODE + 1, NULL, 0) < 0) {
+        THROW_ERROR("get_mempolicy failed");
+    }
+    if (mode != MPOL_BIND || nodemask != 1) {
+        THROW_ERROR("the memory policy is not the one set");
+    }
+
+    // The memory of a bound thread must be on the node
+    size_t len = DEFAULT_CHUNK_SIZE * 2;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+    int node = -1;
+    if (syscall(__NR_get_mempolicy, &node, NULL, 0, buf, MPOL_F_NODE | MPOL_F_ADDR) < 0) {
+        THROW_ERROR("get_mempolicy with MPOL_F_ADDR failed");
+    }
+    if (node != 0) {
+        THROW_ERROR("the memory is not on the bound node");
+    }
+    if (munmap(buf, len) < 0) {
+        THROW_ERROR("munmap failed");
+    }
+
+    if (syscall(__NR_set_mempolicy, MPOL_DEFAULT, NULL, 0) < 0) {
+        THROW_ERROR("failed to reset the memory policy");
+    }
+    nodemask = 1UL << (MAX_NODE - 1);
+    if (!(syscall(__NR_set_mempolicy, MPOL_BIND, &nodemask, MAX_NODE + 1) < 0
+            && errno == EINVAL)) {
+        THROW_ERROR("set_mempolicy with a nonexistent node should fail with EINVAL");
+    }
+    return 0;
+}
+
+int test_mbind() {
+    size_t len = 4 * PAGE_SIZE;
+    char *buf = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        THROW_ERROR("mmap failed");
+    }
+
+    unsigned long allowed = 0;
+    if (syscall(__NR_get_mempolicy, NULL, &allowed, MAX_NODE + 1, NULL,
+                MPOL_F_MEMS_ALLOWED) < 0) {
+        THROW_ERROR("get_mempolicy with MPOL_F_MEMS_ALLOWED failed");
+    }
+    if (syscall(__NR_mbind, buf, len, MPOL_BIND, &allowed, MAX_NODE + 1,
+                MPOL_MF_STRICT) < 0) {
+        THROW_ERROR("mbind to all the nodes failed");
+    }
+    if (!(syscall(__NR_mbind, buf + 1, len, MPOL_BIND, &allowed, MAX_NODE + 1, 0) < 0
+            && errno == EINVAL)) {
+        THROW_ERROR("mbind with non-page-aligned addr should fail with EINVAL");
+    }
+
+    if (munmap(buf, len) < 0) {
+        THROW_ERROR("munmap failed");
+    }
+    if (!(syscall(__NR_mbind, buf, len, MPOL_BIND, &allowed, MAX_NODE + 1, 0) < 0
+            && errno == EFAULT)) {
+        THROW_ERROR("mbind on unmapped memory should fail with EFAULT");
+    }
+    return 0;
+}
+
 // ============================================================================
 // Test suite main
 // ============================================================================
@@ -1428,6 +1876,8 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_anonymous_mmap_with_bad_hints),
     TEST_CASE(test_anonymous_mmap_with_zero_len),
     TEST_CASE(test_anonymous_mmap_with_non_page_aligned_len),
+    TEST_CASE(test_anonymous_mmap_with_hugetlb),
+    TEST_CASE(test_anonymous_mmap_larger_than_chunk),
     TEST_CASE(test_private_file_mmap),
     TEST_CASE(test_private_file_mmap_with_offset),
     TEST_CASE(test_private_file_mmap_with_invalid_fd),
@@ -1452,6 +1902,8 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_mremap),
     TEST_CASE(test_mremap_subrange),
     TEST_CASE(test_mremap_with_fixed_addr),
+    TEST_CASE(test_mremap_large_mapping_in_place),
+    TEST_CASE(test_mremap_with_zero_old_size),
     TEST_CASE(test_file_backed_mremap),
     TEST_CASE(test_file_backed_mremap_mem_may_move),
     TEST_CASE(test_mprotect_once),
@@ -1464,6 +1916,14 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_mprotect_multiple_vmas),
     TEST_CASE(test_mprotect_grow_down),
     TEST_CASE(test_mremap_concurrent),
+    TEST_CASE(test_madvise_dontneed_anonymous),
+    TEST_CASE(test_madvise_dontneed_private_file),
+    TEST_CASE(test_madvise_free_and_willneed),
+    TEST_CASE(test_madvise_reclaim_stat),
+    TEST_CASE(test_madvise_hugepage),
+    TEST_CASE(test_madvise_with_invalid_args),
+    TEST_CASE(test_set_get_mempolicy),
+    TEST_CASE(test_mbind),
 };
 
 int main() {
@@ -1,6 +1,7 @@
 #include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/wait.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -13,10 +14,44 @@
 
 #define TOTAL_BYTES     (2 * GB)
 #define BUF_SIZE        (128 * KB)
+#define MAX_NR_WRITERS  (16)
 
 #define MIN(x, y)       ((x) <= (y) ? (x) : (y))
 
-int main(int argc, const char *argv[]) {
+struct writer_args {
+    int pipe_wr_fd;
+    size_t total_bytes;
+    size_t buf_size;
+};
+
+static void *writer_thread(void *_args) {
+    struct writer_args *args = (struct writer_args *)_args;
+    char *buf = calloc(1, args->buf_size);
+    if (buf == NULL) {
+        printf("ERROR: failed to allocate the buffer\n");
+        return (void *) -1;
+    }
+
+    // Write a specified amount of data in a buffer of specified size
+    size_t remain_bytes = args->total_bytes;
+    while (remain_bytes > 0) {
+        size_t len = MIN(args->buf_size, remain_bytes);
+        ssize_t ret = write(args->pipe_wr_fd, buf, len);
+        if (ret < 0) {
+            printf("ERROR: failed to write to pipe\n");
+            free(buf);
+            return (void *) -1;
+        }
+        remain_bytes -= ret;
+    }
+
+    free(buf);
+    return NULL;
+}
+
+// Measure the throughput of a pipe that is written by multiple threads
+// concurrently and read by a single child process.
+static int bench_pipe(int nr_writers) {
     // Create pipe
     int pipe_fds[2];
     if (pipe(pipe_fds) < 0) {
@@ -45,8 +80,9 @@ int main(int argc, const char *argv[]) {
     gettimeofday(&tv_start, NULL);
 
     // Tell the reader how many data are to be transfered
-    size_t remain_bytes = TOTAL_BYTES;
-    if (write(pipe_wr_fd, &remain_bytes, sizeof(remain_bytes)) != sizeof(remain_bytes)) {
+    size_t bytes_per_writer = TOTAL_BYTES / nr_writers;
+    size_t total_bytes = bytes_per_writer * nr_writers;
+    if (write(pipe_wr_fd, &total_bytes, sizeof(total_bytes)) != sizeof(total_bytes)) {
         printf("ERROR: failed to write to pipe\n");
         return -1;
     }
@@ -58,15 +94,30 @@ int main(int argc, const char *argv[]) {
         return -1;
     }
 
-    // Write a specified amount of data in a buffer of specified size
-    char buf[BUF_SIZE] = {0};
-    while (remain_bytes > 0) {
-        size_t len = MIN(buf_size, remain_bytes);
-        if ((len = write(pipe_wr_fd, &buf, len)) < 0) {
-            printf("ERROR: failed to write to pipe\n");
+    // Write the data from multiple threads sharing the same pipe
+    pthread_t writers[MAX_NR_WRITERS];
+    struct writer_args args = {
+        .pipe_wr_fd = pipe_wr_fd,
+        .total_bytes = bytes_per_writer,
+        .buf_size = buf_size,
+    };
+    for (int i = 0; i < nr_writers; i++) {
+        if (pthread_create(&writers[i], NULL, writer_thread, &args) != 0) {
+            printf("ERROR: failed to create a writer thread\n");
             return -1;
         }
-        remain_bytes -= len;
+    }
+    int writer_failed = 0;
+    for (int i = 0; i < nr_writers; i++) {
+        void *ret = NULL;
+        pthread_join(writers[i], &ret);
+        if (ret != NULL) {
+            writer_failed = 1;
+        }
+    }
+    close(pipe_wr_fd);
+    if (writer_failed) {
+        return -1;
     }
 
     // Wait for the child process to read all data and exit
@@ -86,8 +137,30 @@ int main(int argc, const char *argv[]) {
         printf("WARNING: run long enough to get meaningful results\n");
         if (total_s == 0) { return 0; }
     }
-    double total_mb = (double)TOTAL_BYTES / MB;
+    double total_mb = (double)total_bytes / MB;
     double throughput = total_mb / total_s;
-    printf("Throughput of pipe is %.2f MB/s\n", throughput);
+    printf("Throughput of pipe with %d writer(s) is %.2f MB/s\n", nr_writers, throughput);
+    return 0;
+}
+
+int main(int argc, const char *argv[]) {
+    // By default, compare a single writer with multiple concurrent writers
+    int nr_writers_list[] = {1, 4};
+    int nr_runs = sizeof(nr_writers_list) / sizeof(nr_writers_list[0]);
+
+    if (argc >= 2) {
+        nr_writers_list[0] = atoi(argv[1]);
+        nr_runs = 1;
+        if (nr_writers_list[0] <= 0 || nr_writers_list[0] > MAX_NR_WRITERS) {
+            printf("ERROR: the number of writers must be in [1, %d]\n", MAX_NR_WRITERS);
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < nr_runs; i++) {
+        if (bench_pipe(nr_writers_list[i]) < 0) {
+            return -1;
+        }
+    }
     return 0;
 }
@@ -97,6 +97,14 @@ static int test_spawn_child_and_unlock() {
     // Sleep 3s for the child to run setlkw test and wait, is 3s enough?
     sleep(3);
 
+    // The child is waiting for the lock of parent, so waiting for the lock of child
+    // would cause a deadlock
+    struct flock tail_fl = { F_WRLCK, SEEK_SET, g_file_len * 2, 1, 0 };
+    ret = fcntl(g_fd, F_SETLKW, &tail_fl);
+    if (!(ret < 0 && errno == EDEADLK)) {
+        THROW_ERROR("failed to detect the deadlock");
+    }
+
     // Unlock the flock will cause child process to finish running
     struct flock fl = { F_UNLCK, SEEK_SET, 0, 0, 0 };
     if (fcntl(g_fd, F_SETLK, &fl) < 0) {
@@ -154,6 +162,15 @@ static int test_child_setlk() {
     return 0;
 }
 
+static int test_child_setlk_beyond_eof() {
+    // The lock is held until the child exits
+    struct flock fl = { F_WRLCK, SEEK_SET, g_file_len * 2, 1, 0 };
+    if (fcntl(g_fd, F_SETLK, &fl) < 0) {
+        THROW_ERROR("failed to lock the range beyond EOF");
+    }
+    return 0;
+}
+
 static int test_child_setlkw() {
     struct flock fl = { F_RDLCK, SEEK_SET, 0, g_file_len / 4, 0 };
     int res = fcntl(g_fd, F_SETLKW, &fl);
@@ -176,6 +193,7 @@ static test_case_t test_cases[] = {
 static test_case_t child_test_cases[] = {
     TEST_CASE(test_child_getlk),
     TEST_CASE(test_child_setlk),
+    TEST_CASE(test_child_setlk_beyond_eof),
     TEST_CASE(test_child_setlkw),
 };
 
@@ -0,0 +1,156 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define PAGE_SIZE   4096
+
+const char prog_name[] = "/bin/process_vm";
+const char parent_msg[] = "written by the parent";
+const char child_msg[] = "written by the child";
+
+// ============================================================================
+// Test cases in a process
+// ============================================================================
+
+int test_readv_scattered() {
+    char src[] = "0123456789";
+    char dst1[4] = {0}, dst2[7] = {0};
+    struct iovec local[] = {
+        { .iov_base = dst1, .iov_len = sizeof(dst1) - 1 },
+        { .iov_base = dst2, .iov_len = sizeof(dst2) - 1 },
+    };
+    struct iovec remote[] = {
+        { .iov_base = src, .iov_len = 5 },
+        { .iov_base = src + 6, .iov_len = 4 },
+    };
+
+    // The remote buffers are gathered and scattered into the local buffers
+    if (process_vm_readv(getpid(), local, 2, remote, 2, 0) != 9) {
+        THROW_ERROR("failed to read the memory");
+    }
+    if (strcmp(dst1, "012") != 0 || strcmp(dst2, "346789") != 0) {
+        THROW_ERROR("the memory is read wrongly");
+    }
+    return 0;
+}
+
+int test_writev_read_only() {
+    char buf[16] = "local";
+    struct iovec local = { .iov_base = buf, .iov_len = sizeof(buf) };
+
+    char *addr = mmap(NULL, PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        THROW_ERROR("failed to map the memory");
+    }
+    struct iovec remote = { .iov_base = addr, .iov_len = sizeof(buf) };
+    if (process_vm_writev(getpid(), &local, 1, &remote, 1, 0) >= 0 || errno != EFAULT) {
+        THROW_ERROR("the read-only memory is written");
+    }
+    if (process_vm_readv(getpid(), &local, 1, &remote, 1, 0) != sizeof(buf)) {
+        THROW_ERROR("failed to read the read-only memory");
+    }
+    munmap(addr, PAGE_SIZE);
+    return 0;
+}
+
+int test_invalid_args() {
+    char buf[16];
+    struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+    struct iovec unmapped = { .iov_base = NULL, .iov_len = sizeof(buf) };
+
+    if (process_vm_readv(getpid(), &iov, 1, &iov, 1, 1) >= 0 || errno != EINVAL) {
+        THROW_ERROR("the flags are not checked");
+    }
+    if (process_vm_readv(-1, &iov, 1, &iov, 1, 0) >= 0 || errno != ESRCH) {
+        THROW_ERROR("the pid is not checked");
+    }
+    if (process_vm_readv(getpid(), &iov, 1, &unmapped, 1, 0) >= 0 || errno != EFAULT) {
+        THROW_ERROR("the unmapped memory is read");
+    }
+    // The copy stops at the first remote buffer that is not mapped
+    struct iovec remote[] = { iov, unmapped };
+    if (process_vm_readv(getpid(), &iov, 1, remote, 2, 0) != sizeof(buf)) {
+        THROW_ERROR("the partial copy is wrong");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases between processes
+// ============================================================================
+
+static int child_read_and_write(pid_t parent, void *addr) {
+    char buf[sizeof(parent_msg)] = {0};
+    struct iovec local = { .iov_base = buf, .iov_len = sizeof(buf) };
+    struct iovec remote = { .iov_base = addr, .iov_len = sizeof(buf) };
+
+    if (process_vm_readv(parent, &local, 1, &remote, 1, 0) != sizeof(buf)) {
+        THROW_ERROR("failed to read the memory of the parent");
+    }
+    if (strcmp(buf, parent_msg) != 0) {
+        THROW_ERROR("the memory of the parent is read wrongly");
+    }
+    local.iov_base = (void *)child_msg;
+    local.iov_len = sizeof(child_msg);
+    remote.iov_len = sizeof(child_msg);
+    if (process_vm_writev(parent, &local, 1, &remote, 1, 0) != sizeof(child_msg)) {
+        THROW_ERROR("failed to write the memory of the parent");
+    }
+    return 0;
+}
+
+int test_read_and_write_parent() {
+    char buf[64];
+    char pid_buf[16], addr_buf[32];
+    char *child_argv[] = {(char *)prog_name, pid_buf, addr_buf, NULL};
+    pid_t child_pid;
+    int status;
+
+    strcpy(buf, parent_msg);
+    snprintf(pid_buf, sizeof(pid_buf), "%d", getpid());
+    snprintf(addr_buf, sizeof(addr_buf), "%lx", (unsigned long)buf);
+    if (posix_spawn(&child_pid, prog_name, NULL, NULL, child_argv, NULL) != 0) {
+        THROW_ERROR("failed to spawn a child process");
+    }
+    if (waitpid(child_pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+        THROW_ERROR("the child process failed");
+    }
+    if (strcmp(buf, child_msg) != 0) {
+        THROW_ERROR("the write of the child is not seen");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_readv_scattered),
+    TEST_CASE(test_writev_read_only),
+    TEST_CASE(test_invalid_args),
+    TEST_CASE(test_read_and_write_parent),
+};
+
+int main(int argc, const char *argv[]) {
+    if (argc > 2) {
+        // The child process arrives here
+        pid_t parent = atoi(argv[1]);
+        void *addr = (void *)strtoul(argv[2], NULL, 16);
+        return child_read_and_write(parent, addr) < 0 ? -1 : 0;
+    }
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
@@ -10,6 +10,7 @@
 #include <sys/resource.h>
 #include <sys/syscall.h>
 #include <sys/wait.h>
+#include <stdint.h>
 #include "test.h"
 
 // ============================================================================
@@ -304,6 +305,61 @@ static int test_getcpu_after_setaffinity() {
     return 0;
 }
 
+// ============================================================================
+// Test cases for rseq
+// ============================================================================
+
+#ifndef __NR_rseq
+#define __NR_rseq 334
+#endif
+
+#define RSEQ_FLAG_UNREGISTER 1
+#define RSEQ_SIG 0x53053053
+
+struct rseq_area {
+    uint32_t cpu_id_start;
+    uint32_t cpu_id;
+    uint64_t rseq_cs;
+    uint32_t flags;
+} __attribute__((aligned(32)));
+
+static int test_rseq_register() {
+    static struct rseq_area rseq;
+    memset(&rseq, 0, sizeof(rseq));
+    rseq.cpu_id = -1;
+
+    if (syscall(__NR_rseq, &rseq, sizeof(rseq), 0, RSEQ_SIG) < 0) {
+        // rseq is only supported in the M:N mode, and libc may have registered it
+        if (errno == ENOSYS || errno == EBUSY) {
+            return 0;
+        }
+        THROW_ERROR("failed to register rseq");
+    }
+    if (syscall(__NR_rseq, &rseq, sizeof(rseq), 0, RSEQ_SIG) == 0 || errno != EBUSY) {
+        THROW_ERROR("registering rseq twice should fail");
+    }
+
+    int cpu;
+    if (syscall(__NR_getcpu, &cpu, NULL, NULL) < 0) {
+        THROW_ERROR("getcpu fail");
+    }
+    if (rseq.cpu_id != rseq.cpu_id_start || rseq.cpu_id != cpu) {
+        THROW_ERROR("the cpu id of rseq is not the current cpu");
+    }
+
+    if (syscall(__NR_rseq, &rseq, sizeof(rseq), RSEQ_FLAG_UNREGISTER, RSEQ_SIG + 1) == 0
+            || errno != EPERM) {
+        THROW_ERROR("unregistering rseq with wrong signature should fail");
+    }
+    if (syscall(__NR_rseq, &rseq, sizeof(rseq), RSEQ_FLAG_UNREGISTER, RSEQ_SIG) < 0) {
+        THROW_ERROR("failed to unregister rseq");
+    }
+    if (rseq.cpu_id != (uint32_t) -1) {
+        THROW_ERROR("the cpu id of rseq is not reset");
+    }
+    return 0;
+}
+
 // ============================================================================
 // Test cases for setpriority and getpriority
 // ============================================================================
@@ -374,6 +430,7 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_sched_xetaffinity_children_inheritance),
     TEST_CASE(test_getcpu),
     TEST_CASE(test_getcpu_after_setaffinity),
+    TEST_CASE(test_rseq_register),
     TEST_CASE(test_set_get_priority_process),
     TEST_CASE(test_set_get_priority_pgrp),
     TEST_CASE(test_set_get_priority_user),
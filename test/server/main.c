@@ -413,8 +413,394 @@ int test_poll() {
     return 0;
 }
 
+// The readiness of host sockets is cached, which must not outlive the data
+int test_poll_cached_readiness() {
+    int port = 8808;
+    int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(sock_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        THROW_ERROR("bind socket failed");
+    }
+
+    struct pollfd polls[] = {
+        { .fd = sock_fd, .events = POLLIN | POLLOUT }
+    };
+    if (poll(polls, 1, 0) != 1 || polls[0].revents != POLLOUT) {
+        THROW_ERROR("the socket should be writable only");
+    }
+
+    if (sendto(sock_fd, DEFAULT_MSG, strlen(DEFAULT_MSG), 0,
+               (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        THROW_ERROR("sendto failed");
+    }
+    // Poll twice without receiving the message
+    for (int i = 0; i < 2; i++) {
+        polls[0].events = POLLIN;
+        if (poll(polls, 1, 1000) != 1 || polls[0].revents != POLLIN) {
+            THROW_ERROR("the socket should be readable");
+        }
+    }
+
+    char buf[64];
+    if (recv(sock_fd, buf, sizeof(buf), 0) != strlen(DEFAULT_MSG)) {
+        THROW_ERROR("recv failed");
+    }
+    for (int i = 0; i < 2; i++) {
+        if (poll(polls, 1, 0) != 0) {
+            THROW_ERROR("the socket should not be readable");
+        }
+    }
+
+    close(sock_fd);
+    return 0;
+}
+
+int test_udp_loopback() {
+    int port = 8809;
+    int recv_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (recv_fd < 0 || send_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+
+    struct sockaddr_in servaddr;
+    memset(&servaddr, 0, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    servaddr.sin_port = htons(port);
+    if (bind(recv_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("bind socket failed");
+    }
+
+    // The unbound sender is bound by sendto, whose address is seen by the receiver
+    if (sendto(send_fd, DEFAULT_MSG, sizeof(DEFAULT_MSG), 0,
+               (struct sockaddr *) &servaddr, sizeof(servaddr)) != sizeof(DEFAULT_MSG)) {
+        THROW_ERROR("sendto failed");
+    }
+    char buf[64] = {0};
+    struct sockaddr_in from_addr, send_addr;
+    socklen_t addr_len = sizeof(from_addr);
+    if (recvfrom(recv_fd, buf, sizeof(buf), MSG_PEEK, (struct sockaddr *) &from_addr,
+                 &addr_len) != sizeof(DEFAULT_MSG) || strcmp(buf, DEFAULT_MSG) != 0) {
+        THROW_ERROR("failed to peek the datagram");
+    }
+    memset(buf, 0, sizeof(buf));
+    if (recvfrom(recv_fd, buf, sizeof(buf), 0, (struct sockaddr *) &from_addr,
+                 &addr_len) != sizeof(DEFAULT_MSG) || strcmp(buf, DEFAULT_MSG) != 0) {
+        THROW_ERROR("failed to receive the peeked datagram");
+    }
+    socklen_t send_addr_len = sizeof(send_addr);
+    if (getsockname(send_fd, (struct sockaddr *) &send_addr, &send_addr_len) < 0) {
+        THROW_ERROR("getsockname error");
+    }
+    if (addr_len != sizeof(from_addr) || from_addr.sin_port != send_addr.sin_port ||
+            from_addr.sin_addr.s_addr != htonl(INADDR_LOOPBACK)) {
+        THROW_ERROR("the source address mismatches the sender");
+    }
+
+    // Reply to the sender
+    if (sendto(recv_fd, RESPONSE, sizeof(RESPONSE), 0, (struct sockaddr *) &from_addr,
+               addr_len) != sizeof(RESPONSE)) {
+        THROW_ERROR("failed to reply");
+    }
+    if (recv(send_fd, buf, sizeof(buf), 0) != sizeof(RESPONSE) || strcmp(buf, RESPONSE) != 0) {
+        THROW_ERROR("failed to receive the reply");
+    }
+
+    // The rest of a truncated datagram is discarded
+    if (send(send_fd, DEFAULT_MSG, sizeof(DEFAULT_MSG), 0) >= 0 || errno != EDESTADDRREQ) {
+        THROW_ERROR("send without an address should fail before connect");
+    }
+    if (connect(send_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("connect error");
+    }
+    if (send(send_fd, DEFAULT_MSG, sizeof(DEFAULT_MSG), 0) != sizeof(DEFAULT_MSG)) {
+        THROW_ERROR("send failed");
+    }
+    struct iovec iov = { .iov_base = buf, .iov_len = 2 };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (recvmsg(recv_fd, &msg, 0) != 2 || !(msg.msg_flags & MSG_TRUNC)) {
+        THROW_ERROR("the datagram should be truncated");
+    }
+    if (recv(recv_fd, buf, sizeof(buf), MSG_DONTWAIT) >= 0 || errno != EAGAIN) {
+        THROW_ERROR("no datagram should be left");
+    }
+
+    close(send_fd);
+    close(recv_fd);
+    return 0;
+}
+
+int test_loopback_addrs_and_shutdown() {
+    int port = 8806;
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+    int reuse = 1;
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+        THROW_ERROR("setsockopt port to reuse failed");
+    }
+
+    struct sockaddr_in servaddr;
+    memset(&servaddr, 0, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    servaddr.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("bind socket failed");
+    }
+    if (listen(listen_fd, 1) < 0) {
+        THROW_ERROR("listen socket error");
+    }
+
+    // Both ends are in the same process, so the connection must not block
+    int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+    if (connect(client_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("connect error");
+    }
+
+    struct sockaddr_in peer_addr;
+    socklen_t peer_addr_len = sizeof(peer_addr);
+    int server_fd = accept(listen_fd, (struct sockaddr *) &peer_addr, &peer_addr_len);
+    if (server_fd < 0) {
+        THROW_ERROR("accept socket error");
+    }
+
+    struct sockaddr_in client_addr, server_addr;
+    socklen_t addr_len = sizeof(client_addr);
+    if (getsockname(client_fd, (struct sockaddr *) &client_addr, &addr_len) < 0) {
+        THROW_ERROR("getsockname error");
+    }
+    if (peer_addr_len != addr_len || peer_addr.sin_port != client_addr.sin_port ||
+            peer_addr.sin_addr.s_addr != client_addr.sin_addr.s_addr) {
+        THROW_ERROR("the peer address from accept mismatches the client address");
+    }
+    addr_len = sizeof(server_addr);
+    if (getpeername(client_fd, (struct sockaddr *) &server_addr, &addr_len) < 0) {
+        THROW_ERROR("getpeername error");
+    }
+    if (server_addr.sin_port != servaddr.sin_port ||
+            server_addr.sin_addr.s_addr != servaddr.sin_addr.s_addr) {
+        THROW_ERROR("the peer address of the client mismatches the server address");
+    }
+
+    char buf[sizeof(ECHO_MSG)];
+    if (write(client_fd, ECHO_MSG, sizeof(ECHO_MSG)) != sizeof(ECHO_MSG)) {
+        THROW_ERROR("write failed");
+    }
+    if (shutdown(client_fd, SHUT_WR) < 0) {
+        THROW_ERROR("shutdown failed");
+    }
+    if (read(server_fd, buf, sizeof(buf)) != sizeof(ECHO_MSG) ||
+            strcmp(buf, ECHO_MSG) != 0) {
+        THROW_ERROR("read failed");
+    }
+    if (read(server_fd, buf, sizeof(buf)) != 0) {
+        THROW_ERROR("read after the peer shutdown should return EOF");
+    }
+
+    close(server_fd);
+    close(client_fd);
+    close(listen_fd);
+    return 0;
+}
+
+static void *write_msg_in_halves(void *arg) {
+    int fd = *(int *)arg;
+    size_t half = sizeof(ECHO_MSG) / 2;
+    write(fd, ECHO_MSG, half);
+    // Let the reader block before the rest of the message arrives
+    usleep(100 * 1000);
+    write(fd, ECHO_MSG + half, sizeof(ECHO_MSG) - half);
+    return NULL;
+}
+
+int test_loopback_peek_oob_and_waitall() {
+    int port = 8807;
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+    int reuse = 1;
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+        THROW_ERROR("setsockopt port to reuse failed");
+    }
+
+    struct sockaddr_in servaddr;
+    memset(&servaddr, 0, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    servaddr.sin_port = htons(port);
+    if (bind(listen_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("bind socket failed");
+    }
+    if (listen(listen_fd, 1) < 0) {
+        THROW_ERROR("listen socket error");
+    }
+    int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+    if (connect(client_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("connect error");
+    }
+    int server_fd = accept(listen_fd, NULL, NULL);
+    if (server_fd < 0) {
+        THROW_ERROR("accept socket error");
+    }
+
+    // The peeked data are received again
+    char buf[sizeof(ECHO_MSG)] = {0};
+    if (write(client_fd, DEFAULT_MSG, sizeof(DEFAULT_MSG)) != sizeof(DEFAULT_MSG)) {
+        THROW_ERROR("write failed");
+    }
+    if (recv(server_fd, buf, sizeof(DEFAULT_MSG), MSG_PEEK) != sizeof(DEFAULT_MSG) ||
+            strcmp(buf, DEFAULT_MSG) != 0) {
+        THROW_ERROR("failed to peek the data");
+    }
+    memset(buf, 0, sizeof(buf));
+    if (recv(server_fd, buf, sizeof(DEFAULT_MSG), 0) != sizeof(DEFAULT_MSG) ||
+            strcmp(buf, DEFAULT_MSG) != 0) {
+        THROW_ERROR("failed to receive the peeked data");
+    }
+
+    // The last byte sent with MSG_OOB is received out of band
+    if (send(client_fd, "ab", 2, MSG_OOB) != 2) {
+        THROW_ERROR("failed to send out-of-band data");
+    }
+    struct pollfd pollfd = { .fd = server_fd, .events = POLLPRI };
+    if (poll(&pollfd, 1, 1000) != 1 || !(pollfd.revents & POLLPRI)) {
+        THROW_ERROR("out-of-band data should be reported by POLLPRI");
+    }
+    if (recv(server_fd, buf, 1, MSG_OOB) != 1 || buf[0] != 'b') {
+        THROW_ERROR("failed to receive out-of-band data");
+    }
+    if (recv(server_fd, buf, sizeof(buf), 0) != 1 || buf[0] != 'a') {
+        THROW_ERROR("failed to receive the data before the out-of-band data");
+    }
+    if (recv(server_fd, buf, 1, MSG_OOB) >= 0 || errno != EINVAL) {
+        THROW_ERROR("out-of-band data should be received only once");
+    }
+
+    // MSG_WAITALL waits until the buffer is full
+    pthread_t writer;
+    if (pthread_create(&writer, NULL, write_msg_in_halves, &client_fd) != 0) {
+        THROW_ERROR("failed to create the writer thread");
+    }
+    memset(buf, 0, sizeof(buf));
+    if (recv(server_fd, buf, sizeof(ECHO_MSG), MSG_WAITALL) != sizeof(ECHO_MSG) ||
+            strcmp(buf, ECHO_MSG) != 0) {
+        THROW_ERROR("MSG_WAITALL should wait for the whole message");
+    }
+    pthread_join(writer, NULL);
+
+    close(server_fd);
+    close(client_fd);
+    close(listen_fd);
+    return 0;
+}
+
 // This is a testcase mocking pyspark exit procedure. Client process is receiving and blocking.
 // One of server process' child thread waits for the client to exit and the main thread calls exit_group.
+#ifdef __GLIBC__
+#define NR_MMSGS 3
+
+int test_udp_sendmmsg_recvmmsg() {
+    int port = 8807;
+    int recv_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (recv_fd < 0 || send_fd < 0) {
+        THROW_ERROR("create socket error");
+    }
+
+    struct sockaddr_in servaddr;
+    memset(&servaddr, 0, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    servaddr.sin_port = htons(port);
+    if (bind(recv_fd, (struct sockaddr *) &servaddr, sizeof(servaddr)) < 0) {
+        THROW_ERROR("bind socket failed");
+    }
+
+    // Send messages of different lengths in one batch
+    const char *msgs[NR_MMSGS] = { "a", "bcd", "efghijk" };
+    struct iovec send_iovs[NR_MMSGS];
+    struct mmsghdr send_mmsgs[NR_MMSGS];
+    memset(send_mmsgs, 0, sizeof(send_mmsgs));
+    for (int i = 0; i < NR_MMSGS; i++) {
+        send_iovs[i].iov_base = (void *) msgs[i];
+        send_iovs[i].iov_len = strlen(msgs[i]);
+        send_mmsgs[i].msg_hdr.msg_name = &servaddr;
+        send_mmsgs[i].msg_hdr.msg_namelen = sizeof(servaddr);
+        send_mmsgs[i].msg_hdr.msg_iov = &send_iovs[i];
+        send_mmsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    if (sendmmsg(send_fd, send_mmsgs, NR_MMSGS, 0) != NR_MMSGS) {
+        THROW_ERROR("sendmmsg failed");
+    }
+    for (int i = 0; i < NR_MMSGS; i++) {
+        if (send_mmsgs[i].msg_len != strlen(msgs[i])) {
+            THROW_ERROR("wrong msg_len of sendmmsg");
+        }
+    }
+
+    // Receive them in one batch with one more buffer than needed, which must not block
+    char bufs[NR_MMSGS + 1][16];
+    struct sockaddr_in addrs[NR_MMSGS + 1];
+    struct iovec recv_iovs[NR_MMSGS + 1];
+    struct mmsghdr recv_mmsgs[NR_MMSGS + 1];
+    memset(recv_mmsgs, 0, sizeof(recv_mmsgs));
+    for (int i = 0; i < NR_MMSGS + 1; i++) {
+        recv_iovs[i].iov_base = bufs[i];
+        recv_iovs[i].iov_len = sizeof(bufs[i]);
+        recv_mmsgs[i].msg_hdr.msg_name = &addrs[i];
+        recv_mmsgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        recv_mmsgs[i].msg_hdr.msg_iov = &recv_iovs[i];
+        recv_mmsgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    struct timespec timeout = { .tv_sec = 1, .tv_nsec = 0 };
+    int nr_recvd = recvmmsg(recv_fd, recv_mmsgs, NR_MMSGS + 1, MSG_WAITFORONE, &timeout);
+    if (nr_recvd <= 0 || nr_recvd > NR_MMSGS) {
+        THROW_ERROR("recvmmsg failed");
+    }
+    for (int i = 0; i < nr_recvd; i++) {
+        if (recv_mmsgs[i].msg_len != strlen(msgs[i]) ||
+                strncmp(bufs[i], msgs[i], recv_mmsgs[i].msg_len) != 0) {
+            THROW_ERROR("the message boundary is not preserved");
+        }
+        if (recv_mmsgs[i].msg_hdr.msg_namelen != sizeof(struct sockaddr_in)) {
+            THROW_ERROR("wrong msg_namelen of recvmmsg");
+        }
+    }
+
+    // No message is left after all are received
+    if (nr_recvd == NR_MMSGS &&
+            (recvmmsg(recv_fd, recv_mmsgs, NR_MMSGS, MSG_DONTWAIT, NULL) >= 0 ||
+             errno != EAGAIN)) {
+        THROW_ERROR("recvmmsg should fail with EAGAIN");
+    }
+
+    close(send_fd);
+    close(recv_fd);
+    return 0;
+}
+#endif
+
 static int test_exit_group() {
     int port = 8888;
     int pipes[2];
@@ -511,6 +897,13 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_fcntl_setfl_and_getfl),
     TEST_CASE(test_poll),
     TEST_CASE(test_poll_events_unchanged),
+    TEST_CASE(test_poll_cached_readiness),
+    TEST_CASE(test_loopback_addrs_and_shutdown),
+    TEST_CASE(test_loopback_peek_oob_and_waitall),
+    TEST_CASE(test_udp_loopback),
+#ifdef __GLIBC__
+    TEST_CASE(test_udp_sendmmsg_recvmmsg),
+#endif
     TEST_CASE(test_exit_group),
 };
 
@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+
+// ============================================================================
+// Helper functions
+// ============================================================================
+
+static int block_signals(sigset_t *mask, int signum) {
+    sigemptyset(mask);
+    sigaddset(mask, signum);
+    if (sigprocmask(SIG_BLOCK, mask, NULL) < 0) {
+        THROW_ERROR("failed to block the signal");
+    }
+    return 0;
+}
+
+static int unblock_signals(sigset_t *mask) {
+    if (sigprocmask(SIG_UNBLOCK, mask, NULL) < 0) {
+        THROW_ERROR("failed to unblock the signal");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases for signalfd
+// ============================================================================
+
+int test_read_signal() {
+    struct signalfd_siginfo info;
+    sigset_t mask;
+
+    if (block_signals(&mask, SIGUSR1) < 0) {
+        return -1;
+    }
+    int fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a signalfd");
+    }
+    if (kill(getpid(), SIGUSR1) < 0) {
+        THROW_ERROR("failed to send the signal");
+    }
+    if (read(fd, &info, sizeof(info)) != sizeof(info)) {
+        THROW_ERROR("failed to read the signalfd");
+    }
+    if (info.ssi_signo != SIGUSR1 || info.ssi_code != SI_USER || info.ssi_pid != getpid()) {
+        THROW_ERROR("the signal information is wrong");
+    }
+    close(fd);
+    return unblock_signals(&mask);
+}
+
+int test_read_signals_in_batch() {
+    struct signalfd_siginfo infos[4];
+    sigset_t mask;
+    int expected_signums[] = {SIGRTMIN, SIGRTMIN, SIGRTMIN + 1};
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGRTMIN);
+    sigaddset(&mask, SIGRTMIN + 1);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0) {
+        THROW_ERROR("failed to block the signals");
+    }
+    int fd = signalfd(-1, &mask, 0);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a signalfd");
+    }
+    if (kill(getpid(), SIGRTMIN + 1) < 0 || kill(getpid(), SIGRTMIN) < 0 ||
+            kill(getpid(), SIGRTMIN) < 0) {
+        THROW_ERROR("failed to send the signals");
+    }
+
+    // All the queued real-time signals are read at once, the lowest-numbered first
+    if (read(fd, infos, sizeof(infos)) != 3 * sizeof(infos[0])) {
+        THROW_ERROR("failed to read the signals in a batch");
+    }
+    for (int i = 0; i < 3; i++) {
+        if (infos[i].ssi_signo != expected_signums[i] || infos[i].ssi_code != SI_USER) {
+            THROW_ERROR("the signal information is wrong");
+        }
+    }
+    close(fd);
+    return unblock_signals(&mask);
+}
+
+int test_nonblock_and_invalid_args() {
+    struct signalfd_siginfo info;
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a signalfd");
+    }
+    if (read(fd, &info, sizeof(info)) >= 0 || errno != EAGAIN) {
+        THROW_ERROR("the read does not fail without signals");
+    }
+    if (read(fd, &info, sizeof(info) - 1) >= 0 || errno != EINVAL) {
+        THROW_ERROR("the small buffer is not checked");
+    }
+    if (signalfd(-1, &mask, 1) >= 0 || errno != EINVAL) {
+        THROW_ERROR("the flags are not checked");
+    }
+    if (signalfd(STDOUT_FILENO, &mask, 0) >= 0 || errno != EINVAL) {
+        THROW_ERROR("the signalfd is not checked");
+    }
+    // The mask of an existing signalfd can be changed
+    sigaddset(&mask, SIGUSR2);
+    if (signalfd(fd, &mask, 0) != fd) {
+        THROW_ERROR("failed to change the mask");
+    }
+    close(fd);
+    return 0;
+}
+
+int test_epoll_signalfd() {
+    struct signalfd_siginfo info;
+    struct epoll_event event;
+    sigset_t mask;
+
+    if (block_signals(&mask, SIGUSR2) < 0) {
+        return -1;
+    }
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK);
+    int epfd = epoll_create1(0);
+    if (fd < 0 || epfd < 0) {
+        THROW_ERROR("failed to create the files");
+    }
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        THROW_ERROR("failed to add the signalfd");
+    }
+    if (epoll_wait(epfd, &event, 1, 0) != 0) {
+        THROW_ERROR("the signalfd is ready without signals");
+    }
+    if (kill(getpid(), SIGUSR2) < 0) {
+        THROW_ERROR("failed to send the signal");
+    }
+    if (epoll_wait(epfd, &event, 1, 1000) != 1 || event.data.fd != fd ||
+            (event.events & EPOLLIN) == 0) {
+        THROW_ERROR("the signalfd is not ready");
+    }
+    if (read(fd, &info, sizeof(info)) != sizeof(info) || info.ssi_signo != SIGUSR2) {
+        THROW_ERROR("failed to read the signal");
+    }
+    close(epfd);
+    close(fd);
+    return unblock_signals(&mask);
+}
+
+static void *read_signal_of_thread(void *arg) {
+    struct signalfd_siginfo info;
+    int fd = *(int *)arg;
+
+    // The signal sent to this thread wakes it up, though another thread creates the fd
+    if (read(fd, &info, sizeof(info)) != sizeof(info) || info.ssi_signo != SIGUSR2) {
+        return (void *) -1;
+    }
+    return NULL;
+}
+
+int test_read_in_another_thread() {
+    pthread_t thread;
+    sigset_t mask;
+    void *ret;
+
+    if (block_signals(&mask, SIGUSR2) < 0) {
+        return -1;
+    }
+    int fd = signalfd(-1, &mask, 0);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a signalfd");
+    }
+    if (pthread_create(&thread, NULL, read_signal_of_thread, &fd) != 0) {
+        THROW_ERROR("failed to create the thread");
+    }
+    usleep(100 * 1000);
+    if (pthread_kill(thread, SIGUSR2) != 0) {
+        THROW_ERROR("failed to send the signal to the thread");
+    }
+    if (pthread_join(thread, &ret) != 0 || ret != NULL) {
+        THROW_ERROR("the thread failed to read its signal");
+    }
+    close(fd);
+    return unblock_signals(&mask);
+}
+
+static volatile int handler_called = 0;
+
+static void signal_handler(int signum) {
+    handler_called = 1;
+}
+
+int test_signal_not_handled() {
+    struct signalfd_siginfo info;
+    sigset_t mask;
+
+    if (signal(SIGUSR1, signal_handler) == SIG_ERR) {
+        THROW_ERROR("failed to set the handler");
+    }
+    if (block_signals(&mask, SIGUSR1) < 0) {
+        return -1;
+    }
+    int fd = signalfd(-1, &mask, 0);
+    if (fd < 0) {
+        THROW_ERROR("failed to create a signalfd");
+    }
+    if (kill(getpid(), SIGUSR1) < 0) {
+        THROW_ERROR("failed to send the signal");
+    }
+    if (read(fd, &info, sizeof(info)) != sizeof(info)) {
+        THROW_ERROR("failed to read the signalfd");
+    }
+    // The signal read from the signalfd is no longer pending
+    if (unblock_signals(&mask) < 0) {
+        return -1;
+    }
+    if (handler_called) {
+        THROW_ERROR("the signal is handled after it is read");
+    }
+    close(fd);
+    signal(SIGUSR1, SIG_DFL);
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_read_signal),
+    TEST_CASE(test_read_signals_in_batch),
+    TEST_CASE(test_nonblock_and_invalid_args),
+    TEST_CASE(test_epoll_signalfd),
+    TEST_CASE(test_read_in_another_thread),
+    TEST_CASE(test_signal_not_handled),
+};
+
+int main() {
+    return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+}
@@ -0,0 +1,442 @@
+#define _GNU_SOURCE
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/sem.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "test.h"
+
+// ============================================================================
+// Global definitions
+// ============================================================================
+
+#define S_IRWUSER   (S_IRUSR | S_IWUSR)
+
+#define TEST_SEM_UNDO   0
+
+union semun {
+    int val;
+    struct semid_ds *buf;
+    unsigned short *array;
+};
+
+struct test_msg {
+    long mtype;
+    char mtext[16];
+};
+
+const char prog_name[] = "/bin/sysv_ipc";
+
+// Spawn a child with the option and the argument, and wait for it to succeed
+static int execute_in_child(int option, int arg) {
+    char option_buf[16], arg_buf[16];
+    char *child_argv[] = {(char *)prog_name, option_buf, arg_buf, NULL};
+    pid_t child_pid;
+    int status;
+
+    snprintf(option_buf, sizeof(option_buf), "%d", option);
+    snprintf(arg_buf, sizeof(arg_buf), "%d", arg);
+    if (posix_spawn(&child_pid, prog_name, NULL, NULL, child_argv, NULL) != 0) {
+        THROW_ERROR("failed to spawn a child process");
+    }
+    if (waitpid(child_pid, &status, 0) < 0) {
+        THROW_ERROR("failed to wait for the child process");
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        THROW_ERROR("the test in the child process failed");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases for semaphores
+// ============================================================================
+
+static int test_semget_by_key() {
+    key_t key;
+    int semid, ret;
+
+    srand(time(NULL));
+    key = random();
+    ret = semget(key, 1, S_IRWUSER);
+    if (ret != -1 || errno != ENOENT) {
+        THROW_ERROR("semget should fail with ENOENT for a non-existent key");
+    }
+    semid = semget(key, 2, IPC_CREAT | IPC_EXCL | S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    if (semget(key, 2, S_IRWUSER) != semid) {
+        THROW_ERROR("semget should get the set by key");
+    }
+    ret = semget(key, 3, S_IRWUSER);
+    if (ret != -1 || errno != EINVAL) {
+        THROW_ERROR("semget should fail with EINVAL for too many semaphores");
+    }
+    ret = semget(key, 2, IPC_CREAT | IPC_EXCL | S_IRWUSER);
+    if (ret != -1 || errno != EEXIST) {
+        THROW_ERROR("semget should fail with EEXIST for an existing key");
+    }
+
+    struct semid_ds ds;
+    union semun arg = { .buf = &ds };
+    if (semctl(semid, 0, IPC_STAT, arg) < 0) {
+        THROW_ERROR("failed to stat the semaphore set");
+    }
+    if (ds.sem_nsems != 2 || ds.sem_perm.__key != key) {
+        THROW_ERROR("the status of the semaphore set is wrong");
+    }
+    if (semctl(semid, 0, IPC_RMID) < 0) {
+        THROW_ERROR("failed to remove the semaphore set");
+    }
+    ret = semctl(semid, 0, GETVAL);
+    if (ret != -1 || errno != EINVAL) {
+        THROW_ERROR("semctl should fail with EINVAL for a removed set");
+    }
+    return 0;
+}
+
+static int test_semop_lock_and_unlock() {
+    struct sembuf lock = { .sem_num = 0, .sem_op = -1, .sem_flg = IPC_NOWAIT };
+    struct sembuf unlock = { .sem_num = 0, .sem_op = 1, .sem_flg = 0 };
+    union semun arg = { .val = 1 };
+    int semid, ret;
+
+    semid = semget(IPC_PRIVATE, 1, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    if (semctl(semid, 0, SETVAL, arg) < 0) {
+        THROW_ERROR("failed to set the value");
+    }
+    if (semop(semid, &lock, 1) < 0) {
+        THROW_ERROR("failed to lock");
+    }
+    if (semctl(semid, 0, GETVAL) != 0 || semctl(semid, 0, GETPID) != getpid()) {
+        THROW_ERROR("the semaphore is not locked");
+    }
+    ret = semop(semid, &lock, 1);
+    if (ret != -1 || errno != EAGAIN) {
+        THROW_ERROR("semop should fail with EAGAIN on a locked semaphore");
+    }
+    if (semop(semid, &unlock, 1) < 0 || semctl(semid, 0, GETVAL) != 1) {
+        THROW_ERROR("failed to unlock");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+static int test_semop_time() {
+    struct sembuf unlock = { .sem_num = 0, .sem_op = 1, .sem_flg = 0 };
+    struct semid_ds ds;
+    union semun arg = { .buf = &ds };
+    int semid;
+
+    semid = semget(IPC_PRIVATE, 1, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    if (semctl(semid, 0, IPC_STAT, arg) < 0 || ds.sem_otime != 0) {
+        THROW_ERROR("the time of semop should be zero before any semop");
+    }
+    time_t op_time = time(NULL);
+    if (semop(semid, &unlock, 1) < 0) {
+        THROW_ERROR("failed to unlock");
+    }
+    // The time is of the semop, rather than of the IPC_STAT
+    sleep(2);
+    if (semctl(semid, 0, IPC_STAT, arg) < 0 || ds.sem_otime < op_time - 1 ||
+            ds.sem_otime > op_time + 1) {
+        THROW_ERROR("the time of semop is wrong");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+static int test_semop_all_or_nothing() {
+    unsigned short vals[2] = {1, 0};
+    union semun arg = { .array = vals };
+    struct sembuf sops[2] = {
+        { .sem_num = 0, .sem_op = -1, .sem_flg = IPC_NOWAIT },
+        { .sem_num = 1, .sem_op = -1, .sem_flg = IPC_NOWAIT },
+    };
+    int semid, ret;
+
+    semid = semget(IPC_PRIVATE, 2, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    if (semctl(semid, 0, SETALL, arg) < 0) {
+        THROW_ERROR("failed to set the values");
+    }
+    // The second operation cannot proceed, so neither is done
+    ret = semop(semid, sops, 2);
+    if (ret != -1 || errno != EAGAIN) {
+        THROW_ERROR("semop should fail with EAGAIN");
+    }
+    if (semctl(semid, 0, GETVAL) != 1) {
+        THROW_ERROR("the first operation should not be done");
+    }
+    vals[1] = 1;
+    if (semctl(semid, 0, SETALL, arg) < 0 || semop(semid, sops, 2) < 0) {
+        THROW_ERROR("failed to do the operations");
+    }
+    if (semctl(semid, 0, GETALL, arg) < 0 || vals[0] != 0 || vals[1] != 0) {
+        THROW_ERROR("the operations are not done");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+static int test_semtimedop_timeout() {
+    struct sembuf sop = { .sem_num = 0, .sem_op = -1, .sem_flg = 0 };
+    struct timespec timeout = { .tv_sec = 0, .tv_nsec = 100 * 1000 * 1000 };
+    int semid, ret;
+
+    semid = semget(IPC_PRIVATE, 1, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    ret = semtimedop(semid, &sop, 1, &timeout);
+    if (ret != -1 || errno != EAGAIN) {
+        THROW_ERROR("semtimedop should fail with EAGAIN on timeout");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+static void *post_after_sleep(void *arg) {
+    struct sembuf sop = { .sem_num = 0, .sem_op = 1, .sem_flg = 0 };
+    int semid = *(int *)arg;
+
+    usleep(100 * 1000);
+    semop(semid, &sop, 1);
+    return NULL;
+}
+
+static int test_semop_wait_and_wake() {
+    struct sembuf sop = { .sem_num = 0, .sem_op = -1, .sem_flg = 0 };
+    pthread_t thread;
+    int semid;
+
+    semid = semget(IPC_PRIVATE, 1, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    if (pthread_create(&thread, NULL, post_after_sleep, &semid) != 0) {
+        THROW_ERROR("failed to create the thread");
+    }
+    if (semop(semid, &sop, 1) < 0) {
+        THROW_ERROR("failed to wait for the semaphore");
+    }
+    pthread_join(thread, NULL);
+    if (semctl(semid, 0, GETVAL) != 0) {
+        THROW_ERROR("the semaphore value is wrong");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+static int child_test_sem_undo(int semid) {
+    struct sembuf sop = { .sem_num = 0, .sem_op = 1, .sem_flg = SEM_UNDO };
+
+    if (semop(semid, &sop, 1) < 0 || semctl(semid, 0, GETVAL) != 1) {
+        THROW_ERROR("failed to post the semaphore");
+    }
+    return 0;
+}
+
+static int test_sem_undo_on_exit() {
+    int semid;
+
+    semid = semget(IPC_PRIVATE, 1, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    if (execute_in_child(TEST_SEM_UNDO, semid) < 0) {
+        return -1;
+    }
+    // The post of the child is undone when it exits
+    if (semctl(semid, 0, GETVAL) != 0) {
+        THROW_ERROR("the operation with SEM_UNDO is not undone");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+// ============================================================================
+// Test cases for message queues
+// ============================================================================
+
+static int send_msg(int msqid, long mtype, const char *text) {
+    struct test_msg msg = { .mtype = mtype };
+    strncpy(msg.mtext, text, sizeof(msg.mtext));
+    return msgsnd(msqid, &msg, strlen(text) + 1, IPC_NOWAIT);
+}
+
+static int test_msg_recv_by_type() {
+    struct test_msg msg;
+    int msqid, ret;
+
+    msqid = msgget(IPC_PRIVATE, S_IRWUSER);
+    if (msqid < 0) {
+        THROW_ERROR("failed to create the message queue");
+    }
+    if (send_msg(msqid, 3, "three") < 0 || send_msg(msqid, 1, "one") < 0 ||
+            send_msg(msqid, 2, "two") < 0) {
+        THROW_ERROR("failed to send the messages");
+    }
+
+    // The first message of type 2
+    ret = msgrcv(msqid, &msg, sizeof(msg.mtext), 2, 0);
+    if (ret != strlen("two") + 1 || msg.mtype != 2 || strcmp(msg.mtext, "two") != 0) {
+        THROW_ERROR("failed to receive the message of type 2");
+    }
+    // The first message of the lowest type that is not greater than 3
+    ret = msgrcv(msqid, &msg, sizeof(msg.mtext), -3, 0);
+    if (ret < 0 || msg.mtype != 1) {
+        THROW_ERROR("failed to receive the message of the lowest type");
+    }
+    // The copy of a message never waits or skips a type
+    ret = msgrcv(msqid, &msg, sizeof(msg.mtext), 0, MSG_COPY);
+    if (ret != -1 || errno != EINVAL) {
+        THROW_ERROR("MSG_COPY should fail with EINVAL without IPC_NOWAIT");
+    }
+    ret = msgrcv(msqid, &msg, sizeof(msg.mtext), 0, MSG_COPY | IPC_NOWAIT | MSG_EXCEPT);
+    if (ret != -1 || errno != EINVAL) {
+        THROW_ERROR("MSG_COPY should fail with EINVAL with MSG_EXCEPT");
+    }
+    // The message is too long to receive without MSG_NOERROR
+    ret = msgrcv(msqid, &msg, 2, 0, 0);
+    if (ret != -1 || errno != E2BIG) {
+        THROW_ERROR("msgrcv should fail with E2BIG");
+    }
+    ret = msgrcv(msqid, &msg, 2, 0, MSG_NOERROR);
+    if (ret != 2 || msg.mtype != 3 || strncmp(msg.mtext, "th", 2) != 0) {
+        THROW_ERROR("the message should be truncated");
+    }
+    // The lowest type is the bound of all types
+    if (send_msg(msqid, 5, "five") < 0) {
+        THROW_ERROR("failed to send the message");
+    }
+    ret = msgrcv(msqid, &msg, sizeof(msg.mtext), LONG_MIN, IPC_NOWAIT);
+    if (ret < 0 || msg.mtype != 5) {
+        THROW_ERROR("failed to receive the message of any type");
+    }
+    ret = msgrcv(msqid, &msg, sizeof(msg.mtext), 0, IPC_NOWAIT);
+    if (ret != -1 || errno != ENOMSG) {
+        THROW_ERROR("msgrcv should fail with ENOMSG on an empty queue");
+    }
+
+    struct msqid_ds ds;
+    if (msgctl(msqid, IPC_STAT, &ds) < 0 || ds.msg_qnum != 0 || ds.msg_lrpid != getpid()) {
+        THROW_ERROR("the status of the message queue is wrong");
+    }
+    if (msgctl(msqid, IPC_RMID, NULL) < 0) {
+        THROW_ERROR("failed to remove the message queue");
+    }
+    ret = send_msg(msqid, 1, "one");
+    if (ret != -1 || errno != EINVAL) {
+        THROW_ERROR("msgsnd should fail with EINVAL for a removed queue");
+    }
+    return 0;
+}
+
+static void *send_after_sleep(void *arg) {
+    usleep(100 * 1000);
+    send_msg(*(int *)arg, 7, "seven");
+    return NULL;
+}
+
+static int test_msg_wait_and_wake() {
+    struct test_msg msg;
+    pthread_t thread;
+    int msqid;
+
+    msqid = msgget(IPC_PRIVATE, S_IRWUSER);
+    if (msqid < 0) {
+        THROW_ERROR("failed to create the message queue");
+    }
+    if (pthread_create(&thread, NULL, send_after_sleep, &msqid) != 0) {
+        THROW_ERROR("failed to create the thread");
+    }
+    if (msgrcv(msqid, &msg, sizeof(msg.mtext), 7, 0) < 0 || strcmp(msg.mtext, "seven") != 0) {
+        THROW_ERROR("failed to wait for the message");
+    }
+    pthread_join(thread, NULL);
+    msgctl(msqid, IPC_RMID, NULL);
+    return 0;
+}
+
+// ============================================================================
+// Test cases for /proc/sysvipc
+// ============================================================================
+
+static int test_proc_sysvipc() {
+    char buf[1024], line[32];
+    int semid, fd, len;
+
+    semid = semget(IPC_PRIVATE, 3, S_IRWUSER);
+    if (semid < 0) {
+        THROW_ERROR("failed to create the semaphore set");
+    }
+    fd = open("/proc/sysvipc/sem", O_RDONLY);
+    if (fd < 0) {
+        THROW_ERROR("failed to open /proc/sysvipc/sem");
+    }
+    len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) {
+        THROW_ERROR("failed to read /proc/sysvipc/sem");
+    }
+    buf[len] = '\0';
+    // The key, the ID, the permissions and the number of semaphores
+    snprintf(line, sizeof(line), "%10d %10d  %4o %10u", 0, semid, S_IRWUSER, 3);
+    if (strstr(buf, "semid") == NULL || strstr(buf, line) == NULL) {
+        THROW_ERROR("the semaphore set is not in /proc/sysvipc/sem");
+    }
+    semctl(semid, 0, IPC_RMID);
+    return 0;
+}
+
+// ============================================================================
+// Test suite main
+// ============================================================================
+
+static test_case_t test_cases[] = {
+    TEST_CASE(test_semget_by_key),
+    TEST_CASE(test_semop_lock_and_unlock),
+    TEST_CASE(test_semop_time),
+    TEST_CASE(test_semop_all_or_nothing),
+    TEST_CASE(test_semtimedop_timeout),
+    TEST_CASE(test_semop_wait_and_wake),
+    TEST_CASE(test_sem_undo_on_exit),
+    TEST_CASE(test_msg_recv_by_type),
+    TEST_CASE(test_msg_wait_and_wake),
+    TEST_CASE(test_proc_sysvipc),
+};
+
+int main(int argc, const char *argv[]) {
+    if (argc == 1) {
+        return test_suite_run(test_cases, ARRAY_SIZE(test_cases));
+    }
+
+    // The child process arrives here
+    int option = atoi(argv[1]);
+    int arg = argc > 2 ? atoi(argv[2]) : 0;
+    switch (option) {
+        case TEST_SEM_UNDO:
+            return child_test_sem_undo(arg) < 0 ? -1 : 0;
+        default:
+            return -1;
+    }
+}
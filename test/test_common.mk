@@ -73,9 +73,12 @@ $(BUILD_DIR)/test/obj/$(TEST_NAME)/%.o: %.cc
 # Test
 #############################################################################
 
+# The occlum command that runs the test, which may be changed by the test
+OCCLUM_CMD ?= exec /bin/$(TEST_NAME) $(BIN_ARGS)
+
 test:
 	@cd $(BUILD_DIR)/test && \
-		$(EXTRA_ENV) $(OCCLUM_BIN_PATH)/occlum exec /bin/$(TEST_NAME) $(BIN_ARGS)
+		$(EXTRA_ENV) $(OCCLUM_BIN_PATH)/occlum $(OCCLUM_CMD)
 
 test-native:
 	@LD_LIBRARY_PATH=/usr/local/occlum/lib cd $(IMAGE_DIR) && ./bin/$(TEST_NAME) $(BIN_ARGS)
@@ -1,5 +1,7 @@
 #include <sys/time.h>
+#include <signal.h>
 #include <time.h>
+#include <unistd.h>
 #include "test.h"
 
 // ============================================================================
@@ -68,6 +70,136 @@ int test_get_localtime() {
     return 0;
 }
 
+// ============================================================================
+// Test cases for interval timers and alarm
+// ============================================================================
+
+static volatile int alarm_count = 0;
+
+static void handle_alarm(int sig) {
+    alarm_count++;
+}
+
+int test_setitimer_and_getitimer() {
+    struct sigaction sa = { .sa_handler = handle_alarm };
+    struct sigaction old_sa;
+    if (sigaction(SIGALRM, &sa, &old_sa) < 0) {
+        THROW_ERROR("sigaction failed");
+    }
+
+    alarm_count = 0;
+    struct itimerval new_value = {
+        .it_interval = { .tv_sec = 0, .tv_usec = 20 * 1000 },
+        .it_value = { .tv_sec = 0, .tv_usec = 20 * 1000 },
+    };
+    if (setitimer(ITIMER_REAL, &new_value, NULL) < 0) {
+        THROW_ERROR("setitimer failed");
+    }
+    struct itimerval curr_value;
+    if (getitimer(ITIMER_REAL, &curr_value) < 0) {
+        THROW_ERROR("getitimer failed");
+    }
+    if (curr_value.it_interval.tv_usec != 20 * 1000 ||
+            curr_value.it_value.tv_sec != 0 || curr_value.it_value.tv_usec == 0) {
+        THROW_ERROR("getitimer returns an incorrect value");
+    }
+
+    // Wait for the periodic timer to expire three times, or one second
+    for (int i = 0; i < 100 && alarm_count < 3; i++) {
+        usleep(10 * 1000);
+    }
+    if (alarm_count < 3) {
+        THROW_ERROR("the interval timer does not expire periodically");
+    }
+
+    struct itimerval zero_value = { 0 };
+    if (setitimer(ITIMER_REAL, &zero_value, NULL) < 0) {
+        THROW_ERROR("setitimer failed to disarm the timer");
+    }
+    if (getitimer(ITIMER_REAL, &curr_value) < 0) {
+        THROW_ERROR("getitimer failed");
+    }
+    if (curr_value.it_value.tv_sec != 0 || curr_value.it_value.tv_usec != 0) {
+        THROW_ERROR("the interval timer is not disarmed");
+    }
+
+    if (setitimer(3, &new_value, NULL) == 0 || errno != EINVAL) {
+        THROW_ERROR("setitimer with an invalid timer should fail");
+    }
+    sigaction(SIGALRM, &old_sa, NULL);
+    return 0;
+}
+
+int test_alarm() {
+    if (alarm(10) != 0) {
+        THROW_ERROR("alarm returns an incorrect value");
+    }
+    // The remaining seconds are rounded to the nearest
+    if (alarm(0) != 10) {
+        THROW_ERROR("alarm fails to return the remaining seconds");
+    }
+    if (alarm(0) != 0) {
+        THROW_ERROR("alarm is not cancelled");
+    }
+    return 0;
+}
+
+// ============================================================================
+// Test cases for POSIX timers
+// ============================================================================
+
+int test_posix_timer() {
+    sigset_t mask, old_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    if (sigprocmask(SIG_BLOCK, &mask, &old_mask) < 0) {
+        THROW_ERROR("sigprocmask failed");
+    }
+
+    timer_t timerid;
+    struct sigevent sev = {
+        .sigev_notify = SIGEV_SIGNAL,
+        .sigev_signo = SIGUSR1,
+        .sigev_value.sival_int = 42,
+    };
+    if (timer_create(CLOCK_MONOTONIC, &sev, &timerid) < 0) {
+        THROW_ERROR("timer_create failed");
+    }
+    struct itimerspec new_value = {
+        .it_interval = { 0, 0 },
+        .it_value = { .tv_sec = 0, .tv_nsec = 10 * 1000 * 1000 },
+    };
+    if (timer_settime(timerid, 0, &new_value, NULL) < 0) {
+        THROW_ERROR("timer_settime failed");
+    }
+
+    siginfo_t info;
+    struct timespec timeout = { .tv_sec = 1, .tv_nsec = 0 };
+    if (sigtimedwait(&mask, &info, &timeout) != SIGUSR1) {
+        THROW_ERROR("the timer signal is not received");
+    }
+    if (info.si_code != SI_TIMER || info.si_value.sival_int != 42) {
+        THROW_ERROR("the siginfo of the timer signal is incorrect");
+    }
+
+    struct itimerspec curr_value;
+    if (timer_gettime(timerid, &curr_value) < 0) {
+        THROW_ERROR("timer_gettime failed");
+    }
+    if (curr_value.it_value.tv_sec != 0 || curr_value.it_value.tv_nsec != 0) {
+        THROW_ERROR("the one-shot timer is still armed");
+    }
+    if (timer_getoverrun(timerid) != 0) {
+        THROW_ERROR("timer_getoverrun returns an incorrect value");
+    }
+    if (timer_delete(timerid) < 0) {
+        THROW_ERROR("timer_delete failed");
+    }
+
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+    return 0;
+}
+
 // ============================================================================
 // Test suite
 // ============================================================================
@@ -77,6 +209,9 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_clock_gettime),
     TEST_CASE(test_clock_getres),
     TEST_CASE(test_get_localtime),
+    TEST_CASE(test_setitimer_and_getitimer),
+    TEST_CASE(test_alarm),
+    TEST_CASE(test_posix_timer),
 };
 
 int main() {
@@ -1,4 +1,7 @@
+#include <stdint.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/timerfd.h>
 #include <sys/select.h>
 #include <time.h>
@@ -80,6 +83,54 @@ int test_invalid_argument() {
     return 0;
 }
 
+int test_read_expirations() {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (tfd < 0) {
+        THROW_ERROR("timerfd_create(CLOCK_MONOTONIC, ...) failed");
+    }
+
+    uint64_t expirations = 0;
+    if (read(tfd, &expirations, sizeof(expirations)) >= 0 || errno != EAGAIN) {
+        THROW_ERROR("read should fail with EAGAIN before the timer expires");
+    }
+
+    // A periodic timer expires multiple times between the reads
+    struct itimerspec spec = {
+        { 0, 10 * 1000 * 1000 },
+        { 0, 10 * 1000 * 1000 }
+    };
+    if (timerfd_settime(tfd, 0, &spec, NULL)) {
+        THROW_ERROR("timerfd_settime(...) failed");
+    }
+    usleep(55 * 1000);
+    if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        THROW_ERROR("failed to read the expirations");
+    }
+    if (expirations < 2) {
+        THROW_ERROR("the expirations of the periodic timer are not accumulated");
+    }
+
+    // A blocking read waits for a one-shot timer
+    struct itimerspec one_shot = {
+        { 0, 0 },
+        { 0, 10 * 1000 * 1000 }
+    };
+    if (fcntl(tfd, F_SETFL, 0) < 0) {
+        THROW_ERROR("failed to clear O_NONBLOCK");
+    }
+    if (timerfd_settime(tfd, 0, &one_shot, NULL)) {
+        THROW_ERROR("timerfd_settime(...) failed");
+    }
+    if (read(tfd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        THROW_ERROR("failed to read the expirations");
+    }
+    if (expirations != 1) {
+        THROW_ERROR("the one-shot timer expires more than once");
+    }
+    close(tfd);
+    return 0;
+}
+
 // ============================================================================
 // Test suite
 // ============================================================================
@@ -87,6 +138,7 @@ int test_invalid_argument() {
 static test_case_t test_cases[] = {
     TEST_CASE(test_timerfd),
     TEST_CASE(test_invalid_argument),
+    TEST_CASE(test_read_expirations),
 };
 
 int main() {
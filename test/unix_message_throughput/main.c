@@ -0,0 +1,132 @@
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KB              (1024UL)
+
+#define MSG_SIZE        (64UL)
+#define MAX_MSG_SIZE    (64 * KB)
+#define TOTAL_MSGS      (1000000UL)
+
+struct writer_args {
+    int sock_fd;
+    size_t msg_size;
+    size_t total_msgs;
+};
+
+static void *writer_thread(void *_args) {
+    struct writer_args *args = (struct writer_args *)_args;
+    char *buf = calloc(1, args->msg_size);
+    if (buf == NULL) {
+        printf("ERROR: failed to allocate the buffer\n");
+        return (void *) -1;
+    }
+
+    for (size_t i = 0; i < args->total_msgs; i++) {
+        if (write(args->sock_fd, buf, args->msg_size) != args->msg_size) {
+            printf("ERROR: failed to write to socket\n");
+            free(buf);
+            return (void *) -1;
+        }
+    }
+
+    free(buf);
+    return NULL;
+}
+
+// Measure the rate of messages sent through a pair of connected unix sockets of
+// the given type. For a stream socket, a "message" is a write of the same size,
+// which does not preserve the message boundary.
+static int bench_unix_socket(int sock_type, const char *type_name,
+                             size_t msg_size, size_t total_msgs) {
+    int socks[2];
+    if (socketpair(AF_UNIX, sock_type, 0, socks) < 0) {
+        printf("ERROR: failed to create a %s socket pair\n", type_name);
+        return -1;
+    }
+
+    char *buf = calloc(1, msg_size);
+    if (buf == NULL) {
+        printf("ERROR: failed to allocate the buffer\n");
+        return -1;
+    }
+
+    // Start the timer
+    struct timeval tv_start, tv_end;
+    gettimeofday(&tv_start, NULL);
+
+    pthread_t writer;
+    struct writer_args args = {
+        .sock_fd = socks[0],
+        .msg_size = msg_size,
+        .total_msgs = total_msgs,
+    };
+    if (pthread_create(&writer, NULL, writer_thread, &args) < 0) {
+        printf("ERROR: failed to create a writer thread\n");
+        return -1;
+    }
+
+    size_t remain_bytes = msg_size * total_msgs;
+    while (remain_bytes > 0) {
+        ssize_t ret = read(socks[1], buf, msg_size);
+        if (ret <= 0) {
+            printf("ERROR: failed to read from socket\n");
+            return -1;
+        }
+        remain_bytes -= ret;
+    }
+
+    void *ret = NULL;
+    pthread_join(writer, &ret);
+    if (ret != NULL) {
+        return -1;
+    }
+
+    // Stop the timer
+    gettimeofday(&tv_end, NULL);
+
+    free(buf);
+    close(socks[0]);
+    close(socks[1]);
+
+    double total_s = (tv_end.tv_sec - tv_start.tv_sec)
+                     + (double)(tv_end.tv_usec - tv_start.tv_usec) / 1000000;
+    if (total_s < 1.0) {
+        printf("WARNING: run long enough to get meaningful results\n");
+        if (total_s == 0) { return 0; }
+    }
+    double rate = (double)total_msgs / total_s;
+    printf("Message rate of %s unix socket with %zu-byte messages is %.2f msgs/s\n",
+           type_name, msg_size, rate);
+    return 0;
+}
+
+int main(int argc, const char *argv[]) {
+    size_t msg_size = MSG_SIZE;
+    size_t total_msgs = TOTAL_MSGS;
+    if (argc >= 2) {
+        msg_size = atol(argv[1]);
+        if (msg_size == 0 || msg_size > MAX_MSG_SIZE) {
+            printf("ERROR: the message size must be in [1, %lu]\n", MAX_MSG_SIZE);
+            return -1;
+        }
+    }
+    if (argc >= 3) {
+        total_msgs = atol(argv[2]);
+    }
+
+    if (bench_unix_socket(SOCK_STREAM, "stream", msg_size, total_msgs) < 0) {
+        return -1;
+    }
+    if (bench_unix_socket(SOCK_DGRAM, "datagram", msg_size, total_msgs) < 0) {
+        return -1;
+    }
+    if (bench_unix_socket(SOCK_SEQPACKET, "seqpacket", msg_size, total_msgs) < 0) {
+        return -1;
+    }
+    return 0;
+}
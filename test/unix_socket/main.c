@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <spawn.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/epoll.h>
 #include <pthread.h>
 
@@ -558,6 +559,155 @@ int test_sendmsg_recvmsg() {
     return ret;
 }
 
+int test_dgram_message_boundary() {
+    char name[] = "unix_dgram_path";
+    int server = socket(AF_UNIX, SOCK_DGRAM, 0);
+    int client = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (server < 0 || client < 0) {
+        THROW_ERROR("failed to create datagram sockets");
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, name);
+    socklen_t addr_len = strlen(addr.sun_path) + sizeof(addr.sun_family) + 1;
+    unlink(name);
+    if (bind(server, (struct sockaddr *)&addr, addr_len) < 0) {
+        THROW_ERROR("failed to bind");
+    }
+
+    // Two messages must be received separately
+    if (sendto(client, "hello", 5, 0, (struct sockaddr *)&addr, addr_len) != 5 ||
+            sendto(client, "world!", 6, 0, (struct sockaddr *)&addr, addr_len) != 6) {
+        THROW_ERROR("failed to sendto");
+    }
+
+    char buf[16] = {0};
+    if (recv(server, buf, sizeof(buf), 0) != 5 || strncmp(buf, "hello", 5) != 0) {
+        THROW_ERROR("the first message mismatched");
+    }
+
+    // A truncated message reports its real length with MSG_TRUNC
+    if (recv(server, buf, 3, MSG_TRUNC) != 6 || strncmp(buf, "wor", 3) != 0) {
+        THROW_ERROR("the truncated message mismatched");
+    }
+
+    if (recv(server, buf, sizeof(buf), MSG_DONTWAIT) != -1 || errno != EAGAIN) {
+        THROW_ERROR("an empty datagram socket should not be readable");
+    }
+
+    close(client);
+    close(server);
+    unlink(name);
+    return 0;
+}
+
+int test_seqpacket_connection() {
+    char name[] = "unix_seqpacket_path";
+    int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (listen_fd < 0) {
+        THROW_ERROR("failed to create a seqpacket socket");
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, name);
+    socklen_t addr_len = strlen(addr.sun_path) + sizeof(addr.sun_family) + 1;
+    unlink(name);
+    if (bind(listen_fd, (struct sockaddr *)&addr, addr_len) < 0 || listen(listen_fd, 5) < 0) {
+        THROW_ERROR("failed to bind or listen");
+    }
+
+    int client_fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (client_fd < 0 || connect(client_fd, (struct sockaddr *)&addr, addr_len) < 0) {
+        THROW_ERROR("failed to connect");
+    }
+    int server_fd = accept(listen_fd, NULL, NULL);
+    if (server_fd < 0) {
+        THROW_ERROR("failed to accept");
+    }
+
+    if (write(client_fd, ECHO_MSG, strlen(ECHO_MSG)) != strlen(ECHO_MSG) ||
+            write(client_fd, ECHO_MSG, 4) != 4) {
+        THROW_ERROR("failed to write");
+    }
+    char buf[64] = {0};
+    if (read(server_fd, buf, sizeof(buf)) != strlen(ECHO_MSG) ||
+            read(server_fd, buf, sizeof(buf)) != 4) {
+        THROW_ERROR("the message boundaries are not preserved");
+    }
+
+    // The peer gets EOF after the connection is closed
+    close(client_fd);
+    if (read(server_fd, buf, sizeof(buf)) != 0) {
+        THROW_ERROR("failed to get EOF");
+    }
+
+    close(server_fd);
+    close(listen_fd);
+    unlink(name);
+    return 0;
+}
+
+int test_scm_rights() {
+    int socks[2], pipe_fds[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, socks) < 0 || pipe(pipe_fds) < 0) {
+        THROW_ERROR("failed to create the sockets or the pipe");
+    }
+
+    // Pass the reader end of the pipe
+    char data = 'x';
+    struct iovec iov = { .iov_base = &data, .iov_len = 1 };
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct msghdr msg = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf),
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &pipe_fds[0], sizeof(int));
+    if (sendmsg(socks[0], &msg, 0) != 1) {
+        THROW_ERROR("failed to sendmsg");
+    }
+    close(pipe_fds[0]);
+
+    memset(&control, 0, sizeof(control));
+    data = 0;
+    if (recvmsg(socks[1], &msg, 0) != 1 || data != 'x') {
+        THROW_ERROR("failed to recvmsg");
+    }
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_type != SCM_RIGHTS ||
+            cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+        THROW_ERROR("no file is received");
+    }
+    int received_fd;
+    memcpy(&received_fd, CMSG_DATA(cmsg), sizeof(int));
+
+    // The received file is the reader end of the pipe
+    if (write(pipe_fds[1], ECHO_MSG, strlen(ECHO_MSG)) != strlen(ECHO_MSG)) {
+        THROW_ERROR("failed to write to the pipe");
+    }
+    char buf[64] = {0};
+    if (read(received_fd, buf, sizeof(buf)) != strlen(ECHO_MSG) ||
+            strncmp(buf, ECHO_MSG, strlen(ECHO_MSG)) != 0) {
+        THROW_ERROR("the received file mismatched");
+    }
+
+    close(received_fd);
+    close(pipe_fds[1]);
+    close(socks[0]);
+    close(socks[1]);
+    return 0;
+}
+
 static test_case_t test_cases[] = {
     TEST_CASE(test_unix_socket_inter_process),
     TEST_CASE(test_socketpair_inter_process),
@@ -568,6 +718,9 @@ static test_case_t test_cases[] = {
     TEST_CASE(test_unix_socket_rename),
     TEST_CASE(test_epoll_wait),
     TEST_CASE(test_sendmsg_recvmsg),
+    TEST_CASE(test_dgram_message_boundary),
+    TEST_CASE(test_seqpacket_connection),
+    TEST_CASE(test_scm_rights),
 };
 
 int main(int argc, const char *argv[]) {
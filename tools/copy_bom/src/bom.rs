@@ -7,7 +7,7 @@
 //! Then do real file operations on each BomManagement
 use crate::error::{FILE_NOT_EXISTS_ERROR, INVALID_BOM_FILE_ERROR};
 use crate::util::{
-    check_file_hash, copy_dir, copy_file, copy_shared_object, create_link, dest_in_root,
+    check_file_hash, copy_dir, copy_files, copy_shared_objects, create_link, dest_in_root,
     find_dependent_shared_objects, find_included_bom_file, infer_default_loader,
     lazy_check_missing_libraries, mkdir, resolve_envs, warn_on_nonempty_image_dir,
 };
@@ -436,12 +436,8 @@ impl BomManagement {
         dirs_to_copy
             .iter()
             .for_each(|(src, dest)| copy_dir(src, dest, dry_run, &excludes));
-        files_to_copy
-            .iter()
-            .for_each(|(src, dest)| copy_file(src, dest, dry_run));
-        shared_objects_to_copy
-            .iter()
-            .for_each(|(src, dest)| copy_shared_object(src, dest, dry_run));
+        copy_files(files_to_copy, dry_run);
+        copy_shared_objects(shared_objects_to_copy, dry_run);
     }
 
     // Try to analyse and copy dependencies for files in copydirs.
@@ -102,6 +102,57 @@ pub fn copy_file(src: &str, dest: &str, dry_run: bool) {
     }
 }
 
+/// Copy files with as few rsync processes as possible.
+/// The files that keep their names are copied to the same dest dir by one rsync, and
+/// the others (i.e., renamed files) are copied one by one.
+pub fn copy_files(files: &Vec<(String, String)>, dry_run: bool) {
+    // The max number of files passed to one rsync, to stay below the limit of args
+    const MAX_FILES_PER_RSYNC: usize = 1024;
+    // key: the dest dir, value: the source files. Keep the order of dest dirs.
+    let mut batches: Vec<(String, Vec<String>)> = Vec::new();
+    let mut batch_index: HashMap<String, usize> = HashMap::new();
+    for (src, dest) in files {
+        let src_path = PathBuf::from(src);
+        let dest_path = PathBuf::from(dest);
+        match (
+            src_path.file_name(),
+            dest_path.file_name(),
+            dest_path.parent(),
+        ) {
+            (Some(src_name), Some(dest_name), Some(dest_dir)) if src_name == dest_name => {
+                let dest_dir = dest_dir.to_string_lossy().to_string();
+                let index = *batch_index.entry(dest_dir.clone()).or_insert_with(|| {
+                    batches.push((dest_dir, Vec::new()));
+                    batches.len() - 1
+                });
+                batches[index].1.push(src.clone());
+            }
+            _ => copy_file(src, dest, dry_run),
+        }
+    }
+    for (dest_dir, srcs) in batches.iter() {
+        for srcs in srcs.chunks(MAX_FILES_PER_RSYNC) {
+            // The trailing slash makes rsync treat the dest as a dir
+            let dest = format!("{}/", dest_dir);
+            info!("rsync -aL {} {}", srcs.join(" "), dest);
+            if !dry_run {
+                let output = Command::new("rsync")
+                    .arg("-aL")
+                    .args(srcs)
+                    .arg(&dest)
+                    .output();
+                match output {
+                    Ok(output) => deal_with_output(output, COPY_FILE_ERROR),
+                    Err(e) => {
+                        error!("copy files {:?} to {} failed. {}", srcs, dest, e);
+                        std::process::exit(COPY_FILE_ERROR);
+                    }
+                }
+            }
+        }
+    }
+}
+
 fn format_command_args(args: &Vec<String>) -> String {
     let mut res = String::new();
     for arg in args {
@@ -158,9 +209,11 @@ pub fn copy_dir(src: &str, dest: &str, dry_run: bool, excludes: &Vec<String>) {
     }
 }
 
-pub fn copy_shared_object(src: &str, dest: &str, dry_run: bool) {
-    debug!("copy shared object {} to {}.", src, dest);
-    copy_file(src, dest, dry_run);
+pub fn copy_shared_objects(shared_objects: &Vec<(String, String)>, dry_run: bool) {
+    for (src, dest) in shared_objects.iter() {
+        debug!("copy shared object {} to {}.", src, dest);
+    }
+    copy_files(shared_objects, dry_run);
 }
 
 /// convert a dest path(usually absolute) to a dest path in root directory
@@ -144,8 +144,9 @@ fn main() {
             enclave_config_file_path
         );
 
-        // get the number of TCS
-        let tcs_num = occlum_config.resource_limits.max_num_of_threads;
+        // get the number of TCS, with one more for the timer thread of the PAL, which
+        // stays in the enclave all the time
+        let tcs_num = occlum_config.resource_limits.max_num_of_threads + 1;
         let tcs_min_pool = tcs_num;
         let tcs_max_num = std::cmp::max(tcs_num, DEFAULT_CONFIG.num_of_tcs_max);
 
@@ -280,7 +281,9 @@ fn main() {
                 default_stack_size: occlum_config.process.default_stack_size,
                 default_heap_size: occlum_config.process.default_heap_size,
                 default_mmap_size: occlum_config.process.default_mmap_size,
+                templates: occlum_config.process.templates,
             },
+            scheduler: occlum_config.scheduler,
             env: occlum_config.env,
             app: app_config,
         };
@@ -472,6 +475,8 @@ fn gen_app_config(
 struct OcclumConfiguration {
     resource_limits: OcclumResourceLimits,
     process: OcclumProcess,
+    #[serde(default)]
+    scheduler: serde_json::Value,
     entry_points: serde_json::Value,
     env: serde_json::Value,
     metadata: OcclumMetadata,
@@ -495,6 +500,8 @@ struct OcclumProcess {
     default_stack_size: String,
     default_heap_size: String,
     default_mmap_size: String,
+    #[serde(default, skip_serializing_if = "Vec::is_empty")]
+    templates: Vec<String>,
 }
 
 #[derive(Debug, PartialEq, Deserialize)]
@@ -533,6 +540,8 @@ struct OcclumMountOptions {
     pub layers: Option<Vec<OcclumMount>>,
     #[serde(default, skip_serializing_if = "is_false")]
     pub temporary: bool,
+    #[serde(default, skip_serializing_if = "is_false")]
+    pub materialize: bool,
 }
 
 #[inline]
@@ -585,6 +594,8 @@ struct InternalResourceLimits {
 struct InternalOcclumJson {
     resource_limits: InternalResourceLimits,
     process: OcclumProcess,
+    #[serde(skip_serializing_if = "serde_json::Value::is_null")]
+    scheduler: serde_json::Value,
     env: serde_json::Value,
     app: serde_json::Value,
 }
@@ -116,16 +116,20 @@ ifneq ($(wildcard $(IMAGE)/. ),)
 $(SECURE_IMAGE_MAC):
 $(SECURE_IMAGE): $(IMAGE) $(IMAGE_DIRS) $(IMAGE_FILES) $(SEFS_CLI_SIM) $(SIGNED_SEFS_CLI_LIB)
 	@echo "Building new image..."
-	@rm -rf build/mount
+	@# Keep the previous image to reuse the data files of unchanged files
+	@rm -rf build/mount.prev
+	@[ -d build/mount ] && mv build/mount build/mount.prev || true
 	@mkdir -p build/mount/
 	@[ -n "$(SECURE_IMAGE_KEY)" ] && export SECURE_IMAGE_KEY_OPTION="--key $(SECURE_IMAGE_KEY)" ; \
 		LD_LIBRARY_PATH="$(SGX_SDK)/sdk_libs" $(SEFS_CLI_SIM) \
 			--enclave "$(SIGNED_SEFS_CLI_LIB)" \
 			zip \
 			$$SECURE_IMAGE_KEY_OPTION \
+			--reuse "$(instance_dir)/build/mount.prev/__ROOT" \
 			"$(IMAGE)" \
 			"$(instance_dir)/build/mount/__ROOT" \
 			"$(SECURE_IMAGE_MAC)"
+	@rm -rf build/mount.prev
 endif
 
 clean: